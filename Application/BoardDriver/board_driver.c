@@ -1,6 +1,7 @@
 #include "board_driver.h"
 #include "FreeRTOS.h"
 #include "bsp_nvram.h"
+#include "bsp_wear.h"
 #include "cmsis_os.h"
 #include "main.h"
 #include "stdio.h"
@@ -11,11 +12,17 @@ void BoardDriver_Task(void const *arguments)
     osDelay(50);
     CLI_INFO("%s: Initialize Start\n", __FUNCTION__);
     Bsp_Nvram_Init();
+    Bsp_Nvram_LoadConfig();
+    Bsp_Wear_Init();
 
-    CLI_INFO("%s: Initialize Finish\n", __FUNCTION__);
+    // Tick counts from reset, time to config includes the boot.
+    CLI_INFO("%s: Initialize Finish, config loaded in %ld ms, %ld ms after reset\n", __FUNCTION__,
+             Nvram_Config.LoadTime, HAL_GetTick());
 
     for (;;)
     {
-        osDelay(1000);
+        Bsp_Nvram_Task();
+        Bsp_Wear_Task();
+        osDelay(100);
     }
 }
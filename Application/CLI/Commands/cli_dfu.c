@@ -0,0 +1,67 @@
+/******************************************************************************
+ * @file    cli_dfu.c
+ * @brief   Command Line Interface for DFU (Device Firmware Upgrade) boot options.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include "cli.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+#include "bsp_nvram.h"
+#include "dfu_console.h"
+#include "dfu_flash_if.h"
+
+const char *dfu_helptext = "dfu command usage:\n"
+                           "\t-a --arm [reset]\tOpen DFU window on next boot, [reset] now.\n"
+                           "\t-d --disarm\tBoot straight to application on next boot.\n"
+                           "\t-i --info\tShow boot bank, image and boot time.\n"
+                           "\t-h --help\tShow this help text.\n";
+
+int cli_dfu(int argc, char *argv[])
+{
+    argc--;
+    argv++;
+
+    if ((argc == 0) || (strcmp(argv[0], "-h") == 0) || (strcmp(argv[0], "--help") == 0))
+    {
+        CLI_PRINT("%s", dfu_helptext);
+    }
+    else if ((strcmp(argv[0], "-a") == 0) || (strcmp(argv[0], "--arm") == 0))
+    {
+        Dfu_arm(1);
+        CLI_PRINT("DFU window opens on next boot for [%d] ms.\n", DFU_BOOT_DELAY);
+        if ((argc > 1) && (strcmp(argv[1], "reset") == 0))
+        {
+            Bsp_Nvram_Flush();
+            fflush(stdout);
+            HAL_Delay(10);
+            HAL_NVIC_SystemReset();
+        }
+    }
+    else if ((strcmp(argv[0], "-d") == 0) || (strcmp(argv[0], "--disarm") == 0))
+    {
+        Dfu_arm(0);
+        CLI_PRINT("Fast boot on next boot.\n");
+    }
+    else if ((strcmp(argv[0], "-i") == 0) || (strcmp(argv[0], "--info") == 0))
+    {
+        const Flash_ManifestTypeDef *manifest = Flash_getManifest(Flash_getActiveBank());
+
+        CLI_PRINT("Boot bank  : [%ld]\n", Flash_getActiveBank());
+        CLI_PRINT("Image      : [%ld] bytes, CRC [0x%08lX]\n", manifest ? manifest->Length : 0,
+                  manifest ? manifest->Crc : 0);
+        CLI_PRINT("Next boot  : %s\n", Dfu_isArmed() ? "DFU window" : "fast boot");
+        CLI_PRINT("Boot time  : [%ld] ms from reset to first task\n", Dfu_BootTime);
+    }
+    else
+    {
+        CLI_PRINT("Unknow args of [%s], try [-h] for help.\n", argv[0]);
+    }
+
+    return 0;
+}
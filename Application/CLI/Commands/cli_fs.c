@@ -0,0 +1,266 @@
+/******************************************************************************
+ * @file    cli_fs.c
+ * @brief   Command Line Interface for the file system on QSPI flash, ls / cat / rm / df.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include "cli.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+#include "bsp_qspi_fs.h"
+
+const char *cat_helptext = "cat command usage:\n"
+                           "\tcat <name>\tPrint a file.\n"
+                           "\t-w --write <name> <text...>\tWrite text to a new or truncated file.\n"
+                           "\t-a --append <name> <text...>\tAppend text to a file.\n"
+                           "\t-h --help\tShow this help text.\n";
+
+const char *df_helptext = "df command usage:\n"
+                          "\tdf\tShow blocks, files and commits of the file system.\n"
+                          "\t-f --format [confirm]\tErase all files, [confirm] to proceed.\n"
+                          "\t-h --help\tShow this help text.\n";
+
+static const char *fs_error(int ret)
+{
+    switch (ret)
+    {
+    case QSPI_FS_NOENT:
+        return "no such file";
+    case QSPI_FS_NOSPC:
+        return "no space";
+    case QSPI_FS_INVAL:
+        return "invalid name or mode";
+    case QSPI_FS_BUSY:
+        return "file busy";
+    case QSPI_FS_NOFS:
+        return "no file system, try [df -f]";
+    default:
+        return "flash error";
+    }
+}
+
+/*!@brief Mount the file system on first use.
+ *
+ * @return QSPI_FS_OK or the error printed.
+ */
+static int fs_mount(void)
+{
+    int ret = QSPI_FS_OK;
+
+    if (!QSPI_FS_Mounted())
+    {
+        ret = QSPI_FS_Mount();
+        if (ret != QSPI_FS_OK)
+        {
+            CLI_PRINT("\e[31mERROR: mount failed, %s.\e[0m\n", fs_error(ret));
+        }
+    }
+    return ret;
+}
+
+int cli_ls(int argc, char *argv[])
+{
+    QSPI_FS_InfoTypeDef info;
+    uint32_t            pos   = 0;
+    uint32_t            total = 0;
+    uint32_t            files = 0;
+
+    (void)argc;
+    (void)argv;
+
+    if (fs_mount() != QSPI_FS_OK)
+    {
+        return 0;
+    }
+
+    while (QSPI_FS_Dir(&pos, &info) == QSPI_FS_OK)
+    {
+        CLI_PRINT("%10lu  %s\n", info.Size, info.Name);
+        total += info.Size;
+        files++;
+    }
+    CLI_PRINT("[%lu] files, [%lu] bytes\n", files, total);
+
+    return 0;
+}
+
+/*!@brief Write the arguments to an open file, separated by spaces, ended by a new line.
+ */
+static int cat_write(QSPI_FS_FileTypeDef *file, int argc, char *argv[])
+{
+    int32_t size = 0;
+
+    for (int i = 0; i < argc; i++)
+    {
+        int32_t len = strlen(argv[i]);
+
+        if ((QSPI_FS_Write(file, argv[i], len) != len) ||
+            (QSPI_FS_Write(file, (i + 1 < argc) ? " " : "\n", 1) != 1))
+        {
+            return -1;
+        }
+        size += len + 1;
+    }
+    return size;
+}
+
+int cli_cat(int argc, char *argv[])
+{
+    QSPI_FS_FileTypeDef file;
+    int                 ret;
+
+    argc--;
+    argv++;
+
+    if ((argc == 0) || (strcmp(argv[0], "-h") == 0) || (strcmp(argv[0], "--help") == 0))
+    {
+        CLI_PRINT("%s", cat_helptext);
+    }
+    else if ((strcmp(argv[0], "-w") == 0) || (strcmp(argv[0], "--write") == 0) ||
+             (strcmp(argv[0], "-a") == 0) || (strcmp(argv[0], "--append") == 0))
+    {
+        uint8_t mode = QSPI_FS_WRITE | QSPI_FS_CREATE;
+        int32_t size;
+
+        mode |= ((strcmp(argv[0], "-a") == 0) || (strcmp(argv[0], "--append") == 0))
+                    ? QSPI_FS_APPEND
+                    : QSPI_FS_TRUNC;
+
+        if (argc < 2)
+        {
+            CLI_PRINT("%s", cat_helptext);
+            return 0;
+        }
+        if (fs_mount() != QSPI_FS_OK)
+        {
+            return 0;
+        }
+
+        ret = QSPI_FS_Open(&file, argv[1], mode);
+        if (ret != QSPI_FS_OK)
+        {
+            CLI_PRINT("\e[31mERROR: can't open [%s], %s.\e[0m\n", argv[1], fs_error(ret));
+            return 0;
+        }
+
+        size = cat_write(&file, argc - 2, &argv[2]);
+        ret  = QSPI_FS_Close(&file);
+        if ((size < 0) || (ret != QSPI_FS_OK))
+        {
+            CLI_PRINT("\e[31mERROR: can't write [%s], %s.\e[0m\n", argv[1],
+                      fs_error((size < 0) ? QSPI_FS_NOSPC : ret));
+            return 0;
+        }
+        CLI_PRINT("Write [%s] = %ld bytes, size [%lu]\n", argv[1], size, file.Size);
+    }
+    else
+    {
+        char    buf[64];
+        int32_t len;
+
+        if (fs_mount() != QSPI_FS_OK)
+        {
+            return 0;
+        }
+
+        ret = QSPI_FS_Open(&file, argv[0], QSPI_FS_READ);
+        if (ret != QSPI_FS_OK)
+        {
+            CLI_PRINT("\e[31mERROR: can't open [%s], %s.\e[0m\n", argv[0], fs_error(ret));
+            return 0;
+        }
+
+        while ((len = QSPI_FS_Read(&file, buf, sizeof(buf))) > 0)
+        {
+            CLI_PRINT("%.*s", (int)len, buf);
+        }
+        QSPI_FS_Close(&file);
+        if (len < 0)
+        {
+            CLI_PRINT("\n\e[31mERROR: can't read [%s], %s.\e[0m\n", argv[0], fs_error(len));
+        }
+    }
+
+    return 0;
+}
+
+int cli_rm(int argc, char *argv[])
+{
+    argc--;
+    argv++;
+
+    if (argc == 0)
+    {
+        CLI_PRINT("rm command usage:\n\trm <name...>\tRemove files.\n");
+        return 0;
+    }
+    if (fs_mount() != QSPI_FS_OK)
+    {
+        return 0;
+    }
+
+    for (int i = 0; i < argc; i++)
+    {
+        int ret = QSPI_FS_Remove(argv[i]);
+
+        if (ret != QSPI_FS_OK)
+        {
+            CLI_PRINT("\e[31mERROR: can't remove [%s], %s.\e[0m\n", argv[i], fs_error(ret));
+        }
+    }
+
+    return 0;
+}
+
+int cli_df(int argc, char *argv[])
+{
+    argc--;
+    argv++;
+
+    if ((argc > 0) && ((strcmp(argv[0], "-h") == 0) || (strcmp(argv[0], "--help") == 0)))
+    {
+        CLI_PRINT("%s", df_helptext);
+    }
+    else if ((argc > 0) && ((strcmp(argv[0], "-f") == 0) || (strcmp(argv[0], "--format") == 0)))
+    {
+        int ret = QSPI_FS_OK;
+
+        if ((argc < 2) || (strcmp(argv[1], "confirm") != 0))
+        {
+            CLI_PRINT("\e[33mWARNING: Will Erase all files, can't be undo.\e[0m\n");
+            CLI_PRINT("Please use \"df -f confirm\" to confirm file system format.\n");
+        }
+        else if ((ret = QSPI_FS_Format()) != QSPI_FS_OK)
+        {
+            CLI_PRINT("\e[31mERROR: format failed, %s.\e[0m\n", fs_error(ret));
+        }
+        else
+        {
+            CLI_PRINT("File system formatted, [%d] blocks of [%d] bytes.\n", QSPI_FS_BLOCKS,
+                      QSPI_FS_BLOCK);
+        }
+    }
+    else if (argc > 0)
+    {
+        CLI_PRINT("Unknow args of [%s], try [-h] for help.\n", argv[0]);
+    }
+    else if (fs_mount() == QSPI_FS_OK)
+    {
+        CLI_PRINT("Area       : [0x%08X] [%d] blocks of [%d] bytes\n", QSPI_FS_BASE,
+                  QSPI_FS_BLOCKS, QSPI_FS_BLOCK);
+        CLI_PRINT("Used       : [%lu] blocks, [%lu] free\n", QSPI_FS_Stat.Used,
+                  QSPI_FS_BLOCKS - QSPI_FS_Stat.Used);
+        CLI_PRINT("Files      : [%lu] of [%d]\n", QSPI_FS_Stat.Files, QSPI_FS_FILES);
+        CLI_PRINT("Sequence   : [%lu]\n", QSPI_FS_Stat.Sequence);
+        CLI_PRINT("Since mount: [%lu] commits, [%lu] erases, [%lu] bytes copied\n",
+                  QSPI_FS_Stat.Commit, QSPI_FS_Stat.Erase, QSPI_FS_Stat.Copy);
+        CLI_PRINT("Mount time : [%lu] ms\n", QSPI_FS_Stat.Mount);
+    }
+
+    return 0;
+}
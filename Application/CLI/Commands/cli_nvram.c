@@ -11,6 +11,9 @@
 #include "cli.h"
 #include "stdlib.h"
 #include "bsp_nvram.h"
+#include "bsp_nvram_i2c.h"
+#include "bsp_nvram_qspi.h"
+#include "bsp_wear.h"
 #include <stdio.h>
 #include <string.h>
 #include <sys/_stdint.h>
@@ -32,11 +35,17 @@
     } while (0)
 
 const char *Nvram_helptext = "Nvram command usage:\n"
-                             "\t-w --write [addr] [value ...]   Write a value to Nvram\n"
+                             "\t-w --write [addr] [value ...]   Write values to Nvram from addr,\n"
+                             "\t                                all or none of them\n"
                              "\t-r --read  [addr] [len]         Read a value from Nvram\n"
+                             "\t-W --writex [reg] [text]        Write a text as multi-byte value\n"
+                             "\t-R --readx  [reg]               Read a multi-byte value\n"
                              "\t-e --erase Erase Nvram content on flash bank.\n"
                              "\t-d --dump  Dump Nvram content.\n"
-                             "\t-i --info  [debug] Show Nvram info\n"
+                             "\t-f --flush Write cached values to Nvram now.\n"
+                             "\t-i --info  [emul|qspi|i2c] Show Nvram info,\n"
+                             "\t                                switch device first if given\n"
+                             "\t-i --info  debug               Show Nvram info and flash wear\n"
                              "\t-h --help  Show this help text.\n";
 
 int cli_nvram(int argc, char *argv[])
@@ -78,11 +87,35 @@ int cli_nvram(int argc, char *argv[])
             goto param_error;
         }
 
-        // Write NVRAM
-        CHECK_FUNC_RET(0, Nvram_Drv.Write(addr, data));
+        // Write NVRAM, several values in one transaction.
+        if (argc == 3)
+        {
+            CHECK_FUNC_RET(0, Nvram_Drv.Write(addr, data));
+            CLI_PRINT("NVRAM Write Reg[0x%04lX] = 0x%lX\n", addr, data);
+            return 0;
+        }
+
+        CHECK_FUNC_RET(0, Bsp_Nvram_Begin());
+        for (int i = 2; i < argc; i++)
+        {
+            data = strtoul(argv[i], tail, 0);
+            if (**tail != 0)
+            {
+                Bsp_Nvram_Abort();
+                goto param_error;
+            }
+            if (Nvram_Drv.Write(addr + i - 2, data) != NVRAM_OK)
+            {
+                Bsp_Nvram_Abort();
+                CLI_PRINT("\e[31mERROR: can't write Reg[0x%04lX], up to %d values.\e[0m\n",
+                          addr + i - 2, NVRAM_TX_SIZE);
+                return -1;
+            }
+        }
+        CHECK_FUNC_RET(0, Bsp_Nvram_Commit());
 
         // Print Result
-        CLI_PRINT("NVRAM Write Reg[0x%04lX] = 0x%lX\n", addr, data);
+        CLI_PRINT("NVRAM Write Reg[0x%04lX..0x%04lX] committed\n", addr, addr + argc - 3);
     }
     else if ((strcmp(argv[0], "-r") == 0) || (strcmp(argv[0], "--read") == 0))
     {
@@ -105,11 +138,92 @@ int cli_nvram(int argc, char *argv[])
         // Print Result
         CLI_PRINT("NVRAM Read Reg[0x%04lX] = 0x%lX\n", addr, data);
     }
+    else if ((strcmp(argv[0], "-W") == 0) || (strcmp(argv[0], "--writex") == 0))
+    {
+        // Check syntax
+        if ((argc < 3) || (argv[1] == NULL) || (argv[2] == NULL))
+        {
+            goto syntax_error;
+        }
+
+        // Get Parameters
+        uint32_t reg = strtoul(argv[1], tail, 0);
+        if (**tail != 0)
+        {
+            goto param_error;
+        }
+        uint16_t len = strlen(argv[2]);
+
+        // Write NVRAM
+        if (Nvram_Drv.WriteEx == NULL)
+        {
+            NVRAM_ERROR("ERROR: NVRAM driver has no multi-byte access.\n");
+            return -1;
+        }
+        CHECK_FUNC_RET(0, Nvram_Drv.WriteEx(reg, (uint8_t *)argv[2], len));
+
+        // Print Result
+        CLI_PRINT("NVRAM WriteEx Reg[0x%02lX] = %d bytes\n", reg, len);
+    }
+    else if ((strcmp(argv[0], "-R") == 0) || (strcmp(argv[0], "--readx") == 0))
+    {
+        static uint8_t data[NVRAM_EX_SIZE];
+
+        // Check syntax
+        if ((argc < 2) || (argv[1] == NULL))
+        {
+            goto syntax_error;
+        }
+
+        // Get Parameters
+        uint32_t reg = strtoul(argv[1], tail, 0);
+        if (**tail != 0)
+        {
+            goto param_error;
+        }
+
+        // Read NVRAM, value is zero padded
+        if (Nvram_Drv.ReadEx == NULL)
+        {
+            NVRAM_ERROR("ERROR: NVRAM driver has no multi-byte access.\n");
+            return -1;
+        }
+        CHECK_FUNC_RET(0, Nvram_Drv.ReadEx(reg, data, sizeof(data)));
+        int len = sizeof(data);
+        while ((len > 0) && (data[len - 1] == 0))
+        {
+            len--;
+        }
+
+        // Print Result, hex and ASCII per 16 bytes
+        CLI_PRINT("NVRAM ReadEx Reg[0x%02lX] = %d bytes\n", reg, len);
+        for (int i = 0; i < len; i += 16)
+        {
+            CLI_PRINT("%04X:", i);
+            for (int j = i; j < i + 16; j++)
+            {
+                if (j < len)
+                {
+                    CLI_PRINT(" %02X", data[j]);
+                }
+                else
+                {
+                    CLI_PRINT("   ");
+                }
+            }
+            CLI_PRINT("  ");
+            for (int j = i; (j < i + 16) && (j < len); j++)
+            {
+                CLI_PRINT("%c", ((data[j] >= 0x20) && (data[j] < 0x7F)) ? data[j] : '.');
+            }
+            CLI_PRINT("\n");
+        }
+    }
     else if ((strcmp(argv[0], "-d") == 0) || (strcmp(argv[0], "--dump") == 0))
     {
-        Nvram_InfoTypeDef info   = {0};
-        NVRAM_STATUS      status = 0;
-        uint32_t          val    = 0;
+        static uint32_t   value[NVRAM_CONFIG_SIZE];
+        uint32_t          valid[(NVRAM_CONFIG_SIZE + 31) / 32];
+        Nvram_InfoTypeDef info = {0};
 
         Nvram_Drv.GetInfo(&info);
         CLI_INFO("NVRAM Information:\n");
@@ -121,12 +235,18 @@ int cli_nvram(int argc, char *argv[])
         CLI_INFO("DataVolume  = %ld\n", info.DataVolume);
 
         CLI_PRINT("NVRAM dump:\n");
-        for (int i = 0; i < info.DataVolume; i++)
+        for (uint32_t addr = 0; addr < info.DataVolume; addr += NVRAM_CONFIG_SIZE)
         {
-            status = Nvram_Drv.Read(i, &val);
-            if (status == 0)
+            uint32_t count = info.DataVolume - addr;
+            count          = (count > NVRAM_CONFIG_SIZE) ? NVRAM_CONFIG_SIZE : count;
+
+            CHECK_FUNC_RET(0, Bsp_Nvram_Snapshot(addr, count, value, valid));
+            for (uint32_t i = 0; i < count; i++)
             {
-                CLI_PRINT("Reg[0x%04X]== 0x%lX\n", i, val);
+                if (valid[i / 32] & (1UL << (i % 32)))
+                {
+                    CLI_PRINT("Reg[0x%04lX]== 0x%lX\n", addr + i, value[i]);
+                }
             }
         }
     }
@@ -155,9 +275,33 @@ int cli_nvram(int argc, char *argv[])
 
         count++;
     }
+    else if ((strcmp(argv[0], "-f") == 0) || (strcmp(argv[0], "--flush") == 0))
+    {
+        CHECK_FUNC_RET(0, Bsp_Nvram_Flush());
+        CLI_PRINT("NVRAM cache flushed.\n");
+    }
     else if ((strcmp(argv[0], "-i") == 0) || (strcmp(argv[0], "--info") == 0))
     {
-        Nvram_InfoTypeDef info = {0};
+        const char *      dev[NVRAM_DEV_NUM] = {"emul", "qspi", "i2c"};
+        Nvram_InfoTypeDef info               = {0};
+        int               debug              = (argc > 1) && (strcmp(argv[1], "debug") == 0);
+
+        if ((argc > 1) && !debug)
+        {
+            int sel = 0;
+
+            while ((sel < NVRAM_DEV_NUM) && (strcmp(argv[1], dev[sel]) != 0))
+            {
+                sel++;
+            }
+            if (sel == NVRAM_DEV_NUM)
+            {
+                goto syntax_error;
+            }
+            CHECK_FUNC_RET(0, Bsp_Nvram_Select(sel));
+            CLI_PRINT("NVRAM device switched to %s.\n", dev[sel]);
+        }
+
         Nvram_Drv.GetInfo(&info);
         CLI_PRINT("NVRAM Information:\n");
         CLI_PRINT("Interface   = %s\n", info.Interface);
@@ -166,6 +310,83 @@ int cli_nvram(int argc, char *argv[])
         CLI_PRINT("DevAddr     = 0x%02X\n", info.DevAddr);
         CLI_PRINT("DataBit     = %d\n", info.DataBit);
         CLI_PRINT("DataVolume  = %ld\n", info.DataVolume);
+        CLI_PRINT("Cache Write = %ld\n", Nvram_CacheStat.Write);
+        CLI_PRINT("Elided      = %ld\n", Nvram_CacheStat.Elided);
+        CLI_PRINT("Coalesced   = %ld\n", Nvram_CacheStat.Coalesced);
+        CLI_PRINT("FlashWrite  = %ld\n", Nvram_CacheStat.FlashWrite);
+        CLI_PRINT("Flush       = %ld\n", Nvram_CacheStat.Flush);
+        CLI_PRINT("Commit      = %ld\n", Nvram_CacheStat.Commit);
+        CLI_PRINT("Config      = loaded in %ld ms\n", Nvram_Config.LoadTime);
+        CLI_PRINT("Latency     = max %ld ms in %ld writes\n", Nvram_WriteLatency.Max,
+                  Nvram_WriteLatency.Count);
+        for (int i = 0; i < NVRAM_LATENCY_BUCKETS; i++)
+        {
+            CLI_PRINT("  %s%3d ms   = %ld\n", (i < NVRAM_LATENCY_BUCKETS - 1) ? "< " : ">=",
+                      (i < NVRAM_LATENCY_BUCKETS - 1) ? (1 << i) : (1 << (i - 1)),
+                      Nvram_WriteLatency.Bucket[i]);
+        }
+        if (strcmp(info.Interface, "QSPI") == 0)
+        {
+            CLI_PRINT("Mount       = %ld ms\n", QSPI_KV_Stat.Mount);
+            CLI_PRINT("Keys        = %ld\n", QSPI_KV_Stat.Keys);
+            CLI_PRINT("Free        = %ld subsectors\n", QSPI_KV_Stat.Free);
+            CLI_PRINT("Record      = %ld\n", QSPI_KV_Stat.Record);
+            CLI_PRINT("Gc          = %ld, %ld records copied\n", QSPI_KV_Stat.Gc,
+                      QSPI_KV_Stat.GcCopy);
+            CLI_PRINT("Erase       = %ld, max %ld per subsector\n", QSPI_KV_Stat.Erase,
+                      QSPI_KV_Stat.EraseMax);
+        }
+        else if (strcmp(info.Interface, "I2C") == 0)
+        {
+            CLI_PRINT("PageWrite   = %ld, %ld bytes\n", I2C_EEP_Stat.PageWrite,
+                      I2C_EEP_Stat.ByteWrite);
+            CLI_PRINT("Merged      = %ld\n", I2C_EEP_Stat.Merged);
+            CLI_PRINT("Read        = %ld, %ld by DMA\n", I2C_EEP_Stat.Read, I2C_EEP_Stat.DmaRead);
+            CLI_PRINT("PageHit     = %ld\n", I2C_EEP_Stat.PageHit);
+            CLI_PRINT("Poll        = %ld, max %ld per write\n", I2C_EEP_Stat.Poll,
+                      I2C_EEP_Stat.PollMax);
+            CLI_PRINT("Replay      = %ld\n", I2C_EEP_Stat.Replay);
+        }
+        if (debug)
+        {
+            Wear_TelemetryTypeDef tm = {0};
+
+            Bsp_Wear_Get(&tm);
+            CLI_PRINT("Flash Wear:\n");
+            CLI_PRINT("OnTime      = %ld s\n", tm.Record.OnTime);
+            CLI_PRINT("WriteAmp    = %ld.%02ld, %ld elements / %ld writes\n", tm.WriteAmp / 100,
+                      tm.WriteAmp % 100, tm.Record.PhysicalWrite, tm.Record.LogicalWrite);
+            CLI_PRINT("EmulErase   =");
+            for (int i = 0; i < PAGES_NUMBER; i++)
+            {
+                CLI_PRINT(" %ld", tm.Record.EmulErase[i]);
+            }
+            CLI_PRINT("\n");
+            for (int bank = 0; bank < 2; bank++)
+            {
+                CLI_PRINT("Bank%dErase  =", bank + 1);
+                for (int i = 0; i < WEAR_GROUPS; i++)
+                {
+                    CLI_PRINT(" %d", tm.Record.BankErase[bank][i]);
+                }
+                CLI_PRINT("  (%d pages a group)\n", WEAR_GROUP_PAGES);
+            }
+
+            const char *name[2] = {"EmulLife", "BankLife"};
+            uint32_t    max[2]  = {tm.EmulMax, tm.BankMax};
+            uint32_t    life[2] = {tm.EmulLife, tm.BankLife};
+            for (int i = 0; i < 2; i++)
+            {
+                if (life[i] == WEAR_LIFE_NONE)
+                {
+                    CLI_PRINT("%s    = %ld erases, no erase rate yet\n", name[i], max[i]);
+                }
+                else
+                {
+                    CLI_PRINT("%s    = %ld erases, %lu days left\n", name[i], max[i], life[i]);
+                }
+            }
+        }
     }
     else
     {
@@ -1,8 +1,13 @@
+#include "bsp_qspi.h"
+#include "bsp_qspi_cache.h"
+#include "cmsis_os.h"
 #include "stdio.h"
 #include "stdlib.h"
 #include "stm32l476g_discovery_qspi.h"
 #include "string.h"
 
+#define QSPI_BENCH_CHUNK 4096 //!< Read buffer of the bench
+
 #define CHECK_FUNC_EXIT(status, func)                                                              \
     do                                                                                             \
     {                                                                                              \
@@ -33,6 +38,81 @@ int cli_qspi_selftest()
     return 0;
 }
 
+/**@brief Read QSPI flash in chunks, blocking, by DMA, then copied from the memory-mapped
+ *        window. CPU load is the run time of the calling task, counted in ms by FreeRTOS at
+ *        each context switch.
+ *
+ * @param addr
+ * @param size
+ */
+static int cli_qspi_bench(uint32_t addr, uint32_t size)
+{
+    const char *mode[] = {"Blocking", "DMA", "Mapped"};
+    uint8_t *   buf    = (uint8_t *)cli_qspi_malloc(QSPI_BENCH_CHUNK);
+    uint8_t     idle   = Qspi_MapIdle;
+
+    if (buf == NULL)
+    {
+        return -1;
+    }
+
+    // Blocking reads need indirect mode.
+    Bsp_Qspi_MapMode(0);
+
+    printf("Read QSPI @ addr[0x%lX], size=[%ld], chunk=[%d]\n", addr, size, QSPI_BENCH_CHUNK);
+    printf("Mode     Time(ms)   kB/s  CPU\n");
+    for (int dma = 0; dma < 3; dma++)
+    {
+        TaskStatus_t   before, after;
+        uint8_t        ret = QSPI_OK;
+        const uint8_t *map = NULL;
+
+        // Switch out, so that the run time counter is up to date.
+        osDelay(1);
+        vTaskGetInfo(NULL, &before, pdFALSE, eRunning);
+        uint32_t tick = HAL_GetTick();
+
+        // Blocking reads go through the scheduler too, so that they can't race the I/O task.
+        Qspi_Blocking = (dma == 0);
+        if (dma == 2)
+        {
+            map = Bsp_Qspi_Map(addr, size);
+            ret = (map != NULL) ? QSPI_OK : QSPI_ERROR;
+        }
+        for (uint32_t i = 0; (i < size) && (ret == QSPI_OK); i += QSPI_BENCH_CHUNK)
+        {
+            uint32_t len = (size - i > QSPI_BENCH_CHUNK) ? QSPI_BENCH_CHUNK : size - i;
+
+            if (map != NULL)
+            {
+                memcpy(buf, map + i, len);
+            }
+            else
+            {
+                ret = Bsp_Qspi_Read(buf, addr + i, len);
+            }
+        }
+        if (map != NULL)
+        {
+            Bsp_Qspi_Release();
+        }
+        Qspi_Blocking = 0;
+
+        tick = HAL_GetTick() - tick;
+        osDelay(1);
+        vTaskGetInfo(NULL, &after, pdFALSE, eRunning);
+
+        uint32_t run = after.ulRunTimeCounter - before.ulRunTimeCounter;
+        tick         = (tick == 0) ? 1 : tick;
+        printf("%-8s %8ld %6ld %3ld%%%s\n", mode[dma], tick, size / 1024 * 1000 / tick,
+               ((run > tick) ? tick : run) * 100 / tick, (ret == QSPI_OK) ? "" : " ERROR");
+    }
+
+    Bsp_Qspi_MapMode(idle);
+    cli_qspi_free(buf);
+    return 0;
+}
+
 /**@brief Command line interface for Accel
  *
  * @param argc
@@ -42,9 +122,11 @@ int cli_qspi(int argc, char **argv)
 {
     const char *QSPI_HELPTEXT = "Quad-SPI Flash commands:\n"
                                 "\t-i --init        QSPI Flash initialize\n"
-                                "\t-m --mount       QSPI Flash mount to system address 0x00.\n"
-                                "\t-p --property    Show QSPI Flash info \n"
+                                "\t-m --mount [off] Map QSPI Flash @ 0x90000000 while idle.\n"
+                                "\t-p --property    Show QSPI Flash info and read cache statistic.\n"
                                 "\t-s --selftest    Run QSPI self test.\n"
+                                "\t-b --bench [addr] [size]\n"
+                                "\t                 Read blocking, DMA and mapped, show CPU load.\n"
                                 "\t-r --read  [addr] [len]\n"
                                 "\t                 Read QSPI flash.\n"
                                 "\t-w --write [addr] [value]...[value]\n"
@@ -72,16 +154,17 @@ int cli_qspi(int argc, char **argv)
 
     if ((strcmp(argv[0], "-i") == 0) || (strcmp(argv[0], "--init") == 0))
     {
-        CHECK_FUNC_EXIT(QSPI_OK, BSP_QSPI_Init());
+        CHECK_FUNC_EXIT(QSPI_OK, Bsp_Qspi_Reset());
 
         printf("QSPI Initialize OK!\n");
     }
     else if ((strcmp(argv[0], "-m") == 0) || (strcmp(argv[0], "--mount") == 0))
     {
-        CHECK_FUNC_EXIT(QSPI_OK, BSP_QSPI_EnableMemoryMappedMode());
-        __HAL_SYSCFG_REMAPMEMORY_QUADSPI();
+        uint8_t idle = !((argc > 1) && (strcmp(argv[1], "off") == 0));
 
-        printf("QSPI Mounted @ 0x00000000\n");
+        Bsp_Qspi_MapMode(idle);
+        printf("QSPI %s @ 0x%08lX while idle\n", idle ? "memory-mapped" : "indirect",
+               (uint32_t)QSPI_MAP_BASE);
     }
     else if ((strcmp(argv[0], "-r") == 0) || (strcmp(argv[0], "--read") == 0))
     {
@@ -102,7 +185,7 @@ int cli_qspi(int argc, char **argv)
         pdata = (uint8_t *)cli_qspi_malloc(size);
 
         // Read Flash
-        CHECK_FUNC_EXIT(QSPI_OK, BSP_QSPI_Read(pdata, addr, size));
+        CHECK_FUNC_EXIT(QSPI_OK, Bsp_Qspi_Read(pdata, addr, size));
 
         // Print Results & free buffer
         printf("Read QSPI @ addr[0x%lX], size=[%ld]\n", addr, size);
@@ -128,7 +211,7 @@ int cli_qspi(int argc, char **argv)
         }
 
         // Write Flash
-        CHECK_FUNC_EXIT(QSPI_OK, BSP_QSPI_Write(pdata, addr, size));
+        CHECK_FUNC_EXIT(QSPI_OK, Bsp_Qspi_Write(pdata, addr, size));
 
         // Print Result
         printf("Write QSPI @ addr[0x%lX], length=[%d]\n", addr, size);
@@ -142,7 +225,7 @@ int cli_qspi(int argc, char **argv)
         printf("QSPI Chip erase start.\n");
         for (uint32_t i = 0; i < info.SectorNumber; i++)
         {
-            CHECK_FUNC_EXIT(QSPI_OK, BSP_QSPI_Erase_Sector(i));
+            CHECK_FUNC_EXIT(QSPI_OK, Bsp_Qspi_Erase(i * info.SectorSize, info.SectorSize));
             printf("\rErasing Sector [%4ld], Erased = [%8ld kB]", i, (i + 1) * (info.SectorSize));
         }
         printf("\nQSPI Chip erase OK!\n");
@@ -159,7 +242,8 @@ int cli_qspi(int argc, char **argv)
         printf("QSPI Erase Sector [0x%lX] ~ [0x%lX]\n", sector_start, sector_start + sector_num);
         for (uint32_t i = 0; i < sector_num; i++)
         {
-            CHECK_FUNC_EXIT(QSPI_OK, BSP_QSPI_Erase_Sector(sector_start + i));
+            CHECK_FUNC_EXIT(QSPI_OK,
+                            Bsp_Qspi_Erase((sector_start + i) * info.SectorSize, info.SectorSize));
             printf("\nErasing Sector [%4ld], Erased = [%8ld kB]", sector_start + i,
                    (i + 1) * (info.SectorSize));
         }
@@ -178,7 +262,8 @@ int cli_qspi(int argc, char **argv)
 
         // Erase Page
         printf("QSPI Erase @ [0x%lX]\n", address);
-        CHECK_FUNC_EXIT(QSPI_OK, BSP_QSPI_Erase_Block(address));
+        CHECK_FUNC_EXIT(QSPI_OK, Bsp_Qspi_Erase(address & ~(N25Q128A_SUBSECTOR_SIZE - 1),
+                                                N25Q128A_SUBSECTOR_SIZE));
     }
     else if ((strcmp(argv[0], "-c") == 0) || (strcmp(argv[0], "--copy") == 0))
     {
@@ -193,11 +278,23 @@ int cli_qspi(int argc, char **argv)
         uint32_t size     = strtoul(argv[3], tail, 0);
 
         // Write QSPI
-        CHECK_FUNC_EXIT(QSPI_OK, BSP_QSPI_Write((uint8_t *)src_addr, dst_addr, size));
+        CHECK_FUNC_EXIT(QSPI_OK, Bsp_Qspi_Write((uint8_t *)src_addr, dst_addr, size));
 
         // Print Results
         printf("Copy data [0x%lX] -> [0x%lX], size = %ld\n", src_addr, dst_addr, size);
     }
+    else if ((strcmp(argv[0], "-b") == 0) || (strcmp(argv[0], "--bench") == 0))
+    {
+        if ((argc < 3) || (argv[1] == NULL) || (argv[2] == NULL))
+        {
+            goto syntax_error;
+        }
+
+        uint32_t addr = strtoul(argv[1], tail, 0);
+        uint32_t size = strtoul(argv[2], tail, 0);
+
+        CHECK_FUNC_EXIT(0, cli_qspi_bench(addr, size));
+    }
     else if ((strcmp(argv[0], "-s") == 0) || (strcmp(argv[0], "--selftest") == 0))
     {
         printf("QSPI Self Test. TBD...\n");
@@ -215,6 +312,20 @@ int cli_qspi(int argc, char **argv)
         printf("EraseSectorNum  = %ld\n", info.EraseSectorsNumber);
         printf("ProgPageSize    = %ld Byte\n", info.ProgPageSize);
         printf("ProgPageNumber  = %ld\n", info.ProgPagesNumber);
+
+        uint32_t access = Qspi_CacheStat.Hit + Qspi_CacheStat.Miss;
+        printf("Cache           = %d kB, %d blocks, %s\n", QSPI_CACHE_SIZE / 1024,
+               QSPI_CACHE_BLOCKS, Qspi_CacheEnable ? "on" : "off");
+        printf("CacheHit        = %ld / %ld blocks (%ld%%)\n", Qspi_CacheStat.Hit, access,
+               access ? Qspi_CacheStat.Hit * 100 / access : 0);
+        printf("CacheReadAhead  = %ld blocks, %ld hit\n", Qspi_CacheStat.Ahead,
+               Qspi_CacheStat.AheadHit);
+        printf("CacheBypass     = %ld reads\n", Qspi_CacheStat.Bypass);
+        printf("CacheInvalidate = %ld blocks\n", Qspi_CacheStat.Invalidate);
+        printf("MapIdle         = %s\n", Qspi_MapIdle ? "memory-mapped" : "indirect");
+        printf("MapSwitch       = %ld mapped, %ld back to indirect\n", Qspi_Stat.Map,
+               Qspi_Stat.Unmap);
+        printf("MapRead         = %ld reads copied from the window\n", Qspi_Stat.MapRead);
     }
     else
     {
@@ -1,3 +1,4 @@
+#include "bsp_nvram.h"
 #include "cli.h"
 #include "stdio.h"
 #include "stdlib.h"
@@ -31,7 +32,8 @@ int cli_reset(int argc, char *argv[])
 
     CLI_PRINT("\n\e[33mReset MCU in [%ld] ms!\e[0m\r\n", delay);
 
-    // Run Pre-Reset command, clear log buffer.
+    // Run Pre-Reset command, save NVRAM cache, clear log buffer.
+    Bsp_Nvram_Flush();
     fflush(stderr);
     fflush(stdout);
 
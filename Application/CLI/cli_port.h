@@ -19,6 +19,11 @@ extern int cli_os(int argc, char **argv);
 extern int cli_top(int argc, char **argv);
 extern int cli_rtc(int argc, char **argv);
 extern int cli_nvram(int argc, char **argv);
+extern int cli_dfu(int argc, char **argv);
+extern int cli_ls(int argc, char **argv);
+extern int cli_cat(int argc, char **argv);
+extern int cli_rm(int argc, char **argv);
+extern int cli_df(int argc, char **argv);
 
 /*! Porting API
  */
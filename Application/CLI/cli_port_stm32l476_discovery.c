@@ -106,6 +106,11 @@ int cli_port_init()
     CLI_Register("qspi", "Quad-SPI flash operation", &cli_qspi);
     CLI_Register("os", "RTOS operation", &cli_os);
     CLI_Register("rtc", "Real Time Clock operation", &cli_rtc);
+    CLI_Register("dfu", "DFU boot option", &cli_dfu);
+    CLI_Register("ls", "List files on QSPI flash", &cli_ls);
+    CLI_Register("cat", "Print or write a file", &cli_cat);
+    CLI_Register("rm", "Remove files", &cli_rm);
+    CLI_Register("df", "File system usage and format", &cli_df);
 
     return 0;
 }
@@ -6,6 +6,18 @@
  * @date    2018/08/12
  * @version V0.2 Initial Version, support Intel Hex (ihex) format.
  *          V0.3 Using dfu_print / dfu_getchar instead of printf / getchar
+ *          V0.4 Streaming ihex decoder, records are decoded without line buffer.
+ *          V0.5 Binary transfer protocol, @ref dfu_proto.h
+ *          V0.6 Compressed image is decompressed on the fly, @ref dfu_lz.h
+ *          V0.7 Delta image against active bank, @ref dfu_delta.h
+ *               DFU bank is erased on the first write of a full image, not on console entry.
+ *          V0.8 Image manifest is written after a complete image, @ref Flash_ManifestTypeDef
+ *          V0.9 Reception, decoding and flash programming are pipelined, @ref Dfu_pollConsole
+ *               Text input is flow controlled with XON / XOFF.
+ *          V1.0 Image is verified by CRC unit before bank switch, @ref Flash_verifyImage
+ *               Digest of a hex image is given by command "digest <crc32>".
+ *          V1.1 Fast boot, DFU window is opened only when armed, @ref DFU_ARM
+ *          V1.2 Flash wear telemetry by binary frame WEAR, @ref bsp_wear.h
  * @ref     < https://en.wikipedia.org/wiki/Intel_HEX#Color_legend >
  *****************************************************************************/
 
@@ -17,18 +29,43 @@
 #include "stm32l4xx_hal.h"
 #include "string.h"
 
+#include "bsp_wear.h"
 #include "dfu_console.h"
+#include "dfu_delta.h"
 #include "dfu_flash_if.h"
+#include "dfu_lz.h"
+#include "dfu_proto.h"
+#include "main.h"
 
 /*! Defines -----------------------------------------------------------------*/
+// clang-format off
+#define DFU_TX_MS(bytes)    ((bytes) * 10 * 1000 / huart2.Init.BaudRate + 2) //!< 8N1, 2 ms margin
+#define DFU_TX_RETRY        3       //!< Attempts to send a reply frame
+// clang-format on
 
 /*! Variables ---------------------------------------------------------------*/
 extern UART_HandleTypeDef huart2;
-
-uint8_t *Dfu_InputBuf  = NULL;
-uint16_t Dfu_InputIdx  = 0;
-uint8_t *Dfu_OutputBuf = NULL;
-uint16_t Dfu_OutputIdx = 0;
+extern RTC_HandleTypeDef  hrtc;
+
+uint8_t *Dfu_InputBuf   = NULL;
+uint16_t Dfu_InputIdx   = 0;
+uint8_t *Dfu_OutputBuf  = NULL;
+uint16_t Dfu_OutputIdx  = 0;
+uint32_t Dfu_BankErased = 0; //!< [1]: DFU bank is mass erased for a full image
+uint32_t Dfu_ImageSize  = 0; //!< Hex image end, offset to bank start
+uint32_t Dfu_FlowOff    = 0; //!< [1]: XOFF is sent
+uint32_t Dfu_DigestSet  = 0; //!< [1]: Dfu_Digest is given for next hex image
+uint32_t Dfu_Digest     = 0; //!< CRC32 of next hex image, from host
+uint32_t Dfu_BootTime   = 0; //!< Tick from reset to first task, ms
+
+Flash_PageBufTypeDef Dfu_PageBuf = {.PageAddr = FLASH_PAGEBUF_EMPTY}; //!< DFU bank write buffer
+Dfu_ProtoTypeDef     Dfu_Proto   = {0};                                 //!< Binary protocol session
+Dfu_LzTypeDef        Dfu_Lz      = {0};                                 //!< Compressed image decoder
+Dfu_DeltaTypeDef     Dfu_Delta   = {0};                                 //!< Delta image parser
+uint8_t              Dfu_ReplyBuf[DFU_PROTO_MAX_FRAME];                   //!< Binary reply
+
+static Dfu_HexLineTypeDefine Dfu_HexLine    = {0}; //!< Hex record and counters of the image
+static Hex_DecoderTypeDef    Dfu_HexDecoder = {0}; //!< Hex record being received
 
 /*! Functions ---------------------------------------------------------------*/
 /*!@brief Convert 'A' to 0x0A
@@ -174,92 +211,70 @@ int dfu_print(char *fmt, ...)
 }
 
 /*!@brief   Get a char from DFU input port (typically UART)
- *          The UART RX data will be buffered in Dfu_InputBuf by UART hardware & DMA and wait for
- * this function to read. works like getchar() of stdio.
+ *          The UART RX data will be buffered in Dfu_InputBuf by UART hardware & circular DMA and
+ * wait for this function to read. works like getchar() of stdio.
+ *          Write position is taken from DMA counter, so binary data including 0x00 is received.
  * @return  EOF(-1)     : No data is received.
- *          0x00~0xFE   : received data.
+ *          0x00~0xFF   : received data.
  */
 int dfu_getchar()
 {
-    if (Dfu_InputBuf == NULL)
+    if ((Dfu_InputBuf == NULL) || (huart2.hdmarx == NULL))
     {
         return EOF;
     }
 
-    uint8_t c = Dfu_InputBuf[Dfu_InputIdx];
-    if (c == 0)
+    uint16_t head = DFU_INPUT_BUF_SIZE - __HAL_DMA_GET_COUNTER(huart2.hdmarx);
+    if (head >= DFU_INPUT_BUF_SIZE)
     {
-        return EOF;
+        head = 0;
     }
-    else
+
+    if (head == Dfu_InputIdx)
     {
-        Dfu_InputBuf[Dfu_InputIdx] = 0;
-        Dfu_InputIdx = (Dfu_InputIdx >= DFU_INPUT_BUF_SIZE - 1) ? 0 : Dfu_InputIdx + 1;
-        return c;
+        return EOF;
     }
+
+    uint8_t c    = Dfu_InputBuf[Dfu_InputIdx];
+    Dfu_InputIdx = (Dfu_InputIdx >= DFU_INPUT_BUF_SIZE - 1) ? 0 : Dfu_InputIdx + 1;
+    return c;
 }
 
-/*!@brief   Get a line from DFU input port (typically UART)
+/*!@brief   Write binary data to DFU output port, bypass the string buffer of dfu_print().
+ *          Wait for last UART TX transfer to finish, as long as its length takes on the line.
+ *          The reply buffer isn't touched while it is sent.
  *
- * @param   line    Pointer to where the line is saved.
- * @return  Number of bytes that received. 0x00 means there is no line ("\r")
+ * @param   buf     Pointer to data.
+ * @param   len     Data length, maximum sizeof(Dfu_ReplyBuf).
+ * @return  Number of bytes that is sent, 0 if the last transfer doesn't finish or the transmit
+ *          is refused, the caller retries.
  */
-int dfu_getline(char *line)
+int dfu_write(uint8_t *buf, uint16_t len)
 {
-    static char linebuf[HEX_MAX_STRING_LENGTH] = {0};
-    static int  idx                            = 0;
-    int         c                              = 0;
+    uint32_t tick    = HAL_GetTick();
+    uint32_t timeout = DFU_TX_MS(huart2.TxXferSize);
 
-    do
+    for (;;)
     {
-        // Get 1 char and check
-        c = dfu_getchar();
-
-        // Handle characters
-        switch (c)
-        {
-        case 0x00: // NULL for ASCII
-        case 0xFF: // EOF for ASCII
-        case EOF:  // EOF for STDIN
-        case '\n': // End of a line, Unix/Windows Style.
+        HAL_UART_StateTypeDef state = HAL_UART_GetState(&huart2);
+        if ((HAL_UART_STATE_BUSY_TX != state) && (HAL_UART_STATE_BUSY_TX_RX != state))
         {
             break;
         }
-        case '\r': // End of a line, MacOS style
+        if (HAL_GetTick() - tick >= timeout)
         {
-            if (idx < 1) // Empty line with "/n"
-            {
-                dfu_print("\n]");
-            }
-            else
-            {
-                // Copy out line buffer
-                memcpy(line, linebuf, idx);
-
-                // Clear buffer and index
-                memset(linebuf, 0, idx);
-                int ret = idx;
-                idx     = 0;
-                return ret; // return copy data count
-            }
-            break;
+            return 0;
         }
-        default:
-        {
-            // Buffer 1 byte
-            linebuf[idx++] = c;
+    }
 
-            // echo back if it's not a ihex line.
-            if (linebuf[0] != ':')
-            {
-                dfu_print("%c", c);
-            }
-            break;
-        }
-        }
-    } while ((c != '\xff') && (c != EOF));
+    len = (len > sizeof(Dfu_ReplyBuf)) ? sizeof(Dfu_ReplyBuf) : len;
+    memcpy(Dfu_ReplyBuf, buf, len);
+    if (HAL_UART_Transmit_DMA(&huart2, Dfu_ReplyBuf, len) != HAL_OK)
+    {
+        return 0;
+    }
 
-    return 0;
+    return len;
 }
 
 void dfu_io_init(void)
@@ -268,19 +283,72 @@ void dfu_io_init(void)
     memset(Dfu_InputBuf, 0, DFU_INPUT_BUF_SIZE);
 
     Dfu_OutputBuf = malloc(DFU_OUTPUT_BUF_SIZE);
-    memset(Dfu_OutputBuf, 0, DFU_INPUT_BUF_SIZE);
+    memset(Dfu_OutputBuf, 0, DFU_OUTPUT_BUF_SIZE);
 
     HAL_UART_Receive_DMA(&huart2, Dfu_InputBuf, DFU_INPUT_BUF_SIZE);
 }
 
 void dfu_io_deinit(void)
 {
+    // Send the rest of output buffer before UART is handed over, it's a few ms at most.
+    uint32_t tick = HAL_GetTick();
+    while (HAL_GetTick() - tick < 20)
+    {
+        HAL_UART_StateTypeDef state = HAL_UART_GetState(&huart2);
+        if ((HAL_UART_STATE_BUSY_TX != state) && (HAL_UART_STATE_BUSY_TX_RX != state) &&
+            (dfu_flush() == 0))
+        {
+            break;
+        }
+    }
+
     free(Dfu_InputBuf);
     free(Dfu_OutputBuf);
     HAL_UART_AbortTransmit_IT(&huart2);
     HAL_UART_AbortReceive_IT(&huart2);
 }
 
+/*!@brief   Get number of received bytes not read yet.
+ */
+static uint16_t dfu_input_count(void)
+{
+    if ((Dfu_InputBuf == NULL) || (huart2.hdmarx == NULL))
+    {
+        return 0;
+    }
+
+    uint16_t head = DFU_INPUT_BUF_SIZE - __HAL_DMA_GET_COUNTER(huart2.hdmarx);
+    return (head + DFU_INPUT_BUF_SIZE - Dfu_InputIdx) % DFU_INPUT_BUF_SIZE;
+}
+
+/*!@brief   XON / XOFF flow control of text input, binary session is paced by its window.
+ *          Sender is stopped when input buffer is half full, and resumed when it's drained.
+ *
+ * @param   stop    [1]: Stop sender before a long blocking operation, e.g. mass erase.
+ */
+static void Dfu_flowControl(uint32_t stop)
+{
+    uint8_t  c      = 0;
+    uint16_t unread = dfu_input_count();
+
+    if (Dfu_Proto.Active)
+    {
+        return;
+    }
+
+    // State changes once the character is sent, a refused one is sent on the next call.
+    if (!Dfu_FlowOff && (stop || (unread > DFU_FLOW_XOFF_LEVEL)))
+    {
+        c           = DFU_FLOW_XOFF;
+        Dfu_FlowOff = (dfu_write(&c, 1) == 1);
+    }
+    else if (Dfu_FlowOff && !stop && (unread < DFU_FLOW_XON_LEVEL))
+    {
+        c           = DFU_FLOW_XON;
+        Dfu_FlowOff = (dfu_write(&c, 1) != 1);
+    }
+}
+
 /*!@brief Parse a Intel Hex format line, example is:
  *        :020000040800F2
  *
@@ -357,6 +425,153 @@ DFU_RET Hex_ParseLine(char *string, int len, Dfu_HexLineTypeDefine *hexline)
     }
 }
 
+/*!@brief Hex character to nibble lookup table, [0xFF] means invalid character.
+ */
+static const uint8_t Hex_NibbleTable[256] = {
+    [0 ... 255] = 0xFF,
+    ['0'] = 0x0, ['1'] = 0x1, ['2'] = 0x2, ['3'] = 0x3, ['4'] = 0x4, ['5'] = 0x5,
+    ['6'] = 0x6, ['7'] = 0x7, ['8'] = 0x8, ['9'] = 0x9, ['A'] = 0xA, ['B'] = 0xB,
+    ['C'] = 0xC, ['D'] = 0xD, ['E'] = 0xE, ['F'] = 0xF, ['a'] = 0xA, ['b'] = 0xB,
+    ['c'] = 0xC, ['d'] = 0xD, ['e'] = 0xE, ['f'] = 0xF,
+};
+
+/*!@brief Reset streaming hex decoder to wait for next record.
+ *
+ * @param decoder   : Pointer to decoder structure.
+ */
+void Hex_DecoderInit(Hex_DecoderTypeDef *decoder)
+{
+    memset(decoder, 0, sizeof(Hex_DecoderTypeDef));
+    decoder->State = HEX_STATE_IDLE;
+}
+
+/*!@brief Decode Intel Hex stream byte by byte, without buffering the ASCII line.
+ *        Record fields are decoded straight into hexline, check sum is accumulated per byte.
+ *
+ * @param decoder   : Pointer to decoder structure.
+ * @param c         : Input character.
+ * @param hexline   : Pointer to hex line structure, valid when DFU_OK is returned.
+ * @return  DFU_OK      : A complete record is decoded.
+ *          DFU_BUSY    : Record is in progress, or waiting for ':'.
+ *          Others      : Record error, decoder is reset to wait for next record.
+ */
+DFU_RET Hex_DecodeByte(Hex_DecoderTypeDef *decoder, uint8_t c, Dfu_HexLineTypeDefine *hexline)
+{
+    if (decoder->State == HEX_STATE_IDLE)
+    {
+        if (c == ':')
+        {
+            Hex_DecoderInit(decoder);
+            decoder->State   = HEX_STATE_RECORD;
+            decoder->ByteLen = 5;
+            hexline->Header  = ':';
+        }
+        return DFU_BUSY;
+    }
+
+    uint8_t nibble = Hex_NibbleTable[c];
+    if (nibble == 0xFF)
+    {
+        // Line end or unknown character inside a record.
+        DFU_RET ret = ((c == '\r') || (c == '\n')) ? DFU_LENGTH_ERR : DFU_BYTE_ERR;
+        Hex_DecoderInit(decoder);
+        hexline->ErrorCount++;
+        return ret;
+    }
+
+    if (decoder->Nibble == 0)
+    {
+        decoder->Value  = nibble << 4;
+        decoder->Nibble = 1;
+        return DFU_BUSY;
+    }
+
+    uint8_t  value = decoder->Value | nibble;
+    uint16_t idx   = decoder->ByteIdx++;
+    decoder->Nibble = 0;
+    decoder->Sum += value;
+
+    /*! Record layout: Length | Offset(H) | Offset(L) | Type | Data[Length] | CheckSum */
+    switch (idx)
+    {
+    case 0:
+        hexline->DataLength = value;
+        decoder->ByteLen    = 5 + value;
+        break;
+    case 1:
+        hexline->DataOffset = value << 8;
+        break;
+    case 2:
+        hexline->DataOffset |= value;
+        break;
+    case 3:
+        hexline->DataType = value;
+        break;
+    default:
+        if (idx < decoder->ByteLen - 1)
+        {
+            hexline->DataBuf[idx - 4] = value;
+            break;
+        }
+
+        // Last byte is check sum
+        hexline->CheckSum = value;
+        DFU_RET ret       = (decoder->Sum == 0) ? DFU_OK : DFU_CHECKSUM_ERR;
+        Hex_DecoderInit(decoder);
+
+        if (ret == DFU_OK)
+        {
+            hexline->LineCount++;
+        }
+        else
+        {
+            hexline->ErrorCount++;
+        }
+        return ret;
+    }
+
+    return DFU_BUSY;
+}
+
+/*!@brief Start over for the next image: DFU bank is erased again before fast programming, a
+ *        partial hex record and the counters of the last hex image are dropped.
+ *        Called when a session starts, ends, fails or is aborted.
+ */
+void Dfu_resetSession(void)
+{
+    Dfu_BankErased = 0;
+    Dfu_ImageSize  = 0;
+    Hex_DecoderInit(&Dfu_HexDecoder);
+    memset(&Dfu_HexLine, 0, sizeof(Dfu_HexLine));
+}
+
+/*!@brief Drop the binary session, console takes text input again.
+ *        Page buffer is emptied without commit, DFU bank is prepared again by next image.
+ *
+ * @param reason    : Printed to console.
+ */
+static void Dfu_abortSession(const char *reason)
+{
+    Dfu_Proto.Active    = 0;
+    Dfu_Proto.State     = DFU_PROTO_STATE_SOF;
+    Dfu_Proto.NakOffset = 0xFFFFFFFF;
+    Flash_pageBufInit(&Dfu_PageBuf, 0);
+    Dfu_resetSession();
+    dfu_print("\r\nBinary session %s, next image starts over.\n]", reason);
+}
+
+/*!@brief Mass erase DFU bank for a full image, fast programming is allowed after.
+ */
+static void Dfu_prepareBank(uint32_t bank)
+{
+    Dfu_flowControl(1);
+    Flash_eraseBank(bank);
+    Flash_pageBufInit(&Dfu_PageBuf, 1);
+    Flash_pageBufCrcStart(&Dfu_PageBuf, Flash_getAddress(bank, 0));
+    Dfu_BankErased = 1;
+    Dfu_ImageSize  = 0;
+}
+
 /*!@brief Write Flash using Intel hex line.
  *
  * @param hexline   : Pointer to a hexline structure.
@@ -374,12 +589,31 @@ DFU_RET Hex_ExcuteLine(Dfu_HexLineTypeDefine *hexline)
     switch (hexline->DataType)
     {
     case HEX_DATATYPE_DATA: //!< Write Byte to Flash
-        // Calculate Address on backup bank
-        address = hexline->BaseAddress + hexline->DataOffset - FLASH_BASE +
-                  Flash_getAddress(OtherBank, 0);
+        // Erase DFU bank on the first record of an image.
+        if (!Dfu_BankErased)
+        {
+            Dfu_prepareBank(OtherBank);
+        }
 
-        // Write Flash
-        Flash_program_8bit(address, hexline->DataBuf, hexline->DataLength);
+        // Calculate Address on backup bank, last page is kept for manifest.
+        address = hexline->BaseAddress + hexline->DataOffset - FLASH_BASE;
+        if (address + hexline->DataLength > FLASH_IMAGE_MAX_SIZE)
+        {
+            hexline->ErrorCount++;
+            break;
+        }
+        if (address + hexline->DataLength > Dfu_ImageSize)
+        {
+            Dfu_ImageSize = address + hexline->DataLength;
+        }
+        address += Flash_getAddress(OtherBank, 0);
+
+        // Write Flash through page buffer, a page is programmed when it is complete.
+        if (Flash_pageBufWrite(&Dfu_PageBuf, address, hexline->DataBuf, hexline->DataLength) !=
+            HAL_OK)
+        {
+            hexline->ErrorCount++;
+        }
 
         // Add byte count
         hexline->ByteCount += hexline->DataLength;
@@ -392,11 +626,38 @@ DFU_RET Hex_ExcuteLine(Dfu_HexLineTypeDefine *hexline)
 
         break;
     case HEX_DATATYPE_END: //!< End of a Hex File
+    {
+        uint32_t crc = 0;
+
+        // Commit last partial page, verify the image, then write its manifest.
+        if (Flash_pageBufFlush(&Dfu_PageBuf) != HAL_OK)
+        {
+            hexline->ErrorCount++;
+        }
+        if ((hexline->ErrorCount == 0) &&
+            (Flash_verifyImage(&Dfu_PageBuf, OtherBank, Dfu_ImageSize, &crc) != HAL_OK))
+        {
+            hexline->ErrorCount++;
+        }
+        if ((hexline->ErrorCount == 0) && Dfu_DigestSet && (crc != Dfu_Digest))
+        {
+            dfu_print("\r\nERROR: Image CRC [0x%08lX] != digest [0x%08lX]\n", crc, Dfu_Digest);
+            hexline->ErrorCount++;
+        }
+        if ((hexline->ErrorCount == 0) &&
+            (Flash_writeManifest(OtherBank, Dfu_ImageSize, crc) != HAL_OK))
+        {
+            hexline->ErrorCount++;
+        }
+        Dfu_DigestSet = 0;
+
         // End of operation
         dfu_print("\r\n[%03d.%03d]Hex: End of file\n", HAL_GetTick() / 1000, HAL_GetTick() % 1000);
         dfu_print("Hex: LineCount  = %ld\n", hexline->LineCount);
         dfu_print("Hex: ErrorCount = %ld\n", hexline->ErrorCount);
         dfu_print("Hex: ByteCount  = %ld\n", hexline->ByteCount);
+        dfu_print("Hex: PageCount  = %ld, FastRow = %ld, DoubleWord = %ld\n", Dfu_PageBuf.PageCount,
+                  Dfu_PageBuf.RowCount, Dfu_PageBuf.DwordCount);
         dfu_flush();
         HAL_Delay(10);
 
@@ -410,6 +671,7 @@ DFU_RET Hex_ExcuteLine(Dfu_HexLineTypeDefine *hexline)
             Flash_setActiveBank(OtherBank);
         }
         break;
+    }
     case HEX_DATATYPE_EXT_SEG_ADDR:
         // Not Used
         break;
@@ -439,6 +701,315 @@ DFU_RET Hex_ExcuteLine(Dfu_HexLineTypeDefine *hexline)
     return 0;
 }
 
+/*!@brief Send a binary protocol reply frame.
+ *
+ * @param cmd       : DFU_PROTO_CMD_ACK or DFU_PROTO_CMD_NAK
+ * @param offset    : Next expected image offset.
+ * @param payload   : Pointer to payload.
+ * @param len       : Payload length, maximum DFU_PROTO_MAX_PAYLOAD.
+ */
+static void Dfu_protoReply(uint8_t cmd, uint32_t offset, const uint8_t *payload, uint16_t len)
+{
+    uint8_t  buf[sizeof(Dfu_ReplyBuf)];
+    uint16_t size = Dfu_protoPack(buf, cmd, offset, payload, len);
+
+    for (int i = 0; (i < DFU_TX_RETRY) && (dfu_write(buf, size) == 0); i++)
+    {
+    }
+}
+
+static uint32_t Dfu_protoGet32(const uint8_t *buf)
+{
+    return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+/*!@brief Decompressed image output, ctx is the DFU bank address.
+ */
+static uint32_t Dfu_lzWrite(void *ctx, uint32_t pos, const uint8_t *buf, uint32_t len)
+{
+    return Flash_pageBufWrite(&Dfu_PageBuf, (uint32_t)ctx + pos, (uint8_t *)buf, len);
+}
+
+/*!@brief Match history, read back from DFU bank and page buffer.
+ */
+static uint32_t Dfu_lzRead(void *ctx, uint32_t pos, uint8_t *buf, uint32_t len)
+{
+    return Flash_pageBufRead(&Dfu_PageBuf, (uint32_t)ctx + pos, buf, len);
+}
+
+/*!@brief Delta image output, ctx is the DFU bank address.
+ *        Page buffer erases a page only when its content changes.
+ */
+static uint32_t Dfu_deltaWrite(void *ctx, uint32_t pos, const uint8_t *buf, uint32_t len)
+{
+    return Flash_pageBufWrite(&Dfu_PageBuf, (uint32_t)ctx + pos, (uint8_t *)buf, len);
+}
+
+/*!@brief Rebuild unchanged pages of delta image from active bank.
+ *        A page already in place, e.g. DFU bank holds an older image with the same page, is
+ *        not copied again.
+ */
+static uint32_t Dfu_deltaCopy(void *ctx, uint32_t src_page, uint32_t pos, uint32_t count)
+{
+    uint32_t CurrentBank = Flash_getActiveBank();
+    uint32_t OtherBank   = FLASH_BANK_2 + FLASH_BANK_1 - CurrentBank;
+    uint32_t DstPage     = pos / FLASH_PAGE_SIZE;
+
+    // Output is page aligned here, commit the last DATA page first.
+    uint32_t ret = Flash_pageBufFlush(&Dfu_PageBuf);
+
+    for (uint32_t i = 0; (i < count) && (ret == HAL_OK); i++)
+    {
+        if (Flash_cmpPage(CurrentBank, src_page + i, OtherBank, DstPage + i) != 0)
+        {
+            Dfu_PageBuf.EraseCount += (Flash_checkPageUsage(OtherBank, DstPage + i) != 0);
+            Dfu_PageBuf.PageCount++;
+            ret = Flash_copyPage(CurrentBank, src_page + i, OtherBank, DstPage + i);
+        }
+    }
+
+    return ret;
+}
+
+/*!@brief Execute a binary protocol frame received from host.
+ *        DATA is written to DFU bank through page buffer, same as Intel Hex records.
+ *        DATA of a compressed image is decompressed into the page buffer.
+ *
+ * @param proto     : Pointer to protocol structure, a decoded frame is in proto->Frame.
+ * @return  DFU_OK or DFU_ERROR if a NAK is sent.
+ */
+DFU_RET Dfu_protoExcuteFrame(Dfu_ProtoTypeDef *proto)
+{
+    Dfu_ProtoFrameTypeDef *frame  = &proto->Frame;
+    uint8_t                status = 0;
+
+    uint32_t CurrentBank = Flash_getActiveBank();
+    uint32_t OtherBank   = FLASH_BANK_2 + FLASH_BANK_1 - CurrentBank;
+    uint32_t BankAddr    = Flash_getAddress(OtherBank, 0);
+
+    switch (frame->Cmd)
+    {
+    case DFU_PROTO_CMD_START:
+    {
+        uint32_t size    = Dfu_protoGet32(&frame->Payload[0]);
+        uint32_t crc     = Dfu_protoGet32(&frame->Payload[4]);
+        uint32_t format  = DFU_PROTO_FORMAT_RAW;
+        uint32_t rawsize = size;
+        uint32_t rawcrc  = crc;
+        uint32_t basesize = 0;
+        uint32_t basecrc  = 0;
+
+        if (frame->Length >= DFU_PROTO_START_SIZE_EX)
+        {
+            format  = frame->Payload[8];
+            rawsize = Dfu_protoGet32(&frame->Payload[12]);
+            rawcrc  = Dfu_protoGet32(&frame->Payload[16]);
+        }
+        if (frame->Length >= DFU_PROTO_START_SIZE_DELTA)
+        {
+            basesize = Dfu_protoGet32(&frame->Payload[20]);
+            basecrc  = Dfu_protoGet32(&frame->Payload[24]);
+        }
+
+        if ((frame->Length < DFU_PROTO_START_SIZE) || (size == 0) || (rawsize == 0) ||
+            (rawsize > FLASH_IMAGE_MAX_SIZE) ||
+            ((format == DFU_PROTO_FORMAT_RAW) && (size != rawsize)))
+        {
+            status = DFU_PROTO_STATUS_SIZE;
+            break;
+        }
+        if ((format > DFU_PROTO_FORMAT_DELTA) ||
+            ((format == DFU_PROTO_FORMAT_DELTA) && (frame->Length < DFU_PROTO_START_SIZE_DELTA)))
+        {
+            status = DFU_PROTO_STATUS_FORMAT;
+            break;
+        }
+        // Delta is built on the running image, check it's the one host made the patch against.
+        if ((format == DFU_PROTO_FORMAT_DELTA) &&
+            ((basesize > FLASH_BANK_SIZE) ||
+             (Flash_crc32(Flash_getAddress(CurrentBank, 0), basesize) != basecrc)))
+        {
+            status = DFU_PROTO_STATUS_BASE;
+            break;
+        }
+
+        // Same image as the active session, resume from next expected offset.
+        // Decoder state is kept in RAM, so a compressed stream resumes as well.
+        if (!(proto->Active && (proto->ImageSize == size) && (proto->ImageCrc == crc) &&
+              (proto->Format == format) && (proto->RawSize == rawsize) &&
+              (proto->RawCrc == rawcrc)))
+        {
+            proto->Active     = 1;
+            proto->ImageSize  = size;
+            proto->ImageCrc   = crc;
+            proto->Format     = format;
+            proto->RawSize    = rawsize;
+            proto->RawCrc     = rawcrc;
+            proto->NextOffset = 0;
+            Dfu_resetSession();
+            if (format == DFU_PROTO_FORMAT_DELTA)
+            {
+                // Pages of DFU bank are erased only when they change.
+                Flash_pageBufInit(&Dfu_PageBuf, 0);
+                Flash_pageBufCrcStart(&Dfu_PageBuf, BankAddr);
+                Dfu_deltaInit(&Dfu_Delta, FLASH_IMAGE_MAX_SIZE, FLASH_PAGE_SIZE, Dfu_deltaWrite,
+                              Dfu_deltaCopy, (void *)BankAddr);
+            }
+            else
+            {
+                Dfu_prepareBank(OtherBank);
+                Dfu_lzInit(&Dfu_Lz, rawsize, Dfu_lzWrite, Dfu_lzRead, (void *)BankAddr);
+            }
+        }
+        proto->NakOffset = 0xFFFFFFFF;
+
+        uint8_t info[4] = {DFU_PROTO_WINDOW & 0xFF, DFU_PROTO_WINDOW >> 8,
+                           DFU_PROTO_MAX_PAYLOAD & 0xFF, DFU_PROTO_MAX_PAYLOAD >> 8};
+        Dfu_protoReply(DFU_PROTO_CMD_ACK, proto->NextOffset, info, sizeof(info));
+        return DFU_OK;
+    }
+    case DFU_PROTO_CMD_DATA:
+    {
+        if (!proto->Active)
+        {
+            status = DFU_PROTO_STATUS_SESSION;
+            break;
+        }
+
+        if (frame->Offset + frame->Length > proto->ImageSize)
+        {
+            status = DFU_PROTO_STATUS_SIZE;
+            break;
+        }
+
+        if (frame->Offset > proto->NextOffset)
+        {
+            // A frame is lost, NAK once and drop the rest of the window.
+            proto->DropCount++;
+            if (proto->NakOffset == proto->NextOffset)
+            {
+                return DFU_ERROR;
+            }
+            status = DFU_PROTO_STATUS_OFFSET;
+            break;
+        }
+
+        // Duplicated frame after host goes back is acknowledged without writing.
+        if (frame->Offset == proto->NextOffset)
+        {
+            DFU_RET ret = DFU_OK;
+            switch (proto->Format)
+            {
+            case DFU_PROTO_FORMAT_LZ4:
+                ret = Dfu_lzDecode(&Dfu_Lz, frame->Payload, frame->Length);
+                break;
+            case DFU_PROTO_FORMAT_DELTA:
+                ret = Dfu_deltaDecode(&Dfu_Delta, frame->Payload, frame->Length);
+                break;
+            default:
+                ret = (Flash_pageBufWrite(&Dfu_PageBuf, BankAddr + frame->Offset, frame->Payload,
+                                          frame->Length) == HAL_OK)
+                          ? DFU_OK
+                          : DFU_FLASH_ERROR;
+                break;
+            }
+
+            if (ret != DFU_OK)
+            {
+                // Decoder state is lost in the middle of the frame, START over.
+                proto->Active = (proto->Format == DFU_PROTO_FORMAT_RAW);
+                status        = (ret == DFU_FLASH_ERROR) ? DFU_PROTO_STATUS_FLASH
+                                                         : DFU_PROTO_STATUS_FORMAT;
+                if (!proto->Active)
+                {
+                    Dfu_resetSession();
+                }
+                break;
+            }
+            proto->NextOffset += frame->Length;
+        }
+
+        Dfu_protoReply(DFU_PROTO_CMD_ACK, proto->NextOffset, NULL, 0);
+        return DFU_OK;
+    }
+    case DFU_PROTO_CMD_END:
+    {
+        if (!proto->Active || (proto->NextOffset != proto->ImageSize))
+        {
+            status = DFU_PROTO_STATUS_SESSION;
+            break;
+        }
+
+        // Commit last partial page and check the whole image. The session is over whatever
+        // the result, DFU bank is no longer erased.
+        proto->Active = 0;
+        Dfu_resetSession();
+        if (Flash_pageBufFlush(&Dfu_PageBuf) != HAL_OK)
+        {
+            status = DFU_PROTO_STATUS_FLASH;
+            break;
+        }
+        // Delta output is padded to a page.
+        if (((proto->Format == DFU_PROTO_FORMAT_LZ4) && (Dfu_Lz.OutSize != proto->RawSize)) ||
+            ((proto->Format == DFU_PROTO_FORMAT_DELTA) &&
+             ((Dfu_Delta.OutSize < proto->RawSize) ||
+              (Dfu_Delta.OutSize - proto->RawSize >= FLASH_PAGE_SIZE))))
+        {
+            status = DFU_PROTO_STATUS_FORMAT;
+            break;
+        }
+        // Flash content is checked against running CRC and digest from host by CRC unit.
+        uint32_t crc = 0;
+        if (Flash_verifyImage(&Dfu_PageBuf, OtherBank, proto->RawSize, &crc) != HAL_OK)
+        {
+            status = DFU_PROTO_STATUS_FLASH;
+            break;
+        }
+        if (crc != proto->RawCrc)
+        {
+            status = DFU_PROTO_STATUS_IMAGE_CRC;
+            break;
+        }
+        if (Flash_writeManifest(OtherBank, proto->RawSize, crc) != HAL_OK)
+        {
+            status = DFU_PROTO_STATUS_FLASH;
+            break;
+        }
+
+        uint8_t info[4] = {proto->ImageCrc, proto->ImageCrc >> 8, proto->ImageCrc >> 16,
+                           proto->ImageCrc >> 24};
+        Dfu_protoReply(DFU_PROTO_CMD_ACK, proto->NextOffset, info, sizeof(info));
+        HAL_Delay(10);
+        Flash_setActiveBank(OtherBank);
+        return DFU_OK;
+    }
+    case DFU_PROTO_CMD_QUERY:
+    {
+        Dfu_protoReply(DFU_PROTO_CMD_ACK, proto->NextOffset, NULL, 0);
+        return DFU_OK;
+    }
+    case DFU_PROTO_CMD_WEAR:
+    {
+        Wear_TelemetryTypeDef tm = {0};
+
+        // NVRAM isn't up in the DFU window at boot, its PVD flush must not run while
+        // flash is programmed. Saved counters are only sent once the application loaded them.
+        Bsp_Wear_Get(&tm);
+        Dfu_protoReply(DFU_PROTO_CMD_ACK, proto->NextOffset, (uint8_t *)&tm, sizeof(tm));
+        return DFU_OK;
+    }
+    default:
+    {
+        status = DFU_PROTO_STATUS_CMD;
+        break;
+    }
+    }
+
+    proto->NakOffset = proto->NextOffset;
+    Dfu_protoReply(DFU_PROTO_CMD_NAK, proto->NextOffset, &status, 1);
+    return DFU_ERROR;
+}
+
 uint32_t Dfu_selectBootBank()
 {
     //!< Get current working bank
@@ -472,14 +1043,35 @@ uint32_t Dfu_selectBootBank()
     return CurrentBank;
 }
 
+/*!@brief Arm or disarm DFU window of next boot.
+ *        Backup domain access is enabled by SystemClock_Config() and kept.
+ *
+ * @param arm   [1]: Open DFU window on next boot, [0]: Boot straight to application.
+ */
+void Dfu_arm(uint32_t arm)
+{
+    HAL_RTCEx_BKUPWrite(&hrtc, DFU_ARM_BKP_REG, arm ? DFU_ARM_MAGIC : 0);
+}
+
+/*!@brief Check if DFU window should be opened on this boot.
+ *
+ * @return  [1]: Armed by CLI, or joystick center is held, or fast boot is disabled.
+ */
+uint32_t Dfu_isArmed(void)
+{
+    return (!DFU_FAST_BOOT) || (HAL_RTCEx_BKUPRead(&hrtc, DFU_ARM_BKP_REG) == DFU_ARM_MAGIC) ||
+           (HAL_GPIO_ReadPin(JOY_CENTER_GPIO_Port, JOY_CENTER_Pin) == GPIO_PIN_SET);
+}
+
 /*!@brief DFU Initial Work Flow:
  *
  * FLASH_BANK_1 is working bank.
  * FLASH_BANK_2 is DFU bank.
  *
- * [Reboot] -> Bank1 ? -> Wait Key for 1s ------No----->             [Normal work]
- *                                        |
- *                                        ------YES---->             [DFU]
+ * [Reboot] -> Bank1 ? -> Armed ? -> Wait Key for 1s ------No----->  [Normal work]
+ *                          |                         |
+ *                          |                         ------YES---->  [DFU]
+ *                          ----No------------------------------->  [Normal work]
  *
  * [Reboot] -> Bank2 ? -> Copy Bank2 to Bank1 -> Set Bank1 active -> [Reboot]
  *
@@ -496,8 +1088,17 @@ DFU_RET Bsp_Dfu_Init()
     /*! 2. Select Boot bank & DFU bank*/
     uint32_t BootBank = Dfu_selectBootBank();
     uint32_t DfuBank  = FLASH_BANK_2 + FLASH_BANK_1 - BootBank;
+    dfu_print("%s: Boot bank [%ld], DFU bank [%ld]\n", __FILE__, BootBank, DfuBank);
+
+    /*! 3. Wait Keyboard to enter DFU console, only when armed. The flag is for one boot. */
+    if (!Dfu_isArmed())
+    {
+        dfu_print("%s: Fast boot, run [dfu --arm] to open DFU window on next boot.\n", __FILE__);
+        dfu_io_deinit();
+        return DFU_OK;
+    }
+    Dfu_arm(0);
 
-    /*! 3. Wait Keyboard to enter DFU console. */
     dfu_print("%s: Press [Enter] to enter DFU console, wait %d ms.\n", __FILE__, DFU_BOOT_DELAY);
     uint32_t end_tick = HAL_GetTick() + DFU_BOOT_DELAY;
     while (HAL_GetTick() < end_tick)
@@ -507,9 +1108,9 @@ DFU_RET Bsp_Dfu_Init()
         {
             dfu_print("\n========Start of DFU=========\n");
 
-            // Erase target flash
-            // Flash_erasePage(DfuBank, 0, DFU_MAX_PAGE);
-            Flash_eraseBank(DfuBank);
+            // DFU bank is erased when a full image starts, a delta image keeps unchanged pages.
+            Dfu_resetSession();
+            Flash_pageBufInit(&Dfu_PageBuf, 0);
 
             // Run DFU console
             Bsp_Dfu_Console();
@@ -523,88 +1124,220 @@ DFU_RET Bsp_Dfu_Init()
     return DFU_OK;
 }
 
-/*!@brief  Start a mini console for DFU function.
- *         It will check input of UART and write DFU bank flash.
+/*!@brief Process pending input of DFU console, return when the input buffer is empty.
+ *        Characters are routed to one of:
+ *        - Binary protocol decoder : frame starts with DFU_PROTO_SOF.
+ *        - Intel Hex decoder       : record starts with ':'.
+ *        - Command line            : others, echo back and process on '\r'.
  *
- * @return
+ * @return  DFU_BUSY    : Input is processed, call again later.
+ *          DFU_END     : Quit command is received.
  */
-DFU_RET Bsp_Dfu_Console()
+DFU_RET Dfu_processInput(void)
 {
     const char *Dfu_helptext =
         "\n"
         "\e[1m\e[5m===Mini DFU console===\e[0m\n"
         "FW Download: Transmit the <.hex> file through UART, e.g.\n"
         "             \e[4mcat ./Build/discovery.hex >/dev/cu.usbmodem14203\e[0m\n"
+        "             enable XON/XOFF of the port for high baudrate, e.g. \e[4mstty ixon\e[0m\n"
+        "             or upload <.bin> file with binary protocol, e.g.\n"
+        "             \e[4m./Build/Host/dfu_upload /dev/cu.usbmodem14203 ./Build/discovery.bin\e[0m\n"
+        "             a stalled binary upload is dropped by Ctrl-C x3, or after 30 s idle.\n"
+        "digest <crc32> : CRC32 of next <.hex> image, checked before bank switch, e.g.\n"
+        "             \e[4mdigest $(crc32 ./Build/discovery.bin)\e[0m\n"
         "quit   | q : Quit DFU mode\n"
         "status | s : Show DFU status.\n"
         "help       : Show this help text.\r\n";
 
     static int                   str_len                        = 0;
     static char                  str_buf[HEX_MAX_STRING_LENGTH] = {0};
-    static Dfu_HexLineTypeDefine hexline                        = {0};
+    static int                   hex_eol                        = 0;
+    static int                   abort_cnt                      = 0;
 
     DFU_RET ret = DFU_OK;
+    int     c   = EOF;
 
-    dfu_print("\r\n]");
-
-    while (1)
+    // A lost host leaves the session active, give the console back.
+    if (Dfu_Proto.Active && (HAL_GetTick() - Dfu_Proto.LastTick > DFU_PROTO_SESSION_TIMEOUT))
     {
-        // Get Line from UART
-        str_len = dfu_getline(str_buf);
+        Dfu_abortSession("timeout");
+    }
 
-        if (str_len > 0)
+    // Input waits in DMA ring while both pages of page buffer are in use.
+    while (!Flash_pageBufBusy(&Dfu_PageBuf) && ((c = dfu_getchar()) != EOF))
+    {
+        /*! Binary frames, other bytes are dropped during a binary session. */
+        if ((Dfu_Proto.State != DFU_PROTO_STATE_SOF) || (Dfu_Proto.Active) ||
+            ((c == DFU_PROTO_SOF) && (str_len == 0) && (Dfu_HexDecoder.State == HEX_STATE_IDLE)))
         {
-            // Process command
-            if (strcmp(str_buf, "help") == 0)
+            ret = Dfu_protoDecodeByte(&Dfu_Proto, c, HAL_GetTick());
+
+            // Ctrl-C dropped between frames, or after a partial frame times out.
+            abort_cnt = ((c == DFU_PROTO_ABORT) && (ret == DFU_BUSY) &&
+                         (Dfu_Proto.State == DFU_PROTO_STATE_SOF))
+                            ? abort_cnt + 1
+                            : 0;
+            if (abort_cnt == DFU_PROTO_ABORT_COUNT)
             {
-                dfu_print("\n%s", Dfu_helptext);
+                abort_cnt = 0;
+                Dfu_abortSession("aborted");
             }
-            else if ((strcmp(str_buf, "q") == 0) || (strcmp(str_buf, "quit") == 0))
+            else if (ret == DFU_OK)
             {
-                dfu_print("\nQuit DFU process.\n");
-                return -1;
+                Dfu_protoExcuteFrame(&Dfu_Proto);
             }
-            else if ((strcmp(str_buf, "s") == 0) || (strcmp(str_buf, "status") == 0))
+            else if (ret != DFU_BUSY)
             {
-                dfu_print("%s\nDFU status:\n", str_buf);
-                dfu_print("HexLineCount  = %ld\n", hexline.LineCount);
-                dfu_print("HexErrorCount = %ld\n", hexline.ErrorCount);
-                dfu_print("HexByteCount  = %ld\n", hexline.ByteCount);
+                // Broken frame, ask host to resend from next expected offset.
+                uint8_t status      = DFU_PROTO_STATUS_CRC;
+                Dfu_Proto.NakOffset = Dfu_Proto.NextOffset;
+                Dfu_protoReply(DFU_PROTO_CMD_NAK, Dfu_Proto.NextOffset, &status, 1);
             }
-            else if (str_buf[0] == ':')
+            continue;
+        }
+
+        /*! Intel Hex records are decoded on the fly, no line buffer for them. */
+        if ((Dfu_HexDecoder.State != HEX_STATE_IDLE) || ((c == ':') && (str_len == 0)))
+        {
+            ret = Hex_DecodeByte(&Dfu_HexDecoder, c, &Dfu_HexLine);
+            if (ret == DFU_OK)
             {
-                // Parse sting using ihex format
-                ret = Hex_ParseLine(str_buf, str_len, &hexline);
-                if (ret == DFU_OK)
+                // Process HEX line
+                ret = Hex_ExcuteLine(&Dfu_HexLine);
+                if (ret != DFU_OK)
                 {
-                    // Process HEX line
-                    ret = Hex_ExcuteLine(&hexline);
-                    if (ret != DFU_OK)
-                    {
-                        dfu_print("ERROR: Dfu_runHexLine fail, error code = [%d]\n", ret);
-                    }
+                    dfu_print("ERROR: Dfu_runHexLine fail, error code = [%d]\n", ret);
                 }
-                else
+                // Image is switched to or failed, a retry starts on an erased bank.
+                if (Dfu_HexLine.DataType == HEX_DATATYPE_END)
                 {
-
-                    dfu_print("ERROR: Dfu_parseHexLine fail, error code = [%d]\n", ret);
+                    Dfu_resetSession();
                 }
+                hex_eol = 1;
+            }
+            else if (ret != DFU_BUSY)
+            {
+                dfu_print("ERROR: Dfu_parseHexLine fail, error code = [%d]\n", ret);
+                hex_eol = 1;
+            }
+            continue;
+        }
 
-                // Clear buffer after successfully run a command.
+        /*! Other characters are command line, echo back and process on '\r'. */
+        switch (c)
+        {
+        case 0x00: // NULL for ASCII
+        case 0xFF: // EOF for ASCII
+        case '\n': // End of a line, Unix/Windows Style.
+        {
+            break;
+        }
+        case '\r': // End of a line, MacOS style
+        {
+            if (str_len == 0)
+            {
+                // Empty line, skip the one that ends a hex record.
+                if (!hex_eol)
+                {
+                    dfu_print("\n]");
+                }
+            }
+            else if (strcmp(str_buf, "help") == 0)
+            {
+                dfu_print("\n%s", Dfu_helptext);
+            }
+            else if ((strcmp(str_buf, "q") == 0) || (strcmp(str_buf, "quit") == 0))
+            {
+                dfu_print("\nQuit DFU process.\n");
                 memset(str_buf, 0, sizeof(str_buf));
                 str_len = 0;
+                return DFU_END;
+            }
+            else if (strncmp(str_buf, "digest ", 7) == 0)
+            {
+                char *end     = NULL;
+                Dfu_Digest    = strtoul(&str_buf[7], &end, 16);
+                Dfu_DigestSet = (end != &str_buf[7]);
+                dfu_print("\nDigest of next image = [0x%08lX]%s\n", Dfu_Digest,
+                          Dfu_DigestSet ? "" : ", invalid");
+            }
+            else if ((strcmp(str_buf, "s") == 0) || (strcmp(str_buf, "status") == 0))
+            {
+                dfu_print("%s\nDFU status:\n", str_buf);
+                dfu_print("HexLineCount  = %ld\n", Dfu_HexLine.LineCount);
+                dfu_print("HexErrorCount = %ld\n", Dfu_HexLine.ErrorCount);
+                dfu_print("HexByteCount  = %ld\n", Dfu_HexLine.ByteCount);
+                dfu_print("PageCount     = %ld\n", Dfu_PageBuf.PageCount);
+                dfu_print("PageErase     = %ld\n", Dfu_PageBuf.EraseCount);
+                dfu_print("BinFrameCount = %ld\n", Dfu_Proto.FrameCount);
+                dfu_print("BinCrcError   = %ld\n", Dfu_Proto.CrcErrorCount);
+                dfu_print("BinOffset     = %ld / %ld\n", Dfu_Proto.NextOffset, Dfu_Proto.ImageSize);
+                dfu_print("BinRawOffset  = %ld / %ld\n",
+                          (Dfu_Proto.Format == DFU_PROTO_FORMAT_LZ4) ? Dfu_Lz.OutSize
+                                                                  : Dfu_Proto.NextOffset,
+                          Dfu_Proto.RawSize);
             }
             else
             {
                 dfu_print("\nERROR: Unknown command, try [help].\n");
             }
 
-            // Clear empty line
+            // Clear line after run a command.
             memset(str_buf, 0, sizeof(str_buf));
             str_len = 0;
+            hex_eol = 0;
+            break;
+        }
+        default:
+        {
+            // Buffer 1 byte and echo back
+            if (str_len < HEX_MAX_STRING_LENGTH - 1)
+            {
+                str_buf[str_len++] = c;
+                dfu_print("%c", c);
+            }
+            hex_eol = 0;
+            break;
+        }
         }
+    }
 
-        dfu_flush();
+    return DFU_BUSY;
+}
+
+/*!@brief  A single pass of DFU console loop.
+ *         Input is decoded into page buffer while a page is committed a row at a time, so UART
+ *         reception, decoding and flash programming overlap.
+ *
+ * @return @ref Dfu_processInput
+ */
+DFU_RET Dfu_pollConsole(void)
+{
+    DFU_RET ret = Dfu_processInput();
+
+    Dfu_flowControl(0);
+    Flash_pageBufPoll(&Dfu_PageBuf);
+    dfu_flush();
+
+    return ret;
+}
+
+/*!@brief  Start a mini console for DFU function.
+ *         It will check input of UART and write DFU bank flash.
+ *
+ * @return
+ */
+DFU_RET Bsp_Dfu_Console()
+{
+    dfu_print("\r\n]");
+
+    while (1)
+    {
+        if (Dfu_pollConsole() == DFU_END)
+        {
+            return -1;
+        }
     };
 
     return DFU_OK;
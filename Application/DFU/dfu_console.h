@@ -6,6 +6,10 @@
  * @date    2018/08/12
  * @version V0.2 Initial Version, support Intel Hex (ihex) format.
  *          V0.3 Using dfu_print / dfu_getchar instead of STDIO.
+ *          V0.4 Streaming ihex decoder.
+ *          V0.5 Binary transfer protocol.
+ *          V0.6 Compressed image.
+ *          V0.9 Reception and flash programming are pipelined.
  *
  *****************************************************************************/
 
@@ -30,12 +34,36 @@
 #define HEX_MAX_STRING_LENGTH           64      //!< Maximum ihex file line length
 #define HEX_MAX_DATA_LENGTH             16      //!< Maximum ihex data length in a single line
 
+/*!@defgroup    HEX_STATE Define Group
+ *              State of streaming ihex decoder.
+ */
+#define HEX_STATE_IDLE                  0       //!< Wait for ':' of next record
+#define HEX_STATE_RECORD                1       //!< Decoding record bytes
+
 #define DFU_ENTERANCE_CHAR              '\r'    //!< Character to enter DFU mode
 #define DFU_PROMPT_CHAR                 "]"     //!< Character as line prompt in DFU mode
 #define DFU_BOOT_DELAY                  1000    //!< Delay time for wait keyboard input to enter DFU
-#define DFU_INPUT_BUF_SIZE              2048    //!< IO input buffer size
+#define DFU_INPUT_BUF_SIZE              4096    //!< IO input buffer size
 #define DFU_OUTPUT_BUF_SIZE             2048    //!< IO output buffer size
 
+/*!@defgroup    DFU_FLOW Define Group
+ *              XON / XOFF flow control of text input, e.g. Intel hex sent by a terminal.
+ *              Binary protocol is paced by its window instead.
+ */
+#define DFU_FLOW_XON                    0x11
+#define DFU_FLOW_XOFF                   0x13
+#define DFU_FLOW_XOFF_LEVEL             (DFU_INPUT_BUF_SIZE / 2)    //!< Unread bytes to send XOFF
+#define DFU_FLOW_XON_LEVEL              (DFU_INPUT_BUF_SIZE / 8)    //!< Unread bytes to send XON
+
+/*!@defgroup    DFU_ARM Define Group
+ *              Fast boot, DFU_BOOT_DELAY window is opened only when it's armed for next boot by
+ *              CLI "dfu --arm", or joystick center is held at reset. Otherwise boot goes straight
+ *              to application. Flag is kept in a RTC backup register, cleared as window opens.
+ */
+#define DFU_FAST_BOOT                   1           //!< [0]: Always open DFU window
+#define DFU_ARM_BKP_REG                 RTC_BKP_DR0
+#define DFU_ARM_MAGIC                   0x4D524144  //!< "DARM"
+
 //!< [1]: Force erase flash page.
 
 /*!@def DFU_WORK_BANK       Working Flash Bank, could select FLASH_BANK_1 FLASH_BANK_2 or both.
@@ -67,6 +95,18 @@ typedef struct Dfu_HexLineTypeDefine {
     uint32_t ByteCount;
 } Dfu_HexLineTypeDefine;
 
+/*!@struct Streaming decoder of Intel Hex records, fed byte by byte from input port.
+ *
+ */
+typedef struct Hex_DecoderTypeDef {
+    uint8_t  State;    //!< @ref HEX_STATE
+    uint8_t  Nibble;   //!< [1]: High nibble of current byte is received
+    uint8_t  Value;    //!< Current byte value
+    uint8_t  Sum;      //!< Running check sum of decoded bytes
+    uint16_t ByteIdx;  //!< Index of current byte in record
+    uint16_t ByteLen;  //!< Total record length in byte, 5 + Data Length
+} Hex_DecoderTypeDef;
+
 typedef enum DFU_RET {
     DFU_OK           = 0,   //!< General OK
     DFU_BUSY         = 1,   //!< DFU process is busy
@@ -79,8 +119,23 @@ typedef enum DFU_RET {
     DFU_ERROR        = -1   //!< General Error
 } DFU_RET;
 
+/*! Variables ---------------------------------------------------------------*/
+extern uint32_t Dfu_BootTime; //!< Tick from reset to first task, ms
+
 /*! Functions ---------------------------------------------------------------*/
-DFU_RET Bsp_Dfu_Init();
-DFU_RET Bsp_Dfu_Console();
+DFU_RET  Bsp_Dfu_Init();
+void     Dfu_arm(uint32_t arm);
+uint32_t Dfu_isArmed(void);
+DFU_RET  Bsp_Dfu_Console();
+DFU_RET  Dfu_processInput(void);
+DFU_RET  Dfu_pollConsole(void);
+void     Dfu_resetSession(void);
+void     dfu_io_init(void);
+void     dfu_io_deinit(void);
+int      dfu_flush(void);
+DFU_RET  Hex_ParseLine(char *string, int len, Dfu_HexLineTypeDefine *hexline);
+DFU_RET  Hex_ExcuteLine(Dfu_HexLineTypeDefine *hexline);
+void     Hex_DecoderInit(Hex_DecoderTypeDef *decoder);
+DFU_RET  Hex_DecodeByte(Hex_DecoderTypeDef *decoder, uint8_t c, Dfu_HexLineTypeDefine *hexline);
 
 #endif /* DFU_CONSOLE_H_ */
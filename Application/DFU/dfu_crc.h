@@ -0,0 +1,18 @@
+/******************************************************************************
+ * @file    dfu_crc.h
+ * @brief   CRC32 for DFU image and protocol frames.
+ *          No HAL dependency, shared with host tools.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef DFU_CRC_H_
+#define DFU_CRC_H_
+
+#include "stdint.h"
+
+uint32_t Dfu_crc32(uint32_t crc, const uint8_t *buf, uint32_t len);
+
+#endif /* DFU_CRC_H_ */
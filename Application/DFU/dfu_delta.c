@@ -0,0 +1,132 @@
+/******************************************************************************
+ * @file    dfu_delta.c
+ * @brief   Block level delta update, patch stream parser.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+/*! Includes ----------------------------------------------------------------*/
+#include "dfu_delta.h"
+
+/*! Functions ---------------------------------------------------------------*/
+/*!@brief Reset parser.
+ *
+ * @param delta     : Pointer to parser.
+ * @param max_size  : Maximum image size, a bank.
+ * @param page_size : Flash page size, unit of COPY.
+ * @param write     : Output write callback.
+ * @param copy      : Page copy callback, from active bank to output.
+ * @param ctx       : Context of callbacks.
+ */
+void Dfu_deltaInit(Dfu_DeltaTypeDef *delta, uint32_t max_size, uint32_t page_size,
+                   Dfu_DeltaWriteTypeDef write, Dfu_DeltaCopyTypeDef copy, void *ctx)
+{
+    delta->State     = DFU_DELTA_STATE_OP;
+    delta->Op        = 0;
+    delta->ArgIdx    = 0;
+    delta->Len       = 0;
+    delta->OutSize   = 0;
+    delta->MaxSize   = max_size;
+    delta->PageSize  = page_size;
+    delta->CopyPages = 0;
+    delta->DataBytes = 0;
+    delta->Write     = write;
+    delta->Copy      = copy;
+    delta->Ctx       = ctx;
+}
+
+/*!@brief Execute a record when its argument is complete.
+ */
+static DFU_RET Dfu_deltaRecord(Dfu_DeltaTypeDef *delta)
+{
+    if (delta->Op == DFU_DELTA_OP_DATA)
+    {
+        delta->Len = delta->Arg[0] | (delta->Arg[1] << 8) | (delta->Arg[2] << 16) |
+                     ((uint32_t)delta->Arg[3] << 24);
+        if (delta->Len > delta->MaxSize - delta->OutSize)
+        {
+            return DFU_FORMAT_ERR;
+        }
+        delta->State = (delta->Len > 0) ? DFU_DELTA_STATE_DATA : DFU_DELTA_STATE_OP;
+        return DFU_OK;
+    }
+
+    uint32_t src   = delta->Arg[0] | (delta->Arg[1] << 8);
+    uint32_t count = delta->Arg[2] | (delta->Arg[3] << 8);
+    uint32_t pages = delta->MaxSize / delta->PageSize;
+
+    if ((delta->OutSize % delta->PageSize != 0) || (src + count > pages) ||
+        (count > (delta->MaxSize - delta->OutSize) / delta->PageSize))
+    {
+        return DFU_FORMAT_ERR;
+    }
+    if (delta->Copy(delta->Ctx, src, delta->OutSize, count) != 0)
+    {
+        return DFU_FLASH_ERROR;
+    }
+
+    delta->OutSize += count * delta->PageSize;
+    delta->CopyPages += count;
+    delta->State = DFU_DELTA_STATE_OP;
+    return DFU_OK;
+}
+
+/*!@brief Decode a chunk of patch stream.
+ *
+ * @param delta     : Pointer to parser.
+ * @param buf       : Patch data.
+ * @param len       : Length of patch data.
+ * @return  DFU_OK          : Chunk is decoded, wait for next.
+ *          DFU_FORMAT_ERR  : Invalid record, or output exceeds max_size.
+ *          DFU_FLASH_ERROR : Output callback fails.
+ */
+DFU_RET Dfu_deltaDecode(Dfu_DeltaTypeDef *delta, const uint8_t *buf, uint32_t len)
+{
+    DFU_RET  ret = DFU_OK;
+    uint32_t i   = 0;
+
+    while ((i < len) && (ret == DFU_OK))
+    {
+        switch (delta->State)
+        {
+        case DFU_DELTA_STATE_OP:
+            delta->Op     = buf[i++];
+            delta->ArgIdx = 0;
+            delta->State  = DFU_DELTA_STATE_ARG;
+            if ((delta->Op != DFU_DELTA_OP_COPY) && (delta->Op != DFU_DELTA_OP_DATA))
+            {
+                ret = DFU_FORMAT_ERR;
+            }
+            break;
+        case DFU_DELTA_STATE_ARG:
+            delta->Arg[delta->ArgIdx++] = buf[i++];
+            if (delta->ArgIdx == sizeof(delta->Arg))
+            {
+                ret = Dfu_deltaRecord(delta);
+            }
+            break;
+        case DFU_DELTA_STATE_DATA:
+        {
+            uint32_t n = (delta->Len > len - i) ? len - i : delta->Len;
+            if (delta->Write(delta->Ctx, delta->OutSize, &buf[i], n) != 0)
+            {
+                ret = DFU_FLASH_ERROR;
+                break;
+            }
+            delta->OutSize += n;
+            delta->DataBytes += n;
+            delta->Len -= n;
+            i += n;
+            delta->State = (delta->Len == 0) ? DFU_DELTA_STATE_OP : DFU_DELTA_STATE_DATA;
+            break;
+        }
+        default:
+            ret = DFU_FORMAT_ERR;
+            break;
+        }
+    }
+
+    return ret;
+}
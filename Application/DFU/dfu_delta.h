@@ -0,0 +1,82 @@
+/******************************************************************************
+ * @file    dfu_delta.h
+ * @brief   Block level delta update, new image is rebuilt from pages of the
+ *          active bank plus changed pages sent by host.
+ *
+ *          Patch stream is a sequence of records, little endian:
+ *
+ *          | COPY | SrcPage(2) | Count(2) |     Count pages of active bank @ SrcPage
+ *          | DATA | Length(4)  | Bytes[Length] | New content
+ *
+ *          Output position of COPY must be page aligned, so DATA length is a multiple
+ *          of page size except in the last record.
+ *
+ *          Delta file, made by host tool dfu_pack against the active image:
+ *
+ *          | Magic | RawSize | RawCrc | BaseSize | BaseCrc | PatchSize | Patch[PatchSize] |
+ *          |   4   |    4    |   4    |    4     |    4    |     4     |                  |
+ *
+ *          No HAL dependency, shared with host tools.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef DFU_DELTA_H_
+#define DFU_DELTA_H_
+
+/*! Includes ----------------------------------------------------------------*/
+#include "dfu_console.h"
+#include "stdint.h"
+
+/*! Defines -----------------------------------------------------------------*/
+// clang-format off
+#define DFU_DELTA_MAGIC                 0x31444644  //!< "DFD1"
+#define DFU_DELTA_HEADER_SIZE           24          //!< Delta file header
+
+/*!@defgroup    DFU_DELTA_OP Define Group, patch record.
+ */
+#define DFU_DELTA_OP_COPY               0x01
+#define DFU_DELTA_OP_DATA               0x02
+
+/*!@defgroup    DFU_DELTA_STATE Define Group, parser state.
+ */
+#define DFU_DELTA_STATE_OP              0
+#define DFU_DELTA_STATE_ARG             1
+#define DFU_DELTA_STATE_DATA            2
+// clang-format on
+
+/*!@brief Output callbacks, return 0 on success.
+ *        pos is the offset in new image.
+ */
+typedef uint32_t (*Dfu_DeltaWriteTypeDef)(void *ctx, uint32_t pos, const uint8_t *buf,
+                                          uint32_t len);
+typedef uint32_t (*Dfu_DeltaCopyTypeDef)(void *ctx, uint32_t src_page, uint32_t pos,
+                                         uint32_t count);
+
+/*!@struct Dfu_DeltaTypeDef
+ *          Streaming patch parser.
+ */
+typedef struct Dfu_DeltaTypeDef {
+    uint8_t               State;     //!< @ref DFU_DELTA_STATE
+    uint8_t               Op;        //!< @ref DFU_DELTA_OP
+    uint8_t               ArgIdx;    //!< Received argument bytes
+    uint8_t               Arg[4];    //!< Record argument
+    uint32_t              Len;       //!< Remaining DATA bytes
+    uint32_t              OutSize;   //!< Output bytes so far
+    uint32_t              MaxSize;   //!< Output limit, also the size of a bank
+    uint32_t              PageSize;  //!< Flash page size
+    uint32_t              CopyPages; //!< Pages rebuilt from active bank
+    uint32_t              DataBytes; //!< Bytes sent by host
+    Dfu_DeltaWriteTypeDef Write;
+    Dfu_DeltaCopyTypeDef  Copy;
+    void                 *Ctx;
+} Dfu_DeltaTypeDef;
+
+/*! Functions ---------------------------------------------------------------*/
+void    Dfu_deltaInit(Dfu_DeltaTypeDef *delta, uint32_t max_size, uint32_t page_size,
+                      Dfu_DeltaWriteTypeDef write, Dfu_DeltaCopyTypeDef copy, void *ctx);
+DFU_RET Dfu_deltaDecode(Dfu_DeltaTypeDef *delta, const uint8_t *buf, uint32_t len);
+
+#endif /* DFU_DELTA_H_ */
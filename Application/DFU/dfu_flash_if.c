@@ -10,14 +10,21 @@
  *          - Dual Bank address / bank / page convert.
  *          - Flash bank/page usage check.
  *          - Flash bank/page erase/copy/compare.
+ *          - Flash content CRC32 with hardware CRC unit.
+ *          - Image manifest, so used pages are known without scanning the bank.
  *
  * @author  Nick Yang
  * @date    2018/08/12
  * @version V0.2
  *****************************************************************************/
+#include "inttypes.h"
+#include "stddef.h"
 #include "stdio.h"
+#include "string.h"
+#include "dfu_crc.h"
 #include "dfu_flash_if.h"
 #include "stm32l4xx_hal.h"
+#include "stm32l4xx_ll_crc.h"
 
 #define HWREG64(x) (*((volatile uint64_t *)((uint32_t)x)))
 #define HWREG32(x) (*((volatile uint32_t *)((uint32_t)x)))
@@ -90,8 +97,8 @@ uint32_t Flash_setActiveBank(uint32_t bank)
     }
     else
     {
-        printf("\e[31mERROR: Invalid Vector on Flash bank [%d]! EndStack=[0x%08lX], "
-               "ResetVector=[0x%08lX]\e[0m\n",
+        printf("\e[31mERROR: Invalid Vector on Flash bank [%d]! EndStack=[0x%08" PRIX32 "], "
+               "ResetVector=[0x%08" PRIX32 "]\e[0m\n",
                (uint8_t)bank, HWREG32(estack_addr), HWREG32(reset_addr));
         return -1;
     }
@@ -222,6 +229,7 @@ uint32_t Flash_checkPageUsage(uint32_t bank, uint8_t page)
 }
 
 /*!@brief   Check how many page in a Flash bank is used.
+ *          Pages of the image are counted from manifest when the bank has one.
  *
  * @param   bank    @def FLASH_BANK_1 or @def FLASH_BANK_2
  * @return          [0~255]Number of page used
@@ -231,13 +239,16 @@ uint32_t Flash_checkBankUsage(uint32_t bank)
     // Check Parameter
     assert_param(IS_FLASH_BANK_EXCLUSIVE(bank));
 
-    // Check all page in a Bank
-    uint32_t TotalPage = FLASH_BANK_SIZE / FLASH_PAGE_SIZE;
-    uint32_t UsedCount = 0;
+    const Flash_ManifestTypeDef *Manifest  = Flash_getManifest(bank);
+    uint32_t                     UsedCount = 0;
 
-    for (int i = 0; i < TotalPage; i++)
+    for (int i = 0; i < FLASH_BANK_PAGES; i++)
     {
-        if (Flash_checkPageUsage(bank, i) == 0) // Used page
+        if (Manifest != NULL)
+        {
+            UsedCount += (Manifest->Bitmap[i / 32] >> (i % 32)) & 1;
+        }
+        else if (Flash_checkPageUsage(bank, i) != 0) // Used page
         {
             UsedCount += 1;
         }
@@ -258,7 +269,7 @@ uint32_t Flash_erasePage(uint32_t bank, uint32_t start_page, uint32_t num_of_pag
     // Check Parameters
     assert_param(IS_FLASH_BANK_EXCLUSIVE(bank));
     assert_param(IS_FLASH_PAGE(start_page));
-    assert_param(IS_FLASH_PAGE(start_page + num_of_page));
+    assert_param(IS_FLASH_PAGE(start_page + num_of_page - 1));
 
     FLASH_EraseInitTypeDef erase_param = {0};
     HAL_StatusTypeDef      ret         = HAL_OK;
@@ -268,6 +279,7 @@ uint32_t Flash_erasePage(uint32_t bank, uint32_t start_page, uint32_t num_of_pag
     erase_param.Page                   = start_page;
     erase_param.NbPages                = num_of_page;
 
+    Flash_eraseCallback(bank, start_page, num_of_page);
     HAL_FLASH_Unlock();
     ret = HAL_FLASHEx_Erase(&erase_param, &page_error);
     HAL_FLASH_Lock();
@@ -275,13 +287,27 @@ uint32_t Flash_erasePage(uint32_t bank, uint32_t start_page, uint32_t num_of_pag
     if (ret != HAL_OK)
     {
         uint32_t usage = Flash_checkPageUsage(bank, start_page);
-        printf("Flash_erasePage, status = [%d], error_page = [%lX], usage = [%ld] \n", ret,
-               page_error, usage);
+        printf("Flash_erasePage, status = [%d], error_page = [%" PRIX32 "], usage = [%" PRIu32
+               "] \n",
+               ret, page_error, usage);
     }
 
     return ret;
 }
 
+/*!@brief Called before each page or mass erase, for wear statistic.
+ *
+ * @param bank          FLASH_BANK_1 or FLASH_BANK_2
+ * @param start_page    [0~255] First page to erase.
+ * @param num_of_page   [1~256] Number of Pages to erase.
+ */
+__weak void Flash_eraseCallback(uint32_t bank, uint32_t start_page, uint32_t num_of_page)
+{
+    UNUSED(bank);
+    UNUSED(start_page);
+    UNUSED(num_of_page);
+}
+
 /*!@brief Mass erase on an entire Flash bank
  *
  * @param bank  FLASH_BANK_1 or FLASH_BANK_2
@@ -302,11 +328,13 @@ uint32_t Flash_eraseBank(uint32_t bank)
     erase_param.NbPages                = 256;
 
     // Do Mass erase
+    Flash_eraseCallback(bank, 0, erase_param.NbPages);
     HAL_FLASH_Unlock();
     ret = HAL_FLASHEx_Erase(&erase_param, &page_error);
     HAL_FLASH_Lock();
 
-    printf("Flash_eraseBank [%ld], ret =[%d], page_error=[0x%lX]\n", bank, ret, page_error);
+    printf("Flash_eraseBank [%" PRIu32 "], ret =[%d], page_error=[0x%" PRIX32 "]\n", bank, ret,
+           page_error);
 
     return ret;
 }
@@ -345,6 +373,7 @@ uint32_t Flash_cmpPage(uint32_t SrcBank, uint32_t SrcPage, uint32_t DstBank, uin
 }
 
 /*!@brief Copy a flash page content and another.
+ *        Destination is erased only when it's not blank.
  *
  * @param SrcBank   FLASH_BANK_1 or FLASH_BANK_2, Source Flash bank
  * @param SrcPage   [0~255], Source Flash page
@@ -365,21 +394,28 @@ uint32_t Flash_copyPage(uint32_t SrcBank, uint32_t SrcPage, uint32_t DstBank, ui
     uint32_t DstAddr = Flash_getAddress(DstBank, DstPage);
     uint32_t Ret     = 0;
 
-    // Erase Destination Page
-    HAL_FLASH_Unlock();
-    Flash_erasePage(DstBank, DstPage, 1);
-    HAL_FLASH_Lock();
+    // Erase Destination Page, a blank page is not erased again.
+    if (Flash_checkPageUsage(DstBank, DstPage) != 0)
+    {
+        HAL_FLASH_Unlock();
+        Flash_erasePage(DstBank, DstPage, 1);
+        HAL_FLASH_Lock();
+    }
 
-    // Write Destination Page
+    // Write Destination Page, blank double words are skipped.
     HAL_FLASH_Unlock();
     for (int i = 0; i < FLASH_PAGE_SIZE; i = i + 8)
     {
         uint64_t data = HWREG64(SrcAddr + i);
-        Ret           = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, DstAddr + i, data);
+        if (data == 0xFFFFFFFFFFFFFFFF)
+        {
+            continue;
+        }
+        Ret = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, DstAddr + i, data);
 
         if (Ret != HAL_OK)
         {
-            printf("\e[31mERROR: Flash write fail @ [0x%lX]\n\e[0m", DstAddr + i);
+            printf("\e[31mERROR: Flash write fail @ [0x%" PRIX32 "]\n\e[0m", DstAddr + i);
             HAL_FLASH_Lock();
             return Ret;
         }
@@ -389,50 +425,718 @@ uint32_t Flash_copyPage(uint32_t SrcBank, uint32_t SrcPage, uint32_t DstBank, ui
     return Ret;
 }
 
+/*!@brief Count non-blank rows and double words of a flash page.
+ */
+static void Flash_scanPage(uint32_t addr, uint32_t *rows, uint32_t *dwords)
+{
+    for (uint32_t row = 0; row < FLASH_PAGE_SIZE; row = row + FLASH_ROW_SIZE)
+    {
+        uint32_t used = 0;
+        for (uint32_t i = 0; i < FLASH_ROW_SIZE; i = i + 8)
+        {
+            used += (HWREG64(addr + row + i) != 0xFFFFFFFFFFFFFFFF);
+        }
+        *rows += (used > 0);
+        *dwords += used;
+    }
+}
+
 /*!@brief Copy a bank to another.
+ *        Pages identical to destination are skipped. The rest is copied in the cheaper of 2x
+ *        modes, estimated with typical flash timing:
+ *        - Page: erase changed pages that are not blank, program double words.
+ *        - Mass: mass erase destination, program all used rows in fast mode.
+ *        Fast programming is only allowed after a mass erase, so it's not mixed with page mode.
+ *
+ *        When source bank has a manifest, only pages of the image and the manifest are copied,
+ *        and the image is verified against manifest CRC. Otherwise all pages are scanned and
+ *        verified one by one with hardware CRC.
  *
  * @param SrcBank   FLASH_BANK_1 or FLASH_BANK_2, Source bank
  * @param DstBank   FLASH_BANK_1 or FLASH_BANK_2, Destination bank
- * @return
+ * @return          HAL_OK, or HAL_ERROR when copy or verification fails.
  */
 uint32_t Flash_copyBank(uint32_t SrcBank, uint32_t DstBank)
 {
-    uint16_t page = 0;
-    for (page = 0; page < FLASH_BANK_SIZE / FLASH_PAGE_SIZE; page++)
+    const Flash_ManifestTypeDef *SrcManifest = Flash_getManifest(SrcBank);
+    const Flash_ManifestTypeDef *DstManifest = Flash_getManifest(DstBank);
+
+    uint32_t Map[FLASH_BANK_PAGES / 32];
+    uint32_t Tick   = HAL_GetTick();
+    uint32_t Skip   = 0;
+    uint32_t Copy   = 0;
+    uint32_t Erase  = 0;
+    uint32_t Rows   = 0;
+    uint32_t Dwords = 0;
+    uint32_t Ret    = HAL_OK;
+
+    // Pages to copy
+    for (int i = 0; i < FLASH_BANK_PAGES / 32; i++)
+    {
+        Map[i] = (SrcManifest != NULL) ? SrcManifest->Bitmap[i] : 0xFFFFFFFF;
+    }
+    Map[FLASH_MANIFEST_PAGE / 32] |= 1U << (FLASH_MANIFEST_PAGE % 32);
+
+    // Same manifest, destination holds the image already.
+    if ((SrcManifest != NULL) && (DstManifest != NULL) &&
+        (memcmp(SrcManifest, DstManifest, sizeof(Flash_ManifestTypeDef)) == 0) &&
+        (Flash_crc32(Flash_getAddress(DstBank, 0), DstManifest->Length) == DstManifest->Crc))
+    {
+        printf("Flash_copyBank [%" PRIu32 "]->[%" PRIu32 "], same image, [%" PRIu32 "] ms\n",
+               SrcBank, DstBank, HAL_GetTick() - Tick);
+        return HAL_OK;
+    }
+
+    // Find changed pages, and the cost of both modes.
+    for (uint32_t page = 0; page < FLASH_BANK_PAGES; page++)
     {
-        // Check if a flash page is used.
-        uint32_t PageUsage = Flash_checkPageUsage(SrcBank, page);
+        uint32_t Used = 0;
+
+        if (((Map[page / 32] >> (page % 32)) & 1) == 0)
+        {
+            continue;
+        }
+
+        Flash_scanPage(Flash_getAddress(SrcBank, page), &Rows, &Used);
 
-        if (PageUsage > 0)
+        if (Flash_cmpPage(SrcBank, page, DstBank, page) == 0)
         {
-            Flash_erasePage(DstBank, page, 1);
-            Flash_copyPage(SrcBank, page, DstBank, page);
+            Skip += (Used > 0);
+            Map[page / 32] &= ~(1U << (page % 32));
+            continue;
         }
+
+        Copy++;
+        Dwords += Used;
+        Erase += (Flash_checkPageUsage(DstBank, page) != 0);
     }
-    return HAL_OK;
+
+    uint32_t PageCost = Erase * FLASH_TIME_PAGE_ERASE + Dwords * FLASH_TIME_DWORD;
+    uint32_t MassCost = FLASH_TIME_MASS_ERASE + Rows * FLASH_TIME_ROW;
+    uint32_t MassMode = (Copy > 0) && (MassCost < PageCost);
+
+    if (MassMode)
+    {
+        // Skipped pages are programmed again after mass erase.
+        for (int i = 0; i < FLASH_BANK_PAGES / 32; i++)
+        {
+            Map[i] = (SrcManifest != NULL) ? SrcManifest->Bitmap[i] : 0xFFFFFFFF;
+        }
+        Map[FLASH_MANIFEST_PAGE / 32] |= 1U << (FLASH_MANIFEST_PAGE % 32);
+
+        Ret = Flash_eraseBank(DstBank);
+        HAL_FLASH_Unlock();
+        for (uint32_t page = 0; (page < FLASH_BANK_PAGES) && (Ret == HAL_OK); page++)
+        {
+            uint32_t SrcAddr = Flash_getAddress(SrcBank, page);
+            uint32_t DstAddr = Flash_getAddress(DstBank, page);
+
+            if (((Map[page / 32] >> (page % 32)) & 1) == 0)
+            {
+                continue;
+            }
+
+            for (uint32_t row = 0; (row < FLASH_PAGE_SIZE) && (Ret == HAL_OK);
+                 row           = row + FLASH_ROW_SIZE)
+            {
+                // Destination is blank, only used rows differ.
+                if (memcmp((uint8_t *)(SrcAddr + row), (uint8_t *)(DstAddr + row),
+                           FLASH_ROW_SIZE) != 0)
+                {
+                    // Source is read from the other bank while writing, no RAM copy.
+                    Ret = HAL_FLASH_Program(FLASH_TYPEPROGRAM_FAST_AND_LAST, DstAddr + row,
+                                            SrcAddr + row);
+                }
+            }
+        }
+        HAL_FLASH_Lock();
+    }
+    else
+    {
+        for (uint32_t page = 0; (page < FLASH_BANK_PAGES) && (Ret == HAL_OK); page++)
+        {
+            if ((Map[page / 32] >> (page % 32)) & 1)
+            {
+                Ret = Flash_copyPage(SrcBank, page, DstBank, page);
+            }
+        }
+    }
+
+    // Verify
+    if ((Ret == HAL_OK) && (SrcManifest != NULL))
+    {
+        DstManifest = Flash_getManifest(DstBank);
+        if ((DstManifest == NULL) ||
+            (memcmp(SrcManifest, DstManifest, sizeof(Flash_ManifestTypeDef)) != 0) ||
+            (Flash_crc32(Flash_getAddress(DstBank, 0), DstManifest->Length) != DstManifest->Crc))
+        {
+            printf("\e[31mERROR: Bank copy verify fail, image CRC\n\e[0m");
+            Ret = HAL_ERROR;
+        }
+    }
+    for (uint32_t page = 0; (page < FLASH_BANK_PAGES) && (Ret == HAL_OK) && (SrcManifest == NULL);
+         page++)
+    {
+        uint32_t SrcAddr = Flash_getAddress(SrcBank, page);
+        uint32_t DstAddr = Flash_getAddress(DstBank, page);
+        if (Flash_crc32(SrcAddr, FLASH_PAGE_SIZE) != Flash_crc32(DstAddr, FLASH_PAGE_SIZE))
+        {
+            printf("\e[31mERROR: Bank copy verify fail @ [0x%" PRIX32 "]\n\e[0m", DstAddr);
+            Ret = HAL_ERROR;
+        }
+    }
+
+    printf("Flash_copyBank [%" PRIu32 "]->[%" PRIu32 "], skip [%" PRIu32 "], copy [%" PRIu32
+           "], mode [%s], [%" PRIu32 "] ms, %s\n",
+           SrcBank, DstBank, Skip, Copy, MassMode ? "mass" : "page", HAL_GetTick() - Tick,
+           (Ret == HAL_OK) ? "verified" : "failed");
+
+    return Ret;
+}
+
+/*!@brief Calculate CRC32 of flash content with hardware CRC unit.
+ *        Same result as zlib crc32(), and Dfu_crc32() of DFU protocol.
+ *
+ * @param addr  Start address, 4 byte aligned.
+ * @param len   Number of bytes.
+ * @return      CRC32
+ */
+uint32_t Flash_crc32(uint32_t addr, uint32_t len)
+{
+    return Flash_crc32Update(0, addr, len);
+}
+
+#ifndef FLASH_CRC_SOFTWARE
+/*!@brief CRC32 of whole words by the CRC unit, from the CRC of previous chunks loaded as init
+ *        value, bit reversed as the unit keeps it. Words are reversed on input, so bytes are
+ *        processed in memory order. EEPROM emulation runs its CRC16 on the same unit from the
+ *        PVD interrupt, with the configuration set once by EE_Init(): interrupts are masked
+ *        while the unit is configured for CRC32, and INIT, POL and CR are restored after. The
+ *        partial CRC16 of a task switched out mid-blob is reloaded in DR through INIT, as its
+ *        output is not reversed.
+ *
+ * @param crc   CRC32 of previous chunks.
+ * @param addr  Start address, 4 byte aligned.
+ * @param len   Number of bytes, a multiple of 4, up to FLASH_CRC_SLICE.
+ * @return      CRC32 of all chunks so far.
+ */
+static uint32_t Flash_crc32Unit(uint32_t crc, uint32_t addr, uint32_t len)
+{
+    CRC_HandleTypeDef hcrc = {0};
+    uint32_t          init = ~crc;
+    uint32_t          primask;
+    uint32_t          save_init;
+    uint32_t          save_pol;
+    uint32_t          save_cr;
+    uint32_t          save_dr;
+
+    init = ((init >> 1) & 0x55555555) | ((init & 0x55555555) << 1);
+    init = ((init >> 2) & 0x33333333) | ((init & 0x33333333) << 2);
+    init = ((init >> 4) & 0x0F0F0F0F) | ((init & 0x0F0F0F0F) << 4);
+    init = __builtin_bswap32(init);
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    __HAL_RCC_CRC_CLK_ENABLE();
+    save_init = READ_REG(CRC->INIT);
+    save_pol  = READ_REG(CRC->POL);
+    save_cr   = READ_REG(CRC->CR) & ~CRC_CR_RESET;
+    save_dr   = READ_REG(CRC->DR);
+
+    hcrc.Instance                     = CRC;
+    hcrc.Init.DefaultPolynomialUse    = DEFAULT_POLYNOMIAL_ENABLE;
+    hcrc.Init.DefaultInitValueUse     = DEFAULT_INIT_VALUE_DISABLE;
+    hcrc.Init.InitValue               = init;
+    hcrc.Init.InputDataInversionMode  = CRC_INPUTDATA_INVERSION_WORD;
+    hcrc.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_ENABLE;
+    hcrc.InputDataFormat              = CRC_INPUTDATA_FORMAT_WORDS;
+    HAL_CRC_Init(&hcrc);
+
+    crc = HAL_CRC_Calculate(&hcrc, (uint32_t *)addr, len / 4);
+
+    WRITE_REG(CRC->POL, save_pol);
+    WRITE_REG(CRC->CR, save_cr);
+    WRITE_REG(CRC->INIT, save_dr);
+    LL_CRC_ResetCRCCalculationUnit(CRC);
+    WRITE_REG(CRC->INIT, save_init);
+    __set_PRIMASK(primask);
+
+    return ~crc;
+}
+#endif
+
+/*!@brief Continue CRC32 of flash content, could be called in chunks like Dfu_crc32().
+ *        Words go through the CRC unit by FLASH_CRC_SLICE, so that interrupts are not masked
+ *        long, bytes after the last full word are done in software.
+ *
+ * @param crc   CRC32 of previous chunks, 0 for the first chunk.
+ * @param addr  Start address, 4 byte aligned.
+ * @param len   Number of bytes.
+ * @return      CRC32 of all chunks so far.
+ */
+uint32_t Flash_crc32Update(uint32_t crc, uint32_t addr, uint32_t len)
+{
+#ifdef FLASH_CRC_SOFTWARE
+    return Dfu_crc32(crc, (const uint8_t *)addr, len);
+#else
+    uint32_t words = len & ~3;
+
+    for (uint32_t i = 0; i < words; i += FLASH_CRC_SLICE)
+    {
+        crc = Flash_crc32Unit(crc, addr + i,
+                              (words - i > FLASH_CRC_SLICE) ? FLASH_CRC_SLICE : words - i);
+    }
+
+    crc = ~crc;
+    for (uint32_t i = words; i < len; i++)
+    {
+        crc ^= HWREG8(addr + i);
+        for (int j = 0; j < 8; j++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+
+    return ~crc;
+#endif
+}
+
+/*!@brief Verify an image in a bank before it is activated.
+ *        The bank is read back once through CRC unit, the part covered by the running CRC of page
+ *        buffer must match what was handed over to programming, the image CRC is returned for a
+ *        check against the digest from host.
+ *
+ * @param pb        Page buffer the image is written through.
+ * @param bank      FLASH_BANK_1 or FLASH_BANK_2
+ * @param length    Image length in bytes, from bank start.
+ * @param crc       CRC32 of image in flash, output.
+ * @return          HAL_OK, or HAL_ERROR if flash content differs from the running CRC.
+ */
+uint32_t Flash_verifyImage(Flash_PageBufTypeDef *pb, uint32_t bank, uint32_t length, uint32_t *crc)
+{
+    uint32_t Tick   = HAL_GetTick();
+    uint32_t Addr   = Flash_getAddress(bank, 0);
+    uint32_t Stream = 0;
+    uint32_t Ret    = HAL_OK;
+
+    // Running CRC from bank start, covers the image in full pages when it is not interrupted.
+    if ((pb->CrcBase == Addr) && (pb->CrcAddr != FLASH_PAGEBUF_EMPTY))
+    {
+        Stream = pb->CrcAddr - Addr;
+    }
+
+    if (Stream <= length)
+    {
+        *crc = Flash_crc32(Addr, Stream);
+        Ret  = ((Stream > 0) && (*crc != pb->Crc)) ? HAL_ERROR : HAL_OK;
+        *crc = Flash_crc32Update(*crc, Addr + Stream, length - Stream);
+    }
+    else
+    {
+        *crc = Flash_crc32(Addr, length);
+        Ret  = (Flash_crc32Update(*crc, Addr + length, Stream - length) != pb->Crc) ? HAL_ERROR
+                                                                                   : HAL_OK;
+    }
+
+    printf("%s [%" PRIu32 "], [%" PRIu32 "] bytes, stream [%" PRIu32 "] bytes, crc [0x%08" PRIX32
+           "], [%" PRIu32 "] ms, %s\n",
+           __func__, bank, length, Stream, *crc, HAL_GetTick() - Tick,
+           (Ret == HAL_OK) ? "matched" : "failed");
+
+    return Ret;
+}
+
+/*!@brief Write image manifest to the last page of a bank.
+ *        Used pages are found by scanning the image only, once after DFU.
+ *
+ * @param bank      FLASH_BANK_1 or FLASH_BANK_2
+ * @param length    Image length in bytes, maximum FLASH_IMAGE_MAX_SIZE.
+ * @param crc       CRC32 of image, from Flash_verifyImage().
+ * @return          HAL_OK or error status.
+ */
+uint32_t Flash_writeManifest(uint32_t bank, uint32_t length, uint32_t crc)
+{
+    // Static, CRC unit reads it by 32-bit address on host build as well.
+    static Flash_ManifestTypeDef Manifest;
+
+    if (length > FLASH_IMAGE_MAX_SIZE)
+    {
+        return HAL_ERROR;
+    }
+
+    memset(&Manifest, 0, sizeof(Manifest));
+    Manifest.Magic  = FLASH_MANIFEST_MAGIC;
+    Manifest.Length = length;
+    Manifest.Crc    = crc;
+    for (uint32_t page = 0; page < (length + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE; page++)
+    {
+        if (Flash_checkPageUsage(bank, page) != 0)
+        {
+            Manifest.Bitmap[page / 32] |= 1U << (page % 32);
+        }
+    }
+    Manifest.Check = Flash_crc32((uint32_t)&Manifest, offsetof(Flash_ManifestTypeDef, Check));
+
+    // Manifest of an older image
+    if (Flash_checkPageUsage(bank, FLASH_MANIFEST_PAGE) != 0)
+    {
+        Flash_erasePage(bank, FLASH_MANIFEST_PAGE, 1);
+    }
+
+    return Flash_program_8bit(Flash_getAddress(bank, FLASH_MANIFEST_PAGE), (uint8_t *)&Manifest,
+                              sizeof(Manifest));
 }
 
+/*!@brief Get image manifest of a bank.
+ *
+ * @param bank  FLASH_BANK_1 or FLASH_BANK_2
+ * @return      Pointer to manifest in flash, NULL if the bank has no valid manifest.
+ */
+const Flash_ManifestTypeDef *Flash_getManifest(uint32_t bank)
+{
+    const Flash_ManifestTypeDef *Manifest =
+        (const Flash_ManifestTypeDef *)Flash_getAddress(bank, FLASH_MANIFEST_PAGE);
+
+    if ((Manifest->Magic != FLASH_MANIFEST_MAGIC) || (Manifest->Length > FLASH_IMAGE_MAX_SIZE) ||
+        (Flash_crc32((uint32_t)Manifest, offsetof(Flash_ManifestTypeDef, Check)) !=
+         Manifest->Check))
+    {
+        return NULL;
+    }
+
+    return Manifest;
+}
+
+/*!@brief Program a byte array to flash with double word programming.
+ *
+ * @param addr  Flash address to start, must be 8 byte aligned.
+ * @param pu8   Pointer to source bytes.
+ * @param len   Number of bytes, last double word is padded with 0xFF when not a multiple of 8.
+ * @return      HAL_OK or error status of the failed program operation.
+ */
 uint32_t Flash_program_8bit(uint32_t addr, uint8_t *pu8, uint32_t len)
 {
-    // b*Dfu_runHexLine
+    HAL_StatusTypeDef ret = HAL_OK;
+
     HAL_FLASH_Unlock();
 
-    for (int i = 0; i < len; i = i + 8)
+    for (uint32_t i = 0; (i < len) && (ret == HAL_OK); i = i + 8)
     {
-        // Convert 8x U8 to 1x U64
+        // Convert 8x U8 to 1x U64, bytes beyond len keep erased value.
         uint64_t temp = 0;
         for (int j = 7; j >= 0; j--)
         {
-            temp = (temp << 8) + pu8[i + j];
+            temp = (temp << 8) + ((i + j < len) ? pu8[i + j] : 0xFF);
         }
 
         // Write Flash
-        HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, addr + i, temp);
+        ret = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, addr + i, temp);
     }
 
     HAL_FLASH_Lock();
 
-    return 0;
+    return ret;
+}
+
+/*!@brief Initialize a flash page buffer.
+ *
+ * @param pb    Pointer to page buffer.
+ * @param fast  [1]: Target bank is mass erased, blank rows are committed in fast programming mode.
+ *              [0]: Only standard double word programming is used.
+ * @return      HAL_OK
+ */
+uint32_t Flash_pageBufInit(Flash_PageBufTypeDef *pb, uint32_t fast)
+{
+    pb->PageAddr   = FLASH_PAGEBUF_EMPTY;
+    pb->FillCount  = 0;
+    pb->Fill       = 0;
+    pb->PendAddr   = FLASH_PAGEBUF_EMPTY;
+    pb->PendRow    = 0;
+    pb->Status     = HAL_OK;
+    pb->FastMode   = fast;
+    pb->PageCount  = 0;
+    pb->RowCount   = 0;
+    pb->DwordCount = 0;
+    pb->EraseCount = 0;
+    pb->ErrorCount = 0;
+    pb->CrcAddr    = FLASH_PAGEBUF_EMPTY;
+    pb->CrcBase    = FLASH_PAGEBUF_EMPTY;
+    pb->Crc        = 0;
+    memset(pb->Data, 0xFF, sizeof(pb->Data));
+
+    return HAL_OK;
+}
+
+/*!@brief Start running CRC of committed pages.
+ *        Each page is added at the start of its commit, a page out of address order stops it.
+ *        A page is a block of 2 KB to CRC unit, ~50 us against ~15 ms to program it.
+ *
+ * @param pb    Pointer to page buffer, in 32-bit address space to be read by CRC unit.
+ * @param addr  Page aligned start address, e.g. bank start of an image.
+ * @return      HAL_OK
+ */
+uint32_t Flash_pageBufCrcStart(Flash_PageBufTypeDef *pb, uint32_t addr)
+{
+    pb->CrcAddr = addr;
+    pb->CrcBase = addr;
+    pb->Crc     = 0;
+
+    return HAL_OK;
+}
+
+/*!@brief Do a single step of pending page commit, erase or program a row.
+ *        Rows identical to flash are skipped. Blank rows are programmed in fast mode when allowed,
+ *        otherwise only changed double words are programmed. When a changed double word is not
+ *        blank, the page is erased first and fast mode is disabled, the bank is no longer mass
+ *        erased.
+ */
+static void Flash_pageBufStep(Flash_PageBufTypeDef *pb)
+{
+    uint8_t *Data   = pb->Data[pb->Fill ^ 1];
+    uint32_t Status = HAL_OK;
+
+    if (pb->PendRow == FLASH_PAGEBUF_CHECK)
+    {
+        pb->PendRow = 0;
+
+        if (pb->CrcAddr == pb->PendAddr)
+        {
+            pb->Crc = Flash_crc32Update(pb->Crc, (uint32_t)Data, FLASH_PAGE_SIZE);
+            pb->CrcAddr += FLASH_PAGE_SIZE;
+        }
+        else
+        {
+            pb->CrcAddr = FLASH_PAGEBUF_EMPTY;
+        }
+
+        for (int i = 0; i < FLASH_PAGE_SIZE; i = i + 8)
+        {
+            uint64_t data;
+            memcpy(&data, &Data[i], sizeof(data));
+            if ((data != HWREG64(pb->PendAddr + i)) &&
+                (HWREG64(pb->PendAddr + i) != 0xFFFFFFFFFFFFFFFF))
+            {
+                Status = Flash_erasePage(Flash_getBankNum(pb->PendAddr),
+                                         Flash_getPageNum(pb->PendAddr), 1);
+                pb->EraseCount++;
+                pb->FastMode = 0;
+                break;
+            }
+        }
+    }
+    else
+    {
+        uint32_t RowAddr = pb->PendAddr + pb->PendRow;
+        uint8_t *RowData = &Data[pb->PendRow];
+        uint32_t Blank   = 1;
+
+        for (int i = 0; i < FLASH_ROW_SIZE; i = i + 8)
+        {
+            if (HWREG64(RowAddr + i) != 0xFFFFFFFFFFFFFFFF)
+            {
+                Blank = 0;
+                break;
+            }
+        }
+
+        // Skip rows already in flash
+        if (memcmp(RowData, (uint8_t *)RowAddr, FLASH_ROW_SIZE) != 0)
+        {
+            HAL_FLASH_Unlock();
+            if (pb->FastMode && Blank)
+            {
+                // Program 32x double word in a single row operation.
+                Status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_FAST_AND_LAST, RowAddr,
+                                           (uint32_t)RowData);
+                pb->RowCount++;
+            }
+            else
+            {
+                // Program changed double words only.
+                for (int i = 0; (i < FLASH_ROW_SIZE) && (Status == HAL_OK); i = i + 8)
+                {
+                    uint64_t data;
+                    memcpy(&data, &RowData[i], sizeof(data));
+                    if (data != HWREG64(RowAddr + i))
+                    {
+                        Status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, RowAddr + i, data);
+                        pb->DwordCount++;
+                    }
+                }
+            }
+            HAL_FLASH_Lock();
+        }
+
+        if (Status != HAL_OK)
+        {
+            printf("\e[31mERROR: Flash write fail @ [0x%" PRIX32 "]\n\e[0m", RowAddr);
+            pb->ErrorCount++;
+        }
+
+        pb->PendRow += FLASH_ROW_SIZE;
+        if (pb->PendRow >= FLASH_PAGE_SIZE)
+        {
+            pb->PageCount++;
+            pb->PendAddr = FLASH_PAGEBUF_EMPTY;
+            memset(Data, 0xFF, FLASH_PAGE_SIZE);
+        }
+    }
+
+    if ((Status != HAL_OK) && (pb->Status == HAL_OK))
+    {
+        pb->Status = Status;
+    }
+}
+
+/*!@brief Commit pending page, then hand filled page over to commit.
+ */
+static void Flash_pageBufSwap(Flash_PageBufTypeDef *pb)
+{
+    while (pb->PendAddr != FLASH_PAGEBUF_EMPTY)
+    {
+        Flash_pageBufStep(pb);
+    }
+
+    if (pb->PageAddr != FLASH_PAGEBUF_EMPTY)
+    {
+        pb->PendAddr  = pb->PageAddr;
+        pb->PendRow   = FLASH_PAGEBUF_CHECK;
+        pb->Fill      = pb->Fill ^ 1;
+        pb->PageAddr  = FLASH_PAGEBUF_EMPTY;
+        pb->FillCount = 0;
+    }
+}
+
+/*!@brief Report and clear the first error of page commits.
+ */
+static uint32_t Flash_pageBufStatus(Flash_PageBufTypeDef *pb)
+{
+    uint32_t ret = pb->Status;
+    pb->Status   = HAL_OK;
+    return ret;
+}
+
+/*!@brief Write bytes to flash through page buffer.
+ *        Bytes are merged into the filling page. When a write moves to another page, the filled
+ *        page is handed over to commit, which goes on in Flash_pageBufPoll() while the next page
+ *        fills. Call Flash_pageBufFlush() to commit all.
+ *
+ * @param pb    Pointer to page buffer.
+ * @param addr  Flash address, no alignment required.
+ * @param ptr   Pointer to source bytes.
+ * @param len   Number of bytes.
+ * @return      HAL_OK or error status of a page commit since last call.
+ */
+uint32_t Flash_pageBufWrite(Flash_PageBufTypeDef *pb, uint32_t addr, uint8_t *ptr, uint32_t len)
+{
+    while (len > 0)
+    {
+        uint32_t PageAddr = addr - (addr - FLASH_BASE) % FLASH_PAGE_SIZE;
+        uint32_t Offset   = addr - PageAddr;
+        uint32_t Count    = (len < FLASH_PAGE_SIZE - Offset) ? len : FLASH_PAGE_SIZE - Offset;
+
+        // Moving to another page, load current content of the new page.
+        if (pb->PageAddr != PageAddr)
+        {
+            Flash_pageBufSwap(pb);
+            if (pb->PendAddr == PageAddr)
+            {
+                Flash_pageBufSwap(pb);
+            }
+            pb->PageAddr = PageAddr;
+            memcpy(pb->Data[pb->Fill], (uint8_t *)PageAddr, FLASH_PAGE_SIZE);
+        }
+
+        memcpy(&pb->Data[pb->Fill][Offset], ptr, Count);
+        pb->FillCount += Count;
+        addr += Count;
+        ptr += Count;
+        len -= Count;
+    }
+
+    return Flash_pageBufStatus(pb);
+}
+
+/*!@brief Read bytes as they will be in flash, buffered page content included.
+ *
+ * @param pb    Pointer to page buffer.
+ * @param addr  Flash address, no alignment required.
+ * @param ptr   Pointer to destination bytes.
+ * @param len   Number of bytes.
+ * @return      HAL_OK
+ */
+uint32_t Flash_pageBufRead(Flash_PageBufTypeDef *pb, uint32_t addr, uint8_t *ptr, uint32_t len)
+{
+    while (len > 0)
+    {
+        uint32_t PageAddr = addr - (addr - FLASH_BASE) % FLASH_PAGE_SIZE;
+        uint32_t Offset   = addr - PageAddr;
+        uint32_t Count    = (len < FLASH_PAGE_SIZE - Offset) ? len : FLASH_PAGE_SIZE - Offset;
+        uint8_t *Src      = (uint8_t *)addr;
+
+        if (pb->PageAddr == PageAddr)
+        {
+            Src = &pb->Data[pb->Fill][Offset];
+        }
+        else if (pb->PendAddr == PageAddr)
+        {
+            Src = &pb->Data[pb->Fill ^ 1][Offset];
+        }
+
+        memcpy(ptr, Src, Count);
+        addr += Count;
+        ptr += Count;
+        len -= Count;
+    }
+
+    return HAL_OK;
+}
+
+/*!@brief Go on with page commit in background of data reception, call it in idle loop.
+ *        A single erase or row is done in a call, so input is served at least every
+ *        FLASH_TIME_PAGE_ERASE. A completely filled page is handed over to commit without
+ *        waiting for the next write.
+ *
+ * @param pb    Pointer to page buffer.
+ * @return      [1]: Commit is pending, [0]: Idle.
+ */
+uint32_t Flash_pageBufPoll(Flash_PageBufTypeDef *pb)
+{
+    if ((pb->PendAddr == FLASH_PAGEBUF_EMPTY) && (pb->FillCount >= FLASH_PAGE_SIZE))
+    {
+        Flash_pageBufSwap(pb);
+    }
+
+    if (pb->PendAddr != FLASH_PAGEBUF_EMPTY)
+    {
+        Flash_pageBufStep(pb);
+    }
+
+    return (pb->PendAddr != FLASH_PAGEBUF_EMPTY);
+}
+
+/*!@brief Check if page buffer can't take more data without waiting for a commit.
+ *        Filling page is complete and the other one is still being committed.
+ *
+ * @param pb    Pointer to page buffer.
+ * @return      [1]: Busy, [0]: Ready.
+ */
+uint32_t Flash_pageBufBusy(Flash_PageBufTypeDef *pb)
+{
+    return (pb->PendAddr != FLASH_PAGEBUF_EMPTY) && (pb->FillCount >= FLASH_PAGE_SIZE);
+}
+
+/*!@brief Commit both buffered pages to flash and empty the buffer.
+ *
+ * @param pb    Pointer to page buffer.
+ * @return      HAL_OK or error status of a page commit since last call.
+ */
+uint32_t Flash_pageBufFlush(Flash_PageBufTypeDef *pb)
+{
+    Flash_pageBufSwap(pb);
+    Flash_pageBufSwap(pb);
+
+    return Flash_pageBufStatus(pb);
 }
 
 uint32_t Flash_Otp_write(uint16_t idx, uint64_t value)
@@ -40,21 +40,103 @@
 #define FLASH_OTP_ADDR                  0x1FFF7000
 #define FLASH_OTP_DATABYTE              8
 #define FLASH_OTP_SIZE                  1024
+
+#define FLASH_ROW_SIZE                  256         //!< Fast programming row, 32x double word
+#define FLASH_BANK_PAGES                256         //!< Pages in a bank
+
+/*!@defgroup FLASH_MANIFEST Image manifest, in the last page of a bank.
+ *            The image itself can use the rest of the bank.
+ */
+#define FLASH_MANIFEST_MAGIC            0x31464E4D  //!< "MNF1"
+#define FLASH_MANIFEST_PAGE             (FLASH_BANK_PAGES - 1)
+#define FLASH_IMAGE_MAX_SIZE            (FLASH_BANK_SIZE - FLASH_PAGE_SIZE)
+#define FLASH_PAGEBUF_EMPTY             0xFFFFFFFF  //!< Page buffer holds no page
+#define FLASH_PAGEBUF_CHECK             0xFFFFFFFF  //!< Commit starts with erase check
+
+/*!@defgroup FLASH_TIME Typical flash operation time in us, <DS10198> table 50.
+ *            Used to choose the cheaper way of a bank copy.
+ */
+#define FLASH_TIME_DWORD                82          //!< Program 1x double word, standard mode
+#define FLASH_TIME_ROW                  1910        //!< Program 1x row, fast mode
+#define FLASH_TIME_PAGE_ERASE           22020       //!< Erase 1x page
+#define FLASH_TIME_MASS_ERASE           22130       //!< Mass erase 1x bank
+
+/*!@defgroup FLASH_CRC CRC32 of flash content is calculated by CRC unit when HAL_CRC module is
+ *            enabled. Define FLASH_CRC_SOFTWARE to use Dfu_crc32() instead, e.g. host build
+ *            without CRC unit simulation.
+ */
+#if !defined(HAL_CRC_MODULE_ENABLED) && !defined(FLASH_CRC_SOFTWARE)
+#define FLASH_CRC_SOFTWARE
+#endif
+#define FLASH_CRC_SLICE                 1024        //!< Bytes per CRC unit run, interrupts masked
 // clang-format on
 
+/*!@struct Flash_PageBufTypeDef
+ *          Double buffered write-combining of flash pages.
+ *          Scattered writes are assembled in RAM and committed to flash one page at a time, rows
+ *          that are blank in flash are programmed with fast (row) programming when allowed.
+ *          A page is erased before commit only when a changed double word is not blank.
+ *          A page is committed row by row by Flash_pageBufPoll(), while the other one fills.
+ *          Pages committed in address order are added to a running CRC as they are programmed,
+ *          to be checked against flash content by Flash_verifyImage().
+ */
+typedef struct Flash_PageBufTypeDef {
+    uint32_t PageAddr;                 //!< Address of filling page, FLASH_PAGEBUF_EMPTY if none
+    uint32_t FillCount;                //!< Bytes written to filling page
+    uint32_t Fill;                     //!< Index of filling page in Data, the other is committed
+    uint32_t PendAddr;                 //!< Address of page in commit, FLASH_PAGEBUF_EMPTY if none
+    uint32_t PendRow;                  //!< Next row to commit, FLASH_PAGEBUF_CHECK to check erase
+    uint32_t Status;                   //!< First error of commit, reported by next write or flush
+    uint32_t FastMode;                 //!< [1]: Bank is mass erased, fast programming allowed
+    uint32_t PageCount;                //!< Number of pages committed
+    uint32_t RowCount;                 //!< Number of rows programmed in fast mode
+    uint32_t DwordCount;               //!< Number of double words programmed in standard mode
+    uint32_t EraseCount;               //!< Number of pages erased before commit
+    uint32_t ErrorCount;               //!< Number of failed program operations
+    uint32_t CrcAddr;                  //!< Next page of running CRC, FLASH_PAGEBUF_EMPTY if off
+    uint32_t CrcBase;                  //!< Start address of running CRC
+    uint32_t Crc;                      //!< Running CRC32 of pages committed from CrcBase
+    uint8_t  Data[2][FLASH_PAGE_SIZE]; //!< Page content
+} Flash_PageBufTypeDef;
+
+/*!@struct Flash_ManifestTypeDef
+ *          Written by DFU after an image is complete, so boot, copy and verify know the image
+ *          without scanning the bank. Copied with the image by Flash_copyBank().
+ */
+typedef struct Flash_ManifestTypeDef {
+    uint32_t Magic;                         //!< FLASH_MANIFEST_MAGIC
+    uint32_t Length;                        //!< Image length in bytes, from bank start
+    uint32_t Crc;                           //!< CRC32 of image
+    uint32_t Bitmap[FLASH_BANK_PAGES / 32]; //!< [1]: Page n is used, bit n % 32 of word n / 32
+    uint32_t Check;                         //!< CRC32 of manifest fields above
+} Flash_ManifestTypeDef;
+
 uint32_t Flash_setActiveBank(uint32_t flashbank);
 uint32_t Flash_getActiveBank();
-uint32_t Flash_getPage(uint32_t address);
-uint32_t Flash_getBank(uint32_t address);
+uint32_t Flash_getPageNum(uint32_t address);
+uint32_t Flash_getBankNum(uint32_t address);
 uint32_t Flash_getAddress(uint32_t bank, uint32_t page);
 uint32_t Flash_checkBankUsage(uint32_t bank);
 uint32_t Flash_checkPageUsage(uint32_t bank, uint8_t page);
 uint32_t Flash_erasePage(uint32_t bank, uint32_t start_page, uint32_t num_of_page);
 uint32_t Flash_eraseBank(uint32_t bank);
+void     Flash_eraseCallback(uint32_t bank, uint32_t start_page, uint32_t num_of_page);
 uint32_t Flash_cmpPage(uint32_t SrcBank, uint32_t SrcPage, uint32_t DstBank, uint32_t DstPage);
 uint32_t Flash_copyPage(uint32_t SrcBank, uint32_t SrcPage, uint32_t DstBank, uint32_t DstPage);
 uint32_t Flash_copyBank(uint32_t SrcBank, uint32_t DstBank);
+uint32_t Flash_crc32(uint32_t addr, uint32_t len);
+uint32_t Flash_crc32Update(uint32_t crc, uint32_t addr, uint32_t len);
+uint32_t Flash_verifyImage(Flash_PageBufTypeDef *pb, uint32_t bank, uint32_t length, uint32_t *crc);
+uint32_t Flash_writeManifest(uint32_t bank, uint32_t length, uint32_t crc);
+const Flash_ManifestTypeDef *Flash_getManifest(uint32_t bank);
 uint32_t Flash_program_8bit(uint32_t addr, uint8_t *ptr, uint32_t len);
+uint32_t Flash_pageBufInit(Flash_PageBufTypeDef *pb, uint32_t fast);
+uint32_t Flash_pageBufCrcStart(Flash_PageBufTypeDef *pb, uint32_t addr);
+uint32_t Flash_pageBufWrite(Flash_PageBufTypeDef *pb, uint32_t addr, uint8_t *ptr, uint32_t len);
+uint32_t Flash_pageBufFlush(Flash_PageBufTypeDef *pb);
+uint32_t Flash_pageBufRead(Flash_PageBufTypeDef *pb, uint32_t addr, uint8_t *ptr, uint32_t len);
+uint32_t Flash_pageBufPoll(Flash_PageBufTypeDef *pb);
+uint32_t Flash_pageBufBusy(Flash_PageBufTypeDef *pb);
 uint32_t Flash_Otp_write(uint16_t idx, uint64_t value);
 uint32_t Flash_Otp_read(uint16_t idx, uint64_t *value);
 
@@ -0,0 +1,167 @@
+/******************************************************************************
+ * @file    dfu_lz.c
+ * @brief   Streaming decompression of DFU images, LZ4 block format.
+ *
+ *          LZ4 sequence:
+ *          | Token | [LitLen+] | Literals | Offset(2) | [MatchLen+] |
+ *          Token high nibble is literal length, low nibble is match length - 4,
+ *          nibble 15 is followed by extra length bytes until a byte != 255.
+ *          Last sequence has literals only.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+/*! Includes ----------------------------------------------------------------*/
+#include "dfu_lz.h"
+
+/*! Functions ---------------------------------------------------------------*/
+/*!@brief Reset decoder.
+ *
+ * @param lz        : Pointer to decoder.
+ * @param max_size  : Maximum decompressed size, larger image is rejected.
+ * @param write     : Output write callback.
+ * @param read      : Output read back callback, for match history.
+ * @param ctx       : Context of callbacks.
+ */
+void Dfu_lzInit(Dfu_LzTypeDef *lz, uint32_t max_size, Dfu_LzWriteTypeDef write,
+                Dfu_LzReadTypeDef read, void *ctx)
+{
+    lz->State    = DFU_LZ_STATE_TOKEN;
+    lz->MatchLen = 0;
+    lz->Offset   = 0;
+    lz->Len      = 0;
+    lz->OutSize  = 0;
+    lz->MaxSize  = max_size;
+    lz->Write    = write;
+    lz->Read     = read;
+    lz->Ctx      = ctx;
+}
+
+/*!@brief Copy a match from history, in chunks of DFU_LZ_COPY_SIZE.
+ *        Overlapped match (Offset < Len) repeats with period of Offset.
+ */
+static DFU_RET Dfu_lzCopy(Dfu_LzTypeDef *lz)
+{
+    uint8_t buf[DFU_LZ_COPY_SIZE];
+
+    if ((lz->Offset == 0) || (lz->Offset > lz->OutSize) || (lz->Len > lz->MaxSize - lz->OutSize))
+    {
+        return DFU_FORMAT_ERR;
+    }
+
+    while (lz->Len > 0)
+    {
+        uint32_t n = (lz->Len > DFU_LZ_COPY_SIZE) ? DFU_LZ_COPY_SIZE : lz->Len;
+        uint32_t m = (n > lz->Offset) ? lz->Offset : n;
+
+        if (lz->Read(lz->Ctx, lz->OutSize - lz->Offset, buf, m) != 0)
+        {
+            return DFU_FLASH_ERROR;
+        }
+        for (uint32_t i = m; i < n; i++)
+        {
+            buf[i] = buf[i - m];
+        }
+        if (lz->Write(lz->Ctx, lz->OutSize, buf, n) != 0)
+        {
+            return DFU_FLASH_ERROR;
+        }
+
+        lz->OutSize += n;
+        lz->Len -= n;
+    }
+
+    return DFU_OK;
+}
+
+/*!@brief Decode a chunk of compressed stream.
+ *
+ * @param lz        : Pointer to decoder.
+ * @param buf       : Compressed data.
+ * @param len       : Length of compressed data.
+ * @return  DFU_OK          : Chunk is decoded, wait for next.
+ *          DFU_FORMAT_ERR  : Invalid stream, or output exceeds max_size.
+ *          DFU_FLASH_ERROR : Output callback fails.
+ */
+DFU_RET Dfu_lzDecode(Dfu_LzTypeDef *lz, const uint8_t *buf, uint32_t len)
+{
+    DFU_RET  ret = DFU_OK;
+    uint32_t i   = 0;
+
+    while ((i < len) && (ret == DFU_OK))
+    {
+        uint8_t c = buf[i];
+
+        switch (lz->State)
+        {
+        case DFU_LZ_STATE_TOKEN:
+            lz->Len      = c >> 4;
+            lz->MatchLen = c & 0x0F;
+            lz->State    = (lz->Len == 15)  ? DFU_LZ_STATE_LITLEN
+                           : (lz->Len > 0) ? DFU_LZ_STATE_LITERAL
+                                           : DFU_LZ_STATE_OFFSET0;
+            i++;
+            break;
+        case DFU_LZ_STATE_LITLEN:
+            lz->Len += c;
+            lz->State = (c != 255) ? DFU_LZ_STATE_LITERAL : DFU_LZ_STATE_LITLEN;
+            i++;
+            break;
+        case DFU_LZ_STATE_LITERAL:
+        {
+            // Literals go to output straight from input.
+            uint32_t n = (lz->Len > len - i) ? len - i : lz->Len;
+            if (n > lz->MaxSize - lz->OutSize)
+            {
+                ret = DFU_FORMAT_ERR;
+                break;
+            }
+            if (lz->Write(lz->Ctx, lz->OutSize, &buf[i], n) != 0)
+            {
+                ret = DFU_FLASH_ERROR;
+                break;
+            }
+            lz->OutSize += n;
+            lz->Len -= n;
+            i += n;
+            lz->State = (lz->Len == 0) ? DFU_LZ_STATE_OFFSET0 : DFU_LZ_STATE_LITERAL;
+            break;
+        }
+        case DFU_LZ_STATE_OFFSET0:
+            lz->Offset = c;
+            lz->State  = DFU_LZ_STATE_OFFSET1;
+            i++;
+            break;
+        case DFU_LZ_STATE_OFFSET1:
+            lz->Offset |= c << 8;
+            lz->Len = lz->MatchLen + DFU_LZ_MIN_MATCH;
+            i++;
+            if (lz->MatchLen == 15)
+            {
+                lz->State = DFU_LZ_STATE_MATCHLEN;
+            }
+            else
+            {
+                ret       = Dfu_lzCopy(lz);
+                lz->State = DFU_LZ_STATE_TOKEN;
+            }
+            break;
+        case DFU_LZ_STATE_MATCHLEN:
+            lz->Len += c;
+            i++;
+            if (c != 255)
+            {
+                ret       = Dfu_lzCopy(lz);
+                lz->State = DFU_LZ_STATE_TOKEN;
+            }
+            break;
+        default:
+            ret = DFU_FORMAT_ERR;
+            break;
+        }
+    }
+
+    return ret;
+}
@@ -0,0 +1,73 @@
+/******************************************************************************
+ * @file    dfu_lz.h
+ * @brief   Streaming decompression of DFU images, LZ4 block format.
+ *
+ *          Compressed data is fed in chunks of any size. Literals are written to
+ *          output as they arrive, match history is read back from output, so the
+ *          decoder itself has no window buffer. On device, output is the page
+ *          buffer of the DFU bank, and history is the already written flash.
+ *
+ *          Packed image file, made by host tool dfu_pack, little endian:
+ *
+ *          | Magic | RawSize | RawCrc | PackSize | LZ4 block[PackSize] |
+ *          |   4   |    4    |   4    |    4     |                     |
+ *
+ *          No HAL dependency, shared with host tools.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef DFU_LZ_H_
+#define DFU_LZ_H_
+
+/*! Includes ----------------------------------------------------------------*/
+#include "dfu_console.h"
+#include "stdint.h"
+
+/*! Defines -----------------------------------------------------------------*/
+// clang-format off
+#define DFU_LZ_MAGIC                    0x315A4644  //!< "DFZ1"
+#define DFU_LZ_HEADER_SIZE              16          //!< Packed image file header
+#define DFU_LZ_MIN_MATCH                4           //!< LZ4 minimum match length
+#define DFU_LZ_MAX_OFFSET               65535       //!< LZ4 maximum match offset
+#define DFU_LZ_COPY_SIZE                64          //!< Match is copied in chunks, stack usage
+
+/*!@defgroup    DFU_LZ_STATE Define Group, decoder state.
+ */
+#define DFU_LZ_STATE_TOKEN              0
+#define DFU_LZ_STATE_LITLEN             1
+#define DFU_LZ_STATE_LITERAL            2
+#define DFU_LZ_STATE_OFFSET0            3
+#define DFU_LZ_STATE_OFFSET1            4
+#define DFU_LZ_STATE_MATCHLEN           5
+// clang-format on
+
+/*!@brief Output callbacks, return 0 on success.
+ *        pos is the offset in decompressed image.
+ */
+typedef uint32_t (*Dfu_LzWriteTypeDef)(void *ctx, uint32_t pos, const uint8_t *buf, uint32_t len);
+typedef uint32_t (*Dfu_LzReadTypeDef)(void *ctx, uint32_t pos, uint8_t *buf, uint32_t len);
+
+/*!@struct Dfu_LzTypeDef
+ *          Streaming decoder.
+ */
+typedef struct Dfu_LzTypeDef {
+    uint8_t            State;    //!< @ref DFU_LZ_STATE
+    uint8_t            MatchLen; //!< Match length in token
+    uint16_t           Offset;   //!< Match offset
+    uint32_t           Len;      //!< Remaining literal or match length
+    uint32_t           OutSize;  //!< Decompressed bytes so far
+    uint32_t           MaxSize;  //!< Output limit
+    Dfu_LzWriteTypeDef Write;
+    Dfu_LzReadTypeDef  Read;
+    void              *Ctx;
+} Dfu_LzTypeDef;
+
+/*! Functions ---------------------------------------------------------------*/
+void    Dfu_lzInit(Dfu_LzTypeDef *lz, uint32_t max_size, Dfu_LzWriteTypeDef write,
+                   Dfu_LzReadTypeDef read, void *ctx);
+DFU_RET Dfu_lzDecode(Dfu_LzTypeDef *lz, const uint8_t *buf, uint32_t len);
+
+#endif /* DFU_LZ_H_ */
@@ -0,0 +1,151 @@
+/******************************************************************************
+ * @file    dfu_proto.c
+ * @brief   Binary DFU transfer protocol, frame pack & decode.
+ *          No HAL dependency, shared by device console and host uploader.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+/*! Includes ----------------------------------------------------------------*/
+#include "string.h"
+
+#include "dfu_crc.h"
+#include "dfu_proto.h"
+
+/*! Functions ---------------------------------------------------------------*/
+static void put_u16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = value & 0xFF;
+    buf[1] = value >> 8;
+}
+
+static void put_u32(uint8_t *buf, uint32_t value)
+{
+    put_u16(&buf[0], value & 0xFFFF);
+    put_u16(&buf[2], value >> 16);
+}
+
+static uint32_t get_u32(const uint8_t *buf)
+{
+    return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+/*!@brief Reset frame decoder and session.
+ *
+ * @param proto     : Pointer to protocol structure.
+ */
+void Dfu_protoInit(Dfu_ProtoTypeDef *proto)
+{
+    memset(proto, 0, sizeof(Dfu_ProtoTypeDef));
+    proto->State     = DFU_PROTO_STATE_SOF;
+    proto->NakOffset = 0xFFFFFFFF;
+}
+
+/*!@brief Pack a frame to buffer.
+ *
+ * @param buf       : Output buffer, at least DFU_PROTO_MAX_FRAME bytes.
+ * @param cmd       : @ref DFU_PROTO_CMD
+ * @param offset    : Image offset.
+ * @param payload   : Pointer to payload, could be NULL when len is 0.
+ * @param len       : Payload length, [0~DFU_PROTO_MAX_PAYLOAD].
+ * @return          Frame length in byte.
+ */
+uint16_t Dfu_protoPack(uint8_t *buf, uint8_t cmd, uint32_t offset, const uint8_t *payload,
+                       uint16_t len)
+{
+    buf[0] = DFU_PROTO_SOF;
+    buf[1] = cmd;
+    put_u16(&buf[2], len);
+    put_u32(&buf[4], offset);
+    if (len > 0)
+    {
+        memcpy(&buf[DFU_PROTO_HEADER_SIZE], payload, len);
+    }
+
+    uint32_t crc = Dfu_crc32(0, &buf[1], DFU_PROTO_HEADER_SIZE - 1 + len);
+    put_u32(&buf[DFU_PROTO_HEADER_SIZE + len], crc);
+
+    return DFU_PROTO_HEADER_SIZE + len + DFU_PROTO_CRC_SIZE;
+}
+
+/*!@brief Decode frame byte by byte.
+ *        A partial frame is dropped when no byte is received for DFU_PROTO_BYTE_TIMEOUT.
+ *
+ * @param proto     : Pointer to protocol structure.
+ * @param c         : Input byte.
+ * @param tick      : Current time in ms.
+ * @return  DFU_OK          : A valid frame is decoded to proto->Frame.
+ *          DFU_BUSY        : Frame is in progress, or waiting for SOF.
+ *          DFU_LENGTH_ERR  : Payload too long, decoder is reset.
+ *          DFU_CHECKSUM_ERR: CRC32 error, decoder is reset.
+ */
+DFU_RET Dfu_protoDecodeByte(Dfu_ProtoTypeDef *proto, uint8_t c, uint32_t tick)
+{
+    if ((proto->State != DFU_PROTO_STATE_SOF) &&
+        (tick - proto->LastTick > DFU_PROTO_BYTE_TIMEOUT))
+    {
+        proto->State = DFU_PROTO_STATE_SOF;
+    }
+    proto->LastTick = tick;
+
+    switch (proto->State)
+    {
+    case DFU_PROTO_STATE_SOF:
+        if (c == DFU_PROTO_SOF)
+        {
+            proto->Header[0] = c;
+            proto->Idx       = 1;
+            proto->State     = DFU_PROTO_STATE_HEADER;
+        }
+        break;
+    case DFU_PROTO_STATE_HEADER:
+        proto->Header[proto->Idx++] = c;
+        if (proto->Idx == DFU_PROTO_HEADER_SIZE)
+        {
+            proto->Frame.Cmd    = proto->Header[1];
+            proto->Frame.Length = proto->Header[2] | (proto->Header[3] << 8);
+            proto->Frame.Offset = get_u32(&proto->Header[4]);
+            proto->Idx          = 0;
+
+            if (proto->Frame.Length > DFU_PROTO_MAX_PAYLOAD)
+            {
+                proto->State = DFU_PROTO_STATE_SOF;
+                return DFU_LENGTH_ERR;
+            }
+            proto->State = (proto->Frame.Length > 0) ? DFU_PROTO_STATE_PAYLOAD : DFU_PROTO_STATE_CRC;
+        }
+        break;
+    case DFU_PROTO_STATE_PAYLOAD:
+        proto->Frame.Payload[proto->Idx++] = c;
+        if (proto->Idx == proto->Frame.Length)
+        {
+            proto->Idx   = 0;
+            proto->State = DFU_PROTO_STATE_CRC;
+        }
+        break;
+    case DFU_PROTO_STATE_CRC:
+        proto->Crc = (proto->Idx == 0) ? c : proto->Crc | ((uint32_t)c << (8 * proto->Idx));
+        if (++proto->Idx == DFU_PROTO_CRC_SIZE)
+        {
+            uint32_t crc = Dfu_crc32(0, &proto->Header[1], DFU_PROTO_HEADER_SIZE - 1);
+            crc          = Dfu_crc32(crc, proto->Frame.Payload, proto->Frame.Length);
+            proto->State = DFU_PROTO_STATE_SOF;
+
+            if (crc != proto->Crc)
+            {
+                proto->CrcErrorCount++;
+                return DFU_CHECKSUM_ERR;
+            }
+            proto->FrameCount++;
+            return DFU_OK;
+        }
+        break;
+    default:
+        proto->State = DFU_PROTO_STATE_SOF;
+        break;
+    }
+
+    return DFU_BUSY;
+}
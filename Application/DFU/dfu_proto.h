@@ -0,0 +1,151 @@
+/******************************************************************************
+ * @file    dfu_proto.h
+ * @brief   Binary DFU transfer protocol, an alternative to Intel hex upload.
+ *
+ *          Frame format, multi-byte fields are little endian:
+ *
+ *          | SOF | Cmd | Length | Offset | Payload[Length] | CRC32 |
+ *          |  1  |  1  |   2    |   4    |    0 ~ 256      |   4   |
+ *
+ *          CRC32 covers Cmd ~ Payload.
+ *
+ *          Host -> Device:
+ *          START : Payload = ImageSize(4) + ImageCrc(4). Same image as the last
+ *                  session resumes, otherwise DFU bank is erased.
+ *                  Compressed image appends Format(1) + Reserved(3) + RawSize(4) +
+ *                  RawCrc(4), ImageSize / ImageCrc / Offset are of the compressed
+ *                  stream, RawSize / RawCrc are of the image in DFU bank.
+ *                  Delta image appends BaseSize(4) + BaseCrc(4) further, the image
+ *                  in active bank must match, and DFU bank is not erased.
+ *          DATA  : Payload = image bytes @ Offset, must be sent in order.
+ *          END   : Device checks image CRC32, then boots from DFU bank.
+ *          QUERY : Ask for next expected offset.
+ *          WEAR  : Ask for flash wear telemetry, allowed with or without a session.
+ *
+ *          Device -> Host:
+ *          ACK   : Offset = next expected offset (cumulative).
+ *                  START ACK payload = Window(2) + MaxPayload(2).
+ *                  END ACK payload = ImageCrc(4).
+ *                  WEAR ACK payload = Wear_TelemetryTypeDef of bsp_wear.h as in memory,
+ *                  Record.Magic is 0 without saved counters, as in DFU window at boot.
+ *          NAK   : Offset = next expected offset, Payload = Status(1).
+ *
+ *          Host keeps up to Window DATA frames in flight, and goes back to the
+ *          acknowledged offset on NAK or timeout (Go-Back-N).
+ *
+ *          Console input goes to the frame decoder while a session is active. The session
+ *          is dropped after DFU_PROTO_SESSION_TIMEOUT without input, or by
+ *          DFU_PROTO_ABORT_COUNT Ctrl-C between frames, then the console takes text again
+ *          and the next START starts over.
+ *
+ *          Frame pack / decode has no HAL dependency and is shared with host tools,
+ *          frame execution on device is implemented by DFU console.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef DFU_PROTO_H_
+#define DFU_PROTO_H_
+
+/*! Includes ----------------------------------------------------------------*/
+#include "dfu_console.h"
+#include "stdint.h"
+
+/*! Defines -----------------------------------------------------------------*/
+// clang-format off
+#define DFU_PROTO_SOF                   0xA5    //!< Start of frame, not a printable character
+#define DFU_PROTO_HEADER_SIZE           8       //!< SOF + Cmd + Length + Offset
+#define DFU_PROTO_CRC_SIZE              4
+#define DFU_PROTO_MAX_PAYLOAD           256     //!< Maximum payload, 1x flash row
+#define DFU_PROTO_MAX_FRAME             (DFU_PROTO_HEADER_SIZE + DFU_PROTO_MAX_PAYLOAD + DFU_PROTO_CRC_SIZE)
+#define DFU_PROTO_WINDOW                12      //!< In-flight DATA frames, must fit in DFU_INPUT_BUF_SIZE
+#define DFU_PROTO_BYTE_TIMEOUT          100     //!< Drop a partial frame after idle time in ms
+#define DFU_PROTO_SESSION_TIMEOUT       30000   //!< Drop the session after idle time in ms
+#define DFU_PROTO_ABORT                 0x03    //!< Ctrl-C, drops the session when repeated
+#define DFU_PROTO_ABORT_COUNT           3       //!< Ctrl-C in a row, a frame never starts with it
+#define DFU_PROTO_START_SIZE            8       //!< START payload of raw image
+#define DFU_PROTO_START_SIZE_EX         20      //!< START payload of compressed image
+#define DFU_PROTO_START_SIZE_DELTA      28      //!< START payload of delta image
+
+/*!@defgroup    DFU_PROTO_CMD Define Group
+ */
+#define DFU_PROTO_CMD_START             0x01
+#define DFU_PROTO_CMD_DATA              0x02
+#define DFU_PROTO_CMD_END               0x03
+#define DFU_PROTO_CMD_QUERY             0x04
+#define DFU_PROTO_CMD_WEAR              0x05
+#define DFU_PROTO_CMD_ACK               0x80
+#define DFU_PROTO_CMD_NAK               0x81
+
+/*!@defgroup    DFU_PROTO_STATUS Define Group, NAK reason.
+ */
+#define DFU_PROTO_STATUS_CRC            0x01    //!< Frame CRC error
+#define DFU_PROTO_STATUS_OFFSET         0x02    //!< DATA is not at expected offset
+#define DFU_PROTO_STATUS_SESSION        0x03    //!< No active session, send START first
+#define DFU_PROTO_STATUS_SIZE           0x04    //!< Image or payload too large
+#define DFU_PROTO_STATUS_FLASH          0x05    //!< Flash operation error
+#define DFU_PROTO_STATUS_IMAGE_CRC      0x06    //!< Image CRC32 mismatch
+#define DFU_PROTO_STATUS_CMD            0x07    //!< Unknown command
+#define DFU_PROTO_STATUS_FORMAT         0x08    //!< Unknown image format or corrupted stream
+#define DFU_PROTO_STATUS_BASE           0x09    //!< Active image is not the base of delta
+
+/*!@defgroup    DFU_PROTO_FORMAT Define Group, image format in START frame.
+ */
+#define DFU_PROTO_FORMAT_RAW            0x00    //!< Image as is
+#define DFU_PROTO_FORMAT_LZ4            0x01    //!< LZ4 block, @ref dfu_lz.h
+#define DFU_PROTO_FORMAT_DELTA          0x02    //!< Page patch on active image, @ref dfu_delta.h
+
+/*!@defgroup    DFU_PROTO_STATE Define Group, frame decoder state.
+ */
+#define DFU_PROTO_STATE_SOF             0       //!< Wait for SOF
+#define DFU_PROTO_STATE_HEADER          1       //!< Receiving Cmd, Length & Offset
+#define DFU_PROTO_STATE_PAYLOAD         2       //!< Receiving payload
+#define DFU_PROTO_STATE_CRC             3       //!< Receiving CRC32
+// clang-format on
+
+/*!@struct Dfu_ProtoFrameTypeDef
+ *          Decoded frame.
+ */
+typedef struct Dfu_ProtoFrameTypeDef {
+    uint8_t  Cmd;                            //!< @ref DFU_PROTO_CMD
+    uint16_t Length;                         //!< Payload length
+    uint32_t Offset;                         //!< Image offset
+    uint8_t  Payload[DFU_PROTO_MAX_PAYLOAD]; //!< Payload
+} Dfu_ProtoFrameTypeDef;
+
+/*!@struct Dfu_ProtoTypeDef
+ *          Frame decoder and transfer session.
+ */
+typedef struct Dfu_ProtoTypeDef {
+    // Frame decoder
+    uint8_t               State;    //!< @ref DFU_PROTO_STATE
+    uint16_t              Idx;      //!< Byte index in current state
+    uint32_t              Crc;      //!< Received CRC32
+    uint32_t              LastTick; //!< Tick of last received byte
+    uint8_t               Header[DFU_PROTO_HEADER_SIZE];
+    Dfu_ProtoFrameTypeDef Frame;
+    // Session
+    uint32_t Active;     //!< [1]: START is received
+    uint32_t ImageSize;  //!< Image size in byte
+    uint32_t ImageCrc;   //!< Image CRC32
+    uint32_t Format;     //!< @ref DFU_PROTO_FORMAT
+    uint32_t RawSize;    //!< Decompressed image size
+    uint32_t RawCrc;     //!< Decompressed image CRC32
+    uint32_t NextOffset; //!< Next expected image offset
+    uint32_t NakOffset;  //!< Offset of last NAK, avoid a NAK for every frame of a window
+    // Statistic
+    uint32_t FrameCount;    //!< Valid frames
+    uint32_t CrcErrorCount; //!< Frames with CRC error
+    uint32_t DropCount;     //!< DATA frames out of order
+} Dfu_ProtoTypeDef;
+
+/*! Functions ---------------------------------------------------------------*/
+void     Dfu_protoInit(Dfu_ProtoTypeDef *proto);
+uint16_t Dfu_protoPack(uint8_t *buf, uint8_t cmd, uint32_t offset, const uint8_t *payload,
+                       uint16_t len);
+DFU_RET  Dfu_protoDecodeByte(Dfu_ProtoTypeDef *proto, uint8_t c, uint32_t tick);
+DFU_RET  Dfu_protoExcuteFrame(Dfu_ProtoTypeDef *proto);
+
+#endif /* DFU_PROTO_H_ */
@@ -0,0 +1,233 @@
+/******************************************************************************
+ * @file    crc_sim.c
+ * @brief   Host simulation of STM32L4 CRC calculation unit.
+ *
+ *          HAL_CRC_xxx() and LL_CRC_xxx() API run in software on one set of
+ *          simulated CRC registers (CR, INIT, POL, DR) like the real unit, so a
+ *          module that changes the configuration changes it for every other user.
+ *          7/8/16/32-bit polynomials, input reversal by byte / half word / word and
+ *          output reversal as RM0351 describes.
+ *          HAL calculation adds its duration to simulated time, the unit takes a
+ *          word in 4 AHB cycles, loading the word from flash takes a few more.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include "hal_sim.h"
+#include "stm32l4xx_hal.h"
+#include "stm32l4xx_ll_crc.h"
+
+// clang-format off
+#define SIM_CRC_BYTES_PER_US    40      //!< 1x word per 8 cycles @ 80 MHz
+// clang-format on
+
+static uint32_t CrcSim_reflect(uint32_t v, int bits)
+{
+    uint32_t r = 0;
+    for (int i = 0; i < bits; i++)
+    {
+        r = (r << 1) | ((v >> i) & 1);
+    }
+    return r;
+}
+
+static uint32_t CrcSim_width(CRC_TypeDef *CRCx)
+{
+    switch (CRCx->CR & CRC_CR_POLYSIZE)
+    {
+    case LL_CRC_POLYLENGTH_16B:
+        return 16;
+    case LL_CRC_POLYLENGTH_8B:
+        return 8;
+    case LL_CRC_POLYLENGTH_7B:
+        return 7;
+    default:
+        return 32;
+    }
+}
+
+/*!@brief Write to DR register, 8, 16 or 32 bits. Input reversal of CR.REV_IN is applied on
+ *        the written width, then data is processed MSB first, result is kept in DR.
+ */
+static void CrcSim_feed(CRC_TypeDef *CRCx, uint32_t data, int bits)
+{
+    uint32_t width = CrcSim_width(CRCx);
+    uint32_t mask  = (width == 32) ? 0xFFFFFFFF : (1U << width) - 1;
+    uint32_t crc   = CRCx->DR & mask;
+
+    switch (CRCx->CR & CRC_CR_REV_IN)
+    {
+    case LL_CRC_INDATA_REVERSE_BYTE:
+        for (int i = 0; i < bits; i += 8)
+        {
+            data = (data & ~(0xFFU << i)) | (CrcSim_reflect(data >> i, 8) << i);
+        }
+        break;
+    case LL_CRC_INDATA_REVERSE_HALFWORD:
+        for (int i = 0; i < bits; i += 16)
+        {
+            data = (bits < 16) ? CrcSim_reflect(data, bits)
+                               : (data & ~(0xFFFFU << i)) | (CrcSim_reflect(data >> i, 16) << i);
+        }
+        break;
+    case LL_CRC_INDATA_REVERSE_WORD:
+        data = CrcSim_reflect(data, bits);
+        break;
+    default:
+        break;
+    }
+
+    for (int i = bits - 1; i >= 0; i--)
+    {
+        uint32_t msb = ((crc >> (width - 1)) ^ (data >> i)) & 1;
+        crc          = ((crc << 1) & mask) ^ (msb ? (CRCx->POL & mask) : 0);
+    }
+
+    CRCx->DR = crc;
+}
+
+/*!@brief Read DR register, output reversal of CR.REV_OUT is applied on the polynomial width.
+ */
+static uint32_t CrcSim_read(CRC_TypeDef *CRCx)
+{
+    return (CRCx->CR & CRC_CR_REV_OUT) ? CrcSim_reflect(CRCx->DR, CrcSim_width(CRCx)) : CRCx->DR;
+}
+
+/*! HAL CRC API -------------------------------------------------------------*/
+
+HAL_StatusTypeDef HAL_CRC_Init(CRC_HandleTypeDef *hcrc)
+{
+    CRC_TypeDef *CRCx;
+
+    if ((hcrc == NULL) || (hcrc->Instance == NULL))
+    {
+        return HAL_ERROR;
+    }
+
+    CRCx = hcrc->Instance;
+    if (hcrc->Init.DefaultPolynomialUse == DEFAULT_POLYNOMIAL_ENABLE)
+    {
+        CRCx->POL = DEFAULT_CRC32_POLY;
+        MODIFY_REG(CRCx->CR, CRC_CR_POLYSIZE, CRC_POLYLENGTH_32B);
+    }
+    else
+    {
+        CRCx->POL = hcrc->Init.GeneratingPolynomial;
+        MODIFY_REG(CRCx->CR, CRC_CR_POLYSIZE, hcrc->Init.CRCLength);
+    }
+    CRCx->INIT = (hcrc->Init.DefaultInitValueUse == DEFAULT_INIT_VALUE_ENABLE)
+                     ? DEFAULT_CRC_INITVALUE
+                     : hcrc->Init.InitValue;
+    MODIFY_REG(CRCx->CR, CRC_CR_REV_IN, hcrc->Init.InputDataInversionMode);
+    MODIFY_REG(CRCx->CR, CRC_CR_REV_OUT, hcrc->Init.OutputDataInversionMode);
+
+    hcrc->State = HAL_CRC_STATE_READY;
+    return HAL_OK;
+}
+
+/*!@brief Continue calculation. Byte format packs 4x bytes in a word MSB first like HAL does,
+ *        word format writes each word as is.
+ */
+uint32_t HAL_CRC_Accumulate(CRC_HandleTypeDef *hcrc, uint32_t pBuffer[], uint32_t BufferLength)
+{
+    uint32_t bytes = BufferLength;
+
+    if (hcrc->InputDataFormat == CRC_INPUTDATA_FORMAT_BYTES)
+    {
+        uint8_t *buf = (uint8_t *)pBuffer;
+        uint32_t i   = 0;
+        for (; i + 4 <= BufferLength; i += 4)
+        {
+            CrcSim_feed(hcrc->Instance,
+                        ((uint32_t)buf[i] << 24) | (buf[i + 1] << 16) | (buf[i + 2] << 8) |
+                            buf[i + 3],
+                        32);
+        }
+        for (; i < BufferLength; i++)
+        {
+            CrcSim_feed(hcrc->Instance, buf[i], 8);
+        }
+    }
+    else
+    {
+        bytes = BufferLength * 4;
+        for (uint32_t i = 0; i < BufferLength; i++)
+        {
+            CrcSim_feed(hcrc->Instance, pBuffer[i], 32);
+        }
+    }
+
+    HalSim_AddTime(bytes / SIM_CRC_BYTES_PER_US);
+
+    return CrcSim_read(hcrc->Instance);
+}
+
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef *hcrc, uint32_t pBuffer[], uint32_t BufferLength)
+{
+    hcrc->Instance->DR = hcrc->Instance->INIT;
+    return HAL_CRC_Accumulate(hcrc, pBuffer, BufferLength);
+}
+
+/*! LL CRC API --------------------------------------------------------------*/
+
+void LL_CRC_ResetCRCCalculationUnit(CRC_TypeDef *CRCx)
+{
+    CRCx->DR = CRCx->INIT;
+}
+
+void LL_CRC_SetPolynomialSize(CRC_TypeDef *CRCx, uint32_t PolySize)
+{
+    MODIFY_REG(CRCx->CR, CRC_CR_POLYSIZE, PolySize);
+}
+
+void LL_CRC_SetPolynomialCoef(CRC_TypeDef *CRCx, uint32_t PolynomCoef)
+{
+    CRCx->POL = PolynomCoef;
+}
+
+void LL_CRC_SetInitialData(CRC_TypeDef *CRCx, uint32_t InitCrc)
+{
+    CRCx->INIT = InitCrc;
+}
+
+void LL_CRC_SetInputDataReverseMode(CRC_TypeDef *CRCx, uint32_t ReverseMode)
+{
+    MODIFY_REG(CRCx->CR, CRC_CR_REV_IN, ReverseMode);
+}
+
+void LL_CRC_SetOutputDataReverseMode(CRC_TypeDef *CRCx, uint32_t ReverseMode)
+{
+    MODIFY_REG(CRCx->CR, CRC_CR_REV_OUT, ReverseMode);
+}
+
+void LL_CRC_FeedData32(CRC_TypeDef *CRCx, uint32_t InData)
+{
+    CrcSim_feed(CRCx, InData, 32);
+}
+
+void LL_CRC_FeedData16(CRC_TypeDef *CRCx, uint16_t InData)
+{
+    CrcSim_feed(CRCx, InData, 16);
+}
+
+void LL_CRC_FeedData8(CRC_TypeDef *CRCx, uint8_t InData)
+{
+    CrcSim_feed(CRCx, InData, 8);
+}
+
+uint32_t LL_CRC_ReadData32(CRC_TypeDef *CRCx)
+{
+    return CrcSim_read(CRCx);
+}
+
+uint16_t LL_CRC_ReadData16(CRC_TypeDef *CRCx)
+{
+    return (uint16_t)CrcSim_read(CRCx);
+}
+
+uint8_t LL_CRC_ReadData8(CRC_TypeDef *CRCx)
+{
+    return (uint8_t)CrcSim_read(CRCx);
+}
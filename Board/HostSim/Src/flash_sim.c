@@ -0,0 +1,524 @@
+/******************************************************************************
+ * @file    flash_sim.c
+ * @brief   Host simulation of STM32L476 dual bank flash controller.
+ *
+ *          Implement HAL_FLASH_xxx() API on a RAM backed memory mapped at the
+ *          target address, and apply the programming rules of RM0351:
+ *          - Flash must be unlocked before program / erase.
+ *          - Double word program needs an erased (or zero written) double word.
+ *          - Fast (row) program needs a blank row in a bank with no page erase
+ *            since its last mass erase.
+ *          Every operation adds its duration in FlashSim_Timing to simulated time.
+ *          Interrupt mode erase runs in background instead: its end of operation
+ *          callback is run before return, and the next operation waits until the
+ *          erase time has passed, as FLASH_WaitForLastOperation() does.
+ *
+ *          Power loss: each double word, row, page erase and bank mass erase is a
+ *          step. FlashSim_PowerLoss() arms a loss at a given step, which is left
+ *          half done (some bits programmed / erased, others not), then every later
+ *          step fails until FlashSim_Reset(). ECC error on reading a torn double
+ *          word is not simulated, the torn value is read as is.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "flash_sim.h"
+#include "hal_sim.h"
+#include "stm32l4xx_hal.h"
+
+// clang-format off
+#define SIM_FLASH_SIZE          0x100000    //!< 1 MB main flash, 2x 512 kB bank
+#define SIM_BANK_SIZE           0x80000     //!< 512 kB bank
+#define SIM_PAGE_SIZE           0x800       //!< 2 kB page
+#define SIM_SYSMEM_BASE         0x1FFF0000  //!< System memory, OTP, flash size & option bytes
+#define SIM_SYSMEM_SIZE         0x10000
+#define SIM_PERIPH_BASE         0x40000000  //!< APB1 / APB2 / AHB1 peripheral registers
+#define SIM_PERIPH_SIZE         0x30000
+// clang-format on
+
+FlashSim_StatTypeDef   FlashSim_Stat          = {0};
+volatile uint32_t      FlashSim_PowerLost     = 0;
+uint32_t               FlashSim_PowerLossAddr = 0;
+FlashSim_TimingTypeDef FlashSim_Timing        = {
+    .Dword     = FLASH_SIM_TIME_DWORD,
+    .Row       = FLASH_SIM_TIME_ROW,
+    .PageErase = FLASH_SIM_TIME_PAGE_ERASE,
+    .MassErase = FLASH_SIM_TIME_MASS_ERASE,
+};
+
+static uint32_t FlashSim_Locked        = 1;      //!< Flash control register lock
+static uint32_t FlashSim_Bfb2          = 0;      //!< Option byte BFB2, boot from bank 2
+static uint32_t FlashSim_MassErased[2] = {0, 0}; //!< Physical bank is mass erased
+static uint32_t FlashSim_LossStep      = 0;      //!< Step of injected power loss, 0 = none
+static uint32_t FlashSim_LossSeed      = 1;      //!< Random state of torn bits
+static uint32_t FlashSim_Background    = 0;      //!< Operation runs in background, no wait
+static uint64_t FlashSim_BusyEnd       = 0;      //!< Simulated time background erase ends
+
+/*!@brief Map a memory region to its target address in host process.
+ */
+static int FlashSim_Map(uint32_t addr, uint32_t size, uint8_t fill)
+{
+    void *ptr = mmap((void *)(uintptr_t)addr, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    if (ptr != (void *)(uintptr_t)addr)
+    {
+        fprintf(stderr, "ERROR: FlashSim can't map [0x%08X], size [0x%X]\n", addr, size);
+        return -1;
+    }
+
+    memset(ptr, fill, size);
+    return 0;
+}
+
+/*!@brief Get physical bank index [0~1] of a flash address, following the bank swap setting.
+ */
+static uint32_t FlashSim_PhyBank(uint32_t addr)
+{
+    uint32_t upper = (addr - FLASH_BASE) >= SIM_BANK_SIZE;
+    uint32_t swap  = READ_BIT(SYSCFG->MEMRMP, SYSCFG_MEMRMP_FB_MODE) != 0;
+
+    return upper ^ swap;
+}
+
+/*!@brief Get current address of a physical bank [0~1].
+ */
+static uint32_t FlashSim_BankAddr(uint32_t phy)
+{
+    uint32_t swap = READ_BIT(SYSCFG->MEMRMP, SYSCFG_MEMRMP_FB_MODE) != 0;
+
+    return FLASH_BASE + ((phy ^ swap) ? SIM_BANK_SIZE : 0);
+}
+
+static void FlashSim_Busy(uint64_t us)
+{
+    FlashSim_Stat.BusyTime += us;
+    if (FlashSim_Background)
+    {
+        uint64_t now     = HalSim_GetTime();
+        FlashSim_BusyEnd = ((FlashSim_BusyEnd > now) ? FlashSim_BusyEnd : now) + us;
+    }
+    else
+    {
+        HalSim_AddTime(us);
+    }
+}
+
+/*!@brief Wait for the end of background erase before a new operation.
+ */
+static void FlashSim_Wait(void)
+{
+    uint64_t now = HalSim_GetTime();
+
+    if (FlashSim_BusyEnd > now)
+    {
+        FlashSim_Stat.WaitTime += FlashSim_BusyEnd - now;
+        HalSim_AddTime(FlashSim_BusyEnd - now);
+    }
+}
+
+/*!@brief Random bit mask of torn double word, xorshift.
+ */
+static uint64_t FlashSim_TornMask(void)
+{
+    uint64_t mask = 0;
+
+    for (int i = 0; i < 2; i++)
+    {
+        FlashSim_LossSeed ^= FlashSim_LossSeed << 13;
+        FlashSim_LossSeed ^= FlashSim_LossSeed >> 17;
+        FlashSim_LossSeed ^= FlashSim_LossSeed << 5;
+        mask = (mask << 32) | FlashSim_LossSeed;
+    }
+    return mask;
+}
+
+/*!@brief Count a program / erase step and check injected power loss.
+ *
+ * @return [0] Step runs normally, [1] Power is lost in this step, [-1] Power was lost before.
+ */
+static int FlashSim_Step(uint32_t addr)
+{
+    if (FlashSim_PowerLost)
+    {
+        return -1;
+    }
+
+    FlashSim_Stat.StepCount++;
+    if (FlashSim_Stat.StepCount != FlashSim_LossStep)
+    {
+        return 0;
+    }
+
+    FlashSim_PowerLost     = 1;
+    FlashSim_PowerLossAddr = addr;
+    HalSim_ResetRequest    = 1;
+    return 1;
+}
+
+/*!@brief Interrupted program, only some of the bits are cleared.
+ */
+static void FlashSim_TornProgram(volatile uint64_t *dst, uint32_t count, const uint64_t *src)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        dst[i] &= src[i] | FlashSim_TornMask();
+    }
+}
+
+/*!@brief Interrupted erase, only some of the bits are set.
+ */
+static void FlashSim_TornErase(uint32_t addr, uint32_t size)
+{
+    volatile uint64_t *dst = (volatile uint64_t *)(uintptr_t)addr;
+
+    for (uint32_t i = 0; i < size / 8; i++)
+    {
+        dst[i] |= FlashSim_TornMask();
+    }
+}
+
+static HAL_StatusTypeDef FlashSim_Error(const char *msg, uint32_t addr)
+{
+    fprintf(stderr, "FlashSim: %s @ [0x%08X]\n", msg, addr);
+    FlashSim_Stat.ErrorCount++;
+    return HAL_ERROR;
+}
+
+/*!@brief Peripheral registers with none zero reset value, and the ones shared by modules
+ *        which rely on reset value (CRC unit).
+ */
+static void FlashSim_ResetPeriph(void)
+{
+    CRC->CR   = 0;
+    CRC->DR   = 0xFFFFFFFF;
+    CRC->INIT = 0xFFFFFFFF;
+    CRC->POL  = 0x04C11DB7;
+}
+
+/*!@brief Map simulated memory regions, must be called before any flash access.
+ *
+ * @return [0] Success, [-1] Memory map fail.
+ */
+int FlashSim_Init(void)
+{
+    if ((FlashSim_Map(FLASH_BASE, SIM_FLASH_SIZE, 0xFF) != 0) ||
+        (FlashSim_Map(SIM_SYSMEM_BASE, SIM_SYSMEM_SIZE, 0xFF) != 0) ||
+        (FlashSim_Map(SIM_PERIPH_BASE, SIM_PERIPH_SIZE, 0x00) != 0))
+    {
+        return -1;
+    }
+
+    // Flash size data register, in kB.
+    *(uint16_t *)FLASH_SIZE_DATA_REGISTER = SIM_FLASH_SIZE / 1024;
+
+    FlashSim_ResetPeriph();
+
+    FlashSim_EraseAll();
+    FlashSim_ResetStat();
+    return 0;
+}
+
+/*!@brief Erase entire flash and restore factory state without counting statistic.
+ */
+void FlashSim_EraseAll(void)
+{
+    memset((void *)FLASH_BASE, 0xFF, SIM_FLASH_SIZE);
+    CLEAR_BIT(SYSCFG->MEMRMP, SYSCFG_MEMRMP_FB_MODE);
+    FlashSim_Bfb2          = 0;
+    FlashSim_Locked        = 1;
+    FlashSim_MassErased[0] = 1;
+    FlashSim_MassErased[1] = 1;
+    FlashSim_LossStep      = 0;
+    FlashSim_PowerLost     = 0;
+    HalSim_ResetRequest    = 0;
+}
+
+void FlashSim_ResetStat(void)
+{
+    memset(&FlashSim_Stat, 0, sizeof(FlashSim_Stat));
+}
+
+/*!@brief Simulate a MCU reset, boot bank is selected by option byte BFB2.
+ */
+void FlashSim_Reset(void)
+{
+    uint32_t swap = READ_BIT(SYSCFG->MEMRMP, SYSCFG_MEMRMP_FB_MODE) != 0;
+
+    // Swap the 2x bank in address space when boot bank changes.
+    if (swap != FlashSim_Bfb2)
+    {
+        uint8_t *tmp = malloc(SIM_BANK_SIZE);
+        memcpy(tmp, (void *)FLASH_BASE, SIM_BANK_SIZE);
+        memcpy((void *)FLASH_BASE, (void *)(FLASH_BASE + SIM_BANK_SIZE), SIM_BANK_SIZE);
+        memcpy((void *)(FLASH_BASE + SIM_BANK_SIZE), tmp, SIM_BANK_SIZE);
+        free(tmp);
+        MODIFY_REG(SYSCFG->MEMRMP, SYSCFG_MEMRMP_FB_MODE, FlashSim_Bfb2 ? SYSCFG_MEMRMP_FB_MODE : 0);
+    }
+
+    FlashSim_Locked     = 1;
+    FlashSim_PowerLost  = 0;
+    FlashSim_BusyEnd    = 0;
+    HalSim_ResetRequest = 0;
+    FlashSim_ResetPeriph();
+}
+
+/*!@brief Inject a power loss.
+ *
+ * @param step  : Step to interrupt, counted by FlashSim_Stat.StepCount, 0 to disarm.
+ *                e.g. step = StepCount + 1 interrupts the next program / erase.
+ * @param seed  : Random seed of torn bits, none zero.
+ */
+void FlashSim_PowerLoss(uint32_t step, uint32_t seed)
+{
+    FlashSim_LossStep = step;
+    FlashSim_LossSeed = seed ? seed : 1;
+}
+
+/*! HAL_FLASH API -----------------------------------------------------------*/
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+    FlashSim_Locked = 0;
+    FlashSim_Stat.UnlockCount++;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+    FlashSim_Locked = 1;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+    FlashSim_Wait();
+
+    if (FlashSim_Locked)
+    {
+        return FlashSim_Error("Program while locked", Address);
+    }
+
+    if (TypeProgram == FLASH_TYPEPROGRAM_DOUBLEWORD)
+    {
+        uint32_t is_main = (Address >= FLASH_BASE) && (Address < FLASH_BASE + SIM_FLASH_SIZE);
+        uint32_t is_otp  = (Address >= 0x1FFF7000) && (Address < 0x1FFF7400);
+
+        if ((Address % 8 != 0) || !(is_main || is_otp))
+        {
+            return FlashSim_Error("Program address invalid", Address);
+        }
+
+        // PROGERR: Double word must be erased, except to write all zero.
+        volatile uint64_t *dst = (volatile uint64_t *)(uintptr_t)Address;
+        if ((*dst != 0xFFFFFFFFFFFFFFFF) && (Data != 0))
+        {
+            return FlashSim_Error("Program on non-erased double word", Address);
+        }
+
+        int step = FlashSim_Step(Address);
+        if (step != 0)
+        {
+            if (step > 0)
+            {
+                FlashSim_TornProgram(dst, 1, &Data);
+                FlashSim_Busy(FlashSim_Timing.Dword / 2);
+            }
+            return HAL_ERROR;
+        }
+
+        *dst = Data;
+        FlashSim_Stat.DwordCount++;
+        FlashSim_Busy(FlashSim_Timing.Dword);
+        return HAL_OK;
+    }
+    else if ((TypeProgram == FLASH_TYPEPROGRAM_FAST) ||
+             (TypeProgram == FLASH_TYPEPROGRAM_FAST_AND_LAST))
+    {
+        uint8_t *src = (uint8_t *)(uintptr_t)(uint32_t)Data;
+        uint8_t *dst = (uint8_t *)(uintptr_t)Address;
+
+        if ((Address % 256 != 0) || (Address < FLASH_BASE) ||
+            (Address >= FLASH_BASE + SIM_FLASH_SIZE))
+        {
+            return FlashSim_Error("Fast program address invalid", Address);
+        }
+
+        // PGSERR: Fast programming is only allowed on a mass erased bank.
+        uint32_t phy = FlashSim_PhyBank(Address);
+        for (int i = 0; i < 256; i++)
+        {
+            if (dst[i] != 0xFF)
+            {
+                return FlashSim_Error("Fast program on non-erased row", Address);
+            }
+        }
+
+        if (!FlashSim_MassErased[phy])
+        {
+            return FlashSim_Error("Fast program on page erased bank", Address);
+        }
+
+        int step = FlashSim_Step(Address);
+        if (step != 0)
+        {
+            if (step > 0)
+            {
+                // Row is programmed double word by double word, stop in the middle.
+                uint32_t done = FlashSim_TornMask() % 32;
+                memcpy(dst, src, done * 8);
+                FlashSim_TornProgram((volatile uint64_t *)&dst[done * 8], 1,
+                                     (const uint64_t *)&src[done * 8]);
+                FlashSim_Busy(FlashSim_Timing.Row * done / 32);
+            }
+            return HAL_ERROR;
+        }
+
+        memcpy(dst, src, 256);
+        FlashSim_Stat.RowCount++;
+        FlashSim_Busy(FlashSim_Timing.Row);
+        return HAL_OK;
+    }
+
+    return FlashSim_Error("Program type invalid", Address);
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError)
+{
+    FlashSim_Wait();
+    *PageError = 0xFFFFFFFF;
+
+    if (FlashSim_Locked)
+    {
+        return FlashSim_Error("Erase while locked", 0);
+    }
+
+    if (pEraseInit->TypeErase == FLASH_TYPEERASE_MASSERASE)
+    {
+        for (uint32_t phy = 0; phy < 2; phy++)
+        {
+            if (pEraseInit->Banks & (FLASH_BANK_1 << phy))
+            {
+                int step = FlashSim_Step(FlashSim_BankAddr(phy));
+                if (step != 0)
+                {
+                    if (step > 0)
+                    {
+                        FlashSim_TornErase(FlashSim_BankAddr(phy), SIM_BANK_SIZE);
+                        FlashSim_MassErased[phy] = 0;
+                        FlashSim_Busy(FlashSim_Timing.MassErase / 2);
+                    }
+                    return HAL_ERROR;
+                }
+
+                memset((void *)FlashSim_BankAddr(phy), 0xFF, SIM_BANK_SIZE);
+                FlashSim_MassErased[phy] = 1;
+                FlashSim_Stat.MassErase++;
+                FlashSim_Busy(FlashSim_Timing.MassErase);
+            }
+        }
+        return HAL_OK;
+    }
+
+    uint32_t phy = (pEraseInit->Banks == FLASH_BANK_2) ? 1 : 0;
+    for (uint32_t page = pEraseInit->Page; page < pEraseInit->Page + pEraseInit->NbPages; page++)
+    {
+        if (page >= SIM_BANK_SIZE / SIM_PAGE_SIZE)
+        {
+            *PageError = page;
+            return FlashSim_Error("Erase page invalid", page);
+        }
+
+        uint32_t addr = FlashSim_BankAddr(phy) + page * SIM_PAGE_SIZE;
+        int      step = FlashSim_Step(addr);
+        if (step != 0)
+        {
+            if (step > 0)
+            {
+                FlashSim_TornErase(addr, SIM_PAGE_SIZE);
+                FlashSim_MassErased[phy] = 0;
+                FlashSim_Busy(FlashSim_Timing.PageErase / 2);
+            }
+            *PageError = page;
+            return HAL_ERROR;
+        }
+
+        memset((void *)addr, 0xFF, SIM_PAGE_SIZE);
+        FlashSim_MassErased[phy] = 0;
+        FlashSim_Stat.PageErase++;
+        FlashSim_Busy(FlashSim_Timing.PageErase);
+    }
+
+    return HAL_OK;
+}
+
+/*!@brief Interrupt mode erase, memory is erased and the interrupt callback is run before return,
+ *        flash stays busy in background for the erase time.
+ */
+HAL_StatusTypeDef HAL_FLASHEx_Erase_IT(FLASH_EraseInitTypeDef *pEraseInit)
+{
+    uint32_t page_error = 0;
+
+    FlashSim_Wait();
+    FlashSim_Background   = 1;
+    HAL_StatusTypeDef ret = HAL_FLASHEx_Erase(pEraseInit, &page_error);
+    FlashSim_Background   = 0;
+
+    if (ret == HAL_OK)
+    {
+        HAL_FLASH_EndOfOperationCallback(0xFFFFFFFF);
+    }
+    else if (page_error != 0xFFFFFFFF)
+    {
+        HAL_FLASH_OperationErrorCallback(page_error);
+    }
+    return ret;
+}
+
+__weak void HAL_FLASH_EndOfOperationCallback(uint32_t ReturnValue)
+{
+}
+
+__weak void HAL_FLASH_OperationErrorCallback(uint32_t ReturnValue)
+{
+}
+
+HAL_StatusTypeDef HAL_FLASH_OB_Unlock(void)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_OB_Lock(void)
+{
+    return HAL_OK;
+}
+
+void HAL_FLASHEx_OBGetConfig(FLASH_OBProgramInitTypeDef *pOBInit)
+{
+    pOBInit->OptionType = OPTIONBYTE_USER;
+    pOBInit->USERType   = OB_USER_BFB2;
+    pOBInit->USERConfig = FlashSim_Bfb2 ? OB_BFB2_ENABLE : OB_BFB2_DISABLE;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_OBProgram(FLASH_OBProgramInitTypeDef *pOBInit)
+{
+    if ((pOBInit->OptionType & OPTIONBYTE_USER) && (pOBInit->USERType & OB_USER_BFB2))
+    {
+        FlashSim_Bfb2 = (pOBInit->USERConfig & OB_BFB2_ENABLE) ? 1 : 0;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_OB_Launch(void)
+{
+    // Option byte loading resets the MCU.
+    HalSim_ResetRequest = 1;
+    return HAL_OK;
+}
@@ -0,0 +1,308 @@
+/******************************************************************************
+ * @file    hal_sim.c
+ * @brief   Host simulation of STM32L4 HAL system services.
+ *
+ *          - Tick is driven by simulated time, flash operations and HAL_Delay()
+ *            advance it, so time measured by firmware reflects target timing.
+ *          - UART RX is a circular DMA, bytes are pushed by HalSim_UartRxPush().
+ *          - UART TX is handed to HalSim_UartTxHook, or dropped if no hook is set.
+ *          - RTC backup registers are kept over simulated resets, GPIO inputs read low.
+ *          - PVD and NVIC configuration is ignored, PVD interrupt is never raised.
+ *          - Peripheral interrupts are raised at a simulated time by HalSim_SetIrq(), and
+ *            served when firmware sleeps in HalSim_Idle(), e.g. waiting a semaphore.
+ *            __get_IPSR() tells firmware a handler is running, PRIMASK is only kept.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <time.h>
+
+#include "hal_sim.h"
+#include "stm32l4xx_hal.h"
+
+volatile uint32_t        HalSim_ResetRequest = 0;
+UART_HandleTypeDef       huart2              = {.Init.BaudRate = 115200};
+RTC_HandleTypeDef        hrtc                = {0};
+HalSim_UartTxHookTypeDef HalSim_UartTxHook   = NULL;
+
+static DMA_HandleTypeDef HalSim_UartRxDma  = {0};
+static uint8_t          *HalSim_UartRxBuf  = NULL;
+static uint16_t          HalSim_UartRxSize = 0;
+
+static uint32_t HalSim_RtcBkp[32] = {0};
+
+static uint64_t HalSim_Time = 0; //!< Simulated time in us
+static uint32_t HalSim_Rng  = 1; //!< State of HalSim_Rand()
+
+uint64_t HalSim_IdleTime = 0;
+
+static struct {
+    uint64_t          Time;    //!< Simulated time the interrupt is raised at
+    HalSim_IrqTypeDef Handler; //!< NULL if the slot is free
+} HalSim_Irq[HALSIM_IRQ_NUM] = {0};
+
+static uint32_t HalSim_Ipsr    = 0; //!< Exception number of the running handler, 0 in thread mode
+static uint32_t HalSim_Primask = 0;
+
+uint64_t HalSim_GetTime(void)
+{
+    return HalSim_Time;
+}
+
+void HalSim_AddTime(uint64_t us)
+{
+    HalSim_Time += us;
+}
+
+/*!@brief Get host process CPU time in second.
+ */
+double HalSim_GetCpuTime(void)
+{
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/*!@brief Restart the pseudo-random sequence of HalSim_Rand(), benches replay a workload by it.
+ */
+void HalSim_Seed(uint32_t seed)
+{
+    HalSim_Rng = seed;
+}
+
+/*!@brief Pseudo-random number of 24 bits, a linear congruential generator, the same sequence
+ *        on every host.
+ */
+uint32_t HalSim_Rand(void)
+{
+    HalSim_Rng = HalSim_Rng * 1103515245 + 12345;
+    return HalSim_Rng >> 8;
+}
+
+/*!@brief Raise an interrupt at a simulated time, the handler runs in HalSim_Idle().
+ *
+ * @return [0] Success, [-1] All slots pending.
+ */
+int HalSim_SetIrq(uint64_t time, HalSim_IrqTypeDef handler)
+{
+    for (uint32_t i = 0; i < HALSIM_IRQ_NUM; i++)
+    {
+        if (HalSim_Irq[i].Handler == NULL)
+        {
+            HalSim_Irq[i].Time    = time;
+            HalSim_Irq[i].Handler = handler;
+            return 0;
+        }
+    }
+
+    fprintf(stderr, "ERROR: HalSim interrupt slots full\n");
+    return -1;
+}
+
+/*!@brief Cancel the pending interrupts of a handler.
+ */
+void HalSim_ClearIrq(HalSim_IrqTypeDef handler)
+{
+    for (uint32_t i = 0; i < HALSIM_IRQ_NUM; i++)
+    {
+        if (HalSim_Irq[i].Handler == handler)
+        {
+            HalSim_Irq[i].Handler = NULL;
+        }
+    }
+}
+
+/*!@brief Sleep until the next interrupt like WFI, time jumps to it and its handler runs.
+ *        Time slept is counted in HalSim_IdleTime, free for other tasks on target.
+ *
+ * @param until : Don't sleep past this time, UINT64_MAX to sleep until an interrupt.
+ * @return [1] An interrupt was served, [0] None is raised up to until, time is at until,
+ *         or unchanged if there is no interrupt to wait.
+ */
+int HalSim_Idle(uint64_t until)
+{
+    int next = -1;
+
+    for (int i = 0; i < HALSIM_IRQ_NUM; i++)
+    {
+        if ((HalSim_Irq[i].Handler != NULL) &&
+            ((next < 0) || (HalSim_Irq[i].Time < HalSim_Irq[next].Time)))
+        {
+            next = i;
+        }
+    }
+    if ((next < 0) && (until == UINT64_MAX))
+    {
+        return 0;
+    }
+
+    uint64_t time = ((next >= 0) && (HalSim_Irq[next].Time <= until)) ? HalSim_Irq[next].Time
+                                                                       : until;
+    if (time > HalSim_Time)
+    {
+        HalSim_IdleTime += time - HalSim_Time;
+        HalSim_Time = time;
+    }
+    if ((next < 0) || (HalSim_Irq[next].Time > until))
+    {
+        return 0;
+    }
+
+    HalSim_IrqTypeDef handler = HalSim_Irq[next].Handler;
+    uint32_t          ipsr    = HalSim_Ipsr;
+    HalSim_Irq[next].Handler  = NULL;
+    // External interrupts are exceptions from 16, nested if a handler sleeps.
+    HalSim_Ipsr = 16 + next;
+    handler();
+    HalSim_Ipsr = ipsr;
+    return 1;
+}
+
+/*!@brief Exception number of the running simulated handler, 0 in thread mode.
+ */
+uint32_t __get_IPSR(void)
+{
+    return HalSim_Ipsr;
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return HalSim_Primask;
+}
+
+void __set_PRIMASK(uint32_t priMask)
+{
+    HalSim_Primask = priMask & 1;
+}
+
+void __disable_irq(void)
+{
+    HalSim_Primask = 1;
+}
+
+void __enable_irq(void)
+{
+    HalSim_Primask = 0;
+}
+
+/*! HAL system API ----------------------------------------------------------*/
+
+uint32_t HAL_GetTick(void)
+{
+    // Firmware polls the tick in busy loops, keep the time moving.
+    HalSim_Time += 1;
+    return (uint32_t)(HalSim_Time / 1000);
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+    HalSim_Time += (uint64_t)Delay * 1000;
+}
+
+void HAL_NVIC_SystemReset(void)
+{
+    HalSim_ResetRequest = 1;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+}
+
+HAL_StatusTypeDef HAL_PWR_ConfigPVD(PWR_PVDTypeDef *sConfigPVD)
+{
+    return HAL_OK;
+}
+
+void HAL_PWR_EnablePVD(void)
+{
+}
+
+void assert_failed(char *file, uint32_t line)
+{
+    fprintf(stderr, "ERROR: assert failed @ %s:%u\n", file, line);
+}
+
+/*! HAL UART API ------------------------------------------------------------*/
+
+HAL_UART_StateTypeDef HAL_UART_GetState(UART_HandleTypeDef *huart)
+{
+    return HAL_UART_STATE_READY;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    if ((HalSim_UartTxHook != NULL) && (Size > 0))
+    {
+        HalSim_UartTxHook(pData, Size);
+    }
+    return HAL_OK;
+}
+
+/*!@brief Start circular DMA reception, DMA channel registers are in simulated peripheral memory.
+ */
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    HalSim_UartRxDma.Instance        = DMA1_Channel6;
+    HalSim_UartRxDma.Instance->CNDTR = Size;
+    HalSim_UartRxBuf                 = pData;
+    HalSim_UartRxSize                = Size;
+    huart->hdmarx                    = &HalSim_UartRxDma;
+    return HAL_OK;
+}
+
+/*!@brief Receive 1 byte to the circular DMA buffer, like the UART RX line does.
+ */
+void HalSim_UartRxPush(uint8_t c)
+{
+    if (HalSim_UartRxBuf == NULL)
+    {
+        return;
+    }
+
+    DMA_Channel_TypeDef *dma = HalSim_UartRxDma.Instance;
+    uint16_t             pos = HalSim_UartRxSize - dma->CNDTR;
+
+    HalSim_UartRxBuf[pos] = c;
+    dma->CNDTR            = (dma->CNDTR <= 1) ? HalSim_UartRxSize : dma->CNDTR - 1;
+}
+
+/*!@brief Get DMA write position in the circular buffer.
+ */
+uint16_t HalSim_UartRxHead(void)
+{
+    return (HalSim_UartRxBuf == NULL) ? 0 : HalSim_UartRxSize - HalSim_UartRxDma.Instance->CNDTR;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortTransmit_IT(UART_HandleTypeDef *huart)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive_IT(UART_HandleTypeDef *huart)
+{
+    HalSim_UartRxBuf = NULL;
+    huart->hdmarx    = NULL;
+    return HAL_OK;
+}
+
+/*! HAL RTC / GPIO API ------------------------------------------------------*/
+
+uint32_t HAL_RTCEx_BKUPRead(RTC_HandleTypeDef *hrtc, uint32_t BackupRegister)
+{
+    return HalSim_RtcBkp[BackupRegister % 32];
+}
+
+void HAL_RTCEx_BKUPWrite(RTC_HandleTypeDef *hrtc, uint32_t BackupRegister, uint32_t Data)
+{
+    HalSim_RtcBkp[BackupRegister % 32] = Data;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return GPIO_PIN_RESET;
+}
@@ -0,0 +1,237 @@
+/******************************************************************************
+ * @file    i2c_eeprom_sim.c
+ * @brief   Host simulation of an M24256 I2C EEPROM on I2C1 of STM32L476G-Discovery.
+ *
+ *          Implement EEPROM_I2C_IO_xxx() link functions on a RAM backed memory, with
+ *          the rules of the M24256 datasheet:
+ *          - A write addresses one page, bytes past the page end roll over to its start.
+ *          - The write cycle starts at the stop condition, the device doesn't
+ *            acknowledge its address until the end of the cycle.
+ *          - A read runs across pages up to the end of memory.
+ *          Bus transfers add 9 clocks per byte to simulated time, a write cycle lasts
+ *          I2cEepromSim_Timing.Write of simulated time after the transfer.
+ *          A DMA read completes before its start function returns.
+ *
+ *          Power loss: each write cycle is a step. I2cEepromSim_PowerLoss() arms a
+ *          loss at a given step, whose bytes are left with old, new or random values,
+ *          then every later transfer fails until I2cEepromSim_Reset().
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hal_sim.h"
+#include "i2c_eeprom_sim.h"
+#include "stm32l4xx_hal.h"
+
+I2cEepromSim_StatTypeDef   I2cEepromSim_Stat      = {0};
+volatile uint32_t          I2cEepromSim_PowerLost = 0;
+I2cEepromSim_TimingTypeDef I2cEepromSim_Timing    = {
+    .Write    = I2C_EEPROM_SIM_TIME_WRITE,
+    .ClockKhz = I2C_EEPROM_SIM_CLOCK_KHZ,
+};
+
+static uint8_t  I2cEepromSim_Mem[I2C_EEPROM_SIM_SIZE];
+static uint8_t  I2cEepromSim_Blank    = 0; //!< Memory is set to 0xFF
+static uint64_t I2cEepromSim_BusyEnd  = 0; //!< Simulated time of write cycle end
+static uint32_t I2cEepromSim_LossStep = 0; //!< Step of injected power loss, 0 = none
+static uint32_t I2cEepromSim_LossSeed = 1; //!< Random state of torn bytes
+static uint64_t I2cEepromSim_BusNs    = 0; //!< Bus time below 1 us, not yet added
+
+/*!@brief Random byte of torn write, xorshift.
+ */
+static uint8_t I2cEepromSim_Random(void)
+{
+    I2cEepromSim_LossSeed ^= I2cEepromSim_LossSeed << 13;
+    I2cEepromSim_LossSeed ^= I2cEepromSim_LossSeed >> 17;
+    I2cEepromSim_LossSeed ^= I2cEepromSim_LossSeed << 5;
+    return (uint8_t)I2cEepromSim_LossSeed;
+}
+
+/*!@brief Add bus time of a transfer, start & stop conditions included.
+ *
+ * @param bytes : Bytes on bus, address bytes included, 9 clocks each with acknowledge.
+ */
+static void I2cEepromSim_Bus(uint32_t bytes)
+{
+    I2cEepromSim_BusNs += (9ULL * bytes + 2) * 1000000 / I2cEepromSim_Timing.ClockKhz;
+    I2cEepromSim_Stat.BusTime += I2cEepromSim_BusNs / 1000;
+    HalSim_AddTime(I2cEepromSim_BusNs / 1000);
+    I2cEepromSim_BusNs %= 1000;
+}
+
+/*!@brief Address the device, it acknowledges when powered and out of write cycle.
+ */
+static HAL_StatusTypeDef I2cEepromSim_Address(uint16_t DevAddress)
+{
+    if (!I2cEepromSim_Blank)
+    {
+        I2cEepromSim_EraseAll();
+    }
+
+    if ((DevAddress != I2C_EEPROM_SIM_DEV_ADDR) || I2cEepromSim_PowerLost)
+    {
+        I2cEepromSim_Bus(1);
+        return HAL_ERROR;
+    }
+
+    if (HalSim_GetTime() < I2cEepromSim_BusyEnd)
+    {
+        I2cEepromSim_Stat.Nack++;
+        I2cEepromSim_Bus(1);
+        return HAL_ERROR;
+    }
+    return HAL_OK;
+}
+
+/*!@brief Set memory to 0xFF and restore power without counting statistic.
+ */
+void I2cEepromSim_EraseAll(void)
+{
+    memset(I2cEepromSim_Mem, 0xFF, sizeof(I2cEepromSim_Mem));
+    I2cEepromSim_Blank     = 1;
+    I2cEepromSim_BusyEnd   = 0;
+    I2cEepromSim_LossStep  = 0;
+    I2cEepromSim_PowerLost = 0;
+}
+
+void I2cEepromSim_ResetStat(void)
+{
+    memset(&I2cEepromSim_Stat, 0, sizeof(I2cEepromSim_Stat));
+}
+
+/*!@brief Simulate a power cycle of the device, memory content is kept.
+ */
+void I2cEepromSim_Reset(void)
+{
+    I2cEepromSim_PowerLost = 0;
+    I2cEepromSim_BusyEnd   = 0;
+    HalSim_ResetRequest    = 0;
+}
+
+/*!@brief Inject a power loss.
+ *
+ * @param step  : Write cycle to interrupt, counted by I2cEepromSim_Stat.StepCount, 0 to disarm.
+ * @param seed  : Random seed of torn bytes, none zero.
+ */
+void I2cEepromSim_PowerLoss(uint32_t step, uint32_t seed)
+{
+    I2cEepromSim_LossStep = step;
+    I2cEepromSim_LossSeed = seed ? seed : 1;
+}
+
+/*!@brief Direct access to the memory array, for test setup and inspection.
+ */
+uint8_t *I2cEepromSim_Memory(uint32_t addr)
+{
+    if (!I2cEepromSim_Blank)
+    {
+        I2cEepromSim_EraseAll();
+    }
+    return &I2cEepromSim_Mem[addr];
+}
+
+/*! EEPROM_I2C_IO API --------------------------------------------------------*/
+
+void EEPROM_I2C_IO_Init(void)
+{
+}
+
+HAL_StatusTypeDef EEPROM_I2C_IO_WriteData(uint16_t DevAddress, uint16_t MemAddress, uint8_t *pBuffer,
+                                          uint32_t BufferSize)
+{
+    uint32_t page = MemAddress & ~(I2C_EEPROM_SIM_PAGE_SIZE - 1) & (I2C_EEPROM_SIM_SIZE - 1);
+    uint32_t pos  = MemAddress % I2C_EEPROM_SIM_PAGE_SIZE;
+
+    if (I2cEepromSim_Address(DevAddress) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+
+    I2cEepromSim_Bus(3 + BufferSize);
+    I2cEepromSim_Stat.Rollover += (pos + BufferSize > I2C_EEPROM_SIM_PAGE_SIZE);
+    I2cEepromSim_Stat.StepCount++;
+
+    if (I2cEepromSim_Stat.StepCount == I2cEepromSim_LossStep)
+    {
+        for (uint32_t i = 0; i < BufferSize; i++)
+        {
+            uint8_t *byte = &I2cEepromSim_Mem[page + (pos + i) % I2C_EEPROM_SIM_PAGE_SIZE];
+            uint8_t  rand = I2cEepromSim_Random();
+
+            *byte = (rand < 0x60) ? pBuffer[i] : ((rand < 0xC0) ? *byte : I2cEepromSim_Random());
+        }
+        I2cEepromSim_PowerLost = 1;
+        HalSim_ResetRequest    = 1;
+        return HAL_ERROR;
+    }
+
+    for (uint32_t i = 0; i < BufferSize; i++)
+    {
+        I2cEepromSim_Mem[page + (pos + i) % I2C_EEPROM_SIM_PAGE_SIZE] = pBuffer[i];
+    }
+    I2cEepromSim_Stat.WriteCount++;
+    I2cEepromSim_Stat.WriteBytes += BufferSize;
+    I2cEepromSim_Stat.WriteTime += I2cEepromSim_Timing.Write;
+    I2cEepromSim_BusyEnd = HalSim_GetTime() + I2cEepromSim_Timing.Write;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef EEPROM_I2C_IO_ReadData(uint16_t DevAddress, uint16_t MemAddress, uint8_t *pBuffer,
+                                         uint32_t BufferSize)
+{
+    if ((I2cEepromSim_Address(DevAddress) != HAL_OK) ||
+        (MemAddress + BufferSize > I2C_EEPROM_SIM_SIZE))
+    {
+        return HAL_ERROR;
+    }
+
+    // Address write, restart, address read, data.
+    I2cEepromSim_Bus(4 + BufferSize);
+    memcpy(pBuffer, &I2cEepromSim_Mem[MemAddress], BufferSize);
+    I2cEepromSim_Stat.ReadCount++;
+    I2cEepromSim_Stat.ReadBytes += BufferSize;
+    return HAL_OK;
+}
+
+__weak void EEPROM_I2C_IO_ReadCpltCallback(HAL_StatusTypeDef status)
+{
+    UNUSED(status);
+}
+
+HAL_StatusTypeDef EEPROM_I2C_IO_ReadDataDMA(uint16_t DevAddress, uint16_t MemAddress,
+                                            uint8_t *pBuffer, uint32_t BufferSize)
+{
+    if (EEPROM_I2C_IO_ReadData(DevAddress, MemAddress, pBuffer, BufferSize) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+
+    I2cEepromSim_Stat.DmaCount++;
+    EEPROM_I2C_IO_ReadCpltCallback(HAL_OK);
+    return HAL_OK;
+}
+
+/*!@brief A simulated DMA read completes at once, nothing to stop.
+ */
+HAL_StatusTypeDef EEPROM_I2C_IO_AbortDMA(uint16_t DevAddress)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef EEPROM_I2C_IO_IsDeviceReady(uint16_t DevAddress, uint32_t Trials)
+{
+    for (uint32_t i = 0; i < Trials; i++)
+    {
+        if (I2cEepromSim_Address(DevAddress) == HAL_OK)
+        {
+            I2cEepromSim_Bus(1);
+            return HAL_OK;
+        }
+    }
+    return HAL_ERROR;
+}
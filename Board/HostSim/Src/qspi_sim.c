@@ -0,0 +1,723 @@
+/******************************************************************************
+ * @file    qspi_sim.c
+ * @brief   Host simulation of the N25Q128A QSPI NOR flash of STM32L476G-Discovery.
+ *
+ *          Implement BSP_QSPI_xxx() API on a RAM backed memory, with the rules of
+ *          the N25Q128A datasheet:
+ *          - Program clears bits only, a program on non-erased bytes ANDs them.
+ *          - Program is split at 256 bytes page boundary, as BSP_QSPI_Write() does.
+ *          - Erase sets the 4 kB subsector / 64 kB sector containing the address.
+ *          Every blocking operation adds its duration to simulated time, program
+ *          and erase from QspiSim_Timing, read from the bus clock.
+ *
+ *          DMA / interrupt operations cost CPU time to start and to serve the completion
+ *          interrupt, raised by HalSim_SetIrq() at the end of the transfer / program.
+ *          The memory is read or programmed when the transfer ends.
+ *
+ *          Background operations: non-blocking erases and DMA page programs keep the chip
+ *          busy, BSP_QSPI_GetStatus() tells it. A suspend stops the time left after the
+ *          suspend latency, the resume restarts it. Memory is erased / programmed when the
+ *          operation starts, it can't be read before it ends anyway.
+ *
+ *          Power loss: each page program and each erase is a step. QspiSim_PowerLoss()
+ *          arms a loss at a given step, which is left half done (some bits programmed /
+ *          erased, others not), then every later step fails until QspiSim_Reset().
+ *
+ *          Memory-mapped mode: the memory array is at QSPI_BASE, as the window of the
+ *          target. Indirect commands are rejected while mapped, and the mode can't be
+ *          entered while the chip is busy or suspended. Loads through the window aren't
+ *          seen, the code reading it adds their time by QspiSim_MapRead().
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "hal_sim.h"
+#include "qspi_sim.h"
+#include "stm32l476g_discovery_qspi.h"
+
+// clang-format off
+#define SIM_QSPI_SUBSECTORS     (N25Q128A_FLASH_SIZE / N25Q128A_SUBSECTOR_SIZE)
+// clang-format on
+
+QspiSim_StatTypeDef   QspiSim_Stat          = {0};
+volatile uint32_t     QspiSim_PowerLost     = 0;
+uint32_t              QspiSim_PowerLossAddr = 0;
+QspiSim_TimingTypeDef QspiSim_Timing        = {
+    .Program8       = QSPI_SIM_TIME_PROGRAM_8,
+    .SubsectorErase = QSPI_SIM_TIME_SUBSECTOR_ERASE,
+    .SectorErase    = QSPI_SIM_TIME_SECTOR_ERASE,
+    .ChipErase      = QSPI_SIM_TIME_CHIP_ERASE,
+    .Suspend        = QSPI_SIM_TIME_SUSPEND,
+};
+
+static uint8_t * QspiSim_Mem      = NULL; //!< Memory array
+static uint32_t *QspiSim_Erase    = NULL; //!< Erase count of each subsector
+static uint32_t  QspiSim_LossStep = 0;    //!< Step of injected power loss, 0 = none
+static uint32_t  QspiSim_LossSeed = 1;    //!< Random state of torn bits
+static uint64_t  QspiSim_ReadNs   = 0;    //!< Read time below 1 us, not yet added
+static uint8_t   QspiSim_Async    = 0;    //!< DMA transfer / auto polling ongoing
+static uint8_t   QspiSim_Mapped   = 0;    //!< Memory-mapped mode
+static uint32_t  QspiSim_MapNext  = 0;    //!< Address following the last window access
+
+static struct {
+    uint64_t Ready;     //!< Time the background program / erase ends
+    uint64_t Remain;    //!< Time left of the suspended operation
+    uint32_t Addr;      //!< Area of the operation
+    uint32_t Size;
+    uint8_t  Suspended; //!< Operation is suspended
+} QspiSim_Chip = {0};
+
+static struct {
+    uint8_t *Data;  //!< Memory buffer
+    uint32_t Addr;  //!< Flash address
+    uint32_t Size;  //!< Bytes
+    uint8_t  Write; //!< Page program, else read
+} QspiSim_Dma = {0};
+
+/*!@brief Random byte mask of torn program / erase, xorshift.
+ */
+static uint8_t QspiSim_TornMask(void)
+{
+    QspiSim_LossSeed ^= QspiSim_LossSeed << 13;
+    QspiSim_LossSeed ^= QspiSim_LossSeed >> 17;
+    QspiSim_LossSeed ^= QspiSim_LossSeed << 5;
+    return (uint8_t)QspiSim_LossSeed;
+}
+
+static void QspiSim_Busy(uint64_t us)
+{
+    QspiSim_Stat.BusyTime += us;
+    HalSim_AddTime(us);
+}
+
+/*!@brief Count a program / erase step and check injected power loss.
+ *
+ * @return [0] Step runs normally, [1] Power is lost in this step, [-1] Power was lost before.
+ */
+static int QspiSim_Step(uint32_t addr)
+{
+    if (QspiSim_PowerLost)
+    {
+        return -1;
+    }
+
+    QspiSim_Stat.StepCount++;
+    if (QspiSim_Stat.StepCount != QspiSim_LossStep)
+    {
+        return 0;
+    }
+
+    QspiSim_PowerLost     = 1;
+    QspiSim_PowerLossAddr = addr;
+    HalSim_ResetRequest   = 1;
+    return 1;
+}
+
+/*!@brief Time of a transfer on the bus in us, 2 clocks per byte on 4 lines.
+ */
+static uint64_t QspiSim_BusTime(uint32_t size)
+{
+    uint64_t us;
+
+    QspiSim_ReadNs += (QSPI_SIM_READ_OVERHEAD + 2ULL * size) * 1000 / QSPI_SIM_CLOCK_MHZ;
+    us = QspiSim_ReadNs / 1000;
+    QspiSim_ReadNs %= 1000;
+    return us;
+}
+
+static uint8_t QspiSim_Error(const char *msg, uint32_t addr)
+{
+    fprintf(stderr, "QspiSim: %s @ [0x%08X]\n", msg, addr);
+    QspiSim_Stat.ErrorCount++;
+    return QSPI_ERROR;
+}
+
+/*!@brief Check the chip takes a command, it can only read outside of a suspended operation.
+ */
+static uint8_t QspiSim_Check(uint32_t addr, uint32_t size, uint8_t write)
+{
+    if (QspiSim_Mapped)
+    {
+        return QspiSim_Error("Indirect command in memory-mapped mode", addr);
+    }
+    if (QspiSim_Chip.Ready > HalSim_GetTime())
+    {
+        return QspiSim_Error("Chip busy", addr);
+    }
+    if (QspiSim_Chip.Suspended &&
+        (write || ((addr < QspiSim_Chip.Addr + QspiSim_Chip.Size) &&
+                   (addr + size > QspiSim_Chip.Addr))))
+    {
+        return QspiSim_Error(write ? "Program / erase while suspended" : "Read suspended area",
+                             addr);
+    }
+    return QSPI_OK;
+}
+
+/*!@brief Start a background operation, the chip is busy until it ends.
+ */
+static void QspiSim_Start(uint32_t addr, uint32_t size, uint32_t time)
+{
+    QspiSim_Chip.Ready = HalSim_GetTime() + time;
+    QspiSim_Chip.Addr  = addr;
+    QspiSim_Chip.Size  = size;
+    QspiSim_Stat.BusyTime += time;
+}
+
+/*!@brief Erase a block of memory, an erase step.
+ *
+ * @param time  : Erase time in us, half of it if power is lost in this step.
+ */
+static uint8_t QspiSim_EraseBlock(uint32_t addr, uint32_t size, uint32_t *time)
+{
+    int step = QspiSim_Step(addr);
+
+    if (step != 0)
+    {
+        if (step > 0)
+        {
+            for (uint32_t i = 0; i < size; i++)
+            {
+                QspiSim_Mem[addr + i] |= QspiSim_TornMask();
+            }
+            *time /= 2;
+        }
+        else
+        {
+            *time = 0;
+        }
+        return QSPI_ERROR;
+    }
+
+    memset(&QspiSim_Mem[addr], 0xFF, size);
+    for (uint32_t i = 0; i < size / N25Q128A_SUBSECTOR_SIZE; i++)
+    {
+        QspiSim_Erase[addr / N25Q128A_SUBSECTOR_SIZE + i]++;
+    }
+    return QSPI_OK;
+}
+
+/*!@brief Program a page, a program step.
+ *
+ * @param time  : Program time in us, half of it if power is lost in this step.
+ */
+static uint8_t QspiSim_Program(uint32_t addr, const uint8_t *data, uint32_t size, uint32_t *time)
+{
+    int step = QspiSim_Step(addr);
+
+    *time = (size + 7) / 8 * QspiSim_Timing.Program8;
+    if (step != 0)
+    {
+        if (step > 0)
+        {
+            for (uint32_t i = 0; i < size; i++)
+            {
+                QspiSim_Mem[addr + i] &= data[i] | QspiSim_TornMask();
+            }
+            *time /= 2;
+        }
+        else
+        {
+            *time = 0;
+        }
+        return QSPI_ERROR;
+    }
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        QspiSim_Mem[addr + i] &= data[i];
+    }
+    QspiSim_Stat.ProgramCount++;
+    QspiSim_Stat.ProgramBytes += size;
+    return QSPI_OK;
+}
+
+/*!@brief Map the memory array at the memory-mapped window, erased, must be called before
+ *        any BSP_QSPI access.
+ *
+ * @return [0] Success, [-1] Allocation fail.
+ */
+int QspiSim_Init(void)
+{
+    void *ptr = mmap((void *)(uintptr_t)QSPI_BASE, N25Q128A_FLASH_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    QspiSim_Mem   = (ptr == (void *)(uintptr_t)QSPI_BASE) ? ptr : NULL;
+    QspiSim_Erase = malloc(SIM_QSPI_SUBSECTORS * sizeof(uint32_t));
+
+    if ((QspiSim_Mem == NULL) || (QspiSim_Erase == NULL))
+    {
+        fprintf(stderr, "ERROR: QspiSim can't allocate memory\n");
+        return -1;
+    }
+
+    QspiSim_EraseAll();
+    QspiSim_ResetStat();
+    return 0;
+}
+
+/*!@brief Erase entire memory and restore factory state without counting statistic.
+ */
+void QspiSim_EraseAll(void)
+{
+    memset(QspiSim_Mem, 0xFF, N25Q128A_FLASH_SIZE);
+    memset(QspiSim_Erase, 0, SIM_QSPI_SUBSECTORS * sizeof(uint32_t));
+    QspiSim_LossStep  = 0;
+    QspiSim_PowerLost = 0;
+}
+
+void QspiSim_ResetStat(void)
+{
+    memset(&QspiSim_Stat, 0, sizeof(QspiSim_Stat));
+}
+
+/*!@brief Simulate a power cycle of the chip, memory content is kept.
+ */
+void QspiSim_Reset(void)
+{
+    BSP_QSPI_Abort();
+    memset(&QspiSim_Chip, 0, sizeof(QspiSim_Chip));
+    QspiSim_PowerLost   = 0;
+    HalSim_ResetRequest = 0;
+}
+
+/*!@brief Inject a power loss.
+ *
+ * @param step  : Step to interrupt, counted by QspiSim_Stat.StepCount, 0 to disarm.
+ *                e.g. step = StepCount + 1 interrupts the next program / erase.
+ * @param seed  : Random seed of torn bits, none zero.
+ */
+void QspiSim_PowerLoss(uint32_t step, uint32_t seed)
+{
+    QspiSim_LossStep = step;
+    QspiSim_LossSeed = seed ? seed : 1;
+}
+
+/*!@brief Direct access to the memory array, for test setup and inspection.
+ */
+uint8_t *QspiSim_Memory(uint32_t addr)
+{
+    return &QspiSim_Mem[addr];
+}
+
+/*!@brief Get the number of erases of a subsector since QspiSim_EraseAll().
+ */
+uint32_t QspiSim_EraseCount(uint32_t subsector)
+{
+    return QspiSim_Erase[subsector];
+}
+
+/*!@brief Add the time of loads through the memory-mapped window, the CPU stalls meanwhile.
+ *        An access following the previous one continues its read, others start a read
+ *        command.
+ *
+ * @param addr  : Flash address.
+ * @param size  : Bytes.
+ * @return QSPI_OK, QSPI_ERROR out of memory-mapped mode.
+ */
+uint8_t QspiSim_MapRead(uint32_t addr, uint32_t size)
+{
+    uint64_t clocks = 2ULL * size;
+    uint64_t time;
+
+    if (!QspiSim_Mapped)
+    {
+        return QspiSim_Error("Window read out of memory-mapped mode", addr);
+    }
+    if ((addr >= N25Q128A_FLASH_SIZE) || (size > N25Q128A_FLASH_SIZE - addr))
+    {
+        return QspiSim_Error("Window read invalid", addr);
+    }
+
+    if (addr != QspiSim_MapNext)
+    {
+        clocks += QSPI_SIM_READ_OVERHEAD;
+        QspiSim_Stat.MapFetch++;
+    }
+    QspiSim_MapNext = addr + size;
+    QspiSim_ReadNs += clocks * 1000 / QSPI_SIM_CLOCK_MHZ;
+    time = QspiSim_ReadNs / 1000;
+    QspiSim_ReadNs %= 1000;
+
+    QspiSim_Stat.MapBytes += size;
+    QspiSim_Stat.ReadTime += time;
+    HalSim_AddTime(time);
+    return QSPI_OK;
+}
+
+/*! BSP_QSPI API -------------------------------------------------------------*/
+
+/*!@brief Re-init, it leaves memory-mapped mode as the peripheral reset does.
+ */
+uint8_t BSP_QSPI_Init(void)
+{
+    QspiSim_Mapped = 0;
+    return (QspiSim_Mem != NULL) ? QSPI_OK : QSPI_ERROR;
+}
+
+uint8_t BSP_QSPI_DeInit(void)
+{
+    return QSPI_OK;
+}
+
+uint8_t BSP_QSPI_Read(uint8_t *pData, uint32_t ReadAddr, uint32_t Size)
+{
+    if ((ReadAddr >= N25Q128A_FLASH_SIZE) || (Size > N25Q128A_FLASH_SIZE - ReadAddr))
+    {
+        return QspiSim_Error("Read address invalid", ReadAddr);
+    }
+    if (QspiSim_Check(ReadAddr, Size, 0) != QSPI_OK)
+    {
+        return QSPI_ERROR;
+    }
+
+    memcpy(pData, &QspiSim_Mem[ReadAddr], Size);
+
+    uint64_t time = QspiSim_BusTime(Size);
+    QspiSim_Stat.ReadTime += time;
+    HalSim_AddTime(time);
+    QspiSim_Stat.ReadCount++;
+    QspiSim_Stat.ReadBytes += Size;
+    return QSPI_OK;
+}
+
+uint8_t BSP_QSPI_Write(uint8_t *pData, uint32_t WriteAddr, uint32_t Size)
+{
+    uint32_t end_addr = WriteAddr + Size;
+
+    if ((WriteAddr >= N25Q128A_FLASH_SIZE) || (Size > N25Q128A_FLASH_SIZE - WriteAddr))
+    {
+        return QspiSim_Error("Write address invalid", WriteAddr);
+    }
+    if (QspiSim_Check(WriteAddr, Size, 1) != QSPI_OK)
+    {
+        return QSPI_ERROR;
+    }
+
+    // Program page by page.
+    while (WriteAddr < end_addr)
+    {
+        uint32_t size = N25Q128A_PAGE_SIZE - (WriteAddr % N25Q128A_PAGE_SIZE);
+        size          = (size > end_addr - WriteAddr) ? end_addr - WriteAddr : size;
+        uint32_t time = 0;
+
+        HalSim_AddTime(QspiSim_BusTime(size));
+        uint8_t ret = QspiSim_Program(WriteAddr, pData, size, &time);
+        QspiSim_Busy(time);
+        if (ret != QSPI_OK)
+        {
+            return ret;
+        }
+
+        WriteAddr += size;
+        pData += size;
+    }
+
+    return QSPI_OK;
+}
+
+uint8_t BSP_QSPI_Erase_Block(uint32_t BlockAddress)
+{
+    if (BlockAddress >= N25Q128A_FLASH_SIZE)
+    {
+        return QspiSim_Error("Erase address invalid", BlockAddress);
+    }
+    if (QspiSim_Check(BlockAddress, 1, 1) != QSPI_OK)
+    {
+        return QSPI_ERROR;
+    }
+
+    uint32_t time = QspiSim_Timing.SubsectorErase;
+    QspiSim_Stat.SubsectorErase++;
+    uint8_t ret = QspiSim_EraseBlock(BlockAddress & ~(N25Q128A_SUBSECTOR_SIZE - 1),
+                                     N25Q128A_SUBSECTOR_SIZE, &time);
+    QspiSim_Busy(time);
+    return ret;
+}
+
+/*!@brief Start an erase in background.
+ */
+static uint8_t QspiSim_EraseStart(uint32_t addr, uint32_t size, uint32_t time)
+{
+    if (QspiSim_Check(addr, 1, 1) != QSPI_OK)
+    {
+        return QSPI_ERROR;
+    }
+
+    // Without power, the torn erase stops at once.
+    uint8_t ret = QspiSim_EraseBlock(addr, size, &time);
+    if (ret == QSPI_OK)
+    {
+        QspiSim_Start(addr, size, time);
+    }
+    return ret;
+}
+
+uint8_t BSP_QSPI_Erase_Sector(uint32_t Sector)
+{
+    if (Sector >= (uint32_t)(N25Q128A_FLASH_SIZE / N25Q128A_SECTOR_SIZE))
+    {
+        return QSPI_ERROR;
+    }
+
+    QspiSim_Stat.SectorErase++;
+    return QspiSim_EraseStart(Sector * N25Q128A_SECTOR_SIZE, N25Q128A_SECTOR_SIZE,
+                              QspiSim_Timing.SectorErase);
+}
+
+uint8_t BSP_QSPI_Erase_Subsector(uint32_t Subsector)
+{
+    if (Subsector >= (uint32_t)(N25Q128A_FLASH_SIZE / N25Q128A_SUBSECTOR_SIZE))
+    {
+        return QSPI_ERROR;
+    }
+
+    QspiSim_Stat.SubsectorErase++;
+    return QspiSim_EraseStart(Subsector * N25Q128A_SUBSECTOR_SIZE, N25Q128A_SUBSECTOR_SIZE,
+                              QspiSim_Timing.SubsectorErase);
+}
+
+uint8_t BSP_QSPI_Erase_Chip(void)
+{
+    if (QspiSim_Check(0, 1, 1) != QSPI_OK)
+    {
+        return QSPI_ERROR;
+    }
+
+    uint32_t time = QspiSim_Timing.ChipErase;
+    uint8_t  ret  = QspiSim_EraseBlock(0, N25Q128A_FLASH_SIZE, &time);
+    QspiSim_Busy(time);
+    return ret;
+}
+
+/*!@brief Blocking operations end ready, a background one is busy until it ends.
+ */
+uint8_t BSP_QSPI_GetStatus(void)
+{
+    if (QspiSim_Chip.Suspended)
+    {
+        return QSPI_SUSPENDED;
+    }
+    return (QspiSim_Chip.Ready > HalSim_GetTime()) ? QSPI_BUSY : QSPI_OK;
+}
+
+uint8_t BSP_QSPI_GetInfo(QSPI_Info *pInfo)
+{
+    pInfo->FlashSize          = N25Q128A_FLASH_SIZE;
+    pInfo->SectorSize         = N25Q128A_SECTOR_SIZE;
+    pInfo->SectorNumber       = (N25Q128A_FLASH_SIZE / N25Q128A_SECTOR_SIZE);
+    pInfo->EraseSectorSize    = N25Q128A_SUBSECTOR_SIZE;
+    pInfo->EraseSectorsNumber = (N25Q128A_FLASH_SIZE / N25Q128A_SUBSECTOR_SIZE);
+    pInfo->ProgPageSize       = N25Q128A_PAGE_SIZE;
+    pInfo->ProgPagesNumber    = (N25Q128A_FLASH_SIZE / N25Q128A_PAGE_SIZE);
+
+    return QSPI_OK;
+}
+
+/*!@brief Enter memory-mapped mode, the chip must be ready.
+ */
+uint8_t BSP_QSPI_EnableMemoryMappedMode(void)
+{
+    if (QspiSim_Async || QspiSim_Chip.Suspended || (QspiSim_Chip.Ready > HalSim_GetTime()))
+    {
+        return QspiSim_Error("Memory-mapped mode while busy", QspiSim_Chip.Addr);
+    }
+
+    QspiSim_Mapped  = 1;
+    QspiSim_MapNext = N25Q128A_FLASH_SIZE;
+    return QSPI_OK;
+}
+
+uint8_t BSP_QSPI_DisableMemoryMappedMode(void)
+{
+    QspiSim_Mapped = 0;
+    return QSPI_OK;
+}
+
+/*!@brief Copy from the window, timed by QspiSim_MapRead().
+ */
+uint8_t BSP_QSPI_ReadMapped(uint8_t *pData, uint32_t ReadAddr, uint32_t Size)
+{
+    if (QspiSim_MapRead(ReadAddr, Size) != QSPI_OK)
+    {
+        return QSPI_ERROR;
+    }
+
+    memcpy(pData, &QspiSim_Mem[ReadAddr], Size);
+    return QSPI_OK;
+}
+
+/*!@brief Suspend the background operation, the CPU polls the status for the suspend latency
+ *        as BSP_QSPI_SuspendErase() does. The operation may end meanwhile.
+ */
+uint8_t BSP_QSPI_SuspendErase(void)
+{
+    if (QspiSim_Async)
+    {
+        return QspiSim_Error("Suspend while polling", QspiSim_Chip.Addr);
+    }
+    if (QspiSim_Chip.Ready <= HalSim_GetTime())
+    {
+        return QSPI_OK;
+    }
+
+    HalSim_AddTime(QspiSim_Timing.Suspend);
+    if (QspiSim_Chip.Ready > HalSim_GetTime())
+    {
+        QspiSim_Chip.Remain    = QspiSim_Chip.Ready - HalSim_GetTime();
+        QspiSim_Chip.Ready     = 0;
+        QspiSim_Chip.Suspended = 1;
+        QspiSim_Stat.Suspend++;
+    }
+    return QSPI_OK;
+}
+
+uint8_t BSP_QSPI_ResumeErase(void)
+{
+    if (QspiSim_Async)
+    {
+        return QspiSim_Error("Resume while polling", QspiSim_Chip.Addr);
+    }
+    if (QspiSim_Chip.Suspended)
+    {
+        QspiSim_Chip.Ready     = HalSim_GetTime() + QspiSim_Chip.Remain;
+        QspiSim_Chip.Suspended = 0;
+    }
+    return QSPI_OK;
+}
+
+/*! BSP_QSPI DMA / interrupt API ---------------------------------------------*/
+
+/*!@brief Transfer complete interrupt, the page program starts once data are sent.
+ */
+static void QspiSim_DmaIrq(void)
+{
+    uint8_t ret = QSPI_OK;
+
+    HalSim_AddTime(QSPI_SIM_TIME_IRQ);
+    QspiSim_Async = 0;
+
+    if (QspiSim_Dma.Write)
+    {
+        uint32_t time = 0;
+
+        ret = QspiSim_Program(QspiSim_Dma.Addr, QspiSim_Dma.Data, QspiSim_Dma.Size, &time);
+        if (ret == QSPI_OK)
+        {
+            QspiSim_Start(QspiSim_Dma.Addr, QspiSim_Dma.Size, time);
+        }
+    }
+    else
+    {
+        memcpy(QspiSim_Dma.Data, &QspiSim_Mem[QspiSim_Dma.Addr], QspiSim_Dma.Size);
+    }
+
+    BSP_QSPI_TransferCpltCallback(ret);
+}
+
+/*!@brief Status match interrupt.
+ */
+static void QspiSim_ReadyIrq(void)
+{
+    HalSim_AddTime(QSPI_SIM_TIME_IRQ);
+    QspiSim_Async = 0;
+    BSP_QSPI_TransferCpltCallback(QSPI_OK);
+}
+
+/*!@brief Start a DMA transfer, it ends after its bus time.
+ */
+static uint8_t QspiSim_StartDma(uint8_t *pData, uint32_t Addr, uint32_t Size, uint8_t Write)
+{
+    uint64_t time = QspiSim_BusTime(Size);
+
+    if (QspiSim_Async)
+    {
+        return QSPI_BUSY;
+    }
+
+    QspiSim_Dma.Data  = pData;
+    QspiSim_Dma.Addr  = Addr;
+    QspiSim_Dma.Size  = Size;
+    QspiSim_Dma.Write = Write;
+    QspiSim_Async     = 1;
+    QspiSim_Stat.DmaCount++;
+
+    HalSim_AddTime(QSPI_SIM_TIME_DMA_SETUP);
+    HalSim_SetIrq(HalSim_GetTime() + time, QspiSim_DmaIrq);
+    return QSPI_OK;
+}
+
+uint8_t BSP_QSPI_Read_DMA(uint8_t *pData, uint32_t ReadAddr, uint32_t Size)
+{
+    if ((ReadAddr >= N25Q128A_FLASH_SIZE) || (Size > N25Q128A_FLASH_SIZE - ReadAddr) ||
+        (Size == 0) || (Size > 0xFFFF))
+    {
+        return QspiSim_Error("DMA read invalid", ReadAddr);
+    }
+    if (!QspiSim_Async && (QspiSim_Check(ReadAddr, Size, 0) != QSPI_OK))
+    {
+        return QSPI_ERROR;
+    }
+
+    uint8_t ret = QspiSim_StartDma(pData, ReadAddr, Size, 0);
+    if (ret == QSPI_OK)
+    {
+        QspiSim_Stat.ReadCount++;
+        QspiSim_Stat.ReadBytes += Size;
+    }
+    return ret;
+}
+
+uint8_t BSP_QSPI_WritePage_DMA(uint8_t *pData, uint32_t WriteAddr, uint32_t Size)
+{
+    if ((WriteAddr >= N25Q128A_FLASH_SIZE) || (Size == 0) ||
+        (Size > N25Q128A_PAGE_SIZE - (WriteAddr % N25Q128A_PAGE_SIZE)))
+    {
+        return QspiSim_Error("DMA page program invalid", WriteAddr);
+    }
+    if (!QspiSim_Async && (QspiSim_Check(WriteAddr, Size, 1) != QSPI_OK))
+    {
+        return QSPI_ERROR;
+    }
+
+    return QspiSim_StartDma(pData, WriteAddr, Size, 1);
+}
+
+uint8_t BSP_QSPI_AutoPollingMemReady_IT(void)
+{
+    uint64_t now = HalSim_GetTime();
+
+    if (QspiSim_Async)
+    {
+        return QSPI_BUSY;
+    }
+    if (QspiSim_Mapped)
+    {
+        return QspiSim_Error("Auto polling in memory-mapped mode", 0);
+    }
+
+    QspiSim_Async = 1;
+    QspiSim_Stat.DmaCount++;
+    HalSim_AddTime(QSPI_SIM_TIME_DMA_SETUP);
+    HalSim_SetIrq((QspiSim_Chip.Ready > now) ? QspiSim_Chip.Ready : now, QspiSim_ReadyIrq);
+    return QSPI_OK;
+}
+
+/*!@brief Abort the DMA transfer / auto polling, and leave memory-mapped mode as
+ *        HAL_QSPI_Abort() does.
+ */
+uint8_t BSP_QSPI_Abort(void)
+{
+    HalSim_ClearIrq(QspiSim_DmaIrq);
+    HalSim_ClearIrq(QspiSim_ReadyIrq);
+    QspiSim_Async  = 0;
+    QspiSim_Mapped = 0;
+    return QSPI_OK;
+}
@@ -0,0 +1,160 @@
+/******************************************************************************
+ * @file    rtos_sim.c
+ * @brief   Host simulation of the CMSIS-RTOS API subset used by firmware modules.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cmsis_os.h"
+#include "hal_sim.h"
+
+/*!@brief The caller is a task, the scheduler always runs.
+ */
+int32_t osKernelRunning(void)
+{
+    return 1;
+}
+
+/*!@brief Create a semaphore with count tokens available, like FreeRTOS does.
+ */
+osSemaphoreId osSemaphoreCreate(const osSemaphoreDef_t *semaphore_def, int32_t count)
+{
+    osSemaphoreId sem = malloc(sizeof(*sem));
+
+    if (sem != NULL)
+    {
+        sem->Count = count;
+        sem->Max   = count;
+    }
+    return sem;
+}
+
+/*!@brief Take a token, sleep until an interrupt releases one or timeout.
+ */
+int32_t osSemaphoreWait(osSemaphoreId semaphore_id, uint32_t millisec)
+{
+    uint64_t until = HalSim_GetTime() + (uint64_t)millisec * 1000;
+
+    if (semaphore_id == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    while (semaphore_id->Count == 0)
+    {
+        if ((millisec != osWaitForever) && (HalSim_GetTime() >= until))
+        {
+            return osErrorOS;
+        }
+        if (!HalSim_Idle((millisec == osWaitForever) ? UINT64_MAX : until) &&
+            (millisec == osWaitForever))
+        {
+            // Nothing can release it any more.
+            return osErrorOS;
+        }
+    }
+
+    semaphore_id->Count--;
+    return osOK;
+}
+
+osStatus osSemaphoreRelease(osSemaphoreId semaphore_id)
+{
+    if (semaphore_id == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    if (semaphore_id->Count < semaphore_id->Max)
+    {
+        semaphore_id->Count++;
+    }
+    return osOK;
+}
+
+osMutexId osMutexCreate(const osMutexDef_t *mutex_def)
+{
+    osMutexId mutex = malloc(sizeof(*mutex));
+
+    if (mutex != NULL)
+    {
+        mutex->Held = 0;
+    }
+    return mutex;
+}
+
+/*!@brief Take the mutex. Held, only the single task holds it: a try fails, a wait would
+ *        deadlock on target and aborts.
+ */
+osStatus osMutexWait(osMutexId mutex_id, uint32_t millisec)
+{
+    if (mutex_id == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    if (mutex_id->Held)
+    {
+        if (millisec == 0)
+        {
+            return osErrorOS;
+        }
+        fprintf(stderr, "Mutex deadlock: waited by its holder\n");
+        abort();
+    }
+    mutex_id->Held = 1;
+    return osOK;
+}
+
+osStatus osMutexRelease(osMutexId mutex_id)
+{
+    if ((mutex_id == NULL) || !mutex_id->Held)
+    {
+        return osErrorOS;
+    }
+
+    mutex_id->Held = 0;
+    return osOK;
+}
+
+/*!@brief Id of the single task, not NULL.
+ */
+osThreadId osThreadGetId(void)
+{
+    static uint32_t task = 0;
+
+    return &task;
+}
+
+/*!@brief Nothing preempts the single task.
+ */
+osStatus osThreadSuspendAll(void)
+{
+    return osOK;
+}
+
+osStatus osThreadResumeAll(void)
+{
+    return osOK;
+}
+
+/*!@brief No other task waits a signal.
+ */
+int32_t osSignalSet(osThreadId thread_id, int32_t signals)
+{
+    return 0;
+}
+
+/*!@brief A signal could only come from another task, the wait times out at once.
+ */
+osEvent osSignalWait(int32_t signals, uint32_t millisec)
+{
+    osEvent event = {.status = osEventTimeout};
+
+    return event;
+}
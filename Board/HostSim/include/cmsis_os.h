@@ -0,0 +1,78 @@
+/******************************************************************************
+ * @file    cmsis_os.h
+ * @brief   Host simulation of the CMSIS-RTOS API subset used by firmware modules.
+ *
+ *          There is a single task, the caller. A semaphore wait sleeps in HalSim_Idle()
+ *          and serves simulated interrupts until one releases it, or it times out.
+ *          Thread functions only tell the caller is that task, signals are not simulated.
+ *          A mutex can only be held by that task, waiting it again would never return.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef CMSIS_OS_SIM_H_
+#define CMSIS_OS_SIM_H_
+
+#include "stdint.h"
+
+// clang-format off
+#define osWaitForever           0xFFFFFFFF  //!< Wait forever timeout value
+// clang-format on
+
+typedef enum {
+    osOK             = 0,
+    osEventSignal    = 0x08,
+    osEventTimeout   = 0x40,
+    osErrorParameter = 0x80,
+    osErrorOS        = 0xFF,
+} osStatus;
+
+typedef void *osThreadId;
+
+typedef struct {
+    osStatus status;
+    union {
+        uint32_t v;
+        int32_t  signals;
+    } value;
+} osEvent;
+
+typedef struct os_semaphore_cb {
+    int32_t Count; //!< Tokens available
+    int32_t Max;   //!< Tokens at creation, a binary semaphore has 1
+} *osSemaphoreId;
+
+typedef struct os_semaphore_def {
+    uint32_t dummy;
+} osSemaphoreDef_t;
+
+#define osSemaphoreDef(name) const osSemaphoreDef_t os_semaphore_def_##name = {0}
+#define osSemaphore(name) &os_semaphore_def_##name
+
+typedef struct os_mutex_cb {
+    uint8_t Held;
+} *osMutexId;
+
+typedef struct os_mutex_def {
+    uint32_t dummy;
+} osMutexDef_t;
+
+#define osMutexDef(name) const osMutexDef_t os_mutex_def_##name = {0}
+#define osMutex(name) &os_mutex_def_##name
+
+int32_t       osKernelRunning(void);
+osSemaphoreId osSemaphoreCreate(const osSemaphoreDef_t *semaphore_def, int32_t count);
+int32_t       osSemaphoreWait(osSemaphoreId semaphore_id, uint32_t millisec);
+osStatus      osSemaphoreRelease(osSemaphoreId semaphore_id);
+osMutexId     osMutexCreate(const osMutexDef_t *mutex_def);
+osStatus      osMutexWait(osMutexId mutex_id, uint32_t millisec);
+osStatus      osMutexRelease(osMutexId mutex_id);
+osThreadId    osThreadGetId(void);
+osStatus      osThreadSuspendAll(void);
+osStatus      osThreadResumeAll(void);
+int32_t       osSignalSet(osThreadId thread_id, int32_t signals);
+osEvent       osSignalWait(int32_t signals, uint32_t millisec);
+
+#endif /* CMSIS_OS_SIM_H_ */
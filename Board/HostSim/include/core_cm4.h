@@ -0,0 +1,35 @@
+/******************************************************************************
+ * @file    core_cm4.h
+ * @brief   Host simulation of the Cortex-M4 core header.
+ *          Wraps CMSIS core_cm4.h, __get_IPSR() reads the simulated exception
+ *          number instead of the IPSR register, non-zero while HalSim_Idle()
+ *          runs an interrupt handler. PRIMASK is a variable, interrupts are only
+ *          served by HalSim_Idle(), which code running masked doesn't call.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef HOSTSIM_CORE_CM4_H_
+#define HOSTSIM_CORE_CM4_H_
+
+#define __get_IPSR    __get_IPSR_core
+#define __get_PRIMASK __get_PRIMASK_core
+#define __set_PRIMASK __set_PRIMASK_core
+#define __disable_irq __disable_irq_core
+#define __enable_irq  __enable_irq_core
+#include_next "core_cm4.h"
+#undef __get_IPSR
+#undef __get_PRIMASK
+#undef __set_PRIMASK
+#undef __disable_irq
+#undef __enable_irq
+
+uint32_t __get_IPSR(void);
+uint32_t __get_PRIMASK(void);
+void     __set_PRIMASK(uint32_t priMask);
+void     __disable_irq(void);
+void     __enable_irq(void);
+
+#endif /* HOSTSIM_CORE_CM4_H_ */
@@ -0,0 +1,76 @@
+/******************************************************************************
+ * @file    flash_sim.h
+ * @brief   Host simulation of STM32L476 dual bank flash controller.
+ *
+ *          Main flash, system memory and peripheral registers are mapped to their
+ *          target addresses in the host process, so firmware reading flash with
+ *          HWREG32() or through CMSIS register structures runs unmodified on host.
+ *          HAL_FLASH_xxx() API is implemented on top of the RAM backed memory.
+ *
+ *          Operation latency is set at run time by FlashSim_Timing, and a power
+ *          loss can be injected at any program / erase step by FlashSim_PowerLoss().
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef FLASH_SIM_H_
+#define FLASH_SIM_H_
+
+#include "stdint.h"
+
+// clang-format off
+/*!@defgroup FLASH_SIM_TIMING Flash operation time in us, typical value of STM32L476 datasheet.
+ *           Default of FlashSim_Timing.
+ */
+#define FLASH_SIM_TIME_DWORD            82      //!< Program 1x double word, standard mode
+#define FLASH_SIM_TIME_ROW              1910    //!< Program 1x row (32x double word), fast mode
+#define FLASH_SIM_TIME_PAGE_ERASE       22020   //!< Erase 1x page
+#define FLASH_SIM_TIME_MASS_ERASE       22130   //!< Mass erase 1x bank
+
+/*!@defgroup FLASH_SIM_TIMING_MAX Flash operation time in us, maximum value of STM32L476 datasheet.
+ */
+#define FLASH_SIM_TIME_DWORD_MAX        91
+#define FLASH_SIM_TIME_ROW_MAX          2000
+#define FLASH_SIM_TIME_PAGE_ERASE_MAX   24470
+#define FLASH_SIM_TIME_MASS_ERASE_MAX   24590
+// clang-format on
+
+/*!@struct FlashSim_TimingTypeDef
+ *          Flash operation time in us.
+ */
+typedef struct FlashSim_TimingTypeDef {
+    uint32_t Dword;     //!< Program 1x double word, standard mode
+    uint32_t Row;       //!< Program 1x row, fast mode
+    uint32_t PageErase; //!< Erase 1x page
+    uint32_t MassErase; //!< Mass erase 1x bank
+} FlashSim_TimingTypeDef;
+
+/*!@struct FlashSim_StatTypeDef
+ *          Flash operation statistic.
+ */
+typedef struct FlashSim_StatTypeDef {
+    uint32_t UnlockCount;    //!< Number of HAL_FLASH_Unlock() calls
+    uint32_t DwordCount;     //!< Number of double words programmed in standard mode
+    uint32_t RowCount;       //!< Number of rows programmed in fast mode
+    uint32_t PageErase;      //!< Number of pages erased
+    uint32_t MassErase;      //!< Number of banks mass erased
+    uint32_t ErrorCount;     //!< Number of rejected operations
+    uint32_t StepCount;      //!< Number of program / erase steps, see FlashSim_PowerLoss()
+    uint64_t BusyTime;       //!< Flash busy time in us
+    uint64_t WaitTime;       //!< Time operations waited for a background erase in us
+} FlashSim_StatTypeDef;
+
+extern FlashSim_StatTypeDef   FlashSim_Stat;
+extern FlashSim_TimingTypeDef FlashSim_Timing;
+extern volatile uint32_t      FlashSim_PowerLost;     //!< Set when injected power loss happens
+extern uint32_t               FlashSim_PowerLossAddr; //!< Address of the interrupted step
+
+int  FlashSim_Init(void);
+void FlashSim_EraseAll(void);
+void FlashSim_ResetStat(void);
+void FlashSim_Reset(void);
+void FlashSim_PowerLoss(uint32_t step, uint32_t seed);
+
+#endif /* FLASH_SIM_H_ */
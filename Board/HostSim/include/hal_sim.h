@@ -0,0 +1,39 @@
+/******************************************************************************
+ * @file    hal_sim.h
+ * @brief   Host simulation of STM32L4 HAL system services.
+ *          Simulated time base, reset request and UART stubs, so that firmware
+ *          modules can be built and benchmarked on host.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef HAL_SIM_H_
+#define HAL_SIM_H_
+
+#include "stdint.h"
+
+// clang-format off
+#define HALSIM_IRQ_NUM          4           //!< Interrupts pending at a time
+// clang-format on
+
+typedef void (*HalSim_UartTxHookTypeDef)(const uint8_t *buf, uint16_t len);
+typedef void (*HalSim_IrqTypeDef)(void);
+
+extern volatile uint32_t        HalSim_ResetRequest; //!< Set by HAL_NVIC_SystemReset / option launch
+extern HalSim_UartTxHookTypeDef HalSim_UartTxHook;   //!< Receive UART TX data, NULL to drop
+extern uint64_t                 HalSim_IdleTime;     //!< Time slept in HalSim_Idle() in us
+
+uint64_t HalSim_GetTime(void);
+void     HalSim_AddTime(uint64_t us);
+double   HalSim_GetCpuTime(void);
+void     HalSim_Seed(uint32_t seed);
+uint32_t HalSim_Rand(void);
+int      HalSim_SetIrq(uint64_t time, HalSim_IrqTypeDef handler);
+void     HalSim_ClearIrq(HalSim_IrqTypeDef handler);
+int      HalSim_Idle(uint64_t until);
+void     HalSim_UartRxPush(uint8_t c);
+uint16_t HalSim_UartRxHead(void);
+
+#endif /* HAL_SIM_H_ */
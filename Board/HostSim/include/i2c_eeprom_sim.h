@@ -0,0 +1,65 @@
+/******************************************************************************
+ * @file    i2c_eeprom_sim.h
+ * @brief   Host simulation of an M24256 I2C EEPROM on I2C1 of STM32L476G-Discovery.
+ *
+ *          EEPROM_I2C_IO_xxx() link functions are implemented on a RAM backed 32 kB
+ *          memory, so the NVRAM device on top runs unmodified on host. Device rules
+ *          apply: a write rolls over at the end of its 64 bytes page, then the device
+ *          doesn't acknowledge its address during the write cycle.
+ *
+ *          Bus transfer and write cycle add to simulated time, a power loss can be
+ *          injected at any write cycle by I2cEepromSim_PowerLoss().
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef I2C_EEPROM_SIM_H_
+#define I2C_EEPROM_SIM_H_
+
+#include "stdint.h"
+
+// clang-format off
+#define I2C_EEPROM_SIM_DEV_ADDR         0xA0        //!< Device address, E2..E0 tied low
+#define I2C_EEPROM_SIM_SIZE             0x8000      //!< 256 Kbit
+#define I2C_EEPROM_SIM_PAGE_SIZE        64
+#define I2C_EEPROM_SIM_TIME_WRITE       4000        //!< Write cycle in us, below the tW maximum
+#define I2C_EEPROM_SIM_TIME_WRITE_MAX   5000        //!< tW of M24256 datasheet
+#define I2C_EEPROM_SIM_CLOCK_KHZ        400         //!< I2C1 fast mode
+// clang-format on
+
+/*!@struct I2cEepromSim_TimingTypeDef
+ */
+typedef struct I2cEepromSim_TimingTypeDef {
+    uint32_t Write;    //!< Write cycle in us
+    uint32_t ClockKhz; //!< Bus clock
+} I2cEepromSim_TimingTypeDef;
+
+/*!@struct I2cEepromSim_StatTypeDef
+ *          Operation statistic.
+ */
+typedef struct I2cEepromSim_StatTypeDef {
+    uint32_t ReadCount;  //!< Number of read transfers
+    uint64_t ReadBytes;  //!< Bytes read
+    uint32_t DmaCount;   //!< Number of read transfers by DMA
+    uint32_t WriteCount; //!< Number of write cycles
+    uint64_t WriteBytes; //!< Bytes written
+    uint32_t Rollover;   //!< Writes rolled over the page end
+    uint32_t Nack;       //!< Address not acknowledged, device in write cycle
+    uint32_t StepCount;  //!< Number of write cycles, see I2cEepromSim_PowerLoss()
+    uint64_t BusTime;    //!< Bus transfer time in us
+    uint64_t WriteTime;  //!< Write cycle time in us
+} I2cEepromSim_StatTypeDef;
+
+extern I2cEepromSim_StatTypeDef   I2cEepromSim_Stat;
+extern I2cEepromSim_TimingTypeDef I2cEepromSim_Timing;
+extern volatile uint32_t          I2cEepromSim_PowerLost; //!< Set when injected power loss happens
+
+void     I2cEepromSim_EraseAll(void);
+void     I2cEepromSim_ResetStat(void);
+void     I2cEepromSim_Reset(void);
+void     I2cEepromSim_PowerLoss(uint32_t step, uint32_t seed);
+uint8_t *I2cEepromSim_Memory(uint32_t addr);
+
+#endif /* I2C_EEPROM_SIM_H_ */
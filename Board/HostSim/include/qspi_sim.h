@@ -0,0 +1,100 @@
+/******************************************************************************
+ * @file    qspi_sim.h
+ * @brief   Host simulation of the N25Q128A QSPI NOR flash of STM32L476G-Discovery.
+ *
+ *          BSP_QSPI_xxx() API of stm32l476g_discovery_qspi.c is implemented on a
+ *          RAM backed 16 MB memory, so modules on top of the BSP run unmodified on
+ *          host. NOR rules apply: program only clears bits, erase sets a whole
+ *          subsector / sector to 0xFF.
+ *
+ *          Operation latency is set at run time by QspiSim_Timing, and a power
+ *          loss can be injected at any program / erase step by QspiSim_PowerLoss().
+ *
+ *          The memory is at QSPI_BASE, read through the memory-mapped window once
+ *          BSP_QSPI_EnableMemoryMappedMode() is called, QspiSim_MapRead() adds the time.
+ *
+ *          Erases started by BSP_QSPI_Erase_Sector() / BSP_QSPI_Erase_Subsector() and
+ *          page programs by DMA run in background, the chip is busy until they end and
+ *          can be suspended to read other areas. Commands the chip would ignore or answer
+ *          with garbage, e.g. a read while busy or of the suspended area, are rejected.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef QSPI_SIM_H_
+#define QSPI_SIM_H_
+
+#include "stdint.h"
+
+// clang-format off
+/*!@defgroup QSPI_SIM_TIMING Operation time in us, typical value of N25Q128A datasheet.
+ *           Default of QspiSim_Timing.
+ */
+#define QSPI_SIM_TIME_PROGRAM_8         15          //!< Program 8 bytes, 0.5 ms per 256 bytes page
+#define QSPI_SIM_TIME_SUBSECTOR_ERASE   250000      //!< Erase 1x 4 kB subsector
+#define QSPI_SIM_TIME_SECTOR_ERASE      700000      //!< Erase 1x 64 kB sector
+#define QSPI_SIM_TIME_CHIP_ERASE        170000000   //!< Bulk erase
+#define QSPI_SIM_TIME_SUSPEND           15          //!< Program / erase suspend latency
+
+/*!@defgroup QSPI_SIM_TIMING_MAX Operation time in us, maximum value of N25Q128A datasheet.
+ */
+#define QSPI_SIM_TIME_PROGRAM_8_MAX     157         //!< 5 ms per 256 bytes page
+#define QSPI_SIM_TIME_SUBSECTOR_ERASE_MAX 800000
+#define QSPI_SIM_TIME_SECTOR_ERASE_MAX  3000000
+#define QSPI_SIM_TIME_CHIP_ERASE_MAX    250000000
+#define QSPI_SIM_TIME_SUSPEND_MAX       30
+
+#define QSPI_SIM_CLOCK_MHZ              40          //!< QSPI clock, 80 MHz / (ClockPrescaler + 1)
+#define QSPI_SIM_READ_OVERHEAD          24          //!< Clocks of quad read command, address & dummy
+#define QSPI_SIM_TIME_DMA_SETUP         4           //!< CPU time to start a DMA / interrupt operation
+#define QSPI_SIM_TIME_IRQ               2           //!< CPU time of its completion interrupt
+// clang-format on
+
+/*!@struct QspiSim_TimingTypeDef
+ *          Operation time in us.
+ */
+typedef struct QspiSim_TimingTypeDef {
+    uint32_t Program8;       //!< Program 8 bytes of a page
+    uint32_t SubsectorErase; //!< Erase 1x subsector
+    uint32_t SectorErase;    //!< Erase 1x sector
+    uint32_t ChipErase;      //!< Bulk erase
+    uint32_t Suspend;        //!< Suspend latency, the operation still runs meanwhile
+} QspiSim_TimingTypeDef;
+
+/*!@struct QspiSim_StatTypeDef
+ *          Operation statistic.
+ */
+typedef struct QspiSim_StatTypeDef {
+    uint32_t ReadCount;      //!< Number of read commands
+    uint64_t ReadBytes;      //!< Bytes read
+    uint32_t ProgramCount;   //!< Number of page program commands
+    uint64_t ProgramBytes;   //!< Bytes programmed
+    uint32_t SubsectorErase; //!< Number of subsectors erased
+    uint32_t SectorErase;    //!< Number of sectors erased
+    uint32_t ErrorCount;     //!< Number of rejected operations
+    uint32_t StepCount;      //!< Number of program / erase steps, see QspiSim_PowerLoss()
+    uint64_t BusyTime;       //!< Program / erase time in us
+    uint64_t ReadTime;       //!< Read transfer time in us
+    uint32_t DmaCount;       //!< Number of DMA / interrupt operations
+    uint32_t Suspend;        //!< Number of program / erase suspends
+    uint32_t MapFetch;       //!< Number of read commands of the memory-mapped window
+    uint64_t MapBytes;       //!< Bytes read through the memory-mapped window
+} QspiSim_StatTypeDef;
+
+extern QspiSim_StatTypeDef   QspiSim_Stat;
+extern QspiSim_TimingTypeDef QspiSim_Timing;
+extern volatile uint32_t     QspiSim_PowerLost;     //!< Set when injected power loss happens
+extern uint32_t              QspiSim_PowerLossAddr; //!< Address of the interrupted step
+
+int       QspiSim_Init(void);
+void      QspiSim_EraseAll(void);
+void      QspiSim_ResetStat(void);
+void      QspiSim_Reset(void);
+void      QspiSim_PowerLoss(uint32_t step, uint32_t seed);
+uint8_t * QspiSim_Memory(uint32_t addr);
+uint32_t  QspiSim_EraseCount(uint32_t subsector);
+uint8_t   QspiSim_MapRead(uint32_t addr, uint32_t size);
+
+#endif /* QSPI_SIM_H_ */
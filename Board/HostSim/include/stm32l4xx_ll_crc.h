@@ -0,0 +1,49 @@
+/******************************************************************************
+ * @file    stm32l4xx_ll_crc.h
+ * @brief   Host simulation of STM32L4 CRC LL driver.
+ *
+ *          The LL driver is inline register access, which only stores the data on
+ *          host. This header is found before the one in lib/STM32L4xx_HAL_Driver by
+ *          the host build, and runs the calculation in crc_sim.c on the simulated
+ *          CRC registers (CR, INIT, POL, DR), shared with HAL_CRC_xxx() API as
+ *          on the real unit.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef __STM32L4xx_LL_CRC_H
+#define __STM32L4xx_LL_CRC_H
+
+#include "stm32l4xx.h"
+
+// clang-format off
+#define LL_CRC_POLYLENGTH_32B           0x00000000U
+#define LL_CRC_POLYLENGTH_16B           CRC_CR_POLYSIZE_0
+#define LL_CRC_POLYLENGTH_8B            CRC_CR_POLYSIZE_1
+#define LL_CRC_POLYLENGTH_7B            (CRC_CR_POLYSIZE_1 | CRC_CR_POLYSIZE_0)
+#define LL_CRC_INDATA_REVERSE_NONE      0x00000000U
+#define LL_CRC_INDATA_REVERSE_BYTE      CRC_CR_REV_IN_0
+#define LL_CRC_INDATA_REVERSE_HALFWORD  CRC_CR_REV_IN_1
+#define LL_CRC_INDATA_REVERSE_WORD      CRC_CR_REV_IN
+#define LL_CRC_OUTDATA_REVERSE_NONE     0x00000000U
+#define LL_CRC_OUTDATA_REVERSE_BIT      CRC_CR_REV_OUT
+#define LL_CRC_DEFAULT_CRC32_POLY       0x04C11DB7U
+#define LL_CRC_DEFAULT_CRC_INITVALUE    0xFFFFFFFFU
+// clang-format on
+
+void     LL_CRC_ResetCRCCalculationUnit(CRC_TypeDef *CRCx);
+void     LL_CRC_SetPolynomialSize(CRC_TypeDef *CRCx, uint32_t PolySize);
+void     LL_CRC_SetPolynomialCoef(CRC_TypeDef *CRCx, uint32_t PolynomCoef);
+void     LL_CRC_SetInitialData(CRC_TypeDef *CRCx, uint32_t InitCrc);
+void     LL_CRC_SetInputDataReverseMode(CRC_TypeDef *CRCx, uint32_t ReverseMode);
+void     LL_CRC_SetOutputDataReverseMode(CRC_TypeDef *CRCx, uint32_t ReverseMode);
+void     LL_CRC_FeedData32(CRC_TypeDef *CRCx, uint32_t InData);
+void     LL_CRC_FeedData16(CRC_TypeDef *CRCx, uint16_t InData);
+void     LL_CRC_FeedData8(CRC_TypeDef *CRCx, uint8_t InData);
+uint32_t LL_CRC_ReadData32(CRC_TypeDef *CRCx);
+uint16_t LL_CRC_ReadData16(CRC_TypeDef *CRCx);
+uint8_t  LL_CRC_ReadData8(CRC_TypeDef *CRCx);
+
+#endif /* __STM32L4xx_LL_CRC_H */
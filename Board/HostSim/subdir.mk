@@ -0,0 +1,4 @@
+C_SOURCES += $(wildcard Board/HostSim/Src/*.c)
+
+C_INCLUDES += \
+-IBoard/HostSim/include
@@ -57,6 +57,7 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "cli.h"
+#include "dfu_console.h"
 #include "stdio.h"
 #include "stm32l476g_discovery.h"
 #include "usart.h"
@@ -88,6 +89,7 @@ osThreadId BoardDriver_Handle = NULL;
 osThreadId Cli_Handle = NULL;
 osThreadId SimpleUI_Handle = NULL;
 osThreadId UsbLogger_Handle = NULL;
+osThreadId QspiIo_Handle = NULL;
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN FunctionPrototypes */
@@ -95,6 +97,7 @@ extern void CLI_Task(void const *arguments);
 extern void UsbLogger_Task(void const *arguments);
 extern void BoardDriver_Task(void const *arguments);
 extern void SimpleUI_Task(void const *arguments);
+extern void Bsp_Qspi_Task(void const *arguments);
 
 /* USER CODE END FunctionPrototypes */
 
@@ -143,6 +146,9 @@ void MX_FREERTOS_Init(void)
     osThreadDef(UsbLogger, UsbLogger_Task, osPriorityHigh, 0, 128);
     UsbLogger_Handle = osThreadCreate(osThread(UsbLogger), NULL);
 
+    osThreadDef(QspiIo, Bsp_Qspi_Task, osPriorityAboveNormal, 0, 256);
+    QspiIo_Handle = osThreadCreate(osThread(QspiIo), NULL);
+
     /* USER CODE END RTOS_THREADS */
 
     /* USER CODE BEGIN RTOS_QUEUES */
@@ -160,6 +166,9 @@ void MX_FREERTOS_Init(void)
 /* USER CODE END Header_StartDefaultTask */
 void StartDefaultTask(void const *argument)
 {
+    // Reset to first task, tick starts at HAL_Init() just after reset.
+    Dfu_BootTime = HAL_GetTick();
+
     /* init code for USB_DEVICE */
     osDelay(1000);
     BSP_LED_Init(LED_RED);
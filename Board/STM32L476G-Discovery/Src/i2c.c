@@ -56,6 +56,7 @@
 
 I2C_HandleTypeDef hi2c1;
 I2C_HandleTypeDef hi2c2;
+DMA_HandleTypeDef hdma_i2c1_rx;
 
 /* I2C1 init function */
 void MX_I2C1_Init(void)
@@ -143,6 +144,24 @@ void HAL_I2C_MspInit(I2C_HandleTypeDef *i2cHandle)
         /* I2C1 clock enable */
         __HAL_RCC_I2C1_CLK_ENABLE();
 
+        /* I2C1 DMA Init */
+        /* I2C1_RX Init */
+        hdma_i2c1_rx.Instance                 = DMA2_Channel6;
+        hdma_i2c1_rx.Init.Request             = DMA_REQUEST_5;
+        hdma_i2c1_rx.Init.Direction           = DMA_PERIPH_TO_MEMORY;
+        hdma_i2c1_rx.Init.PeriphInc           = DMA_PINC_DISABLE;
+        hdma_i2c1_rx.Init.MemInc              = DMA_MINC_ENABLE;
+        hdma_i2c1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+        hdma_i2c1_rx.Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+        hdma_i2c1_rx.Init.Mode                = DMA_NORMAL;
+        hdma_i2c1_rx.Init.Priority            = DMA_PRIORITY_LOW;
+        if (HAL_DMA_Init(&hdma_i2c1_rx) != HAL_OK)
+        {
+            Error_Handler();
+        }
+
+        __HAL_LINKDMA(i2cHandle, hdmarx, hdma_i2c1_rx);
+
         /* I2C1 interrupt Init */
         HAL_NVIC_SetPriority(I2C1_EV_IRQn, 5, 0);
         HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
@@ -201,6 +220,9 @@ void HAL_I2C_MspDeInit(I2C_HandleTypeDef *i2cHandle)
         */
         HAL_GPIO_DeInit(GPIOB, I2C1_SCL_Pin | I2C1_SDA_Pin);
 
+        /* I2C1 DMA DeInit */
+        HAL_DMA_DeInit(i2cHandle->hdmarx);
+
         /* I2C1 interrupt Deinit */
         HAL_NVIC_DisableIRQ(I2C1_EV_IRQn);
         HAL_NVIC_DisableIRQ(I2C1_ER_IRQn);
@@ -233,6 +255,86 @@ void HAL_I2C_MspDeInit(I2C_HandleTypeDef *i2cHandle)
 
 /* USER CODE BEGIN 1 */
 
+/*! Link functions of the I2C EEPROM on I2C1, declared by stm32l476g_discovery.c.
+ *  hi2c1 is used instead of the BSP I2C1 handle, as I2C1 interrupts and DMA are routed to it.
+ */
+void EEPROM_I2C_IO_Init(void)
+{
+    if (HAL_I2C_GetState(&hi2c1) == HAL_I2C_STATE_RESET)
+    {
+        MX_I2C1_Init();
+    }
+}
+
+HAL_StatusTypeDef EEPROM_I2C_IO_WriteData(uint16_t DevAddress, uint16_t MemAddress, uint8_t *pBuffer,
+                                          uint32_t BufferSize)
+{
+    return HAL_I2C_Mem_Write(&hi2c1, DevAddress, MemAddress, I2C_MEMADD_SIZE_16BIT, pBuffer,
+                             BufferSize, EEPROM_I2C_IO_TIMEOUT);
+}
+
+HAL_StatusTypeDef EEPROM_I2C_IO_ReadData(uint16_t DevAddress, uint16_t MemAddress, uint8_t *pBuffer,
+                                         uint32_t BufferSize)
+{
+    return HAL_I2C_Mem_Read(&hi2c1, DevAddress, MemAddress, I2C_MEMADD_SIZE_16BIT, pBuffer,
+                            BufferSize, EEPROM_I2C_IO_TIMEOUT);
+}
+
+/*!@brief Start a read by DMA, EEPROM_I2C_IO_ReadCpltCallback() is called on completion.
+ */
+HAL_StatusTypeDef EEPROM_I2C_IO_ReadDataDMA(uint16_t DevAddress, uint16_t MemAddress,
+                                            uint8_t *pBuffer, uint32_t BufferSize)
+{
+    return HAL_I2C_Mem_Read_DMA(&hi2c1, DevAddress, MemAddress, I2C_MEMADD_SIZE_16BIT, pBuffer,
+                                BufferSize);
+}
+
+/*!@brief Stop a DMA read not completed in time, no callback follows. HAL_I2C_Master_Abort_IT()
+ *        refuses a memory read, the peripheral is reset to release the bus.
+ */
+HAL_StatusTypeDef EEPROM_I2C_IO_AbortDMA(uint16_t DevAddress)
+{
+    HAL_DMA_Abort(hi2c1.hdmarx);
+    if (HAL_I2C_Master_Abort_IT(&hi2c1, DevAddress) == HAL_OK)
+    {
+        return HAL_OK;
+    }
+
+    HAL_I2C_DeInit(&hi2c1);
+    MX_I2C1_Init();
+    return (HAL_I2C_GetState(&hi2c1) == HAL_I2C_STATE_READY) ? HAL_OK : HAL_ERROR;
+}
+
+/*!@brief Address the device once per trial, it doesn't acknowledge during a write cycle.
+ */
+HAL_StatusTypeDef EEPROM_I2C_IO_IsDeviceReady(uint16_t DevAddress, uint32_t Trials)
+{
+    return HAL_I2C_IsDeviceReady(&hi2c1, DevAddress, Trials, EEPROM_I2C_IO_TIMEOUT);
+}
+
+__weak void EEPROM_I2C_IO_ReadCpltCallback(HAL_StatusTypeDef status)
+{
+    UNUSED(status);
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    if (hi2c->Instance == I2C1)
+    {
+        EEPROM_I2C_IO_ReadCpltCallback(HAL_OK);
+    }
+}
+
+/*!@brief Error of a transfer in interrupt / DMA mode, the DMA read on I2C1 only.
+ */
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    if (hi2c->Instance == I2C1)
+    {
+        EEPROM_I2C_IO_ReadCpltCallback(HAL_ERROR);
+    }
+}
+
 /* USER CODE END 1 */
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
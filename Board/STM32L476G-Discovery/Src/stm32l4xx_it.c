@@ -75,6 +75,7 @@
 extern PCD_HandleTypeDef  hpcd_USB_OTG_FS;
 extern I2C_HandleTypeDef  hi2c1;
 extern I2C_HandleTypeDef  hi2c2;
+extern DMA_HandleTypeDef  hdma_i2c1_rx;
 extern DMA_HandleTypeDef  hdma_quadspi;
 extern QSPI_HandleTypeDef hqspi;
 extern DMA_HandleTypeDef  hdma_spi2_rx;
@@ -87,6 +88,7 @@ extern UART_HandleTypeDef huart2;
 extern TIM_HandleTypeDef  htim7;
 
 /* USER CODE BEGIN EV */
+extern QSPI_HandleTypeDef QSPIHandle;
 
 /* USER CODE END EV */
 
@@ -284,6 +286,20 @@ void OTG_FS_IRQHandler(void)
     /* USER CODE END OTG_FS_IRQn 1 */
 }
 
+/**
+ * @brief This function handles DMA2 channel6 global interrupt.
+ */
+void DMA2_Channel6_IRQHandler(void)
+{
+    /* USER CODE BEGIN DMA2_Channel6_IRQn 0 */
+
+    /* USER CODE END DMA2_Channel6_IRQn 0 */
+    HAL_DMA_IRQHandler(&hdma_i2c1_rx);
+    /* USER CODE BEGIN DMA2_Channel6_IRQn 1 */
+
+    /* USER CODE END DMA2_Channel6_IRQn 1 */
+}
+
 /**
  * @brief This function handles DMA2 channel7 global interrupt.
  */
@@ -304,6 +320,12 @@ void DMA2_Channel7_IRQHandler(void)
 void QUADSPI_IRQHandler(void)
 {
     /* USER CODE BEGIN QUADSPI_IRQn 0 */
+    // BSP_QSPI_Init() takes QUADSPI over with its own handle, hqspi is left idle.
+    if (QSPIHandle.State != HAL_QSPI_STATE_RESET)
+    {
+        HAL_QSPI_IRQHandler(&QSPIHandle);
+        return;
+    }
 
     /* USER CODE END QUADSPI_IRQn 0 */
     HAL_QSPI_IRQHandler(&hqspi);
@@ -314,5 +336,21 @@ void QUADSPI_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+ * @brief This function handles PVD/PVM interrupt through EXTI line 16, used by NVRAM cache flush.
+ */
+void PVD_PVM_IRQHandler(void)
+{
+    HAL_PWREx_PVD_PVM_IRQHandler();
+}
+
+/**
+ * @brief This function handles Flash global interrupt, used by NVRAM background cleanup.
+ */
+void FLASH_IRQHandler(void)
+{
+    HAL_FLASH_IRQHandler();
+}
+
 /* USER CODE END 1 */
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -64,7 +64,7 @@ extern I2C_HandleTypeDef hi2c1;
 extern I2C_HandleTypeDef hi2c2;
 
 /* USER CODE BEGIN Private defines */
-
+#define EEPROM_I2C_IO_TIMEOUT 10 //!< Blocking transfer timeout in ms
 /* USER CODE END Private defines */
 
 void MX_I2C1_Init(void);
@@ -78,6 +78,8 @@ void OTG_FS_IRQHandler(void);
 void DMA2_Channel7_IRQHandler(void);
 void QUADSPI_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void PVD_PVM_IRQHandler(void);
+void FLASH_IRQHandler(void);
 
 /* USER CODE END EFP */
 
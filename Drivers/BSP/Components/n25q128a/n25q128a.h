@@ -83,6 +83,7 @@
 #define N25Q128A_BULK_ERASE_MAX_TIME         250000
 #define N25Q128A_SECTOR_ERASE_MAX_TIME       3000
 #define N25Q128A_SUBSECTOR_ERASE_MAX_TIME    800
+#define N25Q128A_SUSPEND_MAX_TIME            1         /* Suspend latency is tens of us */
 
 /** 
   * @brief  N25Q128A Commands  
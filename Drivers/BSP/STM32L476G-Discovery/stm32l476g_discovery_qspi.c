@@ -25,6 +25,12 @@
             initialized.
             Read/write operation can be performed with AHB access using the functions
             BSP_QSPI_Read()/BSP_QSPI_Write().
+       (++) Read/write operation can be performed without blocking the CPU by DMA with
+            BSP_QSPI_Read_DMA() and BSP_QSPI_WritePage_DMA(), the end of program is
+            waited by the status match interrupt with BSP_QSPI_AutoPollingMemReady_IT().
+            Each of them returns once started, BSP_QSPI_TransferCpltCallback() is called
+            on completion. The DMA channel and the QUADSPI interrupt are the ones set by
+            HAL_QSPI_MspInit(), QUADSPI_IRQHandler() must serve QSPIHandle.
        (++) The function to the QSPI memory in memory-mapped mode is possible after
             the call of the function BSP_QSPI_EnableMemoryMappedMode().
        (++) The function BSP_QSPI_GetInfo() returns the configuration of the QSPI memory.
@@ -35,7 +41,8 @@
        (++) The function BSP_QSPI_GetStatus() returns the current status of the QSPI memory.
             (see the QSPI memory data sheet)
        (++) Perform erase sector operation using the function BSP_QSPI_Erase_Sector()
-            which is not blocking. So the function BSP_QSPI_GetStatus() should be used
+            or BSP_QSPI_Erase_Subsector() which are not blocking. So the function
+            BSP_QSPI_GetStatus() or BSP_QSPI_AutoPollingMemReady_IT() should be used
             to check if the memory is busy, and the functions BSP_QSPI_SuspendErase()/
             BSP_QSPI_ResumeErase() can be used to perform other operations during the
             sector erase.
@@ -72,6 +79,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "stm32l476g_discovery_qspi.h"
+#include <string.h>
 
 /** @addtogroup BSP
   * @{
@@ -301,6 +309,217 @@ uint8_t BSP_QSPI_Write(uint8_t *pData, uint32_t WriteAddr, uint32_t Size)
   return QSPI_OK;
 }
 
+/**
+  * @brief  Reads an amount of data from the QSPI memory by DMA.
+  * @param  pData: Pointer to data to be read, valid on BSP_QSPI_TransferCpltCallback()
+  * @param  ReadAddr: Read start address
+  * @param  Size: Size of data to read, 65535 bytes at most
+  * @retval QSPI memory status
+  */
+uint8_t BSP_QSPI_Read_DMA(uint8_t *pData, uint32_t ReadAddr, uint32_t Size)
+{
+  QSPI_CommandTypeDef sCommand;
+
+  if (QSPIHandle.hdma == NULL)
+  {
+    return QSPI_NOT_SUPPORTED;
+  }
+
+  /* DMA counter is 16 bits */
+  if ((Size == 0) || (Size > 0xFFFF))
+  {
+    return QSPI_ERROR;
+  }
+
+  /* Initialize the read command */
+  sCommand.InstructionMode   = QSPI_INSTRUCTION_1_LINE;
+  sCommand.Instruction       = QUAD_INOUT_FAST_READ_CMD;
+  sCommand.AddressMode       = QSPI_ADDRESS_4_LINES;
+  sCommand.AddressSize       = QSPI_ADDRESS_24_BITS;
+  sCommand.Address           = ReadAddr;
+  sCommand.AlternateByteMode = QSPI_ALTERNATE_BYTES_NONE;
+  sCommand.DataMode          = QSPI_DATA_4_LINES;
+  sCommand.DummyCycles       = N25Q128A_DUMMY_CYCLES_READ_QUAD;
+  sCommand.NbData            = Size;
+  sCommand.DdrMode           = QSPI_DDR_MODE_DISABLE;
+  sCommand.DdrHoldHalfCycle  = QSPI_DDR_HHC_ANALOG_DELAY;
+  sCommand.SIOOMode          = QSPI_SIOO_INST_EVERY_CMD;
+
+  /* Configure the command */
+  if (HAL_QSPI_Command(&QSPIHandle, &sCommand, HAL_QPSI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+  {
+    return QSPI_ERROR;
+  }
+
+  /* Start the reception of the data */
+  if (HAL_QSPI_Receive_DMA(&QSPIHandle, pData) != HAL_OK)
+  {
+    return QSPI_ERROR;
+  }
+
+  return QSPI_OK;
+}
+
+/**
+  * @brief  Writes an amount of data in a page of the QSPI memory by DMA.
+  *         BSP_QSPI_TransferCpltCallback() is called once data are sent, the memory
+  *         then programs them, see BSP_QSPI_AutoPollingMemReady_IT().
+  * @param  pData: Pointer to data to be written, kept until the callback
+  * @param  WriteAddr: Write start address
+  * @param  Size: Size of data to write, up to the end of the page
+  * @retval QSPI memory status
+  */
+uint8_t BSP_QSPI_WritePage_DMA(uint8_t *pData, uint32_t WriteAddr, uint32_t Size)
+{
+  QSPI_CommandTypeDef sCommand;
+
+  if (QSPIHandle.hdma == NULL)
+  {
+    return QSPI_NOT_SUPPORTED;
+  }
+
+  if ((Size == 0) || (Size > N25Q128A_PAGE_SIZE - (WriteAddr % N25Q128A_PAGE_SIZE)))
+  {
+    return QSPI_ERROR;
+  }
+
+  /* Initialize the program command */
+  sCommand.InstructionMode   = QSPI_INSTRUCTION_1_LINE;
+  sCommand.Instruction       = EXT_QUAD_IN_FAST_PROG_CMD;
+  sCommand.AddressMode       = QSPI_ADDRESS_4_LINES;
+  sCommand.AddressSize       = QSPI_ADDRESS_24_BITS;
+  sCommand.Address           = WriteAddr;
+  sCommand.AlternateByteMode = QSPI_ALTERNATE_BYTES_NONE;
+  sCommand.DataMode          = QSPI_DATA_4_LINES;
+  sCommand.DummyCycles       = 0;
+  sCommand.NbData            = Size;
+  sCommand.DdrMode           = QSPI_DDR_MODE_DISABLE;
+  sCommand.DdrHoldHalfCycle  = QSPI_DDR_HHC_ANALOG_DELAY;
+  sCommand.SIOOMode          = QSPI_SIOO_INST_EVERY_CMD;
+
+  /* Enable write operations, a few clock cycles */
+  if (QSPI_WriteEnable(&QSPIHandle) != QSPI_OK)
+  {
+    return QSPI_ERROR;
+  }
+
+  /* Configure the command */
+  if (HAL_QSPI_Command(&QSPIHandle, &sCommand, HAL_QPSI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+  {
+    return QSPI_ERROR;
+  }
+
+  /* Start the transmission of the data */
+  if (HAL_QSPI_Transmit_DMA(&QSPIHandle, pData) != HAL_OK)
+  {
+    return QSPI_ERROR;
+  }
+
+  return QSPI_OK;
+}
+
+/**
+  * @brief  Waits the end of program / erase by automatic polling of the status
+  *         register, BSP_QSPI_TransferCpltCallback() is called on status match.
+  * @retval QSPI memory status
+  */
+uint8_t BSP_QSPI_AutoPollingMemReady_IT(void)
+{
+  QSPI_CommandTypeDef     sCommand;
+  QSPI_AutoPollingTypeDef sConfig;
+
+  /* Configure automatic polling mode to wait for memory ready */
+  sCommand.InstructionMode   = QSPI_INSTRUCTION_1_LINE;
+  sCommand.Instruction       = READ_STATUS_REG_CMD;
+  sCommand.AddressMode       = QSPI_ADDRESS_NONE;
+  sCommand.AlternateByteMode = QSPI_ALTERNATE_BYTES_NONE;
+  sCommand.DataMode          = QSPI_DATA_1_LINE;
+  sCommand.DummyCycles       = 0;
+  sCommand.DdrMode           = QSPI_DDR_MODE_DISABLE;
+  sCommand.DdrHoldHalfCycle  = QSPI_DDR_HHC_ANALOG_DELAY;
+  sCommand.SIOOMode          = QSPI_SIOO_INST_EVERY_CMD;
+
+  sConfig.Match           = 0;
+  sConfig.Mask            = N25Q128A_SR_WIP;
+  sConfig.MatchMode       = QSPI_MATCH_MODE_AND;
+  sConfig.StatusBytesSize = 1;
+  sConfig.Interval        = 0x10;
+  sConfig.AutomaticStop   = QSPI_AUTOMATIC_STOP_ENABLE;
+
+  if (HAL_QSPI_AutoPolling_IT(&QSPIHandle, &sCommand, &sConfig) != HAL_OK)
+  {
+    return QSPI_ERROR;
+  }
+
+  return QSPI_OK;
+}
+
+/**
+  * @brief  Aborts an ongoing DMA transfer or automatic polling.
+  * @retval QSPI memory status
+  */
+uint8_t BSP_QSPI_Abort(void)
+{
+  if (HAL_QSPI_Abort(&QSPIHandle) != HAL_OK)
+  {
+    return QSPI_ERROR;
+  }
+
+  return QSPI_OK;
+}
+
+/**
+  * @brief  End of BSP_QSPI_Read_DMA(), BSP_QSPI_WritePage_DMA() or
+  *         BSP_QSPI_AutoPollingMemReady_IT(), called from interrupt.
+  * @param  Status: QSPI_OK, or QSPI_ERROR on transfer error
+  * @retval None
+  */
+__weak void BSP_QSPI_TransferCpltCallback(uint8_t Status)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(Status);
+}
+
+/**
+  * @brief  Rx Transfer completed callbacks.
+  * @param  hqspi: QSPI handle
+  * @retval None
+  */
+void HAL_QSPI_RxCpltCallback(QSPI_HandleTypeDef *hqspi)
+{
+  BSP_QSPI_TransferCpltCallback(QSPI_OK);
+}
+
+/**
+  * @brief  Tx Transfer completed callbacks.
+  * @param  hqspi: QSPI handle
+  * @retval None
+  */
+void HAL_QSPI_TxCpltCallback(QSPI_HandleTypeDef *hqspi)
+{
+  BSP_QSPI_TransferCpltCallback(QSPI_OK);
+}
+
+/**
+  * @brief  Status Match callbacks.
+  * @param  hqspi: QSPI handle
+  * @retval None
+  */
+void HAL_QSPI_StatusMatchCallback(QSPI_HandleTypeDef *hqspi)
+{
+  BSP_QSPI_TransferCpltCallback(QSPI_OK);
+}
+
+/**
+  * @brief  Transfer Error callbacks.
+  * @param  hqspi: QSPI handle
+  * @retval None
+  */
+void HAL_QSPI_ErrorCallback(QSPI_HandleTypeDef *hqspi)
+{
+  BSP_QSPI_TransferCpltCallback(QSPI_ERROR);
+}
+
 /**
   * @brief  Erases the specified block of the QSPI memory.
   * @param  BlockAddress: Block address to erase
@@ -391,6 +610,50 @@ uint8_t BSP_QSPI_Erase_Sector(uint32_t Sector)
   return QSPI_OK;
 }
 
+/**
+  * @brief  Erases the specified subsector of the QSPI memory.
+  * @param  Subsector: Subsector address to erase (0 to 4095)
+  * @retval QSPI memory status
+  * @note This function is non blocking as BSP_QSPI_Erase_Sector(),
+  *       the erase can be suspended by BSP_QSPI_SuspendErase().
+  */
+uint8_t BSP_QSPI_Erase_Subsector(uint32_t Subsector)
+{
+  QSPI_CommandTypeDef sCommand;
+
+  if (Subsector >= (uint32_t)(N25Q128A_FLASH_SIZE / N25Q128A_SUBSECTOR_SIZE))
+  {
+    return QSPI_ERROR;
+  }
+
+  /* Initialize the erase command */
+  sCommand.InstructionMode   = QSPI_INSTRUCTION_1_LINE;
+  sCommand.Instruction       = SUBSECTOR_ERASE_CMD;
+  sCommand.AddressMode       = QSPI_ADDRESS_1_LINE;
+  sCommand.AddressSize       = QSPI_ADDRESS_24_BITS;
+  sCommand.Address           = (Subsector * N25Q128A_SUBSECTOR_SIZE);
+  sCommand.AlternateByteMode = QSPI_ALTERNATE_BYTES_NONE;
+  sCommand.DataMode          = QSPI_DATA_NONE;
+  sCommand.DummyCycles       = 0;
+  sCommand.DdrMode           = QSPI_DDR_MODE_DISABLE;
+  sCommand.DdrHoldHalfCycle  = QSPI_DDR_HHC_ANALOG_DELAY;
+  sCommand.SIOOMode          = QSPI_SIOO_INST_EVERY_CMD;
+
+  /* Enable write operations */
+  if (QSPI_WriteEnable(&QSPIHandle) != QSPI_OK)
+  {
+    return QSPI_ERROR;
+  }
+
+  /* Send the command */
+  if (HAL_QSPI_Command(&QSPIHandle, &sCommand, HAL_QPSI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+  {
+    return QSPI_ERROR;
+  }
+
+  return QSPI_OK;
+}
+
 /**
   * @brief  Erases the entire QSPI memory.
   * @retval QSPI memory status
@@ -534,6 +797,45 @@ uint8_t BSP_QSPI_EnableMemoryMappedMode(void)
   return QSPI_OK;
 }
 
+/**
+  * @brief  Leaves the memory-mapped mode, the QSPI takes indirect commands again.
+  *         The memory-mapped area must not be accessed meanwhile.
+  * @retval QSPI memory status
+  */
+uint8_t BSP_QSPI_DisableMemoryMappedMode(void)
+{
+  if (HAL_QSPI_GetState(&QSPIHandle) != HAL_QSPI_STATE_BUSY_MEM_MAPPED)
+  {
+    return QSPI_OK;
+  }
+
+  if (HAL_QSPI_Abort(&QSPIHandle) != HAL_OK)
+  {
+    return QSPI_ERROR;
+  }
+
+  return QSPI_OK;
+}
+
+/**
+  * @brief  Reads an amount of data from the memory-mapped area, by the CPU.
+  * @param  pData: Pointer to data to be read
+  * @param  ReadAddr: Read start address
+  * @param  Size: Size of data to read
+  * @retval QSPI memory status
+  */
+uint8_t BSP_QSPI_ReadMapped(uint8_t *pData, uint32_t ReadAddr, uint32_t Size)
+{
+  if (HAL_QSPI_GetState(&QSPIHandle) != HAL_QSPI_STATE_BUSY_MEM_MAPPED)
+  {
+    return QSPI_ERROR;
+  }
+
+  memcpy(pData, (uint8_t *)QSPI_BASE + ReadAddr, Size);
+
+  return QSPI_OK;
+}
+
 /**
   * @brief  This function suspends an ongoing erase command.
   * @retval QSPI memory status
@@ -541,6 +843,8 @@ uint8_t BSP_QSPI_EnableMemoryMappedMode(void)
 uint8_t BSP_QSPI_SuspendErase(void)
 {
   QSPI_CommandTypeDef sCommand;
+  uint32_t tickstart;
+  uint8_t status;
 
   /* Check whether the device is busy (erase operation is
   in progress).
@@ -570,7 +874,17 @@ uint8_t BSP_QSPI_SuspendErase(void)
       return QSPI_ERROR;
     }
 
-    if (BSP_QSPI_GetStatus() == QSPI_SUSPENDED)
+    /* The device stays busy for the suspend latency, the operation may also end meanwhile */
+    tickstart = HAL_GetTick();
+    while ((status = BSP_QSPI_GetStatus()) == QSPI_BUSY)
+    {
+      if ((HAL_GetTick() - tickstart) > N25Q128A_SUSPEND_MAX_TIME)
+      {
+        return QSPI_ERROR;
+      }
+    }
+
+    if ((status == QSPI_SUSPENDED) || (status == QSPI_OK))
     {
       return QSPI_OK;
     }
@@ -103,12 +103,20 @@ uint8_t BSP_QSPI_Read(uint8_t *pData, uint32_t ReadAddr, uint32_t Size);
 uint8_t BSP_QSPI_Write(uint8_t *pData, uint32_t WriteAddr, uint32_t Size);
 uint8_t BSP_QSPI_Erase_Block(uint32_t BlockAddress);
 uint8_t BSP_QSPI_Erase_Sector(uint32_t Sector);
+uint8_t BSP_QSPI_Erase_Subsector(uint32_t Subsector);
 uint8_t BSP_QSPI_Erase_Chip(void);
 uint8_t BSP_QSPI_GetStatus(void);
 uint8_t BSP_QSPI_GetInfo(QSPI_Info *pInfo);
 uint8_t BSP_QSPI_EnableMemoryMappedMode(void);
+uint8_t BSP_QSPI_DisableMemoryMappedMode(void);
+uint8_t BSP_QSPI_ReadMapped(uint8_t *pData, uint32_t ReadAddr, uint32_t Size);
 uint8_t BSP_QSPI_SuspendErase(void);
 uint8_t BSP_QSPI_ResumeErase(void);
+uint8_t BSP_QSPI_Read_DMA(uint8_t *pData, uint32_t ReadAddr, uint32_t Size);
+uint8_t BSP_QSPI_WritePage_DMA(uint8_t *pData, uint32_t WriteAddr, uint32_t Size);
+uint8_t BSP_QSPI_AutoPollingMemReady_IT(void);
+uint8_t BSP_QSPI_Abort(void);
+void    BSP_QSPI_TransferCpltCallback(uint8_t Status);
 
 /**
   * @}
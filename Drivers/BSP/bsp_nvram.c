@@ -3,7 +3,31 @@
  * @brief   Board Support Package for NVRAM (Non-Volatile Random Access Memory)
  *          Support the following device:
  *          - STM32L476 internal flash emulation.
- *          - External EEPROM device (TBD)
+ *          - N25Q128A QSPI flash, log-structured key-value store of bsp_nvram_qspi.c.
+ *          - External M24256 I2C EEPROM of bsp_nvram_i2c.c.
+ *          NVRAM_DEVICE is bound at init, Bsp_Nvram_Select() changes it at run time.
+ *
+ *          Writes go through a RAM write-back cache in front of the device driver.
+ *          A write of the value already on device is dropped, repeated writes to a
+ *          variable are merged, and cached variables are written to device by
+ *          Bsp_Nvram_Task() NVRAM_CACHE_FLUSH_MS after the first cached write, by
+ *          Bsp_Nvram_Flush() before a reset, on cache full or on PVD brown-out.
+ *          PVD writes the internal flash from interrupt, other devices from the task.
+ *          A flush writes by address order then flushes the device, so a device
+ *          buffering its writes by page writes neighbour variables together.
+ *
+ *          Pages left by an EEPROM_Emul page transfer are erased in background:
+ *          Bsp_Nvram_Task() starts EE_CleanUp_IT() and holds the cache flush until
+ *          the flash interrupt reports the end of erase, so writes don't wait for it.
+ *
+ *          Writes between Bsp_Nvram_Begin() and Bsp_Nvram_Commit() are staged, then
+ *          written to device in one transaction, all or none of them after a reset.
+ *          Multi-byte values of WriteEx()/ReadEx() are stored as EEPROM_Emul blobs and
+ *          bypass the cache.
+ *
+ *          Tasks are serialized on the cache, the transaction and the device by a mutex,
+ *          device drivers aren't reentrant. PVD can't wait it, it defers its flush while
+ *          a task is inside.
  *
  * @author  Nick Yang
  * @date    2018/04/27
@@ -11,10 +35,21 @@
  *****************************************************************************/
 
 #include "bsp_nvram.h"
+#include "bsp_nvram_i2c.h"
+#include "bsp_nvram_qspi.h"
+#include "cmsis_os.h"
 #include "stdio.h"
+#include "string.h"
 
 #include "eeprom_emul.h"
 
+// clang-format off
+#define EEP_EMUL_CLEAN_IDLE         0       //!< No page to erase
+#define EEP_EMUL_CLEAN_REQUIRED     1       //!< Page transfer done, pages to erase
+#define EEP_EMUL_CLEAN_ERASING      2       //!< Erase in progress, flash is busy
+#define EEP_EMUL_CLEAN_TIMEOUT      200     //!< Maximum wait for the erase in ms, 3x pages
+// clang-format on
+
 // General Print
 #define NVRAM_PRINT(msg, args...)                                                                  \
     do                                                                                             \
@@ -63,7 +98,33 @@ const uint16_t EEP_EMUL_VirtualTab[] = {
     0xF0,  0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF,
 };
 
-Nvram_DrvTypeDef Nvram_Drv = {0};
+typedef struct {
+    uint32_t Addr;
+    uint32_t Value;
+} Nvram_CacheTypeDef;
+
+Nvram_DrvTypeDef       Nvram_Drv          = {0};
+Nvram_CacheStatTypeDef Nvram_CacheStat    = {0};
+Nvram_LatencyTypeDef   Nvram_WriteLatency = {0};
+Nvram_ConfigTypeDef    Nvram_Config       = {0};
+
+static volatile uint8_t EEP_EMUL_CleanState = EEP_EMUL_CLEAN_IDLE;
+
+static Nvram_DrvTypeDef   Nvram_Dev          = {0}; //!< Device driver behind the cache
+static NVRAM_DEV          Nvram_DevSel       = NVRAM_DEVICE; //!< Index of Nvram_Dev in Nvram_DevTab
+static Nvram_CacheTypeDef Nvram_Cache[NVRAM_CACHE_SIZE];
+static uint32_t           Nvram_CacheCount   = 0;
+static uint32_t           Nvram_CacheTick    = 0; //!< Tick of the first cached write
+static volatile uint8_t   Nvram_CacheBusy    = 0; //!< A task holds Nvram_Mutex, PVD defers
+static volatile uint8_t   Nvram_CachePending = 0; //!< Flush requested while cache is locked
+static uint32_t           Nvram_TxAddr[NVRAM_TX_SIZE];
+static uint32_t           Nvram_TxValue[NVRAM_TX_SIZE];
+static uint32_t           Nvram_TxCount = 0;
+static uint8_t            Nvram_TxOpen  = 0; //!< Writes are staged until Bsp_Nvram_Commit()
+static osMutexId          Nvram_Mutex   = NULL; //!< Held by the task in the cache or device
+static uint8_t            Nvram_Ready   = 0; //!< Bsp_Nvram_Init() succeeded, not deinitialized
+
+osMutexDef(Nvram_Mutex);
 
 NVRAM_STATUS EEP_EMUL_Init()
 {
@@ -84,6 +145,8 @@ NVRAM_STATUS EEP_EMUL_Init()
     if (EE_OK == status)
     {
         NVRAM_PRINT("EEPROM_Emul Initialize success!\n");
+        // Erase pages left by a page transfer before reset, if any.
+        EEP_EMUL_CleanState = EEP_EMUL_CLEAN_REQUIRED;
     }
     else
     {
@@ -95,6 +158,10 @@ NVRAM_STATUS EEP_EMUL_Init()
     // Lock Flash after initialize finish.
     HAL_FLASH_Lock();
 
+    // Flash interrupt ends background cleanup, preempts PVD flush waiting for it.
+    HAL_NVIC_SetPriority(FLASH_IRQn, 4, 0);
+    HAL_NVIC_EnableIRQ(FLASH_IRQn);
+
     return 0;
 }
 
@@ -103,29 +170,149 @@ NVRAM_STATUS EEP_EMUL_DeInit()
     return 0;
 }
 
+/*!@brief Wait for the background cleanup, flash is held by HAL until the erase ends.
+ */
+static void EEP_EMUL_WaitClean(void)
+{
+    uint32_t tick = HAL_GetTick();
+
+    while ((EEP_EMUL_CleanState == EEP_EMUL_CLEAN_ERASING) &&
+           (HAL_GetTick() - tick < EEP_EMUL_CLEAN_TIMEOUT))
+    {
+    }
+}
+
 NVRAM_STATUS EEP_EMUL_Erase()
 {
     EE_Status ret = 0;
+    EEP_EMUL_WaitClean();
     HAL_FLASH_Unlock();
     ret = EE_Format(EE_FORCED_ERASE);
     HAL_FLASH_Lock();
     return ret;
 }
 
+/*!@brief Erase now when next page transfer is due before background cleanup ran.
+ *
+ * @param ret   : Status of the write.
+ * @return 1 if pages are erased and the write can be retried.
+ */
+static uint8_t EEP_EMUL_CleanNow(EE_Status ret)
+{
+    if ((ret == EE_ERROR_NOERASE_PAGE) && (EE_CleanUp() == EE_OK))
+    {
+        EEP_EMUL_CleanState = EEP_EMUL_CLEAN_IDLE;
+        return 1;
+    }
+    return 0;
+}
+
+/*!@brief Write is done, erase of the transferred pages is left to EEP_EMUL_Clean().
+ *
+ * @param ret   : Status of the write.
+ * @return Status of the write, EE_CLEANUP_REQUIRED is success.
+ */
+static EE_Status EEP_EMUL_CleanLater(EE_Status ret)
+{
+    if (ret == EE_CLEANUP_REQUIRED)
+    {
+        EEP_EMUL_CleanState = EEP_EMUL_CLEAN_REQUIRED;
+        ret                 = EE_OK;
+    }
+    return ret;
+}
+
 NVRAM_STATUS EEP_EMUL_Write(uint32_t addr, uint32_t value)
 {
     EE_Status ret = 0;
 
+    EEP_EMUL_WaitClean();
     HAL_FLASH_Unlock();
     ret = EE_WriteVariable32bits(addr, value);
-
-    if (ret == EE_CLEANUP_REQUIRED)
+    if (EEP_EMUL_CleanNow(ret))
     {
-        ret = EE_CleanUp();
         ret = EE_WriteVariable32bits(addr, value);
     }
+    ret = EEP_EMUL_CleanLater(ret);
+    HAL_FLASH_Lock();
+
+    return ret;
+}
+
+/*!@brief Write a set of variables in one EEPROM_Emul transaction, with a single flash unlock.
+ *         After a reset during the write, EE_Init() discards the incomplete set.
+ */
+NVRAM_STATUS EEP_EMUL_WriteTx(uint32_t *addr, uint32_t *value, uint16_t count)
+{
+    uint16_t  virtaddr[EE_TX_MAX_ELEMENTS];
+    EE_Status ret = 0;
+
+    if (count > EE_TX_MAX_ELEMENTS)
+    {
+        return NVRAM_ERR_PARAM;
+    }
 
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (addr[i] > 0xFFFF)
+        {
+            return NVRAM_ERR_PARAM;
+        }
+        virtaddr[i] = addr[i];
+    }
+
+    EEP_EMUL_WaitClean();
+    HAL_FLASH_Unlock();
+    ret = EE_WriteTransaction32bits(virtaddr, value, count);
+    if (EEP_EMUL_CleanNow(ret))
+    {
+        ret = EE_WriteTransaction32bits(virtaddr, value, count);
+    }
+    ret = EEP_EMUL_CleanLater(ret);
+    HAL_FLASH_Lock();
+
+    return ret;
+}
+
+/*!@brief Write a multi-byte value as an EEPROM_Emul blob, data with a single crc. Only the
+ *        6-byte data elements changed since the previous value are programmed.
+ *
+ * @param reg   : Blob index, up to NB_OF_BLOBS - 1.
+ * @param value : Data, up to EE_BLOB_MAX_SIZE bytes.
+ * @param len   : Data length in bytes.
+ */
+NVRAM_STATUS EEP_EMUL_WriteEx(uint8_t reg, uint8_t *value, uint16_t len)
+{
+    EE_Status ret = 0;
+
+    EEP_EMUL_WaitClean();
+    HAL_FLASH_Unlock();
+    ret = EE_WriteBlob(reg, value, len);
+    if (EEP_EMUL_CleanNow(ret))
+    {
+        ret = EE_WriteBlob(reg, value, len);
+    }
+    ret = EEP_EMUL_CleanLater(ret);
     HAL_FLASH_Lock();
+
+    return ret;
+}
+
+/*!@brief Read a blob, bytes after the blob length are cleared.
+ *
+ * @param reg   : Blob index, up to NB_OF_BLOBS - 1.
+ * @param value : Buffer receiving the data.
+ * @param len   : Buffer size in bytes.
+ */
+NVRAM_STATUS EEP_EMUL_ReadEx(uint8_t reg, uint8_t *value, uint16_t len)
+{
+    uint16_t  length = 0;
+    EE_Status ret    = EE_ReadBlob(reg, value, len, &length);
+
+    if ((ret == EE_OK) && (length < len))
+    {
+        memset(value + length, 0, len - length);
+    }
     return ret;
 }
 
@@ -134,6 +321,63 @@ NVRAM_STATUS EEP_EMUL_Read(uint32_t addr, uint32_t *value)
     return EE_ReadVariable32bits(addr, value);
 }
 
+/*!@brief Read variables addr ~ addr + count - 1 in a single browse of the emulation pages.
+ */
+NVRAM_STATUS EEP_EMUL_Snapshot(uint32_t addr, uint32_t count, uint32_t *value, uint32_t *valid)
+{
+    if (addr + count > 0xFFFF)
+    {
+        return NVRAM_ERR_PARAM;
+    }
+    return EE_ReadSnapshot32bits(addr, count, value, valid);
+}
+
+/*!@brief Start erase of the pages left by a page transfer, in interrupt mode.
+ *
+ * @return NVRAM_OK when no page is left to erase, NVRAM_BUSY while erase is required or running.
+ */
+NVRAM_STATUS EEP_EMUL_Clean()
+{
+    if (EEP_EMUL_CleanState == EEP_EMUL_CLEAN_REQUIRED)
+    {
+        EEP_EMUL_CleanState = EEP_EMUL_CLEAN_ERASING;
+        HAL_FLASH_Unlock();
+
+        // No page group in erasing state, or erase not started.
+        if (EE_CleanUp_IT() != EE_OK)
+        {
+            HAL_FLASH_Lock();
+            EEP_EMUL_CleanState = EEP_EMUL_CLEAN_IDLE;
+        }
+    }
+
+    return (EEP_EMUL_CleanState == EEP_EMUL_CLEAN_IDLE) ? NVRAM_OK : NVRAM_BUSY;
+}
+
+void EE_EndOfCleanup_UserCallback(void)
+{
+    HAL_FLASH_Lock();
+    EEP_EMUL_CleanState = EEP_EMUL_CLEAN_IDLE;
+}
+
+/*!@brief Flash interrupt, called after each erased page, then with 0xFFFFFFFF after the last.
+ */
+void HAL_FLASH_EndOfOperationCallback(uint32_t ReturnValue)
+{
+    if (ReturnValue == 0xFFFFFFFF)
+    {
+        EE_EndOfCleanup_UserCallback();
+    }
+}
+
+/*!@brief Flash interrupt on erase error, retry on next EEP_EMUL_Clean().
+ */
+void HAL_FLASH_OperationErrorCallback(uint32_t ReturnValue)
+{
+    HAL_FLASH_Lock();
+    EEP_EMUL_CleanState = EEP_EMUL_CLEAN_REQUIRED;
+}
+
 NVRAM_STATUS EEP_EMUL_GetInfo(Nvram_InfoTypeDef *info)
 {
     info->Interface  = "EMULATION";
@@ -146,25 +390,542 @@ NVRAM_STATUS EEP_EMUL_GetInfo(Nvram_InfoTypeDef *info)
     return NVRAM_OK;
 }
 
-NVRAM_STATUS Bsp_Nvram_Init()
+/*!@var Nvram_DevTab
+ * Device drivers, indexed by NVRAM_DEV.
+ */
+static const Nvram_DrvTypeDef Nvram_DevTab[NVRAM_DEV_NUM] = {
+    [NVRAM_DEV_EMUL] =
+        {
+            .Init    = EEP_EMUL_Init,
+            .DeInit  = EEP_EMUL_DeInit,
+            .Erase   = EEP_EMUL_Erase,
+            .Clean   = EEP_EMUL_Clean,
+            .Write   = EEP_EMUL_Write,
+            .Read    = EEP_EMUL_Read,
+            .WriteTx = EEP_EMUL_WriteTx,
+            .WriteEx = EEP_EMUL_WriteEx,
+            .ReadEx  = EEP_EMUL_ReadEx,
+            .Snapshot = EEP_EMUL_Snapshot,
+            .GetInfo = EEP_EMUL_GetInfo,
+        },
+    [NVRAM_DEV_QSPI] =
+        {
+            .Init    = QSPI_KV_Init,
+            .DeInit  = QSPI_KV_DeInit,
+            .Erase   = QSPI_KV_Erase,
+            .Clean   = QSPI_KV_Clean,
+            .Write   = QSPI_KV_Write,
+            .Read    = QSPI_KV_Read,
+            .WriteTx = QSPI_KV_WriteTx,
+            .WriteEx = QSPI_KV_WriteEx,
+            .ReadEx  = QSPI_KV_ReadEx,
+            .GetInfo = QSPI_KV_GetInfo,
+        },
+    [NVRAM_DEV_I2C] =
+        {
+            .Init    = I2C_EEP_Init,
+            .DeInit  = I2C_EEP_DeInit,
+            .Erase   = I2C_EEP_Erase,
+            .Flush   = I2C_EEP_Flush,
+            .Clean   = I2C_EEP_Clean,
+            .Write   = I2C_EEP_Write,
+            .Read    = I2C_EEP_Read,
+            .WriteTx = I2C_EEP_WriteTx,
+            .WriteEx = I2C_EEP_WriteEx,
+            .ReadEx  = I2C_EEP_ReadEx,
+            .Snapshot = I2C_EEP_Snapshot,
+            .GetInfo = I2C_EEP_GetInfo,
+        },
+};
+
+/*!@brief Find a variable in the cache.
+ *
+ * @param addr  : Variable address.
+ * @return Index in cache, -1 if not cached.
+ */
+static int NVRAM_CACHE_Find(uint32_t addr)
 {
-    Nvram_Drv.Init    = EEP_EMUL_Init;
-    Nvram_Drv.DeInit  = EEP_EMUL_DeInit;
-    Nvram_Drv.Erase   = EEP_EMUL_Erase;
-    Nvram_Drv.Write   = EEP_EMUL_Write;
-    Nvram_Drv.Read    = EEP_EMUL_Read;
-    Nvram_Drv.GetInfo = EEP_EMUL_GetInfo;
+    for (uint32_t i = 0; i < Nvram_CacheCount; i++)
+    {
+        if (Nvram_Cache[i].Addr == addr)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
 
-    if (Nvram_Drv.Init != NULL)
+/*!@brief Find a variable staged in the open transaction.
+ *
+ * @param addr  : Variable address.
+ * @return Index in transaction, -1 if not staged.
+ */
+static int NVRAM_TX_Find(uint32_t addr)
+{
+    for (uint32_t i = 0; i < Nvram_TxCount; i++)
     {
-        return Nvram_Drv.Init();
+        if (Nvram_TxAddr[i] == addr)
+        {
+            return i;
+        }
     }
+    return -1;
+}
 
-    return NVRAM_OK;
+/*!@brief Write cached variables to device, cache must be locked by caller.
+ *         Variables failed to write are kept in cache and retried on next flush.
+ */
+static NVRAM_STATUS NVRAM_CACHE_Sync(void)
+{
+    NVRAM_STATUS ret  = NVRAM_OK;
+    uint32_t     keep = 0;
+
+    // Sort by address, variables sharing a device page are written in turn.
+    for (uint32_t i = 1; i < Nvram_CacheCount; i++)
+    {
+        Nvram_CacheTypeDef entry = Nvram_Cache[i];
+        uint32_t           j     = i;
+
+        for (; (j > 0) && (Nvram_Cache[j - 1].Addr > entry.Addr); j--)
+        {
+            Nvram_Cache[j] = Nvram_Cache[j - 1];
+        }
+        Nvram_Cache[j] = entry;
+    }
+
+    for (uint32_t i = 0; i < Nvram_CacheCount; i++)
+    {
+        uint32_t value = 0;
+
+        // Variable may have been written back to the value on device.
+        if ((Nvram_Dev.Read(Nvram_Cache[i].Addr, &value) == NVRAM_OK) &&
+            (value == Nvram_Cache[i].Value))
+        {
+            Nvram_CacheStat.Elided++;
+            continue;
+        }
+
+        Nvram_CacheStat.FlashWrite++;
+        NVRAM_STATUS status = Nvram_Dev.Write(Nvram_Cache[i].Addr, Nvram_Cache[i].Value);
+        if (status != NVRAM_OK)
+        {
+            Nvram_Cache[keep++] = Nvram_Cache[i];
+            ret                 = status;
+        }
+    }
+
+    // Device keeps a failed buffered write and retries it on Clean().
+    if ((Nvram_Dev.Flush != NULL) && (Nvram_Dev.Flush() != NVRAM_OK))
+    {
+        ret = NVRAM_FAIL;
+    }
+
+    Nvram_CacheCount   = keep;
+    Nvram_CacheTick    = HAL_GetTick();
+    Nvram_CachePending = 0;
+    Nvram_CacheStat.Flush++;
+
+    return ret;
+}
+
+/*!@brief Lock cache and device for the calling task, not from interrupt. The mutex is created
+ *         on first use once the scheduler runs, before there is a single caller.
+ *
+ * @param ms    : Wait in ms, 0 to try.
+ * @return 1 if locked, 0 if another task holds it.
+ */
+static uint8_t NVRAM_CACHE_Lock(uint32_t ms)
+{
+    if (osKernelRunning())
+    {
+        osThreadSuspendAll();
+        if (Nvram_Mutex == NULL)
+        {
+            Nvram_Mutex = osMutexCreate(osMutex(Nvram_Mutex));
+        }
+        osThreadResumeAll();
+
+        if (osMutexWait(Nvram_Mutex, ms) != osOK)
+        {
+            return 0;
+        }
+    }
+    Nvram_CacheBusy = 1;
+    return 1;
+}
+
+/*!@brief Unlock cache, run the flush requested while it was locked.
+ */
+static void NVRAM_CACHE_Unlock(void)
+{
+    if (Nvram_CachePending)
+    {
+        NVRAM_CACHE_Sync();
+    }
+    Nvram_CacheBusy = 0;
+    if (osKernelRunning() && (Nvram_Mutex != NULL))
+    {
+        osMutexRelease(Nvram_Mutex);
+    }
+}
+
+NVRAM_STATUS NVRAM_CACHE_Init()
+{
+    NVRAM_CACHE_Lock(osWaitForever);
+    Nvram_CacheCount   = 0;
+    Nvram_CachePending = 0;
+    NVRAM_STATUS ret   = Nvram_Dev.Init();
+    NVRAM_CACHE_Unlock();
+
+    return ret;
+}
+
+NVRAM_STATUS NVRAM_CACHE_DeInit()
+{
+    NVRAM_CACHE_Lock(osWaitForever);
+    NVRAM_CACHE_Sync();
+    NVRAM_STATUS ret = (Nvram_Dev.DeInit != NULL) ? Nvram_Dev.DeInit() : NVRAM_OK;
+    NVRAM_CACHE_Unlock();
+
+    return ret;
+}
+
+NVRAM_STATUS NVRAM_CACHE_Erase()
+{
+    NVRAM_CACHE_Lock(osWaitForever);
+    Nvram_CacheCount   = 0;
+    Nvram_CachePending = 0;
+    NVRAM_STATUS ret   = Nvram_Dev.Erase();
+    NVRAM_CACHE_Unlock();
+
+    return ret;
+}
+
+NVRAM_STATUS NVRAM_CACHE_Flush()
+{
+    NVRAM_CACHE_Lock(osWaitForever);
+    NVRAM_STATUS ret = NVRAM_CACHE_Sync();
+    NVRAM_CACHE_Unlock();
+
+    return ret;
+}
+
+/*!@brief Add a write to latency histogram.
+ */
+static void NVRAM_CACHE_Latency(uint32_t ms)
+{
+    uint32_t n = 0;
+
+    while ((n < NVRAM_LATENCY_BUCKETS - 1) && (ms >= (1U << n)))
+    {
+        n++;
+    }
+
+    Nvram_WriteLatency.Bucket[n]++;
+    Nvram_WriteLatency.Count++;
+    Nvram_WriteLatency.Max = (ms > Nvram_WriteLatency.Max) ? ms : Nvram_WriteLatency.Max;
+}
+
+NVRAM_STATUS NVRAM_CACHE_Write(uint32_t addr, uint32_t value)
+{
+    NVRAM_STATUS ret     = NVRAM_OK;
+    uint32_t     current = 0;
+    uint32_t     tick    = HAL_GetTick();
+
+    // Virtual address 0x0000 & from EE_BLOB_VIRTADDR are reserved by EEPROM_Emul.
+    if ((addr == 0) || (addr >= EE_BLOB_VIRTADDR))
+    {
+        return NVRAM_ERR_PARAM;
+    }
+
+    NVRAM_CACHE_Lock(osWaitForever);
+    Nvram_CacheStat.Write++;
+
+    // Stage in the open transaction, repeated writes to a variable are merged.
+    if (Nvram_TxOpen)
+    {
+        int i = NVRAM_TX_Find(addr);
+        if (i >= 0)
+        {
+            Nvram_TxValue[i] = value;
+            Nvram_CacheStat.Coalesced++;
+        }
+        else if (Nvram_TxCount < NVRAM_TX_SIZE)
+        {
+            Nvram_TxAddr[Nvram_TxCount]  = addr;
+            Nvram_TxValue[Nvram_TxCount] = value;
+            Nvram_TxCount++;
+        }
+        else
+        {
+            ret = NVRAM_FAIL;
+        }
+
+        NVRAM_CACHE_Unlock();
+        return ret;
+    }
+
+    int i = NVRAM_CACHE_Find(addr);
+    if (i >= 0)
+    {
+        if (Nvram_Cache[i].Value == value)
+        {
+            Nvram_CacheStat.Elided++;
+        }
+        else
+        {
+            Nvram_Cache[i].Value = value;
+            Nvram_CacheStat.Coalesced++;
+        }
+    }
+    else if ((Nvram_Dev.Read(addr, &current) == NVRAM_OK) && (current == value))
+    {
+        Nvram_CacheStat.Elided++;
+    }
+    else
+    {
+        if (Nvram_CacheCount >= NVRAM_CACHE_SIZE)
+        {
+            ret = NVRAM_CACHE_Sync();
+        }
+
+        if (Nvram_CacheCount < NVRAM_CACHE_SIZE)
+        {
+            if (Nvram_CacheCount == 0)
+            {
+                Nvram_CacheTick = HAL_GetTick();
+            }
+            Nvram_Cache[Nvram_CacheCount].Addr  = addr;
+            Nvram_Cache[Nvram_CacheCount].Value = value;
+            Nvram_CacheCount++;
+            ret = NVRAM_OK;
+        }
+    }
+
+    NVRAM_CACHE_Unlock();
+    NVRAM_CACHE_Latency(HAL_GetTick() - tick);
+    return ret;
+}
+
+NVRAM_STATUS NVRAM_CACHE_Read(uint32_t addr, uint32_t *value)
+{
+    NVRAM_STATUS ret = NVRAM_OK;
+
+    NVRAM_CACHE_Lock(osWaitForever);
+    int i = Nvram_TxOpen ? NVRAM_TX_Find(addr) : -1;
+    if (i >= 0)
+    {
+        *value = Nvram_TxValue[i];
+    }
+    else if ((i = NVRAM_CACHE_Find(addr)) >= 0)
+    {
+        *value = Nvram_Cache[i].Value;
+    }
+    else
+    {
+        ret = Nvram_Dev.Read(addr, value);
+    }
+    NVRAM_CACHE_Unlock();
+
+    return ret;
+}
+
+/*!@brief Write a set of variables to device in one transaction, cache must be locked by
+ *         caller. Cached values of the set are dropped once the set is written.
+ */
+static NVRAM_STATUS NVRAM_CACHE_WriteSet(uint32_t *addr, uint32_t *value, uint16_t count)
+{
+    NVRAM_STATUS ret = Nvram_Dev.WriteTx(addr, value, count);
+
+    if (ret == NVRAM_OK)
+    {
+        for (uint16_t i = 0; i < count; i++)
+        {
+            int j = NVRAM_CACHE_Find(addr[i]);
+            if (j >= 0)
+            {
+                Nvram_Cache[j] = Nvram_Cache[--Nvram_CacheCount];
+            }
+        }
+        Nvram_CacheStat.FlashWrite += count;
+        Nvram_CacheStat.Commit++;
+    }
+
+    return ret;
+}
+
+/*!@brief Write a set of variables to device in one transaction, bypassing the cache.
+ */
+NVRAM_STATUS NVRAM_CACHE_WriteTx(uint32_t *addr, uint32_t *value, uint16_t count)
+{
+    if (Nvram_Dev.WriteTx == NULL)
+    {
+        return NVRAM_ERR_IF;
+    }
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if ((addr[i] == 0) || (addr[i] >= EE_BLOB_VIRTADDR))
+        {
+            return NVRAM_ERR_PARAM;
+        }
+    }
+
+    NVRAM_CACHE_Lock(osWaitForever);
+    NVRAM_STATUS ret = NVRAM_CACHE_WriteSet(addr, value, count);
+    NVRAM_CACHE_Unlock();
+
+    return ret;
+}
+
+/*!@brief Write a multi-byte value to device, bypassing the cache.
+ */
+NVRAM_STATUS NVRAM_CACHE_WriteEx(uint8_t reg, uint8_t *value, uint16_t len)
+{
+    if (Nvram_Dev.WriteEx == NULL)
+    {
+        return NVRAM_ERR_IF;
+    }
+
+    NVRAM_CACHE_Lock(osWaitForever);
+    NVRAM_STATUS ret = Nvram_Dev.WriteEx(reg, value, len);
+    NVRAM_CACHE_Unlock();
+
+    return ret;
+}
+
+/*!@brief Read a multi-byte value from device, cache is locked as device is shared with flush.
+ */
+NVRAM_STATUS NVRAM_CACHE_ReadEx(uint8_t reg, uint8_t *value, uint16_t len)
+{
+    if (Nvram_Dev.ReadEx == NULL)
+    {
+        return NVRAM_ERR_IF;
+    }
+
+    NVRAM_CACHE_Lock(osWaitForever);
+    NVRAM_STATUS ret = Nvram_Dev.ReadEx(reg, value, len);
+    NVRAM_CACHE_Unlock();
+
+    return ret;
+}
+
+/*!@brief Read a range of variables, the device reads them at once if it can. Cached and
+ *         staged writes are newer than device content and override it.
+ */
+NVRAM_STATUS NVRAM_CACHE_Snapshot(uint32_t addr, uint32_t count, uint32_t *value, uint32_t *valid)
+{
+    NVRAM_STATUS ret = NVRAM_OK;
+
+    NVRAM_CACHE_Lock(osWaitForever);
+    if (Nvram_Dev.Snapshot != NULL)
+    {
+        ret = Nvram_Dev.Snapshot(addr, count, value, valid);
+    }
+    else
+    {
+        memset(valid, 0, (count + 31) / 32 * sizeof(uint32_t));
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t read = 0;
+
+            if (Nvram_Dev.Read(addr + i, &read) == NVRAM_OK)
+            {
+                value[i] = read;
+                valid[i / 32] |= 1UL << (i % 32);
+            }
+        }
+    }
+
+    for (uint32_t i = 0; (ret == NVRAM_OK) && (i < Nvram_CacheCount); i++)
+    {
+        uint32_t n = Nvram_Cache[i].Addr - addr;
+
+        if (n < count)
+        {
+            value[n] = Nvram_Cache[i].Value;
+            valid[n / 32] |= 1UL << (n % 32);
+        }
+    }
+    for (uint32_t i = 0; (ret == NVRAM_OK) && Nvram_TxOpen && (i < Nvram_TxCount); i++)
+    {
+        uint32_t n = Nvram_TxAddr[i] - addr;
+
+        if (n < count)
+        {
+            value[n] = Nvram_TxValue[i];
+            valid[n / 32] |= 1UL << (n % 32);
+        }
+    }
+    NVRAM_CACHE_Unlock();
+
+    return ret;
+}
+
+/*!@var Nvram_DevIsr
+ * Devices the PVD interrupt writes to. Internal flash is programmed by polling and its cleanup
+ * interrupt preempts PVD. QSPI requests sleep until the I/O task serves them and the I2C bus
+ * is shared with task transfers, their flush is left to a task.
+ */
+static const uint8_t Nvram_DevIsr[NVRAM_DEV_NUM] = {
+    [NVRAM_DEV_EMUL] = 1,
+    [NVRAM_DEV_QSPI] = 0,
+    [NVRAM_DEV_I2C]  = 0,
+};
+
+/*!@brief PVD interrupt on supply falling below PWR_PVDLEVEL_4 (~2.6V), save cached variables
+ *        before brown-out reset. If a task is in the cache, flush is done when it unlocks.
+ *        A device not written from interrupt is flushed by the next Bsp_Nvram_Task().
+ */
+void HAL_PWR_PVDCallback(void)
+{
+    if (!Nvram_DevIsr[Nvram_DevSel] || Nvram_CacheBusy)
+    {
+        Nvram_CachePending = 1;
+        return;
+    }
+
+    // The mutex may be taken by a task not inside yet, it touched nothing.
+    Nvram_CacheBusy = 1;
+    NVRAM_CACHE_Sync();
+    Nvram_CacheBusy = 0;
+}
+
+NVRAM_STATUS Bsp_Nvram_Init()
+{
+    PWR_PVDTypeDef pvd = {.PVDLevel = PWR_PVDLEVEL_4, .Mode = PWR_PVD_MODE_IT_RISING};
+
+    Nvram_DevSel = NVRAM_DEVICE;
+    Nvram_Dev    = Nvram_DevTab[Nvram_DevSel];
+
+    Nvram_Drv.Init    = NVRAM_CACHE_Init;
+    Nvram_Drv.DeInit  = NVRAM_CACHE_DeInit;
+    Nvram_Drv.Erase   = NVRAM_CACHE_Erase;
+    Nvram_Drv.Flush   = NVRAM_CACHE_Flush;
+    Nvram_Drv.Clean   = Nvram_Dev.Clean;
+    Nvram_Drv.Write   = NVRAM_CACHE_Write;
+    Nvram_Drv.Read    = NVRAM_CACHE_Read;
+    Nvram_Drv.WriteTx = NVRAM_CACHE_WriteTx;
+    Nvram_Drv.WriteEx = NVRAM_CACHE_WriteEx;
+    Nvram_Drv.ReadEx  = NVRAM_CACHE_ReadEx;
+    Nvram_Drv.Snapshot = NVRAM_CACHE_Snapshot;
+    Nvram_Drv.GetInfo = Nvram_Dev.GetInfo;
+
+    // PVD output rises when VDD falls below the threshold.
+    HAL_PWR_ConfigPVD(&pvd);
+    HAL_PWR_EnablePVD();
+    HAL_NVIC_SetPriority(PVD_PVM_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(PVD_PVM_IRQn);
+
+    NVRAM_STATUS ret = Nvram_Drv.Init();
+    Nvram_Ready      = (ret == NVRAM_OK);
+
+    return ret;
 }
 
 NVRAM_STATUS Bsp_Nvram_DeInit()
 {
+    Nvram_Ready = 0;
     if (Nvram_Drv.DeInit != NULL)
     {
         Nvram_Drv.DeInit();
@@ -173,9 +934,199 @@ NVRAM_STATUS Bsp_Nvram_DeInit()
     Nvram_Drv.Init    = NULL;
     Nvram_Drv.DeInit  = NULL;
     Nvram_Drv.Erase   = NULL;
+    Nvram_Drv.Flush   = NULL;
+    Nvram_Drv.Clean   = NULL;
     Nvram_Drv.Write   = NULL;
     Nvram_Drv.Read    = NULL;
+    Nvram_Drv.WriteTx = NULL;
+    Nvram_Drv.WriteEx = NULL;
+    Nvram_Drv.ReadEx  = NULL;
+    Nvram_Drv.Snapshot = NULL;
     Nvram_Drv.GetInfo = NULL;
 
     return NVRAM_OK;
 }
+
+/*!@brief Switch the device behind the cache at run time.
+ *          Cached writes are flushed to the current device first, which stays bound
+ *          if the new device fails to init. Selection isn't kept across reset.
+ *
+ * @param dev   : Device to bind.
+ * @retval NVRAM_BUSY while a transaction is open or the cache can't be flushed.
+ */
+NVRAM_STATUS Bsp_Nvram_Select(NVRAM_DEV dev)
+{
+    NVRAM_STATUS ret;
+
+    if (dev >= NVRAM_DEV_NUM)
+    {
+        return NVRAM_ERR_PARAM;
+    }
+    if (dev == Nvram_DevSel)
+    {
+        return NVRAM_OK;
+    }
+
+    NVRAM_CACHE_Lock(osWaitForever);
+    if (Nvram_TxOpen || (NVRAM_CACHE_Sync() != NVRAM_OK) || (Nvram_CacheCount != 0))
+    {
+        ret = NVRAM_BUSY;
+    }
+    else if ((ret = Nvram_DevTab[dev].Init()) == NVRAM_OK)
+    {
+        if (Nvram_Dev.DeInit != NULL)
+        {
+            Nvram_Dev.DeInit();
+        }
+
+        Nvram_DevSel      = dev;
+        Nvram_Dev         = Nvram_DevTab[dev];
+        Nvram_Drv.Clean   = Nvram_Dev.Clean;
+        Nvram_Drv.GetInfo = Nvram_Dev.GetInfo;
+    }
+    NVRAM_CACHE_Unlock();
+
+    return ret;
+}
+
+NVRAM_DEV Bsp_Nvram_Device()
+{
+    return Nvram_DevSel;
+}
+
+/*!@brief NVRAM is up, Nvram_Drv can be called.
+ */
+uint8_t Bsp_Nvram_IsInit()
+{
+    return Nvram_Ready;
+}
+
+/*!@brief Write cached variables to device, call before reset.
+ */
+NVRAM_STATUS Bsp_Nvram_Flush()
+{
+    return (Nvram_Drv.Flush != NULL) ? Nvram_Drv.Flush() : NVRAM_OK;
+}
+
+/*!@brief Read current values of variables addr ~ addr + count - 1 at once.
+ *
+ * @param value : Array of count values, value[n] receives variable addr + n.
+ * @param valid : Bitmap of (count + 31) / 32 words, bit n set if variable addr + n is found.
+ */
+NVRAM_STATUS Bsp_Nvram_Snapshot(uint32_t addr, uint32_t count, uint32_t *value, uint32_t *valid)
+{
+    return (Nvram_Drv.Snapshot != NULL) ? Nvram_Drv.Snapshot(addr, count, value, valid)
+                                        : NVRAM_ERR_IF;
+}
+
+/*!@brief Load variables 0 ~ NVRAM_CONFIG_SIZE - 1 to Nvram_Config, on boot once device is
+ *         initialized.
+ */
+NVRAM_STATUS Bsp_Nvram_LoadConfig()
+{
+    uint32_t     tick = HAL_GetTick();
+    NVRAM_STATUS ret  = Bsp_Nvram_Snapshot(0, NVRAM_CONFIG_SIZE, Nvram_Config.Value,
+                                          Nvram_Config.Valid);
+
+    Nvram_Config.LoadTime = HAL_GetTick() - tick;
+    return ret;
+}
+
+/*!@brief Start a transaction, following Nvram_Drv.Write() are staged until Bsp_Nvram_Commit().
+ *        Up to NVRAM_TX_SIZE variables, Nvram_Drv.Read() returns the staged values.
+ */
+NVRAM_STATUS Bsp_Nvram_Begin()
+{
+    NVRAM_STATUS ret = NVRAM_BUSY;
+
+    if (Nvram_Drv.WriteTx == NULL)
+    {
+        return NVRAM_ERR_IF;
+    }
+
+    NVRAM_CACHE_Lock(osWaitForever);
+    if (!Nvram_TxOpen)
+    {
+        Nvram_TxCount = 0;
+        Nvram_TxOpen  = 1;
+        ret           = NVRAM_OK;
+    }
+    NVRAM_CACHE_Unlock();
+
+    return ret;
+}
+
+/*!@brief Write the staged variables to device, all or none of them. Variables the device
+ *        already holds and not pending in the cache are dropped from the set.
+ */
+NVRAM_STATUS Bsp_Nvram_Commit()
+{
+    NVRAM_STATUS ret   = NVRAM_OK;
+    uint16_t     count = 0;
+
+    NVRAM_CACHE_Lock(osWaitForever);
+    if (!Nvram_TxOpen)
+    {
+        NVRAM_CACHE_Unlock();
+        return NVRAM_ERR_PARAM;
+    }
+
+    Nvram_TxOpen = 0;
+    for (uint32_t i = 0; i < Nvram_TxCount; i++)
+    {
+        uint32_t current = 0;
+
+        if ((Nvram_Dev.Read(Nvram_TxAddr[i], &current) == NVRAM_OK) &&
+            (current == Nvram_TxValue[i]) && (NVRAM_CACHE_Find(Nvram_TxAddr[i]) < 0))
+        {
+            Nvram_CacheStat.Elided++;
+            continue;
+        }
+        Nvram_TxAddr[count]  = Nvram_TxAddr[i];
+        Nvram_TxValue[count] = Nvram_TxValue[i];
+        count++;
+    }
+    Nvram_TxCount = 0;
+
+    // Staging is written while locked, so that no other task stages over it.
+    if (count > 0)
+    {
+        ret = NVRAM_CACHE_WriteSet(Nvram_TxAddr, Nvram_TxValue, count);
+    }
+    NVRAM_CACHE_Unlock();
+
+    return ret;
+}
+
+/*!@brief Drop the staged variables, nothing is written.
+ */
+void Bsp_Nvram_Abort()
+{
+    NVRAM_CACHE_Lock(osWaitForever);
+    Nvram_TxOpen  = 0;
+    Nvram_TxCount = 0;
+    NVRAM_CACHE_Unlock();
+}
+
+/*!@brief Periodic task, run device cleanup in background, flush the cache NVRAM_CACHE_FLUSH_MS
+ *        after the first cached write. Flush is held while the device is busy on cleanup,
+ *        up to NVRAM_CACHE_HOLD_MS. A flush requested by PVD is done at once.
+ */
+void Bsp_Nvram_Task()
+{
+    // Another task in the cache, flush is tried on the next run.
+    if ((Nvram_Drv.Write == NULL) || !NVRAM_CACHE_Lock(0))
+    {
+        return;
+    }
+
+    uint8_t  busy    = (Nvram_Dev.Clean != NULL) && (Nvram_Dev.Clean() == NVRAM_BUSY);
+    uint32_t elapsed = HAL_GetTick() - Nvram_CacheTick;
+
+    if ((Nvram_CacheCount > 0) && (elapsed >= NVRAM_CACHE_FLUSH_MS) &&
+        (!busy || (elapsed >= NVRAM_CACHE_HOLD_MS)))
+    {
+        NVRAM_CACHE_Sync();
+    }
+    NVRAM_CACHE_Unlock();
+}
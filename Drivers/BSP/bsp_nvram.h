@@ -11,11 +11,34 @@
 #include "eeprom_emul.h"
 #include "stdint.h"
 
+// clang-format off
+#define NVRAM_CACHE_SIZE        32      //!< Number of variables held by the write-back cache
+#define NVRAM_CACHE_FLUSH_MS    1000    //!< Flush cache N ms after the first cached write
+#define NVRAM_CACHE_HOLD_MS     4000    //!< Maximum flush delay while device is busy on cleanup
+#define NVRAM_LATENCY_BUCKETS   8       //!< Write latency histogram, <1, <2, <4 ... >=64 ms
+#define NVRAM_TX_SIZE           64      //!< Max variables written by one transaction
+#define NVRAM_EX_SIZE           1024    //!< Max bytes of a WriteEx()/ReadEx() value, device may hold less
+#define NVRAM_CONFIG_SIZE       256     //!< Variables 0 ~ N-1 loaded to Nvram_Config at boot
+#define NVRAM_EX_WEAR           3       //!< WriteEx() register reserved for bsp_wear.h record
+// clang-format on
+
+typedef enum {
+    NVRAM_DEV_EMUL = 0, //!> STM32L476 internal flash EEPROM emulation
+    NVRAM_DEV_QSPI = 1, //!> Key-value store on N25Q128A QSPI flash
+    NVRAM_DEV_I2C  = 2, //!> External M24256 I2C EEPROM
+    NVRAM_DEV_NUM,
+} NVRAM_DEV;
+
+#ifndef NVRAM_DEVICE
+#define NVRAM_DEVICE NVRAM_DEV_EMUL //!< Device bound by Bsp_Nvram_Init(), see Bsp_Nvram_Select()
+#endif
+
 typedef enum {
     NVRAM_OK        = 0,
     NVRAM_FAIL      = -1,
     NVRAM_ERR_PARAM = 1,
     NVRAM_ERR_IF    = 2,
+    NVRAM_BUSY      = 3,
 } NVRAM_STATUS;
 
 typedef struct {
@@ -32,20 +55,58 @@ typedef struct {
     NVRAM_STATUS (*Init)(void);
     NVRAM_STATUS (*DeInit)(void);
     NVRAM_STATUS (*Erase)(void);
+    NVRAM_STATUS (*Flush)(void);
+    NVRAM_STATUS (*Clean)(void); //!> Background maintenance, return NVRAM_BUSY while running
 
     /*! Register R/W Function */
     NVRAM_STATUS (*Write)(uint32_t addr, uint32_t value);
     NVRAM_STATUS (*Read)(uint32_t addr, uint32_t *value);
+    NVRAM_STATUS (*WriteTx)(uint32_t *addr, uint32_t *value, uint16_t count); //!> All or none
     NVRAM_STATUS (*WriteEx)(uint8_t reg, uint8_t *value, uint16_t len);
     NVRAM_STATUS (*ReadEx)(uint8_t reg, uint8_t *value, uint16_t len);
+    NVRAM_STATUS (*Snapshot)(uint32_t addr, uint32_t count, uint32_t *value, uint32_t *valid);
 
     /*! Get Value*/
     NVRAM_STATUS (*GetInfo)(Nvram_InfoTypeDef *info);
 } Nvram_DrvTypeDef;
 
-Nvram_DrvTypeDef Nvram_Drv;
+typedef struct {
+    uint32_t Write;      //!> Write requests
+    uint32_t Elided;     //!> Writes dropped as the device already holds the value
+    uint32_t Coalesced;  //!> Writes merged into a cached variable
+    uint32_t FlashWrite; //!> Writes passed to the device
+    uint32_t Flush;      //!> Cache flushes
+    uint32_t Commit;     //!> Transactions written to the device
+} Nvram_CacheStatTypeDef;
+
+typedef struct {
+    uint32_t Count;                         //!> Write requests
+    uint32_t Max;                           //!> Longest write in ms
+    uint32_t Bucket[NVRAM_LATENCY_BUCKETS]; //!> Bucket[n] counts writes < 2^n ms, last >= 64 ms
+} Nvram_LatencyTypeDef;
+
+typedef struct {
+    uint32_t Value[NVRAM_CONFIG_SIZE];             //!> Value of variable n
+    uint32_t Valid[(NVRAM_CONFIG_SIZE + 31) / 32]; //!> Bit n set if variable n is found
+    uint32_t LoadTime;                             //!> Time to load in ms
+} Nvram_ConfigTypeDef;
+
+extern Nvram_DrvTypeDef       Nvram_Drv;
+extern Nvram_CacheStatTypeDef Nvram_CacheStat;
+extern Nvram_LatencyTypeDef   Nvram_WriteLatency;
+extern Nvram_ConfigTypeDef    Nvram_Config;
 
 NVRAM_STATUS Bsp_Nvram_Init();
 NVRAM_STATUS Bsp_Nvram_DeInit();
+NVRAM_STATUS Bsp_Nvram_Select(NVRAM_DEV dev);
+NVRAM_DEV    Bsp_Nvram_Device();
+uint8_t      Bsp_Nvram_IsInit();
+NVRAM_STATUS Bsp_Nvram_Flush();
+NVRAM_STATUS Bsp_Nvram_Snapshot(uint32_t addr, uint32_t count, uint32_t *value, uint32_t *valid);
+NVRAM_STATUS Bsp_Nvram_LoadConfig();
+NVRAM_STATUS Bsp_Nvram_Begin();
+NVRAM_STATUS Bsp_Nvram_Commit();
+void         Bsp_Nvram_Abort();
+void         Bsp_Nvram_Task();
 
 #endif /* INC_BSP_BSP_NVRAM_H_ */
@@ -0,0 +1,650 @@
+/******************************************************************************
+ * @file    bsp_nvram_i2c.c
+ * @brief   NVRAM device on an external M24256 I2C EEPROM on I2C1 (PB6/PB7).
+ *
+ *          Each variable has a fixed slot of value & ~value at addr * 8, a torn or
+ *          never written slot reads as not found. Variable writes go to a page
+ *          buffer and the bytes changed in a page are written by one page write,
+ *          when a write or read moves to another page, or by I2C_EEP_Flush().
+ *          The cache sorts its flush by address, so neighbour variables share it.
+ *
+ *          Acknowledge polling: a page write is followed by a write cycle of up to
+ *          tW = 5 ms, the device doesn't answer its address until it ends. Next
+ *          access polls the device address instead of waiting tW after each write,
+ *          so the CPU runs while the cycle lasts and waits only for its real end.
+ *
+ *          Reads of I2C_EEP_DMA_MIN bytes and more are done by DMA: snapshots of
+ *          variables, page loads of sequential variable reads, journal and
+ *          multi-byte values.
+ *
+ *          Transaction: pairs then a header with their crc are written to a journal,
+ *          then variables, then the header is cleared. I2C_EEP_Init() completes a
+ *          journal left by a reset. Multi-byte values alternate between 2 slots, the
+ *          header with sequence and data crc is written after the data.
+ *          A variable write cut by a power loss may tear the bytes of its page write,
+ *          the variables of those bytes read as not found.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include "bsp_nvram_i2c.h"
+#include "cmsis_os.h"
+#include "stdio.h"
+#include "string.h"
+
+#include "dfu_crc.h"
+
+// clang-format off
+#define I2C_EEP_MAGIC           0x5045454E  //!< "NEEP", slot of variable 0 on formatted device
+#define I2C_EEP_TX_MAGIC        0x5854454E  //!< "NETX", journal holds a transaction
+#define I2C_EEP_SLOT_SIZE       8           //!< Variable slot, value & ~value
+#define I2C_EEP_TX_PAIRS        (I2C_EEP_TX_BASE + 16)
+#define I2C_EEP_EX_END          (I2C_EEP_EX_BASE + 2 * I2C_EEP_EX_REGS * I2C_EEP_EX_SLOT)
+#define I2C_EEP_INIT_TRIALS     10          //!< Address trials of device detection
+// clang-format on
+
+#if (I2C_EEP_VARS * I2C_EEP_SLOT_SIZE > I2C_EEP_TX_BASE)
+#error "I2C_EEP_VARS overlaps the transaction journal"
+#endif
+
+#if (I2C_EEP_TX_PAIRS + NVRAM_TX_SIZE * 8 > I2C_EEP_EX_BASE) || (NVRAM_TX_SIZE * 8 > NVRAM_EX_SIZE)
+#error "NVRAM_TX_SIZE too large for the transaction journal"
+#endif
+
+#if (I2C_EEP_EX_END > I2C_EEP_SIZE)
+#error "I2C_EEP_EX_REGS too large for device size"
+#endif
+
+typedef struct {
+    int32_t Page;  //!< Buffered page, -1 for none
+    uint8_t Valid; //!< Whole page is read from device
+    uint8_t Lo;    //!< Changed bytes [Lo, Hi) to write
+    uint8_t Hi;
+    uint8_t Data[I2C_EEP_PAGE_SIZE];
+} I2C_EEP_PageTypeDef;
+
+typedef struct {
+    uint32_t Magic; //!< I2C_EEP_TX_MAGIC, cleared once variables are written
+    uint32_t Count; //!< Pairs of address, value
+    uint32_t Crc;   //!< CRC32 of the pairs
+} I2C_EEP_JournalTypeDef;
+
+typedef struct {
+    uint16_t Length;   //!< Data length in bytes
+    uint16_t Sequence; //!< Newer slot of a reg has the higher sequence
+    uint32_t Crc;      //!< CRC32 of the data
+    uint32_t Check;    //!< ~(Length | Sequence << 16), header is torn if not matching
+} I2C_EEP_ExTypeDef;
+
+I2C_EEP_StatTypeDef I2C_EEP_Stat = {0};
+
+static I2C_EEP_PageTypeDef I2C_EEP_Page     = {.Page = -1};
+static uint8_t             I2C_EEP_Buffer[NVRAM_EX_SIZE]; //!< Journal & multi-byte value buffer
+static uint8_t             I2C_EEP_Busy     = 0;          //!< Write cycle may be running
+static uint32_t            I2C_EEP_Last     = 0;          //!< Last variable read
+static volatile int8_t     I2C_EEP_DmaState = 0;          //!< [1] Running, [0] Done, [-1] Error
+
+osSemaphoreDef(I2C_EEP_DmaEvent);
+static osSemaphoreId I2C_EEP_DmaEvent = NULL; //!< Given by the DMA read completion
+
+void EEPROM_I2C_IO_ReadCpltCallback(HAL_StatusTypeDef status)
+{
+    I2C_EEP_DmaState = (status == HAL_OK) ? 0 : -1;
+    if (I2C_EEP_DmaEvent != NULL)
+    {
+        osSemaphoreRelease(I2C_EEP_DmaEvent);
+    }
+}
+
+/*!@brief Wait for the end of the write cycle by acknowledge polling.
+ */
+static NVRAM_STATUS I2C_EEP_Ready(void)
+{
+    uint32_t tick = HAL_GetTick();
+    uint32_t poll = 0;
+
+    if (!I2C_EEP_Busy)
+    {
+        return NVRAM_OK;
+    }
+
+    while (EEPROM_I2C_IO_IsDeviceReady(I2C_EEP_DEV_ADDR, 1) != HAL_OK)
+    {
+        poll++;
+        if (HAL_GetTick() - tick > I2C_EEP_WRITE_TIMEOUT)
+        {
+            I2C_EEP_Stat.Poll += poll;
+            return NVRAM_FAIL;
+        }
+    }
+
+    I2C_EEP_Busy = 0;
+    I2C_EEP_Stat.Poll += poll;
+    I2C_EEP_Stat.PollMax = (poll > I2C_EEP_Stat.PollMax) ? poll : I2C_EEP_Stat.PollMax;
+    return NVRAM_OK;
+}
+
+static NVRAM_STATUS I2C_EEP_ReadAt(uint32_t offset, void *data, uint32_t len)
+{
+    HAL_StatusTypeDef ret = HAL_OK;
+
+    if (I2C_EEP_Ready() != NVRAM_OK)
+    {
+        return NVRAM_FAIL;
+    }
+
+    I2C_EEP_Stat.Read++;
+    if (len < I2C_EEP_DMA_MIN)
+    {
+        ret = EEPROM_I2C_IO_ReadData(I2C_EEP_DEV_ADDR, offset, data, len);
+        return (ret == HAL_OK) ? NVRAM_OK : NVRAM_FAIL;
+    }
+
+    // 9 bits per byte at 100 kHz at least, 1 ms margin.
+    uint32_t tick    = HAL_GetTick();
+    uint32_t timeout = 1 + len / 10;
+
+    if ((I2C_EEP_DmaEvent == NULL) && osKernelRunning())
+    {
+        I2C_EEP_DmaEvent = osSemaphoreCreate(osSemaphore(I2C_EEP_DmaEvent), 1);
+    }
+
+    I2C_EEP_Stat.DmaRead++;
+    I2C_EEP_DmaState = 1;
+    if (EEPROM_I2C_IO_ReadDataDMA(I2C_EEP_DEV_ADDR, offset, data, len) != HAL_OK)
+    {
+        I2C_EEP_DmaState = 0;
+        return NVRAM_FAIL;
+    }
+
+    // Sleep until the completion, a token left by an earlier read only checks once more.
+    while (I2C_EEP_DmaState == 1)
+    {
+        uint32_t spent = HAL_GetTick() - tick;
+
+        if (spent > timeout)
+        {
+            EEPROM_I2C_IO_AbortDMA(I2C_EEP_DEV_ADDR);
+            I2C_EEP_DmaState = -1;
+            break;
+        }
+        if (I2C_EEP_DmaEvent != NULL)
+        {
+            osSemaphoreWait(I2C_EEP_DmaEvent, timeout + 1 - spent);
+        }
+    }
+    return (I2C_EEP_DmaState == 0) ? NVRAM_OK : NVRAM_FAIL;
+}
+
+/*!@brief Write data, split at page boundaries, one write cycle per page.
+ */
+static NVRAM_STATUS I2C_EEP_WriteAt(uint32_t offset, const void *data, uint32_t len)
+{
+    const uint8_t *buf = data;
+
+    while (len > 0)
+    {
+        uint32_t size = I2C_EEP_PAGE_SIZE - offset % I2C_EEP_PAGE_SIZE;
+        size          = (size > len) ? len : size;
+
+        if ((I2C_EEP_Ready() != NVRAM_OK) ||
+            (EEPROM_I2C_IO_WriteData(I2C_EEP_DEV_ADDR, offset, (uint8_t *)buf, size) != HAL_OK))
+        {
+            return NVRAM_FAIL;
+        }
+
+        I2C_EEP_Busy = 1;
+        I2C_EEP_Stat.PageWrite++;
+        I2C_EEP_Stat.ByteWrite += size;
+        offset += size;
+        buf += size;
+        len -= size;
+    }
+    return NVRAM_OK;
+}
+
+/*!@brief Read the bytes of the buffered page not changed by writes.
+ */
+static NVRAM_STATUS I2C_EEP_Fill(void)
+{
+    uint8_t data[I2C_EEP_PAGE_SIZE];
+
+    if (I2C_EEP_ReadAt(I2C_EEP_Page.Page * I2C_EEP_PAGE_SIZE, data, sizeof(data)) != NVRAM_OK)
+    {
+        return NVRAM_FAIL;
+    }
+
+    memcpy(I2C_EEP_Page.Data, data, I2C_EEP_Page.Lo);
+    memcpy(I2C_EEP_Page.Data + I2C_EEP_Page.Hi, data + I2C_EEP_Page.Hi,
+           I2C_EEP_PAGE_SIZE - I2C_EEP_Page.Hi);
+    I2C_EEP_Page.Valid = 1;
+    return NVRAM_OK;
+}
+
+/*!@brief Move the page buffer to a page, changes of the previous page are written first.
+ */
+static NVRAM_STATUS I2C_EEP_Select(int32_t page)
+{
+    if (I2C_EEP_Page.Page == page)
+    {
+        return NVRAM_OK;
+    }
+
+    if (I2C_EEP_Flush() != NVRAM_OK)
+    {
+        return NVRAM_FAIL;
+    }
+
+    I2C_EEP_Page.Page  = page;
+    I2C_EEP_Page.Valid = 0;
+    return NVRAM_OK;
+}
+
+/*!@brief Write the variables of the transaction in journal, then clear the journal.
+ *
+ * @param count : Pairs of address, value in I2C_EEP_Buffer.
+ */
+static NVRAM_STATUS I2C_EEP_Apply(uint32_t count)
+{
+    uint32_t *pair  = (uint32_t *)I2C_EEP_Buffer;
+    uint32_t  clear = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (I2C_EEP_Write(pair[2 * i], pair[2 * i + 1]) != NVRAM_OK)
+        {
+            return NVRAM_FAIL;
+        }
+    }
+
+    if (I2C_EEP_Flush() != NVRAM_OK)
+    {
+        return NVRAM_FAIL;
+    }
+    return I2C_EEP_WriteAt(I2C_EEP_TX_BASE, &clear, sizeof(clear));
+}
+
+/*!@brief Complete a transaction left in journal by a reset. Header is written after the
+ *         pairs, pairs failing the crc of a torn header are dropped.
+ */
+static NVRAM_STATUS I2C_EEP_Replay(void)
+{
+    I2C_EEP_JournalTypeDef journal;
+    uint32_t               clear = 0;
+
+    if (I2C_EEP_ReadAt(I2C_EEP_TX_BASE, &journal, sizeof(journal)) != NVRAM_OK)
+    {
+        return NVRAM_FAIL;
+    }
+
+    if ((journal.Magic != I2C_EEP_TX_MAGIC) || (journal.Count > NVRAM_TX_SIZE))
+    {
+        return NVRAM_OK;
+    }
+
+    if ((journal.Count > 0) &&
+        (I2C_EEP_ReadAt(I2C_EEP_TX_PAIRS, I2C_EEP_Buffer, journal.Count * 8) != NVRAM_OK))
+    {
+        return NVRAM_FAIL;
+    }
+
+    if (Dfu_crc32(0, I2C_EEP_Buffer, journal.Count * 8) != journal.Crc)
+    {
+        return I2C_EEP_WriteAt(I2C_EEP_TX_BASE, &clear, sizeof(clear));
+    }
+
+    I2C_EEP_Stat.Replay++;
+    return I2C_EEP_Apply(journal.Count);
+}
+
+/*!@brief Get the slot of a multi-byte value holding its newest data.
+ *
+ * @param reg   : Register.
+ * @param ex    : Return headers of both slots.
+ * @return Newest slot 0/1, -1 if none is valid.
+ */
+static int I2C_EEP_ExSlot(uint8_t reg, I2C_EEP_ExTypeDef *ex)
+{
+    uint8_t valid[2];
+
+    for (int i = 0; i < 2; i++)
+    {
+        uint32_t offset = I2C_EEP_EX_BASE + (2 * reg + i) * I2C_EEP_EX_SLOT;
+
+        valid[i] = (I2C_EEP_ReadAt(offset, &ex[i], sizeof(ex[i])) == NVRAM_OK) &&
+                   (ex[i].Check == ~(ex[i].Length | ((uint32_t)ex[i].Sequence << 16))) &&
+                   (ex[i].Length <= NVRAM_EX_SIZE);
+    }
+
+    if (valid[0] && valid[1])
+    {
+        return ((int16_t)(ex[1].Sequence - ex[0].Sequence) > 0) ? 1 : 0;
+    }
+    return valid[0] ? 0 : (valid[1] ? 1 : -1);
+}
+
+NVRAM_STATUS I2C_EEP_Init(void)
+{
+    uint32_t slot[2] = {0};
+
+    EEPROM_I2C_IO_Init();
+    I2C_EEP_Page.Page = -1;
+    I2C_EEP_Page.Lo   = 0;
+    I2C_EEP_Page.Hi   = 0;
+    I2C_EEP_Busy      = 0;
+
+    if (EEPROM_I2C_IO_IsDeviceReady(I2C_EEP_DEV_ADDR, I2C_EEP_INIT_TRIALS) != HAL_OK)
+    {
+        fprintf(stderr, "\e[31mI2C EEPROM not found at [0x%02X].\e[0m\n", I2C_EEP_DEV_ADDR);
+        return NVRAM_ERR_IF;
+    }
+
+    if (I2C_EEP_ReadAt(0, slot, sizeof(slot)) != NVRAM_OK)
+    {
+        return NVRAM_FAIL;
+    }
+
+    if ((slot[0] != I2C_EEP_MAGIC) || (slot[1] != ~I2C_EEP_MAGIC))
+    {
+        fprintf(stdout, "\e[33mI2C EEPROM is not formatted, erase it.\e[0m\n");
+        return I2C_EEP_Erase();
+    }
+
+    return I2C_EEP_Replay();
+}
+
+NVRAM_STATUS I2C_EEP_DeInit(void)
+{
+    NVRAM_STATUS ret = I2C_EEP_Flush();
+
+    return (I2C_EEP_Ready() == NVRAM_OK) ? ret : NVRAM_FAIL;
+}
+
+/*!@brief Set every slot to 0xFF, variables and values read as not found, then format.
+ */
+NVRAM_STATUS I2C_EEP_Erase(void)
+{
+    uint8_t  blank[I2C_EEP_PAGE_SIZE];
+    uint32_t slot[2] = {I2C_EEP_MAGIC, ~I2C_EEP_MAGIC};
+
+    I2C_EEP_Page.Page = -1;
+    I2C_EEP_Page.Lo   = 0;
+    I2C_EEP_Page.Hi   = 0;
+    memset(blank, 0xFF, sizeof(blank));
+
+    for (uint32_t offset = 0; offset < I2C_EEP_EX_END; offset += I2C_EEP_PAGE_SIZE)
+    {
+        if (I2C_EEP_WriteAt(offset, blank, sizeof(blank)) != NVRAM_OK)
+        {
+            return NVRAM_FAIL;
+        }
+    }
+    return I2C_EEP_WriteAt(0, slot, sizeof(slot));
+}
+
+/*!@brief Write the changed bytes of the page buffer, the page stays buffered if fully read.
+ *         On fail the changes are kept and written again on next flush.
+ */
+NVRAM_STATUS I2C_EEP_Flush(void)
+{
+    if (I2C_EEP_Page.Lo < I2C_EEP_Page.Hi)
+    {
+        uint32_t offset = I2C_EEP_Page.Page * I2C_EEP_PAGE_SIZE + I2C_EEP_Page.Lo;
+
+        if (I2C_EEP_WriteAt(offset, I2C_EEP_Page.Data + I2C_EEP_Page.Lo,
+                            I2C_EEP_Page.Hi - I2C_EEP_Page.Lo) != NVRAM_OK)
+        {
+            return NVRAM_FAIL;
+        }
+    }
+
+    I2C_EEP_Page.Lo   = 0;
+    I2C_EEP_Page.Hi   = 0;
+    I2C_EEP_Page.Page = I2C_EEP_Page.Valid ? I2C_EEP_Page.Page : -1;
+    return NVRAM_OK;
+}
+
+/*!@brief Background maintenance, write a page left in buffer.
+ */
+NVRAM_STATUS I2C_EEP_Clean(void)
+{
+    return I2C_EEP_Flush();
+}
+
+/*!@brief Write a variable to the page buffer, written to device by I2C_EEP_Flush() or
+ *         when another page is accessed.
+ */
+NVRAM_STATUS I2C_EEP_Write(uint32_t addr, uint32_t value)
+{
+    uint32_t slot[2] = {value, ~value};
+    uint32_t pos     = (addr * I2C_EEP_SLOT_SIZE) % I2C_EEP_PAGE_SIZE;
+
+    if ((addr == 0) || (addr >= I2C_EEP_VARS))
+    {
+        return NVRAM_ERR_PARAM;
+    }
+
+    if (I2C_EEP_Select(addr * I2C_EEP_SLOT_SIZE / I2C_EEP_PAGE_SIZE) != NVRAM_OK)
+    {
+        return NVRAM_FAIL;
+    }
+
+    if (I2C_EEP_Page.Lo == I2C_EEP_Page.Hi)
+    {
+        I2C_EEP_Page.Lo = pos;
+        I2C_EEP_Page.Hi = pos;
+    }
+    else
+    {
+        // Bytes between the changed ones are written too, they must be read first.
+        if (!I2C_EEP_Page.Valid && ((pos > I2C_EEP_Page.Hi) ||
+                                    (pos + I2C_EEP_SLOT_SIZE < I2C_EEP_Page.Lo)) &&
+            (I2C_EEP_Fill() != NVRAM_OK))
+        {
+            return NVRAM_FAIL;
+        }
+        I2C_EEP_Stat.Merged++;
+    }
+
+    memcpy(I2C_EEP_Page.Data + pos, slot, sizeof(slot));
+    I2C_EEP_Page.Lo = (pos < I2C_EEP_Page.Lo) ? pos : I2C_EEP_Page.Lo;
+    I2C_EEP_Page.Hi = (pos + sizeof(slot) > I2C_EEP_Page.Hi) ? pos + sizeof(slot) : I2C_EEP_Page.Hi;
+    return NVRAM_OK;
+}
+
+/*!@brief Read a variable, from the page buffer if it holds it. A read following the read of
+ *         the previous variable loads its whole page.
+ */
+NVRAM_STATUS I2C_EEP_Read(uint32_t addr, uint32_t *value)
+{
+    uint32_t slot[2] = {0};
+    int32_t  page    = addr * I2C_EEP_SLOT_SIZE / I2C_EEP_PAGE_SIZE;
+    uint32_t pos     = (addr * I2C_EEP_SLOT_SIZE) % I2C_EEP_PAGE_SIZE;
+
+    if ((addr == 0) || (addr >= I2C_EEP_VARS))
+    {
+        return NVRAM_ERR_PARAM;
+    }
+
+    if ((I2C_EEP_Page.Page == page) &&
+        (I2C_EEP_Page.Valid || ((pos >= I2C_EEP_Page.Lo) && (pos < I2C_EEP_Page.Hi))))
+    {
+        I2C_EEP_Stat.PageHit++;
+        memcpy(slot, I2C_EEP_Page.Data + pos, sizeof(slot));
+    }
+    else if (addr == I2C_EEP_Last + 1)
+    {
+        if ((I2C_EEP_Select(page) != NVRAM_OK) || (I2C_EEP_Fill() != NVRAM_OK))
+        {
+            return NVRAM_FAIL;
+        }
+        memcpy(slot, I2C_EEP_Page.Data + pos, sizeof(slot));
+    }
+    else if (I2C_EEP_ReadAt(addr * I2C_EEP_SLOT_SIZE, slot, sizeof(slot)) != NVRAM_OK)
+    {
+        return NVRAM_FAIL;
+    }
+
+    I2C_EEP_Last = addr;
+    *value       = slot[0];
+    return (slot[1] == ~slot[0]) ? NVRAM_OK : NVRAM_FAIL;
+}
+
+/*!@brief Write a set of variables through the journal, all or none of them after a reset.
+ */
+NVRAM_STATUS I2C_EEP_WriteTx(uint32_t *addr, uint32_t *value, uint16_t count)
+{
+    I2C_EEP_JournalTypeDef journal = {.Magic = I2C_EEP_TX_MAGIC, .Count = count};
+    uint32_t *             pair    = (uint32_t *)I2C_EEP_Buffer;
+
+    if (count > NVRAM_TX_SIZE)
+    {
+        return NVRAM_ERR_PARAM;
+    }
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if ((addr[i] == 0) || (addr[i] >= I2C_EEP_VARS))
+        {
+            return NVRAM_ERR_PARAM;
+        }
+        pair[2 * i]     = addr[i];
+        pair[2 * i + 1] = value[i];
+    }
+    journal.Crc = Dfu_crc32(0, I2C_EEP_Buffer, count * 8);
+
+    if ((I2C_EEP_Flush() != NVRAM_OK) ||
+        (I2C_EEP_WriteAt(I2C_EEP_TX_PAIRS, I2C_EEP_Buffer, count * 8) != NVRAM_OK) ||
+        (I2C_EEP_WriteAt(I2C_EEP_TX_BASE, &journal, sizeof(journal)) != NVRAM_OK))
+    {
+        return NVRAM_FAIL;
+    }
+
+    return I2C_EEP_Apply(count);
+}
+
+/*!@brief Write a multi-byte value to the slot not holding its newest data, header last.
+ *
+ * @param reg   : Register, up to I2C_EEP_EX_REGS - 1.
+ * @param value : Data, up to NVRAM_EX_SIZE bytes.
+ * @param len   : Data length in bytes.
+ */
+NVRAM_STATUS I2C_EEP_WriteEx(uint8_t reg, uint8_t *value, uint16_t len)
+{
+    I2C_EEP_ExTypeDef ex[2];
+
+    if ((reg >= I2C_EEP_EX_REGS) || (len > NVRAM_EX_SIZE))
+    {
+        return NVRAM_ERR_PARAM;
+    }
+
+    int      slot   = I2C_EEP_ExSlot(reg, ex);
+    uint16_t seq    = (slot < 0) ? 0 : ex[slot].Sequence + 1;
+    int      target = (slot == 0) ? 1 : 0;
+    uint32_t offset = I2C_EEP_EX_BASE + (2 * reg + target) * I2C_EEP_EX_SLOT;
+
+    ex[target].Length   = len;
+    ex[target].Sequence = seq;
+    ex[target].Crc      = Dfu_crc32(0, value, len);
+    ex[target].Check    = ~(len | ((uint32_t)seq << 16));
+
+    if ((I2C_EEP_WriteAt(offset + I2C_EEP_PAGE_SIZE, value, len) != NVRAM_OK) ||
+        (I2C_EEP_WriteAt(offset, &ex[target], sizeof(ex[target])) != NVRAM_OK))
+    {
+        return NVRAM_FAIL;
+    }
+    return NVRAM_OK;
+}
+
+/*!@brief Read a multi-byte value, from the older slot if the newest fails its crc.
+ *         Bytes after the value length are cleared.
+ *
+ * @param reg   : Register, up to I2C_EEP_EX_REGS - 1.
+ * @param value : Buffer receiving the data.
+ * @param len   : Buffer size in bytes.
+ */
+NVRAM_STATUS I2C_EEP_ReadEx(uint8_t reg, uint8_t *value, uint16_t len)
+{
+    I2C_EEP_ExTypeDef ex[2];
+
+    if (reg >= I2C_EEP_EX_REGS)
+    {
+        return NVRAM_ERR_PARAM;
+    }
+
+    int slot = I2C_EEP_ExSlot(reg, ex);
+    for (int i = 0; (i < 2) && (slot >= 0); i++, slot = 1 - slot)
+    {
+        uint32_t offset = I2C_EEP_EX_BASE + (2 * reg + slot) * I2C_EEP_EX_SLOT + I2C_EEP_PAGE_SIZE;
+
+        if ((ex[slot].Check != ~(ex[slot].Length | ((uint32_t)ex[slot].Sequence << 16))) ||
+            (ex[slot].Length > NVRAM_EX_SIZE) ||
+            ((ex[slot].Length > 0) &&
+             (I2C_EEP_ReadAt(offset, I2C_EEP_Buffer, ex[slot].Length) != NVRAM_OK)) ||
+            (Dfu_crc32(0, I2C_EEP_Buffer, ex[slot].Length) != ex[slot].Crc))
+        {
+            continue;
+        }
+
+        uint16_t length = (ex[slot].Length < len) ? ex[slot].Length : len;
+        memcpy(value, I2C_EEP_Buffer, length);
+        memset(value + length, 0, len - length);
+        return NVRAM_OK;
+    }
+    return NVRAM_FAIL;
+}
+
+/*!@brief Read variables addr ~ addr + count - 1 by DMA reads of their slots, up to
+ *         NVRAM_EX_SIZE bytes each, once the page buffer is written.
+ */
+NVRAM_STATUS I2C_EEP_Snapshot(uint32_t addr, uint32_t count, uint32_t *value, uint32_t *valid)
+{
+    uint32_t *slot = (uint32_t *)I2C_EEP_Buffer;
+
+    if (addr + count > I2C_EEP_VARS)
+    {
+        return NVRAM_ERR_PARAM;
+    }
+
+    memset(valid, 0, (count + 31) / 32 * sizeof(uint32_t));
+    if (I2C_EEP_Flush() != NVRAM_OK)
+    {
+        return NVRAM_FAIL;
+    }
+
+    for (uint32_t i = 0; i < count;)
+    {
+        uint32_t n = count - i;
+        n          = (n > NVRAM_EX_SIZE / I2C_EEP_SLOT_SIZE) ? NVRAM_EX_SIZE / I2C_EEP_SLOT_SIZE : n;
+
+        if (I2C_EEP_ReadAt((addr + i) * I2C_EEP_SLOT_SIZE, slot, n * I2C_EEP_SLOT_SIZE) != NVRAM_OK)
+        {
+            return NVRAM_FAIL;
+        }
+
+        // Slot of variable 0 holds the format magic.
+        for (uint32_t k = 0; k < n; k++, i++)
+        {
+            if ((addr + i != 0) && (slot[2 * k + 1] == ~slot[2 * k]))
+            {
+                value[i] = slot[2 * k];
+                valid[i / 32] |= 1UL << (i % 32);
+            }
+        }
+    }
+    return NVRAM_OK;
+}
+
+NVRAM_STATUS I2C_EEP_GetInfo(Nvram_InfoTypeDef *info)
+{
+    info->Interface  = "I2C";
+    info->DevName    = "M24256_I2C_EEPROM";
+    info->DevChannel = 1;
+    info->DevAddr    = I2C_EEP_DEV_ADDR;
+    info->DataBit    = 32;
+    info->DataVolume = I2C_EEP_VARS;
+
+    return NVRAM_OK;
+}
@@ -0,0 +1,68 @@
+/******************************************************************************
+ * @file    bsp_nvram_i2c.h
+ * @brief   NVRAM device on an external M24256 I2C EEPROM on I2C1 (PB6/PB7).
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef INC_BSP_BSP_NVRAM_I2C_H_
+#define INC_BSP_BSP_NVRAM_I2C_H_
+
+#include "bsp_nvram.h"
+#include "stdint.h"
+#include "stm32l4xx_hal.h"
+
+// clang-format off
+#define I2C_EEP_DEV_ADDR        0xA0        //!< M24256 with E2..E0 tied low
+#define I2C_EEP_SIZE            0x8000      //!< 256 Kbit
+#define I2C_EEP_PAGE_SIZE       64          //!< Write page, a write rolls over at page end
+#define I2C_EEP_VARS            512         //!< Variables of 8 bytes slot at addr * 8, addr 1 ~ N-1
+#define I2C_EEP_TX_BASE         0x1000      //!< Transaction journal, header then pairs
+#define I2C_EEP_EX_BASE         0x1400      //!< Multi-byte values, 2 slots per reg
+#define I2C_EEP_EX_REGS         8
+#define I2C_EEP_EX_SLOT         (I2C_EEP_PAGE_SIZE + NVRAM_EX_SIZE) //!< Header page + data
+#define I2C_EEP_WRITE_TIMEOUT   10          //!< Write cycle timeout in ms, tW is 5 ms max
+#define I2C_EEP_DMA_MIN         32          //!< Reads of N bytes and more are done by DMA
+// clang-format on
+
+typedef struct {
+    uint32_t PageWrite; //!> Page writes
+    uint32_t ByteWrite; //!> Bytes written
+    uint32_t Merged;    //!> Variable writes merged into a pending page write
+    uint32_t Read;      //!> Reads from device
+    uint32_t DmaRead;   //!> Reads by DMA
+    uint32_t PageHit;   //!> Variable reads served by the page buffer
+    uint32_t Poll;      //!> Acknowledge polls not answered, device in write cycle
+    uint32_t PollMax;   //!> Most polls of a write cycle
+    uint32_t Replay;    //!> Transactions completed from the journal at init
+} I2C_EEP_StatTypeDef;
+
+extern I2C_EEP_StatTypeDef I2C_EEP_Stat;
+
+/*! Link functions of the EEPROM, on board I2C1 */
+extern void              EEPROM_I2C_IO_Init(void);
+extern HAL_StatusTypeDef EEPROM_I2C_IO_WriteData(uint16_t DevAddress, uint16_t MemAddress,
+                                                 uint8_t *pBuffer, uint32_t BufferSize);
+extern HAL_StatusTypeDef EEPROM_I2C_IO_ReadData(uint16_t DevAddress, uint16_t MemAddress,
+                                                uint8_t *pBuffer, uint32_t BufferSize);
+extern HAL_StatusTypeDef EEPROM_I2C_IO_ReadDataDMA(uint16_t DevAddress, uint16_t MemAddress,
+                                                   uint8_t *pBuffer, uint32_t BufferSize);
+extern HAL_StatusTypeDef EEPROM_I2C_IO_AbortDMA(uint16_t DevAddress);
+extern HAL_StatusTypeDef EEPROM_I2C_IO_IsDeviceReady(uint16_t DevAddress, uint32_t Trials);
+
+NVRAM_STATUS I2C_EEP_Init(void);
+NVRAM_STATUS I2C_EEP_DeInit(void);
+NVRAM_STATUS I2C_EEP_Erase(void);
+NVRAM_STATUS I2C_EEP_Flush(void);
+NVRAM_STATUS I2C_EEP_Clean(void);
+NVRAM_STATUS I2C_EEP_Write(uint32_t addr, uint32_t value);
+NVRAM_STATUS I2C_EEP_Read(uint32_t addr, uint32_t *value);
+NVRAM_STATUS I2C_EEP_WriteTx(uint32_t *addr, uint32_t *value, uint16_t count);
+NVRAM_STATUS I2C_EEP_WriteEx(uint8_t reg, uint8_t *value, uint16_t len);
+NVRAM_STATUS I2C_EEP_ReadEx(uint8_t reg, uint8_t *value, uint16_t len);
+NVRAM_STATUS I2C_EEP_Snapshot(uint32_t addr, uint32_t count, uint32_t *value, uint32_t *valid);
+NVRAM_STATUS I2C_EEP_GetInfo(Nvram_InfoTypeDef *info);
+
+#endif /* INC_BSP_BSP_NVRAM_I2C_H_ */
@@ -0,0 +1,882 @@
+/******************************************************************************
+ * @file    bsp_nvram_qspi.c
+ * @brief   NVRAM device on the N25Q128A QSPI flash, a log-structured key-value store.
+ *
+ *          The store area is a circular log of 4 kB subsectors. Each write appends a
+ *          record (key, length, value, crc32) at the log head, the newest record of a
+ *          key holds its value. A RAM hash index maps each key to its newest record,
+ *          it is rebuilt by scanning the log at mount.
+ *
+ *          Subsector header holds its erase count, written after erase, and its log
+ *          sequence, written when the subsector is opened. Garbage collection copies
+ *          the records still indexed from the oldest subsector to the head, then
+ *          erases it. Subsectors are used in turn, so wear is even across the area.
+ *          QSPI_KV_Clean() collects in background below QSPI_KV_GC_FREE free
+ *          subsectors, a write collects inline below QSPI_KV_RESERVE.
+ *
+ *          Power loss: an interrupted record fails its crc and is ignored, the key
+ *          keeps its previous record. Writes resume in a new subsector after it.
+ *          A transaction is one record holding every variable of the set.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include "bsp_nvram_qspi.h"
+#include "stdio.h"
+#include "string.h"
+
+#include "bsp_qspi.h"
+#include "dfu_crc.h"
+
+// clang-format off
+#define QSPI_KV_MAGIC           0x564B564E  //!< "NVKV", xor erase count in subsector header
+#define QSPI_KV_ALIGN           16          //!< Record alignment, unit of index
+#define QSPI_KV_HEADER_SIZE     16          //!< Subsector header size
+#define QSPI_KV_ALIGN_SIZE(n)   (((n) + QSPI_KV_ALIGN - 1) & ~(QSPI_KV_ALIGN - 1))
+#define QSPI_KV_RECORD_MAX      QSPI_KV_ALIGN_SIZE(sizeof(QSPI_KV_RecordTypeDef) + QSPI_KV_VALUE_MAX)
+#define QSPI_KV_INDEX_SIZE      (1U << QSPI_KV_INDEX_BITS)
+#define QSPI_KV_KEY_NONE        0xFFFF      //!< Empty index slot, erased record
+#define QSPI_KV_STATE_DIRTY     0           //!< Free subsector, to erase before use
+#define QSPI_KV_STATE_BLANK     1           //!< Free subsector, erased with header
+#define QSPI_KV_STATE_USED      2           //!< Subsector in the log
+#define QSPI_KV_SCAN_ERROR      -2          //!< Device read fail
+#define QSPI_KV_SCAN_INVALID    -1          //!< Torn record, rest of subsector is unusable
+#define QSPI_KV_SCAN_END        0           //!< Erased record, end of subsector log
+#define QSPI_KV_SCAN_RECORD     1           //!< Valid record
+// clang-format on
+
+#if (QSPI_KV_SIZE / QSPI_KV_ALIGN) > 0x10000
+#error "QSPI_KV_SIZE too large for 16-bit record units of the index"
+#endif
+
+#if (QSPI_KV_MAX_KEYS >= QSPI_KV_INDEX_SIZE)
+#error "QSPI_KV_MAX_KEYS must leave empty slots in the index"
+#endif
+
+// Garbage collection always gains space while live records fill up to half of the area.
+#if (QSPI_KV_MAX_KEYS * QSPI_KV_ALIGN + 256 * (QSPI_KV_VALUE_MAX + 2 * QSPI_KV_ALIGN)) >          \
+    (QSPI_KV_SIZE / 2)
+#error "QSPI_KV_SIZE too small for QSPI_KV_MAX_KEYS and QSPI_KV_VALUE_MAX"
+#endif
+
+typedef struct {
+    uint32_t Magic;    //!< QSPI_KV_MAGIC ^ Erase, written after erase
+    uint32_t Erase;    //!< Erase count of the subsector
+    uint32_t Sequence; //!< Log order, written when the subsector is opened
+    uint32_t Check;    //!< ~Sequence
+} QSPI_KV_SubsectorTypeDef;
+
+typedef struct {
+    uint16_t Key;    //!< Variable address, QSPI_KV_KEY_EX + reg or QSPI_KV_KEY_TX
+    uint16_t Length; //!< Value length in bytes
+    uint32_t Crc;    //!< CRC32 of key, length and value
+} QSPI_KV_RecordTypeDef;
+
+typedef struct {
+    uint16_t Key;
+    uint16_t Unit; //!< Offset of the newest record in QSPI_KV_ALIGN units
+} QSPI_KV_IndexTypeDef;
+
+typedef struct {
+    uint32_t Addr; //!< Offset of QSPI_KV_Buffer[0]
+    uint32_t Fill; //!< Bytes loaded in QSPI_KV_Buffer
+    uint32_t Pos;  //!< Offset of next record
+    uint32_t End;  //!< Offset of subsector end
+} QSPI_KV_ScanTypeDef;
+
+QSPI_KV_StatTypeDef QSPI_KV_Stat = {0};
+
+static QSPI_KV_IndexTypeDef QSPI_KV_Index[QSPI_KV_INDEX_SIZE];
+static uint8_t              QSPI_KV_State[QSPI_KV_SUBSECTORS];
+static uint8_t              QSPI_KV_Buffer[QSPI_KV_RECORD_MAX]; //!< Scan & transaction read buffer
+static uint32_t             QSPI_KV_Head     = 0; //!< Subsector at the log head
+static uint32_t             QSPI_KV_Pos      = 0; //!< Offset of next record in head subsector
+static uint32_t             QSPI_KV_Used     = 0; //!< Subsectors in the log, tail to head
+static uint32_t             QSPI_KV_Sequence = 0; //!< Sequence of next opened subsector
+static uint8_t              QSPI_KV_Mounted  = 0;
+static uint8_t              QSPI_KV_Class    = QSPI_CLASS_INTERACTIVE; //!< Of QSPI requests
+
+static NVRAM_STATUS QSPI_KV_ReadAt(uint32_t offset, void *data, uint32_t size)
+{
+    uint8_t ret = Bsp_Qspi_Request(QSPI_OP_READ, QSPI_KV_Class, data, QSPI_KV_BASE + offset, size);
+    return (ret == QSPI_OK) ? NVRAM_OK : NVRAM_FAIL;
+}
+
+/*!@brief Read of a scan, past the QSPI cache: scans read each record once, into
+ *        QSPI_KV_Buffer, and would only evict the cached values.
+ */
+static NVRAM_STATUS QSPI_KV_ScanAt(uint32_t offset, void *data, uint32_t size)
+{
+    Qspi_ReqTypeDef req = {.Op    = QSPI_OP_READ,
+                           .Class = QSPI_KV_Class,
+                           .Data  = data,
+                           .Addr  = QSPI_KV_BASE + offset,
+                           .Size  = size};
+
+    uint8_t ret = Bsp_Qspi_Run(&req, 1);
+    return (ret == QSPI_OK) ? NVRAM_OK : NVRAM_FAIL;
+}
+
+static NVRAM_STATUS QSPI_KV_WriteAt(uint32_t offset, const void *data, uint32_t size)
+{
+    uint8_t ret = Bsp_Qspi_Request(QSPI_OP_WRITE, QSPI_KV_Class, (uint8_t *)data,
+                                   QSPI_KV_BASE + offset, size);
+    return (ret == QSPI_OK) ? NVRAM_OK : NVRAM_FAIL;
+}
+
+static NVRAM_STATUS QSPI_KV_EraseAt(uint32_t offset, uint32_t size)
+{
+    uint8_t ret = Bsp_Qspi_Request(QSPI_OP_ERASE, QSPI_KV_Class, NULL, QSPI_KV_BASE + offset, size);
+    return (ret == QSPI_OK) ? NVRAM_OK : NVRAM_FAIL;
+}
+
+/*!@brief Find the index slot of a key, linear probing.
+ *
+ * @return Slot holding the key, or the empty slot to insert it.
+ */
+static QSPI_KV_IndexTypeDef *QSPI_KV_Slot(uint16_t key)
+{
+    uint32_t i = (key * 0x9E3779B1U) >> (32 - QSPI_KV_INDEX_BITS);
+
+    while ((QSPI_KV_Index[i].Key != key) && (QSPI_KV_Index[i].Key != QSPI_KV_KEY_NONE))
+    {
+        i = (i + 1) & (QSPI_KV_INDEX_SIZE - 1);
+    }
+    return &QSPI_KV_Index[i];
+}
+
+/*!@brief Point a key to its newest record, insert the key if new.
+ */
+static NVRAM_STATUS QSPI_KV_Update(uint16_t key, uint32_t offset)
+{
+    QSPI_KV_IndexTypeDef *slot = QSPI_KV_Slot(key);
+
+    if (slot->Key != key)
+    {
+        if (QSPI_KV_Stat.Keys >= QSPI_KV_MAX_KEYS)
+        {
+            return NVRAM_FAIL;
+        }
+        slot->Key = key;
+        QSPI_KV_Stat.Keys++;
+    }
+    slot->Unit = offset / QSPI_KV_ALIGN;
+    return NVRAM_OK;
+}
+
+static void QSPI_KV_Reset(void)
+{
+    memset(QSPI_KV_Index, 0xFF, sizeof(QSPI_KV_Index));
+    QSPI_KV_Stat.Keys = 0;
+    QSPI_KV_Head      = QSPI_KV_SUBSECTORS - 1;
+    QSPI_KV_Pos       = QSPI_KV_SUBSECTOR_SIZE;
+    QSPI_KV_Used      = 0;
+    QSPI_KV_Sequence  = 0;
+    QSPI_KV_Stat.Free = QSPI_KV_SUBSECTORS;
+}
+
+/*!@brief Start a scan of the records of a subsector.
+ */
+static void QSPI_KV_ScanStart(QSPI_KV_ScanTypeDef *scan, uint32_t subsector)
+{
+    scan->Pos  = subsector * QSPI_KV_SUBSECTOR_SIZE + QSPI_KV_HEADER_SIZE;
+    scan->End  = (subsector + 1) * QSPI_KV_SUBSECTOR_SIZE;
+    scan->Addr = scan->Pos;
+    scan->Fill = 0;
+}
+
+/*!@brief Load QSPI_KV_Buffer from a record, unless the record is already in it.
+ */
+static NVRAM_STATUS QSPI_KV_ScanLoad(QSPI_KV_ScanTypeDef *scan, uint32_t size)
+{
+    if (scan->Pos + size <= scan->Addr + scan->Fill)
+    {
+        return NVRAM_OK;
+    }
+
+    scan->Addr = scan->Pos;
+    scan->Fill = scan->End - scan->Pos;
+    scan->Fill = (scan->Fill > sizeof(QSPI_KV_Buffer)) ? sizeof(QSPI_KV_Buffer) : scan->Fill;
+    return QSPI_KV_ScanAt(scan->Addr, QSPI_KV_Buffer, scan->Fill);
+}
+
+/*!@brief Get next record of a scan, verified by its crc.
+ *
+ * @param record : Return the record, in QSPI_KV_Buffer until next scan.
+ * @return QSPI_KV_SCAN_RECORD, QSPI_KV_SCAN_END, QSPI_KV_SCAN_INVALID or QSPI_KV_SCAN_ERROR.
+ */
+static int QSPI_KV_ScanNext(QSPI_KV_ScanTypeDef *scan, QSPI_KV_RecordTypeDef **record)
+{
+    const uint32_t         erased[2] = {0xFFFFFFFF, 0xFFFFFFFF};
+    QSPI_KV_RecordTypeDef *rec       = NULL;
+
+    if (scan->Pos + sizeof(QSPI_KV_RecordTypeDef) > scan->End)
+    {
+        return QSPI_KV_SCAN_END;
+    }
+
+    if (QSPI_KV_ScanLoad(scan, sizeof(QSPI_KV_RecordTypeDef)) != NVRAM_OK)
+    {
+        return QSPI_KV_SCAN_ERROR;
+    }
+
+    rec = (QSPI_KV_RecordTypeDef *)&QSPI_KV_Buffer[scan->Pos - scan->Addr];
+    if (memcmp(rec, erased, sizeof(QSPI_KV_RecordTypeDef)) == 0)
+    {
+        return QSPI_KV_SCAN_END;
+    }
+
+    if ((rec->Length > QSPI_KV_VALUE_MAX) ||
+        (scan->Pos + sizeof(QSPI_KV_RecordTypeDef) + rec->Length > scan->End))
+    {
+        return QSPI_KV_SCAN_INVALID;
+    }
+
+    if (QSPI_KV_ScanLoad(scan, sizeof(QSPI_KV_RecordTypeDef) + rec->Length) != NVRAM_OK)
+    {
+        return QSPI_KV_SCAN_ERROR;
+    }
+
+    rec          = (QSPI_KV_RecordTypeDef *)&QSPI_KV_Buffer[scan->Pos - scan->Addr];
+    uint32_t crc = Dfu_crc32(0, (const uint8_t *)rec, 4);
+    if (Dfu_crc32(crc, (const uint8_t *)(rec + 1), rec->Length) != rec->Crc)
+    {
+        return QSPI_KV_SCAN_INVALID;
+    }
+
+    *record = rec;
+    scan->Pos += QSPI_KV_ALIGN_SIZE(sizeof(QSPI_KV_RecordTypeDef) + rec->Length);
+    return QSPI_KV_SCAN_RECORD;
+}
+
+/*!@brief Erase a subsector and write its header with the erase count.
+ */
+static NVRAM_STATUS QSPI_KV_Prepare(uint32_t subsector)
+{
+    QSPI_KV_SubsectorTypeDef header = {0};
+    uint32_t                 offset = subsector * QSPI_KV_SUBSECTOR_SIZE;
+    uint32_t                 erase  = QSPI_KV_Stat.EraseMax;
+
+    // Erase count is lost on a torn header, assume the worst.
+    if ((QSPI_KV_ReadAt(offset, &header, sizeof(header)) == NVRAM_OK) &&
+        ((header.Magic ^ header.Erase) == QSPI_KV_MAGIC))
+    {
+        erase = header.Erase;
+    }
+
+    QSPI_KV_State[subsector] = QSPI_KV_STATE_DIRTY;
+    if (QSPI_KV_EraseAt(offset, QSPI_KV_SUBSECTOR_SIZE) != NVRAM_OK)
+    {
+        return NVRAM_FAIL;
+    }
+    QSPI_KV_Stat.Erase++;
+
+    header.Erase = erase + 1;
+    header.Magic = QSPI_KV_MAGIC ^ header.Erase;
+    if (QSPI_KV_WriteAt(offset, &header, 8) != NVRAM_OK)
+    {
+        return NVRAM_FAIL;
+    }
+
+    QSPI_KV_State[subsector] = QSPI_KV_STATE_BLANK;
+    QSPI_KV_Stat.EraseMax = (header.Erase > QSPI_KV_Stat.EraseMax) ? header.Erase
+                                                                   : QSPI_KV_Stat.EraseMax;
+    return NVRAM_OK;
+}
+
+static NVRAM_STATUS QSPI_KV_Collect(void);
+
+/*!@brief Open the subsector after the head as new log head.
+ *
+ * @param gc    : Called by garbage collection, which may use the reserved subsectors.
+ */
+static NVRAM_STATUS QSPI_KV_Open(uint8_t gc)
+{
+    uint32_t sequence[2] = {QSPI_KV_Sequence, ~QSPI_KV_Sequence};
+    uint32_t next        = 0;
+
+    // Keep QSPI_KV_RESERVE free subsectors for garbage collection to copy records in.
+    for (uint32_t n = 0; !gc && (QSPI_KV_Stat.Free < QSPI_KV_RESERVE) && (n < QSPI_KV_SUBSECTORS);
+         n++)
+    {
+        if (QSPI_KV_Collect() != NVRAM_OK)
+        {
+            break;
+        }
+    }
+
+    if (QSPI_KV_Used >= QSPI_KV_SUBSECTORS)
+    {
+        return NVRAM_FAIL;
+    }
+
+    next = (QSPI_KV_Head + 1) % QSPI_KV_SUBSECTORS;
+    if ((QSPI_KV_State[next] != QSPI_KV_STATE_BLANK) && (QSPI_KV_Prepare(next) != NVRAM_OK))
+    {
+        return NVRAM_FAIL;
+    }
+
+    if (QSPI_KV_WriteAt(next * QSPI_KV_SUBSECTOR_SIZE + 8, sequence, sizeof(sequence)) != NVRAM_OK)
+    {
+        QSPI_KV_State[next] = QSPI_KV_STATE_DIRTY;
+        return NVRAM_FAIL;
+    }
+
+    QSPI_KV_State[next] = QSPI_KV_STATE_USED;
+    QSPI_KV_Head        = next;
+    QSPI_KV_Pos         = QSPI_KV_HEADER_SIZE;
+    QSPI_KV_Used++;
+    QSPI_KV_Sequence++;
+    QSPI_KV_Stat.Free = QSPI_KV_SUBSECTORS - QSPI_KV_Used;
+    return NVRAM_OK;
+}
+
+/*!@brief Append a record at the log head, value given in 1 or 2 parts.
+ *
+ * @param key       : Record key.
+ * @param data      : Value parts, second one may be NULL.
+ * @param size      : Size of each value part in bytes.
+ * @param gc        : Called by garbage collection.
+ * @param offset    : Return the offset of the record.
+ */
+static NVRAM_STATUS QSPI_KV_Append(uint16_t key, const void *data[2], const uint16_t size[2],
+                                   uint8_t gc, uint32_t *offset)
+{
+    QSPI_KV_RecordTypeDef rec  = {.Key = key, .Length = size[0] + size[1]};
+    uint32_t              need = QSPI_KV_ALIGN_SIZE(sizeof(rec) + rec.Length);
+
+    if ((QSPI_KV_Pos + need > QSPI_KV_SUBSECTOR_SIZE) && (QSPI_KV_Open(gc) != NVRAM_OK))
+    {
+        return NVRAM_FAIL;
+    }
+
+    rec.Crc = Dfu_crc32(0, (const uint8_t *)&rec, 4);
+    rec.Crc = Dfu_crc32(rec.Crc, data[0], size[0]);
+    rec.Crc = Dfu_crc32(rec.Crc, data[1], size[1]);
+    *offset = QSPI_KV_Head * QSPI_KV_SUBSECTOR_SIZE + QSPI_KV_Pos;
+
+    // Program a variable in one go, header first otherwise.
+    NVRAM_STATUS ret = NVRAM_OK;
+    if ((size[0] == 4) && (size[1] == 0))
+    {
+        uint8_t buf[sizeof(rec) + 4];
+        memcpy(buf, &rec, sizeof(rec));
+        memcpy(&buf[sizeof(rec)], data[0], 4);
+        ret = QSPI_KV_WriteAt(*offset, buf, sizeof(buf));
+    }
+    else
+    {
+        ret = QSPI_KV_WriteAt(*offset, &rec, sizeof(rec));
+        for (int i = 0; (i < 2) && (ret == NVRAM_OK); i++)
+        {
+            ret = (size[i] > 0) ? QSPI_KV_WriteAt(*offset + sizeof(rec) + (i ? size[0] : 0),
+                                                  data[i], size[i])
+                                : NVRAM_OK;
+        }
+    }
+
+    // Don't write after a failed record, the next one goes to a new subsector.
+    QSPI_KV_Pos = (ret == NVRAM_OK) ? QSPI_KV_Pos + need : QSPI_KV_SUBSECTOR_SIZE;
+    QSPI_KV_Stat.Record += (ret == NVRAM_OK);
+    return ret;
+}
+
+/*!@brief Copy a record still indexed by the key to the log head.
+ */
+static NVRAM_STATUS QSPI_KV_Move(uint16_t key, uint32_t offset, const void *value, uint16_t len)
+{
+    QSPI_KV_IndexTypeDef *slot    = QSPI_KV_Slot(key);
+    const void *          data[2] = {value, NULL};
+    const uint16_t        size[2] = {len, 0};
+
+    if ((slot->Key != key) || (slot->Unit != offset / QSPI_KV_ALIGN))
+    {
+        return NVRAM_OK;
+    }
+
+    if (QSPI_KV_Append(key, data, size, 1, &offset) != NVRAM_OK)
+    {
+        return NVRAM_FAIL;
+    }
+    slot->Unit = offset / QSPI_KV_ALIGN;
+    QSPI_KV_Stat.GcCopy++;
+    return NVRAM_OK;
+}
+
+/*!@brief Garbage collect the log tail, copy its indexed records to the head then erase it.
+ *         Variables of a transaction record are copied as single records.
+ */
+static NVRAM_STATUS QSPI_KV_Collect(void)
+{
+    QSPI_KV_ScanTypeDef    scan = {0};
+    QSPI_KV_RecordTypeDef *rec  = NULL;
+    uint32_t               tail = (QSPI_KV_Head + 1 + QSPI_KV_SUBSECTORS - QSPI_KV_Used) %
+                    QSPI_KV_SUBSECTORS;
+    int ret = QSPI_KV_SCAN_END;
+
+    if (QSPI_KV_Used <= 1)
+    {
+        return NVRAM_FAIL;
+    }
+
+    if (QSPI_KV_State[tail] == QSPI_KV_STATE_USED)
+    {
+        QSPI_KV_ScanStart(&scan, tail);
+        for (uint32_t at = scan.Pos; (ret = QSPI_KV_ScanNext(&scan, &rec)) == QSPI_KV_SCAN_RECORD;
+             at          = scan.Pos)
+        {
+            NVRAM_STATUS status = NVRAM_OK;
+
+            if (rec->Key == QSPI_KV_KEY_TX)
+            {
+                // Last value first, a set may write a variable twice.
+                uint32_t  count = rec->Length / 8;
+                uint32_t *addr  = (uint32_t *)(rec + 1);
+                for (uint32_t i = count; (i > 0) && (status == NVRAM_OK); i--)
+                {
+                    status = QSPI_KV_Move(addr[i - 1], at, &addr[count + i - 1], 4);
+                }
+            }
+            else
+            {
+                status = QSPI_KV_Move(rec->Key, at, rec + 1, rec->Length);
+            }
+
+            if (status != NVRAM_OK)
+            {
+                return NVRAM_FAIL;
+            }
+        }
+
+        if (ret == QSPI_KV_SCAN_ERROR)
+        {
+            return NVRAM_FAIL;
+        }
+    }
+
+    // Records are copied, tail leaves the log even if the erase fails.
+    QSPI_KV_Used--;
+    QSPI_KV_Stat.Free = QSPI_KV_SUBSECTORS - QSPI_KV_Used;
+    QSPI_KV_Stat.Gc++;
+    return QSPI_KV_Prepare(tail);
+}
+
+/*!@brief Get the offset of a value, in the record of its key or in a transaction record.
+ *
+ * @param key   : Key of the value.
+ * @param len   : Return the value length.
+ * @return Offset of the value, 0 if not found.
+ */
+static uint32_t QSPI_KV_Locate(uint16_t key, uint16_t *len)
+{
+    QSPI_KV_IndexTypeDef *slot   = QSPI_KV_Slot(key);
+    QSPI_KV_RecordTypeDef rec    = {0};
+    uint32_t              offset = slot->Unit * QSPI_KV_ALIGN;
+
+    if ((slot->Key != key) || (QSPI_KV_ReadAt(offset, &rec, sizeof(rec)) != NVRAM_OK))
+    {
+        return 0;
+    }
+
+    offset += sizeof(rec);
+    if (rec.Key == key)
+    {
+        *len = rec.Length;
+        return offset;
+    }
+
+    // Last of the variable in a transaction record, a set may write a variable twice.
+    uint32_t *addr  = (uint32_t *)QSPI_KV_Buffer;
+    uint32_t  count = rec.Length / 8;
+    if ((rec.Key != QSPI_KV_KEY_TX) || (QSPI_KV_ReadAt(offset, addr, count * 4) != NVRAM_OK))
+    {
+        return 0;
+    }
+
+    for (uint32_t i = count; i > 0; i--)
+    {
+        if (addr[i - 1] == key)
+        {
+            *len = 4;
+            return offset + (count + i - 1) * 4;
+        }
+    }
+    return 0;
+}
+
+/*!@brief Rebuild the index from the records of a subsector.
+ *
+ * @param head  : Subsector is the log head, set next record offset.
+ */
+static NVRAM_STATUS QSPI_KV_Mount(uint32_t subsector, uint8_t head)
+{
+    QSPI_KV_ScanTypeDef    scan = {0};
+    QSPI_KV_RecordTypeDef *rec  = NULL;
+    int                    ret  = QSPI_KV_SCAN_END;
+
+    QSPI_KV_ScanStart(&scan, subsector);
+    for (uint32_t at = scan.Pos; (ret = QSPI_KV_ScanNext(&scan, &rec)) == QSPI_KV_SCAN_RECORD;
+         at          = scan.Pos)
+    {
+        if (rec->Key == QSPI_KV_KEY_TX)
+        {
+            uint32_t *addr = (uint32_t *)(rec + 1);
+            for (uint32_t i = 0; i < rec->Length / 8; i++)
+            {
+                QSPI_KV_Update(addr[i], at);
+            }
+        }
+        else
+        {
+            QSPI_KV_Update(rec->Key, at);
+        }
+    }
+
+    if (ret == QSPI_KV_SCAN_ERROR)
+    {
+        return NVRAM_FAIL;
+    }
+
+    if (head)
+    {
+        QSPI_KV_Pos = (ret == QSPI_KV_SCAN_END) ? scan.Pos : QSPI_KV_SUBSECTOR_SIZE;
+
+        // A torn record may look erased at its start, the rest of the head must be blank.
+        for (uint32_t pos = QSPI_KV_Pos; pos < QSPI_KV_SUBSECTOR_SIZE; pos += sizeof(QSPI_KV_Buffer))
+        {
+            uint32_t size = QSPI_KV_SUBSECTOR_SIZE - pos;
+            size          = (size > sizeof(QSPI_KV_Buffer)) ? sizeof(QSPI_KV_Buffer) : size;
+            if (QSPI_KV_ScanAt(subsector * QSPI_KV_SUBSECTOR_SIZE + pos, QSPI_KV_Buffer, size) !=
+                NVRAM_OK)
+            {
+                return NVRAM_FAIL;
+            }
+            for (uint32_t i = 0; i < size; i++)
+            {
+                if (QSPI_KV_Buffer[i] != 0xFF)
+                {
+                    QSPI_KV_Pos = QSPI_KV_SUBSECTOR_SIZE;
+                    return NVRAM_OK;
+                }
+            }
+        }
+    }
+    return NVRAM_OK;
+}
+
+/*!@brief Mount the store, rebuild the index from the log. A blank area is an empty store,
+ *         subsectors are erased when first used.
+ */
+NVRAM_STATUS QSPI_KV_Init(void)
+{
+    QSPI_KV_SubsectorTypeDef header = {0};
+    uint32_t                 tick   = HAL_GetTick();
+    uint32_t                 tail   = 0;
+    uint32_t                 first  = 0xFFFFFFFF; //!< Sequence of the tail
+    uint32_t                 last   = 0;          //!< Sequence of the head
+
+    QSPI_KV_Mounted = 0;
+    // Through the scheduler, it waits the transfers and erases in flight and unmaps.
+    if (Bsp_Qspi_Reset() != QSPI_OK)
+    {
+        return NVRAM_ERR_IF;
+    }
+
+    QSPI_KV_Reset();
+    QSPI_KV_Stat.EraseMax = 0;
+    for (uint32_t i = 0; i < QSPI_KV_SUBSECTORS; i++)
+    {
+        if (QSPI_KV_ScanAt(i * QSPI_KV_SUBSECTOR_SIZE, &header, sizeof(header)) != NVRAM_OK)
+        {
+            return NVRAM_FAIL;
+        }
+
+        QSPI_KV_State[i] = QSPI_KV_STATE_DIRTY;
+        if ((header.Magic ^ header.Erase) != QSPI_KV_MAGIC)
+        {
+            continue;
+        }
+
+        QSPI_KV_Stat.EraseMax = (header.Erase > QSPI_KV_Stat.EraseMax) ? header.Erase
+                                                                       : QSPI_KV_Stat.EraseMax;
+        if ((header.Sequence == 0xFFFFFFFF) && (header.Check == 0xFFFFFFFF))
+        {
+            QSPI_KV_State[i] = QSPI_KV_STATE_BLANK;
+        }
+        else if (header.Check == ~header.Sequence)
+        {
+            // Log runs from the lowest to the highest sequence.
+            if (header.Sequence <= first)
+            {
+                first = header.Sequence;
+                tail  = i;
+            }
+            if (header.Sequence >= last)
+            {
+                last         = header.Sequence;
+                QSPI_KV_Head = i;
+            }
+            QSPI_KV_State[i] = QSPI_KV_STATE_USED;
+        }
+    }
+
+    if (first <= last)
+    {
+        QSPI_KV_Used      = (QSPI_KV_Head + QSPI_KV_SUBSECTORS - tail) % QSPI_KV_SUBSECTORS + 1;
+        QSPI_KV_Sequence  = last + 1;
+        QSPI_KV_Stat.Free = QSPI_KV_SUBSECTORS - QSPI_KV_Used;
+
+        for (uint32_t i = 0; i < QSPI_KV_Used; i++)
+        {
+            uint32_t subsector = (tail + i) % QSPI_KV_SUBSECTORS;
+            if ((QSPI_KV_State[subsector] == QSPI_KV_STATE_USED) &&
+                (QSPI_KV_Mount(subsector, subsector == QSPI_KV_Head) != NVRAM_OK))
+            {
+                return NVRAM_FAIL;
+            }
+        }
+    }
+
+    QSPI_KV_Stat.Mount = HAL_GetTick() - tick;
+    QSPI_KV_Mounted    = 1;
+    return NVRAM_OK;
+}
+
+NVRAM_STATUS QSPI_KV_DeInit(void)
+{
+    QSPI_KV_Mounted = 0;
+    return NVRAM_OK;
+}
+
+/*!@brief Erase the store area by 64 kB sectors, erase count of each subsector is kept.
+ */
+NVRAM_STATUS QSPI_KV_Erase(void)
+{
+    QSPI_KV_SubsectorTypeDef header = {0};
+    uint32_t                 erase[N25Q128A_SECTOR_SIZE / QSPI_KV_SUBSECTOR_SIZE];
+
+    for (uint32_t sector = 0; sector < QSPI_KV_SIZE / N25Q128A_SECTOR_SIZE; sector++)
+    {
+        uint32_t first = sector * N25Q128A_SECTOR_SIZE / QSPI_KV_SUBSECTOR_SIZE;
+
+        for (uint32_t i = 0; i < N25Q128A_SECTOR_SIZE / QSPI_KV_SUBSECTOR_SIZE; i++)
+        {
+            erase[i] = QSPI_KV_Stat.EraseMax;
+            if ((QSPI_KV_ScanAt((first + i) * QSPI_KV_SUBSECTOR_SIZE, &header, sizeof(header)) ==
+                 NVRAM_OK) &&
+                ((header.Magic ^ header.Erase) == QSPI_KV_MAGIC))
+            {
+                erase[i] = header.Erase;
+            }
+            QSPI_KV_State[first + i] = QSPI_KV_STATE_DIRTY;
+        }
+
+        if (QSPI_KV_EraseAt(sector * N25Q128A_SECTOR_SIZE, N25Q128A_SECTOR_SIZE) != NVRAM_OK)
+        {
+            return NVRAM_FAIL;
+        }
+
+        for (uint32_t i = 0; i < N25Q128A_SECTOR_SIZE / QSPI_KV_SUBSECTOR_SIZE; i++)
+        {
+            header.Erase = erase[i] + 1;
+            header.Magic = QSPI_KV_MAGIC ^ header.Erase;
+            if (QSPI_KV_WriteAt((first + i) * QSPI_KV_SUBSECTOR_SIZE, &header, 8) != NVRAM_OK)
+            {
+                return NVRAM_FAIL;
+            }
+            QSPI_KV_State[first + i] = QSPI_KV_STATE_BLANK;
+            QSPI_KV_Stat.EraseMax = (header.Erase > QSPI_KV_Stat.EraseMax) ? header.Erase
+                                                                           : QSPI_KV_Stat.EraseMax;
+        }
+        QSPI_KV_Stat.Erase += N25Q128A_SECTOR_SIZE / QSPI_KV_SUBSECTOR_SIZE;
+    }
+
+    QSPI_KV_Reset();
+    return NVRAM_OK;
+}
+
+/*!@brief Background maintenance, one subsector per call: erase the subsector next to the head,
+ *         or garbage collect below QSPI_KV_GC_FREE free subsectors. QSPI operations are
+ *         background requests, reads of other tasks suspend the erase, they are done on return.
+ */
+NVRAM_STATUS QSPI_KV_Clean(void)
+{
+    uint32_t next = (QSPI_KV_Head + 1) % QSPI_KV_SUBSECTORS;
+
+    if (!QSPI_KV_Mounted)
+    {
+        return NVRAM_OK;
+    }
+
+    QSPI_KV_Class = QSPI_CLASS_BACKGROUND;
+    if ((QSPI_KV_Used < QSPI_KV_SUBSECTORS) && (QSPI_KV_State[next] == QSPI_KV_STATE_DIRTY))
+    {
+        QSPI_KV_Prepare(next);
+    }
+    else if (QSPI_KV_Stat.Free < QSPI_KV_GC_FREE)
+    {
+        QSPI_KV_Collect();
+    }
+    QSPI_KV_Class = QSPI_CLASS_INTERACTIVE;
+    return NVRAM_OK;
+}
+
+/*!@brief Append a value record and index it.
+ */
+static NVRAM_STATUS QSPI_KV_Put(uint16_t key, const void *value, uint16_t len)
+{
+    const void *   data[2] = {value, NULL};
+    const uint16_t size[2] = {len, 0};
+    uint32_t       offset  = 0;
+
+    if (!QSPI_KV_Mounted)
+    {
+        return NVRAM_ERR_IF;
+    }
+
+    if ((QSPI_KV_Slot(key)->Key != key) && (QSPI_KV_Stat.Keys >= QSPI_KV_MAX_KEYS))
+    {
+        return NVRAM_FAIL;
+    }
+
+    if (QSPI_KV_Append(key, data, size, 0, &offset) != NVRAM_OK)
+    {
+        return NVRAM_FAIL;
+    }
+    return QSPI_KV_Update(key, offset);
+}
+
+NVRAM_STATUS QSPI_KV_Write(uint32_t addr, uint32_t value)
+{
+    if ((addr == 0) || (addr >= QSPI_KV_KEY_EX))
+    {
+        return NVRAM_ERR_PARAM;
+    }
+
+    return QSPI_KV_Put(addr, &value, sizeof(value));
+}
+
+NVRAM_STATUS QSPI_KV_Read(uint32_t addr, uint32_t *value)
+{
+    uint16_t len    = 0;
+    uint32_t offset = 0;
+
+    if ((addr == 0) || (addr >= QSPI_KV_KEY_EX))
+    {
+        return NVRAM_ERR_PARAM;
+    }
+
+    if (!QSPI_KV_Mounted)
+    {
+        return NVRAM_ERR_IF;
+    }
+
+    offset = QSPI_KV_Locate(addr, &len);
+    if ((offset == 0) || (len != sizeof(*value)))
+    {
+        return NVRAM_FAIL;
+    }
+    return QSPI_KV_ReadAt(offset, value, sizeof(*value));
+}
+
+/*!@brief Write a set of variables in one record, after a reset all or none of them are read.
+ */
+NVRAM_STATUS QSPI_KV_WriteTx(uint32_t *addr, uint32_t *value, uint16_t count)
+{
+    const void *   data[2] = {addr, value};
+    const uint16_t size[2] = {count * 4, count * 4};
+    uint32_t       keys    = 0;
+    uint32_t       offset  = 0;
+
+    if ((count == 0) || (count > NVRAM_TX_SIZE))
+    {
+        return NVRAM_ERR_PARAM;
+    }
+
+    if (!QSPI_KV_Mounted)
+    {
+        return NVRAM_ERR_IF;
+    }
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if ((addr[i] == 0) || (addr[i] >= QSPI_KV_KEY_EX))
+        {
+            return NVRAM_ERR_PARAM;
+        }
+        keys += (QSPI_KV_Slot(addr[i])->Key != addr[i]);
+    }
+
+    if (QSPI_KV_Stat.Keys + keys > QSPI_KV_MAX_KEYS)
+    {
+        return NVRAM_FAIL;
+    }
+
+    if (QSPI_KV_Append(QSPI_KV_KEY_TX, data, size, 0, &offset) != NVRAM_OK)
+    {
+        return NVRAM_FAIL;
+    }
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        QSPI_KV_Update(addr[i], offset);
+    }
+    return NVRAM_OK;
+}
+
+/*!@brief Write a multi-byte value.
+ *
+ * @param reg   : Value index, 0 to 255.
+ * @param value : Data, up to QSPI_KV_VALUE_MAX bytes.
+ * @param len   : Data length in bytes.
+ */
+NVRAM_STATUS QSPI_KV_WriteEx(uint8_t reg, uint8_t *value, uint16_t len)
+{
+    if ((value == NULL) || (len == 0) || (len > QSPI_KV_VALUE_MAX))
+    {
+        return NVRAM_ERR_PARAM;
+    }
+
+    return QSPI_KV_Put(QSPI_KV_KEY_EX + reg, value, len);
+}
+
+/*!@brief Read a multi-byte value, bytes after the value length are cleared.
+ *
+ * @param reg   : Value index, 0 to 255.
+ * @param value : Buffer receiving the data.
+ * @param len   : Buffer size in bytes, data after len bytes is not copied.
+ */
+NVRAM_STATUS QSPI_KV_ReadEx(uint8_t reg, uint8_t *value, uint16_t len)
+{
+    uint16_t length = 0;
+    uint32_t offset = 0;
+
+    if (!QSPI_KV_Mounted)
+    {
+        return NVRAM_ERR_IF;
+    }
+
+    offset = QSPI_KV_Locate(QSPI_KV_KEY_EX + reg, &length);
+    if (offset == 0)
+    {
+        return NVRAM_FAIL;
+    }
+
+    length = (length < len) ? length : len;
+    memset(value + length, 0, len - length);
+    return QSPI_KV_ReadAt(offset, value, length);
+}
+
+NVRAM_STATUS QSPI_KV_GetInfo(Nvram_InfoTypeDef *info)
+{
+    info->Interface  = "QSPI";
+    info->DevName    = "N25Q128A_QSPI_KV";
+    info->DevChannel = 0;
+    info->DevAddr    = 0;
+    info->DataBit    = 32;
+    info->DataVolume = QSPI_KV_MAX_KEYS;
+
+    return NVRAM_OK;
+}
@@ -0,0 +1,54 @@
+/******************************************************************************
+ * @file    bsp_nvram_qspi.h
+ * @brief   NVRAM device on the N25Q128A QSPI flash, a log-structured key-value store.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef INC_BSP_BSP_NVRAM_QSPI_H_
+#define INC_BSP_BSP_NVRAM_QSPI_H_
+
+#include "bsp_nvram.h"
+#include "stdint.h"
+
+// clang-format off
+#define QSPI_KV_BASE            0x00F00000  //!< Store area, last 1 MB of the QSPI flash
+#define QSPI_KV_SIZE            0x00100000
+#define QSPI_KV_SUBSECTOR_SIZE  0x1000      //!< Erase unit, N25Q128A subsector
+#define QSPI_KV_SUBSECTORS      (QSPI_KV_SIZE / QSPI_KV_SUBSECTOR_SIZE)
+#define QSPI_KV_RESERVE         2           //!< Garbage collect on write below N free subsectors
+#define QSPI_KV_GC_FREE         8           //!< Garbage collect in background below N free subsectors
+#define QSPI_KV_INDEX_BITS      10          //!< RAM hash index of 2^N slots, 4 bytes per slot
+#define QSPI_KV_MAX_KEYS        768         //!< Keys held by the index, 3/4 of the slots
+#define QSPI_KV_VALUE_MAX       NVRAM_EX_SIZE //!< Max bytes of a WriteEx() value
+#define QSPI_KV_KEY_EX          EE_BLOB_VIRTADDR //!< Key of WriteEx() value, + reg
+#define QSPI_KV_KEY_TX          0xFFFE      //!< Key of a transaction record
+// clang-format on
+
+typedef struct {
+    uint32_t Mount;    //!> Mount time in ms, index rebuilt from the log
+    uint32_t Keys;     //!> Keys in index
+    uint32_t Free;     //!> Subsectors out of the log
+    uint32_t Record;   //!> Records written, garbage collection included
+    uint32_t Gc;       //!> Subsectors garbage collected
+    uint32_t GcCopy;   //!> Records copied by garbage collection
+    uint32_t Erase;    //!> Subsectors erased
+    uint32_t EraseMax; //!> Highest erase count of a subsector
+} QSPI_KV_StatTypeDef;
+
+extern QSPI_KV_StatTypeDef QSPI_KV_Stat;
+
+NVRAM_STATUS QSPI_KV_Init(void);
+NVRAM_STATUS QSPI_KV_DeInit(void);
+NVRAM_STATUS QSPI_KV_Erase(void);
+NVRAM_STATUS QSPI_KV_Clean(void);
+NVRAM_STATUS QSPI_KV_Write(uint32_t addr, uint32_t value);
+NVRAM_STATUS QSPI_KV_Read(uint32_t addr, uint32_t *value);
+NVRAM_STATUS QSPI_KV_WriteTx(uint32_t *addr, uint32_t *value, uint16_t count);
+NVRAM_STATUS QSPI_KV_WriteEx(uint8_t reg, uint8_t *value, uint16_t len);
+NVRAM_STATUS QSPI_KV_ReadEx(uint8_t reg, uint8_t *value, uint16_t len);
+NVRAM_STATUS QSPI_KV_GetInfo(Nvram_InfoTypeDef *info);
+
+#endif /* INC_BSP_BSP_NVRAM_QSPI_H_ */
@@ -0,0 +1,899 @@
+/******************************************************************************
+ * @file    bsp_qspi.c
+ * @brief   Task level access to the N25Q128A QSPI flash without busy waiting, through
+ *          an I/O scheduler.
+ *
+ *          A DMA read of 32 kB takes 0.8 ms on the 40 MHz quad bus, a page program
+ *          0.5 ms typical, a subsector erase 250 ms and a sector erase 700 ms. The chip
+ *          can't be read while it programs or erases, so a read queued behind a garbage
+ *          collection erase would wait for all of it. The scheduler suspends the erase,
+ *          reads, and resumes it, a read waits at most QSPI_ERASE_SLICE ms plus the suspend
+ *          latency and the reads queued before it.
+ *
+ *          Bsp_Qspi_Process() runs the queue, it only starts operations and returns, the
+ *          completion interrupts wake it again. Reads shorter than QSPI_DMA_MIN cost less
+ *          than the DMA setup and are done at once.
+ *
+ *          In memory-mapped mode the CPU reads the flash with no command per access, assets
+ *          are used in place, but the QSPI takes no indirect command. The mode is switched
+ *          between operations, with no transfer, program or erase in flight. Readers of the
+ *          window are counted, a write or erase waits for the count to drop to 0.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include "bsp_qspi.h"
+#include "bsp_qspi_cache.h"
+#include "cmsis_os.h"
+#include "string.h"
+
+Qspi_StatTypeDef Qspi_Stat     = {0};
+uint8_t          Qspi_Preempt  = 1;
+uint8_t          Qspi_MapIdle  = 0;
+uint8_t          Qspi_Blocking = 0;
+
+osSemaphoreDef(Qspi_Event);
+static osSemaphoreId    Qspi_Event  = NULL;    //!< Given by completion interrupts and submits
+static osThreadId       Qspi_TaskId = NULL;    //!< I/O task, NULL while callers run the queue
+static volatile uint8_t Qspi_Done   = 0;       //!< Transfer / status match completed
+static volatile uint8_t Qspi_Status = QSPI_OK; //!< Status of the completed transfer
+
+static Qspi_ReqTypeDef *Qspi_Queue[QSPI_CLASSES] = {NULL}; //!< Requests of each class in order
+static uint32_t         Qspi_Seq          = 0;
+static Qspi_ReqTypeDef *Qspi_Xfer         = NULL; //!< Request of the DMA transfer in flight
+static uint32_t         Qspi_XferLen      = 0;    //!< Bytes of the DMA read
+static uint32_t         Qspi_XferTick     = 0;
+static Qspi_ReqTypeDef *Qspi_Chip         = NULL; //!< Request of the erase / page program
+static uint32_t         Qspi_ChipLen      = 0;    //!< Bytes of the request it completes
+static uint32_t         Qspi_ChipTick     = 0;    //!< Start tick, moved by the time suspended
+static uint32_t         Qspi_ChipLimit    = 0;    //!< Timeout in ms
+static uint8_t          Qspi_Poll         = 0;    //!< Status match armed
+static uint8_t          Qspi_Suspended    = 0;
+static uint32_t         Qspi_SuspendTick  = 0;
+static uint32_t         Qspi_SuspendReads = 0;    //!< Reads served in this suspend
+static uint32_t         Qspi_ResumeTick   = 0;    //!< Tick the erase / program started or resumed
+static uint8_t          Qspi_Mapped       = 0;    //!< Memory-mapped mode
+static uint32_t         Qspi_Readers      = 0;    //!< Pointers of Bsp_Qspi_Map() not released
+static uint8_t          Qspi_Page[N25Q128A_PAGE_SIZE]; //!< Data of the page program, merged
+
+/*!@brief Completion of a DMA transfer or status match, from interrupt.
+ */
+void BSP_QSPI_TransferCpltCallback(uint8_t Status)
+{
+    Qspi_Status = Status;
+    Qspi_Done   = 1;
+    if (Qspi_Event != NULL)
+    {
+        osSemaphoreRelease(Qspi_Event);
+    }
+}
+
+/*!@brief Keep other tasks out of the queues and the cache, nests. Before the scheduler starts
+ *        there are none, and a FreeRTOS critical section would leave interrupts masked until
+ *        it starts.
+ */
+void Bsp_Qspi_Lock(void)
+{
+    if (osKernelRunning())
+    {
+        osThreadSuspendAll();
+    }
+}
+
+void Bsp_Qspi_Unlock(void)
+{
+    if (osKernelRunning())
+    {
+        osThreadResumeAll();
+    }
+}
+
+/*!@brief Create the event semaphore once the scheduler runs, call locked. A token left by an
+ *        earlier event only runs the queue once more.
+ */
+static void Bsp_Qspi_Init(void)
+{
+    if ((Qspi_Event == NULL) && osKernelRunning())
+    {
+        Qspi_Event = osSemaphoreCreate(osSemaphore(Qspi_Event), 1);
+    }
+}
+
+/*!@brief Check a request changes the flash, or resets it.
+ */
+static uint8_t Bsp_Qspi_Modify(Qspi_ReqTypeDef *req)
+{
+    return (req->Op == QSPI_OP_WRITE) || (req->Op == QSPI_OP_ERASE) || (req->Op == QSPI_OP_INIT);
+}
+
+/*!@brief Check the areas left to do of two requests overlap.
+ */
+static uint8_t Bsp_Qspi_Overlap(Qspi_ReqTypeDef *a, Qspi_ReqTypeDef *b)
+{
+    return (a->Addr + a->Done < b->Addr + b->Size) && (b->Addr + b->Done < a->Addr + a->Size);
+}
+
+/*!@brief Check a request must wait an earlier one on the same area, unless both read.
+ *        A map waits every earlier write and erase, so that readers can't hold them off.
+ *
+ * @param page  : Write of the page program req is merged in, it and the writes merged
+ *                already don't block. NULL otherwise.
+ */
+static uint8_t Bsp_Qspi_Blocked(Qspi_ReqTypeDef *req, Qspi_ReqTypeDef *page)
+{
+    for (uint32_t c = 0; c < QSPI_CLASSES; c++)
+    {
+        for (Qspi_ReqTypeDef *r = Qspi_Queue[c]; r != NULL; r = r->Next)
+        {
+            if (((int32_t)(r->Seq - req->Seq) >= 0) ||
+                ((page != NULL) && ((r == page) || r->Merged)))
+            {
+                continue;
+            }
+            if ((req->Op == QSPI_OP_MAP) && Bsp_Qspi_Modify(r))
+            {
+                return 1;
+            }
+            if ((Bsp_Qspi_Modify(req) || Bsp_Qspi_Modify(r)) && Bsp_Qspi_Overlap(req, r))
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/*!@brief Get the first request to serve, by class then submit order.
+ *
+ * @param read  : Get reads only.
+ * @param cls   : Lowest priority class to get.
+ */
+static Qspi_ReqTypeDef *Bsp_Qspi_Next(uint8_t read, uint8_t cls)
+{
+    for (uint32_t c = 0; c <= cls; c++)
+    {
+        for (Qspi_ReqTypeDef *r = Qspi_Queue[c]; r != NULL; r = r->Next)
+        {
+            if ((!read || (r->Op == QSPI_OP_READ)) && !Bsp_Qspi_Blocked(r, NULL))
+            {
+                return r;
+            }
+        }
+    }
+    return NULL;
+}
+
+/*!@brief Remove a request from its queue and notify its owner.
+ */
+static void Bsp_Qspi_Finish(Qspi_ReqTypeDef *req, uint8_t status)
+{
+    void (*callback)(Qspi_ReqTypeDef *) = req->Callback;
+    void *            context           = req->Context;
+    uint32_t          latency           = HAL_GetTick() - req->Tick;
+    Qspi_ReqTypeDef **link              = &Qspi_Queue[req->Class];
+
+    Bsp_Qspi_Lock();
+    while (*link != req)
+    {
+        link = &(*link)->Next;
+    }
+    *link = req->Next;
+    Bsp_Qspi_Unlock();
+
+    if (status != QSPI_OK)
+    {
+        Qspi_Stat.Error++;
+    }
+    if (latency > Qspi_Stat.Latency[req->Class])
+    {
+        Qspi_Stat.Latency[req->Class] = latency;
+    }
+
+    // A task waiting the request may return as soon as Status is set.
+    req->Merged = 0;
+    req->Status = status;
+    if (callback != NULL)
+    {
+        callback(req);
+    }
+    else if (context != NULL)
+    {
+        osSignalSet(context, QSPI_SIGNAL);
+    }
+}
+
+/*!@brief Arm the status match interrupt on the end of erase / program.
+ */
+static uint8_t Bsp_Qspi_Poll(void)
+{
+    Qspi_Done = 0;
+    Qspi_Poll = (BSP_QSPI_AutoPollingMemReady_IT() == QSPI_OK);
+    return Qspi_Poll ? QSPI_OK : QSPI_ERROR;
+}
+
+/*!@brief End of the erase / page program, the writes merged in the page end with it.
+ */
+static void Bsp_Qspi_ChipDone(uint8_t status)
+{
+    Qspi_ReqTypeDef *req = Qspi_Chip;
+
+    Qspi_Chip = NULL;
+    req->Done += Qspi_ChipLen;
+
+    if (req->Op == QSPI_OP_WRITE)
+    {
+        for (uint32_t c = 0; c < QSPI_CLASSES; c++)
+        {
+            Qspi_ReqTypeDef *r = Qspi_Queue[c];
+            while (r != NULL)
+            {
+                Qspi_ReqTypeDef *next = r->Next;
+                if (r->Merged)
+                {
+                    Bsp_Qspi_Finish(r, status);
+                }
+                r = next;
+            }
+        }
+    }
+
+    if ((status != QSPI_OK) || (req->Done == req->Size))
+    {
+        Bsp_Qspi_Finish(req, status);
+    }
+}
+
+/*!@brief End of the DMA transfer or of the status match.
+ */
+static void Bsp_Qspi_Complete(uint8_t status)
+{
+    Qspi_ReqTypeDef *req = Qspi_Xfer;
+
+    if (req != NULL)
+    {
+        Qspi_Xfer = NULL;
+        if (req->Op == QSPI_OP_READ)
+        {
+            req->Done += Qspi_XferLen;
+            if ((status != QSPI_OK) || (req->Done == req->Size))
+            {
+                Bsp_Qspi_Finish(req, status);
+            }
+        }
+        else if (status == QSPI_OK)
+        {
+            // Page is sent, the program runs.
+            Qspi_ChipTick   = HAL_GetTick();
+            Qspi_ResumeTick = Qspi_ChipTick;
+            Qspi_ChipLimit  = QSPI_PROG_TIMEOUT;
+            if (Bsp_Qspi_Poll() != QSPI_OK)
+            {
+                Bsp_Qspi_ChipDone(QSPI_ERROR);
+            }
+        }
+        else
+        {
+            Bsp_Qspi_ChipDone(status);
+        }
+    }
+    else if (Qspi_Poll)
+    {
+        Qspi_Poll = 0;
+        Bsp_Qspi_ChipDone(status);
+    }
+}
+
+/*!@brief Start the next part of a read, a short one, one from the memory-mapped window or
+ *        any with Qspi_Blocking set is read at once.
+ */
+static void Bsp_Qspi_StartRead(Qspi_ReqTypeDef *req)
+{
+    uint32_t len = req->Size - req->Done;
+    uint8_t  ret;
+
+    len = (len > QSPI_DMA_MAX) ? QSPI_DMA_MAX : len;
+    if (Qspi_Mapped || Qspi_Blocking || (len < QSPI_DMA_MIN))
+    {
+        uint8_t *data = req->Data + req->Done;
+        uint32_t addr = req->Addr + req->Done;
+
+        ret = Qspi_Mapped ? BSP_QSPI_ReadMapped(data, addr, len) : BSP_QSPI_Read(data, addr, len);
+        Qspi_Stat.MapRead += Qspi_Mapped;
+        req->Done += len;
+        if ((ret != QSPI_OK) || (req->Done == req->Size))
+        {
+            Bsp_Qspi_Finish(req, ret);
+        }
+        return;
+    }
+
+    Qspi_Done = 0;
+    ret       = BSP_QSPI_Read_DMA(req->Data + req->Done, req->Addr + req->Done, len);
+    if (ret != QSPI_OK)
+    {
+        Bsp_Qspi_Finish(req, ret);
+        return;
+    }
+    Qspi_Stat.DmaRead++;
+    Qspi_Xfer     = req;
+    Qspi_XferLen  = len;
+    Qspi_XferTick = HAL_GetTick();
+}
+
+/*!@brief Start the program of the next page of a write, with the queued writes inside the
+ *        page that no earlier request holds back.
+ */
+static void Bsp_Qspi_StartWrite(Qspi_ReqTypeDef *req)
+{
+    uint32_t addr = req->Addr + req->Done;
+    uint32_t page = addr & ~(N25Q128A_PAGE_SIZE - 1);
+    uint32_t lo   = addr - page;
+    uint32_t len  = N25Q128A_PAGE_SIZE - lo;
+    uint32_t hi;
+
+    len = (len > req->Size - req->Done) ? req->Size - req->Done : len;
+    hi  = lo + len;
+    memset(Qspi_Page, 0xFF, sizeof(Qspi_Page));
+    memcpy(&Qspi_Page[lo], req->Data + req->Done, len);
+
+    for (uint32_t c = 0; c < QSPI_CLASSES; c++)
+    {
+        for (Qspi_ReqTypeDef *r = Qspi_Queue[c]; r != NULL; r = r->Next)
+        {
+            if ((r == req) || (r->Op != QSPI_OP_WRITE) || (r->Done != 0) || (r->Addr < page) ||
+                (r->Addr + r->Size > page + N25Q128A_PAGE_SIZE) || Bsp_Qspi_Blocked(r, req))
+            {
+                continue;
+            }
+
+            for (uint32_t i = 0; i < r->Size; i++)
+            {
+                Qspi_Page[r->Addr - page + i] &= r->Data[i];
+            }
+            lo        = (r->Addr - page < lo) ? r->Addr - page : lo;
+            hi        = (r->Addr + r->Size - page > hi) ? r->Addr + r->Size - page : hi;
+            r->Merged = 1;
+            Qspi_Stat.Merge++;
+        }
+    }
+
+    Qspi_Chip    = req;
+    Qspi_ChipLen = len;
+    Qspi_Done    = 0;
+    if (BSP_QSPI_WritePage_DMA(&Qspi_Page[lo], page + lo, hi - lo) != QSPI_OK)
+    {
+        Bsp_Qspi_ChipDone(QSPI_ERROR);
+        return;
+    }
+    Qspi_Stat.Page++;
+    Qspi_Xfer     = req;
+    Qspi_XferLen  = 0;
+    Qspi_XferTick = HAL_GetTick();
+}
+
+/*!@brief Start the erase of the next sector or subsector of an erase request.
+ */
+static void Bsp_Qspi_StartErase(Qspi_ReqTypeDef *req)
+{
+    uint32_t addr = req->Addr + req->Done;
+    uint8_t  ret;
+
+    if ((addr % N25Q128A_SECTOR_SIZE == 0) && (req->Size - req->Done >= N25Q128A_SECTOR_SIZE))
+    {
+        ret            = BSP_QSPI_Erase_Sector(addr / N25Q128A_SECTOR_SIZE);
+        Qspi_ChipLen   = N25Q128A_SECTOR_SIZE;
+        Qspi_ChipLimit = N25Q128A_SECTOR_ERASE_MAX_TIME;
+    }
+    else
+    {
+        ret            = BSP_QSPI_Erase_Subsector(addr / N25Q128A_SUBSECTOR_SIZE);
+        Qspi_ChipLen   = N25Q128A_SUBSECTOR_SIZE;
+        Qspi_ChipLimit = N25Q128A_SUBSECTOR_ERASE_MAX_TIME;
+    }
+
+    Qspi_Chip       = req;
+    Qspi_ChipTick   = HAL_GetTick();
+    Qspi_ResumeTick = Qspi_ChipTick;
+    if (ret == QSPI_OK)
+    {
+        Qspi_Stat.Erase++;
+        ret = Bsp_Qspi_Poll();
+    }
+    if (ret != QSPI_OK)
+    {
+        Bsp_Qspi_ChipDone(ret);
+    }
+}
+
+/*!@brief Switch between memory-mapped and indirect mode, with no transfer, program or erase
+ *        in flight.
+ */
+static uint8_t Bsp_Qspi_SetMapped(uint8_t mapped)
+{
+    uint8_t ret;
+
+    if (mapped == Qspi_Mapped)
+    {
+        return QSPI_OK;
+    }
+
+    ret = mapped ? BSP_QSPI_EnableMemoryMappedMode() : BSP_QSPI_DisableMemoryMappedMode();
+    if (ret == QSPI_OK)
+    {
+        Qspi_Mapped = mapped;
+        if (mapped)
+        {
+            Qspi_Stat.Map++;
+        }
+        else
+        {
+            Qspi_Stat.Unmap++;
+        }
+    }
+    return ret;
+}
+
+/*!@brief Map the window for a reader of Bsp_Qspi_Map().
+ */
+static void Bsp_Qspi_StartMap(Qspi_ReqTypeDef *req)
+{
+    uint8_t ret = Bsp_Qspi_SetMapped(1);
+
+    if (ret == QSPI_OK)
+    {
+        Bsp_Qspi_Lock();
+        Qspi_Readers++;
+        Bsp_Qspi_Unlock();
+    }
+    Bsp_Qspi_Finish(req, ret);
+}
+
+/*!@brief Re-init the QSPI and the flash, it leaves memory-mapped mode. Earlier requests are
+ *        done and readers of the window released, as for a write.
+ */
+static void Bsp_Qspi_StartInit(Qspi_ReqTypeDef *req)
+{
+    uint8_t ret = BSP_QSPI_Init();
+
+    Qspi_Mapped = 0;
+    Bsp_Qspi_Finish(req, ret);
+}
+
+/*!@brief Suspend the erase / page program for reads. It may have ended, or not be
+ *        suspended, then it is polled again and the suspend retried after a slice.
+ */
+static void Bsp_Qspi_Suspend(void)
+{
+    BSP_QSPI_Abort();
+    Qspi_Poll = 0;
+    if (Qspi_Done)
+    {
+        // Status matched before the abort.
+        Qspi_Done = 0;
+        Bsp_Qspi_ChipDone(Qspi_Status);
+        return;
+    }
+
+    BSP_QSPI_SuspendErase();
+    switch (BSP_QSPI_GetStatus())
+    {
+    case QSPI_SUSPENDED:
+        Qspi_Suspended    = 1;
+        Qspi_SuspendTick  = HAL_GetTick();
+        Qspi_SuspendReads = 0;
+        Qspi_Stat.Suspend++;
+        break;
+
+    case QSPI_OK:
+        Bsp_Qspi_ChipDone(QSPI_OK);
+        break;
+
+    default:
+        Qspi_ResumeTick = HAL_GetTick();
+        if (Bsp_Qspi_Poll() != QSPI_OK)
+        {
+            Bsp_Qspi_ChipDone(QSPI_ERROR);
+        }
+        break;
+    }
+}
+
+/*!@brief Resume the suspended erase / page program, its timeout is moved by the time
+ *        suspended.
+ */
+static void Bsp_Qspi_Resume(void)
+{
+    uint32_t tick = HAL_GetTick();
+
+    BSP_QSPI_ResumeErase();
+    Qspi_Suspended  = 0;
+    Qspi_ChipTick  += tick - Qspi_SuspendTick;
+    Qspi_ResumeTick = tick;
+    if (Bsp_Qspi_Poll() != QSPI_OK)
+    {
+        Bsp_Qspi_ChipDone(QSPI_ERROR);
+    }
+}
+
+/*!@brief Serve the queue: handle the completed transfer, suspend an erase / page program
+ *        for reads, start the next operation. Returns once an operation is in flight.
+ *
+ * @return Time in ms to call again at the latest, when no completion interrupt comes,
+ *         osWaitForever if the queue is empty.
+ */
+uint32_t Bsp_Qspi_Process(void)
+{
+    for (;;)
+    {
+        Qspi_ReqTypeDef *req = NULL;
+        uint32_t         tick;
+
+        if (Qspi_Done)
+        {
+            Qspi_Done = 0;
+            Bsp_Qspi_Complete(Qspi_Status);
+        }
+
+        // After completion, which may start the program timeout.
+        tick = HAL_GetTick();
+
+        if (Qspi_Xfer != NULL)
+        {
+            if (tick - Qspi_XferTick <= QSPI_READ_TIMEOUT)
+            {
+                return QSPI_READ_TIMEOUT;
+            }
+            BSP_QSPI_Abort();
+            Qspi_Done = 0;
+            Bsp_Qspi_Complete(QSPI_ERROR);
+            continue;
+        }
+
+        if ((Qspi_Chip != NULL) && !Qspi_Suspended)
+        {
+            if (tick - Qspi_ChipTick > Qspi_ChipLimit)
+            {
+                BSP_QSPI_Abort();
+                Qspi_Poll = 0;
+                Qspi_Done = 0;
+                Bsp_Qspi_ChipDone(QSPI_ERROR);
+                continue;
+            }
+
+            // Page program is short, only interactive reads suspend it.
+            req = Bsp_Qspi_Next(1, (Qspi_Chip->Op == QSPI_OP_ERASE) ? QSPI_CLASS_BACKGROUND
+                                                                     : QSPI_CLASS_INTERACTIVE);
+            if (!Qspi_Preempt || (req == NULL))
+            {
+                return QSPI_PROG_TIMEOUT;
+            }
+            if (tick - Qspi_ResumeTick <= QSPI_ERASE_SLICE)
+            {
+                return 1;
+            }
+            Bsp_Qspi_Suspend();
+            continue;
+        }
+
+        if (Qspi_Chip != NULL)
+        {
+            req = Bsp_Qspi_Next(1, QSPI_CLASS_BACKGROUND);
+            if ((req != NULL) && (Qspi_SuspendReads < QSPI_SUSPEND_READS))
+            {
+                Qspi_SuspendReads++;
+                Bsp_Qspi_StartRead(req);
+            }
+            else
+            {
+                Bsp_Qspi_Resume();
+            }
+            continue;
+        }
+
+        req = Bsp_Qspi_Next(0, QSPI_CLASS_BACKGROUND);
+        if ((req != NULL) && Bsp_Qspi_Modify(req) && (Qspi_Readers > 0))
+        {
+            // Readers of the window drain, Bsp_Qspi_Release() wakes the queue.
+            req = Bsp_Qspi_Next(1, QSPI_CLASS_BACKGROUND);
+            if (req == NULL)
+            {
+                return osWaitForever;
+            }
+        }
+        if (req == NULL)
+        {
+            if ((Qspi_Readers == 0) && (Bsp_Qspi_SetMapped(Qspi_MapIdle) != QSPI_OK))
+            {
+                Qspi_Stat.Error++;
+            }
+            return osWaitForever;
+        }
+        // The init resets the mode, also when it can't be left.
+        if (Bsp_Qspi_Modify(req) && (req->Op != QSPI_OP_INIT) &&
+            (Bsp_Qspi_SetMapped(0) != QSPI_OK))
+        {
+            Bsp_Qspi_Finish(req, QSPI_ERROR);
+            continue;
+        }
+
+        switch (req->Op)
+        {
+        case QSPI_OP_READ:
+            Bsp_Qspi_StartRead(req);
+            break;
+
+        case QSPI_OP_WRITE:
+            Bsp_Qspi_StartWrite(req);
+            break;
+
+        case QSPI_OP_ERASE:
+            Bsp_Qspi_StartErase(req);
+            break;
+
+        case QSPI_OP_INIT:
+            Bsp_Qspi_StartInit(req);
+            break;
+
+        default:
+            Bsp_Qspi_StartMap(req);
+            break;
+        }
+    }
+}
+
+/*!@brief QSPI I/O task, serves the queue for the other tasks. It must run before they
+ *        access the QSPI, i.e. have a higher priority. Callbacks run in it, they must not
+ *        wait a request.
+ */
+void Bsp_Qspi_Task(void const *arguments)
+{
+    Bsp_Qspi_Lock();
+    Bsp_Qspi_Init();
+    Qspi_TaskId = osThreadGetId();
+    Bsp_Qspi_Unlock();
+
+    for (;;)
+    {
+        osSemaphoreWait(Qspi_Event, Bsp_Qspi_Process());
+    }
+}
+
+/*!@brief Queue a request, its Callback and Context are set by the caller. The data buffer
+ *        must stay valid until completion.
+ *
+ * @return QSPI_OK if queued, QSPI_ERROR if the request is invalid.
+ */
+uint8_t Bsp_Qspi_Submit(Qspi_ReqTypeDef *req)
+{
+    Qspi_ReqTypeDef **link;
+
+    if ((req->Size == 0) || (req->Addr >= N25Q128A_FLASH_SIZE) ||
+        (req->Size > N25Q128A_FLASH_SIZE - req->Addr) || (req->Class >= QSPI_CLASSES) ||
+        (req->Op > QSPI_OP_INIT) ||
+        ((req->Op == QSPI_OP_ERASE) && ((req->Addr | req->Size) % N25Q128A_SUBSECTOR_SIZE)))
+    {
+        req->Status = QSPI_ERROR;
+        return QSPI_ERROR;
+    }
+
+    req->Next   = NULL;
+    req->Done   = 0;
+    req->Merged = 0;
+    req->Tick   = HAL_GetTick();
+    req->Status = QSPI_BUSY;
+
+    Bsp_Qspi_Lock();
+    Bsp_Qspi_Init();
+    if (Bsp_Qspi_Modify(req))
+    {
+        // Before any later read is queued, so that it can't fill the cache with old data.
+        Bsp_Qspi_CacheInvalidate(req->Addr, req->Size);
+    }
+    if (req->Op == QSPI_OP_READ)
+    {
+        Qspi_Stat.Read++;
+        Qspi_Stat.ReadBytes += req->Size;
+    }
+    else if (req->Op == QSPI_OP_WRITE)
+    {
+        Qspi_Stat.Write++;
+        Qspi_Stat.WriteBytes += req->Size;
+    }
+    req->Seq = Qspi_Seq++;
+    for (link = &Qspi_Queue[req->Class]; *link != NULL; link = &(*link)->Next)
+    {
+    }
+    *link = req;
+    Bsp_Qspi_Unlock();
+
+    if (Qspi_Event != NULL)
+    {
+        osSemaphoreRelease(Qspi_Event);
+    }
+    return QSPI_OK;
+}
+
+/*!@brief Without the I/O task, wait an interrupt or the time Bsp_Qspi_Process() asks.
+ */
+static void Bsp_Qspi_Sleep(uint32_t ms)
+{
+    uint32_t tick = HAL_GetTick();
+
+    ms = (ms > QSPI_READ_TIMEOUT) ? QSPI_READ_TIMEOUT : ms;
+    if (Qspi_Event != NULL)
+    {
+        osSemaphoreWait(Qspi_Event, ms);
+        return;
+    }
+    while (!Qspi_Done && (HAL_GetTick() - tick < ms))
+    {
+    }
+}
+
+/*!@brief Queue requests and sleep until all complete, they are served back to back. Their
+ *        Callback and Context are set here. Not from interrupt, it can neither sleep nor
+ *        lock the queues there, use Bsp_Qspi_Submit() with a Callback.
+ *
+ * @param req   : Requests, Op, Class, Data, Addr and Size set.
+ * @param count : Number of requests.
+ * @return QSPI_OK or the error of the first failed request, QSPI_ERROR from interrupt.
+ */
+uint8_t Bsp_Qspi_Run(Qspi_ReqTypeDef *req, uint32_t count)
+{
+    uint8_t ret = QSPI_OK;
+
+    if (__get_IPSR() != 0)
+    {
+        return QSPI_ERROR;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        req[i].Callback = NULL;
+        req[i].Context  = (Qspi_TaskId != NULL) ? osThreadGetId() : NULL;
+        Bsp_Qspi_Submit(&req[i]);
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        // A signal may be left by a request completed before it is waited.
+        while (req[i].Status == QSPI_BUSY)
+        {
+            if (Qspi_TaskId != NULL)
+            {
+                osSignalWait(QSPI_SIGNAL, osWaitForever);
+            }
+            else
+            {
+                uint32_t ms = Bsp_Qspi_Process();
+                if (req[i].Status == QSPI_BUSY)
+                {
+                    Bsp_Qspi_Sleep(ms);
+                }
+            }
+        }
+        ret = (ret == QSPI_OK) ? req[i].Status : ret;
+    }
+
+    return ret;
+}
+
+/*!@brief Queue a request and sleep until it completes. Reads go through the block cache.
+ *        Not from interrupt, as Bsp_Qspi_Run().
+ *
+ * @param op    : QSPI_OP_xxx.
+ * @param cls   : QSPI_CLASS_xxx.
+ * @param data  : Buffer, NULL for erase.
+ * @param addr  : Flash address, subsector aligned for erase.
+ * @param size  : Bytes, a multiple of subsectors for erase.
+ * @return QSPI_OK or the error of the failed operation.
+ */
+uint8_t Bsp_Qspi_Request(uint8_t op, uint8_t cls, uint8_t *data, uint32_t addr, uint32_t size)
+{
+    Qspi_ReqTypeDef req = {.Op = op, .Class = cls, .Data = data, .Addr = addr, .Size = size};
+
+    if (size == 0)
+    {
+        return QSPI_OK;
+    }
+    if (__get_IPSR() != 0)
+    {
+        return QSPI_ERROR;
+    }
+    if (op == QSPI_OP_READ)
+    {
+        return Bsp_Qspi_CacheRead(cls, data, addr, size);
+    }
+
+    return Bsp_Qspi_Run(&req, 1);
+}
+
+/*!@brief Read data, as an interactive request.
+ */
+uint8_t Bsp_Qspi_Read(uint8_t *data, uint32_t addr, uint32_t size)
+{
+    return Bsp_Qspi_Request(QSPI_OP_READ, QSPI_CLASS_INTERACTIVE, data, addr, size);
+}
+
+/*!@brief Write data, as an interactive request.
+ */
+uint8_t Bsp_Qspi_Write(uint8_t *data, uint32_t addr, uint32_t size)
+{
+    return Bsp_Qspi_Request(QSPI_OP_WRITE, QSPI_CLASS_INTERACTIVE, data, addr, size);
+}
+
+/*!@brief Erase subsectors, by sectors where aligned, as an interactive request.
+ */
+uint8_t Bsp_Qspi_Erase(uint32_t addr, uint32_t size)
+{
+    return Bsp_Qspi_Request(QSPI_OP_ERASE, QSPI_CLASS_INTERACTIVE, NULL, addr, size);
+}
+
+/*!@brief Get a pointer to flash data in the memory-mapped window, sleep until the mode is
+ *        set. Writes and erases queued before are done first. The data is read by the CPU
+ *        or a memory to memory DMA, until Bsp_Qspi_Release().
+ *
+ * @param addr  : Flash address.
+ * @param size  : Bytes, the area reads must stay in.
+ * @return Pointer to the data, NULL if the area is invalid or the mode can't be set.
+ */
+const uint8_t *Bsp_Qspi_Map(uint32_t addr, uint32_t size)
+{
+    Qspi_ReqTypeDef req = {
+        .Op = QSPI_OP_MAP, .Class = QSPI_CLASS_INTERACTIVE, .Addr = addr, .Size = size};
+
+    if (Bsp_Qspi_Run(&req, 1) != QSPI_OK)
+    {
+        return NULL;
+    }
+    return (const uint8_t *)QSPI_MAP_BASE + addr;
+}
+
+/*!@brief Release a pointer of Bsp_Qspi_Map(), once the last is released the writes and
+ *        erases waiting go on.
+ */
+void Bsp_Qspi_Release(void)
+{
+    uint8_t idle;
+
+    Bsp_Qspi_Lock();
+    Qspi_Readers -= (Qspi_Readers > 0);
+    idle = (Qspi_Readers == 0);
+    Bsp_Qspi_Unlock();
+
+    if (idle && (Qspi_Event != NULL))
+    {
+        osSemaphoreRelease(Qspi_Event);
+    }
+}
+
+/*!@brief Set the mode while idle, memory-mapped or indirect. Without the I/O task it is set
+ *        when the queue is served next.
+ *
+ * @param idle  : 1 to keep the window mapped while no request is queued.
+ */
+void Bsp_Qspi_MapMode(uint8_t idle)
+{
+    Qspi_MapIdle = idle;
+    if (Qspi_Event != NULL)
+    {
+        osSemaphoreRelease(Qspi_Event);
+    }
+}
+
+/*!@brief Re-init the QSPI and the flash, sleep until done. Requests queued before are done
+ *        first, the window is unmapped once its readers released it. Not from interrupt.
+ *
+ * @return QSPI_OK or the error of the init.
+ */
+uint8_t Bsp_Qspi_Reset(void)
+{
+    Qspi_ReqTypeDef req = {.Op    = QSPI_OP_INIT,
+                           .Class = QSPI_CLASS_INTERACTIVE,
+                           .Addr  = 0,
+                           .Size  = N25Q128A_FLASH_SIZE};
+
+    return Bsp_Qspi_Run(&req, 1);
+}
@@ -0,0 +1,135 @@
+/******************************************************************************
+ * @file    bsp_qspi.h
+ * @brief   Task level access to the N25Q128A QSPI flash without busy waiting, through
+ *          an I/O scheduler.
+ *
+ *          Reads are done by DMA and writes by DMA page program, the end of each page
+ *          program and erase is waited by the status match interrupt. Requests are queued
+ *          and served by the QSPI I/O task Bsp_Qspi_Task(), the calling task sleeps until
+ *          its request completes, or a callback is called by the I/O task. Without the I/O
+ *          task, e.g. before the scheduler starts, the caller serves the queue itself,
+ *          one task at a time.
+ *
+ *          Scheduling:
+ *          - Interactive requests are served before background ones, e.g. garbage
+ *            collection. Requests are split in DMA reads, page programs and erase blocks,
+ *            other requests are served between the parts of a long one.
+ *          - A read queued while an erase or page program runs suspends it, unless it
+ *            reads the area being erased / programmed. Up to QSPI_SUSPEND_READS DMA reads
+ *            are served, then the operation resumes and runs at least QSPI_ERASE_SLICE ms
+ *            before the next suspend. Only interactive reads suspend a page program.
+ *          - Queued writes entirely in the page of a page program are merged in it, the
+ *            bytes are ANDed as NOR programming does.
+ *          - Requests on overlapping areas complete in submit order, unless both read.
+ *
+ *          Reads of Bsp_Qspi_Read() / Bsp_Qspi_Request() go through the block cache of
+ *          bsp_qspi_cache.h, submitted requests don't.
+ *
+ *          Memory-mapped mode:
+ *          - Bsp_Qspi_Map() returns a pointer into the QSPI_MAP_BASE window, valid until
+ *            Bsp_Qspi_Release(). The mode is entered once no program / erase runs.
+ *          - While mapped, queued reads are copied from the window. A write or erase waits
+ *            until the pointers are released, maps queued after it wait until it is done,
+ *            then indirect mode is set for it.
+ *          - Once the queue is empty and no pointer is held, the window is mapped again if
+ *            Qspi_MapIdle, left otherwise.
+ *          A task holding a pointer must release it before it writes, erases or maps again.
+ *          Bsp_Qspi_Reset() re-inits the chip in queue order as a write, with the same rule.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef INC_BSP_BSP_QSPI_H_
+#define INC_BSP_BSP_QSPI_H_
+
+#include "stdint.h"
+#include "stm32l476g_discovery_qspi.h"
+
+// clang-format off
+#define QSPI_DMA_MIN            32          //!< Reads of N bytes and more are done by DMA
+#define QSPI_DMA_MAX            0x8000      //!< Bytes of a DMA read, DMA counter is 16 bits
+#define QSPI_READ_TIMEOUT       10          //!< DMA read timeout in ms, 0.8 ms per 32 kB at 40 MHz
+#define QSPI_PROG_TIMEOUT       10          //!< Page program timeout in ms, tPP is 5 ms max
+#define QSPI_ERASE_SLICE        2           //!< Erase runs N ms after resume before next suspend
+#define QSPI_SUSPEND_READS      4           //!< DMA reads served per suspend
+#define QSPI_SIGNAL             0x0100      //!< Signal of request completion to its task
+#define QSPI_MAP_BASE           QSPI_BASE   //!< Memory-mapped window, flash address 0
+
+/*!@defgroup QSPI_OP Request operation.
+ */
+#define QSPI_OP_READ            0
+#define QSPI_OP_WRITE           1
+#define QSPI_OP_ERASE           2           //!< Subsectors, by 64 kB sectors where aligned
+#define QSPI_OP_MAP             3           //!< Memory-mapped mode for a reader, no data
+#define QSPI_OP_INIT            4           //!< Re-init the QSPI and the flash, indirect mode
+
+/*!@defgroup QSPI_CLASS Request class, in priority order.
+ */
+#define QSPI_CLASS_INTERACTIVE  0           //!< User and application accesses
+#define QSPI_CLASS_BACKGROUND   1           //!< Garbage collection, log rotation, copies
+#define QSPI_CLASSES            2
+// clang-format on
+
+typedef struct Qspi_ReqTypeDef Qspi_ReqTypeDef;
+
+/*!@struct Qspi_ReqTypeDef
+ *          Request, owned by the scheduler from Bsp_Qspi_Submit() until Status isn't
+ *          QSPI_BUSY.
+ */
+struct Qspi_ReqTypeDef {
+    Qspi_ReqTypeDef *Next;                           //!> Queue link
+    void (*Callback)(Qspi_ReqTypeDef *req);          //!> Called by the I/O task on completion
+    void *           Context;                        //!> Task signaled on completion without callback
+    uint8_t *        Data;                           //!> Buffer, NULL for erase
+    uint32_t         Addr;                           //!> Flash address
+    uint32_t         Size;                           //!> Bytes, a multiple of subsectors for erase
+    uint32_t         Done;                           //!> Bytes done
+    uint32_t         Seq;                            //!> Submit order
+    uint32_t         Tick;                           //!> Submit tick
+    uint8_t          Op;                             //!> QSPI_OP_xxx
+    uint8_t          Class;                          //!> QSPI_CLASS_xxx
+    uint8_t          Merged;                         //!> Programmed by the current page program
+    volatile uint8_t Status;                         //!> QSPI_BUSY until completed
+};
+
+typedef struct {
+    uint32_t Read;                     //!> Read requests
+    uint64_t ReadBytes;                //!> Bytes read
+    uint32_t DmaRead;                  //!> DMA reads, a request is split at QSPI_DMA_MAX
+    uint32_t Write;                    //!> Write requests
+    uint64_t WriteBytes;               //!> Bytes written
+    uint32_t Page;                     //!> Page programs
+    uint32_t Merge;                    //!> Write requests merged in the page program of another
+    uint32_t Erase;                    //!> Erase operations, subsector or sector
+    uint32_t Suspend;                  //!> Erases / page programs suspended for reads
+    uint32_t Error;                    //!> Transfers failed or timed out
+    uint32_t Map;                      //!> Switches to memory-mapped mode
+    uint32_t Unmap;                    //!> Switches back to indirect mode
+    uint32_t MapRead;                  //!> Reads copied from the memory-mapped window
+    uint32_t Latency[QSPI_CLASSES];    //!> Max ms from submit to completion, by class
+} Qspi_StatTypeDef;
+
+extern Qspi_StatTypeDef Qspi_Stat;
+extern uint8_t          Qspi_Preempt;  //!< Reads suspend erases / programs, 1 by default
+extern uint8_t          Qspi_MapIdle;  //!< Memory-mapped mode while idle, see Bsp_Qspi_MapMode()
+extern uint8_t          Qspi_Blocking; //!< Indirect reads polled instead of DMA, for comparison
+
+void           Bsp_Qspi_Lock(void);
+void           Bsp_Qspi_Unlock(void);
+uint8_t        Bsp_Qspi_Submit(Qspi_ReqTypeDef *req);
+uint8_t        Bsp_Qspi_Run(Qspi_ReqTypeDef *req, uint32_t count);
+uint32_t       Bsp_Qspi_Process(void);
+void           Bsp_Qspi_Task(void const *arguments);
+uint8_t        Bsp_Qspi_Request(uint8_t op, uint8_t cls, uint8_t *data, uint32_t addr,
+                                uint32_t size);
+uint8_t        Bsp_Qspi_Read(uint8_t *data, uint32_t addr, uint32_t size);
+uint8_t        Bsp_Qspi_Write(uint8_t *data, uint32_t addr, uint32_t size);
+uint8_t        Bsp_Qspi_Erase(uint32_t addr, uint32_t size);
+const uint8_t *Bsp_Qspi_Map(uint32_t addr, uint32_t size);
+void           Bsp_Qspi_Release(void);
+void           Bsp_Qspi_MapMode(uint8_t idle);
+uint8_t        Bsp_Qspi_Reset(void);
+
+#endif /* INC_BSP_BSP_QSPI_H_ */
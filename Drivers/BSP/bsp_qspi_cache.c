@@ -0,0 +1,327 @@
+/******************************************************************************
+ * @file    bsp_qspi_cache.c
+ * @brief   LRU block cache of QSPI flash reads, in SRAM2.
+ *
+ *          A quad read command costs ~0.6 us of command, address and dummy cycles, plus
+ *          the DMA setup and its interrupt, whatever its size. Metadata of a store is read
+ *          over and over in small pieces, a hit is a copy from SRAM2 instead.
+ *
+ *          Missing blocks of a request are read by one DMA read into consecutive slots,
+ *          the run of slots whose last access is the oldest. A miss on a block not missed
+ *          lately, next to no cached block, reads the request alone and records its blocks.
+ *          Slots are picked and released under Bsp_Qspi_Lock(), a slot being filled is out
+ *          of lookups and replacement.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include "bsp_qspi_cache.h"
+#include "bsp_qspi.h"
+#include "string.h"
+
+// clang-format off
+#define QSPI_CACHE_FREE         0
+#define QSPI_CACHE_VALID        1
+#define QSPI_CACHE_FILLING      2           //!< Read in flight
+#define QSPI_CACHE_STALE        3           //!< Invalidated while filling, freed once read
+// clang-format on
+
+typedef struct {
+    uint32_t Addr;  //!> Flash address of the block
+    uint32_t Use;   //!> Qspi_CacheClock of the last access
+    uint8_t  State; //!> QSPI_CACHE_xxx
+    uint8_t  Ahead; //!> Read ahead and not hit yet
+} Qspi_CacheBlockTypeDef;
+
+Qspi_CacheStatTypeDef Qspi_CacheStat   = {0};
+uint8_t               Qspi_CacheEnable = 1;
+
+static Qspi_CacheBlockTypeDef Qspi_CacheBlock[QSPI_CACHE_BLOCKS];
+static uint32_t               Qspi_CacheClock = 0;
+static uint32_t               Qspi_CacheLast  = 0; //!< End address of the last read
+static uint32_t               Qspi_CacheHistory[QSPI_CACHE_HISTORY]; //!< Missed block + 1, 0 none
+static uint32_t               Qspi_CacheHistoryPos = 0; //!< Next history entry to replace
+
+// SRAM2 isn't cleared by the startup, slots are free by their State in .bss.
+static uint8_t Qspi_CacheData[QSPI_CACHE_BLOCKS][QSPI_CACHE_BLOCK]
+    __attribute__((section(".ram2")));
+
+/*!@brief Find a valid block, call locked.
+ *
+ * @param addr  : Block address.
+ * @return Slot index, -1 if not cached.
+ */
+static int Bsp_Qspi_CacheFind(uint32_t addr)
+{
+    for (uint32_t i = 0; i < QSPI_CACHE_BLOCKS; i++)
+    {
+        if ((Qspi_CacheBlock[i].State == QSPI_CACHE_VALID) && (Qspi_CacheBlock[i].Addr == addr))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*!@brief Get consecutive slots to fill, the run whose most recently used slot is the least
+ *        recently used, free slots first. A single slot is the LRU one. Call locked.
+ *
+ * @param n     : Number of slots.
+ * @return Index of the first slot, -1 if each run has a slot being filled.
+ */
+static int Bsp_Qspi_CacheVictim(uint32_t n)
+{
+    int      run = -1;
+    uint32_t age = 0; //!< Accesses since the last one to the chosen run
+
+    for (uint32_t s = 0; s + n <= QSPI_CACHE_BLOCKS; s++)
+    {
+        uint32_t newest = UINT32_MAX;
+        uint32_t k;
+
+        for (k = 0; k < n; k++)
+        {
+            Qspi_CacheBlockTypeDef *block = &Qspi_CacheBlock[s + k];
+
+            if ((block->State == QSPI_CACHE_FILLING) || (block->State == QSPI_CACHE_STALE))
+            {
+                break;
+            }
+            if ((block->State == QSPI_CACHE_VALID) && (Qspi_CacheClock - block->Use < newest))
+            {
+                newest = Qspi_CacheClock - block->Use;
+            }
+        }
+
+        if ((k == n) && ((run < 0) || (newest > age)))
+        {
+            run = s;
+            age = newest;
+        }
+    }
+    return run;
+}
+
+/*!@brief Check a missed block has history: it missed lately or a neighbour is cached. Without,
+ *        the blocks up to the end of the request are recorded. Call locked.
+ *
+ * @param blk   : Missed block address.
+ * @param end   : End address of the request.
+ * @return 1 if the block has history.
+ */
+static uint8_t Bsp_Qspi_CacheSeen(uint32_t blk, uint32_t end)
+{
+    for (uint32_t i = 0; i < QSPI_CACHE_HISTORY; i++)
+    {
+        if (Qspi_CacheHistory[i] == blk + 1)
+        {
+            return 1;
+        }
+    }
+    if (((blk > 0) && (Bsp_Qspi_CacheFind(blk - QSPI_CACHE_BLOCK) >= 0)) ||
+        (Bsp_Qspi_CacheFind(blk + QSPI_CACHE_BLOCK) >= 0))
+    {
+        return 1;
+    }
+
+    for (; blk < end; blk += QSPI_CACHE_BLOCK)
+    {
+        Qspi_CacheHistory[Qspi_CacheHistoryPos] = blk + 1;
+        Qspi_CacheHistoryPos = (Qspi_CacheHistoryPos + 1) % QSPI_CACHE_HISTORY;
+    }
+    return 0;
+}
+
+/*!@brief Copy the part of a slot inside the requested area, call locked.
+ */
+static void Bsp_Qspi_CacheCopy(uint32_t i, uint8_t *data, uint32_t addr, uint32_t size)
+{
+    uint32_t blk = Qspi_CacheBlock[i].Addr;
+    uint32_t lo  = (addr > blk) ? addr : blk;
+    uint32_t hi  = (addr + size < blk + QSPI_CACHE_BLOCK) ? addr + size : blk + QSPI_CACHE_BLOCK;
+
+    memcpy(data + (lo - addr), &Qspi_CacheData[i][lo - blk], hi - lo);
+}
+
+/*!@brief Read missing blocks from *blk on: the following blocks of the request up to the
+ *        first cached one, and the next ones of a sequential stream. Without history of
+ *        *blk, or without slots to fill, the rest of the request is read uncached.
+ *
+ * @param blk   : First missing block, moved past the blocks of the request read.
+ * @param ahead : Read ahead past the request.
+ * @return QSPI_OK or the error of the read.
+ */
+static uint8_t Bsp_Qspi_CacheFill(uint8_t cls, uint32_t *blk, uint8_t ahead, uint8_t *data,
+                                  uint32_t addr, uint32_t size)
+{
+    Qspi_ReqTypeDef req = {.Op = QSPI_OP_READ, .Class = cls, .Addr = *blk};
+    uint32_t        end  = addr + size;
+    uint32_t        last = (end - 1) & ~(QSPI_CACHE_BLOCK - 1);
+    uint32_t        n    = 1;
+    int             s    = -1;
+
+    if (ahead)
+    {
+        last += QSPI_CACHE_AHEAD * QSPI_CACHE_BLOCK;
+    }
+
+    Bsp_Qspi_Lock();
+    if (ahead || Bsp_Qspi_CacheSeen(*blk, end))
+    {
+        while (n < QSPI_CACHE_FILL)
+        {
+            uint32_t b = *blk + n * QSPI_CACHE_BLOCK;
+
+            if ((b > last) || (b >= N25Q128A_FLASH_SIZE) || (Bsp_Qspi_CacheFind(b) >= 0))
+            {
+                break;
+            }
+            n++;
+        }
+
+        // Each run has a slot being filled when other tasks fill all over the cache.
+        s = Bsp_Qspi_CacheVictim(n);
+        for (uint32_t k = 0; (s >= 0) && (k < n); k++)
+        {
+            Qspi_CacheBlock[s + k].Addr  = *blk + k * QSPI_CACHE_BLOCK;
+            Qspi_CacheBlock[s + k].State = QSPI_CACHE_FILLING;
+        }
+    }
+    Bsp_Qspi_Unlock();
+
+    if (s < 0)
+    {
+        uint32_t lo = (addr > *blk) ? addr : *blk;
+
+        req.Data = data + (lo - addr);
+        req.Addr = lo;
+        req.Size = end - lo;
+        Qspi_CacheStat.Bypass++;
+        *blk = end;
+        return Bsp_Qspi_Run(&req, 1);
+    }
+
+    req.Data = Qspi_CacheData[s];
+    req.Size = n * QSPI_CACHE_BLOCK;
+    Bsp_Qspi_Run(&req, 1);
+
+    Bsp_Qspi_Lock();
+    for (uint32_t k = 0; k < n; k++)
+    {
+        Qspi_CacheBlockTypeDef *block = &Qspi_CacheBlock[s + k];
+
+        if (block->Addr < end)
+        {
+            if (req.Status == QSPI_OK)
+            {
+                Bsp_Qspi_CacheCopy(s + k, data, addr, size);
+            }
+            Qspi_CacheStat.Miss++;
+            *blk += QSPI_CACHE_BLOCK;
+        }
+        else
+        {
+            Qspi_CacheStat.Ahead++;
+        }
+
+        // Another task may have cached the block meanwhile.
+        if ((req.Status == QSPI_OK) && (block->State == QSPI_CACHE_FILLING) &&
+            (Bsp_Qspi_CacheFind(block->Addr) < 0))
+        {
+            block->State = QSPI_CACHE_VALID;
+            block->Use   = ++Qspi_CacheClock;
+            block->Ahead = (block->Addr >= end);
+        }
+        else
+        {
+            block->State = QSPI_CACHE_FREE;
+        }
+    }
+    Bsp_Qspi_Unlock();
+
+    return req.Status;
+}
+
+/*!@brief Read data through the cache, sleep while missing blocks are read.
+ *        A request starting less than a block after the end of the previous one is
+ *        sequential and reads ahead.
+ *
+ * @param cls   : QSPI_CLASS_xxx of the flash reads.
+ * @param data  : Buffer.
+ * @param addr  : Flash address.
+ * @param size  : Bytes.
+ * @return QSPI_OK or the error of the failed read.
+ */
+uint8_t Bsp_Qspi_CacheRead(uint8_t cls, uint8_t *data, uint32_t addr, uint32_t size)
+{
+    uint32_t blk   = addr & ~(QSPI_CACHE_BLOCK - 1);
+    uint8_t  ahead = (addr >= Qspi_CacheLast) && (addr - Qspi_CacheLast < QSPI_CACHE_BLOCK);
+    uint8_t  ret   = QSPI_OK;
+
+    if (!Qspi_CacheEnable || (size >= QSPI_CACHE_BYPASS) || (addr >= N25Q128A_FLASH_SIZE) ||
+        (size > N25Q128A_FLASH_SIZE - addr))
+    {
+        Qspi_ReqTypeDef req = {
+            .Op = QSPI_OP_READ, .Class = cls, .Data = data, .Addr = addr, .Size = size};
+
+        Qspi_CacheStat.Bypass++;
+        return Bsp_Qspi_Run(&req, 1);
+    }
+
+    while ((blk < addr + size) && (ret == QSPI_OK))
+    {
+        int i;
+
+        Bsp_Qspi_Lock();
+        i = Bsp_Qspi_CacheFind(blk);
+        if (i >= 0)
+        {
+            Qspi_CacheStat.Hit++;
+            Qspi_CacheStat.AheadHit += Qspi_CacheBlock[i].Ahead;
+            Qspi_CacheBlock[i].Ahead = 0;
+            Qspi_CacheBlock[i].Use   = ++Qspi_CacheClock;
+            Bsp_Qspi_CacheCopy(i, data, addr, size);
+            blk += QSPI_CACHE_BLOCK;
+        }
+        Bsp_Qspi_Unlock();
+
+        if (i < 0)
+        {
+            ret = Bsp_Qspi_CacheFill(cls, &blk, ahead, data, addr, size);
+        }
+    }
+
+    Qspi_CacheLast = addr + size;
+    return ret;
+}
+
+/*!@brief Drop the cached blocks of a flash area, blocks being filled are dropped once read.
+ *
+ * @param addr  : Flash address.
+ * @param size  : Bytes.
+ */
+void Bsp_Qspi_CacheInvalidate(uint32_t addr, uint32_t size)
+{
+    Bsp_Qspi_Lock();
+    for (uint32_t i = 0; i < QSPI_CACHE_BLOCKS; i++)
+    {
+        Qspi_CacheBlockTypeDef *block = &Qspi_CacheBlock[i];
+
+        if ((block->Addr >= addr + size) || (block->Addr + QSPI_CACHE_BLOCK <= addr))
+        {
+            continue;
+        }
+        if (block->State == QSPI_CACHE_VALID)
+        {
+            block->State = QSPI_CACHE_FREE;
+            Qspi_CacheStat.Invalidate++;
+        }
+        else if (block->State == QSPI_CACHE_FILLING)
+        {
+            block->State = QSPI_CACHE_STALE;
+        }
+    }
+    Bsp_Qspi_Unlock();
+}
@@ -0,0 +1,61 @@
+/******************************************************************************
+ * @file    bsp_qspi_cache.h
+ * @brief   LRU block cache of QSPI flash reads, in SRAM2.
+ *
+ *          Reads by Bsp_Qspi_Read() / Bsp_Qspi_Request() are served from cached blocks of
+ *          QSPI_CACHE_BLOCK bytes, missing blocks are read by DMA into the least recently
+ *          used ones. A miss right after the previous read, i.e. a sequential stream, also
+ *          reads ahead QSPI_CACHE_AHEAD blocks in the same DMA read. Reads of
+ *          QSPI_CACHE_BYPASS bytes and more go to the flash, they would flush the cache.
+ *
+ *          A miss out of a sequential stream, on a block neither missed lately nor next to a
+ *          cached one, reads only the requested bytes and records its blocks in a history
+ *          of QSPI_CACHE_HISTORY misses. The next miss of the block fills the cache, so
+ *          reads without locality cost a read each, as uncached.
+ *
+ *          The cache holds no dirty data: writes and erases queued by Bsp_Qspi_Submit()
+ *          drop the blocks they overlap, and a block being filled meanwhile isn't kept.
+ *          Flash changed another way, e.g. blocking BSP_QSPI_xxx() calls or memory-mapped
+ *          mode, must be invalidated by Bsp_Qspi_CacheInvalidate().
+ *
+ *          Block data is in section .ram2, placed in SRAM2 by the linker script before the
+ *          heap check, so QSPI_CACHE_SIZE and the heap / stack reserve share the 32 kB.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef INC_BSP_BSP_QSPI_CACHE_H_
+#define INC_BSP_BSP_QSPI_CACHE_H_
+
+#include "stdint.h"
+
+// clang-format off
+#ifndef QSPI_CACHE_SIZE
+#define QSPI_CACHE_SIZE         8192        //!< Bytes of block data in SRAM2
+#endif
+#define QSPI_CACHE_BLOCK        128         //!< Bytes of a block
+#define QSPI_CACHE_BLOCKS       (QSPI_CACHE_SIZE / QSPI_CACHE_BLOCK)
+#define QSPI_CACHE_AHEAD        8           //!< Blocks read ahead of a sequential read
+#define QSPI_CACHE_HISTORY      64          //!< Blocks of the last misses not cached
+#define QSPI_CACHE_BYPASS       1024        //!< Reads of N bytes and more aren't cached
+#define QSPI_CACHE_FILL         (QSPI_CACHE_BYPASS / QSPI_CACHE_BLOCK + 1 + QSPI_CACHE_AHEAD)
+// clang-format on
+
+typedef struct {
+    uint32_t Hit;        //!> Blocks found in the cache
+    uint32_t Miss;       //!> Blocks read from flash for a request
+    uint32_t Ahead;      //!> Blocks read ahead of a sequential request
+    uint32_t AheadHit;   //!> Blocks read ahead, then hit
+    uint32_t Bypass;     //!> Reads not cached: too large, cache off or no history
+    uint32_t Invalidate; //!> Blocks dropped by writes and erases
+} Qspi_CacheStatTypeDef;
+
+extern Qspi_CacheStatTypeDef Qspi_CacheStat;
+extern uint8_t               Qspi_CacheEnable; //!< Reads go through the cache, 1 by default
+
+uint8_t Bsp_Qspi_CacheRead(uint8_t cls, uint8_t *data, uint32_t addr, uint32_t size);
+void    Bsp_Qspi_CacheInvalidate(uint32_t addr, uint32_t size);
+
+#endif /* INC_BSP_BSP_QSPI_CACHE_H_ */
@@ -0,0 +1,1024 @@
+/******************************************************************************
+ * @file    bsp_qspi_fs.c
+ * @brief   Power-safe flat file system on the N25Q128A QSPI flash, copy-on-write.
+ *
+ *          Layout, in QSPI_FS_BLOCK blocks:
+ *          - Blocks 0 ~ QSPI_FS_SUPER_BLOCKS - 1: ring of superblock records. A record
+ *            holds the commit sequence, the metadata block and the allocation cursor,
+ *            with a crc. The ring block with the highest first sequence holds the newest
+ *            record, it's the only one scanned at mount.
+ *          - Metadata block: used block bitmap and directory, rewritten to a new block by
+ *            each commit.
+ *          - Data blocks. A file of one block points at its data block, a larger file at
+ *            an index block holding the block number of each file block.
+ *
+ *          Writes allocate a new block for each file block they change and copy the
+ *          unchanged part of the old one, appends program the erased end of the last
+ *          block in place, once checked erased after a reopen. Blocks replaced are freed
+ *          by the next commit, the last commit stays readable until then. Blocks written
+ *          and not committed are free again after a reset: the bitmap of the last commit
+ *          doesn't hold them.
+ *
+ *          The price of this power safety is write amplification. An overwrite, whatever
+ *          its size, copies the rest of each block it touches, up to 4 kB, and erases a
+ *          block for it. A commit writes the metadata block, and the index block of a file
+ *          of more than one block, each to a newly erased block. A 64 bytes overwrite and
+ *          sync costs about 3 erases and 4 kB copied, small appends with a sync each cost
+ *          about 1 erase per commit. Batch small writes before QSPI_FS_Sync().
+ *
+ *          Reads of file data and of index entries go through the QSPI cache, reads of
+ *          superblock records and metadata don't.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include "bsp_qspi_fs.h"
+#include "stddef.h"
+#include "string.h"
+
+#include "bsp_qspi.h"
+#include "dfu_crc.h"
+
+// clang-format off
+#define QSPI_FS_MAGIC           0x53465351  //!< "QSFS", superblock record
+#define QSPI_FS_META_MAGIC      0x4154454D  //!< "META", metadata block
+#define QSPI_FS_RECORD_SIZE     32
+#define QSPI_FS_RECORDS         (QSPI_FS_BLOCK / QSPI_FS_RECORD_SIZE)
+#define QSPI_FS_CHUNK           256         //!< Bytes of a superblock scan / block copy read
+#define QSPI_FS_NONE            0xFFFF      //!< No block
+#define QSPI_FS_WRITER          0x80        //!< QSPI_FS_Users[] of the file open for writing
+#define QSPI_FS_READERS         0x7F        //!< Max readers of a file
+#define QSPI_FS_DATA_BLOCKS     (QSPI_FS_BLOCKS - QSPI_FS_SUPER_BLOCKS)
+#define QSPI_FS_ADDR(block)     (QSPI_FS_BASE + (block) * QSPI_FS_BLOCK)
+#define QSPI_FS_COUNT(size)     (((size) + QSPI_FS_BLOCK - 1) / QSPI_FS_BLOCK)
+#define QSPI_FS_IS(map, b)      (((map)[(b) >> 3] >> ((b) & 7)) & 1)
+#define QSPI_FS_SET(map, b)     ((map)[(b) >> 3] |= (1U << ((b) & 7)))
+#define QSPI_FS_CLR(map, b)     ((map)[(b) >> 3] &= ~(1U << ((b) & 7)))
+// clang-format on
+
+typedef struct {
+    uint32_t Magic;       //!< QSPI_FS_MAGIC
+    uint32_t Sequence;    //!< Commit order
+    uint32_t Meta;        //!< Metadata block
+    uint32_t Cursor;      //!< Last allocated block
+    uint32_t Reserved[3]; //!< 0
+    uint32_t Crc;         //!< CRC32 of the fields above
+} QSPI_FS_RecordTypeDef;
+
+typedef struct {
+    char     Name[QSPI_FS_NAME_MAX + 1]; //!< Empty for a free entry
+    uint32_t Size;                       //!< Bytes
+    uint16_t Index;    //!< Data block of a 1 block file, index block of a larger one, or none
+    uint16_t Reserved; //!< 0
+} QSPI_FS_EntryTypeDef;
+
+typedef struct {
+    uint32_t             Magic;    //!< QSPI_FS_META_MAGIC
+    uint32_t             Sequence; //!< Of the superblock record pointing at the block
+    uint32_t             Crc;      //!< CRC32 from Blocks to the end
+    uint32_t             Blocks;   //!< QSPI_FS_BLOCKS of the format
+    uint8_t              Used[QSPI_FS_BLOCKS / 8];
+    QSPI_FS_EntryTypeDef File[QSPI_FS_FILES];
+} QSPI_FS_MetaTypeDef;
+
+#if (QSPI_FS_BLOCKS >= QSPI_FS_NONE) || (QSPI_FS_BLOCKS % 8)
+#error "QSPI_FS_BLOCKS out of 16-bit block numbers, or not a multiple of 8"
+#endif
+
+#if (QSPI_FS_BASE + QSPI_FS_SIZE) > N25Q128A_FLASH_SIZE
+#error "QSPI_FS_SIZE beyond the QSPI flash"
+#endif
+
+_Static_assert(sizeof(QSPI_FS_RecordTypeDef) == QSPI_FS_RECORD_SIZE, "Superblock record size");
+_Static_assert(sizeof(QSPI_FS_MetaTypeDef) <= QSPI_FS_BLOCK, "Metadata larger than a block");
+
+QSPI_FS_StatTypeDef QSPI_FS_Stat = {0};
+
+static QSPI_FS_MetaTypeDef QSPI_FS_Meta; //!< Last commit
+static QSPI_FS_MetaTypeDef QSPI_FS_Work; //!< Commit being written
+static uint8_t  QSPI_FS_New[QSPI_FS_BLOCKS / 8];  //!< Blocks the writer wrote since its last commit
+static uint8_t  QSPI_FS_Drop[QSPI_FS_BLOCKS / 8]; //!< Committed blocks the writer replaced
+static uint16_t QSPI_FS_Map[QSPI_FS_FILE_BLOCKS]; //!< Blocks of the file open for writing
+static char     QSPI_FS_Name[QSPI_FS_NAME_MAX + 1]; //!< Name of the file open for writing
+static uint8_t  QSPI_FS_Users[QSPI_FS_FILES];       //!< Readers of each file, or QSPI_FS_WRITER
+static uint8_t  QSPI_FS_Buffer[QSPI_FS_CHUNK];
+static uint32_t QSPI_FS_Tail      = QSPI_FS_NONE; //!< File block the writer has just written
+static uint32_t QSPI_FS_Fill      = 0;            //!< Bytes of the tail block not erased
+static uint8_t  QSPI_FS_Dirty     = 0;            //!< Writer has changes to commit
+static uint8_t  QSPI_FS_MapDirty  = 0;            //!< QSPI_FS_Map changed since the last commit
+static uint32_t QSPI_FS_MetaBlock = QSPI_FS_NONE; //!< Metadata block of the last commit
+static uint32_t QSPI_FS_Cursor    = 0;            //!< Last allocated block
+static uint32_t QSPI_FS_Sequence  = 0;            //!< Sequence of the last commit
+static uint32_t QSPI_FS_Super     = 0;            //!< Ring block of the newest record
+static uint32_t QSPI_FS_SuperPos  = 0;            //!< Next record slot in the ring block
+static uint8_t  QSPI_FS_Ready     = 0;
+
+/*!@brief Read past the QSPI cache, for data read once.
+ */
+static int QSPI_FS_ReadAt(uint32_t addr, void *data, uint32_t size)
+{
+    Qspi_ReqTypeDef req = {
+        .Op = QSPI_OP_READ, .Class = QSPI_CLASS_INTERACTIVE, .Data = data, .Addr = addr, .Size = size};
+
+    uint8_t ret = Bsp_Qspi_Run(&req, 1);
+    return (ret == QSPI_OK) ? QSPI_FS_OK : QSPI_FS_ERROR;
+}
+
+static int QSPI_FS_WriteAt(uint32_t addr, const void *data, uint32_t size)
+{
+    uint8_t ret = Bsp_Qspi_Write((uint8_t *)data, addr, size);
+    return (ret == QSPI_OK) ? QSPI_FS_OK : QSPI_FS_ERROR;
+}
+
+/*!@brief Erase and allocate the first free block after the cursor.
+ *
+ * @param mark  : Bitmap the block is set in, also excluded from the search.
+ * @return Block number, or QSPI_FS_NOSPC / QSPI_FS_ERROR.
+ */
+static int32_t QSPI_FS_Alloc(uint8_t *mark)
+{
+    for (uint32_t n = 1; n <= QSPI_FS_DATA_BLOCKS; n++)
+    {
+        uint32_t b = QSPI_FS_SUPER_BLOCKS +
+                     (QSPI_FS_Cursor - QSPI_FS_SUPER_BLOCKS + n) % QSPI_FS_DATA_BLOCKS;
+
+        if (QSPI_FS_IS(QSPI_FS_Meta.Used, b) || QSPI_FS_IS(QSPI_FS_New, b) || QSPI_FS_IS(mark, b))
+        {
+            continue;
+        }
+
+        QSPI_FS_Cursor = b;
+        QSPI_FS_Stat.Erase++;
+        if (Bsp_Qspi_Erase(QSPI_FS_ADDR(b), QSPI_FS_BLOCK) != QSPI_OK)
+        {
+            return QSPI_FS_ERROR;
+        }
+        QSPI_FS_SET(mark, b);
+        return b;
+    }
+    return QSPI_FS_NOSPC;
+}
+
+/*!@brief Release a block of the file open for writing: free at once if not committed yet,
+ *        freed by the next commit otherwise.
+ */
+static void QSPI_FS_Release(uint32_t block)
+{
+    if (QSPI_FS_IS(QSPI_FS_New, block))
+    {
+        QSPI_FS_CLR(QSPI_FS_New, block);
+    }
+    else
+    {
+        QSPI_FS_SET(QSPI_FS_Drop, block);
+    }
+}
+
+/*!@brief Refresh file and block counts of QSPI_FS_Stat.
+ */
+static void QSPI_FS_Count(void)
+{
+    QSPI_FS_Stat.Sequence = QSPI_FS_Sequence;
+    QSPI_FS_Stat.Files    = 0;
+    QSPI_FS_Stat.Used     = 0;
+
+    for (uint32_t i = 0; i < QSPI_FS_FILES; i++)
+    {
+        QSPI_FS_Stat.Files += (QSPI_FS_Meta.File[i].Name[0] != 0);
+    }
+    for (uint32_t b = 0; b < QSPI_FS_BLOCKS; b++)
+    {
+        QSPI_FS_Stat.Used += QSPI_FS_IS(QSPI_FS_Meta.Used, b);
+    }
+}
+
+/*!@brief Write QSPI_FS_Work to a new metadata block, then the superblock record pointing at
+ *        it. QSPI_FS_Work is the last commit once the record is written.
+ *
+ * @return QSPI_FS_OK, QSPI_FS_NOSPC or QSPI_FS_ERROR.
+ */
+static int QSPI_FS_Commit(void)
+{
+    QSPI_FS_RecordTypeDef record = {.Magic = QSPI_FS_MAGIC, .Sequence = QSPI_FS_Sequence + 1};
+    int32_t               meta   = QSPI_FS_Alloc(QSPI_FS_Work.Used);
+    int                   ret;
+
+    if (meta < 0)
+    {
+        return meta;
+    }
+    if (QSPI_FS_MetaBlock != QSPI_FS_NONE)
+    {
+        QSPI_FS_CLR(QSPI_FS_Work.Used, QSPI_FS_MetaBlock);
+    }
+
+    QSPI_FS_Work.Magic    = QSPI_FS_META_MAGIC;
+    QSPI_FS_Work.Sequence = record.Sequence;
+    QSPI_FS_Work.Blocks   = QSPI_FS_BLOCKS;
+    QSPI_FS_Work.Crc      = Dfu_crc32(0, (const uint8_t *)&QSPI_FS_Work.Blocks,
+                                 sizeof(QSPI_FS_Work) - offsetof(QSPI_FS_MetaTypeDef, Blocks));
+    ret = QSPI_FS_WriteAt(QSPI_FS_ADDR(meta), &QSPI_FS_Work, sizeof(QSPI_FS_Work));
+    if (ret != QSPI_FS_OK)
+    {
+        return ret;
+    }
+
+    // Ring block full: the next one holds older records, erase it.
+    if (QSPI_FS_SuperPos == QSPI_FS_RECORDS)
+    {
+        uint32_t next = (QSPI_FS_Super + 1) % QSPI_FS_SUPER_BLOCKS;
+
+        QSPI_FS_Stat.Erase++;
+        if (Bsp_Qspi_Erase(QSPI_FS_ADDR(next), QSPI_FS_BLOCK) != QSPI_OK)
+        {
+            return QSPI_FS_ERROR;
+        }
+        QSPI_FS_Super    = next;
+        QSPI_FS_SuperPos = 0;
+    }
+
+    record.Meta   = meta;
+    record.Cursor = QSPI_FS_Cursor;
+    record.Crc    = Dfu_crc32(0, (const uint8_t *)&record, offsetof(QSPI_FS_RecordTypeDef, Crc));
+    ret           = QSPI_FS_WriteAt(QSPI_FS_ADDR(QSPI_FS_Super) +
+                              QSPI_FS_SuperPos * QSPI_FS_RECORD_SIZE,
+                          &record, sizeof(record));
+    QSPI_FS_SuperPos++; // The slot isn't blank anymore, even if the write failed
+    if (ret != QSPI_FS_OK)
+    {
+        return ret;
+    }
+
+    memcpy(&QSPI_FS_Meta, &QSPI_FS_Work, sizeof(QSPI_FS_Meta));
+    QSPI_FS_MetaBlock = meta;
+    QSPI_FS_Sequence  = record.Sequence;
+    QSPI_FS_Stat.Commit++;
+    QSPI_FS_Count();
+    return QSPI_FS_OK;
+}
+
+static uint8_t QSPI_FS_Valid(const QSPI_FS_RecordTypeDef *record)
+{
+    return (record->Magic == QSPI_FS_MAGIC) &&
+           (record->Crc == Dfu_crc32(0, (const uint8_t *)record, offsetof(QSPI_FS_RecordTypeDef, Crc))) &&
+           (record->Meta >= QSPI_FS_SUPER_BLOCKS) && (record->Meta < QSPI_FS_BLOCKS) &&
+           (record->Cursor >= QSPI_FS_SUPER_BLOCKS) && (record->Cursor < QSPI_FS_BLOCKS);
+}
+
+/*!@brief Find the newest valid record of a ring block below a sequence.
+ *
+ * @param ring  : Ring block.
+ * @param below : Sequence the record is older than.
+ * @param found : Record found.
+ * @param pos   : Slot after the last one written, valid or not.
+ * @return QSPI_FS_OK, QSPI_FS_NOFS if none or QSPI_FS_ERROR.
+ */
+static int QSPI_FS_Scan(uint32_t ring, uint32_t below, QSPI_FS_RecordTypeDef *found,
+                        uint32_t *pos)
+{
+    uint8_t have = 0;
+
+    *pos = 0;
+    for (uint32_t offset = 0; offset < QSPI_FS_BLOCK; offset += QSPI_FS_CHUNK)
+    {
+        if (QSPI_FS_ReadAt(QSPI_FS_ADDR(ring) + offset, QSPI_FS_Buffer, QSPI_FS_CHUNK) !=
+            QSPI_FS_OK)
+        {
+            return QSPI_FS_ERROR;
+        }
+
+        for (uint32_t i = 0; i < QSPI_FS_CHUNK; i += QSPI_FS_RECORD_SIZE)
+        {
+            QSPI_FS_RecordTypeDef *record = (QSPI_FS_RecordTypeDef *)&QSPI_FS_Buffer[i];
+            uint32_t               k;
+
+            for (k = 0; (k < QSPI_FS_RECORD_SIZE) && (QSPI_FS_Buffer[i + k] == 0xFF); k++)
+            {
+            }
+            if (k < QSPI_FS_RECORD_SIZE)
+            {
+                *pos = (offset + i) / QSPI_FS_RECORD_SIZE + 1;
+            }
+
+            if (QSPI_FS_Valid(record) && (record->Sequence < below) &&
+                (!have || (record->Sequence > found->Sequence)))
+            {
+                *found = *record;
+                have   = 1;
+            }
+        }
+    }
+    return have ? QSPI_FS_OK : QSPI_FS_NOFS;
+}
+
+/*!@brief Load the metadata block of a record into QSPI_FS_Meta.
+ */
+static int QSPI_FS_Load(const QSPI_FS_RecordTypeDef *record)
+{
+    QSPI_FS_MetaTypeDef *meta = &QSPI_FS_Work;
+
+    if (QSPI_FS_ReadAt(QSPI_FS_ADDR(record->Meta), meta, sizeof(*meta)) != QSPI_FS_OK)
+    {
+        return QSPI_FS_ERROR;
+    }
+    if ((meta->Magic != QSPI_FS_META_MAGIC) || (meta->Sequence != record->Sequence) ||
+        (meta->Blocks != QSPI_FS_BLOCKS) ||
+        (meta->Crc != Dfu_crc32(0, (const uint8_t *)&meta->Blocks,
+                                sizeof(*meta) - offsetof(QSPI_FS_MetaTypeDef, Blocks))))
+    {
+        return QSPI_FS_NOFS;
+    }
+
+    for (uint32_t i = 0; i < QSPI_FS_FILES; i++)
+    {
+        meta->File[i].Name[QSPI_FS_NAME_MAX] = 0;
+    }
+    memcpy(&QSPI_FS_Meta, meta, sizeof(QSPI_FS_Meta));
+    return QSPI_FS_OK;
+}
+
+/*!@brief Reset the state of open files and of the writer.
+ */
+static void QSPI_FS_Reset(void)
+{
+    memset(QSPI_FS_Users, 0, sizeof(QSPI_FS_Users));
+    memset(QSPI_FS_New, 0, sizeof(QSPI_FS_New));
+    memset(QSPI_FS_Drop, 0, sizeof(QSPI_FS_Drop));
+    QSPI_FS_Tail     = QSPI_FS_NONE;
+    QSPI_FS_Dirty    = 0;
+    QSPI_FS_MapDirty = 0;
+    memset(&QSPI_FS_Stat, 0, sizeof(QSPI_FS_Stat));
+}
+
+/*!@brief Mount the file system: read the first record of each ring block, the records of the
+ *        newest ring block and the metadata block of the newest record.
+ *
+ * @return QSPI_FS_OK, QSPI_FS_NOFS if the area isn't formatted, or QSPI_FS_ERROR.
+ */
+int QSPI_FS_Mount(void)
+{
+    QSPI_FS_RecordTypeDef record;
+    uint32_t              tick  = HAL_GetTick();
+    uint32_t              below = UINT32_MAX;
+    uint32_t              seq   = 0;
+    uint32_t              pos;
+    int                   ring = -1;
+    int                   ret;
+
+    QSPI_FS_Ready = 0;
+    QSPI_FS_Reset();
+
+    for (uint32_t r = 0; r < QSPI_FS_SUPER_BLOCKS; r++)
+    {
+        if (QSPI_FS_ReadAt(QSPI_FS_ADDR(r), &record, sizeof(record)) != QSPI_FS_OK)
+        {
+            return QSPI_FS_ERROR;
+        }
+        if (QSPI_FS_Valid(&record) && ((ring < 0) || (record.Sequence > seq)))
+        {
+            ring = r;
+            seq  = record.Sequence;
+        }
+    }
+    if (ring < 0)
+    {
+        return QSPI_FS_NOFS;
+    }
+
+    // Metadata of the newest record is written before it, fall back on older ones anyway.
+    do
+    {
+        ret = QSPI_FS_Scan(ring, below, &record, &pos);
+        if (ret != QSPI_FS_OK)
+        {
+            return ret;
+        }
+        ret   = QSPI_FS_Load(&record);
+        below = record.Sequence;
+    } while (ret == QSPI_FS_NOFS);
+
+    if (ret != QSPI_FS_OK)
+    {
+        return ret;
+    }
+
+    QSPI_FS_MetaBlock = record.Meta;
+    QSPI_FS_Cursor    = record.Cursor;
+    QSPI_FS_Sequence  = record.Sequence;
+    QSPI_FS_Super     = ring;
+    QSPI_FS_SuperPos  = pos;
+    QSPI_FS_Count();
+    QSPI_FS_Stat.Mount = HAL_GetTick() - tick;
+    QSPI_FS_Ready      = 1;
+    return QSPI_FS_OK;
+}
+
+/*!@brief Unmount, files must be closed first.
+ */
+int QSPI_FS_Unmount(void)
+{
+    for (uint32_t i = 0; i < QSPI_FS_FILES; i++)
+    {
+        if (QSPI_FS_Users[i])
+        {
+            return QSPI_FS_BUSY;
+        }
+    }
+    QSPI_FS_Ready = 0;
+    return QSPI_FS_OK;
+}
+
+/*!@brief Erase the superblock ring and commit an empty directory, then mounted.
+ *        Open files are lost.
+ */
+int QSPI_FS_Format(void)
+{
+    int ret;
+
+    QSPI_FS_Ready = 0;
+    QSPI_FS_Reset();
+    QSPI_FS_Stat.Erase = QSPI_FS_SUPER_BLOCKS;
+    if (Bsp_Qspi_Erase(QSPI_FS_ADDR(0), QSPI_FS_SUPER_BLOCKS * QSPI_FS_BLOCK) != QSPI_OK)
+    {
+        return QSPI_FS_ERROR;
+    }
+
+    memset(&QSPI_FS_Work, 0, sizeof(QSPI_FS_Work));
+    for (uint32_t i = 0; i < QSPI_FS_FILES; i++)
+    {
+        QSPI_FS_Work.File[i].Index = QSPI_FS_NONE;
+    }
+    for (uint32_t r = 0; r < QSPI_FS_SUPER_BLOCKS; r++)
+    {
+        QSPI_FS_SET(QSPI_FS_Work.Used, r);
+    }
+    memcpy(&QSPI_FS_Meta, &QSPI_FS_Work, sizeof(QSPI_FS_Meta));
+    QSPI_FS_MetaBlock = QSPI_FS_NONE;
+    QSPI_FS_Cursor    = QSPI_FS_BLOCKS - 1;
+    QSPI_FS_Sequence  = 0;
+    QSPI_FS_Super     = 0;
+    QSPI_FS_SuperPos  = 0;
+
+    ret = QSPI_FS_Commit();
+    if (ret == QSPI_FS_OK)
+    {
+        QSPI_FS_Ready = 1;
+    }
+    return ret;
+}
+
+int QSPI_FS_Mounted(void)
+{
+    return QSPI_FS_Ready;
+}
+
+/*!@brief Directory entry of a name, the file open for writing by its pending name.
+ *
+ * @return Entry, -1 if not found.
+ */
+static int QSPI_FS_Find(const char *name)
+{
+    for (uint32_t i = 0; i < QSPI_FS_FILES; i++)
+    {
+        const char *entry = (QSPI_FS_Users[i] == QSPI_FS_WRITER) ? QSPI_FS_Name
+                                                                : QSPI_FS_Meta.File[i].Name;
+        if ((entry[0] != 0) && (strcmp(entry, name) == 0))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*!@brief Block of a file at a block offset.
+ *
+ * @return Block number, or QSPI_FS_ERROR.
+ */
+static int32_t QSPI_FS_Block(QSPI_FS_FileTypeDef *file, uint32_t k)
+{
+    uint16_t block = file->Index;
+
+    if (file->Mode & QSPI_FS_WRITE)
+    {
+        return QSPI_FS_Map[k];
+    }
+    if ((file->Size > QSPI_FS_BLOCK) &&
+        (Bsp_Qspi_Read((uint8_t *)&block, QSPI_FS_ADDR(file->Index) + k * 2, 2) != QSPI_OK))
+    {
+        return QSPI_FS_ERROR;
+    }
+    return (block < QSPI_FS_BLOCKS) ? block : QSPI_FS_ERROR;
+}
+
+/*!@brief Open a file.
+ *
+ * @param file  : Handle.
+ * @param name  : 1 ~ QSPI_FS_NAME_MAX characters.
+ * @param mode  : QSPI_FS_READ or QSPI_FS_WRITE, with QSPI_FS_CREATE, QSPI_FS_TRUNC and
+ *                QSPI_FS_APPEND for writing.
+ * @return QSPI_FS_OK, or QSPI_FS_NOENT, QSPI_FS_BUSY, QSPI_FS_NOSPC for a new file...
+ */
+int QSPI_FS_Open(QSPI_FS_FileTypeDef *file, const char *name, uint8_t mode)
+{
+    uint32_t len  = name ? strlen(name) : 0;
+    int      slot = -1;
+
+    if (!QSPI_FS_Ready)
+    {
+        return QSPI_FS_NOFS;
+    }
+    if ((file == NULL) || (len == 0) || (len > QSPI_FS_NAME_MAX) ||
+        !(mode & (QSPI_FS_READ | QSPI_FS_WRITE)))
+    {
+        return QSPI_FS_INVAL;
+    }
+
+    file->Mode = 0;
+    slot       = QSPI_FS_Find(name);
+
+    if (!(mode & QSPI_FS_WRITE))
+    {
+        if (slot < 0)
+        {
+            return QSPI_FS_NOENT;
+        }
+        if (QSPI_FS_Users[slot] >= QSPI_FS_READERS)
+        {
+            return QSPI_FS_BUSY;
+        }
+        QSPI_FS_Users[slot]++;
+        file->Size  = QSPI_FS_Meta.File[slot].Size;
+        file->Index = QSPI_FS_Meta.File[slot].Index;
+    }
+    else
+    {
+        for (uint32_t i = 0; i < QSPI_FS_FILES; i++)
+        {
+            if (QSPI_FS_Users[i] == QSPI_FS_WRITER)
+            {
+                return QSPI_FS_BUSY;
+            }
+        }
+
+        if (slot >= 0)
+        {
+            uint32_t n = QSPI_FS_COUNT(QSPI_FS_Meta.File[slot].Size);
+
+            if (QSPI_FS_Users[slot])
+            {
+                return QSPI_FS_BUSY;
+            }
+            if ((n > 1) && (QSPI_FS_ReadAt(QSPI_FS_ADDR(QSPI_FS_Meta.File[slot].Index),
+                                           QSPI_FS_Map, n * 2) != QSPI_FS_OK))
+            {
+                return QSPI_FS_ERROR;
+            }
+            if (n == 1)
+            {
+                QSPI_FS_Map[0] = QSPI_FS_Meta.File[slot].Index;
+            }
+            file->Size    = QSPI_FS_Meta.File[slot].Size;
+            QSPI_FS_Dirty  = 0;
+        }
+        else
+        {
+            if (!(mode & QSPI_FS_CREATE))
+            {
+                return QSPI_FS_NOENT;
+            }
+            for (slot = 0; slot < QSPI_FS_FILES; slot++)
+            {
+                if ((QSPI_FS_Meta.File[slot].Name[0] == 0) && (QSPI_FS_Users[slot] == 0))
+                {
+                    break;
+                }
+            }
+            if (slot == QSPI_FS_FILES)
+            {
+                return QSPI_FS_NOSPC;
+            }
+            file->Size    = 0;
+            QSPI_FS_Dirty = 1;
+        }
+
+        if (mode & QSPI_FS_TRUNC)
+        {
+            for (uint32_t k = 0; k < QSPI_FS_COUNT(file->Size); k++)
+            {
+                QSPI_FS_Release(QSPI_FS_Map[k]);
+            }
+            file->Size    = 0;
+            QSPI_FS_Dirty = 1;
+        }
+
+        strcpy(QSPI_FS_Name, name);
+        QSPI_FS_Users[slot] = QSPI_FS_WRITER;
+        QSPI_FS_Tail       = QSPI_FS_NONE;
+        QSPI_FS_MapDirty   = QSPI_FS_Dirty;
+        file->Index        = QSPI_FS_NONE;
+    }
+
+    file->Slot = slot;
+    file->Pos  = 0;
+    file->Mode = mode;
+    return QSPI_FS_OK;
+}
+
+/*!@brief Read from the position.
+ *
+ * @return Bytes read, less than size at end of file, or QSPI_FS_INVAL / QSPI_FS_ERROR.
+ */
+int32_t QSPI_FS_Read(QSPI_FS_FileTypeDef *file, void *data, uint32_t size)
+{
+    uint8_t *dst  = data;
+    uint32_t done = 0;
+
+    if ((file == NULL) || !file->Mode)
+    {
+        return QSPI_FS_INVAL;
+    }
+    if (size > file->Size - file->Pos)
+    {
+        size = file->Size - file->Pos;
+    }
+
+    while (done < size)
+    {
+        uint32_t k   = file->Pos / QSPI_FS_BLOCK;
+        uint32_t off = file->Pos % QSPI_FS_BLOCK;
+        uint32_t len = (size - done < QSPI_FS_BLOCK - off) ? size - done : QSPI_FS_BLOCK - off;
+        int32_t  block = QSPI_FS_Block(file, k);
+
+        if ((block < 0) ||
+            (Bsp_Qspi_Read(dst + done, QSPI_FS_ADDR(block) + off, len) != QSPI_OK))
+        {
+            return QSPI_FS_ERROR;
+        }
+        file->Pos += len;
+        done += len;
+    }
+    return done;
+}
+
+/*!@brief Copy bytes of a block to the same place of a new one.
+ */
+static int QSPI_FS_Copy(uint32_t from, uint32_t to, uint32_t start, uint32_t end)
+{
+    for (uint32_t off = start; off < end; off += QSPI_FS_CHUNK)
+    {
+        uint32_t len = (end - off < QSPI_FS_CHUNK) ? end - off : QSPI_FS_CHUNK;
+
+        if ((QSPI_FS_ReadAt(QSPI_FS_ADDR(from) + off, QSPI_FS_Buffer, len) != QSPI_FS_OK) ||
+            (QSPI_FS_WriteAt(QSPI_FS_ADDR(to) + off, QSPI_FS_Buffer, len) != QSPI_FS_OK))
+        {
+            return QSPI_FS_ERROR;
+        }
+        QSPI_FS_Stat.Copy += len;
+    }
+    return QSPI_FS_OK;
+}
+
+/*!@brief Take the last block of the file as the tail block, for an append at the end of a
+ *        committed file to program it in place. Writes dropped by a reset may have
+ *        programmed the end of the block, it must read erased.
+ *
+ * @param k     : File block.
+ * @param off   : Offset of the append in the block.
+ * @return 1 if the block is the tail block.
+ */
+static uint8_t QSPI_FS_Adopt(QSPI_FS_FileTypeDef *file, uint32_t k, uint32_t off)
+{
+    if ((file->Size != k * QSPI_FS_BLOCK + off) || (off == 0))
+    {
+        return 0;
+    }
+
+    for (uint32_t pos = off; pos < QSPI_FS_BLOCK; pos += QSPI_FS_CHUNK)
+    {
+        uint32_t len = (QSPI_FS_BLOCK - pos < QSPI_FS_CHUNK) ? QSPI_FS_BLOCK - pos : QSPI_FS_CHUNK;
+
+        if (QSPI_FS_ReadAt(QSPI_FS_ADDR(QSPI_FS_Map[k]) + pos, QSPI_FS_Buffer, len) != QSPI_FS_OK)
+        {
+            return 0;
+        }
+        for (uint32_t i = 0; i < len; i++)
+        {
+            if (QSPI_FS_Buffer[i] != 0xFF)
+            {
+                return 0;
+            }
+        }
+    }
+
+    QSPI_FS_Tail = k;
+    QSPI_FS_Fill = off;
+    return 1;
+}
+
+/*!@brief Move a file block of the writer to a new block, but the bytes about to be written.
+ *
+ * @param k     : File block.
+ * @param start : First byte to be written.
+ * @param end   : Byte after the last one to be written.
+ */
+static int QSPI_FS_Replace(QSPI_FS_FileTypeDef *file, uint32_t k, uint32_t start, uint32_t end)
+{
+    uint32_t valid = 0;
+    int32_t  block = QSPI_FS_Alloc(QSPI_FS_New);
+    int      ret   = QSPI_FS_OK;
+
+    if (block < 0)
+    {
+        return block;
+    }
+
+    if (file->Size > k * QSPI_FS_BLOCK)
+    {
+        valid = file->Size - k * QSPI_FS_BLOCK;
+        valid = (valid < QSPI_FS_BLOCK) ? valid : QSPI_FS_BLOCK;
+        ret   = QSPI_FS_Copy(QSPI_FS_Map[k], block, 0, start);
+        if ((ret == QSPI_FS_OK) && (end < valid))
+        {
+            ret = QSPI_FS_Copy(QSPI_FS_Map[k], block, end, valid);
+        }
+        if (ret != QSPI_FS_OK)
+        {
+            QSPI_FS_CLR(QSPI_FS_New, block);
+            return ret;
+        }
+        QSPI_FS_Release(QSPI_FS_Map[k]);
+    }
+
+    QSPI_FS_Map[k]   = block;
+    QSPI_FS_Tail     = k;
+    QSPI_FS_Fill     = (end < valid) ? valid : end;
+    QSPI_FS_MapDirty = 1;
+    return QSPI_FS_OK;
+}
+
+/*!@brief Write at the position, or at the end of file in QSPI_FS_APPEND mode. Data is in
+ *        the file once committed by QSPI_FS_Sync() / QSPI_FS_Close().
+ *
+ * @return Bytes written, less than size if the area or the file is full, or a status if
+ *         none is.
+ */
+int32_t QSPI_FS_Write(QSPI_FS_FileTypeDef *file, const void *data, uint32_t size)
+{
+    const uint8_t *src  = data;
+    uint32_t       done = 0;
+    int            ret  = QSPI_FS_OK;
+
+    if ((file == NULL) || !(file->Mode & QSPI_FS_WRITE))
+    {
+        return QSPI_FS_INVAL;
+    }
+    if (file->Mode & QSPI_FS_APPEND)
+    {
+        file->Pos = file->Size;
+    }
+
+    while ((done < size) && (ret == QSPI_FS_OK))
+    {
+        uint32_t k   = file->Pos / QSPI_FS_BLOCK;
+        uint32_t off = file->Pos % QSPI_FS_BLOCK;
+        uint32_t len = (size - done < QSPI_FS_BLOCK - off) ? size - done : QSPI_FS_BLOCK - off;
+
+        if (k >= QSPI_FS_FILE_BLOCKS)
+        {
+            ret = QSPI_FS_NOSPC;
+            break;
+        }
+
+        // Program the erased end of the tail block in place, move the block otherwise.
+        if (((k != QSPI_FS_Tail) && !QSPI_FS_Adopt(file, k, off)) || (off < QSPI_FS_Fill))
+        {
+            ret = QSPI_FS_Replace(file, k, off, off + len);
+        }
+        if (ret == QSPI_FS_OK)
+        {
+            ret = QSPI_FS_WriteAt(QSPI_FS_ADDR(QSPI_FS_Map[k]) + off, src + done, len);
+        }
+        if (ret == QSPI_FS_OK)
+        {
+            QSPI_FS_Fill  = (off + len > QSPI_FS_Fill) ? off + len : QSPI_FS_Fill;
+            QSPI_FS_Dirty = 1;
+            file->Pos += len;
+            file->Size = (file->Pos > file->Size) ? file->Pos : file->Size;
+            done += len;
+        }
+    }
+
+    return done ? (int32_t)done : ret;
+}
+
+/*!@brief Move the position, within the file.
+ *
+ * @return New position, or QSPI_FS_INVAL.
+ */
+int32_t QSPI_FS_Seek(QSPI_FS_FileTypeDef *file, int32_t offset, uint8_t whence)
+{
+    int64_t pos;
+
+    if ((file == NULL) || !file->Mode)
+    {
+        return QSPI_FS_INVAL;
+    }
+
+    switch (whence)
+    {
+    case QSPI_FS_SEEK_SET:
+        pos = offset;
+        break;
+    case QSPI_FS_SEEK_CUR:
+        pos = (int64_t)file->Pos + offset;
+        break;
+    case QSPI_FS_SEEK_END:
+        pos = (int64_t)file->Size + offset;
+        break;
+    default:
+        return QSPI_FS_INVAL;
+    }
+
+    if ((pos < 0) || (pos > file->Size))
+    {
+        return QSPI_FS_INVAL;
+    }
+    file->Pos = pos;
+    return file->Pos;
+}
+
+/*!@brief Commit the writes to a file: index block if changed, metadata and superblock record.
+ *        Nothing to do for a file open for reading.
+ */
+int QSPI_FS_Sync(QSPI_FS_FileTypeDef *file)
+{
+    QSPI_FS_EntryTypeDef *old;
+    QSPI_FS_EntryTypeDef *entry;
+    uint32_t              n;
+    int                   ret;
+
+    if ((file == NULL) || !file->Mode)
+    {
+        return QSPI_FS_INVAL;
+    }
+    if (!(file->Mode & QSPI_FS_WRITE) || !QSPI_FS_Dirty)
+    {
+        return QSPI_FS_OK;
+    }
+
+    old   = &QSPI_FS_Meta.File[file->Slot];
+    entry = &QSPI_FS_Work.File[file->Slot];
+    n     = QSPI_FS_COUNT(file->Size);
+    memcpy(&QSPI_FS_Work, &QSPI_FS_Meta, sizeof(QSPI_FS_Work));
+    for (uint32_t i = 0; i < sizeof(QSPI_FS_New); i++)
+    {
+        QSPI_FS_Work.Used[i] = (QSPI_FS_Work.Used[i] | QSPI_FS_New[i]) & ~QSPI_FS_Drop[i];
+    }
+
+    strcpy(entry->Name, QSPI_FS_Name);
+    entry->Size  = file->Size;
+    entry->Index = (n == 1) ? QSPI_FS_Map[0] : QSPI_FS_NONE;
+    if ((n > 1) && !QSPI_FS_MapDirty)
+    {
+        entry->Index = old->Index;
+    }
+    else if (n > 1)
+    {
+        int32_t index = QSPI_FS_Alloc(QSPI_FS_Work.Used);
+
+        if (index < 0)
+        {
+            return index;
+        }
+        ret = QSPI_FS_WriteAt(QSPI_FS_ADDR(index), QSPI_FS_Map, n * 2);
+        if (ret != QSPI_FS_OK)
+        {
+            return ret;
+        }
+        entry->Index = index;
+    }
+    if ((old->Size > QSPI_FS_BLOCK) && (old->Index != entry->Index))
+    {
+        QSPI_FS_CLR(QSPI_FS_Work.Used, old->Index);
+    }
+
+    ret = QSPI_FS_Commit();
+    if (ret == QSPI_FS_OK)
+    {
+        memset(QSPI_FS_New, 0, sizeof(QSPI_FS_New));
+        memset(QSPI_FS_Drop, 0, sizeof(QSPI_FS_Drop));
+        QSPI_FS_Dirty    = 0;
+        QSPI_FS_MapDirty = 0;
+    }
+    return ret;
+}
+
+/*!@brief Close a file, committing its writes. Writes not committed, on error, are dropped.
+ */
+int QSPI_FS_Close(QSPI_FS_FileTypeDef *file)
+{
+    int ret = QSPI_FS_Sync(file);
+
+    if (ret == QSPI_FS_INVAL)
+    {
+        return ret;
+    }
+
+    if (file->Mode & QSPI_FS_WRITE)
+    {
+        memset(QSPI_FS_New, 0, sizeof(QSPI_FS_New));
+        memset(QSPI_FS_Drop, 0, sizeof(QSPI_FS_Drop));
+        QSPI_FS_Users[file->Slot] = 0;
+        QSPI_FS_Tail             = QSPI_FS_NONE;
+        QSPI_FS_Dirty            = 0;
+    }
+    else
+    {
+        QSPI_FS_Users[file->Slot]--;
+    }
+    file->Mode = 0;
+    return ret;
+}
+
+/*!@brief Remove a file, committed at once.
+ */
+int QSPI_FS_Remove(const char *name)
+{
+    QSPI_FS_EntryTypeDef *entry;
+    uint32_t              n;
+    int                   slot;
+
+    if (!QSPI_FS_Ready)
+    {
+        return QSPI_FS_NOFS;
+    }
+    slot = name ? QSPI_FS_Find(name) : -1;
+    if (slot < 0)
+    {
+        return QSPI_FS_NOENT;
+    }
+    if (QSPI_FS_Users[slot])
+    {
+        return QSPI_FS_BUSY;
+    }
+
+    entry = &QSPI_FS_Meta.File[slot];
+    n     = QSPI_FS_COUNT(entry->Size);
+    memcpy(&QSPI_FS_Work, &QSPI_FS_Meta, sizeof(QSPI_FS_Work));
+
+    if (n == 1)
+    {
+        QSPI_FS_CLR(QSPI_FS_Work.Used, entry->Index);
+    }
+    else if (n > 1)
+    {
+        uint16_t *blocks = (uint16_t *)QSPI_FS_Buffer;
+
+        for (uint32_t k = 0; k < n; k += QSPI_FS_CHUNK / 2)
+        {
+            uint32_t count = (n - k < QSPI_FS_CHUNK / 2) ? n - k : QSPI_FS_CHUNK / 2;
+
+            if (QSPI_FS_ReadAt(QSPI_FS_ADDR(entry->Index) + k * 2, blocks, count * 2) !=
+                QSPI_FS_OK)
+            {
+                return QSPI_FS_ERROR;
+            }
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (blocks[i] < QSPI_FS_BLOCKS)
+                {
+                    QSPI_FS_CLR(QSPI_FS_Work.Used, blocks[i]);
+                }
+            }
+        }
+        QSPI_FS_CLR(QSPI_FS_Work.Used, entry->Index);
+    }
+
+    memset(&QSPI_FS_Work.File[slot], 0, sizeof(QSPI_FS_Work.File[slot]));
+    QSPI_FS_Work.File[slot].Index = QSPI_FS_NONE;
+    return QSPI_FS_Commit();
+}
+
+/*!@brief List the directory, files committed.
+ *
+ * @param pos   : Position in the directory, 0 to start.
+ * @param info  : Name and size of the next file.
+ * @return QSPI_FS_OK, or QSPI_FS_NOENT past the last file.
+ */
+int QSPI_FS_Dir(uint32_t *pos, QSPI_FS_InfoTypeDef *info)
+{
+    while (QSPI_FS_Ready && (*pos < QSPI_FS_FILES))
+    {
+        QSPI_FS_EntryTypeDef *entry = &QSPI_FS_Meta.File[(*pos)++];
+
+        if (entry->Name[0] != 0)
+        {
+            strcpy(info->Name, entry->Name);
+            info->Size = entry->Size;
+            return QSPI_FS_OK;
+        }
+    }
+    return QSPI_FS_NOENT;
+}
@@ -0,0 +1,115 @@
+/******************************************************************************
+ * @file    bsp_qspi_fs.h
+ * @brief   Power-safe flat file system on the N25Q128A QSPI flash, copy-on-write.
+ *
+ *          Files are written to newly erased blocks, never over the data of the last
+ *          commit. QSPI_FS_Sync() / QSPI_FS_Close() / QSPI_FS_Remove() commit: a new
+ *          metadata block (used block bitmap and directory) is written, then a superblock
+ *          record pointing at it. A power loss before the record is complete leaves the
+ *          file system as of the previous commit, so a file is all or nothing per sync.
+ *
+ *          Mount reads the superblock records and the metadata block, nothing else.
+ *
+ *          Wear leveling: blocks are allocated in turn from a cursor saved in the
+ *          superblock, over the whole area. Superblock records are appended to a ring of
+ *          QSPI_FS_SUPER_BLOCKS blocks, each erased once per 128 x QSPI_FS_SUPER_BLOCKS
+ *          commits. Static data isn't moved, the more of the area cold files hold, the
+ *          faster the rest wears.
+ *
+ *          One file is open for writing at a time, a file is open either for writing or
+ *          for reading. Seek is limited to the file size, files have no holes.
+ *          Functions are called from one task at a time.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef INC_BSP_BSP_QSPI_FS_H_
+#define INC_BSP_BSP_QSPI_FS_H_
+
+#include "stdint.h"
+
+// clang-format off
+#define QSPI_FS_BASE            0x00000000  //!< File system area, QSPI flash up to the KV store
+#define QSPI_FS_SIZE            0x00F00000
+#define QSPI_FS_BLOCK           0x1000      //!< Allocation and erase unit, N25Q128A subsector
+#define QSPI_FS_BLOCKS          (QSPI_FS_SIZE / QSPI_FS_BLOCK)
+#define QSPI_FS_SUPER_BLOCKS    8           //!< First blocks of the area, ring of superblock records
+#define QSPI_FS_FILES           32          //!< Directory entries
+#define QSPI_FS_NAME_MAX        23          //!< Characters of a file name
+#ifndef QSPI_FS_FILE_BLOCKS
+#define QSPI_FS_FILE_BLOCKS     1024        //!< Blocks of a file, 2 bytes of RAM each
+#endif
+
+/*!@defgroup QSPI_FS_MODE Open mode, or-ed.
+ */
+#define QSPI_FS_READ            0x01
+#define QSPI_FS_WRITE           0x02        //!< Read and write
+#define QSPI_FS_CREATE          0x04        //!< Create the file if missing
+#define QSPI_FS_TRUNC           0x08        //!< Start from an empty file
+#define QSPI_FS_APPEND          0x10        //!< Write at the end of file
+
+/*!@defgroup QSPI_FS_SEEK Seek origin.
+ */
+#define QSPI_FS_SEEK_SET        0
+#define QSPI_FS_SEEK_CUR        1
+#define QSPI_FS_SEEK_END        2
+
+/*!@defgroup QSPI_FS_STATUS Return status, negative.
+ */
+#define QSPI_FS_OK              0
+#define QSPI_FS_ERROR           -1          //!< Device read / write failed
+#define QSPI_FS_NOENT           -2          //!< No such file
+#define QSPI_FS_NOSPC           -3          //!< Area, directory or file size full
+#define QSPI_FS_INVAL           -4          //!< Bad name, mode or handle
+#define QSPI_FS_BUSY            -5          //!< File open, or another file open for writing
+#define QSPI_FS_NOFS            -6          //!< No valid superblock, area to format
+// clang-format on
+
+#if (QSPI_FS_FILE_BLOCKS * 2 > QSPI_FS_BLOCK)
+#error "QSPI_FS_FILE_BLOCKS exceeds the entries of an index block"
+#endif
+
+/*!@struct QSPI_FS_FileTypeDef
+ *          Open file, owned by the caller.
+ */
+typedef struct {
+    uint32_t Pos;   //!> Read / write position
+    uint32_t Size;  //!> File size, uncommitted writes included
+    uint16_t Index; //!> Data block of a 1 block file, index block of a larger one
+    uint8_t  Slot;  //!> Directory entry
+    uint8_t  Mode;  //!> QSPI_FS_MODE, 0 when closed
+} QSPI_FS_FileTypeDef;
+
+typedef struct {
+    char     Name[QSPI_FS_NAME_MAX + 1];
+    uint32_t Size;
+} QSPI_FS_InfoTypeDef;
+
+typedef struct {
+    uint32_t Mount;    //!> Mount time in ms
+    uint32_t Sequence; //!> Sequence of the last commit
+    uint32_t Files;    //!> Files in the directory
+    uint32_t Used;     //!> Blocks used by files, metadata and superblocks
+    uint32_t Commit;   //!> Commits since mount
+    uint32_t Erase;    //!> Blocks erased since mount
+    uint32_t Copy;     //!> Bytes copied to new blocks by overwrites since mount
+} QSPI_FS_StatTypeDef;
+
+extern QSPI_FS_StatTypeDef QSPI_FS_Stat;
+
+int     QSPI_FS_Mount(void);
+int     QSPI_FS_Unmount(void);
+int     QSPI_FS_Format(void);
+int     QSPI_FS_Open(QSPI_FS_FileTypeDef *file, const char *name, uint8_t mode);
+int32_t QSPI_FS_Read(QSPI_FS_FileTypeDef *file, void *data, uint32_t size);
+int32_t QSPI_FS_Write(QSPI_FS_FileTypeDef *file, const void *data, uint32_t size);
+int32_t QSPI_FS_Seek(QSPI_FS_FileTypeDef *file, int32_t offset, uint8_t whence);
+int     QSPI_FS_Sync(QSPI_FS_FileTypeDef *file);
+int     QSPI_FS_Close(QSPI_FS_FileTypeDef *file);
+int     QSPI_FS_Remove(const char *name);
+int     QSPI_FS_Dir(uint32_t *pos, QSPI_FS_InfoTypeDef *info);
+int     QSPI_FS_Mounted(void);
+
+#endif /* INC_BSP_BSP_QSPI_FS_H_ */
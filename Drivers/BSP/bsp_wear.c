@@ -0,0 +1,252 @@
+/******************************************************************************
+ * @file    bsp_wear.c
+ * @brief   Flash wear and endurance telemetry of EEPROM emulation pages and DFU banks.
+ *
+ *          Erases are counted by the erase callbacks of EEPROM_Emul porting layer and
+ *          of DFU flash interface, programmed double words by EEPROM_Emul uwProgramCount.
+ *          Counters are kept in RAM and saved as one multi-byte NVRAM value, the EEPROM
+ *          emulation writes it as a blob of ~30 elements. DFU erases are pending in RTC
+ *          backup registers, 4 bits a group, and move to the record when it is saved.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include "bsp_wear.h"
+#include "dfu_flash_if.h"
+
+extern RTC_HandleTypeDef hrtc;
+
+static Wear_RecordTypeDef Wear_Record    = {.Magic = WEAR_MAGIC};
+static uint8_t            Wear_Loaded    = 0; //!< Saved counters are loaded
+static uint32_t           Wear_Unsaved   = 0; //!< Erase operations since last save
+static uint32_t           Wear_SaveTick  = 0; //!< Tick of last save
+static uint32_t           Wear_Tick      = 0; //!< Tick OnTime is counted up to
+static uint32_t           Wear_Ms        = 0; //!< OnTime below 1 s, not yet added
+static uint32_t           Wear_Write     = 0; //!< Nvram_CacheStat.Write counted to LogicalWrite
+static uint32_t           Wear_Program   = 0; //!< uwProgramCount counted to PhysicalWrite
+static uint32_t           Wear_EmulErase = 0; //!< EEPROM emulation page erases since reset
+
+/*!@brief EEPROM emulation erases one or several of its pages.
+ */
+void EE_PageErase_UserCallback(uint32_t Page, uint16_t NbPages)
+{
+    for (uint32_t i = 0; i < NbPages; i++)
+    {
+        Wear_Record.EmulErase[(Page + i - START_PAGE) % PAGES_NUMBER]++;
+    }
+    Wear_EmulErase += NbPages;
+    Wear_Unsaved++;
+}
+
+/*!@brief DFU erases pages or a whole bank, each group of the range counts one erase.
+ */
+void Flash_eraseCallback(uint32_t bank, uint32_t start_page, uint32_t num_of_page)
+{
+    uint32_t base = WEAR_BKP_REG + ((bank == FLASH_BANK_2) ? WEAR_GROUPS / 8 : 0);
+
+    for (uint32_t g = start_page / WEAR_GROUP_PAGES;
+         (g <= (start_page + num_of_page - 1) / WEAR_GROUP_PAGES) && (g < WEAR_GROUPS); g++)
+    {
+        uint32_t reg = HAL_RTCEx_BKUPRead(&hrtc, base + g / 8);
+
+        if (((reg >> (4 * (g % 8))) & 0xF) != 0xF)
+        {
+            HAL_RTCEx_BKUPWrite(&hrtc, base + g / 8, reg + (1UL << (4 * (g % 8))));
+        }
+    }
+    Wear_Unsaved++;
+}
+
+/*!@brief Add DFU erases pending in backup registers to a record.
+ *
+ * @return Number of pending erases.
+ */
+static uint32_t Bsp_Wear_Pending(Wear_RecordTypeDef *record)
+{
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < 2 * WEAR_GROUPS; i++)
+    {
+        uint16_t *group = &record->BankErase[i / WEAR_GROUPS][i % WEAR_GROUPS];
+        uint32_t  n     = (HAL_RTCEx_BKUPRead(&hrtc, WEAR_BKP_REG + i / 8) >> (4 * (i % 8))) & 0xF;
+
+        *group = (*group + n < UINT16_MAX) ? *group + n : UINT16_MAX;
+        count += n;
+    }
+
+    return count;
+}
+
+/*!@brief Add powered time and writes since last call to the record.
+ */
+static void Bsp_Wear_Update(void)
+{
+    uint32_t tick = HAL_GetTick();
+
+    Wear_Ms += tick - Wear_Tick;
+    Wear_Tick = tick;
+    Wear_Record.OnTime += Wear_Ms / 1000;
+    Wear_Ms %= 1000;
+
+    // Statistic cleared by user restarts from 0.
+    uint32_t write = Nvram_CacheStat.Write;
+    if (Bsp_Nvram_Device() == NVRAM_DEV_EMUL)
+    {
+        Wear_Record.LogicalWrite += (write >= Wear_Write) ? (write - Wear_Write) : write;
+    }
+    Wear_Write = write;
+
+    Wear_Record.PhysicalWrite += uwProgramCount - Wear_Program;
+    Wear_Program = uwProgramCount;
+}
+
+/*!@brief Load saved counters, call once NVRAM is initialized. Erases done before, e.g. by
+ *        EEPROM emulation format, are added to them. Later calls, and calls before NVRAM
+ *        is initialized, do nothing.
+ */
+void Bsp_Wear_Init()
+{
+    Wear_RecordTypeDef saved = {0};
+
+    if (Wear_Loaded || !Bsp_Nvram_IsInit())
+    {
+        return;
+    }
+    Wear_Loaded = 1;
+
+    // OnTime counts from reset.
+    Bsp_Wear_Update();
+
+    if ((Nvram_Drv.ReadEx(NVRAM_EX_WEAR, (uint8_t *)&saved, sizeof(saved)) == NVRAM_OK) &&
+        (saved.Magic == WEAR_MAGIC))
+    {
+        Wear_Record.OnTime += saved.OnTime;
+        Wear_Record.LogicalWrite += saved.LogicalWrite;
+        Wear_Record.PhysicalWrite += saved.PhysicalWrite;
+        for (uint32_t i = 0; i < PAGES_NUMBER; i++)
+        {
+            Wear_Record.EmulErase[i] += saved.EmulErase[i];
+        }
+        for (uint32_t i = 0; i < WEAR_GROUPS; i++)
+        {
+            Wear_Record.BankErase[0][i] += saved.BankErase[0][i];
+            Wear_Record.BankErase[1][i] += saved.BankErase[1][i];
+        }
+    }
+    Wear_SaveTick = Wear_Tick;
+
+    // DFU erases before this boot are saved on the next task.
+    if (Bsp_Wear_Pending(&saved) != 0)
+    {
+        Wear_Unsaved = WEAR_SAVE_ERASES;
+    }
+}
+
+/*!@brief Write counters to NVRAM now, pending DFU erases are cleared once written.
+ *
+ * @retval NVRAM_BUSY while the device can't take the write, Bsp_Wear_Task() retries.
+ */
+NVRAM_STATUS Bsp_Wear_Save()
+{
+    Wear_RecordTypeDef record;
+
+    if ((Nvram_Drv.WriteEx == NULL) || !Wear_Loaded)
+    {
+        return NVRAM_ERR_IF;
+    }
+
+    Bsp_Wear_Update();
+    record = Wear_Record;
+    Bsp_Wear_Pending(&record);
+
+    NVRAM_STATUS ret = Nvram_Drv.WriteEx(NVRAM_EX_WEAR, (uint8_t *)&record, sizeof(record));
+    if (ret == NVRAM_OK)
+    {
+        Wear_Record = record;
+        for (uint32_t i = 0; i < 2 * WEAR_GROUPS / 8; i++)
+        {
+            HAL_RTCEx_BKUPWrite(&hrtc, WEAR_BKP_REG + i, 0);
+        }
+        Wear_Unsaved  = 0;
+        Wear_SaveTick = HAL_GetTick();
+    }
+
+    return ret;
+}
+
+/*!@brief Periodic task, save counters when their change is worth a write.
+ */
+void Bsp_Wear_Task()
+{
+    uint32_t elapsed = HAL_GetTick() - Wear_SaveTick;
+
+    if ((Wear_Unsaved >= WEAR_SAVE_ERASES) || (Wear_Unsaved && (elapsed >= WEAR_SAVE_MS)) ||
+        (elapsed >= WEAR_SAVE_IDLE_MS))
+    {
+        Bsp_Wear_Save();
+    }
+}
+
+/*!@brief Days until a page erased max times reaches endurance.
+ *
+ * @param max       : Erases of the most worn page.
+ * @param erase     : Erases of all pages in sec.
+ * @param pages     : Pages sharing the erases.
+ * @param sec       : Time of the erases.
+ */
+static uint32_t Bsp_Wear_Life(uint32_t max, uint32_t erase, uint32_t pages, uint32_t sec)
+{
+    if (max >= WEAR_ENDURANCE)
+    {
+        return 0;
+    }
+    if ((erase == 0) || (sec == 0))
+    {
+        return WEAR_LIFE_NONE;
+    }
+
+    uint64_t days = (uint64_t)(WEAR_ENDURANCE - max) * pages * sec / erase / 86400;
+    return (days < WEAR_LIFE_NONE) ? days : WEAR_LIFE_NONE - 1;
+}
+
+/*!@brief Get counters, write amplification and projected lifetime.
+ *        EEPROM emulation pages wear evenly as they rotate, their rate is the one since
+ *        reset if any erase happened, else the average. DFU erases are far apart, their rate
+ *        is the average on OnTime.
+ */
+void Bsp_Wear_Get(Wear_TelemetryTypeDef *tm)
+{
+    uint32_t total = 0;
+
+    Bsp_Wear_Update();
+    tm->Record = Wear_Record;
+    Bsp_Wear_Pending(&tm->Record);
+    if (!Wear_Loaded)
+    {
+        tm->Record.Magic = 0;
+    }
+    tm->EmulMax = 0;
+    tm->BankMax = 0;
+
+    for (uint32_t i = 0; i < PAGES_NUMBER; i++)
+    {
+        total += tm->Record.EmulErase[i];
+        tm->EmulMax = (tm->Record.EmulErase[i] > tm->EmulMax) ? tm->Record.EmulErase[i]
+                                                               : tm->EmulMax;
+    }
+    for (uint32_t i = 0; i < 2 * WEAR_GROUPS; i++)
+    {
+        uint32_t erase = tm->Record.BankErase[i / WEAR_GROUPS][i % WEAR_GROUPS];
+        tm->BankMax    = (erase > tm->BankMax) ? erase : tm->BankMax;
+    }
+
+    tm->WriteAmp = tm->Record.LogicalWrite
+                       ? (uint64_t)tm->Record.PhysicalWrite * 100 / tm->Record.LogicalWrite
+                       : 0;
+    uint32_t erase = Wear_EmulErase ? Wear_EmulErase : total;
+    uint32_t sec   = Wear_EmulErase ? HAL_GetTick() / 1000 : tm->Record.OnTime;
+    tm->EmulLife   = Bsp_Wear_Life(tm->EmulMax, erase, PAGES_NUMBER, sec);
+    tm->BankLife = Bsp_Wear_Life(tm->BankMax, tm->BankMax, 1, tm->Record.OnTime);
+}
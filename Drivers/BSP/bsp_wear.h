@@ -0,0 +1,75 @@
+/******************************************************************************
+ * @file    bsp_wear.h
+ * @brief   Flash wear and endurance telemetry of EEPROM emulation pages and DFU banks.
+ *
+ *          Erases are counted per page for EEPROM emulation, and per group of
+ *          WEAR_GROUP_PAGES pages for each DFU bank. A group counts an erase operation
+ *          once however many of its pages are erased, so it is an upper bound of the
+ *          erases of any page in the group.
+ *
+ *          Write amplification is double words programmed by EEPROM emulation, page
+ *          headers and transfers included, per NVRAM variable write request.
+ *
+ *          Counters are saved to NVRAM register NVRAM_EX_WEAR by Bsp_Wear_Task() after
+ *          WEAR_SAVE_ERASES erases, WEAR_SAVE_MS after an erase, or WEAR_SAVE_IDLE_MS.
+ *          EEPROM emulation erases since the last save are lost on reset. DFU erases
+ *          mostly happen in DFU window, before NVRAM is initialized and followed by a
+ *          reset, so they are pending in RTC backup registers until saved, up to 15 per
+ *          group. They are lost with the backup domain, i.e. power off without VBAT.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef INC_BSP_BSP_WEAR_H_
+#define INC_BSP_BSP_WEAR_H_
+
+#include "bsp_nvram.h"
+#include "stdint.h"
+
+// clang-format off
+#define WEAR_MAGIC              0x31414557  //!< "WEA1", record layout version
+#define WEAR_ENDURANCE          10000       //!< Erase cycles of a flash page, STM32L476 datasheet
+#define WEAR_BANK_PAGES         256         //!< 2K pages of a 512K bank
+#define WEAR_GROUP_PAGES        8           //!< DFU bank pages counted together
+#define WEAR_GROUPS             (WEAR_BANK_PAGES / WEAR_GROUP_PAGES)
+#define WEAR_SAVE_ERASES        8           //!< Save after N erase operations
+#define WEAR_SAVE_MS            3600000     //!< Save N ms after an erase
+#define WEAR_SAVE_IDLE_MS       86400000    //!< Save on time without erase every N ms
+#define WEAR_LIFE_NONE          0xFFFFFFFF  //!< No erase to project lifetime from
+#define WEAR_BKP_REG            RTC_BKP_DR1 //!< First of 8 backup registers of pending DFU erases
+// clang-format on
+
+/*!@struct Wear_RecordTypeDef
+ *          Persisted counters.
+ */
+typedef struct {
+    uint32_t Magic;                      //!> WEAR_MAGIC
+    uint32_t OnTime;                     //!> Powered time in s since the record is created
+    uint32_t LogicalWrite;               //!> Variable writes while EEPROM emulation is selected
+    uint32_t PhysicalWrite;              //!> Double words programmed by EEPROM emulation
+    uint32_t EmulErase[PAGES_NUMBER];    //!> Erases of EEPROM emulation page n
+    uint16_t BankErase[2][WEAR_GROUPS];  //!> Erases of bank 1 / bank 2 page group n
+} Wear_RecordTypeDef;
+
+/*!@struct Wear_TelemetryTypeDef
+ *          Counters with derived figures, sent as is by the DFU WEAR reply.
+ *          Record.Magic is 0 until saved counters are loaded, counters are then the ones
+ *          since reset plus pending DFU erases.
+ */
+typedef struct {
+    Wear_RecordTypeDef Record;
+    uint32_t           EmulMax;  //!> Erases of the most worn EEPROM emulation page
+    uint32_t           BankMax;  //!> Erases of the most worn DFU bank page group
+    uint32_t           WriteAmp; //!> Physical writes per logical write x 100
+    uint32_t           EmulLife; //!> Days until EmulMax reaches WEAR_ENDURANCE, at current rate
+    uint32_t           BankLife; //!> Days until BankMax reaches WEAR_ENDURANCE, at average rate
+} Wear_TelemetryTypeDef;
+
+void         Bsp_Wear_Init();
+void         Bsp_Wear_Task();
+NVRAM_STATUS Bsp_Wear_Save();
+void         Bsp_Wear_Get(Wear_TelemetryTypeDef *tm);
+
+#endif /* INC_BSP_BSP_WEAR_H_ */
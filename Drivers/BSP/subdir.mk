@@ -22,4 +22,10 @@ C_INCLUDES += \
 -IDrivers/BSP/Components/n25q128a/
 
 C_SOURCES += \
-Drivers/BSP/bsp_nvram.c
+Drivers/BSP/bsp_nvram.c \
+Drivers/BSP/bsp_nvram_i2c.c \
+Drivers/BSP/bsp_nvram_qspi.c \
+Drivers/BSP/bsp_wear.c \
+Drivers/BSP/bsp_qspi.c \
+Drivers/BSP/bsp_qspi_cache.c \
+Drivers/BSP/bsp_qspi_fs.c
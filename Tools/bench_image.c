@@ -0,0 +1,143 @@
+/******************************************************************************
+ * @file    bench_image.c
+ * @brief   Test image generator & loader for host benchmarks.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_image.h"
+#include "dfu_console.h"
+
+/*!@brief Generate a pseudo random image, with valid stack & reset vector so that it's
+ *        accepted as a boot bank.
+ *
+ * @param image     : Output buffer.
+ * @param size      : Image size in byte, multiple of 4.
+ * @param seed      : Random seed, same seed generates same image.
+ */
+void BenchImage_gen(uint8_t *image, uint32_t size, uint32_t seed)
+{
+    for (uint32_t i = 0; i < size; i++)
+    {
+        seed     = seed * 1103515245 + 12345;
+        image[i] = seed >> 16;
+    }
+
+    if (size >= 8)
+    {
+        *(uint32_t *)&image[0] = 0x20001000; // End of stack in SRAM1
+        *(uint32_t *)&image[4] = 0x08000201; // Reset handler in flash
+    }
+}
+
+static uint32_t BenchImage_record(char *text, uint8_t len, uint16_t offset, uint8_t type,
+                                  const uint8_t *data)
+{
+    uint8_t  sum = len + (offset >> 8) + (offset & 0xFF) + type;
+    uint32_t idx = sprintf(text, ":%02X%04X%02X", len, offset, type);
+
+    for (int i = 0; i < len; i++)
+    {
+        idx += sprintf(&text[idx], "%02X", data[i]);
+        sum += data[i];
+    }
+    idx += sprintf(&text[idx], "%02X\r\n", (uint8_t)(0x100 - sum));
+
+    return idx;
+}
+
+/*!@brief Convert image to Intel hex text, 16 bytes per record, like objcopy does.
+ *
+ * @param image     : Pointer to image.
+ * @param size      : Image size in byte.
+ * @param base      : Address of image[0].
+ * @param text      : Output buffer, at least size * BENCH_IMAGE_HEX_RATIO bytes.
+ * @return          Text length in byte.
+ */
+uint32_t BenchImage_toHex(const uint8_t *image, uint32_t size, uint32_t base, char *text)
+{
+    uint32_t len = 0;
+
+    for (uint32_t i = 0; i < size; i += 16)
+    {
+        uint32_t addr = base + i;
+        if ((i == 0) || (addr % 0x10000 == 0))
+        {
+            uint8_t upper[2] = {addr >> 24, addr >> 16};
+            len += BenchImage_record(&text[len], 2, 0, 0x04, upper);
+        }
+        len += BenchImage_record(&text[len], (size - i > 16) ? 16 : size - i, addr & 0xFFFF, 0x00,
+                                 &image[i]);
+    }
+    len += BenchImage_record(&text[len], 0, 0, 0x01, NULL);
+
+    return len;
+}
+
+/*!@brief Load an image file, Intel hex (starts with ':') or raw binary.
+ *        Hex records are placed at address - base, gaps are filled with 0xFF like erased flash.
+ *
+ * @param path      : File path.
+ * @param image     : Output buffer.
+ * @param max       : Size of output buffer.
+ * @param base      : Address of image[0], for Intel hex.
+ * @return          Image size in byte, 0 on error.
+ */
+uint32_t BenchImage_load(const char *path, uint8_t *image, uint32_t max, uint32_t base)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "ERROR: can't open [%s]\n", path);
+        return 0;
+    }
+
+    int c = fgetc(fp);
+    if (c != ':')
+    {
+        image[0]      = c;
+        uint32_t size = (c == EOF) ? 0 : 1 + fread(&image[1], 1, max - 1, fp);
+        fclose(fp);
+        return size;
+    }
+
+    // Intel hex, reuse the firmware stream decoder.
+    Dfu_HexLineTypeDefine hexline = {0};
+    Hex_DecoderTypeDef    decoder;
+    uint32_t              size = 0;
+
+    memset(image, 0xFF, max);
+    Hex_DecoderInit(&decoder);
+    for (; c != EOF; c = fgetc(fp))
+    {
+        if (Hex_DecodeByte(&decoder, c, &hexline) != DFU_OK)
+        {
+            continue;
+        }
+        if (hexline.DataType == HEX_DATATYPE_LINEAR_ADDR)
+        {
+            hexline.BaseAddress = (uint32_t)(hexline.DataBuf[0] * 256 + hexline.DataBuf[1]) << 16;
+        }
+        else if (hexline.DataType == HEX_DATATYPE_DATA)
+        {
+            uint32_t addr = hexline.BaseAddress + hexline.DataOffset - base;
+            if (addr + hexline.DataLength > max)
+            {
+                fprintf(stderr, "ERROR: [%s] exceeds %u bytes\n", path, max);
+                size = 0;
+                break;
+            }
+            memcpy(&image[addr], hexline.DataBuf, hexline.DataLength);
+            size = (addr + hexline.DataLength > size) ? addr + hexline.DataLength : size;
+        }
+    }
+
+    fclose(fp);
+    return size;
+}
@@ -0,0 +1,23 @@
+/******************************************************************************
+ * @file    bench_image.h
+ * @brief   Test image generator & loader for host benchmarks.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef BENCH_IMAGE_H_
+#define BENCH_IMAGE_H_
+
+#include "stdint.h"
+
+// clang-format off
+#define BENCH_IMAGE_HEX_RATIO           3       //!< Upper bound of ihex text size / image size
+// clang-format on
+
+void     BenchImage_gen(uint8_t *image, uint32_t size, uint32_t seed);
+uint32_t BenchImage_toHex(const uint8_t *image, uint32_t size, uint32_t base, char *text);
+uint32_t BenchImage_load(const char *path, uint8_t *image, uint32_t max, uint32_t base);
+
+#endif /* BENCH_IMAGE_H_ */
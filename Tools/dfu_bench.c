@@ -0,0 +1,323 @@
+/******************************************************************************
+ * @file    dfu_bench.c
+ * @brief   Host benchmark of DFU Intel hex flash programming.
+ *
+ *          Download the same image to DFU bank with 2x methods and compare:
+ *          - Legacy : program each hex record by Flash_program_8bit().
+ *          - PageBuf: Hex_ExcuteLine() with page buffered fast programming.
+ *          Then copy the downloaded bank to the other one, as boot from DFU bank does:
+ *          - Legacy : erase and program every used page.
+ *          - Scan   : Flash_copyBank() without manifest, scan the bank, skip identical pages.
+ *          - Compare: Flash_copyBank() with manifest, only image pages are compared.
+ *          with destination bank blank, a few pages changed, or identical.
+ *          Flash time is the simulated busy time with typical STM32L476 timing.
+ *
+ *          Usage: dfu_bench [file.hex]
+ *          Without input file, a 256 kB pseudo random image is generated.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_image.h"
+#include "dfu_console.h"
+#include "dfu_flash_if.h"
+#include "flash_sim.h"
+#include "hal_sim.h"
+#include "stm32l4xx_hal.h"
+
+// clang-format off
+#define BENCH_IMAGE_SIZE        (256 * 1024)    //!< Size of generated image
+#define BENCH_MAX_LINES         (64 * 1024)     //!< Maximum hex lines in a file
+#define BENCH_CHANGED_PAGES     4               //!< Pages changed in bank copy scenario
+// clang-format on
+
+extern Flash_PageBufTypeDef Dfu_PageBuf;
+
+static char   **Bench_Lines     = NULL;
+static int      Bench_LineCount = 0;
+static uint8_t *Bench_Image     = NULL; //!< Expected content of DFU bank, offset to FLASH_BASE
+static uint32_t Bench_ImageSize = 0;
+
+/*!@brief Generate a hex image starting from FLASH_BASE, and split it to lines.
+ */
+static void Bench_genImage(uint32_t size)
+{
+    char *text = malloc(size * BENCH_IMAGE_HEX_RATIO);
+
+    BenchImage_gen(Bench_Image, size, 0x12345678);
+    BenchImage_toHex(Bench_Image, size, FLASH_BASE, text);
+
+    for (char *line = strtok(text, "\r\n"); line != NULL; line = strtok(NULL, "\r\n"))
+    {
+        Bench_Lines[Bench_LineCount++] = line;
+    }
+    Bench_ImageSize = size;
+}
+
+/*!@brief Load a hex file and build the expected image.
+ */
+static int Bench_loadFile(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "ERROR: can't open [%s]\n", path);
+        return -1;
+    }
+
+    char                  buf[256];
+    Dfu_HexLineTypeDefine hexline = {0};
+    while (fgets(buf, sizeof(buf), fp) && (Bench_LineCount < BENCH_MAX_LINES))
+    {
+        int len = strcspn(buf, "\r\n");
+        if ((len == 0) || (len >= HEX_MAX_STRING_LENGTH))
+        {
+            continue;
+        }
+        buf[len] = 0;
+
+        if (Hex_ParseLine(buf, len, &hexline) == DFU_OK)
+        {
+            if (hexline.DataType == HEX_DATATYPE_LINEAR_ADDR)
+            {
+                hexline.BaseAddress = (hexline.DataBuf[0] * 256 + hexline.DataBuf[1]) << 16;
+            }
+            else if (hexline.DataType == HEX_DATATYPE_DATA)
+            {
+                uint32_t offset = hexline.BaseAddress + hexline.DataOffset - FLASH_BASE;
+                if (offset + hexline.DataLength <= FLASH_BANK_SIZE)
+                {
+                    memcpy(&Bench_Image[offset], hexline.DataBuf, hexline.DataLength);
+                    if (offset + hexline.DataLength > Bench_ImageSize)
+                    {
+                        Bench_ImageSize = offset + hexline.DataLength;
+                    }
+                }
+            }
+        }
+
+        Bench_Lines[Bench_LineCount] = strdup(buf);
+        Bench_LineCount++;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+/*!@brief Check DFU bank content against expected image.
+ */
+static uint32_t Bench_verify(uint32_t bank)
+{
+    uint8_t *flash = (uint8_t *)Flash_getAddress(bank, 0);
+    uint32_t error = 0;
+
+    for (uint32_t i = 0; i < Bench_ImageSize; i++)
+    {
+        error += (flash[i] != Bench_Image[i]);
+    }
+    return error;
+}
+
+static void Bench_report(const char *name, double cpu, uint32_t error)
+{
+    printf("%-8s| %8u | %6u | %6u | %6u | %9.1f | %8.3f | %s\n", name, FlashSim_Stat.DwordCount,
+           FlashSim_Stat.RowCount, FlashSim_Stat.UnlockCount, FlashSim_Stat.MassErase,
+           FlashSim_Stat.BusyTime / 1000.0, cpu * 1000, error ? "FAIL" : "PASS");
+}
+
+/*!@brief Legacy method, program every hex record straight to flash.
+ */
+static uint32_t Bench_runLegacy(uint32_t bank)
+{
+    Dfu_HexLineTypeDefine hexline = {0};
+    uint32_t              error   = 0;
+
+    for (int i = 0; i < Bench_LineCount; i++)
+    {
+        if (Hex_ParseLine(Bench_Lines[i], strlen(Bench_Lines[i]), &hexline) != DFU_OK)
+        {
+            error++;
+            continue;
+        }
+
+        if (hexline.DataType == HEX_DATATYPE_LINEAR_ADDR)
+        {
+            hexline.BaseAddress = (hexline.DataBuf[0] * 256 + hexline.DataBuf[1]) << 16;
+        }
+        else if (hexline.DataType == HEX_DATATYPE_DATA)
+        {
+            uint32_t address =
+                hexline.BaseAddress + hexline.DataOffset - FLASH_BASE + Flash_getAddress(bank, 0);
+            error += (Flash_program_8bit(address, hexline.DataBuf, hexline.DataLength) != HAL_OK);
+        }
+    }
+    return error;
+}
+
+/*!@brief Page buffer method, same flow as DFU console.
+ */
+static uint32_t Bench_runPageBuf(void)
+{
+    Dfu_HexLineTypeDefine hexline = {0};
+
+    // DFU bank is erased on the first record, like DFU console entry.
+    Dfu_resetSession();
+    for (int i = 0; i < Bench_LineCount; i++)
+    {
+        if (Hex_ParseLine(Bench_Lines[i], strlen(Bench_Lines[i]), &hexline) == DFU_OK)
+        {
+            Hex_ExcuteLine(&hexline);
+        }
+    }
+    return hexline.ErrorCount;
+}
+
+/*!@brief Bank copy before the compare, erase twice and program all double words of a used page.
+ */
+static uint32_t Bench_copyLegacy(uint32_t src, uint32_t dst)
+{
+    uint32_t error = 0;
+
+    for (uint32_t page = 0; page < FLASH_BANK_SIZE / FLASH_PAGE_SIZE; page++)
+    {
+        if (Flash_checkPageUsage(src, page) == 0)
+        {
+            continue;
+        }
+
+        Flash_erasePage(dst, page, 1);
+        Flash_erasePage(dst, page, 1);
+
+        uint32_t SrcAddr = Flash_getAddress(src, page);
+        uint32_t DstAddr = Flash_getAddress(dst, page);
+        HAL_FLASH_Unlock();
+        for (int i = 0; i < FLASH_PAGE_SIZE; i = i + 8)
+        {
+            error += (HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, DstAddr + i,
+                                        *(uint64_t *)(uintptr_t)(SrcAddr + i)) != HAL_OK);
+        }
+        HAL_FLASH_Lock();
+    }
+    return error;
+}
+
+/*!@brief Set destination bank content of a bank copy scenario, without flash statistic.
+ *        [0]: Blank, [1]: Some pages changed, [2]: Identical.
+ */
+static void Bench_copySetup(uint32_t src, uint32_t dst, int scenario)
+{
+    uint8_t *SrcAddr = (uint8_t *)(uintptr_t)Flash_getAddress(src, 0);
+    uint8_t *DstAddr = (uint8_t *)(uintptr_t)Flash_getAddress(dst, 0);
+
+    memset(DstAddr, 0xFF, FLASH_BANK_SIZE);
+    if (scenario == 0)
+    {
+        return;
+    }
+
+    memcpy(DstAddr, SrcAddr, FLASH_BANK_SIZE);
+    for (int i = 0; (scenario == 1) && (i < BENCH_CHANGED_PAGES); i++)
+    {
+        uint32_t page = (Bench_ImageSize / FLASH_PAGE_SIZE) * i / BENCH_CHANGED_PAGES;
+        DstAddr[page * FLASH_PAGE_SIZE + 64] ^= 0x5A;
+    }
+}
+
+/*!@brief Run bank copy scenarios.
+ *
+ * @param manifest  [0]: Hide manifest of source bank, [1]: Keep it.
+ */
+static void Bench_runCopy(const char *name, uint32_t (*copy)(uint32_t, uint32_t), int manifest)
+{
+    const char *scenario[] = {"Blank", "Changed", "Same"};
+    uint8_t     saved[FLASH_PAGE_SIZE];
+    uint8_t    *page = (uint8_t *)(uintptr_t)Flash_getAddress(FLASH_BANK_2, FLASH_MANIFEST_PAGE);
+
+    memcpy(saved, page, FLASH_PAGE_SIZE);
+    if (!manifest)
+    {
+        memset(page, 0xFF, FLASH_PAGE_SIZE);
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        Bench_copySetup(FLASH_BANK_2, FLASH_BANK_1, i);
+        FlashSim_ResetStat();
+        double   cpu   = HalSim_GetCpuTime();
+        uint32_t error = copy(FLASH_BANK_2, FLASH_BANK_1);
+        cpu            = HalSim_GetCpuTime() - cpu;
+        error += memcmp((void *)(uintptr_t)Flash_getAddress(FLASH_BANK_2, 0),
+                        (void *)(uintptr_t)Flash_getAddress(FLASH_BANK_1, 0), FLASH_BANK_SIZE);
+
+        printf("%-8s| %-8s| %6u | %6u | %6u | %6u | %9.1f | %8.3f | %s\n", name, scenario[i],
+               FlashSim_Stat.PageErase, FlashSim_Stat.MassErase, FlashSim_Stat.DwordCount,
+               FlashSim_Stat.RowCount, FlashSim_Stat.BusyTime / 1000.0, cpu * 1000,
+               error ? "FAIL" : "PASS");
+    }
+
+    memcpy(page, saved, FLASH_PAGE_SIZE);
+}
+
+int main(int argc, char *argv[])
+{
+    if (FlashSim_Init() != 0)
+    {
+        return -1;
+    }
+
+    Bench_Lines = calloc(BENCH_MAX_LINES, sizeof(char *));
+    Bench_Image = malloc(FLASH_BANK_SIZE);
+    memset(Bench_Image, 0xFF, FLASH_BANK_SIZE);
+
+    if (argc > 1)
+    {
+        if (Bench_loadFile(argv[1]) != 0)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        Bench_genImage(BENCH_IMAGE_SIZE);
+    }
+
+    printf("Image: %d lines, %u bytes\n", Bench_LineCount, Bench_ImageSize);
+    printf("Method  |    Dword |    Row | Unlock | Erase  | Flash(ms) |  CPU(ms) | Verify\n");
+
+    double   cpu   = 0;
+    uint32_t error = 0;
+
+    // Legacy
+    FlashSim_EraseAll();
+    FlashSim_ResetStat();
+    cpu = HalSim_GetCpuTime();
+    Flash_eraseBank(FLASH_BANK_2);
+    error = Bench_runLegacy(FLASH_BANK_2);
+    cpu   = HalSim_GetCpuTime() - cpu;
+    Bench_report("Legacy", cpu, error + Bench_verify(FLASH_BANK_2));
+
+    // Page buffer
+    FlashSim_EraseAll();
+    FlashSim_ResetStat();
+    dfu_io_init();
+    cpu   = HalSim_GetCpuTime();
+    error = Bench_runPageBuf();
+    cpu   = HalSim_GetCpuTime() - cpu;
+    Bench_report("PageBuf", cpu, error + Bench_verify(FLASH_BANK_2));
+    printf("PageBuf : %s\n", HalSim_ResetRequest ? "Boot bank switched" : "Boot bank not switched");
+
+    // Bank copy, DFU bank holds the image now.
+    printf("\nCopy    | Dst     | PErase | MErase |  Dword |    Row | Flash(ms) |  CPU(ms) | "
+           "Verify\n");
+    Bench_runCopy("Legacy", Bench_copyLegacy, 1);
+    Bench_runCopy("Scan", Flash_copyBank, 0);
+    Bench_runCopy("Compare", Flash_copyBank, 1);
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+/******************************************************************************
+ * @file    dfu_deltapack.c
+ * @brief   Host side patch generator for delta DFU images.
+ *
+ *          Every page of new image is looked up in base image, at the same page
+ *          first, then anywhere else. Found pages are COPY records, the rest are
+ *          DATA records. Runs of pages are merged into a single record.
+ *          Only pages fully inside base image are copied, bytes after the end of
+ *          base image are unknown on device.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dfu_crc.h"
+#include "dfu_delta.h"
+#include "dfu_deltapack.h"
+
+static void DfuDelta_put32(uint8_t *buf, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        buf[i] = v >> (8 * i);
+    }
+}
+
+static uint32_t DfuDelta_get32(const uint8_t *buf)
+{
+    return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+/*!@brief Find a page of base image with the same content.
+ *
+ * @return  Page number in base image, -1 if not found.
+ */
+static int DfuDelta_find(const uint8_t *base, uint32_t base_pages, const uint32_t *base_crc,
+                         const uint8_t *page, uint32_t page_no)
+{
+    uint32_t crc = Dfu_crc32(0, page, DFU_DELTAPACK_PAGE_SIZE);
+
+    if ((page_no < base_pages) && (base_crc[page_no] == crc) &&
+        (memcmp(&base[page_no * DFU_DELTAPACK_PAGE_SIZE], page, DFU_DELTAPACK_PAGE_SIZE) == 0))
+    {
+        return page_no;
+    }
+    for (uint32_t i = 0; i < base_pages; i++)
+    {
+        if ((base_crc[i] == crc) &&
+            (memcmp(&base[i * DFU_DELTAPACK_PAGE_SIZE], page, DFU_DELTAPACK_PAGE_SIZE) == 0))
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*!@brief Make a patch stream that rebuilds image from base.
+ *        Image is padded with 0xFF to a page, like erased flash.
+ *
+ * @param base      : Image in active bank.
+ * @param base_size : Size of base image.
+ * @param image     : New image.
+ * @param size      : Size of new image.
+ * @param patch     : Output, at least DFU_DELTAPACK_BOUND(size) bytes.
+ * @return          Patch size in byte.
+ */
+uint32_t DfuDelta_diff(const uint8_t *base, uint32_t base_size, const uint8_t *image,
+                       uint32_t size, uint8_t *patch)
+{
+    uint32_t  base_pages = base_size / DFU_DELTAPACK_PAGE_SIZE;
+    uint32_t  pages      = (size + DFU_DELTAPACK_PAGE_SIZE - 1) / DFU_DELTAPACK_PAGE_SIZE;
+    uint32_t *base_crc   = malloc(sizeof(uint32_t) * (base_pages + 1));
+    uint8_t  *op         = patch;
+    uint8_t  *record     = NULL; //!< Current record, to merge runs
+    uint32_t  run_src    = 0;    //!< Next source page of a COPY run
+    uint32_t  run_len    = 0;    //!< Pages in current record
+    uint8_t   page[DFU_DELTAPACK_PAGE_SIZE];
+
+    for (uint32_t i = 0; i < base_pages; i++)
+    {
+        base_crc[i] = Dfu_crc32(0, &base[i * DFU_DELTAPACK_PAGE_SIZE], DFU_DELTAPACK_PAGE_SIZE);
+    }
+
+    for (uint32_t i = 0; i < pages; i++)
+    {
+        uint32_t len = size - i * DFU_DELTAPACK_PAGE_SIZE;
+        len          = (len > DFU_DELTAPACK_PAGE_SIZE) ? DFU_DELTAPACK_PAGE_SIZE : len;
+        memset(page, 0xFF, sizeof(page));
+        memcpy(page, &image[i * DFU_DELTAPACK_PAGE_SIZE], len);
+
+        int src = DfuDelta_find(base, base_pages, base_crc, page, i);
+        if (src >= 0)
+        {
+            if ((record != NULL) && (record[0] == DFU_DELTA_OP_COPY) && (run_src == (uint32_t)src))
+            {
+                run_len++;
+                record[3] = run_len;
+                record[4] = run_len >> 8;
+            }
+            else
+            {
+                record  = op;
+                run_len = 1;
+                op[0]   = DFU_DELTA_OP_COPY;
+                op[1]   = src;
+                op[2]   = src >> 8;
+                op[3]   = 1;
+                op[4]   = 0;
+                op += 5;
+            }
+            run_src = src + 1;
+        }
+        else
+        {
+            if ((record == NULL) || (record[0] != DFU_DELTA_OP_DATA))
+            {
+                record  = op;
+                run_len = 0;
+                op[0]   = DFU_DELTA_OP_DATA;
+                op += 5;
+            }
+            run_len++;
+            DfuDelta_put32(&record[1], run_len * DFU_DELTAPACK_PAGE_SIZE);
+            memcpy(op, page, DFU_DELTAPACK_PAGE_SIZE);
+            op += DFU_DELTAPACK_PAGE_SIZE;
+        }
+    }
+
+    free(base_crc);
+    return op - patch;
+}
+
+/*!@brief Pack a delta image file, @ref dfu_delta.h
+ *
+ * @param base      : Image in active bank.
+ * @param base_size : Size of base image.
+ * @param image     : New image.
+ * @param size      : Size of new image.
+ * @param file      : Output, at least DFU_DELTA_HEADER_SIZE + DFU_DELTAPACK_BOUND(size) bytes.
+ * @return          File size in byte.
+ */
+uint32_t DfuDelta_pack(const uint8_t *base, uint32_t base_size, const uint8_t *image,
+                       uint32_t size, uint8_t *file)
+{
+    uint32_t patch = DfuDelta_diff(base, base_size, image, size, &file[DFU_DELTA_HEADER_SIZE]);
+
+    DfuDelta_put32(&file[0], DFU_DELTA_MAGIC);
+    DfuDelta_put32(&file[4], size);
+    DfuDelta_put32(&file[8], Dfu_crc32(0, image, size));
+    DfuDelta_put32(&file[12], base_size);
+    DfuDelta_put32(&file[16], Dfu_crc32(0, base, base_size));
+    DfuDelta_put32(&file[20], patch);
+
+    return DFU_DELTA_HEADER_SIZE + patch;
+}
+
+/*!@brief Check header of a delta image file.
+ *
+ * @param file      : File content.
+ * @param size      : File size in byte.
+ * @param info      : Output, RawSize, RawCrc, BaseSize, BaseCrc.
+ * @return          0 if file is a delta image, -1 if not.
+ */
+int DfuDelta_parse(const uint8_t *file, uint32_t size, uint32_t info[4])
+{
+    if ((size < DFU_DELTA_HEADER_SIZE) || (DfuDelta_get32(&file[0]) != DFU_DELTA_MAGIC) ||
+        (DfuDelta_get32(&file[20]) != size - DFU_DELTA_HEADER_SIZE))
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        info[i] = DfuDelta_get32(&file[4 + 4 * i]);
+    }
+    return 0;
+}
@@ -0,0 +1,29 @@
+/******************************************************************************
+ * @file    dfu_deltapack.h
+ * @brief   Host side patch generator for delta DFU images, @ref dfu_delta.h
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef DFU_DELTAPACK_H_
+#define DFU_DELTAPACK_H_
+
+#include "stdint.h"
+
+// clang-format off
+#define DFU_DELTAPACK_PAGE_SIZE         2048    //!< Flash page size of target
+
+/*!@brief Worst case patch size, every page is sent.
+ */
+#define DFU_DELTAPACK_BOUND(size)       ((size) + DFU_DELTAPACK_PAGE_SIZE + 16)
+// clang-format on
+
+uint32_t DfuDelta_diff(const uint8_t *base, uint32_t base_size, const uint8_t *image,
+                       uint32_t size, uint8_t *patch);
+uint32_t DfuDelta_pack(const uint8_t *base, uint32_t base_size, const uint8_t *image,
+                       uint32_t size, uint8_t *file);
+int      DfuDelta_parse(const uint8_t *file, uint32_t size, uint32_t info[4]);
+
+#endif /* DFU_DELTAPACK_H_ */
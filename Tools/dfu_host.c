@@ -0,0 +1,275 @@
+/******************************************************************************
+ * @file    dfu_host.c
+ * @brief   Host side of binary DFU transfer protocol.
+ *
+ *          Upload flow:
+ *          1. START with image size & CRC32, device replies the offset to start.
+ *             A compressed image file is sent as is, with the decompressed size & CRC32.
+ *             A delta image file also carries size & CRC32 of the base image, device
+ *             rejects it when the active image is not the base.
+ *          2. DATA frames, up to Window frames are in flight. Device acknowledges
+ *             in order data, on NAK or timeout go back to acknowledged offset.
+ *          3. END, device checks image CRC32 and boots from DFU bank.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dfu_crc.h"
+#include "dfu_delta.h"
+#include "dfu_deltapack.h"
+#include "dfu_host.h"
+#include "dfu_lz.h"
+#include "dfu_lzpack.h"
+#include "dfu_proto.h"
+
+/*!@brief Send a frame to device.
+ */
+static void DfuHost_send(DfuHost_LinkTypeDef *link, DfuHost_StatTypeDef *stat, uint8_t cmd,
+                         uint32_t offset, const uint8_t *payload, uint16_t len)
+{
+    uint8_t  buf[DFU_PROTO_MAX_FRAME];
+    uint16_t size = Dfu_protoPack(buf, cmd, offset, payload, len);
+
+    link->Write(link->Ctx, buf, size);
+    stat->TxBytes += size;
+}
+
+/*!@brief Wait for a ACK or NAK frame from device.
+ *
+ * @return  DFU_OK: reply is in rx->Frame, DFU_BUSY: timeout.
+ */
+static int DfuHost_waitReply(DfuHost_LinkTypeDef *link, Dfu_ProtoTypeDef *rx, uint32_t timeout)
+{
+    uint8_t c = 0;
+
+    while (link->Read(link->Ctx, &c, 1, timeout) == 1)
+    {
+        // Intra-frame timeout is not used on host, replies are short.
+        if ((Dfu_protoDecodeByte(rx, c, 0) == DFU_OK) &&
+            ((rx->Frame.Cmd == DFU_PROTO_CMD_ACK) || (rx->Frame.Cmd == DFU_PROTO_CMD_NAK)))
+        {
+            return DFU_OK;
+        }
+    }
+
+    return DFU_BUSY;
+}
+
+/*!@brief Send a control frame and wait for its reply, with retry.
+ *        Control replies carry a payload of ack_len bytes, ACK of DATA still in flight is skipped.
+ *
+ * @return  DFU_HOST_OK, DFU_HOST_LINK_ERR or DFU_HOST_DEVICE_ERR.
+ */
+static int DfuHost_control(DfuHost_LinkTypeDef *link, Dfu_ProtoTypeDef *rx,
+                           DfuHost_StatTypeDef *stat, uint8_t cmd, const uint8_t *payload,
+                           uint16_t len, uint32_t timeout, uint16_t ack_len)
+{
+    for (int retry = 0; retry < DFU_HOST_RETRY; retry++)
+    {
+        DfuHost_send(link, stat, cmd, 0, payload, len);
+        while (DfuHost_waitReply(link, rx, timeout) == DFU_OK)
+        {
+            if ((rx->Frame.Cmd == DFU_PROTO_CMD_ACK) && (rx->Frame.Length == ack_len))
+            {
+                return DFU_HOST_OK;
+            }
+            if (rx->Frame.Cmd == DFU_PROTO_CMD_NAK)
+            {
+                uint8_t status = rx->Frame.Payload[0];
+                if ((status != DFU_PROTO_STATUS_CRC) && (status != DFU_PROTO_STATUS_OFFSET))
+                {
+                    fprintf(stderr, "ERROR: CMD [0x%02X] is rejected, status [%d]\n", cmd, status);
+                    return DFU_HOST_DEVICE_ERR;
+                }
+                break;
+            }
+        }
+        stat->TimeoutCount++;
+    }
+
+    return DFU_HOST_LINK_ERR;
+}
+
+static void DfuHost_put32(uint8_t *buf, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        buf[i] = v >> (8 * i);
+    }
+}
+
+/*!@brief Transfer a stream after START payload is prepared.
+ */
+static int DfuHost_transfer(DfuHost_LinkTypeDef *link, const uint8_t *image, uint32_t size,
+                            const uint8_t *info, uint16_t info_len, DfuHost_StatTypeDef *stat)
+{
+    Dfu_ProtoTypeDef rx;
+
+    Dfu_protoInit(&rx);
+
+    /*! 1. START */
+    int ret = DfuHost_control(link, &rx, stat, DFU_PROTO_CMD_START, info, info_len,
+                              DFU_HOST_TIMEOUT_START, 4);
+    if (ret != DFU_HOST_OK)
+    {
+        return ret;
+    }
+
+    uint32_t acked  = rx.Frame.Offset;
+    uint32_t window = rx.Frame.Payload[0] | (rx.Frame.Payload[1] << 8);
+    uint32_t chunk  = rx.Frame.Payload[2] | (rx.Frame.Payload[3] << 8);
+    uint32_t next   = acked;
+    uint32_t sent   = acked; //!< Highest offset ever sent, to count resend
+    uint32_t retry  = 0;
+
+    chunk              = (chunk > DFU_PROTO_MAX_PAYLOAD) ? DFU_PROTO_MAX_PAYLOAD : chunk;
+    stat->ResumeOffset = acked;
+
+    /*! 2. DATA, Go-Back-N */
+    while (acked < size)
+    {
+        while ((next < size) && (next - acked < window * chunk))
+        {
+            uint32_t len = (size - next > chunk) ? chunk : size - next;
+            DfuHost_send(link, stat, DFU_PROTO_CMD_DATA, next, &image[next], len);
+            stat->FrameCount++;
+            stat->ResendCount += (next < sent);
+            next += len;
+            sent = (next > sent) ? next : sent;
+        }
+
+        if (DfuHost_waitReply(link, &rx, DFU_HOST_TIMEOUT_DATA) != DFU_OK)
+        {
+            stat->TimeoutCount++;
+            if (++retry > DFU_HOST_RETRY)
+            {
+                return DFU_HOST_LINK_ERR;
+            }
+
+            // Ask where the device is, then go back.
+            DfuHost_send(link, stat, DFU_PROTO_CMD_QUERY, 0, NULL, 0);
+            next = acked;
+            continue;
+        }
+
+        if (rx.Frame.Cmd == DFU_PROTO_CMD_ACK)
+        {
+            if (rx.Frame.Offset > acked)
+            {
+                acked = rx.Frame.Offset;
+                retry = 0;
+            }
+            next = (next < acked) ? acked : next;
+        }
+        else
+        {
+            stat->NakCount++;
+            uint8_t status = rx.Frame.Payload[0];
+            if ((status != DFU_PROTO_STATUS_CRC) && (status != DFU_PROTO_STATUS_OFFSET))
+            {
+                fprintf(stderr, "ERROR: DATA is rejected @ [0x%X], status [%d]\n",
+                        rx.Frame.Offset, status);
+                return DFU_HOST_DEVICE_ERR;
+            }
+            acked = (rx.Frame.Offset > acked) ? rx.Frame.Offset : acked;
+            next  = acked;
+        }
+    }
+
+    /*! 3. END, device replies image CRC32. */
+    return DfuHost_control(link, &rx, stat, DFU_PROTO_CMD_END, NULL, 0, DFU_HOST_TIMEOUT_END, 4);
+}
+
+/*!@brief Upload an image to DFU bank of device.
+ *        When DFU_HOST_LINK_ERR is returned, call again with the same image to resume.
+ *
+ * @param link      : Transport.
+ * @param image     : Pointer to image, offset 0 is the start of DFU bank.
+ * @param size      : Image size in byte.
+ * @param stat      : Pointer to statistic, accumulated.
+ * @return  @ref DFU_HOST_OK, DFU_HOST_LINK_ERR or DFU_HOST_DEVICE_ERR
+ */
+int DfuHost_upload(DfuHost_LinkTypeDef *link, const uint8_t *image, uint32_t size,
+                   DfuHost_StatTypeDef *stat)
+{
+    uint8_t info[DFU_PROTO_START_SIZE];
+
+    DfuHost_put32(&info[0], size);
+    DfuHost_put32(&info[4], Dfu_crc32(0, image, size));
+
+    return DfuHost_transfer(link, image, size, info, sizeof(info), stat);
+}
+
+/*!@brief Upload a compressed image file made by dfu_pack, device decompresses it to DFU bank.
+ *        When DFU_HOST_LINK_ERR is returned, call again with the same file to resume.
+ *
+ * @param link      : Transport.
+ * @param file      : Pointer to compressed image file, @ref dfu_lz.h
+ * @param size      : File size in byte.
+ * @param stat      : Pointer to statistic, accumulated.
+ * @return  @ref DFU_HOST_OK, DFU_HOST_LINK_ERR or DFU_HOST_DEVICE_ERR
+ */
+int DfuHost_uploadPacked(DfuHost_LinkTypeDef *link, const uint8_t *file, uint32_t size,
+                         DfuHost_StatTypeDef *stat)
+{
+    uint8_t  info[DFU_PROTO_START_SIZE_EX] = {0};
+    uint32_t raw_size                      = 0;
+    uint32_t raw_crc                       = 0;
+
+    if (DfuLz_parse(file, size, &raw_size, &raw_crc) != 0)
+    {
+        fprintf(stderr, "ERROR: not a compressed image\n");
+        return DFU_HOST_DEVICE_ERR;
+    }
+
+    const uint8_t *stream = &file[DFU_LZ_HEADER_SIZE];
+    uint32_t       len    = size - DFU_LZ_HEADER_SIZE;
+
+    DfuHost_put32(&info[0], len);
+    DfuHost_put32(&info[4], Dfu_crc32(0, stream, len));
+    info[8] = DFU_PROTO_FORMAT_LZ4;
+    DfuHost_put32(&info[12], raw_size);
+    DfuHost_put32(&info[16], raw_crc);
+
+    return DfuHost_transfer(link, stream, len, info, sizeof(info), stat);
+}
+
+/*!@brief Upload a delta image file made by dfu_pack, device rebuilds it from active bank.
+ *        When DFU_HOST_LINK_ERR is returned, call again with the same file to resume.
+ *
+ * @param link      : Transport.
+ * @param file      : Pointer to delta image file, @ref dfu_delta.h
+ * @param size      : File size in byte.
+ * @param stat      : Pointer to statistic, accumulated.
+ * @return  @ref DFU_HOST_OK, DFU_HOST_LINK_ERR or DFU_HOST_DEVICE_ERR
+ */
+int DfuHost_uploadDelta(DfuHost_LinkTypeDef *link, const uint8_t *file, uint32_t size,
+                        DfuHost_StatTypeDef *stat)
+{
+    uint8_t  info[DFU_PROTO_START_SIZE_DELTA] = {0};
+    uint32_t head[4]                          = {0};
+
+    if (DfuDelta_parse(file, size, head) != 0)
+    {
+        fprintf(stderr, "ERROR: not a delta image\n");
+        return DFU_HOST_DEVICE_ERR;
+    }
+
+    const uint8_t *stream = &file[DFU_DELTA_HEADER_SIZE];
+    uint32_t       len    = size - DFU_DELTA_HEADER_SIZE;
+
+    DfuHost_put32(&info[0], len);
+    DfuHost_put32(&info[4], Dfu_crc32(0, stream, len));
+    info[8] = DFU_PROTO_FORMAT_DELTA;
+    DfuHost_put32(&info[12], head[0]);
+    DfuHost_put32(&info[16], head[1]);
+    DfuHost_put32(&info[20], head[2]);
+    DfuHost_put32(&info[24], head[3]);
+
+    return DfuHost_transfer(link, stream, len, info, sizeof(info), stat);
+}
@@ -0,0 +1,56 @@
+/******************************************************************************
+ * @file    dfu_host.h
+ * @brief   Host side of binary DFU transfer protocol, @ref dfu_proto.h
+ *          Transport is abstracted by DfuHost_LinkTypeDef, so the same engine runs
+ *          on a serial port or on a simulated link.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef DFU_HOST_H_
+#define DFU_HOST_H_
+
+#include "stdint.h"
+
+// clang-format off
+#define DFU_HOST_RETRY                  5       //!< Retry of a frame before giving up
+#define DFU_HOST_TIMEOUT_START          2000    //!< START reply timeout in ms, device erases DFU bank
+#define DFU_HOST_TIMEOUT_DATA           500     //!< DATA reply timeout in ms
+#define DFU_HOST_TIMEOUT_END            3000    //!< END reply timeout in ms, device checks image CRC
+
+#define DFU_HOST_OK                     0       //!< Image is accepted by device
+#define DFU_HOST_LINK_ERR               -1      //!< No reply, upload again to resume
+#define DFU_HOST_DEVICE_ERR             -2      //!< Device rejects the image
+// clang-format on
+
+/*!@struct DfuHost_LinkTypeDef
+ *          Transport interface.
+ */
+typedef struct DfuHost_LinkTypeDef {
+    void *Ctx;
+    int (*Write)(void *ctx, const uint8_t *buf, int len);                  //!< Return bytes written
+    int (*Read)(void *ctx, uint8_t *buf, int len, uint32_t timeout_ms);    //!< Return 0 on timeout
+} DfuHost_LinkTypeDef;
+
+/*!@struct DfuHost_StatTypeDef
+ *          Upload statistic.
+ */
+typedef struct DfuHost_StatTypeDef {
+    uint32_t FrameCount;   //!< DATA frames sent
+    uint32_t ResendCount;  //!< DATA frames sent again after NAK or timeout
+    uint32_t NakCount;     //!< NAK received
+    uint32_t TimeoutCount; //!< Reply timeout
+    uint32_t ResumeOffset; //!< Offset acknowledged by START
+    uint32_t TxBytes;      //!< Bytes written to link
+} DfuHost_StatTypeDef;
+
+int DfuHost_upload(DfuHost_LinkTypeDef *link, const uint8_t *image, uint32_t size,
+                   DfuHost_StatTypeDef *stat);
+int DfuHost_uploadPacked(DfuHost_LinkTypeDef *link, const uint8_t *file, uint32_t size,
+                         DfuHost_StatTypeDef *stat);
+int DfuHost_uploadDelta(DfuHost_LinkTypeDef *link, const uint8_t *file, uint32_t size,
+                        DfuHost_StatTypeDef *stat);
+
+#endif /* DFU_HOST_H_ */
@@ -0,0 +1,513 @@
+/******************************************************************************
+ * @file    dfu_link_bench.c
+ * @brief   Host benchmark of end-to-end DFU update time over a simulated UART.
+ *
+ *          Device side runs the DFU console input loop on simulated flash. The UART
+ *          is modeled as 2x byte queues with line timing, bytes arrive at the DMA
+ *          ring of the device after 10 bit times. Compare:
+ *          - Hex   : digest command, then cat <.hex> to the console, no acknowledgement.
+ *                    Host TTY stops on XOFF from device, after the bytes already in its
+ *                    TX FIFO.
+ *          - Hex again after an upload rejected by a wrong digest, DFU bank is erased again.
+ *          - Binary: dfu_host uploader, windowed frames with CRC32.
+ *          - Binary on a noisy link with a disconnect longer than the host retry,
+ *            resumed by a second upload.
+ *          - Binary upload lost for good, then hex from a terminal, after Ctrl-C x3 or after
+ *            the session timeout gives the console back.
+ *          - LZ4   : dfu_pack compressed image, decompressed on device.
+ *          - LZ4 on the same noisy link with a disconnect.
+ *          - Delta : with a base image, active bank runs base image and DFU bank holds
+ *                    the base image too, like after a former update of it, or is blank.
+ *          - Boot  : Bsp_Dfu_Init() time with DFU window armed, and with fast boot.
+ *
+ *          Usage: dfu_link_bench [baudrate] [image_kB | image.hex | image.bin] [base]
+ *          Generated image is pseudo random and not compressible, give a real image
+ *          to measure compression.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_image.h"
+#include "dfu_console.h"
+#include "dfu_crc.h"
+#include "dfu_delta.h"
+#include "dfu_deltapack.h"
+#include "dfu_flash_if.h"
+#include "dfu_host.h"
+#include "dfu_lz.h"
+#include "dfu_lzpack.h"
+#include "dfu_proto.h"
+#include "flash_sim.h"
+#include "hal_sim.h"
+#include "stm32l4xx_hal.h"
+
+// clang-format off
+#define LINK_QUEUE_SIZE         (8 * 1024 * 1024)   //!< Bytes in flight on a wire
+#define LINK_TIME_LIMIT         (600ULL * 1000000)  //!< Give up after 10 min simulated time
+#define LINK_TTY_FIFO           32                  //!< Host TTY bytes sent after XOFF
+#define LINK_TTY_AHEAD          50000               //!< Host TTY queues text ahead, in us
+// clang-format on
+
+extern Flash_PageBufTypeDef Dfu_PageBuf;
+extern Dfu_ProtoTypeDef     Dfu_Proto;
+extern uint16_t             Dfu_InputIdx;
+extern Dfu_DeltaTypeDef     Dfu_Delta;
+extern uint32_t             Dfu_FlowOff;
+
+/*!@struct Link_WireTypeDef
+ *          One direction of the UART, bytes with arrival time.
+ */
+typedef struct Link_WireTypeDef {
+    uint8_t  *Data;
+    uint64_t *Time;
+    uint32_t  Head;
+    uint32_t  Tail;
+    uint64_t  FreeTime; //!< Time when TX line is free, in ns
+} Link_WireTypeDef;
+
+/*!@struct Link_TypeDef
+ *          Simulated link & fault injection.
+ */
+typedef struct Link_TypeDef {
+    Link_WireTypeDef ToDevice;
+    Link_WireTypeDef ToHost;
+    uint32_t         ByteTime;     //!< Time of 1 byte in ns, 10 bits
+    uint32_t         ErrorRate;    //!< 1 bit error in N bytes, 0 to disable
+    uint64_t         CutStart;     //!< Link is cut in [CutStart, CutEnd)
+    uint64_t         CutEnd;
+    uint32_t         Overrun;      //!< Bytes overwritten in device DMA ring
+    uint32_t         Corrupted;    //!< Bytes with bit error
+    uint32_t         Dropped;      //!< Bytes dropped when link is cut
+} Link_TypeDef;
+
+static Link_TypeDef Link;
+
+/*!@brief Queue a byte right after the last byte on a wire.
+ */
+static void Link_queue(Link_WireTypeDef *wire, uint8_t c, int inject)
+{
+    uint64_t t = 0;
+
+    wire->FreeTime += Link.ByteTime;
+    t = wire->FreeTime / 1000;
+    if ((t >= Link.CutStart) && (t < Link.CutEnd))
+    {
+        Link.Dropped++;
+        return;
+    }
+    if (inject && Link.ErrorRate && (HalSim_Rand() % Link.ErrorRate == 0))
+    {
+        c ^= 1 << (HalSim_Rand() % 8);
+        Link.Corrupted++;
+    }
+    if (wire->Tail - wire->Head < LINK_QUEUE_SIZE)
+    {
+        wire->Data[wire->Tail % LINK_QUEUE_SIZE] = c;
+        wire->Time[wire->Tail % LINK_QUEUE_SIZE] = t;
+        wire->Tail++;
+    }
+}
+
+/*!@brief Send a byte now, or after the last byte if line is busy.
+ */
+static void Link_push(Link_WireTypeDef *wire, uint8_t c, int inject)
+{
+    uint64_t now = HalSim_GetTime() * 1000;
+
+    wire->FreeTime = (wire->FreeTime > now) ? wire->FreeTime : now;
+    Link_queue(wire, c, inject);
+}
+
+static uint64_t Link_nextTime(Link_WireTypeDef *wire)
+{
+    return (wire->Head == wire->Tail) ? UINT64_MAX : wire->Time[wire->Head % LINK_QUEUE_SIZE];
+}
+
+/*!@brief Device UART TX, hooked from HAL_UART_Transmit_DMA().
+ */
+static void Link_deviceTx(const uint8_t *buf, uint16_t len)
+{
+    for (int i = 0; i < len; i++)
+    {
+        Link_push(&Link.ToHost, buf[i], 0);
+    }
+}
+
+/*!@brief Run device until a time limit or no more input to process.
+ *        Deliver received bytes to DMA ring, run console while it has work, then skip to next
+ *        event.
+ */
+static void Link_step(uint64_t limit)
+{
+    uint64_t now       = HalSim_GetTime();
+    uint32_t delivered = 0;
+    uint16_t unread    = 0;
+
+    while (Link_nextTime(&Link.ToDevice) <= now)
+    {
+        unread = (HalSim_UartRxHead() + DFU_INPUT_BUF_SIZE - Dfu_InputIdx) % DFU_INPUT_BUF_SIZE;
+        Link.Overrun += (unread == DFU_INPUT_BUF_SIZE - 1);
+        HalSim_UartRxPush(Link.ToDevice.Data[Link.ToDevice.Head++ % LINK_QUEUE_SIZE]);
+        delivered++;
+    }
+
+    unread = (HalSim_UartRxHead() + DFU_INPUT_BUF_SIZE - Dfu_InputIdx) % DFU_INPUT_BUF_SIZE;
+    if (delivered || unread || Dfu_FlowOff || (Dfu_PageBuf.PendAddr != FLASH_PAGEBUF_EMPTY) ||
+        (Dfu_PageBuf.FillCount >= FLASH_PAGE_SIZE))
+    {
+        // Console loop takes at least a few us.
+        Dfu_pollConsole();
+        HalSim_AddTime(delivered ? 0 : 1);
+        return;
+    }
+
+    // Idle, skip to next byte on either direction.
+    uint64_t next = Link_nextTime(&Link.ToDevice);
+    uint64_t host = Link_nextTime(&Link.ToHost);
+    next          = (host < next) ? host : next;
+    next          = (limit < next) ? limit : next;
+    HalSim_AddTime((next > now) ? next - now : 1);
+}
+
+static int Link_hostWrite(void *ctx, const uint8_t *buf, int len)
+{
+    for (int i = 0; i < len; i++)
+    {
+        Link_push(&Link.ToDevice, buf[i], 1);
+    }
+    return len;
+}
+
+static int Link_hostRead(void *ctx, uint8_t *buf, int len, uint32_t timeout_ms)
+{
+    uint64_t deadline = HalSim_GetTime() + (uint64_t)timeout_ms * 1000;
+    int      cnt      = 0;
+
+    while (cnt == 0)
+    {
+        while ((cnt < len) && (Link_nextTime(&Link.ToHost) <= HalSim_GetTime()))
+        {
+            buf[cnt++] = Link.ToHost.Data[Link.ToHost.Head++ % LINK_QUEUE_SIZE];
+        }
+        if ((cnt > 0) || (HalSim_GetTime() >= deadline))
+        {
+            break;
+        }
+        Link_step(deadline);
+    }
+
+    return cnt;
+}
+
+/*!@brief Send a text file like a terminal with XON / XOFF enabled.
+ *        Host runs independently of device, so text is queued LINK_TTY_AHEAD before device
+ *        time. When XOFF arrives, bytes beyond the TTY FIFO are taken back from the wire, and
+ *        sending restarts at the time XON arrives.
+ *
+ * @return  [1]: Device switches bank.
+ */
+static int Link_hostText(const char *text, uint32_t len, uint64_t limit)
+{
+    Link_WireTypeDef *wire   = &Link.ToDevice;
+    uint32_t          sent   = 0;
+    int               paused = 0;
+
+    wire->FreeTime = (wire->FreeTime > HalSim_GetTime() * 1000) ? wire->FreeTime
+                                                                : HalSim_GetTime() * 1000;
+    while (!HalSim_ResetRequest && (HalSim_GetTime() < limit))
+    {
+        uint64_t now = HalSim_GetTime();
+
+        while (Link_nextTime(&Link.ToHost) <= now)
+        {
+            uint64_t t = Link_nextTime(&Link.ToHost);
+            uint8_t  c = Link.ToHost.Data[Link.ToHost.Head++ % LINK_QUEUE_SIZE];
+
+            if ((c == DFU_FLOW_XOFF) && !paused)
+            {
+                uint64_t stop = t * 1000 + LINK_TTY_FIFO * Link.ByteTime;
+                while ((wire->Tail > wire->Head) &&
+                       (wire->Time[(wire->Tail - 1) % LINK_QUEUE_SIZE] * 1000 > stop))
+                {
+                    wire->Tail--;
+                    sent--;
+                }
+                wire->FreeTime = (wire->FreeTime > stop) ? stop : wire->FreeTime;
+                paused         = 1;
+            }
+            else if ((c == DFU_FLOW_XON) && paused)
+            {
+                wire->FreeTime = (wire->FreeTime > t * 1000) ? wire->FreeTime : t * 1000;
+                paused         = 0;
+            }
+        }
+
+        while (!paused && (sent < len) && (wire->FreeTime / 1000 < now + LINK_TTY_AHEAD))
+        {
+            Link_queue(wire, text[sent++], 1);
+        }
+
+        Link_step(limit);
+    }
+
+    return HalSim_ResetRequest;
+}
+
+/*!@brief Restore device to DFU console entry state, like Bsp_Dfu_Init() does.
+ */
+static void Link_reset(uint32_t baudrate)
+{
+    FlashSim_EraseAll();
+    FlashSim_ResetStat();
+
+    Link.ToDevice.Head = Link.ToDevice.Tail = 0;
+    Link.ToHost.Head = Link.ToHost.Tail = 0;
+    Link.ToDevice.FreeTime = Link.ToHost.FreeTime = 0;
+    Link.ByteTime                                 = 10 * 1000000000ULL / baudrate;
+    Link.ErrorRate                                = 0;
+    Link.CutStart = Link.CutEnd = 0;
+    HalSim_Seed(1);
+    Link.Overrun = Link.Corrupted = Link.Dropped = 0;
+
+    dfu_io_init();
+    Dfu_InputIdx = 0;
+    Dfu_FlowOff  = 0;
+    Dfu_resetSession();
+    Dfu_protoInit(&Dfu_Proto);
+    Flash_pageBufInit(&Dfu_PageBuf, 0);
+    HalSim_UartTxHook = Link_deviceTx;
+}
+
+static int Link_verify(const uint8_t *image, uint32_t size)
+{
+    // Boot bank is switched by option byte launch, image is in bank 2.
+    return HalSim_ResetRequest &&
+           (memcmp((void *)(FLASH_BASE + FLASH_BANK_SIZE), image, size) == 0);
+}
+
+/*!@brief Upload with retry, link is noisy and cut for 5s at 40% progress.
+ */
+static int Link_resume(DfuHost_LinkTypeDef *host, const uint8_t *data, uint32_t size, int packed,
+                       DfuHost_StatTypeDef *stat, int *upload)
+{
+    int ret = DFU_HOST_OK;
+
+    Link.ErrorRate = 20000;
+    Link.CutStart  = HalSim_GetTime() + (uint64_t)size * Link.ByteTime / 1000 * 4 / 10;
+    Link.CutEnd    = Link.CutStart + 5000000;
+
+    *upload = 0;
+    do
+    {
+        ret = packed ? DfuHost_uploadPacked(host, data, size, stat)
+                     : DfuHost_upload(host, data, size, stat);
+        (*upload)++;
+    } while ((ret == DFU_HOST_LINK_ERR) && (*upload < 3));
+
+    return ret;
+}
+
+/*!@brief Binary upload is lost for good at 40% progress, then hex is sent by a terminal,
+ *        after Ctrl-C x3 or once the session times out.
+ *
+ * @return  [1]: Device switches bank to the image.
+ */
+static int Link_stalled(DfuHost_LinkTypeDef *host, const uint8_t *image, uint32_t size,
+                        const char *text, uint32_t len, int abort)
+{
+    const char          ctrl_c[DFU_PROTO_ABORT_COUNT] = {[0 ... DFU_PROTO_ABORT_COUNT - 1] =
+                                                             DFU_PROTO_ABORT};
+    DfuHost_StatTypeDef stat                          = {0};
+
+    Link.CutStart = HalSim_GetTime() + (uint64_t)size * Link.ByteTime / 1000 * 4 / 10;
+    Link.CutEnd   = UINT64_MAX;
+    if (DfuHost_upload(host, image, size, &stat) != DFU_HOST_LINK_ERR)
+    {
+        return 0;
+    }
+
+    Link.CutEnd = HalSim_GetTime();
+    if (abort)
+    {
+        Link_hostText(ctrl_c, sizeof(ctrl_c), HalSim_GetTime() + 1000000);
+    }
+    else
+    {
+        HalSim_AddTime((DFU_PROTO_SESSION_TIMEOUT + 1000) * 1000ULL);
+    }
+
+    return Link_hostText(text, len, HalSim_GetTime() + LINK_TIME_LIMIT) &&
+           Link_verify(image, size);
+}
+
+/*!@brief Report a scenario, rate is sustained line bytes per second.
+ */
+static void Link_report(const char *name, uint64_t start, uint32_t tx_bytes, int pass)
+{
+    double   sec   = (HalSim_GetTime() - start) / 1e6;
+    uint32_t erase = FlashSim_Stat.PageErase + FlashSim_Stat.MassErase * FLASH_BANK_SIZE /
+                                                   FLASH_PAGE_SIZE;
+    printf("%-8s| %9u | %8.2f | %7.1f | %8.1f | %5u | %7u | %7u | %7u | %s\n", name, tx_bytes,
+           sec, tx_bytes / sec / 1000, FlashSim_Stat.BusyTime / 1000.0, erase, Link.Overrun,
+           Link.Corrupted, Link.Dropped, pass ? "PASS" : "FAIL");
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t baudrate = (argc > 1) ? atoi(argv[1]) : 115200;
+    uint32_t size     = ((argc > 2) ? atoi(argv[2]) : 256) * 1024;
+
+    // Flash size register is in simulated system memory.
+    if (FlashSim_Init() != 0)
+    {
+        return -1;
+    }
+
+    uint8_t *image = malloc(FLASH_BANK_SIZE);
+
+    if (size > 0)
+    {
+        BenchImage_gen(image, size, 0x12345678);
+    }
+    else
+    {
+        size = BenchImage_load(argv[2], image, FLASH_BANK_SIZE, FLASH_BASE);
+    }
+    if ((size == 0) || (size > FLASH_BANK_SIZE))
+    {
+        return -1;
+    }
+
+    Link.ToDevice.Data = malloc(LINK_QUEUE_SIZE);
+    Link.ToDevice.Time = malloc(LINK_QUEUE_SIZE * sizeof(uint64_t));
+    Link.ToHost.Data   = malloc(LINK_QUEUE_SIZE);
+    Link.ToHost.Time   = malloc(LINK_QUEUE_SIZE * sizeof(uint64_t));
+
+    char    *text     = malloc(size * BENCH_IMAGE_HEX_RATIO + 32);
+    uint32_t text_len = sprintf(text, "digest %08X\r", Dfu_crc32(0, image, size));
+    text_len += BenchImage_toHex(image, size, FLASH_BASE, &text[text_len]);
+    uint8_t *packed   = malloc(DFU_LZ_HEADER_SIZE + DFU_LZPACK_BOUND(size));
+    uint32_t pack_len = DfuLz_pack(image, size, packed);
+
+    printf("Image: %u bytes, ihex %u bytes, LZ4 %u bytes (%.1f%%), UART %u baud\n", size, text_len,
+           pack_len, 100.0 * pack_len / size, baudrate);
+    printf("Method  |  TX bytes |  Time(s) |    kB/s | Flash(ms)| Erase | Overrun | BitErr  | "
+           "Dropped | Verify\n");
+
+    /*! 1. Hex, host writes the whole file, device switches bank after END record. */
+    Link_reset(baudrate);
+    uint64_t start = HalSim_GetTime();
+    Link_hostText(text, text_len, start + LINK_TIME_LIMIT);
+    Link_report("Hex", start, text_len, Link_verify(image, size));
+
+    /*! Hex rejected at END by a wrong digest, then sent again. */
+    uint64_t hex_time = HalSim_GetTime() - start;
+    char    *bad      = malloc(text_len + 1);
+    memcpy(bad, text, text_len);
+    sprintf(bad, "digest %08X", ~Dfu_crc32(0, image, size));
+    bad[strlen(bad)] = '\r';
+
+    Link_reset(baudrate);
+    Link_hostText(bad, text_len, HalSim_GetTime() + 2 * hex_time);
+    start = HalSim_GetTime();
+    Link_hostText(text, text_len, start + LINK_TIME_LIMIT);
+    Link_report("Retry", start, text_len, Link_verify(image, size));
+    free(bad);
+
+    /*! 2. Binary protocol. */
+    DfuHost_LinkTypeDef host = {.Ctx = NULL, .Write = Link_hostWrite, .Read = Link_hostRead};
+    DfuHost_StatTypeDef stat = {0};
+
+    Link_reset(baudrate);
+    start   = HalSim_GetTime();
+    int ret = DfuHost_upload(&host, image, size, &stat);
+    Link_report("Binary", start, stat.TxBytes, (ret == DFU_HOST_OK) && Link_verify(image, size));
+
+    /*! 3. Binary protocol, bit error in 1 of 20000 bytes, link is cut for 5s at 40% progress. */
+    int upload = 0;
+    memset(&stat, 0, sizeof(stat));
+    Link_reset(baudrate);
+    start = HalSim_GetTime();
+    ret   = Link_resume(&host, image, size, 0, &stat, &upload);
+    Link_report("Resume", start, stat.TxBytes, (ret == DFU_HOST_OK) && Link_verify(image, size));
+
+    printf("Resume  : %d uploads, resumed @ %u, frames %u, resend %u, NAK %u, timeout %u\n",
+           upload, stat.ResumeOffset, stat.FrameCount, stat.ResendCount, stat.NakCount,
+           stat.TimeoutCount);
+
+    /*! Binary session is left by a lost host, then hex from a terminal. */
+    for (int abort = 1; abort >= 0; abort--)
+    {
+        Link_reset(baudrate);
+        start = HalSim_GetTime();
+        ret   = Link_stalled(&host, image, size, text, text_len, abort);
+        Link_report(abort ? "Abort" : "Timeout", start, text_len, ret);
+    }
+
+    /*! 4. Compressed image. */
+    memset(&stat, 0, sizeof(stat));
+    Link_reset(baudrate);
+    start = HalSim_GetTime();
+    ret   = DfuHost_uploadPacked(&host, packed, pack_len, &stat);
+    Link_report("LZ4", start, stat.TxBytes, (ret == DFU_HOST_OK) && Link_verify(image, size));
+
+    /*! 5. Compressed image on the noisy link, decoder state is kept across the disconnect. */
+    memset(&stat, 0, sizeof(stat));
+    Link_reset(baudrate);
+    start = HalSim_GetTime();
+    ret   = Link_resume(&host, packed, pack_len, 1, &stat, &upload);
+    Link_report("LZ4 Res", start, stat.TxBytes, (ret == DFU_HOST_OK) && Link_verify(image, size));
+
+    printf("LZ4 Res : %d uploads, resumed @ %u, frames %u, resend %u, NAK %u, timeout %u\n",
+           upload, stat.ResumeOffset, stat.FrameCount, stat.ResendCount, stat.NakCount,
+           stat.TimeoutCount);
+
+    /*! 6. Delta image against a base image. Erase counts a mass erase as all pages of a bank. */
+    if (argc > 3)
+    {
+        uint8_t *base      = malloc(FLASH_BANK_SIZE);
+        uint32_t base_size = BenchImage_load(argv[3], base, FLASH_BANK_SIZE, FLASH_BASE);
+        uint8_t *delta     = malloc(DFU_DELTA_HEADER_SIZE + DFU_DELTAPACK_BOUND(size));
+        uint32_t delta_len = DfuDelta_pack(base, base_size, image, size, delta);
+
+        // DFU bank holds the base image, or is blank and every page is copied.
+        for (int prev = 1; prev >= 0; prev--)
+        {
+            memset(&stat, 0, sizeof(stat));
+            Link_reset(baudrate);
+            memcpy((void *)FLASH_BASE, base, base_size);
+            if (prev)
+            {
+                memcpy((void *)(FLASH_BASE + FLASH_BANK_SIZE), base, base_size);
+            }
+            start = HalSim_GetTime();
+            ret   = DfuHost_uploadDelta(&host, delta, delta_len, &stat);
+            Link_report(prev ? "Delta" : "Delta 0", start, stat.TxBytes,
+                        (ret == DFU_HOST_OK) && Link_verify(image, size));
+        }
+
+        printf("Delta   : base %u bytes, patch %u bytes, pages rebuilt %u, pages sent %u\n",
+               base_size, delta_len, Dfu_Delta.CopyPages, Dfu_Delta.DataBytes / FLASH_PAGE_SIZE);
+    }
+
+    /*! 7. Boot to application, no key is pressed. */
+    double boot[2] = {0};
+    for (int armed = 0; armed < 2; armed++)
+    {
+        Link_reset(baudrate);
+        dfu_io_deinit();
+        Dfu_arm(armed);
+        start = HalSim_GetTime();
+        Bsp_Dfu_Init();
+        boot[armed] = (HalSim_GetTime() - start) / 1e3;
+    }
+    printf("Boot    : DFU window %.1f ms, fast boot %.1f ms\n", boot[1], boot[0]);
+
+    return 0;
+}
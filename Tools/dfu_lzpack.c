@@ -0,0 +1,188 @@
+/******************************************************************************
+ * @file    dfu_lzpack.c
+ * @brief   Host side LZ4 block compressor for DFU images.
+ *
+ *          Greedy parse with hash chains, matches up to 64 kB back. Output is a
+ *          standard LZ4 block, decoded on device by Dfu_lzDecode().
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dfu_crc.h"
+#include "dfu_lz.h"
+#include "dfu_lzpack.h"
+
+static uint32_t DfuLz_hash(const uint8_t *p)
+{
+    uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    return (v * 2654435761U) >> (32 - DFU_LZPACK_HASH_BITS);
+}
+
+static uint8_t *DfuLz_putLength(uint8_t *op, uint32_t len)
+{
+    for (; len >= 255; len -= 255)
+    {
+        *op++ = 255;
+    }
+    *op++ = len;
+    return op;
+}
+
+/*!@brief Emit a sequence: literals, then a match when match_len > 0.
+ */
+static uint8_t *DfuLz_putSequence(uint8_t *op, const uint8_t *lit, uint32_t lit_len,
+                                  uint32_t offset, uint32_t match_len)
+{
+    uint8_t *token = op++;
+    uint32_t ml    = match_len ? match_len - DFU_LZ_MIN_MATCH : 0;
+
+    *token = ((lit_len < 15) ? lit_len : 15) << 4;
+    if (lit_len >= 15)
+    {
+        op = DfuLz_putLength(op, lit_len - 15);
+    }
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+
+    if (match_len > 0)
+    {
+        *op++ = offset & 0xFF;
+        *op++ = offset >> 8;
+        *token |= (ml < 15) ? ml : 15;
+        if (ml >= 15)
+        {
+            op = DfuLz_putLength(op, ml - 15);
+        }
+    }
+
+    return op;
+}
+
+/*!@brief Compress a buffer to a LZ4 block.
+ *
+ * @param src       : Input.
+ * @param size      : Input size in byte.
+ * @param dst       : Output, at least DFU_LZPACK_BOUND(size) bytes.
+ * @return          Compressed size in byte.
+ */
+uint32_t DfuLz_compress(const uint8_t *src, uint32_t size, uint8_t *dst)
+{
+    int32_t *head   = malloc(sizeof(int32_t) << DFU_LZPACK_HASH_BITS);
+    int32_t *chain  = malloc(sizeof(int32_t) * (size ? size : 1));
+    uint8_t *op     = dst;
+    uint32_t anchor = 0;
+    uint32_t ip     = 0;
+
+    memset(head, 0xFF, sizeof(int32_t) << DFU_LZPACK_HASH_BITS);
+
+    while (ip + DFU_LZPACK_MF_LIMIT <= size)
+    {
+        uint32_t h         = DfuLz_hash(&src[ip]);
+        uint32_t limit     = size - DFU_LZPACK_LAST_LITERALS;
+        uint32_t best_len  = 0;
+        uint32_t best_dist = 0;
+        int32_t  cand      = head[h];
+
+        for (int depth = 0; (depth < DFU_LZPACK_CHAIN_DEPTH) && (cand >= 0) &&
+                            (ip - cand <= DFU_LZ_MAX_OFFSET);
+             depth++, cand = chain[cand])
+        {
+            uint32_t len = 0;
+            while ((ip + len < limit) && (src[cand + len] == src[ip + len]))
+            {
+                len++;
+            }
+            if (len > best_len)
+            {
+                best_len  = len;
+                best_dist = ip - cand;
+            }
+        }
+
+        chain[ip] = head[h];
+        head[h]   = ip;
+
+        if (best_len < DFU_LZ_MIN_MATCH)
+        {
+            ip++;
+            continue;
+        }
+
+        op = DfuLz_putSequence(op, &src[anchor], ip - anchor, best_dist, best_len);
+
+        // Index positions inside the match, for following matches.
+        for (uint32_t end = ip + best_len, p = ip + 1;
+             p < end && p + DFU_LZPACK_MF_LIMIT <= size; p++)
+        {
+            uint32_t hp = DfuLz_hash(&src[p]);
+            chain[p]    = head[hp];
+            head[hp]    = p;
+        }
+        ip += best_len;
+        anchor = ip;
+    }
+
+    op = DfuLz_putSequence(op, &src[anchor], size - anchor, 0, 0);
+
+    free(head);
+    free(chain);
+    return op - dst;
+}
+
+static void DfuLz_put32(uint8_t *buf, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        buf[i] = v >> (8 * i);
+    }
+}
+
+static uint32_t DfuLz_get32(const uint8_t *buf)
+{
+    return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+/*!@brief Pack an image to a compressed image file, @ref dfu_lz.h
+ *
+ * @param image     : Image, offset 0 is the start of DFU bank.
+ * @param size      : Image size in byte.
+ * @param file      : Output, at least DFU_LZ_HEADER_SIZE + DFU_LZPACK_BOUND(size) bytes.
+ * @return          File size in byte.
+ */
+uint32_t DfuLz_pack(const uint8_t *image, uint32_t size, uint8_t *file)
+{
+    uint32_t pack = DfuLz_compress(image, size, &file[DFU_LZ_HEADER_SIZE]);
+
+    DfuLz_put32(&file[0], DFU_LZ_MAGIC);
+    DfuLz_put32(&file[4], size);
+    DfuLz_put32(&file[8], Dfu_crc32(0, image, size));
+    DfuLz_put32(&file[12], pack);
+
+    return DFU_LZ_HEADER_SIZE + pack;
+}
+
+/*!@brief Check header of a compressed image file.
+ *
+ * @param file      : File content.
+ * @param size      : File size in byte.
+ * @param raw_size  : Output, decompressed image size.
+ * @param raw_crc   : Output, decompressed image CRC32.
+ * @return          0 if file is a compressed image, -1 if not.
+ */
+int DfuLz_parse(const uint8_t *file, uint32_t size, uint32_t *raw_size, uint32_t *raw_crc)
+{
+    if ((size < DFU_LZ_HEADER_SIZE) || (DfuLz_get32(&file[0]) != DFU_LZ_MAGIC) ||
+        (DfuLz_get32(&file[12]) != size - DFU_LZ_HEADER_SIZE))
+    {
+        return -1;
+    }
+
+    *raw_size = DfuLz_get32(&file[4]);
+    *raw_crc  = DfuLz_get32(&file[8]);
+    return 0;
+}
@@ -0,0 +1,30 @@
+/******************************************************************************
+ * @file    dfu_lzpack.h
+ * @brief   Host side LZ4 block compressor for DFU images, @ref dfu_lz.h
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#ifndef DFU_LZPACK_H_
+#define DFU_LZPACK_H_
+
+#include "stdint.h"
+
+// clang-format off
+#define DFU_LZPACK_HASH_BITS            16      //!< Hash table of 4-byte sequences
+#define DFU_LZPACK_CHAIN_DEPTH          64      //!< Candidates searched per position
+#define DFU_LZPACK_MF_LIMIT             12      //!< LZ4: last match starts >= 12 bytes before end
+#define DFU_LZPACK_LAST_LITERALS        5       //!< LZ4: last 5 bytes are literals
+// clang-format on
+
+/*!@brief Worst case compressed size, incompressible input.
+ */
+#define DFU_LZPACK_BOUND(size)          ((size) + (size) / 255 + 16)
+
+uint32_t DfuLz_compress(const uint8_t *src, uint32_t size, uint8_t *dst);
+uint32_t DfuLz_pack(const uint8_t *image, uint32_t size, uint8_t *file);
+int      DfuLz_parse(const uint8_t *file, uint32_t size, uint32_t *raw_size, uint32_t *raw_crc);
+
+#endif /* DFU_LZPACK_H_ */
@@ -0,0 +1,154 @@
+/******************************************************************************
+ * @file    dfu_pack.c
+ * @brief   Pack a firmware image to a compressed or delta image file for DFU upload.
+ *
+ *          Usage: dfu_pack <image.hex|image.bin> <image.dfz>
+ *                 dfu_pack <image.hex|image.bin> <image.dfd> <base.hex|base.bin>
+ *          e.g.   ./Build/Host/dfu_pack ./Build/discovery.hex ./Build/discovery.dfz
+ *                 ./Build/Host/dfu_upload /dev/cu.usbmodem14203 ./Build/discovery.dfz
+ *
+ *          With a base image, which is the image running on device, a delta image is
+ *          made instead.
+ *
+ *          The packed file is decoded back with the firmware decoder before it's
+ *          written, so a file that passes here decodes the same way on device.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_image.h"
+#include "dfu_delta.h"
+#include "dfu_deltapack.h"
+#include "dfu_lz.h"
+#include "dfu_lzpack.h"
+
+// clang-format off
+#define PACK_MAX_SIZE           (512 * 1024)    //!< Flash bank size
+#define PACK_BASE_ADDR          0x08000000      //!< Address of image[0] in ihex
+#define PACK_FILE_SIZE          (2 * PACK_MAX_SIZE) //!< Larger than worst case of both formats
+// clang-format on
+
+static uint32_t Pack_write(void *ctx, uint32_t pos, const uint8_t *buf, uint32_t len)
+{
+    memcpy((uint8_t *)ctx + pos, buf, len);
+    return 0;
+}
+
+static uint32_t Pack_read(void *ctx, uint32_t pos, uint8_t *buf, uint32_t len)
+{
+    memcpy(buf, (uint8_t *)ctx + pos, len);
+    return 0;
+}
+
+static const uint8_t *Pack_Base = NULL;
+
+static uint32_t Pack_copy(void *ctx, uint32_t src_page, uint32_t pos, uint32_t count)
+{
+    memcpy((uint8_t *)ctx + pos, &Pack_Base[src_page * DFU_DELTAPACK_PAGE_SIZE],
+           count * DFU_DELTAPACK_PAGE_SIZE);
+    return 0;
+}
+
+/*!@brief Make a delta image file and check it, base is padded with 0xFF like flash.
+ */
+static uint32_t Pack_delta(const uint8_t *image, uint32_t size, const char *path, uint8_t *file)
+{
+    uint8_t *base      = malloc(PACK_MAX_SIZE);
+    uint32_t base_size = BenchImage_load(path, base, PACK_MAX_SIZE, PACK_BASE_ADDR);
+    if (base_size == 0)
+    {
+        return 0;
+    }
+    memset(&base[base_size], 0xFF, PACK_MAX_SIZE - base_size);
+
+    uint32_t len   = DfuDelta_pack(base, base_size, image, size, file);
+    uint8_t *check = malloc(PACK_MAX_SIZE);
+
+    Dfu_DeltaTypeDef delta;
+    DFU_RET          ret = DFU_OK;
+
+    Pack_Base = base;
+    Dfu_deltaInit(&delta, PACK_MAX_SIZE, DFU_DELTAPACK_PAGE_SIZE, Pack_write, Pack_copy, check);
+    for (uint32_t i = DFU_DELTA_HEADER_SIZE; (i < len) && (ret == DFU_OK); i += 256)
+    {
+        ret = Dfu_deltaDecode(&delta, &file[i], (len - i > 256) ? 256 : len - i);
+    }
+    if ((ret != DFU_OK) || (delta.OutSize < size) || (memcmp(check, image, size) != 0))
+    {
+        fprintf(stderr, "ERROR: delta check fails, ret [%d]\n", ret);
+        return 0;
+    }
+
+    printf("Delta on %u bytes base: %u pages copied, %u bytes sent\n", base_size,
+           delta.CopyPages, delta.DataBytes);
+    return len;
+}
+
+static int Pack_save(const char *path, const uint8_t *file, uint32_t len, uint32_t size)
+{
+    FILE *fp = fopen(path, "wb");
+    if ((fp == NULL) || (fwrite(file, 1, len, fp) != len))
+    {
+        fprintf(stderr, "ERROR: can't write [%s]\n", path);
+        return -1;
+    }
+    fclose(fp);
+
+    printf("Packed %u -> %u bytes, ratio %.1f%%\n", size, len, 100.0 * len / size);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printf("Usage: %s <image.hex|image.bin> <image.dfz> [base.hex|base.bin]\n", argv[0]);
+        return -1;
+    }
+
+    uint8_t *image = malloc(PACK_MAX_SIZE);
+    uint32_t size  = BenchImage_load(argv[1], image, PACK_MAX_SIZE, PACK_BASE_ADDR);
+    if (size == 0)
+    {
+        return -1;
+    }
+
+    uint8_t *file = malloc(PACK_FILE_SIZE);
+    uint32_t len  = 0;
+
+    if (argc > 3)
+    {
+        len = Pack_delta(image, size, argv[3], file);
+        if (len == 0)
+        {
+            return -1;
+        }
+        return Pack_save(argv[2], file, len, size);
+    }
+
+    len = DfuLz_pack(image, size, file);
+
+    // Decode in the same chunks as DATA frames.
+    Dfu_LzTypeDef lz;
+    uint8_t      *check = malloc(size);
+    DFU_RET       ret   = DFU_OK;
+
+    Dfu_lzInit(&lz, size, Pack_write, Pack_read, check);
+    for (uint32_t i = DFU_LZ_HEADER_SIZE; (i < len) && (ret == DFU_OK); i += 256)
+    {
+        ret = Dfu_lzDecode(&lz, &file[i], (len - i > 256) ? 256 : len - i);
+    }
+    if ((ret != DFU_OK) || (lz.OutSize != size) || (memcmp(check, image, size) != 0))
+    {
+        fprintf(stderr, "ERROR: decode check fails, ret [%d]\n", ret);
+        return -1;
+    }
+
+    return Pack_save(argv[2], file, len, size);
+}
@@ -0,0 +1,171 @@
+/******************************************************************************
+ * @file    dfu_upload.c
+ * @brief   Upload a binary image to DFU console through serial port.
+ *
+ *          Usage: dfu_upload <port> <image.bin|image.dfz|image.dfd> [baudrate]
+ *          e.g.   ./Build/Host/dfu_upload /dev/cu.usbmodem14203 ./Build/discovery.bin
+ *
+ *          A compressed image made by dfu_pack is detected by its header, and is
+ *          decompressed by device on the fly. A delta image is rebuilt by device
+ *          from the active bank, which must hold the base image of the delta.
+ *
+ *          Enter DFU console first (press [Enter] during boot), then run the upload.
+ *          An interrupted upload is resumed by running it again with the same image.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dfu_deltapack.h"
+#include "dfu_host.h"
+#include "dfu_lzpack.h"
+
+static int Serial_open(const char *port, uint32_t baudrate)
+{
+    struct termios tio;
+    speed_t        speed = B115200;
+
+    switch (baudrate)
+    {
+    case 9600:
+        speed = B9600;
+        break;
+    case 57600:
+        speed = B57600;
+        break;
+    case 230400:
+        speed = B230400;
+        break;
+    default:
+        speed = B115200;
+        break;
+    }
+
+    int fd = open(port, O_RDWR | O_NOCTTY);
+    if ((fd < 0) || (tcgetattr(fd, &tio) != 0))
+    {
+        fprintf(stderr, "ERROR: can't open [%s]\n", port);
+        return -1;
+    }
+
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN]  = 0;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tio);
+    tcflush(fd, TCIOFLUSH);
+
+    return fd;
+}
+
+static int Serial_write(void *ctx, const uint8_t *buf, int len)
+{
+    int fd  = *(int *)ctx;
+    int cnt = 0;
+
+    while (cnt < len)
+    {
+        int ret = write(fd, &buf[cnt], len - cnt);
+        if (ret < 0)
+        {
+            return cnt;
+        }
+        cnt += ret;
+    }
+    return cnt;
+}
+
+static int Serial_read(void *ctx, uint8_t *buf, int len, uint32_t timeout_ms)
+{
+    int           fd  = *(int *)ctx;
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+
+    if (poll(&pfd, 1, timeout_ms) <= 0)
+    {
+        return 0;
+    }
+
+    int ret = read(fd, buf, len);
+    return (ret < 0) ? 0 : ret;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printf("Usage: %s <port> <image.bin|image.dfz|image.dfd> [baudrate]\n", argv[0]);
+        return -1;
+    }
+
+    FILE *fp = fopen(argv[2], "rb");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "ERROR: can't open [%s]\n", argv[2]);
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *image = malloc(size);
+    if ((image == NULL) || (fread(image, 1, size, fp) != (size_t)size))
+    {
+        fprintf(stderr, "ERROR: can't read [%s]\n", argv[2]);
+        return -1;
+    }
+    fclose(fp);
+
+    int fd = Serial_open(argv[1], (argc > 3) ? atoi(argv[3]) : 115200);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    DfuHost_LinkTypeDef link  = {.Ctx = &fd, .Write = Serial_write, .Read = Serial_read};
+    DfuHost_StatTypeDef stat  = {0};
+    struct timespec     start = {0};
+    struct timespec     end   = {0};
+
+    uint32_t raw_size = 0;
+    uint32_t raw_crc  = 0;
+    uint32_t info[4]  = {0};
+    int      packed   = (DfuLz_parse(image, size, &raw_size, &raw_crc) == 0);
+    int      delta    = (DfuDelta_parse(image, size, info) == 0);
+    if (packed)
+    {
+        printf("Compressed image, %u bytes decompressed\n", raw_size);
+    }
+    if (delta)
+    {
+        printf("Delta image, %u bytes on base image of %u bytes\n", info[0], info[2]);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int ret = packed  ? DfuHost_uploadPacked(&link, image, size, &stat)
+              : delta ? DfuHost_uploadDelta(&link, image, size, &stat)
+                      : DfuHost_upload(&link, image, size, &stat);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("Upload %s: %ld bytes in %.2f s, resumed @ %u\n", (ret == DFU_HOST_OK) ? "done" : "fail",
+           size, sec, stat.ResumeOffset);
+    printf("Frames %u, resend %u, NAK %u, timeout %u\n", stat.FrameCount, stat.ResendCount,
+           stat.NakCount, stat.TimeoutCount);
+    if (ret == DFU_HOST_LINK_ERR)
+    {
+        printf("Link error, run again with the same image to resume.\n");
+    }
+
+    close(fd);
+    return ret;
+}
@@ -0,0 +1,1099 @@
+/******************************************************************************
+ * @file    eeprom_bench.c
+ * @brief   Host benchmark of EEPROM emulation (lib/EEPROM_Emul through bsp_nvram).
+ *
+ *          Performance: format, fill every variable, random writes, read back and
+ *          init on a used flash, with the simulated flash busy time per phase and
+ *          the worst single write (page transfer). Writes are spaced by a run of
+ *          Bsp_Nvram_Task(), which erases transferred pages in background, latency
+ *          percentiles and time waiting for the background erase are reported.
+ *          Reads are done by page scan (RAM index disabled) and through the RAM
+ *          index, host CPU time only.
+ *
+ *          Power loss: a random write workload crossing page transfers and cleanups
+ *          is repeated with a power loss injected at each of its flash steps, then
+ *          EE_Init() must recover and every variable must read the last written
+ *          value. The interrupted write may read either its old or new value. Some
+ *          writes of the workload are blobs, new data or few bytes patched, which must
+ *          read their old or new data.
+ *
+ *          Config: settings are saved by writing every key, few of them changed, and
+ *          a counter key written several times per save. Compared writing the device
+ *          directly and through the write-back cache of bsp_nvram, flushed by
+ *          Bsp_Nvram_Task(). Above phases write the device directly.
+ *
+ *          Transaction: calibration sets of consecutive variables, written one variable
+ *          at a time, in one device transaction, and through Bsp_Nvram_Begin() and
+ *          Bsp_Nvram_Commit(). The transaction power loss test interrupts a workload
+ *          of sets at each flash step, the interrupted set must read all old or all
+ *          new values after EE_Init().
+ *
+ *          Blob: a table written as 32-bit variables and as one blob of EE_WriteBlob(),
+ *          with the whole table changed per write, then few entries of it (patch), the
+ *          variables path only writing changed entries.
+ *
+ *          Boot: config of NVRAM_CONFIG_SIZE variables loaded after EE_Init(), by a read
+ *          per variable and by Bsp_Nvram_LoadConfig() snapshot, with RAM index and with
+ *          page scan (snapshot in a single browse). Time to config is init + load.
+ *
+ *          Wear: random variables and a single counter written through the cache, with
+ *          Bsp_Wear_Task() saving the record. Erase and program counters of bsp_wear must
+ *          match the flash simulation, then DFU erases are pending in backup registers
+ *          until the record is saved, and the DFU WEAR reply must carry the telemetry.
+ *
+ *          CRC: variable and blob writes interleaved with Flash_crc32() of DFU, which
+ *          shares the CRC unit, must read back after EE_Init() with and without a reset.
+ *          A CRC16 switched out mid-calculation for Flash_crc32() must go on unchanged.
+ *
+ *          Usage: eeprom_bench [writes] [typ|max]
+ *          writes is the random write count, default 2000. max uses maximum flash
+ *          timing of the datasheet instead of typical.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp_nvram.h"
+#include "bsp_wear.h"
+#include "dfu_crc.h"
+#include "dfu_flash_if.h"
+#include "dfu_proto.h"
+#include "flash_sim.h"
+#include "hal_sim.h"
+#include "stm32l4xx_hal.h"
+#include "stm32l4xx_ll_crc.h"
+
+// clang-format off
+#define BENCH_WRITES            2000    //!< Default random write count
+#define BENCH_LOSS_WRITES       800     //!< Write workload of power loss test, 1x cleanup at least
+#define BENCH_READ_LOOP         100     //!< Read every variable N times
+#define BENCH_WRITE_PERIOD_MS   100     //!< Write period, Bsp_Nvram_Task() runs after each write
+#define BENCH_AREA_SIZE         (PAGES_NUMBER * PAGE_SIZE)
+#define BENCH_CFG_KEYS          24      //!< Keys of a config save
+#define BENCH_CFG_SAVES         500     //!< Config save count
+#define BENCH_CFG_COUNTER       4       //!< Counter key writes per config save
+#define BENCH_CFG_PERIOD_MS     100     //!< Config save period, Bsp_Nvram_Task() runs after each
+#define BENCH_TX_SETS           100     //!< Calibration sets written per path
+#define BENCH_TX_VARS           40      //!< Variables of a calibration set
+#define BENCH_TX_LOSS_SETS      40      //!< Set workload of transaction power loss test
+#define BENCH_TX_LOSS_VARS      32      //!< Variables of a set in power loss test
+#define BENCH_BLOB_SIZE         EE_BLOB_MAX_SIZE //!< Table size of blob phase
+#define BENCH_BLOB_WRITES       50      //!< Table writes per path
+#define BENCH_BLOB_PATCH        8       //!< Table entries changed per write of patch workload
+#define BENCH_LOSS_BLOB_PERIOD  32      //!< 1 in N writes of power loss workload is a blob
+#define BENCH_LOSS_CUT_PERIOD   4       //!< Recovery cut after 1 in N losses of write workload
+#define BENCH_WEAR_WRITES       5000    //!< Writes per wear workload
+#define BENCH_CRC_WRITES        200     //!< Writes interleaved with Flash_crc32()
+// clang-format on
+
+extern const uint16_t EEP_EMUL_VirtualTab[];
+extern uint16_t       uhNbWrittenElements;
+extern uint8_t        ubCurrentActivePage;
+extern uint32_t       uwAddressNextWrite;
+extern uint8_t        ubIndexValid;
+extern Dfu_ProtoTypeDef Dfu_Proto;
+
+NVRAM_STATUS EEP_EMUL_Write(uint32_t addr, uint32_t value);
+NVRAM_STATUS EEP_EMUL_WriteTx(uint32_t *addr, uint32_t *value, uint16_t count);
+NVRAM_STATUS EEP_EMUL_WriteEx(uint8_t reg, uint8_t *value, uint16_t len);
+
+typedef struct {
+    uint16_t Length; //!< 0 if never written
+    uint8_t  Data[EE_BLOB_MAX_SIZE];
+} Bench_BlobTypeDef;
+
+static uint32_t Bench_Value[NB_OF_VARIABLES]; //!< Expected value of each variable
+static uint8_t *Bench_Area = NULL; //!< Saved emulation pages before power loss workload
+static uint8_t *Bench_Lost = NULL; //!< Emulation pages at power loss, before recovery
+static uint32_t *Bench_Time = NULL; //!< Latency of each write in us
+
+static Bench_BlobTypeDef Bench_Blob[NB_OF_BLOBS]; //!< Expected data of each blob
+static Bench_BlobTypeDef Bench_BlobNew;           //!< New data of the interrupted blob write
+static int               Bench_BlobPending = -1;  //!< Blob being written at power loss, -1 for none
+
+static void Bench_report(const char *name, uint32_t count, uint64_t max, double cpu)
+{
+    printf("%-8s| %6u | %6u | %6u | %9.1f | %7.2f | %8.3f\n", name, count,
+           FlashSim_Stat.DwordCount, FlashSim_Stat.PageErase, FlashSim_Stat.BusyTime / 1000.0,
+           max / 1000.0, cpu * 1000);
+}
+
+static int Bench_compare(const void *a, const void *b)
+{
+    return (*(uint32_t *)a > *(uint32_t *)b) - (*(uint32_t *)a < *(uint32_t *)b);
+}
+
+/*!@brief Write variables to the device, bypass the cache, record expected value and latency.
+ *
+ * @param count : Number of writes.
+ * @param index : [-1] Random variable, [others] Write variables in order.
+ * @param max   : Return the longest write in us.
+ * @return Number of failed writes.
+ */
+static uint32_t Bench_write(uint32_t count, int index, uint64_t *max)
+{
+    uint32_t error = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t var   = ((index < 0) ? HalSim_Rand() : index + i) % NB_OF_VARIABLES;
+        uint32_t value = HalSim_Rand();
+        uint64_t time  = HalSim_GetTime();
+
+        if (EEP_EMUL_Write(EEP_EMUL_VirtualTab[var], value) != NVRAM_OK)
+        {
+            error++;
+            continue;
+        }
+
+        Bench_Value[var] = value;
+        time             = HalSim_GetTime() - time;
+        *max             = (time > *max) ? time : *max;
+        Bench_Time[i]    = time;
+
+        Bsp_Nvram_Task();
+        HAL_Delay(BENCH_WRITE_PERIOD_MS);
+    }
+    return error;
+}
+
+/*!@brief Read back every variable and compare with expected value.
+ *
+ * @param skip  : Variable allowed to hold the value of an interrupted write, -1 for none.
+ * @return Number of variables with wrong value.
+ */
+static uint32_t Bench_verify(int skip, uint32_t skip_value)
+{
+    uint32_t error = 0;
+
+    for (uint32_t var = 0; var < NB_OF_VARIABLES; var++)
+    {
+        uint32_t value = 0;
+        if (Nvram_Drv.Read(EEP_EMUL_VirtualTab[var], &value) != NVRAM_OK)
+        {
+            error++;
+        }
+        else if ((value != Bench_Value[var]) && !(((int)var == skip) && (value == skip_value)))
+        {
+            error++;
+        }
+    }
+    return error;
+}
+
+/*!@brief Compare a blob read back with expected data, zero padded by ReadEx().
+ */
+static uint8_t Bench_blobMatch(NVRAM_STATUS status, const uint8_t *data, const Bench_BlobTypeDef *blob)
+{
+    if (blob->Length == 0)
+    {
+        return status != NVRAM_OK;
+    }
+
+    for (uint32_t i = blob->Length; i < NVRAM_EX_SIZE; i++)
+    {
+        if (data[i] != 0)
+        {
+            return 0;
+        }
+    }
+    return (status == NVRAM_OK) && (memcmp(data, blob->Data, blob->Length) == 0);
+}
+
+/*!@brief Read back every blob, the interrupted blob may hold its old or new data.
+ *
+ * @return Number of blobs with wrong data.
+ */
+static uint32_t Bench_verifyBlob(void)
+{
+    uint8_t  data[NVRAM_EX_SIZE];
+    uint32_t error = 0;
+
+    for (int id = 0; id < NB_OF_BLOBS; id++)
+    {
+        NVRAM_STATUS status = Nvram_Drv.ReadEx(id, data, sizeof(data));
+
+        error += !Bench_blobMatch(status, data, &Bench_Blob[id]) &&
+                 !((id == Bench_BlobPending) && Bench_blobMatch(status, data, &Bench_BlobNew));
+    }
+    return error;
+}
+
+/*!@brief Read back every variable, the variables of an interrupted set must hold either all
+ *        their old or all their new values.
+ *
+ * @param first : First variable of the interrupted set, -1 for none.
+ * @param count : Number of variables of the set.
+ * @param value : New values of the set.
+ * @return Number of variables with wrong value, +1 if the set is partially written.
+ */
+static uint32_t Bench_verifySet(int first, uint32_t count, const uint32_t *value)
+{
+    uint32_t error = 0;
+    uint32_t old   = 0;
+    uint32_t new   = 0;
+
+    for (uint32_t var = 0; var < NB_OF_VARIABLES; var++)
+    {
+        uint32_t data = 0;
+        uint32_t k    = (var + NB_OF_VARIABLES - first) % NB_OF_VARIABLES;
+
+        if (Nvram_Drv.Read(EEP_EMUL_VirtualTab[var], &data) != NVRAM_OK)
+        {
+            error++;
+        }
+        else if ((first >= 0) && (k < count))
+        {
+            old += (data == Bench_Value[var]);
+            new += (data == value[k]);
+            error += (data != Bench_Value[var]) && (data != value[k]);
+        }
+        else if (data != Bench_Value[var])
+        {
+            error++;
+        }
+    }
+
+    return error + ((first >= 0) && (old < count) && (new < count));
+}
+
+/*!@brief Read back every variable in a loop.
+ *
+ * @param index : [0] Page scan, RAM index disabled, [1] RAM index.
+ * @param error : Add number of wrong values.
+ * @return Host CPU time per read in us.
+ */
+static double Bench_read(uint8_t index, uint32_t *error)
+{
+    uint8_t valid = ubIndexValid;
+
+    ubIndexValid = index;
+    double cpu   = HalSim_GetCpuTime();
+    for (int i = 0; i < BENCH_READ_LOOP; i++)
+    {
+        *error += Bench_verify(-1, 0);
+    }
+    cpu          = HalSim_GetCpuTime() - cpu;
+    ubIndexValid = valid;
+
+    Bench_report(index ? "Index" : "Scan", NB_OF_VARIABLES * BENCH_READ_LOOP, 0, cpu);
+    return cpu * 1e6 / (NB_OF_VARIABLES * BENCH_READ_LOOP);
+}
+
+/*!@brief Run the config save workload.
+ *
+ * @param cache : [0] Write device directly, [1] Write through the cache.
+ * @param max   : Return the longest write in us.
+ * @param flush : Return the longest Bsp_Nvram_Task() in us.
+ * @return Total write time in us, Bsp_Nvram_Task() excluded.
+ */
+static uint64_t Bench_config(uint8_t cache, uint64_t *max, uint64_t *flush)
+{
+    uint64_t total = 0;
+
+    HalSim_Seed(0xC0FF19);
+    for (uint32_t save = 0; save < BENCH_CFG_SAVES; save++)
+    {
+        for (uint32_t i = 0; i < BENCH_CFG_KEYS + BENCH_CFG_COUNTER - 1; i++)
+        {
+            // Key 0 is a counter written several times, others change 1 in 16 saves.
+            uint32_t var   = (i < BENCH_CFG_COUNTER) ? 0 : i - BENCH_CFG_COUNTER + 1;
+            uint32_t value = (var == 0) ? Bench_Value[0] + 1
+                             : (HalSim_Rand() % 16 == 0) ? HalSim_Rand()
+                                                        : Bench_Value[var];
+            uint64_t time  = HalSim_GetTime();
+
+            if (cache)
+            {
+                Nvram_Drv.Write(EEP_EMUL_VirtualTab[var], value);
+            }
+            else
+            {
+                EEP_EMUL_Write(EEP_EMUL_VirtualTab[var], value);
+            }
+
+            Bench_Value[var] = value;
+            time             = HalSim_GetTime() - time;
+            total += time;
+            *max = (time > *max) ? time : *max;
+        }
+
+        uint64_t time = HalSim_GetTime();
+        Bsp_Nvram_Task();
+        time   = HalSim_GetTime() - time;
+        *flush = (time > *flush) ? time : *flush;
+        HAL_Delay(BENCH_CFG_PERIOD_MS);
+    }
+    Bsp_Nvram_Flush();
+
+    return total;
+}
+
+/*!@brief Compare config save workload on device directly and through the cache.
+ */
+static void Bench_runConfig(void)
+{
+    uint32_t writes = BENCH_CFG_SAVES * (BENCH_CFG_KEYS + BENCH_CFG_COUNTER - 1);
+    uint32_t dword  = 0;
+    uint64_t max    = 0;
+    uint64_t flush  = 0;
+    uint64_t total  = 0;
+    uint32_t error  = 0;
+
+    printf("\nConfig: %u saves of %u keys, counter written %ux per save\n", BENCH_CFG_SAVES,
+           BENCH_CFG_KEYS, BENCH_CFG_COUNTER);
+    printf("Path    | Writes |  Dword | PErase | Flash(ms) | Avg(us) | Max(us)\n");
+
+    for (uint8_t cache = 0; cache < 2; cache++)
+    {
+        FlashSim_ResetStat();
+        memset(&Nvram_CacheStat, 0, sizeof(Nvram_CacheStat));
+        max   = 0;
+        total = Bench_config(cache, &max, &flush);
+        error += Bench_verify(-1, 0);
+
+        printf("%-8s| %6u | %6u | %6u | %9.1f | %7.1f | %7.1f\n", cache ? "Cache" : "Direct",
+               writes, FlashSim_Stat.DwordCount, FlashSim_Stat.PageErase,
+               FlashSim_Stat.BusyTime / 1000.0, (double)total / writes, (double)max);
+        dword = cache ? (dword - FlashSim_Stat.DwordCount) * 100 / dword : FlashSim_Stat.DwordCount;
+    }
+
+    printf("Cache   : elided %u, coalesced %u, flash write %u, flush %u, max flush %.2f ms\n",
+           Nvram_CacheStat.Elided, Nvram_CacheStat.Coalesced, Nvram_CacheStat.FlashWrite,
+           Nvram_CacheStat.Flush, flush / 1000.0);
+    printf("Saved   : %u of %u writes, %u%% flash dwords\n",
+           Nvram_CacheStat.Elided + Nvram_CacheStat.Coalesced, writes, dword);
+    printf("Verify  : %s\n", error ? "FAIL" : "PASS");
+}
+
+/*!@brief Write a calibration set of consecutive variables with new random values.
+ *
+ * @param path  : [0] One device write per variable, [1] One device transaction,
+ *                [2] Nvram_Drv.Write() between Bsp_Nvram_Begin() and Bsp_Nvram_Commit().
+ * @param first : First variable of the set.
+ * @param count : Number of variables, up to BENCH_TX_VARS.
+ * @param value : Return the new values, value[k] is of variable first + k.
+ * @return Number of failed writes.
+ */
+static uint32_t Bench_txSet(uint8_t path, uint32_t first, uint32_t count, uint32_t *value)
+{
+    uint32_t addr[BENCH_TX_VARS];
+    uint32_t error = 0;
+
+    for (uint32_t k = 0; k < count; k++)
+    {
+        addr[k]  = EEP_EMUL_VirtualTab[(first + k) % NB_OF_VARIABLES];
+        value[k] = HalSim_Rand();
+    }
+
+    if (path == 1)
+    {
+        error = (EEP_EMUL_WriteTx(addr, value, count) != NVRAM_OK) ? count : 0;
+    }
+    else
+    {
+        error += (path == 2) && (Bsp_Nvram_Begin() != NVRAM_OK);
+        for (uint32_t k = 0; k < count; k++)
+        {
+            error += ((path == 2) ? Nvram_Drv.Write(addr[k], value[k])
+                                  : EEP_EMUL_Write(addr[k], value[k])) != NVRAM_OK;
+        }
+        error += (path == 2) && (Bsp_Nvram_Commit() != NVRAM_OK);
+    }
+
+    for (uint32_t k = 0; (k < count) && (error == 0); k++)
+    {
+        Bench_Value[(first + k) % NB_OF_VARIABLES] = value[k];
+    }
+    return error;
+}
+
+/*!@brief Compare calibration set write paths.
+ */
+static void Bench_runTx(void)
+{
+    const char *name[] = {"Write", "Tx", "Commit"};
+    uint32_t    error  = 0;
+    uint32_t    value[BENCH_TX_VARS];
+
+    printf("\nTransaction: %u sets of %u variables\n", BENCH_TX_SETS, BENCH_TX_VARS);
+    printf("Path    |   Sets |  Dword | PErase | Unlock | Flash(ms) | Set(ms) | Max(ms)\n");
+
+    for (uint8_t path = 0; path < 3; path++)
+    {
+        uint64_t total = 0;
+        uint64_t max   = 0;
+
+        FlashSim_ResetStat();
+        HalSim_Seed(0xCA1B);
+        for (uint32_t set = 0; set < BENCH_TX_SETS; set++)
+        {
+            uint64_t time = HalSim_GetTime();
+            error += Bench_txSet(path, HalSim_Rand() % NB_OF_VARIABLES, BENCH_TX_VARS, value);
+            time = HalSim_GetTime() - time;
+            total += time;
+            max = (time > max) ? time : max;
+
+            Bsp_Nvram_Task();
+            HAL_Delay(BENCH_WRITE_PERIOD_MS);
+        }
+        error += Bench_verify(-1, 0);
+
+        printf("%-8s| %6u | %6u | %6u | %6u | %9.1f | %7.2f | %7.2f\n", name[path], BENCH_TX_SETS,
+               FlashSim_Stat.DwordCount, FlashSim_Stat.PageErase, FlashSim_Stat.UnlockCount,
+               FlashSim_Stat.BusyTime / 1000.0, total / 1000.0 / BENCH_TX_SETS, max / 1000.0);
+    }
+    printf("Verify  : %s\n", error ? "FAIL" : "PASS");
+}
+
+/*!@brief Compare a table written as variables and as one blob, whole table or few entries
+ *        changed per write.
+ */
+static void Bench_runBlob(void)
+{
+    const char *name[]  = {"Vars", "Blob"};
+    const char *table[] = {"Full", "Patch"};
+    uint32_t    error   = 0;
+    uint8_t     data[BENCH_BLOB_SIZE];
+    uint8_t     base[BENCH_BLOB_SIZE];
+
+    printf("\nBlob: %u writes of a %u bytes table, whole or %u entries changed\n",
+           BENCH_BLOB_WRITES, BENCH_BLOB_SIZE, BENCH_BLOB_PATCH);
+    printf("Table | Path | Writes |  Dword | PErase | Unlock | Flash(ms) | Write(ms) | Max(ms)\n");
+
+    for (uint8_t patch = 0; patch < 2; patch++)
+    {
+        for (uint8_t blob = 0; blob < 2; blob++)
+        {
+            uint64_t total = 0;
+            uint64_t max   = 0;
+
+            // Both paths hold the table of the end of full workload before patch one.
+            if (patch)
+            {
+                memcpy(data, base, BENCH_BLOB_SIZE);
+            }
+            FlashSim_ResetStat();
+            HalSim_Seed(0xB10B);
+            for (uint32_t n = 0; n < BENCH_BLOB_WRITES; n++)
+            {
+                uint32_t var[BENCH_BLOB_SIZE / 4];
+                uint32_t count = patch ? BENCH_BLOB_PATCH : BENCH_BLOB_SIZE / 4;
+
+                // Entries changed by this write, a variable each in the variables path.
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    var[i] = patch ? HalSim_Rand() % (BENCH_BLOB_SIZE / 4) : i;
+                    for (uint32_t b = 0; b < 4; b++)
+                    {
+                        data[var[i] * 4 + b] = HalSim_Rand();
+                    }
+                }
+
+                uint64_t time = HalSim_GetTime();
+                if (blob)
+                {
+                    error += EEP_EMUL_WriteEx(0, data, BENCH_BLOB_SIZE) != NVRAM_OK;
+                }
+                else
+                {
+                    for (uint32_t i = 0; i < count; i++)
+                    {
+                        memcpy(&Bench_Value[var[i]], &data[var[i] * 4], 4);
+                        error += EEP_EMUL_Write(EEP_EMUL_VirtualTab[var[i]], Bench_Value[var[i]]) !=
+                                 NVRAM_OK;
+                    }
+                }
+                time = HalSim_GetTime() - time;
+                total += time;
+                max = (time > max) ? time : max;
+
+                Bsp_Nvram_Task();
+                HAL_Delay(BENCH_WRITE_PERIOD_MS);
+            }
+
+            if (!patch)
+            {
+                memcpy(base, data, BENCH_BLOB_SIZE);
+            }
+            if (blob)
+            {
+                Bench_Blob[0].Length = BENCH_BLOB_SIZE;
+                memcpy(Bench_Blob[0].Data, data, BENCH_BLOB_SIZE);
+            }
+            error += Bench_verify(-1, 0) + Bench_verifyBlob();
+
+            printf("%-5s | %-4s | %6u | %6u | %6u | %6u | %9.1f | %9.2f | %7.2f\n", table[patch],
+                   name[blob], BENCH_BLOB_WRITES, FlashSim_Stat.DwordCount,
+                   FlashSim_Stat.PageErase, FlashSim_Stat.UnlockCount,
+                   FlashSim_Stat.BusyTime / 1000.0, total / 1000.0 / BENCH_BLOB_WRITES,
+                   max / 1000.0);
+        }
+    }
+    printf("Verify  : %s\n", error ? "FAIL" : "PASS");
+}
+
+static Dfu_ProtoTypeDef Bench_Reply; //!< Decoder of DFU replies
+
+static void Bench_replyTx(const uint8_t *buf, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        Dfu_protoDecodeByte(&Bench_Reply, buf[i], 0);
+    }
+}
+
+/*!@brief Check wear counters of a workload against the flash simulation.
+ *
+ * @param start : Telemetry before the workload.
+ * @param tm    : Telemetry after the workload.
+ * @param writes: Variable writes of the workload.
+ * @return Number of mismatches.
+ */
+static uint32_t Bench_wearCheck(const Wear_TelemetryTypeDef *start, const Wear_TelemetryTypeDef *tm,
+                                uint32_t writes)
+{
+    uint32_t erase = 0;
+
+    for (uint32_t i = 0; i < PAGES_NUMBER; i++)
+    {
+        erase += tm->Record.EmulErase[i] - start->Record.EmulErase[i];
+    }
+    return (erase != FlashSim_Stat.PageErase) +
+           (tm->Record.PhysicalWrite - start->Record.PhysicalWrite != FlashSim_Stat.DwordCount) +
+           (tm->Record.LogicalWrite - start->Record.LogicalWrite != writes);
+}
+
+/*!@brief Send a WEAR frame, the reply payload is the telemetry.
+ *
+ * @return Number of errors in the reply.
+ */
+static uint32_t Bench_wearReply(Wear_TelemetryTypeDef *tm)
+{
+    Dfu_protoInit(&Bench_Reply);
+    HalSim_UartTxHook      = Bench_replyTx;
+    Dfu_Proto.Frame.Cmd    = DFU_PROTO_CMD_WEAR;
+    Dfu_Proto.Frame.Length = 0;
+    Dfu_protoExcuteFrame(&Dfu_Proto);
+    HalSim_UartTxHook = NULL;
+    memcpy(tm, Bench_Reply.Frame.Payload, sizeof(*tm));
+
+    return (Bench_Reply.Frame.Cmd != DFU_PROTO_CMD_ACK) ||
+           (Bench_Reply.Frame.Length != sizeof(Wear_TelemetryTypeDef));
+}
+
+static void Bench_runWear(void)
+{
+    const char *          name[]  = {"Random", "Counter"};
+    Wear_TelemetryTypeDef start   = {0};
+    Wear_TelemetryTypeDef tm      = {0};
+    Wear_RecordTypeDef    saved   = {0};
+    uint32_t              error   = 0;
+    uint32_t              pending = 0;
+    uint32_t              banks   = sizeof(tm.Record.BankErase);
+
+    // DFU window at boot replies before NVRAM is up, without saved counters nor flash access.
+    Bsp_Nvram_DeInit();
+    Bsp_Wear_Init();
+    FlashSim_ResetStat();
+    error += Bench_wearReply(&tm);
+    error += (tm.Record.Magic != 0) || FlashSim_Stat.DwordCount || FlashSim_Stat.PageErase;
+    error += Bsp_Nvram_Init() != NVRAM_OK;
+
+    Bsp_Wear_Init();
+    printf("\nWear: %u bytes record, saved every %u erases\n", (uint32_t)sizeof(Wear_RecordTypeDef),
+           WEAR_SAVE_ERASES);
+    printf("Workload |  Writes |  Dword | PErase | WriteAmp | Max erase | Life(days)\n");
+
+    for (uint8_t path = 0; path < 2; path++)
+    {
+        Bsp_Wear_Get(&start);
+        FlashSim_ResetStat();
+        HalSim_Seed(0x3EA2);
+        for (uint32_t i = 0; i < BENCH_WEAR_WRITES; i++)
+        {
+            uint32_t var   = path ? 1 : HalSim_Rand() % NB_OF_VARIABLES;
+            uint32_t value = HalSim_Rand();
+
+            error += Nvram_Drv.Write(EEP_EMUL_VirtualTab[var], value) != NVRAM_OK;
+            Bench_Value[var] = value;
+            Bsp_Nvram_Task();
+            Bsp_Wear_Task();
+            HAL_Delay(BENCH_WRITE_PERIOD_MS);
+        }
+        Bsp_Nvram_Flush();
+        Bsp_Wear_Get(&tm);
+        error += Bench_wearCheck(&start, &tm, BENCH_WEAR_WRITES) + Bench_verify(-1, 0);
+
+        uint32_t logical = tm.Record.LogicalWrite - start.Record.LogicalWrite;
+        uint32_t dword   = tm.Record.PhysicalWrite - start.Record.PhysicalWrite;
+        printf("%-9s| %7u | %6u | %6u | %8.2f | %9u | %10u\n", name[path], logical, dword,
+               FlashSim_Stat.PageErase, (double)dword / logical, tm.EmulMax, tm.EmulLife);
+    }
+
+    // Record is written as blob NVRAM_EX_WEAR, read back what a reset would load.
+    FlashSim_ResetStat();
+    error += Bsp_Wear_Save() != NVRAM_OK;
+    uint32_t save = FlashSim_Stat.DwordCount;
+    Bsp_Wear_Get(&tm);
+    error += Nvram_Drv.ReadEx(NVRAM_EX_WEAR, (uint8_t *)&saved, sizeof(saved)) != NVRAM_OK;
+    // Dwords of the save itself are counted after it.
+    error += saved.PhysicalWrite + save != tm.Record.PhysicalWrite;
+    saved.OnTime        = tm.Record.OnTime;
+    saved.PhysicalWrite = tm.Record.PhysicalWrite;
+    error += memcmp(&saved, &tm.Record, sizeof(saved)) != 0;
+    printf("Save    : %u dwords, lifetime write amplification %u.%02u\n", save,
+           tm.WriteAmp / 100, tm.WriteAmp % 100);
+
+    // DFU erases 16 pages then the whole bank 2, groups of the 16 pages are erased twice.
+    Flash_erasePage(FLASH_BANK_2, 0, 2 * WEAR_GROUP_PAGES);
+    Flash_eraseBank(FLASH_BANK_2);
+    for (uint32_t i = 0; i < 2 * WEAR_GROUPS / 8; i++)
+    {
+        pending += HAL_RTCEx_BKUPRead(NULL, WEAR_BKP_REG + i) != 0;
+    }
+    Bsp_Wear_Get(&tm);
+    error += (tm.BankMax != 2) || (tm.Record.BankErase[1][2] != 1) ||
+             (tm.Record.BankErase[0][0] != 0) || (pending != WEAR_GROUPS / 8);
+
+    // WEAR frame once saved counters are loaded.
+    error += Bench_wearReply(&start);
+    error += (start.Record.Magic != WEAR_MAGIC) ||
+             (memcmp(start.Record.BankErase, tm.Record.BankErase, banks) != 0);
+
+    // Saved record takes the pending erases once.
+    error += Bsp_Wear_Save() != NVRAM_OK;
+    pending = 0;
+    for (uint32_t i = 0; i < 2 * WEAR_GROUPS / 8; i++)
+    {
+        pending += HAL_RTCEx_BKUPRead(NULL, WEAR_BKP_REG + i) != 0;
+    }
+    Bsp_Wear_Get(&start);
+    error += pending || (start.BankMax != 2) ||
+             (memcmp(start.Record.BankErase, tm.Record.BankErase, banks) != 0);
+    printf("DFU     : bank 2 groups erased up to %u, %u days left, WEAR reply %u bytes\n",
+           start.BankMax, start.BankLife, Bench_Reply.Frame.Length);
+
+    // Power loss phases check blobs, keep the record as expected content.
+    Bench_Blob[NVRAM_EX_WEAR].Length = sizeof(Wear_RecordTypeDef);
+    Nvram_Drv.ReadEx(NVRAM_EX_WEAR, Bench_Blob[NVRAM_EX_WEAR].Data, EE_BLOB_MAX_SIZE);
+    printf("Verify  : %s\n", error ? "FAIL" : "PASS");
+}
+
+static EE_Status Bench_powerUp(void);
+
+/*!@brief Load the config by a read per variable, as the boot loader did before snapshots.
+ *
+ * @return Number of values differing from Nvram_Config.
+ */
+static uint32_t Bench_loadConfig(void)
+{
+    uint32_t error = 0;
+
+    for (uint32_t addr = 0; addr < NVRAM_CONFIG_SIZE; addr++)
+    {
+        uint32_t value = 0;
+        uint8_t  found = Nvram_Drv.Read(addr, &value) == NVRAM_OK;
+        uint8_t  valid = (Nvram_Config.Valid[addr / 32] >> (addr % 32)) & 1;
+
+        error += (found != valid) || (found && (value != Nvram_Config.Value[addr]));
+    }
+    return error;
+}
+
+static void Bench_runBoot(void)
+{
+    const char *name[]  = {"Read", "Snapshot"};
+    double      load[4] = {0};
+    uint32_t    error   = 0;
+
+    FlashSim_ResetStat();
+    double init = HalSim_GetCpuTime();
+    error += Bench_powerUp() != EE_OK;
+    init = HalSim_GetCpuTime() - init;
+    error += Bsp_Nvram_LoadConfig() != NVRAM_OK;
+
+    printf("\nBoot: config of %u variables loaded after init, %u elements in flash\n",
+           NVRAM_CONFIG_SIZE, uhNbWrittenElements);
+    printf("Load     |  Reads | Load(us) | Boot to config(us)\n");
+
+    // [0] Read, scan [1] Snapshot, scan [2] Read, index [3] Snapshot, index
+    for (uint8_t path = 0; path < 4; path++)
+    {
+        uint8_t valid = ubIndexValid;
+
+        ubIndexValid = path / 2;
+        double cpu   = HalSim_GetCpuTime();
+        for (int i = 0; i < BENCH_READ_LOOP; i++)
+        {
+            if (path % 2)
+            {
+                error += Bsp_Nvram_LoadConfig() != NVRAM_OK;
+            }
+            else
+            {
+                error += Bench_loadConfig();
+            }
+        }
+        load[path]   = (HalSim_GetCpuTime() - cpu) * 1e6 / BENCH_READ_LOOP;
+        ubIndexValid = valid;
+
+        printf("%-9s| %6s | %8.1f | %8.1f\n", name[path % 2], (path / 2) ? "Index" : "Scan",
+               load[path], init * 1e6 + load[path]);
+    }
+
+    printf("Snapshot: %.1fx faster on scan, %.1fx on index\n", load[0] / load[1],
+           load[2] / load[3]);
+    printf("Verify  : %s\n", error ? "FAIL" : "PASS");
+}
+
+/*!@brief Init as EEP_EMUL_Init() does, RAM state of emulation is rebuilt from flash.
+ */
+static EE_Status Bench_reinit(void)
+{
+    uhNbWrittenElements = 0;
+    ubCurrentActivePage = 0;
+    uwAddressNextWrite  = PAGE_HEADER_SIZE;
+    ubIndexValid        = 0;
+
+    HAL_FLASH_Unlock();
+    EE_Status status = EE_Init((uint16_t *)EEP_EMUL_VirtualTab, EE_CONDITIONAL_ERASE);
+    HAL_FLASH_Lock();
+    return status;
+}
+
+/*!@brief Simulate a MCU reset, RAM state of emulation is lost, then init as EEP_EMUL_Init() does.
+ */
+static EE_Status Bench_powerUp(void)
+{
+    FlashSim_Reset();
+    return Bench_reinit();
+}
+
+/*!@brief CRC16 of data on the unit as EEPROM emulation runs it for a blob, Flash_crc32() of
+ *        another task may run after split bytes.
+ */
+static uint16_t Bench_crc16(const uint8_t *data, uint32_t len, uint32_t split)
+{
+    LL_CRC_ResetCRCCalculationUnit(CRC);
+    for (uint32_t i = 0; i < len; i++)
+    {
+        if (i == split)
+        {
+            Flash_crc32(START_PAGE_ADDRESS, BENCH_BLOB_SIZE);
+        }
+        LL_CRC_FeedData8(CRC, data[i]);
+    }
+    return LL_CRC_ReadData16(CRC);
+}
+
+/*!@brief Variable and blob writes interleaved with Flash_crc32() on the shared CRC unit, then
+ *        read back after a re-init and after a reset, which check the CRC of every element.
+ */
+static void Bench_runCrc(void)
+{
+    uint8_t  table[BENCH_BLOB_SIZE];
+    uint32_t error[3] = {0};
+    uint32_t len      = BENCH_AREA_SIZE - 3;
+
+    printf("\nCRC: %u writes interleaved with Flash_crc32()\n", BENCH_CRC_WRITES);
+
+    HalSim_Seed(0xC3C3);
+    for (uint32_t i = 0; i < BENCH_CRC_WRITES; i++)
+    {
+        uint32_t var   = HalSim_Rand() % NB_OF_VARIABLES;
+        uint32_t value = HalSim_Rand();
+
+        if (i % BENCH_LOSS_BLOB_PERIOD == 0)
+        {
+            for (uint32_t k = 0; k < BENCH_BLOB_SIZE; k++)
+            {
+                table[k] = HalSim_Rand();
+            }
+            error[0] += EEP_EMUL_WriteEx(0, table, BENCH_BLOB_SIZE) != NVRAM_OK;
+            error[0] += Bench_crc16(table, BENCH_BLOB_SIZE, BENCH_BLOB_SIZE / 2) !=
+                        Bench_crc16(table, BENCH_BLOB_SIZE, BENCH_BLOB_SIZE);
+            Bench_Blob[0].Length = BENCH_BLOB_SIZE;
+            memcpy(Bench_Blob[0].Data, table, BENCH_BLOB_SIZE);
+        }
+        error[0] += EEP_EMUL_Write(EEP_EMUL_VirtualTab[var], value) != NVRAM_OK;
+        Bench_Value[var] = value;
+
+        // Odd length, the last bytes are done in software.
+        error[0] += Flash_crc32(START_PAGE_ADDRESS, len) !=
+                    Dfu_crc32(0, (const uint8_t *)START_PAGE_ADDRESS, len);
+        Bsp_Nvram_Task();
+        HAL_Delay(BENCH_WRITE_PERIOD_MS);
+    }
+    error[0] += Bench_verify(-1, 0) + Bench_verifyBlob();
+    error[1] = (Bench_reinit() != EE_OK) + Bench_verify(-1, 0) + Bench_verifyBlob();
+    error[2] = (Bench_powerUp() != EE_OK) + Bench_verify(-1, 0) + Bench_verifyBlob();
+    printf("Errors  : write %u, re-init %u, reset %u\n", error[0], error[1], error[2]);
+    printf("Verify  : %s\n", (error[0] + error[1] + error[2]) ? "FAIL" : "PASS");
+}
+
+/*!@brief Run the power loss workload, stop at the first failed write.
+ *
+ * @param tx        : [0] Variable writes, [1] Transactions of BENCH_TX_LOSS_VARS variables.
+ * @param pending   : Return the variable, or first variable of the set, being written at power
+ *                    loss, -1 for none.
+ * @param value     : Return the new value of pending variable, or values of the set.
+ * @return Number of steps of the workload.
+ */
+static uint32_t Bench_lossWorkload(uint8_t tx, int *pending, uint32_t *value)
+{
+    uint32_t step = FlashSim_Stat.StepCount;
+    uint32_t writes = tx ? BENCH_TX_LOSS_SETS : BENCH_LOSS_WRITES;
+
+    *pending          = -1;
+    Bench_BlobPending = -1;
+    for (uint32_t i = 0; (i < writes) && !FlashSim_PowerLost; i++)
+    {
+        uint32_t var = HalSim_Rand() % NB_OF_VARIABLES;
+
+        if (!tx && (i % BENCH_LOSS_BLOB_PERIOD == 0))
+        {
+            uint8_t id = (i / BENCH_LOSS_BLOB_PERIOD) % NB_OF_BLOBS;
+
+            // Every other round of blobs patches few bytes, data elements are partly kept.
+            if (((i / BENCH_LOSS_BLOB_PERIOD / NB_OF_BLOBS) % 2) && (Bench_Blob[id].Length != 0))
+            {
+                Bench_BlobNew = Bench_Blob[id];
+                for (uint32_t k = 0; k < BENCH_BLOB_PATCH; k++)
+                {
+                    Bench_BlobNew.Data[HalSim_Rand() % Bench_BlobNew.Length] = HalSim_Rand();
+                }
+            }
+            else
+            {
+                Bench_BlobNew.Length = 1 + var * (EE_BLOB_MAX_SIZE - 1) / (NB_OF_VARIABLES - 1);
+                for (uint32_t k = 0; k < Bench_BlobNew.Length; k++)
+                {
+                    Bench_BlobNew.Data[k] = HalSim_Rand();
+                }
+            }
+
+            if (EEP_EMUL_WriteEx(id, Bench_BlobNew.Data, Bench_BlobNew.Length) == NVRAM_OK)
+            {
+                Bench_Blob[id] = Bench_BlobNew;
+            }
+            else
+            {
+                Bench_BlobPending = id;
+            }
+        }
+        else if (tx)
+        {
+            *pending = Bench_txSet(1, var, BENCH_TX_LOSS_VARS, value) ? (int)var : -1;
+        }
+        else
+        {
+            uint32_t data = HalSim_Rand();
+
+            if (EEP_EMUL_Write(EEP_EMUL_VirtualTab[var], data) == NVRAM_OK)
+            {
+                Bench_Value[var] = data;
+            }
+            else
+            {
+                *pending = var;
+                *value   = data;
+            }
+        }
+        Bsp_Nvram_Task();
+    }
+    return FlashSim_Stat.StepCount - step;
+}
+
+/*!@brief Power up after a loss, variables and blobs must hold their old or new values.
+ *
+ * @param tx  : [0] Variable writes, [1] Transactions.
+ * @param var : Variable, or first variable of the set, being written at power loss.
+ * @param set : New value of the variable, or values of the set.
+ * @return [0] Recovered, [1] Init fail, [2] Data fail.
+ */
+static uint32_t Bench_lossCheck(uint8_t tx, int var, const uint32_t *set)
+{
+    if (Bench_powerUp() != EE_OK)
+    {
+        return 1;
+    }
+    if ((tx ? Bench_verifySet(var, BENCH_TX_LOSS_VARS, set) : Bench_verify(var, set[0])) +
+            Bench_verifyBlob() !=
+        0)
+    {
+        return 2;
+    }
+    return 0;
+}
+
+/*!@brief Inject a power loss at each step of the workload and check recovery. Recovery by
+ *        EE_Init() is then interrupted at each of its own steps (transfer, discard of an
+ *        incomplete transaction, erase), and must complete at next power up. Recovery is
+ *        cut after each loss of the transaction workload, and after 1 in
+ *        BENCH_LOSS_CUT_PERIOD of the write workload to bound the run time.
+ *
+ * @param tx : [0] Variable writes, [1] Transactions.
+ */
+static void Bench_runPowerLoss(uint8_t tx)
+{
+    uint32_t value[NB_OF_VARIABLES];
+    uint32_t set[BENCH_TX_LOSS_VARS];
+    static Bench_BlobTypeDef blob[NB_OF_BLOBS];
+    uint32_t fail_init = 0;
+    uint32_t fail_data = 0;
+    uint32_t fail_next = 0;
+    uint32_t cuts      = 0;
+    int      var       = -1;
+
+    // Dry run to count the steps, from a saved state.
+    memcpy(Bench_Area, (void *)START_PAGE_ADDRESS, BENCH_AREA_SIZE);
+    memcpy(value, Bench_Value, sizeof(value));
+    memcpy(blob, Bench_Blob, sizeof(blob));
+    Bench_powerUp();
+    HalSim_Seed(0xC0FFEE);
+    uint32_t steps = Bench_lossWorkload(tx, &var, set);
+
+    double cpu = HalSim_GetCpuTime();
+    for (uint32_t loss = 1; loss <= steps; loss++)
+    {
+        memcpy((void *)START_PAGE_ADDRESS, Bench_Area, BENCH_AREA_SIZE);
+        memcpy(Bench_Value, value, sizeof(value));
+        memcpy(Bench_Blob, blob, sizeof(blob));
+        Bench_powerUp();
+
+        HalSim_Seed(0xC0FFEE);
+        FlashSim_PowerLoss(FlashSim_Stat.StepCount + loss, loss);
+        Bench_lossWorkload(tx, &var, set);
+        FlashSim_PowerLoss(0, 0);
+
+        // Dry recovery to count its steps, then a power loss at each of them.
+        memcpy(Bench_Lost, (void *)START_PAGE_ADDRESS, BENCH_AREA_SIZE);
+        uint32_t step = FlashSim_Stat.StepCount;
+        Bench_powerUp();
+        uint32_t recovery = FlashSim_Stat.StepCount - step;
+        uint32_t fail     = 0;
+
+        if (!tx && (loss % BENCH_LOSS_CUT_PERIOD))
+        {
+            recovery = 0;
+        }
+
+        for (uint32_t cut = 1; (cut <= recovery) && !fail; cut++)
+        {
+            memcpy((void *)START_PAGE_ADDRESS, Bench_Lost, BENCH_AREA_SIZE);
+            FlashSim_PowerLoss(FlashSim_Stat.StepCount + cut, loss + cut);
+            Bench_powerUp();
+            FlashSim_PowerLoss(0, 0);
+            fail = Bench_lossCheck(tx, var, set);
+            cuts++;
+        }
+
+        memcpy((void *)START_PAGE_ADDRESS, Bench_Lost, BENCH_AREA_SIZE);
+        fail      = fail ? fail : Bench_lossCheck(tx, var, set);
+        fail_init += (fail == 1);
+        fail_data += (fail == 2);
+        if (fail)
+        {
+            continue;
+        }
+
+        // Emulation is still usable after recovery.
+        uint64_t max = 0;
+        if (Bench_write(1, (var >= 0) ? var : 0, &max) + Bench_verify(-1, 0) != 0)
+        {
+            fail_next++;
+        }
+    }
+    cpu = HalSim_GetCpuTime() - cpu;
+
+    printf("\nPower loss: %u %s, %u steps, %u recovery steps, %.0f ms\n",
+           tx ? BENCH_TX_LOSS_SETS : BENCH_LOSS_WRITES, tx ? "transactions" : "writes", steps, cuts,
+           cpu * 1000);
+    printf("Init fail : %u\nData fail : %u\nNext fail : %u\n%s\n", fail_init, fail_data,
+           fail_next, (fail_init + fail_data + fail_next) ? "FAIL" : "PASS");
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t writes = (argc > 1) ? atoi(argv[1]) : BENCH_WRITES;
+
+    if ((argc > 2) && (strcmp(argv[2], "max") == 0))
+    {
+        FlashSim_Timing.Dword     = FLASH_SIM_TIME_DWORD_MAX;
+        FlashSim_Timing.Row       = FLASH_SIM_TIME_ROW_MAX;
+        FlashSim_Timing.PageErase = FLASH_SIM_TIME_PAGE_ERASE_MAX;
+        FlashSim_Timing.MassErase = FLASH_SIM_TIME_MASS_ERASE_MAX;
+    }
+
+    if (FlashSim_Init() != 0)
+    {
+        return -1;
+    }
+    Bench_Area = malloc(BENCH_AREA_SIZE);
+    Bench_Lost = malloc(BENCH_AREA_SIZE);
+    Bench_Time = malloc((writes + NB_OF_VARIABLES) * sizeof(uint32_t));
+
+    printf("EEPROM : %u variables, %u pages @ 0x%08X, %s timing\n", NB_OF_VARIABLES,
+           (uint32_t)PAGES_NUMBER, START_PAGE_ADDRESS, (argc > 2) ? argv[2] : "typ");
+    printf("Phase   |  Count |  Dword | PErase | Flash(ms) | Max(ms) |  CPU(ms)\n");
+
+    uint64_t max   = 0;
+    uint32_t error = 0;
+    double   cpu   = 0;
+
+    // Format on a blank flash, as first boot.
+    FlashSim_ResetStat();
+    cpu = HalSim_GetCpuTime();
+    Bsp_Nvram_Init();
+    cpu = HalSim_GetCpuTime() - cpu;
+    Bench_report("Format", 1, FlashSim_Stat.BusyTime, cpu);
+
+    FlashSim_ResetStat();
+    cpu = HalSim_GetCpuTime();
+    error += Bench_write(NB_OF_VARIABLES, 0, &max);
+    cpu = HalSim_GetCpuTime() - cpu;
+    Bench_report("Fill", NB_OF_VARIABLES, max, cpu);
+
+    FlashSim_ResetStat();
+    max = 0;
+    cpu = HalSim_GetCpuTime();
+    error += Bench_write(writes, -1, &max);
+    cpu = HalSim_GetCpuTime() - cpu;
+    Bench_report("Write", writes, max, cpu);
+    uint64_t wait = FlashSim_Stat.WaitTime;
+    qsort(Bench_Time, writes, sizeof(uint32_t), Bench_compare);
+
+    FlashSim_ResetStat();
+    double scan  = Bench_read(0, &error);
+    double index = Bench_read(1, &error);
+
+    FlashSim_ResetStat();
+    cpu = HalSim_GetCpuTime();
+    error += (Bench_powerUp() != EE_OK);
+    cpu = HalSim_GetCpuTime() - cpu;
+    Bench_report("Init", 1, FlashSim_Stat.BusyTime, cpu);
+    error += Bench_verify(-1, 0);
+    printf("Latency : p50 %u us, p99 %u us, p99.9 %u us, max %u us, erase wait %.1f ms\n",
+           Bench_Time[writes / 2], Bench_Time[writes * 99 / 100], Bench_Time[writes * 999 / 1000],
+           Bench_Time[writes - 1], wait / 1000.0);
+    printf("Read    : scan %.3f us, index %.3f us per variable, %.1fx\n", scan, index,
+           scan / index);
+    printf("Verify  : %s\n", error ? "FAIL" : "PASS");
+
+    Bench_runConfig();
+    Bench_runBoot();
+    Bench_runBlob();
+    Bench_runTx();
+    Bench_runWear();
+    Bench_runCrc();
+    Bench_runPowerLoss(0);
+    Bench_runPowerLoss(1);
+
+    return 0;
+}
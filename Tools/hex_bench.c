@@ -0,0 +1,170 @@
+/******************************************************************************
+ * @file    hex_bench.c
+ * @brief   Host benchmark of DFU Intel hex decoding, without flash programming.
+ *
+ *          Decode the same ihex stream with 2x methods and compare:
+ *          - Line  : gather line byte by byte like a line reader, then Hex_ParseLine().
+ *          - Stream: feed every byte to Hex_DecodeByte().
+ *
+ *          Usage: hex_bench [file.hex]
+ *          Without input file, a 1 MB pseudo random image is generated.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_image.h"
+#include "dfu_console.h"
+#include "hal_sim.h"
+
+// clang-format off
+#define BENCH_IMAGE_SIZE        (1024 * 1024)   //!< Size of generated image
+#define BENCH_TEXT_SIZE         (4 * 1024 * 1024)
+#define BENCH_LOOP              10              //!< Decode the stream N times
+// clang-format on
+
+static char    *Bench_Text = NULL;
+static uint32_t Bench_Len  = 0;
+
+/*!@struct Result of a decode run, used to check both methods decode the same content.
+ */
+typedef struct Bench_ResultTypeDef {
+    uint32_t Records;
+    uint32_t Errors;
+    uint32_t Bytes;
+    uint32_t Hash;
+} Bench_ResultTypeDef;
+
+static int Bench_loadFile(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "ERROR: can't open [%s]\n", path);
+        return -1;
+    }
+    Bench_Len = fread(Bench_Text, 1, BENCH_TEXT_SIZE - 1, fp);
+    fclose(fp);
+    return 0;
+}
+
+static void Bench_collect(Bench_ResultTypeDef *result, Dfu_HexLineTypeDefine *hexline)
+{
+    result->Records++;
+    result->Bytes += hexline->DataLength;
+    result->Hash = result->Hash * 31 + hexline->DataType + hexline->DataOffset;
+    for (int i = 0; i < hexline->DataLength; i++)
+    {
+        result->Hash = result->Hash * 31 + hexline->DataBuf[i];
+    }
+}
+
+/*!@brief Line method, same as the former console: buffer a line, then parse it.
+ */
+static void Bench_runLine(Bench_ResultTypeDef *result)
+{
+    Dfu_HexLineTypeDefine hexline                        = {0};
+    char                  linebuf[HEX_MAX_STRING_LENGTH] = {0};
+    int                   idx                            = 0;
+
+    for (uint32_t i = 0; i < Bench_Len; i++)
+    {
+        char c = Bench_Text[i];
+        if ((c == '\r') || (c == '\n'))
+        {
+            if (idx > 0)
+            {
+                if (Hex_ParseLine(linebuf, idx, &hexline) == DFU_OK)
+                {
+                    Bench_collect(result, &hexline);
+                }
+                else
+                {
+                    result->Errors++;
+                }
+                memset(linebuf, 0, idx);
+                idx = 0;
+            }
+        }
+        else if (idx < HEX_MAX_STRING_LENGTH - 1)
+        {
+            linebuf[idx++] = c;
+        }
+    }
+}
+
+/*!@brief Stream method, decode byte by byte.
+ */
+static void Bench_runStream(Bench_ResultTypeDef *result)
+{
+    Dfu_HexLineTypeDefine hexline = {0};
+    Hex_DecoderTypeDef    decoder;
+
+    Hex_DecoderInit(&decoder);
+    for (uint32_t i = 0; i < Bench_Len; i++)
+    {
+        DFU_RET ret = Hex_DecodeByte(&decoder, Bench_Text[i], &hexline);
+        if (ret == DFU_OK)
+        {
+            Bench_collect(result, &hexline);
+        }
+        else if (ret != DFU_BUSY)
+        {
+            result->Errors++;
+        }
+    }
+}
+
+static double Bench_run(const char *name, void (*run)(Bench_ResultTypeDef *),
+                        Bench_ResultTypeDef *result)
+{
+    double cpu = HalSim_GetCpuTime();
+    for (int loop = 0; loop < BENCH_LOOP; loop++)
+    {
+        memset(result, 0, sizeof(Bench_ResultTypeDef));
+        run(result);
+    }
+    cpu = (HalSim_GetCpuTime() - cpu) / BENCH_LOOP;
+
+    printf("%-8s| %8u | %6u | %8u | 0x%08X | %8.3f | %7.1f\n", name, result->Records,
+           result->Errors, result->Bytes, result->Hash, cpu * 1000, Bench_Len / cpu / 1e6);
+    return cpu;
+}
+
+int main(int argc, char *argv[])
+{
+    Bench_Text = malloc(BENCH_TEXT_SIZE);
+
+    if (argc > 1)
+    {
+        if (Bench_loadFile(argv[1]) != 0)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        uint8_t *image = malloc(BENCH_IMAGE_SIZE);
+        BenchImage_gen(image, BENCH_IMAGE_SIZE, 0x12345678);
+        Bench_Len = BenchImage_toHex(image, BENCH_IMAGE_SIZE, 0x08000000, Bench_Text);
+        free(image);
+    }
+
+    Bench_ResultTypeDef line   = {0};
+    Bench_ResultTypeDef stream = {0};
+
+    printf("Stream: %u bytes of ihex text\n", Bench_Len);
+    printf("Method  |  Records | Errors |    Bytes |       Hash |  CPU(ms) |    MB/s\n");
+    double t_line   = Bench_run("Line", Bench_runLine, &line);
+    double t_stream = Bench_run("Stream", Bench_runStream, &stream);
+
+    int same = (memcmp(&line, &stream, sizeof(Bench_ResultTypeDef)) == 0);
+    printf("Speed up: %.2fx, Result: %s\n", t_line / t_stream, same ? "MATCH" : "MISMATCH");
+
+    return same ? 0 : -1;
+}
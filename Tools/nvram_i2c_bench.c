@@ -0,0 +1,626 @@
+/******************************************************************************
+ * @file    nvram_i2c_bench.c
+ * @brief   Host benchmark of the I2C EEPROM NVRAM device (bsp_nvram_i2c.c on simulated M24256).
+ *
+ *          Latency: random variable writes and reads on the EEPROM emulation and on
+ *          the I2C EEPROM, each write committed to the device (I2C page buffer
+ *          flushed), latency percentiles and bytes/s.
+ *
+ *          Throughput: sequential dump of every variable (page loads by DMA),
+ *          random reads, multi-byte values written and read back (bulk DMA reads),
+ *          snapshot of every variable.
+ *
+ *          Batching: bursts of cached writes flushed through Bsp_Nvram_Flush(), page
+ *          writes per variable against the same writes passed to the device in
+ *          arrival order.
+ *
+ *          Acknowledge polling: back-to-back page writes, time of polling the end of
+ *          each write cycle against a fixed tW delay after each write.
+ *
+ *          Power loss: a workload of transactions and multi-byte values is repeated
+ *          with a power loss injected at each write cycle, then the device is
+ *          initialized and must hold all or none of the interrupted transaction, the
+ *          old or new data of the interrupted value, and last values of the others.
+ *
+ *          Usage: nvram_i2c_bench [writes] [typ|max]
+ *          writes is the random write count, default 2000. max uses maximum timing
+ *          of the datasheets instead of typical.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp_nvram.h"
+#include "bsp_nvram_i2c.h"
+#include "flash_sim.h"
+#include "hal_sim.h"
+#include "i2c_eeprom_sim.h"
+#include "stm32l4xx_hal.h"
+
+// clang-format off
+#define BENCH_WRITES            2000    //!< Default random write count
+#define BENCH_WRITE_PERIOD_MS   100     //!< Write period, device maintenance runs after each write
+#define BENCH_VARS              256     //!< Variables of write & power loss workloads
+#define BENCH_EX                4       //!< Multi-byte values, as many as emulation blobs
+#define BENCH_EX_SIZE           512     //!< Bytes of a multi-byte value, emulation blob max
+#define BENCH_BURSTS            200     //!< Cache bursts of batching phase
+#define BENCH_POLL_WRITES       200     //!< Page writes of acknowledge polling phase
+#define BENCH_LOSS_OPS          40      //!< Power loss workload, transactions and values
+#define BENCH_LOSS_TX_VARS      8       //!< Variables of a transaction
+// clang-format on
+
+extern const uint16_t EEP_EMUL_VirtualTab[];
+
+NVRAM_STATUS EEP_EMUL_Write(uint32_t addr, uint32_t value);
+NVRAM_STATUS EEP_EMUL_Read(uint32_t addr, uint32_t *value);
+NVRAM_STATUS EEP_EMUL_WriteEx(uint8_t reg, uint8_t *value, uint16_t len);
+NVRAM_STATUS EEP_EMUL_ReadEx(uint8_t reg, uint8_t *value, uint16_t len);
+
+typedef struct {
+    uint16_t Length; //!< 0 if never written
+    uint8_t  Data[NVRAM_EX_SIZE];
+} Bench_ExTypeDef;
+
+static uint32_t *Bench_Time = NULL; //!< Latency of each write in us
+static uint8_t   Bench_Area[I2C_EEP_SIZE]; //!< Saved device before power loss workload
+
+static uint32_t        Bench_Var[BENCH_VARS + 1]; //!< Expected value of variable 1 ~ BENCH_VARS
+static Bench_ExTypeDef Bench_Ex[I2C_EEP_EX_REGS]; //!< Expected multi-byte values
+static Bench_ExTypeDef Bench_ExNew;               //!< New data of the interrupted WriteEx()
+
+static int Bench_compare(const void *a, const void *b)
+{
+    return (*(uint32_t *)a > *(uint32_t *)b) - (*(uint32_t *)a < *(uint32_t *)b);
+}
+
+static NVRAM_STATUS Bench_devWrite(uint8_t i2c, uint32_t var, uint32_t value)
+{
+    if (!i2c)
+    {
+        return EEP_EMUL_Write(EEP_EMUL_VirtualTab[var], value);
+    }
+    return (I2C_EEP_Write(var + 1, value) == NVRAM_OK) ? I2C_EEP_Flush() : NVRAM_FAIL;
+}
+
+static NVRAM_STATUS Bench_devRead(uint8_t i2c, uint32_t var, uint32_t *value)
+{
+    return i2c ? I2C_EEP_Read(var + 1, value) : EEP_EMUL_Read(EEP_EMUL_VirtualTab[var], value);
+}
+
+/*!@brief Format bytes/s, internal flash reads take CPU time only, not simulated time.
+ */
+static const char *Bench_rate(uint64_t bytes, uint64_t us)
+{
+    static char text[4][16];
+    static int  n = 0;
+
+    n = (n + 1) % 4;
+    if (us == 0)
+    {
+        return "CPU bound";
+    }
+    snprintf(text[n], sizeof(text[n]), "%.0f", bytes * 1e6 / us);
+    return text[n];
+}
+
+/*!@brief Print percentiles of Bench_Time[0 ~ count-1].
+ */
+static void Bench_printTime(const char *name, const char *op, uint32_t count, uint64_t total)
+{
+    qsort(Bench_Time, count, sizeof(uint32_t), Bench_compare);
+    printf("%-5s %-5s | %8u | %8u | %8.2f | %s\n", name, op, Bench_Time[count / 2],
+           Bench_Time[count * 99 / 100], Bench_Time[count - 1] / 1000.0,
+           Bench_rate(count * 4, total));
+}
+
+/*!@brief Random writes then random reads of variables, each write committed to the device.
+ */
+static void Bench_runLatency(uint32_t writes)
+{
+    const char *name[] = {"EMUL", "I2C"};
+    uint32_t    error  = 0;
+
+    printf("\nLatency: %u random writes then reads of %u variables, maintenance after each\n",
+           writes, BENCH_VARS);
+    printf("Device      |  p50(us) |  p99(us) |  Max(ms) | Bytes/s\n");
+
+    for (uint8_t i2c = 0; i2c < 2; i2c++)
+    {
+        uint64_t total = 0;
+
+        HalSim_Seed(0x5EED);
+        for (uint32_t i = 0; i < writes; i++)
+        {
+            uint32_t var   = HalSim_Rand() % BENCH_VARS;
+            uint32_t value = HalSim_Rand();
+            uint64_t time  = HalSim_GetTime();
+
+            error += Bench_devWrite(i2c, var, value) != NVRAM_OK;
+            Bench_Time[i] = HalSim_GetTime() - time;
+            total += Bench_Time[i];
+            Bench_Var[var + 1] = value;
+
+            if (i2c)
+            {
+                I2C_EEP_Clean();
+            }
+            else
+            {
+                Bsp_Nvram_Task();
+            }
+            HAL_Delay(BENCH_WRITE_PERIOD_MS);
+        }
+        Bench_printTime(name[i2c], "write", writes, total);
+
+        total = 0;
+        for (uint32_t i = 0; i < writes; i++)
+        {
+            uint32_t var   = HalSim_Rand() % BENCH_VARS;
+            uint32_t value = 0;
+            uint64_t time  = HalSim_GetTime();
+
+            error += (Bench_devRead(i2c, var, &value) != NVRAM_OK) || (value != Bench_Var[var + 1]);
+            Bench_Time[i] = HalSim_GetTime() - time;
+            total += Bench_Time[i];
+        }
+        Bench_printTime(name[i2c], "read", writes, total);
+    }
+    printf("Verify  : %s\n", error ? "FAIL" : "PASS");
+}
+
+/*!@brief Dump, random reads and multi-byte values, bytes/s.
+ */
+static void Bench_runThroughput(void)
+{
+    static uint8_t data[BENCH_EX_SIZE];
+    static uint8_t read[BENCH_EX_SIZE];
+    uint32_t       error = 0;
+    uint32_t       value = 0;
+    uint64_t       time;
+
+    printf("\nThroughput: bytes/s, %u x %u bytes multi-byte values\n", BENCH_EX, BENCH_EX_SIZE);
+    printf("Device |      Dump |    Random |   WriteEx |    ReadEx | DMA reads\n");
+
+    for (uint8_t i2c = 0; i2c < 2; i2c++)
+    {
+        uint64_t us[4];
+        uint32_t dma = I2C_EEP_Stat.DmaRead;
+
+        // Dump of every variable in address order, then as many random reads.
+        time = HalSim_GetTime();
+        for (uint32_t var = 0; var < BENCH_VARS; var++)
+        {
+            error += (Bench_devRead(i2c, var, &value) != NVRAM_OK) || (value != Bench_Var[var + 1]);
+        }
+        us[0] = HalSim_GetTime() - time;
+
+        time = HalSim_GetTime();
+        for (uint32_t i = 0; i < BENCH_VARS; i++)
+        {
+            uint32_t var = HalSim_Rand() % BENCH_VARS;
+            error += (Bench_devRead(i2c, var, &value) != NVRAM_OK) || (value != Bench_Var[var + 1]);
+        }
+        us[1] = HalSim_GetTime() - time;
+
+        time = HalSim_GetTime();
+        for (uint8_t reg = 0; reg < BENCH_EX; reg++)
+        {
+            memset(data, 0xA0 + reg, sizeof(data));
+            error += (i2c ? I2C_EEP_WriteEx(reg, data, sizeof(data))
+                          : EEP_EMUL_WriteEx(reg, data, sizeof(data))) != NVRAM_OK;
+        }
+        us[2] = HalSim_GetTime() - time;
+
+        time = HalSim_GetTime();
+        for (uint8_t reg = 0; reg < BENCH_EX; reg++)
+        {
+            memset(data, 0xA0 + reg, sizeof(data));
+            error += ((i2c ? I2C_EEP_ReadEx(reg, read, sizeof(read))
+                           : EEP_EMUL_ReadEx(reg, read, sizeof(read))) != NVRAM_OK) ||
+                     (memcmp(read, data, sizeof(data)) != 0);
+        }
+        us[3] = HalSim_GetTime() - time;
+
+        printf("%-7s| %9s | %9s | %9s | %9s | %u\n", i2c ? "I2C" : "EMUL",
+               Bench_rate(BENCH_VARS * 4, us[0]), Bench_rate(BENCH_VARS * 4, us[1]),
+               Bench_rate(BENCH_EX * BENCH_EX_SIZE, us[2]),
+               Bench_rate(BENCH_EX * BENCH_EX_SIZE, us[3]), i2c ? I2C_EEP_Stat.DmaRead - dma : 0);
+    }
+
+    // Every variable at once, bulk DMA reads of the slots.
+    uint32_t snap[BENCH_VARS];
+    uint32_t valid[BENCH_VARS / 32];
+    uint32_t dma = I2C_EEP_Stat.DmaRead;
+
+    time = HalSim_GetTime();
+    error += I2C_EEP_Snapshot(1, BENCH_VARS, snap, valid) != NVRAM_OK;
+    time = HalSim_GetTime() - time;
+    for (uint32_t var = 0; var < BENCH_VARS; var++)
+    {
+        error += !(valid[var / 32] & (1UL << (var % 32))) || (snap[var] != Bench_Var[var + 1]);
+    }
+    printf("Snapshot: %u variables in %.2f ms, %s bytes/s, %u DMA reads\n", BENCH_VARS,
+           time / 1000.0, Bench_rate(BENCH_VARS * 4, time), I2C_EEP_Stat.DmaRead - dma);
+    printf("Verify  : %s\n", error ? "FAIL" : "PASS");
+}
+
+/*!@brief Bursts of cache size writes, page writes per variable through the sorted cache flush
+ *        and in arrival order.
+ *
+ * @param span  : Variables 1 ~ span written by the bursts.
+ */
+static uint32_t Bench_batch(uint32_t span)
+{
+    uint32_t var[NVRAM_CACHE_SIZE];
+    uint32_t value[NVRAM_CACHE_SIZE];
+    uint32_t error = 0;
+    uint32_t page[2];
+    uint64_t time[2];
+    uint32_t count[2];
+
+    for (uint8_t sorted = 0; sorted < 2; sorted++)
+    {
+        uint32_t write = I2C_EEP_Stat.PageWrite;
+        uint64_t start = HalSim_GetTime();
+
+        count[sorted] = 0;
+        HalSim_Seed(0xBA7C + span);
+        for (uint32_t burst = 0; burst < BENCH_BURSTS; burst++)
+        {
+            for (uint32_t i = 0; i < NVRAM_CACHE_SIZE; i++)
+            {
+                var[i]   = 1 + HalSim_Rand() % span;
+                value[i] = HalSim_Rand();
+            }
+
+            for (uint32_t i = 0; i < NVRAM_CACHE_SIZE; i++)
+            {
+                error += (sorted ? Nvram_Drv.Write(var[i], value[i])
+                                 : I2C_EEP_Write(var[i], value[i])) != NVRAM_OK;
+                Bench_Var[var[i]] = value[i];
+            }
+            count[sorted] += NVRAM_CACHE_SIZE;
+            error += (sorted ? Bsp_Nvram_Flush() : I2C_EEP_Flush()) != NVRAM_OK;
+            HAL_Delay(BENCH_WRITE_PERIOD_MS);
+        }
+        page[sorted] = I2C_EEP_Stat.PageWrite - write;
+        time[sorted] = HalSim_GetTime() - start - BENCH_BURSTS * BENCH_WRITE_PERIOD_MS * 1000ULL;
+    }
+
+    printf("%5u  | %8.3f | %8.3f | %8.1f | %8.1f\n", span, (double)page[0] / count[0],
+           (double)page[1] / count[1], time[0] / 1000.0 / BENCH_BURSTS,
+           time[1] / 1000.0 / BENCH_BURSTS);
+
+    for (uint32_t addr = 1; addr <= span; addr++)
+    {
+        uint32_t read = 0;
+        error += (Bench_Var[addr] != 0) &&
+                 ((I2C_EEP_Read(addr, &read) != NVRAM_OK) || (read != Bench_Var[addr]));
+    }
+    return error;
+}
+
+static void Bench_runBatch(void)
+{
+    uint32_t error = 0;
+
+    printf("\nBatching: %u bursts of %u writes to variables 1 ~ span, flushed after each\n",
+           BENCH_BURSTS, NVRAM_CACHE_SIZE);
+    printf("Span   | Pages/var  Arrival |   Sorted | Arrival(ms) | Sorted(ms) per burst\n");
+
+    error += Bsp_Nvram_Select(NVRAM_DEV_I2C) != NVRAM_OK;
+    error += Bench_batch(64);
+    error += Bench_batch(BENCH_VARS);
+    error += Bench_batch(I2C_EEP_VARS - 1);
+    error += Bsp_Nvram_Select(NVRAM_DEV_EMUL) != NVRAM_OK;
+    printf("Verify  : %s\n", error ? "FAIL" : "PASS");
+}
+
+/*!@brief Back-to-back page writes, acknowledge polling against a fixed tW delay.
+ */
+static void Bench_runPolling(void)
+{
+    uint8_t  data[I2C_EEP_PAGE_SIZE];
+    uint32_t error = 0;
+
+    memset(data, 0x5A, sizeof(data));
+    I2cEepromSim_ResetStat();
+    memset(&I2C_EEP_Stat, 0, sizeof(I2C_EEP_Stat));
+
+    // Multi-byte values of 1 kB are page writes of the data, then the header.
+    uint64_t time = HalSim_GetTime();
+    while (I2C_EEP_Stat.PageWrite < BENCH_POLL_WRITES)
+    {
+        error += I2C_EEP_WriteEx(I2C_EEP_Stat.PageWrite % BENCH_EX, Bench_ExNew.Data,
+                                 NVRAM_EX_SIZE) != NVRAM_OK;
+    }
+    error += I2C_EEP_DeInit() != NVRAM_OK;
+    time = HalSim_GetTime() - time;
+
+    // Same transfers without polls, each write followed by a tW delay.
+    uint64_t clocks = 9 * (3ULL * I2cEepromSim_Stat.WriteCount + I2cEepromSim_Stat.WriteBytes) +
+                      9 * (4ULL * I2cEepromSim_Stat.ReadCount + I2cEepromSim_Stat.ReadBytes) +
+                      2ULL * (I2cEepromSim_Stat.WriteCount + I2cEepromSim_Stat.ReadCount);
+    uint64_t fixed  = clocks * 1000 / I2cEepromSim_Timing.ClockKhz +
+                     (uint64_t)I2cEepromSim_Stat.WriteCount * I2C_EEPROM_SIM_TIME_WRITE_MAX;
+
+    printf("\nPolling: %u page writes back to back, write cycle %u us\n",
+           I2cEepromSim_Stat.WriteCount, I2cEepromSim_Timing.Write);
+    printf("Polling : %8.1f ms, %u polls, max %u per write, %.0f bytes/s\n", time / 1000.0,
+           I2C_EEP_Stat.Poll, I2C_EEP_Stat.PollMax,
+           I2cEepromSim_Stat.WriteBytes * 1e6 / (time + 1));
+    printf("Fixed tW: %8.1f ms, %.0f bytes/s, %+.1f%% time of polling\n", fixed / 1000.0,
+           I2cEepromSim_Stat.WriteBytes * 1e6 / fixed, (fixed - (double)time) * 100 / time);
+    printf("Verify  : %s\n", error ? "FAIL" : "PASS");
+}
+
+/*!@brief Compare a multi-byte value read back with expected data, zero padded by ReadEx().
+ */
+static uint8_t Bench_exMatch(NVRAM_STATUS status, const uint8_t *data, const Bench_ExTypeDef *ex)
+{
+    if (ex->Length == 0)
+    {
+        return status != NVRAM_OK;
+    }
+
+    for (uint32_t i = ex->Length; i < NVRAM_EX_SIZE; i++)
+    {
+        if (data[i] != 0)
+        {
+            return 0;
+        }
+    }
+    return (status == NVRAM_OK) && (memcmp(data, ex->Data, ex->Length) == 0);
+}
+
+/*!@brief Read back every key of the power loss workload.
+ *
+ * @param var   : Variables of the interrupted transaction, may hold the new values.
+ * @param value : New values of the variables.
+ * @param count : Number of variables, 0 for none.
+ * @param ex    : Multi-byte value of the interrupted WriteEx(), -1 for none.
+ * @return Number of keys with wrong value, +1 if a transaction is partially written.
+ */
+static uint32_t Bench_verify(const uint32_t *var, const uint32_t *value, uint32_t count, int ex)
+{
+    uint8_t  data[NVRAM_EX_SIZE];
+    uint32_t error = 0;
+    uint32_t old   = 0;
+    uint32_t new   = 0;
+
+    for (uint32_t addr = 1; addr <= BENCH_VARS; addr++)
+    {
+        uint32_t read = 0;
+        int      k    = -1;
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            k = (var[i] == addr) ? (int)i : k;
+        }
+
+        if (I2C_EEP_Read(addr, &read) != NVRAM_OK)
+        {
+            read = 0;
+        }
+
+        if (k >= 0)
+        {
+            old += (read == Bench_Var[addr]);
+            new += (read == value[k]);
+            error += (read != Bench_Var[addr]) && (read != value[k]);
+        }
+        else
+        {
+            error += (read != Bench_Var[addr]);
+        }
+    }
+
+    for (int reg = 0; reg < I2C_EEP_EX_REGS; reg++)
+    {
+        NVRAM_STATUS status = I2C_EEP_ReadEx(reg, data, sizeof(data));
+
+        error += !Bench_exMatch(status, data, &Bench_Ex[reg]) &&
+                 !((reg == ex) && Bench_exMatch(status, data, &Bench_ExNew));
+    }
+
+    return error + ((count > 0) && (old < count) && (new < count));
+}
+
+/*!@brief Run the power loss workload, stop at the first failed write.
+ *
+ * @param var   : Return the variables being written at power loss.
+ * @param value : Return the new values of the variables.
+ * @param ex    : Return the multi-byte value being written at power loss, -1 for none.
+ * @return Number of variables being written at power loss.
+ */
+static uint32_t Bench_lossWorkload(uint32_t *var, uint32_t *value, int *ex)
+{
+    *ex = -1;
+    for (uint32_t i = 0; (i < BENCH_LOSS_OPS) && !I2cEepromSim_PowerLost; i++)
+    {
+        if (i % 2)
+        {
+            uint8_t reg        = (i / 2) % I2C_EEP_EX_REGS;
+            Bench_ExNew.Length = 1 + HalSim_Rand() % NVRAM_EX_SIZE;
+            for (uint32_t k = 0; k < Bench_ExNew.Length; k++)
+            {
+                Bench_ExNew.Data[k] = HalSim_Rand();
+            }
+
+            if (I2C_EEP_WriteEx(reg, Bench_ExNew.Data, Bench_ExNew.Length) != NVRAM_OK)
+            {
+                *ex = reg;
+                return 0;
+            }
+            Bench_Ex[reg] = Bench_ExNew;
+        }
+        else
+        {
+            // Neighbour variables, pages of the transaction hold nothing else it can tear.
+            uint32_t addr = 1 + HalSim_Rand() % (BENCH_VARS - BENCH_LOSS_TX_VARS);
+
+            for (uint32_t k = 0; k < BENCH_LOSS_TX_VARS; k++)
+            {
+                var[k]   = addr + k;
+                value[k] = HalSim_Rand();
+            }
+
+            if (I2C_EEP_WriteTx(var, value, BENCH_LOSS_TX_VARS) != NVRAM_OK)
+            {
+                return BENCH_LOSS_TX_VARS;
+            }
+            for (uint32_t k = 0; k < BENCH_LOSS_TX_VARS; k++)
+            {
+                Bench_Var[var[k]] = value[k];
+            }
+        }
+    }
+    return 0;
+}
+
+/*!@brief Simulate a MCU reset, RAM state of the device driver is lost, then init.
+ */
+static NVRAM_STATUS Bench_powerUp(void)
+{
+    I2cEepromSim_Reset();
+    return I2C_EEP_Init();
+}
+
+/*!@brief Inject a power loss at each write cycle of the workload and check recovery.
+ */
+static void Bench_runPowerLoss(void)
+{
+    static uint32_t        saved_var[BENCH_VARS + 1];
+    static Bench_ExTypeDef saved_ex[I2C_EEP_EX_REGS];
+    uint32_t               var[BENCH_LOSS_TX_VARS];
+    uint32_t               value[BENCH_LOSS_TX_VARS];
+    uint32_t               fail_init = 0;
+    uint32_t               fail_data = 0;
+    uint32_t               fail_next = 0;
+    int                    ex        = -1;
+
+    // Every key of the workload holds a value before it starts.
+    I2cEepromSim_EraseAll();
+    I2C_EEP_Init();
+    memset(Bench_Var, 0, sizeof(Bench_Var));
+    memset(Bench_Ex, 0, sizeof(Bench_Ex));
+    HalSim_Seed(0xF111);
+    for (uint32_t addr = 1; addr <= BENCH_VARS; addr++)
+    {
+        Bench_Var[addr] = HalSim_Rand();
+        I2C_EEP_Write(addr, Bench_Var[addr]);
+    }
+    for (uint8_t reg = 0; reg < I2C_EEP_EX_REGS; reg++)
+    {
+        Bench_Ex[reg].Length = 1 + HalSim_Rand() % NVRAM_EX_SIZE;
+        memset(Bench_Ex[reg].Data, reg, Bench_Ex[reg].Length);
+        I2C_EEP_WriteEx(reg, Bench_Ex[reg].Data, Bench_Ex[reg].Length);
+    }
+    I2C_EEP_DeInit();
+    memcpy(Bench_Area, I2cEepromSim_Memory(0), I2C_EEP_SIZE);
+    memcpy(saved_var, Bench_Var, sizeof(saved_var));
+    memcpy(saved_ex, Bench_Ex, sizeof(saved_ex));
+
+    // Dry run to count the steps.
+    Bench_powerUp();
+    uint32_t step = I2cEepromSim_Stat.StepCount;
+    HalSim_Seed(0xC0FFEE);
+    Bench_lossWorkload(var, value, &ex);
+    uint32_t steps = I2cEepromSim_Stat.StepCount - step;
+
+    double cpu = HalSim_GetCpuTime();
+    for (uint32_t loss = 1; loss <= steps; loss++)
+    {
+        memcpy(I2cEepromSim_Memory(0), Bench_Area, I2C_EEP_SIZE);
+        memcpy(Bench_Var, saved_var, sizeof(saved_var));
+        memcpy(Bench_Ex, saved_ex, sizeof(saved_ex));
+        Bench_powerUp();
+
+        HalSim_Seed(0xC0FFEE);
+        I2cEepromSim_PowerLoss(I2cEepromSim_Stat.StepCount + loss, loss);
+        uint32_t count = Bench_lossWorkload(var, value, &ex);
+        I2cEepromSim_PowerLoss(0, 0);
+
+        if (Bench_powerUp() != NVRAM_OK)
+        {
+            fail_init++;
+            continue;
+        }
+
+        if (Bench_verify(var, value, count, ex) != 0)
+        {
+            fail_data++;
+            continue;
+        }
+
+        // Device is still usable after recovery.
+        for (uint32_t k = 0; k < count; k++)
+        {
+            uint32_t read = 0;
+            I2C_EEP_Read(var[k], &read);
+            Bench_Var[var[k]] = read;
+        }
+        if (ex >= 0)
+        {
+            I2C_EEP_WriteEx(ex, Bench_ExNew.Data, Bench_ExNew.Length);
+            Bench_Ex[ex] = Bench_ExNew;
+        }
+        Bench_Var[1] = loss;
+        if ((I2C_EEP_Write(1, loss) != NVRAM_OK) || (I2C_EEP_DeInit() != NVRAM_OK) ||
+            (Bench_powerUp() != NVRAM_OK) || (Bench_verify(NULL, NULL, 0, -1) != 0))
+        {
+            fail_next++;
+        }
+    }
+    cpu = HalSim_GetCpuTime() - cpu;
+
+    printf("\nPower loss: %u transactions & values, %u steps, %u replayed, %.0f ms\n",
+           BENCH_LOSS_OPS, steps, I2C_EEP_Stat.Replay, cpu * 1000);
+    printf("Init fail : %u\nData fail : %u\nNext fail : %u\n%s\n", fail_init, fail_data,
+           fail_next, (fail_init + fail_data + fail_next + (I2C_EEP_Stat.Replay == 0)) ? "FAIL"
+                                                                                        : "PASS");
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t writes = (argc > 1) ? atoi(argv[1]) : BENCH_WRITES;
+
+    if ((argc > 2) && (strcmp(argv[2], "max") == 0))
+    {
+        FlashSim_Timing.Dword     = FLASH_SIM_TIME_DWORD_MAX;
+        FlashSim_Timing.Row       = FLASH_SIM_TIME_ROW_MAX;
+        FlashSim_Timing.PageErase = FLASH_SIM_TIME_PAGE_ERASE_MAX;
+        FlashSim_Timing.MassErase = FLASH_SIM_TIME_MASS_ERASE_MAX;
+        I2cEepromSim_Timing.Write = I2C_EEPROM_SIM_TIME_WRITE_MAX;
+    }
+
+    if (FlashSim_Init() != 0)
+    {
+        return -1;
+    }
+    Bench_Time = malloc(writes * sizeof(uint32_t));
+
+    printf("I2C EEP : %u variables, %u x %u bytes values, %u bytes pages @ %u kHz, %s timing\n",
+           I2C_EEP_VARS - 1, I2C_EEP_EX_REGS, NVRAM_EX_SIZE, I2C_EEP_PAGE_SIZE,
+           I2cEepromSim_Timing.ClockKhz, (argc > 2) ? argv[2] : "typ");
+
+    // EEPROM emulation is bound by Bsp_Nvram_Init(), I2C EEPROM is driven directly.
+    Bsp_Nvram_Init();
+    if (I2C_EEP_Init() != NVRAM_OK)
+    {
+        return -1;
+    }
+
+    Bench_runLatency(writes);
+    Bench_runThroughput();
+    Bench_runBatch();
+    Bench_runPolling();
+    Bench_runPowerLoss();
+
+    return 0;
+}
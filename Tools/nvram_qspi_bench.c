@@ -0,0 +1,545 @@
+/******************************************************************************
+ * @file    nvram_qspi_bench.c
+ * @brief   Host benchmark of the QSPI NVRAM device (bsp_nvram_qspi.c on simulated N25Q128A).
+ *
+ *          Write: random variable writes on the EEPROM emulation and on the QSPI
+ *          key-value store, with device maintenance after each write. Internal flash
+ *          and QSPI busy time, write latency percentiles.
+ *
+ *          Capacity: every key of the index written, variables and 1 kB values.
+ *
+ *          Wear: random writes looping the store area several times over keys never
+ *          rewritten, erase count spread of its subsectors, records written per write, then mount time of
+ *          the full log.
+ *
+ *          Power loss: a workload of variables, transactions and multi-byte values
+ *          crossing garbage collection is repeated with a power loss injected at each
+ *          of its QSPI steps, then the store is mounted and every key must read its
+ *          last written value. The interrupted write may read its old or new value,
+ *          all or none of an interrupted transaction. Garbage collection runs in
+ *          background, then inline when writes find too few free subsectors.
+ *
+ *          Usage: nvram_qspi_bench [writes] [typ|max]
+ *          writes is the random write count, default 2000. max uses maximum timing
+ *          of the datasheets instead of typical.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp_nvram.h"
+#include "bsp_nvram_qspi.h"
+#include "bsp_qspi.h"
+#include "bsp_qspi_cache.h"
+#include "flash_sim.h"
+#include "hal_sim.h"
+#include "qspi_sim.h"
+#include "stm32l4xx_hal.h"
+
+// clang-format off
+#define BENCH_WRITES            2000    //!< Default random write count
+#define BENCH_WRITE_PERIOD_MS   100     //!< Write period, device maintenance runs after each write
+#define BENCH_VARS              256     //!< Variables of write & power loss workloads
+#define BENCH_EX                8       //!< Multi-byte values of power loss workload
+#define BENCH_WEAR_LAPS         4       //!< Store area written N times in wear phase
+#define BENCH_COLD              256     //!< Keys written once before wear phase
+#define BENCH_LOSS_WRITES       400     //!< Power loss workload
+#define BENCH_LOSS_PERIOD       16      //!< 1 in N writes is a multi-byte value, 1 in N a transaction
+#define BENCH_LOSS_TX_VARS      8       //!< Variables of a transaction
+// clang-format on
+
+extern const uint16_t EEP_EMUL_VirtualTab[];
+
+NVRAM_STATUS EEP_EMUL_Write(uint32_t addr, uint32_t value);
+
+typedef struct {
+    uint16_t Length; //!< 0 if never written
+    uint8_t  Data[NVRAM_EX_SIZE];
+} Bench_ExTypeDef;
+
+static uint32_t *Bench_Time = NULL; //!< Latency of each write in us
+static uint8_t * Bench_Area = NULL; //!< Saved store area before power loss workload
+
+static uint32_t        Bench_Var[BENCH_VARS + 1]; //!< Expected value of variable 1 ~ BENCH_VARS
+static Bench_ExTypeDef Bench_Ex[BENCH_EX];        //!< Expected multi-byte values
+static Bench_ExTypeDef Bench_ExNew;               //!< New data of the interrupted WriteEx()
+
+static int Bench_compare(const void *a, const void *b)
+{
+    return (*(uint32_t *)a > *(uint32_t *)b) - (*(uint32_t *)a < *(uint32_t *)b);
+}
+
+/*!@brief Random writes to a device, record latency.
+ *
+ * @param qspi  : [0] EEPROM emulation, [1] QSPI key-value store.
+ * @return Number of failed writes.
+ */
+static uint32_t Bench_write(uint8_t qspi, uint32_t count)
+{
+    uint32_t error = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t var   = HalSim_Rand() % BENCH_VARS;
+        uint32_t value = HalSim_Rand();
+        uint64_t time  = HalSim_GetTime();
+
+        error += (qspi ? QSPI_KV_Write(var + 1, value)
+                       : EEP_EMUL_Write(EEP_EMUL_VirtualTab[var], value)) != NVRAM_OK;
+        Bench_Time[i] = HalSim_GetTime() - time;
+        Bench_Var[var + 1] = value;
+
+        if (qspi)
+        {
+            QSPI_KV_Clean();
+        }
+        else
+        {
+            Bsp_Nvram_Task();
+        }
+        HAL_Delay(BENCH_WRITE_PERIOD_MS);
+    }
+    return error;
+}
+
+/*!@brief Compare a multi-byte value read back with expected data, zero padded by ReadEx().
+ */
+static uint8_t Bench_exMatch(NVRAM_STATUS status, const uint8_t *data, const Bench_ExTypeDef *ex)
+{
+    if (ex->Length == 0)
+    {
+        return status != NVRAM_OK;
+    }
+
+    for (uint32_t i = ex->Length; i < NVRAM_EX_SIZE; i++)
+    {
+        if (data[i] != 0)
+        {
+            return 0;
+        }
+    }
+    return (status == NVRAM_OK) && (memcmp(data, ex->Data, ex->Length) == 0);
+}
+
+/*!@brief Read back every key of the power loss workload.
+ *
+ * @param var   : Variables of the interrupted write or transaction, may hold the new values.
+ * @param value : New values of the variables.
+ * @param count : Number of variables, 0 for none.
+ * @param ex    : Multi-byte value of the interrupted WriteEx(), -1 for none.
+ * @return Number of keys with wrong value, +1 if a transaction is partially written.
+ */
+static uint32_t Bench_verify(const uint32_t *var, const uint32_t *value, uint32_t count, int ex)
+{
+    uint8_t  data[NVRAM_EX_SIZE];
+    uint32_t error = 0;
+    uint32_t old   = 0;
+    uint32_t new   = 0;
+
+    for (uint32_t addr = 1; addr <= BENCH_VARS; addr++)
+    {
+        uint32_t read = 0;
+        int      k    = -1;
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            k = (var[i] == addr) ? (int)i : k;
+        }
+
+        if ((QSPI_KV_Read(addr, &read) != NVRAM_OK) && (Bench_Var[addr] != 0))
+        {
+            error++;
+        }
+        else if (k >= 0)
+        {
+            old += (read == Bench_Var[addr]);
+            new += (read == value[k]);
+            error += (read != Bench_Var[addr]) && (read != value[k]);
+        }
+        else
+        {
+            error += (read != Bench_Var[addr]);
+        }
+    }
+
+    for (int reg = 0; reg < BENCH_EX; reg++)
+    {
+        NVRAM_STATUS status = QSPI_KV_ReadEx(reg, data, sizeof(data));
+
+        error += !Bench_exMatch(status, data, &Bench_Ex[reg]) &&
+                 !((reg == ex) && Bench_exMatch(status, data, &Bench_ExNew));
+    }
+
+    return error + ((count > 1) && (old < count) && (new < count));
+}
+
+static void Bench_runWrite(uint32_t writes)
+{
+    const char *name[] = {"EMUL", "QSPI"};
+    uint32_t    error  = 0;
+
+    printf("\nWrite: %u random writes of %u variables, maintenance after each\n", writes,
+           BENCH_VARS);
+    printf("Device  |  Flash(ms) |  QSPI(ms) |  p50(us) |  p99(us) | Max(ms)\n");
+
+    for (uint8_t qspi = 0; qspi < 2; qspi++)
+    {
+        if (qspi)
+        {
+            QSPI_KV_Erase();
+        }
+        FlashSim_ResetStat();
+        QspiSim_ResetStat();
+        HalSim_Seed(0x5EED);
+        error += Bench_write(qspi, writes);
+        qsort(Bench_Time, writes, sizeof(uint32_t), Bench_compare);
+
+        printf("%-8s| %10.1f | %9.1f | %8u | %8u | %7.2f\n", name[qspi],
+               FlashSim_Stat.BusyTime / 1000.0, QspiSim_Stat.BusyTime / 1000.0,
+               Bench_Time[writes / 2], Bench_Time[writes * 99 / 100],
+               Bench_Time[writes - 1] / 1000.0);
+    }
+
+    for (uint32_t addr = 1; addr <= BENCH_VARS; addr++)
+    {
+        uint32_t value = 0;
+        error += (QSPI_KV_Read(addr, &value) != NVRAM_OK) || (value != Bench_Var[addr]);
+    }
+    printf("Verify  : %s\n", error ? "FAIL" : "PASS");
+}
+
+/*!@brief Fill every key of the index, variables and values of QSPI_KV_VALUE_MAX bytes.
+ */
+static void Bench_runCapacity(void)
+{
+    static uint8_t data[QSPI_KV_VALUE_MAX];
+    static uint8_t read[QSPI_KV_VALUE_MAX];
+    uint32_t       vars  = QSPI_KV_MAX_KEYS - 256;
+    uint32_t       error = 0;
+
+    QSPI_KV_Erase();
+    for (uint32_t addr = 1; addr <= vars; addr++)
+    {
+        error += QSPI_KV_Write(addr, addr * 7) != NVRAM_OK;
+    }
+    for (uint32_t reg = 0; reg < 256; reg++)
+    {
+        memset(data, reg, sizeof(data));
+        error += QSPI_KV_WriteEx(reg, data, sizeof(data)) != NVRAM_OK;
+    }
+
+    // Index is full.
+    error += QSPI_KV_Write(vars + 1, 0) == NVRAM_OK;
+
+    QSPI_KV_Init();
+    for (uint32_t addr = 1; addr <= vars; addr++)
+    {
+        uint32_t value = 0;
+        error += (QSPI_KV_Read(addr, &value) != NVRAM_OK) || (value != addr * 7);
+    }
+    for (uint32_t reg = 0; reg < 256; reg++)
+    {
+        memset(data, reg, sizeof(data));
+        error += (QSPI_KV_ReadEx(reg, read, sizeof(read)) != NVRAM_OK) ||
+                 (memcmp(read, data, sizeof(data)) != 0);
+    }
+
+    printf("\nCapacity: %u variables + 256 values of %u bytes = %u kB, EMUL %u variables + %u "
+           "values of %u bytes = %u kB\n",
+           vars, QSPI_KV_VALUE_MAX, (vars * 4 + 256 * QSPI_KV_VALUE_MAX) / 1024, NB_OF_VARIABLES,
+           NB_OF_BLOBS, EE_BLOB_MAX_SIZE, (NB_OF_VARIABLES * 4 + NB_OF_BLOBS * EE_BLOB_MAX_SIZE) / 1024);
+    printf("Verify  : %s\n", error ? "FAIL" : "PASS");
+}
+
+/*!@brief Loop the store area, check erase count spread and mount time of a full log.
+ *        Cold keys written once are copied by garbage collection on each lap.
+ */
+static void Bench_runWear(void)
+{
+    uint32_t records = BENCH_WEAR_LAPS * QSPI_KV_SUBSECTORS * (QSPI_KV_SUBSECTOR_SIZE / 16);
+    uint32_t first   = QSPI_KV_BASE / QSPI_KV_SUBSECTOR_SIZE;
+    uint32_t min     = 0xFFFFFFFF;
+    uint32_t max     = 0;
+    uint32_t error   = 0;
+    uint32_t writes  = 0;
+
+    QspiSim_EraseAll();
+    Bsp_Qspi_CacheInvalidate(0, N25Q128A_FLASH_SIZE);
+    QspiSim_ResetStat();
+    QSPI_KV_Init();
+    memset(&QSPI_KV_Stat, 0, sizeof(QSPI_KV_Stat));
+    memset(Bench_Var, 0, sizeof(Bench_Var));
+    HalSim_Seed(0x3EA7);
+    for (uint32_t addr = BENCH_VARS + 1; addr <= BENCH_VARS + BENCH_COLD; addr++)
+    {
+        error += QSPI_KV_Write(addr, addr * 3) != NVRAM_OK;
+    }
+
+    double cpu = HalSim_GetCpuTime();
+    while (QSPI_KV_Stat.Record < records)
+    {
+        uint32_t var   = HalSim_Rand() % BENCH_VARS;
+        uint32_t value = HalSim_Rand();
+
+        error += QSPI_KV_Write(var + 1, value) != NVRAM_OK;
+        Bench_Var[var + 1] = value;
+        QSPI_KV_Clean();
+        writes++;
+    }
+    cpu = HalSim_GetCpuTime() - cpu;
+
+    for (uint32_t i = 0; i < QSPI_KV_SUBSECTORS; i++)
+    {
+        uint32_t count = QspiSim_EraseCount(first + i);
+        min            = (count < min) ? count : min;
+        max            = (count > max) ? count : max;
+    }
+
+    printf("\nWear: %u writes, %u laps of %u subsectors, %.0f ms\n", writes, BENCH_WEAR_LAPS,
+           QSPI_KV_SUBSECTORS, cpu * 1000);
+    printf("Erase   : min %u, max %u per subsector, %u garbage collected, %u records copied\n", min,
+           max, QSPI_KV_Stat.Gc, QSPI_KV_Stat.GcCopy);
+    printf("Records : %.3f per write, %.1f bytes programmed per write\n",
+           (double)QSPI_KV_Stat.Record / writes, (double)QspiSim_Stat.ProgramBytes / writes);
+
+    QspiSim_ResetStat();
+    cpu = HalSim_GetCpuTime();
+    error += QSPI_KV_Init() != NVRAM_OK;
+    cpu = HalSim_GetCpuTime() - cpu;
+    printf("Mount   : %u ms, %.1f kB read in %u commands, %.1f ms CPU on host, %u keys\n",
+           QSPI_KV_Stat.Mount, QspiSim_Stat.ReadBytes / 1024.0, QspiSim_Stat.ReadCount, cpu * 1000,
+           QSPI_KV_Stat.Keys);
+
+    error += Bench_verify(NULL, NULL, 0, -1);
+    for (uint32_t addr = BENCH_VARS + 1; addr <= BENCH_VARS + BENCH_COLD; addr++)
+    {
+        uint32_t value = 0;
+        error += (QSPI_KV_Read(addr, &value) != NVRAM_OK) || (value != addr * 3);
+    }
+    printf("Verify  : %s\n", (error || (max - min > 1)) ? "FAIL" : "PASS");
+}
+
+/*!@brief Run the power loss workload, stop at the first failed write.
+ *
+ * @param clean : Run background maintenance after each write.
+ * @param var   : Return the variables being written at power loss.
+ * @param value : Return the new values of the variables.
+ * @param ex    : Return the multi-byte value being written at power loss, -1 for none.
+ * @return Number of variables being written at power loss.
+ */
+static uint32_t Bench_lossWorkload(uint8_t clean, uint32_t *var, uint32_t *value, int *ex)
+{
+    *ex = -1;
+    for (uint32_t i = 0; (i < BENCH_LOSS_WRITES) && !QspiSim_PowerLost; i++)
+    {
+        uint32_t addr = 1 + HalSim_Rand() % BENCH_VARS;
+
+        if (i % BENCH_LOSS_PERIOD == 0)
+        {
+            uint8_t reg        = (i / BENCH_LOSS_PERIOD) % BENCH_EX;
+            Bench_ExNew.Length = 1 + HalSim_Rand() % NVRAM_EX_SIZE;
+            for (uint32_t k = 0; k < Bench_ExNew.Length; k++)
+            {
+                Bench_ExNew.Data[k] = HalSim_Rand();
+            }
+
+            if (QSPI_KV_WriteEx(reg, Bench_ExNew.Data, Bench_ExNew.Length) != NVRAM_OK)
+            {
+                *ex = reg;
+                return 0;
+            }
+            Bench_Ex[reg] = Bench_ExNew;
+        }
+        else if (i % BENCH_LOSS_PERIOD == BENCH_LOSS_PERIOD / 2)
+        {
+            for (uint32_t k = 0; k < BENCH_LOSS_TX_VARS; k++)
+            {
+                var[k]   = 1 + (addr + k) % BENCH_VARS;
+                value[k] = HalSim_Rand();
+            }
+
+            if (QSPI_KV_WriteTx(var, value, BENCH_LOSS_TX_VARS) != NVRAM_OK)
+            {
+                return BENCH_LOSS_TX_VARS;
+            }
+            for (uint32_t k = 0; k < BENCH_LOSS_TX_VARS; k++)
+            {
+                Bench_Var[var[k]] = value[k];
+            }
+        }
+        else
+        {
+            var[0]   = addr;
+            value[0] = HalSim_Rand();
+
+            if (QSPI_KV_Write(addr, value[0]) != NVRAM_OK)
+            {
+                return 1;
+            }
+            Bench_Var[addr] = value[0];
+        }
+
+        if (clean)
+        {
+            QSPI_KV_Clean();
+        }
+    }
+    return 0;
+}
+
+/*!@brief Simulate a MCU reset, RAM state of the store and the QSPI cache is lost, then mount.
+ */
+static NVRAM_STATUS Bench_powerUp(void)
+{
+    QspiSim_Reset();
+    Bsp_Qspi_CacheInvalidate(0, N25Q128A_FLASH_SIZE);
+    return QSPI_KV_Init();
+}
+
+/*!@brief Inject a power loss at each step of the workload and check recovery.
+ *
+ * @param clean : [1] Background garbage collection, [0] inline garbage collection.
+ */
+static void Bench_runPowerLoss(uint8_t clean)
+{
+    static uint32_t        saved_var[BENCH_VARS + 1];
+    static Bench_ExTypeDef saved_ex[BENCH_EX];
+    uint32_t               var[BENCH_LOSS_TX_VARS];
+    uint32_t               value[BENCH_LOSS_TX_VARS];
+    uint32_t               fail_init = 0;
+    uint32_t               fail_data = 0;
+    uint32_t               fail_next = 0;
+    uint32_t               gc        = 0;
+    int                    ex        = -1;
+
+    // Fill the area with values to collect, down to the free subsectors the test starts from.
+    QspiSim_EraseAll();
+    Bsp_Qspi_CacheInvalidate(0, N25Q128A_FLASH_SIZE);
+    QSPI_KV_Init();
+    memset(Bench_Var, 0, sizeof(Bench_Var));
+    memset(Bench_Ex, 0, sizeof(Bench_Ex));
+    HalSim_Seed(0xF111);
+    for (uint32_t i = 0; QSPI_KV_Stat.Free > (clean ? QSPI_KV_GC_FREE : QSPI_KV_RESERVE); i++)
+    {
+        uint32_t addr = 1 + HalSim_Rand() % BENCH_VARS;
+        uint8_t  reg  = i % BENCH_EX;
+
+        Bench_Var[addr] = HalSim_Rand();
+        QSPI_KV_Write(addr, Bench_Var[addr]);
+        Bench_Ex[reg].Length = 1 + HalSim_Rand() % NVRAM_EX_SIZE;
+        memset(Bench_Ex[reg].Data, i, Bench_Ex[reg].Length);
+        QSPI_KV_WriteEx(reg, Bench_Ex[reg].Data, Bench_Ex[reg].Length);
+    }
+    memcpy(Bench_Area, QspiSim_Memory(QSPI_KV_BASE), QSPI_KV_SIZE);
+    memcpy(saved_var, Bench_Var, sizeof(saved_var));
+    memcpy(saved_ex, Bench_Ex, sizeof(saved_ex));
+
+    // Dry run to count the steps.
+    Bench_powerUp();
+    uint32_t gc_start = QSPI_KV_Stat.Gc;
+    uint32_t step     = QspiSim_Stat.StepCount;
+    HalSim_Seed(0xC0FFEE);
+    Bench_lossWorkload(clean, var, value, &ex);
+    uint32_t steps = QspiSim_Stat.StepCount - step;
+    gc             = QSPI_KV_Stat.Gc - gc_start;
+
+    double cpu = HalSim_GetCpuTime();
+    for (uint32_t loss = 1; loss <= steps; loss++)
+    {
+        memcpy(QspiSim_Memory(QSPI_KV_BASE), Bench_Area, QSPI_KV_SIZE);
+        memcpy(Bench_Var, saved_var, sizeof(saved_var));
+        memcpy(Bench_Ex, saved_ex, sizeof(saved_ex));
+        Bench_powerUp();
+
+        HalSim_Seed(0xC0FFEE);
+        QspiSim_PowerLoss(QspiSim_Stat.StepCount + loss, loss);
+        uint32_t count = Bench_lossWorkload(clean, var, value, &ex);
+        QspiSim_PowerLoss(0, 0);
+
+        if (Bench_powerUp() != NVRAM_OK)
+        {
+            fail_init++;
+            continue;
+        }
+
+        if (Bench_verify(var, value, count, ex) != 0)
+        {
+            fail_data++;
+            continue;
+        }
+
+        // Store is still usable after recovery, and mounts again.
+        for (uint32_t k = 0; k < count; k++)
+        {
+            uint32_t read = 0;
+            QSPI_KV_Read(var[k], &read);
+            Bench_Var[var[k]] = read;
+        }
+        if (ex >= 0)
+        {
+            Bench_Ex[ex].Length = 0;
+            QSPI_KV_WriteEx(ex, Bench_ExNew.Data, Bench_ExNew.Length);
+            Bench_Ex[ex] = Bench_ExNew;
+        }
+        Bench_Var[1] = loss;
+        if ((QSPI_KV_Write(1, loss) != NVRAM_OK) || (Bench_powerUp() != NVRAM_OK) ||
+            (Bench_verify(NULL, NULL, 0, -1) != 0))
+        {
+            fail_next++;
+        }
+    }
+    cpu = HalSim_GetCpuTime() - cpu;
+
+    printf("\nPower loss: %u writes, %s garbage collection of %u subsectors, %u steps, %.0f ms\n",
+           BENCH_LOSS_WRITES, clean ? "background" : "inline", gc, steps, cpu * 1000);
+    printf("Init fail : %u\nData fail : %u\nNext fail : %u\n%s\n", fail_init, fail_data,
+           fail_next, (fail_init + fail_data + fail_next + (gc == 0)) ? "FAIL" : "PASS");
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t writes = (argc > 1) ? atoi(argv[1]) : BENCH_WRITES;
+
+    if ((argc > 2) && (strcmp(argv[2], "max") == 0))
+    {
+        FlashSim_Timing.Dword          = FLASH_SIM_TIME_DWORD_MAX;
+        FlashSim_Timing.Row            = FLASH_SIM_TIME_ROW_MAX;
+        FlashSim_Timing.PageErase      = FLASH_SIM_TIME_PAGE_ERASE_MAX;
+        FlashSim_Timing.MassErase      = FLASH_SIM_TIME_MASS_ERASE_MAX;
+        QspiSim_Timing.Program8        = QSPI_SIM_TIME_PROGRAM_8_MAX;
+        QspiSim_Timing.SubsectorErase  = QSPI_SIM_TIME_SUBSECTOR_ERASE_MAX;
+        QspiSim_Timing.SectorErase     = QSPI_SIM_TIME_SECTOR_ERASE_MAX;
+        QspiSim_Timing.ChipErase       = QSPI_SIM_TIME_CHIP_ERASE_MAX;
+        QspiSim_Timing.Suspend         = QSPI_SIM_TIME_SUSPEND_MAX;
+    }
+
+    if ((FlashSim_Init() != 0) || (QspiSim_Init() != 0))
+    {
+        return -1;
+    }
+    Bench_Time = malloc(writes * sizeof(uint32_t));
+    Bench_Area = malloc(QSPI_KV_SIZE);
+
+    printf("QSPI KV : %u keys, %u x %u bytes subsectors @ 0x%08X, %s timing\n", QSPI_KV_MAX_KEYS,
+           QSPI_KV_SUBSECTORS, QSPI_KV_SUBSECTOR_SIZE, QSPI_KV_BASE, (argc > 2) ? argv[2] : "typ");
+
+    // EEPROM emulation is bound by Bsp_Nvram_Init(), QSPI store is driven directly.
+    Bsp_Nvram_Init();
+    if (QSPI_KV_Init() != NVRAM_OK)
+    {
+        return -1;
+    }
+
+    Bench_runWrite(writes);
+    Bench_runCapacity();
+    Bench_runWear();
+    Bench_runPowerLoss(1);
+    Bench_runPowerLoss(0);
+
+    return 0;
+}
@@ -0,0 +1,196 @@
+/******************************************************************************
+ * @file    qspi_cache_bench.c
+ * @brief   Host benchmark of the QSPI block cache (bsp_qspi_cache.c on simulated N25Q128A).
+ *
+ *          Small reads through Bsp_Qspi_Read(), with the cache and without:
+ *          - Metadata: 16 ~ 64 bytes, 90% in a 4 kB hot area, the rest anywhere in 1 MB.
+ *          - Random: 16 ~ 64 bytes anywhere in 1 MB, no locality.
+ *          - Sequential: 64 bytes, then 512 bytes reads, one after the other.
+ *
+ *          Time is the simulated time of the reads, CPU the part the caller doesn't sleep
+ *          waiting an interrupt. Each read is checked against the flash.
+ *
+ *          Invalidation: reads of a small area mixed with writes and erases of it, each
+ *          read must return the data written last.
+ *
+ *          Usage: qspi_cache_bench [reads]
+ *          reads is the read count of each workload, default 20000.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp_qspi.h"
+#include "bsp_qspi_cache.h"
+#include "hal_sim.h"
+#include "qspi_sim.h"
+
+// clang-format off
+#define BENCH_READS             20000       //!< Default read count of a workload
+#define BENCH_AREA              0x100000    //!< Area of the read workloads
+#define BENCH_HOT               0x1000      //!< Hot area of the metadata workload
+#define BENCH_HOT_PERCENT       90
+#define BENCH_MIX_ADDR          0x800000    //!< Subsector of the invalidation phase
+#define BENCH_MIX_OPS           4000
+// clang-format on
+
+typedef enum { BENCH_METADATA, BENCH_RANDOM, BENCH_SEQ_64, BENCH_SEQ_512 } Bench_LoadTypeDef;
+
+static uint32_t Bench_Error = 0;
+
+/*!@brief Run a read workload and print its figures.
+ */
+static void Bench_run(const char *name, Bench_LoadTypeDef load, uint32_t reads, uint8_t cache)
+{
+    static uint8_t        buf[512];
+    Qspi_CacheStatTypeDef stat  = Qspi_CacheStat;
+    uint32_t              cmd   = QspiSim_Stat.ReadCount;
+    uint64_t              bytes = QspiSim_Stat.ReadBytes;
+    uint64_t              total = 0;
+    uint32_t              addr  = 0;
+    uint64_t              time;
+    uint64_t              idle;
+
+    Qspi_CacheEnable = cache;
+    HalSim_Seed(1);
+    Bsp_Qspi_CacheInvalidate(0, N25Q128A_FLASH_SIZE);
+    time = HalSim_GetTime();
+    idle = HalSim_IdleTime;
+
+    for (uint32_t i = 0; i < reads; i++)
+    {
+        uint32_t size;
+
+        switch (load)
+        {
+        case BENCH_METADATA:
+            size = 16 + HalSim_Rand() % 49;
+            addr = (HalSim_Rand() % 100 < BENCH_HOT_PERCENT) ? HalSim_Rand() % (BENCH_HOT - size)
+                                                             : HalSim_Rand() % (BENCH_AREA - size);
+            break;
+
+        case BENCH_RANDOM:
+            size = 16 + HalSim_Rand() % 49;
+            addr = HalSim_Rand() % (BENCH_AREA - size);
+            break;
+
+        case BENCH_SEQ_64:
+            size = 64;
+            addr = (addr + size <= BENCH_AREA - size) ? addr + size : 0;
+            break;
+
+        default:
+            size = 512;
+            addr = (addr + size <= BENCH_AREA - size) ? addr + size : 0;
+            break;
+        }
+
+        Bench_Error += (Bsp_Qspi_Read(buf, addr, size) != QSPI_OK);
+        Bench_Error += (memcmp(buf, QspiSim_Memory(addr), size) != 0);
+        total += size;
+    }
+
+    time = HalSim_GetTime() - time;
+    idle = HalSim_IdleTime - idle;
+    cmd  = QspiSim_Stat.ReadCount - cmd;
+
+    uint32_t hit  = Qspi_CacheStat.Hit - stat.Hit;
+    uint32_t miss = Qspi_CacheStat.Miss - stat.Miss;
+    printf("%-10s %-3s | %8.2f | %6.2f | %8.2f | %7u | %6.2f | %5.1f%%\n", name,
+           cache ? "on" : "off", time / 1000.0, (double)total / time, (time - idle) / 1000.0,
+           cmd, (double)(QspiSim_Stat.ReadBytes - bytes) / total,
+           (hit + miss) ? 100.0 * hit / (hit + miss) : 0.0);
+}
+
+/*!@brief Reads mixed with writes and erases of one subsector, checked against a model.
+ */
+static void Bench_runMix(void)
+{
+    static uint8_t model[N25Q128A_SUBSECTOR_SIZE];
+    static uint8_t buf[N25Q128A_PAGE_SIZE];
+    uint32_t       inval = Qspi_CacheStat.Invalidate;
+    uint32_t       hit   = Qspi_CacheStat.Hit;
+
+    Qspi_CacheEnable = 1;
+    HalSim_Seed(7);
+    Bench_Error += (Bsp_Qspi_Erase(BENCH_MIX_ADDR, N25Q128A_SUBSECTOR_SIZE) != QSPI_OK);
+    memset(model, 0xFF, sizeof(model));
+
+    for (uint32_t i = 0; i < BENCH_MIX_OPS; i++)
+    {
+        uint32_t op   = HalSim_Rand() % 100;
+        uint32_t size = 1 + HalSim_Rand() % 64;
+        uint32_t off  = HalSim_Rand() % (N25Q128A_SUBSECTOR_SIZE - size);
+
+        if (op < 1)
+        {
+            Bench_Error += (Bsp_Qspi_Erase(BENCH_MIX_ADDR, N25Q128A_SUBSECTOR_SIZE) != QSPI_OK);
+            memset(model, 0xFF, sizeof(model));
+        }
+        else if (op < 20)
+        {
+            // Program clears bits only, keep a page boundary out of the write.
+            size = (off % N25Q128A_PAGE_SIZE + size > N25Q128A_PAGE_SIZE)
+                       ? N25Q128A_PAGE_SIZE - off % N25Q128A_PAGE_SIZE
+                       : size;
+            for (uint32_t k = 0; k < size; k++)
+            {
+                buf[k] = (uint8_t)HalSim_Rand();
+                model[off + k] &= buf[k];
+            }
+            Bench_Error += (Bsp_Qspi_Write(buf, BENCH_MIX_ADDR + off, size) != QSPI_OK);
+        }
+        else
+        {
+            Bench_Error += (Bsp_Qspi_Read(buf, BENCH_MIX_ADDR + off, size) != QSPI_OK);
+            Bench_Error += (memcmp(buf, &model[off], size) != 0);
+        }
+    }
+    Bench_Error += (memcmp(QspiSim_Memory(BENCH_MIX_ADDR), model, sizeof(model)) != 0);
+
+    printf("\nInvalidation: %u reads, writes and erases of a subsector, %u hits, %u blocks "
+           "dropped\n",
+           BENCH_MIX_OPS, Qspi_CacheStat.Hit - hit, Qspi_CacheStat.Invalidate - inval);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t reads = (argc > 1) ? atoi(argv[1]) : BENCH_READS;
+
+    if ((reads == 0) || (QspiSim_Init() != 0))
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < BENCH_AREA; i++)
+    {
+        *QspiSim_Memory(i) = (uint8_t)(i * 7 + (i >> 12));
+    }
+
+    printf("QSPI cache: %u blocks of %u bytes, fill up to %u blocks, %u reads per workload\n",
+           QSPI_CACHE_BLOCKS, QSPI_CACHE_BLOCK, QSPI_CACHE_FILL, reads);
+    printf("\nWorkload  Cache|  Time(ms)|  MB/s  |  CPU(ms) | Commands| Read x |  Hit\n");
+    Bench_run("Metadata", BENCH_METADATA, reads, 0);
+    Bench_run("Metadata", BENCH_METADATA, reads, 1);
+    Bench_run("Random", BENCH_RANDOM, reads, 0);
+    Bench_run("Random", BENCH_RANDOM, reads, 1);
+    Bench_run("Seq 64 B", BENCH_SEQ_64, reads, 0);
+    Bench_run("Seq 64 B", BENCH_SEQ_64, reads, 1);
+    Bench_run("Seq 512 B", BENCH_SEQ_512, reads, 0);
+    Bench_run("Seq 512 B", BENCH_SEQ_512, reads, 1);
+
+    Bench_runMix();
+
+    printf("\nCache   : %u hits, %u misses, %u read ahead, %u of them hit, %u bypassed\n",
+           Qspi_CacheStat.Hit, Qspi_CacheStat.Miss, Qspi_CacheStat.Ahead,
+           Qspi_CacheStat.AheadHit, Qspi_CacheStat.Bypass);
+    printf("Verify  : %s\n",
+           (Bench_Error || Qspi_Stat.Error || QspiSim_Stat.ErrorCount) ? "FAIL" : "PASS");
+
+    return 0;
+}
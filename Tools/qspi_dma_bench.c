@@ -0,0 +1,126 @@
+/******************************************************************************
+ * @file    qspi_dma_bench.c
+ * @brief   Host benchmark of blocking vs DMA QSPI transfers (bsp_qspi.c on simulated N25Q128A).
+ *
+ *          Read: the read size from QSPI, by blocking BSP_QSPI_Read() in chunks as the
+ *          CLI read them, then by Bsp_Qspi_Read() in chunks and in one call.
+ *          Write: 64 kB programmed by blocking BSP_QSPI_Write(), then by Bsp_Qspi_Write().
+ *
+ *          CPU time is the time the caller doesn't sleep waiting an interrupt, i.e. the
+ *          whole transfer when blocking, command setup and completion interrupts by DMA.
+ *          The rest is free for other tasks. Times follow the QSPI bus clock and the
+ *          program time of the datasheet, CPU costs of DMA are QSPI_SIM_TIME_DMA_SETUP
+ *          and QSPI_SIM_TIME_IRQ.
+ *
+ *          Usage: qspi_dma_bench [kB]
+ *          kB is the read size, default 1024.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp_qspi.h"
+#include "hal_sim.h"
+#include "qspi_sim.h"
+
+// clang-format off
+#define BENCH_READ_KB           1024        //!< Default read size
+#define BENCH_CHUNK             4096        //!< Chunk of a read loop
+#define BENCH_WRITE_ADDR        0x800000    //!< Erased area of write phase
+#define BENCH_WRITE_SIZE        0x10000
+// clang-format on
+
+static uint8_t *Bench_Buf = NULL;
+
+/*!@brief Run a transfer and print its time and CPU load.
+ *
+ * @return Number of errors, transfer fail or data mismatch.
+ */
+static uint32_t Bench_run(const char *name, uint32_t chunk, uint32_t addr, uint32_t size,
+                          uint8_t write, uint8_t dma)
+{
+    uint64_t time  = HalSim_GetTime();
+    uint64_t idle  = HalSim_IdleTime;
+    uint32_t error = 0;
+
+    if (!write)
+    {
+        memset(Bench_Buf, 0, size);
+    }
+
+    for (uint32_t i = 0; i < size; i += chunk)
+    {
+        uint32_t len = (size - i > chunk) ? chunk : size - i;
+        uint8_t  ret;
+
+        if (write)
+        {
+            ret = dma ? Bsp_Qspi_Write(Bench_Buf + i, addr + i, len)
+                      : BSP_QSPI_Write(Bench_Buf + i, addr + i, len);
+        }
+        else
+        {
+            ret = dma ? Bsp_Qspi_Read(Bench_Buf + i, addr + i, len)
+                      : BSP_QSPI_Read(Bench_Buf + i, addr + i, len);
+        }
+        error += (ret != QSPI_OK);
+    }
+
+    time = HalSim_GetTime() - time;
+    idle = HalSim_IdleTime - idle;
+    error += (memcmp(Bench_Buf, QspiSim_Memory(addr), size) != 0);
+
+    printf("%-8s| %6u kB | %9.2f | %6.2f | %8.2f | %5.1f%%\n", name, chunk / 1024,
+           time / 1000.0, (double)size / time, (time - idle) / 1000.0,
+           100.0 * (time - idle) / time);
+    return error;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t size  = ((argc > 1) ? atoi(argv[1]) : BENCH_READ_KB) * 1024;
+    uint32_t error = 0;
+
+    if ((size == 0) || (size > BENCH_WRITE_ADDR) || (QspiSim_Init() != 0))
+    {
+        return -1;
+    }
+    Bench_Buf = malloc(size);
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        *QspiSim_Memory(i) = (uint8_t)(i * 7 + (i >> 12));
+    }
+
+    printf("QSPI DMA: %u MHz quad bus, DMA setup %u us, interrupt %u us of CPU\n",
+           QSPI_SIM_CLOCK_MHZ, QSPI_SIM_TIME_DMA_SETUP, QSPI_SIM_TIME_IRQ);
+
+    printf("\nRead: %u kB\n", size / 1024);
+    printf("Mode    |   Chunk   |  Time(ms) |  MB/s  |  CPU(ms) |  CPU\n");
+    error += Bench_run("Blocking", BENCH_CHUNK, 0, size, 0, 0);
+    error += Bench_run("DMA", BENCH_CHUNK, 0, size, 0, 1);
+    error += Bench_run("DMA", QSPI_DMA_MAX, 0, size, 0, 1);
+    error += Bench_run("DMA", size, 0, size, 0, 1);
+
+    printf("\nWrite: %u kB\n", BENCH_WRITE_SIZE / 1024);
+    printf("Mode    |   Chunk   |  Time(ms) |  MB/s  |  CPU(ms) |  CPU\n");
+    for (uint32_t i = 0; i < BENCH_WRITE_SIZE; i++)
+    {
+        Bench_Buf[i] = (uint8_t)(i * 13);
+    }
+    error += Bench_run("Blocking", BENCH_CHUNK, BENCH_WRITE_ADDR, BENCH_WRITE_SIZE, 1, 0);
+    error += Bench_run("DMA", BENCH_CHUNK, BENCH_WRITE_ADDR + BENCH_WRITE_SIZE,
+                       BENCH_WRITE_SIZE, 1, 1);
+
+    printf("\nDMA     : %u reads, %u pages, %u errors\n", Qspi_Stat.DmaRead, Qspi_Stat.Page,
+           Qspi_Stat.Error);
+    printf("Verify  : %s\n", (error || Qspi_Stat.Error) ? "FAIL" : "PASS");
+
+    free(Bench_Buf);
+    return 0;
+}
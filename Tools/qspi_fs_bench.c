@@ -0,0 +1,617 @@
+/******************************************************************************
+ * @file    qspi_fs_bench.c
+ * @brief   Host benchmark of the QSPI file system (bsp_qspi_fs.c on simulated N25Q128A).
+ *
+ *          Mount: time and flash reads of a mount, empty and with every directory entry
+ *          used.
+ *
+ *          Throughput: a 1 MB file written by 256 bytes and 4 kB writes, read back by
+ *          64 bytes and 4 kB reads, then overwritten in place and appended by small
+ *          writes with a commit each, and appended by a small write each open.
+ *
+ *          Wear: small file rewrites with half of the area held by cold files, erase
+ *          count spread of the blocks and of the superblock ring.
+ *
+ *          Power loss: a workload of appends, rewrites, overwrites and removes is
+ *          repeated with a power loss injected at each of its QSPI steps, then mounted.
+ *          Files must be as of the last commit completed, or of the interrupted one.
+ *
+ *          Usage: qspi_fs_bench [commits] [typ|max]
+ *          commits is the rewrite count of the wear phase, default 10000. max uses
+ *          maximum timing of the datasheet instead of typical.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp_qspi.h"
+#include "bsp_qspi_cache.h"
+#include "bsp_qspi_fs.h"
+#include "hal_sim.h"
+#include "qspi_sim.h"
+
+// clang-format off
+#define BENCH_COMMITS           10000       //!< Default rewrite count of the wear phase
+#define BENCH_FILE_SIZE         0x100000    //!< File of the throughput phase
+#define BENCH_SMALL_WRITES      200         //!< Overwrites and appends with a commit each
+#define BENCH_COLD_FILES        30          //!< Files holding half of the area in wear phase
+#define BENCH_LOSS_FILES        4           //!< Files of the power loss workload
+#define BENCH_LOSS_MAX          0x3000      //!< Bytes of a power loss workload file
+#define BENCH_LOSS_OPS          24          //!< Operations of the power loss workload
+#define BENCH_LOSS_COMMITS      64          //!< Commits of the power loss workload, max
+#define BENCH_LOSS_COLD         4           //!< Files filling the area in power loss phase
+#define BENCH_LOSS_FREE         16          //!< Blocks left free, so that freed blocks are reused
+// clang-format on
+
+typedef struct {
+    uint32_t Size[BENCH_LOSS_FILES];
+    uint8_t  Exist[BENCH_LOSS_FILES];
+    uint8_t  Data[BENCH_LOSS_FILES][BENCH_LOSS_MAX];
+} Bench_ModelTypeDef;
+
+static const char *Bench_LossName[BENCH_LOSS_FILES] = {"log", "config", "data", "tmp"};
+
+static uint32_t           Bench_Error = 0;
+static uint8_t            Bench_Buf[0x1000];
+static uint8_t            Bench_Read[0x1000];
+static Bench_ModelTypeDef Bench_Model;                         //!< Files written
+static Bench_ModelTypeDef Bench_Commit[BENCH_LOSS_COMMITS + 1]; //!< Files of each commit
+static uint32_t           Bench_Commits = 0;
+
+/*!@brief Simulate a MCU reset, RAM state of the file system and the QSPI cache is lost,
+ *        then mount.
+ */
+static int Bench_powerUp(void)
+{
+    QspiSim_Reset();
+    Bsp_Qspi_CacheInvalidate(0, N25Q128A_FLASH_SIZE);
+    return QSPI_FS_Mount();
+}
+
+/*!@brief Mount and print its time and flash reads.
+ */
+static void Bench_runMount(const char *name)
+{
+    uint32_t cmd   = QspiSim_Stat.ReadCount;
+    uint64_t bytes = QspiSim_Stat.ReadBytes;
+    uint64_t time  = HalSim_GetTime();
+
+    Bench_Error += (Bench_powerUp() != QSPI_FS_OK);
+    time = HalSim_GetTime() - time;
+
+    printf("%-22s | %8.3f | %8u | %8llu | %5u | %6u\n", name, time / 1000.0,
+           QspiSim_Stat.ReadCount - cmd, (unsigned long long)(QspiSim_Stat.ReadBytes - bytes),
+           QSPI_FS_Stat.Files, QSPI_FS_Stat.Used);
+}
+
+static void Bench_runMounts(void)
+{
+    QSPI_FS_FileTypeDef file;
+    char                name[QSPI_FS_NAME_MAX + 1];
+
+    printf("\nMount                  | Time(ms) | Commands |  Bytes   | Files | Blocks\n");
+    Bench_Error += (QSPI_FS_Format() != QSPI_FS_OK);
+    Bench_runMount("Empty");
+
+    for (uint32_t i = 0; i < QSPI_FS_FILES; i++)
+    {
+        snprintf(name, sizeof(name), "file%02u", i);
+        Bench_Error += (QSPI_FS_Open(&file, name, QSPI_FS_WRITE | QSPI_FS_CREATE) != QSPI_FS_OK);
+        memset(Bench_Buf, i, sizeof(Bench_Buf));
+        for (uint32_t k = 0; k < 4; k++)
+        {
+            Bench_Error += (QSPI_FS_Write(&file, Bench_Buf, sizeof(Bench_Buf)) != sizeof(Bench_Buf));
+        }
+        Bench_Error += (QSPI_FS_Close(&file) != QSPI_FS_OK);
+    }
+    Bench_runMount("Directory full");
+
+    // Superblock ring wrapped, records in each ring block.
+    for (uint32_t i = 0; i < QSPI_FS_SUPER_BLOCKS * 128; i++)
+    {
+        Bench_Error += (QSPI_FS_Open(&file, "file00", QSPI_FS_WRITE | QSPI_FS_APPEND) != QSPI_FS_OK);
+        Bench_Error += (QSPI_FS_Write(&file, "x", 1) != 1);
+        Bench_Error += (QSPI_FS_Close(&file) != QSPI_FS_OK);
+    }
+    Bench_runMount("Superblock ring full");
+
+    // Content survives the mounts.
+    for (uint32_t i = 0; i < QSPI_FS_FILES; i++)
+    {
+        snprintf(name, sizeof(name), "file%02u", i);
+        Bench_Error += (QSPI_FS_Open(&file, name, QSPI_FS_READ) != QSPI_FS_OK);
+        Bench_Error += (QSPI_FS_Seek(&file, 4096 * 3, QSPI_FS_SEEK_SET) != 4096 * 3);
+        Bench_Error += (QSPI_FS_Read(&file, Bench_Read, 4096) != 4096);
+        Bench_Error += (Bench_Read[0] != i) || (Bench_Read[4095] != i);
+        Bench_Error += (QSPI_FS_Close(&file) != QSPI_FS_OK);
+        Bench_Error += (QSPI_FS_Remove(name) != QSPI_FS_OK);
+    }
+}
+
+/*!@brief Print a throughput phase from its start time.
+ */
+static void Bench_print(const char *name, uint64_t time, uint32_t erase, uint32_t copy,
+                        uint64_t bytes)
+{
+    time = HalSim_GetTime() - time;
+    printf("%-22s | %9.1f | %8.1f | %6u | %8u\n", name, time / 1000.0,
+           bytes * 1000000.0 / 1024 / time, QSPI_FS_Stat.Erase - erase, QSPI_FS_Stat.Copy - copy);
+}
+
+static void Bench_runThroughput(void)
+{
+    static const uint32_t write[2] = {256, 4096};
+    static const uint32_t read[2]  = {64, 4096};
+    QSPI_FS_FileTypeDef   file;
+    uint64_t              time;
+    uint32_t              erase;
+    uint32_t              copy;
+    char                  name[32];
+
+    for (uint32_t i = 0; i < sizeof(Bench_Buf); i++)
+    {
+        Bench_Buf[i] = (uint8_t)(i * 7 + 1);
+    }
+
+    printf("\nThroughput             | Time(ms)  |  kB/s    | Erases | Copied\n");
+    for (uint32_t w = 0; w < 2; w++)
+    {
+        erase = QSPI_FS_Stat.Erase;
+        copy  = QSPI_FS_Stat.Copy;
+        time  = HalSim_GetTime();
+        Bench_Error += (QSPI_FS_Open(&file, "big", QSPI_FS_WRITE | QSPI_FS_CREATE | QSPI_FS_TRUNC) !=
+                        QSPI_FS_OK);
+        for (uint32_t pos = 0; pos < BENCH_FILE_SIZE; pos += write[w])
+        {
+            Bench_Error += (QSPI_FS_Write(&file, &Bench_Buf[pos % sizeof(Bench_Buf)], write[w]) !=
+                            (int32_t)write[w]);
+        }
+        Bench_Error += (QSPI_FS_Close(&file) != QSPI_FS_OK);
+        snprintf(name, sizeof(name), "Write 1 MB by %u B", write[w]);
+        Bench_print(name, time, erase, copy, BENCH_FILE_SIZE);
+    }
+
+    for (uint32_t r = 0; r < 2; r++)
+    {
+        time = HalSim_GetTime();
+        Bench_Error += (QSPI_FS_Open(&file, "big", QSPI_FS_READ) != QSPI_FS_OK);
+        for (uint32_t pos = 0; pos < BENCH_FILE_SIZE; pos += read[r])
+        {
+            Bench_Error += (QSPI_FS_Read(&file, Bench_Read, read[r]) != (int32_t)read[r]);
+            Bench_Error += (memcmp(Bench_Read, &Bench_Buf[pos % sizeof(Bench_Buf)], read[r]) != 0);
+        }
+        Bench_Error += (QSPI_FS_Read(&file, Bench_Read, 1) != 0);
+        Bench_Error += (QSPI_FS_Close(&file) != QSPI_FS_OK);
+        snprintf(name, sizeof(name), "Read 1 MB by %u B", read[r]);
+        Bench_print(name, time, QSPI_FS_Stat.Erase, QSPI_FS_Stat.Copy, BENCH_FILE_SIZE);
+    }
+
+    erase = QSPI_FS_Stat.Erase;
+    copy  = QSPI_FS_Stat.Copy;
+    time  = HalSim_GetTime();
+    HalSim_Seed(3);
+    Bench_Error += (QSPI_FS_Open(&file, "big", QSPI_FS_WRITE) != QSPI_FS_OK);
+    for (uint32_t i = 0; i < BENCH_SMALL_WRITES; i++)
+    {
+        uint32_t pos = HalSim_Rand() % (BENCH_FILE_SIZE - 64);
+
+        memset(Bench_Read, i, 64);
+        Bench_Error += (QSPI_FS_Seek(&file, pos, QSPI_FS_SEEK_SET) != (int32_t)pos);
+        Bench_Error += (QSPI_FS_Write(&file, Bench_Read, 64) != 64);
+        Bench_Error += (QSPI_FS_Sync(&file) != QSPI_FS_OK);
+    }
+    Bench_Error += (QSPI_FS_Close(&file) != QSPI_FS_OK);
+    Bench_print("Overwrite 64 B + sync", time, erase, copy, BENCH_SMALL_WRITES * 64);
+
+    erase = QSPI_FS_Stat.Erase;
+    copy  = QSPI_FS_Stat.Copy;
+    time  = HalSim_GetTime();
+    Bench_Error += (QSPI_FS_Open(&file, "log", QSPI_FS_WRITE | QSPI_FS_CREATE | QSPI_FS_APPEND) !=
+                    QSPI_FS_OK);
+    for (uint32_t i = 0; i < BENCH_SMALL_WRITES; i++)
+    {
+        Bench_Error += (QSPI_FS_Write(&file, Bench_Buf, 64) != 64);
+        Bench_Error += (QSPI_FS_Sync(&file) != QSPI_FS_OK);
+    }
+    Bench_Error += (QSPI_FS_Close(&file) != QSPI_FS_OK);
+    Bench_print("Append 64 B + sync", time, erase, copy, BENCH_SMALL_WRITES * 64);
+
+    erase = QSPI_FS_Stat.Erase;
+    copy  = QSPI_FS_Stat.Copy;
+    time  = HalSim_GetTime();
+    for (uint32_t i = 0; i < BENCH_SMALL_WRITES; i++)
+    {
+        Bench_Error += (QSPI_FS_Open(&file, "log", QSPI_FS_WRITE | QSPI_FS_APPEND) != QSPI_FS_OK);
+        Bench_Error += (QSPI_FS_Write(&file, &Bench_Buf[i * 64 % sizeof(Bench_Buf)], 64) != 64);
+        Bench_Error += (QSPI_FS_Close(&file) != QSPI_FS_OK);
+    }
+    Bench_print("Open, append 64 B", time, erase, copy, BENCH_SMALL_WRITES * 64);
+
+    Bench_Error += (QSPI_FS_Open(&file, "log", QSPI_FS_READ) != QSPI_FS_OK);
+    for (uint32_t i = 0; i < 2 * BENCH_SMALL_WRITES; i++)
+    {
+        uint32_t from = (i < BENCH_SMALL_WRITES) ? 0 : i * 64 % sizeof(Bench_Buf);
+
+        Bench_Error += (QSPI_FS_Read(&file, Bench_Read, 64) != 64);
+        Bench_Error += (memcmp(Bench_Read, &Bench_Buf[from], 64) != 0);
+    }
+    Bench_Error += (QSPI_FS_Close(&file) != QSPI_FS_OK);
+
+    Bench_Error += (QSPI_FS_Remove("big") != QSPI_FS_OK);
+    Bench_Error += (QSPI_FS_Remove("log") != QSPI_FS_OK);
+}
+
+static void Bench_runWear(uint32_t commits)
+{
+    static uint32_t     base[QSPI_FS_BLOCKS];
+    uint32_t            cold  = (QSPI_FS_BLOCKS / 2) / BENCH_COLD_FILES; //!< Blocks of a cold file
+    uint32_t            ring  = 0;
+    uint32_t            max   = 0;
+    uint32_t            sum   = 0;
+    uint32_t            count = 0;
+    QSPI_FS_FileTypeDef file;
+    char                name[QSPI_FS_NAME_MAX + 1];
+
+    memset(Bench_Buf, 0x5A, sizeof(Bench_Buf));
+    for (uint32_t i = 0; i < BENCH_COLD_FILES; i++)
+    {
+        snprintf(name, sizeof(name), "cold%02u", i);
+        Bench_Error += (QSPI_FS_Open(&file, name, QSPI_FS_WRITE | QSPI_FS_CREATE) != QSPI_FS_OK);
+        for (uint32_t k = 0; k < cold; k++)
+        {
+            Bench_Error += (QSPI_FS_Write(&file, Bench_Buf, QSPI_FS_BLOCK) != QSPI_FS_BLOCK);
+        }
+        Bench_Error += (QSPI_FS_Close(&file) != QSPI_FS_OK);
+    }
+
+    for (uint32_t b = 0; b < QSPI_FS_BLOCKS; b++)
+    {
+        base[b] = QspiSim_EraseCount(QSPI_FS_BASE / QSPI_FS_BLOCK + b);
+    }
+
+    HalSim_Seed(5);
+    for (uint32_t i = 0; i < commits; i++)
+    {
+        uint32_t size = 1 + HalSim_Rand() % 2000;
+
+        Bench_Error += (QSPI_FS_Open(&file, "hot", QSPI_FS_WRITE | QSPI_FS_CREATE | QSPI_FS_TRUNC) !=
+                        QSPI_FS_OK);
+        Bench_Error += (QSPI_FS_Write(&file, Bench_Buf, size) != (int32_t)size);
+        Bench_Error += (QSPI_FS_Close(&file) != QSPI_FS_OK);
+    }
+
+    for (uint32_t b = 0; b < QSPI_FS_BLOCKS; b++)
+    {
+        uint32_t n = QspiSim_EraseCount(QSPI_FS_BASE / QSPI_FS_BLOCK + b) - base[b];
+
+        if (b < QSPI_FS_SUPER_BLOCKS)
+        {
+            ring = (n > ring) ? n : ring;
+        }
+        else if (n)
+        {
+            max = (n > max) ? n : max;
+            sum += n;
+            count++;
+        }
+    }
+
+    // Cold files are still there after the rewrites.
+    Bench_Error += (Bench_powerUp() != QSPI_FS_OK);
+    Bench_Error += (QSPI_FS_Stat.Files != BENCH_COLD_FILES + 1);
+    Bench_Error += (QSPI_FS_Open(&file, "cold00", QSPI_FS_READ) != QSPI_FS_OK);
+    Bench_Error += (QSPI_FS_Seek(&file, 0, QSPI_FS_SEEK_END) != (int32_t)(cold * QSPI_FS_BLOCK));
+    Bench_Error += (QSPI_FS_Close(&file) != QSPI_FS_OK);
+
+    printf("\nWear: %u rewrites of a 1 ~ 2000 bytes file, %u blocks of %u in cold files\n", commits,
+           cold * BENCH_COLD_FILES, QSPI_FS_BLOCKS);
+    printf("Data blocks erased   : %u, %.2f erases average, %u max\n", count,
+           count ? (double)sum / count : 0.0, max);
+    printf("Superblock ring      : %u erases max, %.2f commits per erase\n", ring,
+           ring ? (double)commits / ring : 0.0);
+}
+
+/*!@brief Files of the model as of a commit completed, or of the commit in flight.
+ */
+static void Bench_lossCommit(int ret)
+{
+    if (Bench_Commits < BENCH_LOSS_COMMITS)
+    {
+        memcpy(&Bench_Commit[Bench_Commits + 1], &Bench_Model, sizeof(Bench_Model));
+        Bench_Commits += (ret == QSPI_FS_OK);
+    }
+}
+
+/*!@brief Write random bytes at the position, to the file and the model.
+ */
+static int Bench_lossWrite(QSPI_FS_FileTypeDef *file, uint32_t f, uint32_t len)
+{
+    uint32_t pos = (file->Mode & QSPI_FS_APPEND) ? file->Size : file->Pos;
+
+    len = (pos + len > BENCH_LOSS_MAX) ? BENCH_LOSS_MAX - pos : len;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        Bench_Model.Data[f][pos + i] = (uint8_t)HalSim_Rand();
+    }
+    if (pos + len > Bench_Model.Size[f])
+    {
+        Bench_Model.Size[f] = pos + len;
+    }
+    return (QSPI_FS_Write(file, &Bench_Model.Data[f][pos], len) == (int32_t)len) ? 0 : -1;
+}
+
+/*!@brief Power loss workload, stops at the first error.
+ *
+ * @return Operations done.
+ */
+static uint32_t Bench_lossWorkload(void)
+{
+    QSPI_FS_FileTypeDef file;
+    uint32_t            op;
+    int                 ret = QSPI_FS_OK;
+
+    for (op = 0; (op < BENCH_LOSS_OPS) && (ret == QSPI_FS_OK); op++)
+    {
+        uint32_t f    = HalSim_Rand() % BENCH_LOSS_FILES;
+        uint32_t kind = HalSim_Rand() % 4;
+
+        if ((kind == 3) && Bench_Model.Exist[f])
+        {
+            Bench_Model.Exist[f] = 0;
+            Bench_Model.Size[f]  = 0;
+            ret                  = QSPI_FS_Remove(Bench_LossName[f]);
+            Bench_lossCommit(ret);
+            continue;
+        }
+
+        uint8_t mode = QSPI_FS_WRITE | QSPI_FS_CREATE;
+        mode |= (kind == 0) ? QSPI_FS_APPEND : 0;
+        mode |= (kind == 1) ? QSPI_FS_TRUNC : 0;
+        ret = QSPI_FS_Open(&file, Bench_LossName[f], mode);
+        if (ret != QSPI_FS_OK)
+        {
+            break;
+        }
+        Bench_Model.Exist[f] = 1;
+        Bench_Model.Size[f]  = (kind == 1) ? 0 : Bench_Model.Size[f];
+
+        if (kind == 2)
+        {
+            // Overwrite from a random position, commit, then write on.
+            uint32_t pos = HalSim_Rand() % (Bench_Model.Size[f] + 1);
+
+            QSPI_FS_Seek(&file, pos, QSPI_FS_SEEK_SET);
+            ret = Bench_lossWrite(&file, f, 1 + HalSim_Rand() % 3000) ? QSPI_FS_ERROR
+                                                                      : QSPI_FS_Sync(&file);
+            Bench_lossCommit(ret);
+            if (ret != QSPI_FS_OK)
+            {
+                break;
+            }
+        }
+
+        ret = Bench_lossWrite(&file, f, 1 + HalSim_Rand() % ((kind == 1) ? 6000 : 300))
+                  ? QSPI_FS_ERROR
+                  : QSPI_FS_Close(&file);
+        Bench_lossCommit(ret);
+    }
+    return op;
+}
+
+/*!@brief Compare the files with a model.
+ */
+static int Bench_lossVerify(const Bench_ModelTypeDef *model)
+{
+    QSPI_FS_FileTypeDef file;
+    QSPI_FS_InfoTypeDef info;
+    uint32_t            pos   = 0;
+    uint32_t            files = 0;
+
+    while (QSPI_FS_Dir(&pos, &info) == QSPI_FS_OK)
+    {
+        files++;
+    }
+
+    for (uint32_t f = 0; f < BENCH_LOSS_FILES; f++)
+    {
+        int ret = QSPI_FS_Open(&file, Bench_LossName[f], QSPI_FS_READ);
+
+        files -= model->Exist[f];
+        if (!model->Exist[f] || (ret != QSPI_FS_OK))
+        {
+            if (model->Exist[f] || (ret != QSPI_FS_NOENT))
+            {
+                return -1;
+            }
+            continue;
+        }
+
+        ret = (file.Size != model->Size[f]);
+        for (uint32_t off = 0; (off < model->Size[f]) && !ret; off += sizeof(Bench_Read))
+        {
+            uint32_t len = model->Size[f] - off;
+
+            len = (len < sizeof(Bench_Read)) ? len : sizeof(Bench_Read);
+            ret = (QSPI_FS_Read(&file, Bench_Read, len) != (int32_t)len) ||
+                  (memcmp(Bench_Read, &model->Data[f][off], len) != 0);
+        }
+        QSPI_FS_Close(&file);
+        if (ret)
+        {
+            return -1;
+        }
+    }
+    return (files != BENCH_LOSS_COLD) ? -1 : 0;
+}
+
+/*!@brief Restore the file system area from an image: blocks erased since the last restore,
+ *        the block of the last power loss, as a torn erase isn't counted, and the
+ *        superblock ring.
+ */
+static void Bench_lossRestore(const uint8_t *image, uint32_t *erase)
+{
+    for (uint32_t b = 0; b < QSPI_FS_BLOCKS; b++)
+    {
+        uint32_t n = QspiSim_EraseCount(QSPI_FS_BASE / QSPI_FS_BLOCK + b);
+
+        if ((b < QSPI_FS_SUPER_BLOCKS) || (n != erase[b]) ||
+            (b == (QspiSim_PowerLossAddr - QSPI_FS_BASE) / QSPI_FS_BLOCK))
+        {
+            memcpy(QspiSim_Memory(QSPI_FS_BASE + b * QSPI_FS_BLOCK), &image[b * QSPI_FS_BLOCK],
+                   QSPI_FS_BLOCK);
+            erase[b] = n;
+        }
+    }
+}
+
+/*!@brief Inject a power loss at each step of the workload and check recovery. The area is
+ *        filled up to BENCH_LOSS_FREE free blocks, blocks freed by a commit are soon reused.
+ */
+static void Bench_runPowerLoss(void)
+{
+    static uint32_t     erase[QSPI_FS_BLOCKS];
+    uint8_t *           image = malloc(QSPI_FS_SIZE);
+    QSPI_FS_FileTypeDef file;
+    uint32_t            fail_mount = 0;
+    uint32_t            fail_data  = 0;
+    uint32_t            fail_next  = 0;
+    uint32_t            torn       = 0; //!< Interrupted commits found committed
+    uint32_t            ops;
+    uint32_t            commits;
+
+    // Initial files, then the state the workload starts from.
+    QspiSim_EraseAll();
+    Bsp_Qspi_CacheInvalidate(0, N25Q128A_FLASH_SIZE);
+    Bench_Error += (QSPI_FS_Format() != QSPI_FS_OK);
+    memset(&Bench_Model, 0, sizeof(Bench_Model));
+    memset(Bench_Buf, 0xC0, sizeof(Bench_Buf));
+    for (uint32_t i = 0; i < BENCH_LOSS_COLD; i++)
+    {
+        uint32_t blocks = (QSPI_FS_BLOCKS - QSPI_FS_SUPER_BLOCKS - BENCH_LOSS_FREE) /
+                          BENCH_LOSS_COLD;
+
+        snprintf((char *)Bench_Read, QSPI_FS_NAME_MAX, "cold%u", i);
+        Bench_Error += (QSPI_FS_Open(&file, (char *)Bench_Read, QSPI_FS_WRITE | QSPI_FS_CREATE) !=
+                        QSPI_FS_OK);
+        for (uint32_t k = 0; k < blocks; k++)
+        {
+            Bench_Error += (QSPI_FS_Write(&file, Bench_Buf, QSPI_FS_BLOCK) != QSPI_FS_BLOCK);
+        }
+        Bench_Error += (QSPI_FS_Close(&file) != QSPI_FS_OK);
+    }
+    HalSim_Seed(0xF111);
+    for (uint32_t f = 0; f < BENCH_LOSS_FILES; f++)
+    {
+        Bench_Error += (QSPI_FS_Open(&file, Bench_LossName[f], QSPI_FS_WRITE | QSPI_FS_CREATE) !=
+                        QSPI_FS_OK);
+        Bench_Model.Exist[f] = 1;
+        Bench_Error += Bench_lossWrite(&file, f, 1000 + 2000 * f);
+        Bench_Error += (QSPI_FS_Close(&file) != QSPI_FS_OK);
+    }
+    memcpy(&Bench_Commit[0], &Bench_Model, sizeof(Bench_Model));
+    memcpy(image, QspiSim_Memory(QSPI_FS_BASE), QSPI_FS_SIZE);
+    for (uint32_t b = 0; b < QSPI_FS_BLOCKS; b++)
+    {
+        erase[b] = QspiSim_EraseCount(QSPI_FS_BASE / QSPI_FS_BLOCK + b);
+    }
+
+    // Dry run to count the steps.
+    Bench_Error += (Bench_powerUp() != QSPI_FS_OK);
+    uint32_t step = QspiSim_Stat.StepCount;
+    HalSim_Seed(0xC0FFEE);
+    Bench_Commits = 0;
+    ops           = Bench_lossWorkload();
+    commits       = Bench_Commits;
+    Bench_Error += (Bench_lossVerify(&Bench_Model) != 0);
+    uint32_t steps = QspiSim_Stat.StepCount - step;
+
+    double cpu = HalSim_GetCpuTime();
+    for (uint32_t loss = 1; loss <= steps; loss++)
+    {
+        Bench_lossRestore(image, erase);
+        memcpy(&Bench_Model, &Bench_Commit[0], sizeof(Bench_Model));
+        Bench_powerUp();
+
+        HalSim_Seed(0xC0FFEE);
+        Bench_Commits = 0;
+        QspiSim_PowerLoss(QspiSim_Stat.StepCount + loss, loss);
+        Bench_lossWorkload();
+        QspiSim_PowerLoss(0, 0);
+
+        if (Bench_powerUp() != QSPI_FS_OK)
+        {
+            fail_mount++;
+            continue;
+        }
+
+        if (Bench_lossVerify(&Bench_Commit[Bench_Commits]) != 0)
+        {
+            if ((Bench_Commits == commits) ||
+                (Bench_lossVerify(&Bench_Commit[Bench_Commits + 1]) != 0))
+            {
+                fail_data++;
+                continue;
+            }
+            torn++;
+        }
+
+        // File system is still usable after recovery, and mounts again.
+        if ((QSPI_FS_Open(&file, "next", QSPI_FS_WRITE | QSPI_FS_CREATE) != QSPI_FS_OK) ||
+            (QSPI_FS_Write(&file, &loss, sizeof(loss)) != sizeof(loss)) ||
+            (QSPI_FS_Close(&file) != QSPI_FS_OK) || (Bench_powerUp() != QSPI_FS_OK) ||
+            (QSPI_FS_Open(&file, "next", QSPI_FS_READ) != QSPI_FS_OK) ||
+            (QSPI_FS_Read(&file, &step, sizeof(step)) != sizeof(step)) || (step != loss) ||
+            (QSPI_FS_Close(&file) != QSPI_FS_OK))
+        {
+            fail_next++;
+        }
+    }
+    cpu = HalSim_GetCpuTime() - cpu;
+    free(image);
+
+    printf("\nPower loss: %u operations, %u commits, %u steps, %.0f ms\n", ops, commits, steps,
+           cpu * 1000);
+    printf("Interrupted commit found done : %u\n", torn);
+    printf("Mount fail : %u\nData fail  : %u\nNext fail  : %u\n%s\n", fail_mount, fail_data,
+           fail_next, (fail_mount + fail_data + fail_next) ? "FAIL" : "PASS");
+    Bench_Error += fail_mount + fail_data + fail_next;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t commits = (argc > 1) ? atoi(argv[1]) : BENCH_COMMITS;
+
+    if ((argc > 2) && (strcmp(argv[2], "max") == 0))
+    {
+        QspiSim_Timing.Program8       = QSPI_SIM_TIME_PROGRAM_8_MAX;
+        QspiSim_Timing.SubsectorErase = QSPI_SIM_TIME_SUBSECTOR_ERASE_MAX;
+        QspiSim_Timing.SectorErase    = QSPI_SIM_TIME_SECTOR_ERASE_MAX;
+        QspiSim_Timing.ChipErase      = QSPI_SIM_TIME_CHIP_ERASE_MAX;
+        QspiSim_Timing.Suspend        = QSPI_SIM_TIME_SUSPEND_MAX;
+    }
+
+    if (QspiSim_Init() != 0)
+    {
+        return -1;
+    }
+
+    printf("QSPI FS : %u blocks of %u bytes @ 0x%08X, %u files, %s timing\n", QSPI_FS_BLOCKS,
+           QSPI_FS_BLOCK, QSPI_FS_BASE, QSPI_FS_FILES, (argc > 2) ? argv[2] : "typ");
+
+    Bench_Error += (QSPI_FS_Mount() != QSPI_FS_NOFS);
+    Bench_runMounts();
+    Bench_runThroughput();
+    Bench_runWear(commits);
+
+    // Transfers fail on purpose from here on, once power is lost.
+    Bench_Error += Qspi_Stat.Error + QspiSim_Stat.ErrorCount;
+    Bench_runPowerLoss();
+
+    printf("\nVerify  : %s\n", Bench_Error ? "FAIL" : "PASS");
+    return 0;
+}
@@ -0,0 +1,423 @@
+/******************************************************************************
+ * @file    qspi_map_bench.c
+ * @brief   Host benchmark of memory-mapped vs indirect QSPI reads (bsp_qspi.c on simulated
+ *          N25Q128A).
+ *
+ *          Streaming: a consumer reads 1 MB of assets in chunks, or looks up 16 bytes at
+ *          random, either indirect by Bsp_Qspi_Read() (block cache, DMA) into a buffer, or
+ *          in place through a pointer of Bsp_Qspi_Map(). Time is the simulated time, CPU
+ *          the part the consumer doesn't sleep: loads through the window stall the CPU.
+ *
+ *          Updates: players map a clip, check it, hold it while it plays and check it did
+ *          not change, while an updater rewrites clips, erase then write, queued together.
+ *          Players see the last version written, updates wait for the players to drain.
+ *          Requests are submitted by interrupts and completion callbacks, the queue is
+ *          served as the I/O task does.
+ *
+ *          Reset: Bsp_Qspi_Reset() while mapped idle, indirect reads must follow, then the
+ *          window is mapped again.
+ *
+ *          Usage: qspi_map_bench [s]
+ *          s is the simulated time of each update configuration, default 10.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp_qspi.h"
+#include "bsp_qspi_cache.h"
+#include "cmsis_os.h"
+#include "hal_sim.h"
+#include "qspi_sim.h"
+
+// clang-format off
+#define BENCH_TIME_S            10          //!< Default simulated time of an update configuration
+#define BENCH_AREA              0x000000    //!< Assets of the streaming phase
+#define BENCH_AREA_SIZE         0x100000
+#define BENCH_LOOKUPS           20000       //!< Lookups of the random workload
+#define BENCH_LOOKUP_SIZE       16
+#define BENCH_CLIP_BASE         0x400000    //!< Clips of the update phase
+#define BENCH_CLIPS             8
+#define BENCH_CLIP_SIZE         0x4000      //!< 4 subsectors
+#define BENCH_PLAYERS           2
+#define BENCH_PLAY_US           20000       //!< Time a player holds a clip
+#define BENCH_PLAY_GAP_US       10000       //!< Max us between plays
+#define BENCH_UPDATE_GAP_US     2000000     //!< Max us between updates
+#define BENCH_TICK_US           1000        //!< Period of the player and updater interrupt
+// clang-format on
+
+typedef struct {
+    Qspi_ReqTypeDef Req;
+    uint64_t        Time;    //!< Map submit time, end of play once mapped
+    uint64_t        Next;    //!< Time of the next play
+    uint32_t        Clip;
+    uint32_t        Version; //!< Version seen when mapped
+    uint8_t         Active;  //!< Map submitted or clip held
+} Bench_PlayerTypeDef;
+
+static uint32_t            Bench_Error = 0;
+static uint64_t            Bench_End   = 0; //!< Plays and updates stop at this time
+static Bench_PlayerTypeDef Bench_Player[BENCH_PLAYERS];
+static uint32_t            Bench_Version[BENCH_CLIPS];
+static uint32_t            Bench_Plays   = 0;
+static uint32_t            Bench_Stale   = 0; //!< Plays seeing another version or a change
+static uint64_t            Bench_MapWait = 0; //!< Sum of map latency in us
+static uint64_t            Bench_MapMax  = 0;
+static Qspi_ReqTypeDef     Bench_Erase;
+static Qspi_ReqTypeDef     Bench_Write;
+static uint8_t             Bench_Data[BENCH_CLIP_SIZE];
+static uint32_t            Bench_Clip    = 0; //!< Clip being updated
+static uint64_t            Bench_Start   = 0; //!< Submit time of the update
+static uint8_t             Bench_Busy    = 0; //!< Update in flight
+static uint64_t            Bench_UpdNext = 0; //!< Time of the next update
+static uint8_t             Bench_Tick    = 0; //!< Tick interrupt pending
+static uint32_t            Bench_Updates = 0;
+static uint32_t            Bench_Drains  = 0; //!< Updates submitted while a clip is held
+static uint64_t            Bench_UpdWait = 0; //!< Sum of update latency in us
+static uint64_t            Bench_UpdMax  = 0;
+
+/*!@brief Byte of a clip version.
+ */
+static uint8_t Bench_pattern(uint32_t clip, uint32_t version, uint32_t i)
+{
+    return (uint8_t)(i * 31 + clip * 7 + version * 13 + (i >> 8));
+}
+
+/*!@brief Check a clip holds a version.
+ */
+static uint8_t Bench_check(const uint8_t *data, uint32_t clip, uint32_t version)
+{
+    for (uint32_t i = 0; i < BENCH_CLIP_SIZE; i++)
+    {
+        if (data[i] != Bench_pattern(clip, version, i))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*!@brief Stream the asset area in chunks, or look up random bytes, and print the figures.
+ *
+ * @param chunk  : Bytes per read, BENCH_LOOKUP_SIZE at random addresses if lookup.
+ * @param mapped : Read in place through the window, else by Bsp_Qspi_Read().
+ */
+static void Bench_stream(const char *name, uint32_t chunk, uint8_t lookup, uint8_t mapped)
+{
+    static uint8_t buf[0x8000];
+    uint32_t       reads = lookup ? BENCH_LOOKUPS : BENCH_AREA_SIZE / chunk;
+    uint32_t       cmd   = QspiSim_Stat.ReadCount + QspiSim_Stat.MapFetch;
+    uint64_t       total = 0;
+    uint64_t       time;
+    uint64_t       idle;
+    const uint8_t *map = NULL;
+
+    HalSim_Seed(1);
+    Bsp_Qspi_CacheInvalidate(0, N25Q128A_FLASH_SIZE);
+    time = HalSim_GetTime();
+    idle = HalSim_IdleTime;
+
+    if (mapped)
+    {
+        map = Bsp_Qspi_Map(BENCH_AREA, BENCH_AREA_SIZE);
+        Bench_Error += (map != QspiSim_Memory(BENCH_AREA));
+    }
+    for (uint32_t i = 0; (i < reads) && (!mapped || (map != NULL)); i++)
+    {
+        uint32_t addr = lookup ? HalSim_Rand() % (BENCH_AREA_SIZE - chunk) : i * chunk;
+
+        if (mapped)
+        {
+            // The consumer uses the data in place, the sim adds the time of its loads.
+            Bench_Error += (QspiSim_MapRead(BENCH_AREA + addr, chunk) != QSPI_OK);
+        }
+        else
+        {
+            Bench_Error += (Bsp_Qspi_Read(buf, BENCH_AREA + addr, chunk) != QSPI_OK);
+            Bench_Error += (memcmp(buf, QspiSim_Memory(BENCH_AREA + addr), chunk) != 0);
+        }
+        total += chunk;
+    }
+    if (map != NULL)
+    {
+        Bsp_Qspi_Release();
+        // The I/O task runs on the release.
+        Bsp_Qspi_Process();
+    }
+
+    time = HalSim_GetTime() - time;
+    idle = HalSim_IdleTime - idle;
+    cmd  = QspiSim_Stat.ReadCount + QspiSim_Stat.MapFetch - cmd;
+    time = (time == 0) ? 1 : time;
+    printf("%-12s %-8s | %8.2f | %6.2f | %8.2f | %3.0f%% | %7u\n", name,
+           mapped ? "mapped" : "indirect", time / 1000.0, (double)total / time,
+           (time - idle) / 1000.0, 100.0 * (time - idle) / time, cmd);
+}
+
+/*!@brief A clip is mapped: check it holds the last version written, play it.
+ */
+static void Bench_playMapped(Qspi_ReqTypeDef *req)
+{
+    Bench_PlayerTypeDef *player = (Bench_PlayerTypeDef *)req;
+    uint64_t             wait   = HalSim_GetTime() - player->Time;
+
+    if (req->Status != QSPI_OK)
+    {
+        Bench_Error++;
+        player->Active = 0;
+        return;
+    }
+
+    Bench_MapWait += wait;
+    Bench_MapMax    = (wait > Bench_MapMax) ? wait : Bench_MapMax;
+    player->Version = Bench_Version[player->Clip];
+    player->Time    = HalSim_GetTime() + BENCH_PLAY_US;
+    Bench_Stale += Bench_check((const uint8_t *)QSPI_MAP_BASE + req->Addr, player->Clip,
+                               player->Version);
+}
+
+/*!@brief Start a play, map a random clip.
+ */
+static void Bench_playStart(Bench_PlayerTypeDef *player)
+{
+    player->Clip   = HalSim_Rand() % BENCH_CLIPS;
+    player->Time   = HalSim_GetTime();
+    player->Active = 1;
+    player->Req    = (Qspi_ReqTypeDef){.Op       = QSPI_OP_MAP,
+                                       .Class    = QSPI_CLASS_INTERACTIVE,
+                                       .Addr     = BENCH_CLIP_BASE + player->Clip * BENCH_CLIP_SIZE,
+                                       .Size     = BENCH_CLIP_SIZE,
+                                       .Callback = Bench_playMapped};
+    if (Bsp_Qspi_Submit(&player->Req) != QSPI_OK)
+    {
+        Bench_Error++;
+        player->Active = 0;
+    }
+}
+
+/*!@brief End of a play: the clip must not have changed, release it.
+ */
+static void Bench_playEnd(Bench_PlayerTypeDef *player)
+{
+    Bench_Stale += (player->Version != Bench_Version[player->Clip]) ||
+                   Bench_check(QspiSim_Memory(player->Req.Addr), player->Clip, player->Version);
+    Bench_Plays++;
+    player->Active = 0;
+    player->Next   = HalSim_GetTime() + HalSim_Rand() % BENCH_PLAY_GAP_US;
+    Bsp_Qspi_Release();
+}
+
+/*!@brief End of an update, the new version is the one to read.
+ */
+static void Bench_updateDone(Qspi_ReqTypeDef *req)
+{
+    uint64_t wait = HalSim_GetTime() - Bench_Start;
+
+    Bench_Error += (Bench_Erase.Status != QSPI_OK) || (req->Status != QSPI_OK);
+    Bench_Version[Bench_Clip]++;
+    Bench_Updates++;
+    Bench_UpdWait += wait;
+    Bench_UpdMax  = (wait > Bench_UpdMax) ? wait : Bench_UpdMax;
+    Bench_Busy    = 0;
+    Bench_UpdNext = HalSim_GetTime() + HalSim_Rand() % BENCH_UPDATE_GAP_US;
+}
+
+/*!@brief Rewrite a random clip with its next version, erase and write queued together.
+ */
+static void Bench_updateStart(void)
+{
+    uint32_t addr;
+
+    Bench_Clip = HalSim_Rand() % BENCH_CLIPS;
+    addr       = BENCH_CLIP_BASE + Bench_Clip * BENCH_CLIP_SIZE;
+    for (uint32_t i = 0; i < BENCH_CLIP_SIZE; i++)
+    {
+        Bench_Data[i] = Bench_pattern(Bench_Clip, Bench_Version[Bench_Clip] + 1, i);
+    }
+    for (uint32_t p = 0; p < BENCH_PLAYERS; p++)
+    {
+        if (Bench_Player[p].Active)
+        {
+            Bench_Drains++;
+            break;
+        }
+    }
+
+    Bench_Erase = (Qspi_ReqTypeDef){
+        .Op = QSPI_OP_ERASE, .Class = QSPI_CLASS_BACKGROUND, .Addr = addr, .Size = BENCH_CLIP_SIZE};
+    Bench_Write = (Qspi_ReqTypeDef){.Op       = QSPI_OP_WRITE,
+                                    .Class    = QSPI_CLASS_BACKGROUND,
+                                    .Data     = Bench_Data,
+                                    .Addr     = addr,
+                                    .Size     = BENCH_CLIP_SIZE,
+                                    .Callback = Bench_updateDone};
+    Bench_Start = HalSim_GetTime();
+    Bench_Busy  = 1;
+    if ((Bsp_Qspi_Submit(&Bench_Erase) != QSPI_OK) || (Bsp_Qspi_Submit(&Bench_Write) != QSPI_OK))
+    {
+        Bench_Error++;
+        Bench_Busy = 0;
+    }
+}
+
+/*!@brief Tick interrupt of the players and the updater, stops at the end time once all
+ *        plays and updates are done.
+ */
+static void Bench_tick(void)
+{
+    uint64_t now    = HalSim_GetTime();
+    uint8_t  active = 0;
+
+    for (uint32_t p = 0; p < BENCH_PLAYERS; p++)
+    {
+        Bench_PlayerTypeDef *player = &Bench_Player[p];
+
+        if (!player->Active && (now >= player->Next) && (now < Bench_End))
+        {
+            Bench_playStart(player);
+        }
+        else if (player->Active && (player->Req.Status != QSPI_BUSY) && (now >= player->Time))
+        {
+            Bench_playEnd(player);
+        }
+        active |= player->Active;
+    }
+    if (!Bench_Busy && (now >= Bench_UpdNext) && (now < Bench_End))
+    {
+        Bench_updateStart();
+    }
+
+    Bench_Tick = (now < Bench_End) || active || Bench_Busy;
+    if (Bench_Tick)
+    {
+        HalSim_SetIrq(now + BENCH_TICK_US, Bench_tick);
+    }
+}
+
+/*!@brief Serve the queue as the I/O task does, until the tick stops and the queue is idle.
+ */
+static void Bench_serve(void)
+{
+    for (;;)
+    {
+        uint32_t ms  = Bsp_Qspi_Process();
+        uint64_t now = HalSim_GetTime();
+
+        if ((ms == osWaitForever) && !Bench_Tick)
+        {
+            return;
+        }
+        HalSim_Idle((ms == osWaitForever) ? UINT64_MAX : now + (uint64_t)ms * 1000);
+    }
+}
+
+/*!@brief Run players against the updater for one configuration and print the figures.
+ */
+static void Bench_runUpdate(uint8_t idle, uint32_t sec)
+{
+    uint64_t start = HalSim_GetTime();
+
+    Qspi_Stat     = (Qspi_StatTypeDef){0};
+    Bench_Plays   = 0;
+    Bench_MapWait = 0;
+    Bench_MapMax  = 0;
+    Bench_Updates = 0;
+    Bench_Drains  = 0;
+    Bench_UpdWait = 0;
+    Bench_UpdMax  = 0;
+    Bench_End     = start + (uint64_t)sec * 1000000;
+    Bench_UpdNext = start + HalSim_Rand() % BENCH_UPDATE_GAP_US;
+    for (uint32_t p = 0; p < BENCH_PLAYERS; p++)
+    {
+        Bench_Player[p].Next = start + HalSim_Rand() % BENCH_PLAY_GAP_US;
+    }
+    Bsp_Qspi_MapMode(idle);
+
+    Bench_Tick = 1;
+    HalSim_SetIrq(start, Bench_tick);
+    Bench_serve();
+
+    if ((Bench_Plays == 0) || (Bench_Updates == 0))
+    {
+        Bench_Error++;
+        return;
+    }
+    printf("%-8s | %5u | %6.2f | %7.2f | %7u | %6u | %7.2f | %7.2f | %4u | %5u\n",
+           idle ? "mapped" : "indirect", Bench_Plays, Bench_MapWait / 1000.0 / Bench_Plays,
+           Bench_MapMax / 1000.0, Bench_Updates, Bench_Drains,
+           Bench_UpdWait / 1000.0 / Bench_Updates, Bench_UpdMax / 1000.0, Qspi_Stat.Map,
+           Qspi_Stat.Unmap);
+    Bench_Error += Qspi_Stat.Error;
+}
+
+/*!@brief Re-init while mapped idle, the scheduler must read indirect after it and map again.
+ */
+static void Bench_reset(void)
+{
+    uint32_t map  = Qspi_Stat.Map;
+    uint8_t  ret  = Bsp_Qspi_Reset();
+    uint8_t  read = (Bsp_Qspi_Read(Bench_Data, BENCH_CLIP_BASE, BENCH_CLIP_SIZE) == QSPI_OK) &&
+                   (memcmp(Bench_Data, QspiSim_Memory(BENCH_CLIP_BASE), BENCH_CLIP_SIZE) == 0);
+
+    Bench_serve();
+    printf("Reset   : %s, read %s, %s\n", (ret == QSPI_OK) ? "OK" : "failed",
+           read ? "OK" : "failed", (Qspi_Stat.Map > map) ? "mapped again" : "not mapped");
+    Bench_Error += (ret != QSPI_OK) || !read || (Qspi_Stat.Map == map);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t sec = (argc > 1) ? atoi(argv[1]) : BENCH_TIME_S;
+
+    if ((sec == 0) || (QspiSim_Init() != 0))
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < BENCH_AREA_SIZE; i++)
+    {
+        *QspiSim_Memory(BENCH_AREA + i) = (uint8_t)(i * 7 + (i >> 12));
+    }
+    for (uint32_t c = 0; c < BENCH_CLIPS; c++)
+    {
+        for (uint32_t i = 0; i < BENCH_CLIP_SIZE; i++)
+        {
+            *QspiSim_Memory(BENCH_CLIP_BASE + c * BENCH_CLIP_SIZE + i) = Bench_pattern(c, 0, i);
+        }
+    }
+
+    printf("QSPI memory-mapped vs indirect reads, %u MHz quad bus, %u kB of assets\n",
+           QSPI_SIM_CLOCK_MHZ, BENCH_AREA_SIZE / 1024);
+    printf("\nWorkload     Mode     | Time(ms) |  MB/s  |  CPU(ms) |  CPU | Commands\n");
+    Bench_stream("Stream 64 B", 64, 0, 0);
+    Bench_stream("Stream 64 B", 64, 0, 1);
+    Bench_stream("Stream 512 B", 512, 0, 0);
+    Bench_stream("Stream 512 B", 512, 0, 1);
+    Bench_stream("Stream 4 kB", 4096, 0, 0);
+    Bench_stream("Stream 4 kB", 4096, 0, 1);
+    Bench_stream("Stream 32 kB", 32768, 0, 0);
+    Bench_stream("Stream 32 kB", 32768, 0, 1);
+    Bench_stream("Lookup 16 B", BENCH_LOOKUP_SIZE, 1, 0);
+    Bench_stream("Lookup 16 B", BENCH_LOOKUP_SIZE, 1, 1);
+
+    printf("\nUpdates: %u players hold a %u kB clip %u ms, a clip is rewritten every %u ms "
+           "average, %u s each\n",
+           BENCH_PLAYERS, BENCH_CLIP_SIZE / 1024, BENCH_PLAY_US / 1000,
+           BENCH_UPDATE_GAP_US / 2000, sec);
+    printf("Idle     | Plays | Map ms |  max ms | Updates | Drains |  Upd ms |  max ms |  Map | "
+           "Unmap\n");
+    Bench_runUpdate(0, sec);
+    Bench_runUpdate(1, sec);
+    Bench_reset();
+
+    printf("\nStale plays : %u\n", Bench_Stale);
+    printf("Verify  : %s\n",
+           (Bench_Error || Bench_Stale || Qspi_Stat.Error || QspiSim_Stat.ErrorCount) ? "FAIL"
+                                                                                       : "PASS");
+    return 0;
+}
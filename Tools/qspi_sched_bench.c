@@ -0,0 +1,347 @@
+/******************************************************************************
+ * @file    qspi_sched_bench.c
+ * @brief   Host benchmark of the QSPI I/O scheduler (bsp_qspi.c on simulated N25Q128A).
+ *
+ *          Tail latency: interactive reads arrive at random times while a garbage
+ *          collection runs in background, erasing a subsector, copying 4 kB into it
+ *          by reads and page programs, and so on. Read latency percentiles and erases
+ *          per second of the collection are compared for:
+ *          - FIFO: reads queued with the collection, in submit order.
+ *          - Priority: reads served before background requests, erases run to the end.
+ *          - Suspend: priority, and erases / page programs suspended for the reads.
+ *
+ *          Merge: a burst of small writes to one page, queued before the I/O runs, is
+ *          programmed by one page program.
+ *
+ *          The queue is served as the I/O task does: Bsp_Qspi_Process(), then sleep
+ *          until an interrupt or the time it returns. Requests are submitted by the
+ *          arrival interrupt and by completion callbacks.
+ *
+ *          Usage: qspi_sched_bench [s] [typ|max]
+ *          s is the simulated time of each configuration, default 20. max uses maximum
+ *          timing of the datasheet instead of typical.
+ *
+ * @author  Nick Yang
+ * @date    2026/10/19
+ * @version V0.1
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp_qspi.h"
+#include "cmsis_os.h"
+#include "hal_sim.h"
+#include "qspi_sim.h"
+
+// clang-format off
+#define BENCH_TIME_S            20          //!< Default simulated time of a configuration
+#define BENCH_READ_AREA         0x000000    //!< Area of interactive reads, never written
+#define BENCH_READ_AREA_SIZE    0x400000
+#define BENCH_READ_SIZE         512         //!< Bytes of an interactive read
+#define BENCH_READ_PERIOD       40000       //!< Max us between read arrivals, 20 ms average
+#define BENCH_READS             32          //!< Reads in flight at a time, more are dropped
+#define BENCH_GC_SRC            0x400000    //!< Live data copied by the collection
+#define BENCH_GC_DST            0x800000    //!< Subsectors erased and written by the collection
+#define BENCH_GC_SUBSECTORS     64
+#define BENCH_MERGE_ADDR        0xC00000    //!< Page of the merge phase
+#define BENCH_MERGE_WRITES      16          //!< Writes of the burst
+// clang-format on
+
+typedef struct {
+    Qspi_ReqTypeDef Req;
+    uint64_t        Time; //!< Submit time in us
+    uint8_t         Data[BENCH_READ_SIZE];
+} Bench_ReadTypeDef;
+
+/*!@enum Bench_GcStepTypeDef
+ *          Step of the collection of one subsector.
+ */
+typedef enum { BENCH_GC_ERASE, BENCH_GC_READ, BENCH_GC_WRITE } Bench_GcStepTypeDef;
+
+static uint64_t          Bench_End  = 0; //!< Arrivals and collection stop at this time
+static Bench_ReadTypeDef Bench_Read[BENCH_READS];
+static uint32_t          Bench_Busy    = 0; //!< Reads in flight
+static uint32_t         *Bench_Time    = NULL; //!< Latency of each read in us
+static uint32_t          Bench_Count   = 0;
+static uint32_t          Bench_Max     = 0; //!< Size of Bench_Time
+static uint32_t          Bench_Drop    = 0; //!< Arrivals with all reads in flight
+static uint32_t          Bench_Error   = 0;
+static Qspi_ReqTypeDef   Bench_Gc      = {0};
+static Bench_GcStepTypeDef Bench_GcStep = BENCH_GC_ERASE;
+static uint32_t          Bench_GcSub   = 0; //!< Subsector being collected
+static uint32_t          Bench_GcErase = 0; //!< Erases done
+static uint32_t          Bench_GcCopy  = 0; //!< Subsectors copied
+static uint8_t           Bench_GcActive = 0;
+static uint8_t           Bench_GcBuf[N25Q128A_SUBSECTOR_SIZE];
+static uint8_t           Bench_ReadClass = QSPI_CLASS_INTERACTIVE;
+
+static int Bench_compare(const void *a, const void *b)
+{
+    return (*(uint32_t *)a > *(uint32_t *)b) - (*(uint32_t *)a < *(uint32_t *)b);
+}
+
+/*!@brief Completion of an interactive read, record its latency and check its data.
+ */
+static void Bench_readDone(Qspi_ReqTypeDef *req)
+{
+    Bench_ReadTypeDef *read = (Bench_ReadTypeDef *)req;
+
+    if ((req->Status != QSPI_OK) ||
+        (memcmp(read->Data, QspiSim_Memory(req->Addr), req->Size) != 0))
+    {
+        Bench_Error++;
+    }
+    if (Bench_Count < Bench_Max)
+    {
+        Bench_Time[Bench_Count++] = HalSim_GetTime() - read->Time;
+    }
+    req->Size = 0;
+    Bench_Busy--;
+}
+
+/*!@brief Arrival interrupt, submit a read of a random area and raise the next arrival.
+ */
+static void Bench_arrival(void)
+{
+    uint64_t now = HalSim_GetTime();
+    uint32_t i   = 0;
+
+    while ((i < BENCH_READS) && (Bench_Read[i].Req.Size != 0))
+    {
+        i++;
+    }
+
+    if (i == BENCH_READS)
+    {
+        Bench_Drop++;
+    }
+    else
+    {
+        Qspi_ReqTypeDef *req = &Bench_Read[i].Req;
+
+        memset(req, 0, sizeof(*req));
+        req->Op       = QSPI_OP_READ;
+        req->Class    = Bench_ReadClass;
+        req->Data     = Bench_Read[i].Data;
+        req->Addr     = BENCH_READ_AREA + HalSim_Rand() % (BENCH_READ_AREA_SIZE - BENCH_READ_SIZE);
+        req->Size     = BENCH_READ_SIZE;
+        req->Callback = Bench_readDone;
+        Bench_Read[i].Time = now;
+        Bench_Busy++;
+        if (Bsp_Qspi_Submit(req) != QSPI_OK)
+        {
+            Bench_Error++;
+            req->Size = 0;
+            Bench_Busy--;
+        }
+    }
+
+    if (now < Bench_End)
+    {
+        HalSim_SetIrq(now + 1 + HalSim_Rand() % BENCH_READ_PERIOD, Bench_arrival);
+    }
+}
+
+/*!@brief Submit the next step of the collection, from the completion of the previous one.
+ */
+static void Bench_gcNext(Qspi_ReqTypeDef *req)
+{
+    uint32_t dst = BENCH_GC_DST + Bench_GcSub * N25Q128A_SUBSECTOR_SIZE;
+    uint32_t src = BENCH_GC_SRC + Bench_GcSub * N25Q128A_SUBSECTOR_SIZE;
+
+    if ((req != NULL) && (req->Status != QSPI_OK))
+    {
+        Bench_Error++;
+    }
+    if ((req != NULL) && (req->Op == QSPI_OP_WRITE))
+    {
+        Bench_GcCopy++;
+    }
+
+    // A collection started runs to the end of its subsector.
+    if ((Bench_GcStep == BENCH_GC_ERASE) && (HalSim_GetTime() >= Bench_End))
+    {
+        Bench_GcActive = 0;
+        return;
+    }
+
+    memset(&Bench_Gc, 0, sizeof(Bench_Gc));
+    Bench_Gc.Class    = QSPI_CLASS_BACKGROUND;
+    Bench_Gc.Size     = N25Q128A_SUBSECTOR_SIZE;
+    Bench_Gc.Callback = Bench_gcNext;
+
+    switch (Bench_GcStep)
+    {
+    case BENCH_GC_ERASE:
+        Bench_Gc.Op   = QSPI_OP_ERASE;
+        Bench_Gc.Addr = dst;
+        Bench_GcStep  = BENCH_GC_READ;
+        break;
+
+    case BENCH_GC_READ:
+        Bench_GcErase++;
+        Bench_Gc.Op   = QSPI_OP_READ;
+        Bench_Gc.Data = Bench_GcBuf;
+        Bench_Gc.Addr = src;
+        Bench_GcStep  = BENCH_GC_WRITE;
+        break;
+
+    default:
+        Bench_Gc.Op   = QSPI_OP_WRITE;
+        Bench_Gc.Data = Bench_GcBuf;
+        Bench_Gc.Addr = dst;
+        Bench_GcStep  = BENCH_GC_ERASE;
+        Bench_GcSub   = (Bench_GcSub + 1) % BENCH_GC_SUBSECTORS;
+        break;
+    }
+
+    Bench_GcActive = 1;
+    if (Bsp_Qspi_Submit(&Bench_Gc) != QSPI_OK)
+    {
+        Bench_Error++;
+        Bench_GcActive = 0;
+    }
+}
+
+/*!@brief Serve the queue as the I/O task does, until the end time and all requests done.
+ */
+static void Bench_serve(void)
+{
+    for (;;)
+    {
+        uint32_t ms  = Bsp_Qspi_Process();
+        uint64_t now = HalSim_GetTime();
+
+        if ((ms == osWaitForever) && (now >= Bench_End) && !Bench_Busy && !Bench_GcActive)
+        {
+            return;
+        }
+
+        uint64_t until = (ms == osWaitForever) ? Bench_End : now + (uint64_t)ms * 1000;
+        HalSim_Idle((until > now) ? until : now + 1000);
+    }
+}
+
+/*!@brief Run reads against the collection for one configuration and print the figures.
+ */
+static void Bench_runConfig(const char *name, uint8_t cls, uint8_t preempt, uint32_t sec)
+{
+    uint64_t start = HalSim_GetTime();
+    uint32_t erase = Bench_GcErase;
+
+    Bench_ReadClass = cls;
+    Qspi_Preempt    = preempt;
+    Qspi_Stat       = (Qspi_StatTypeDef){0};
+    Bench_Count     = 0;
+    Bench_Drop      = 0;
+    Bench_End       = start + (uint64_t)sec * 1000000;
+
+    HalSim_SetIrq(start + HalSim_Rand() % BENCH_READ_PERIOD, Bench_arrival);
+    Bench_gcNext(NULL);
+    Bench_serve();
+
+    if (Bench_Count == 0)
+    {
+        Bench_Error++;
+        return;
+    }
+    qsort(Bench_Time, Bench_Count, sizeof(uint32_t), Bench_compare);
+    printf("%-9s| %6u | %4u | %8u | %8u | %8.2f | %9.2f | %6u\n", name, Bench_Count, Bench_Drop,
+           Bench_Time[Bench_Count / 2], Bench_Time[Bench_Count * 99 / 100],
+           Bench_Time[Bench_Count - 1] / 1000.0,
+           (Bench_GcErase - erase) * 1e6 / (HalSim_GetTime() - start), Qspi_Stat.Suspend);
+    Bench_Error += Qspi_Stat.Error;
+}
+
+/*!@brief Burst of small writes in one page, queued before the I/O runs.
+ */
+static void Bench_runMerge(void)
+{
+    static Qspi_ReqTypeDef req[BENCH_MERGE_WRITES];
+    static uint8_t         data[N25Q128A_PAGE_SIZE];
+    uint32_t               size = N25Q128A_PAGE_SIZE / BENCH_MERGE_WRITES;
+    uint64_t               time = HalSim_GetTime();
+
+    Qspi_Stat = (Qspi_StatTypeDef){0};
+    for (uint32_t i = 0; i < N25Q128A_PAGE_SIZE; i++)
+    {
+        data[i] = (uint8_t)(i * 29 + 3);
+    }
+
+    for (uint32_t i = 0; i < BENCH_MERGE_WRITES; i++)
+    {
+        req[i] = (Qspi_ReqTypeDef){.Op    = QSPI_OP_WRITE,
+                                   .Class = QSPI_CLASS_INTERACTIVE,
+                                   .Data  = &data[i * size],
+                                   .Addr  = BENCH_MERGE_ADDR + i * size,
+                                   .Size  = size};
+        Bench_Error += (Bsp_Qspi_Submit(&req[i]) != QSPI_OK);
+    }
+    Bench_serve();
+
+    for (uint32_t i = 0; i < BENCH_MERGE_WRITES; i++)
+    {
+        Bench_Error += (req[i].Status != QSPI_OK);
+    }
+    Bench_Error += (memcmp(data, QspiSim_Memory(BENCH_MERGE_ADDR), sizeof(data)) != 0);
+
+    printf("\nMerge: %u writes of %u bytes to one page\n", BENCH_MERGE_WRITES, size);
+    printf("Page programs %u, merged writes %u, %.2f ms\n", Qspi_Stat.Page, Qspi_Stat.Merge,
+           (HalSim_GetTime() - time) / 1000.0);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t sec = (argc > 1) ? atoi(argv[1]) : BENCH_TIME_S;
+
+    if ((argc > 2) && (strcmp(argv[2], "max") == 0))
+    {
+        QspiSim_Timing.Program8       = QSPI_SIM_TIME_PROGRAM_8_MAX;
+        QspiSim_Timing.SubsectorErase = QSPI_SIM_TIME_SUBSECTOR_ERASE_MAX;
+        QspiSim_Timing.SectorErase    = QSPI_SIM_TIME_SECTOR_ERASE_MAX;
+        QspiSim_Timing.ChipErase      = QSPI_SIM_TIME_CHIP_ERASE_MAX;
+        QspiSim_Timing.Suspend        = QSPI_SIM_TIME_SUSPEND_MAX;
+    }
+
+    if ((sec == 0) || (QspiSim_Init() != 0))
+    {
+        return -1;
+    }
+    Bench_Max  = sec * 1000000 / (BENCH_READ_PERIOD / 2) * 2 + BENCH_READS;
+    Bench_Time = malloc(Bench_Max * sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < BENCH_GC_SRC + BENCH_GC_SUBSECTORS * N25Q128A_SUBSECTOR_SIZE; i++)
+    {
+        *QspiSim_Memory(i) = (uint8_t)(i * 7 + (i >> 12));
+    }
+
+    printf("QSPI scheduler: %u B reads every %u ms average, collection of %u kB subsectors\n",
+           BENCH_READ_SIZE, BENCH_READ_PERIOD / 2000, N25Q128A_SUBSECTOR_SIZE / 1024);
+    printf("Erase %u us, page program %u us, suspend %u us, %u s each\n",
+           QspiSim_Timing.SubsectorErase, QspiSim_Timing.Program8 * 32, QspiSim_Timing.Suspend,
+           sec);
+
+    printf("\nMode     |  Reads | Drop |  p50(us) |  p99(us) |  Max(ms) | Erases/s | Suspend\n");
+    Bench_runConfig("FIFO", QSPI_CLASS_BACKGROUND, 0, sec);
+    Bench_runConfig("Priority", QSPI_CLASS_INTERACTIVE, 0, sec);
+    Bench_runConfig("Suspend", QSPI_CLASS_INTERACTIVE, 1, sec);
+
+    Bench_runMerge();
+
+    for (uint32_t i = 0; (i < BENCH_GC_SUBSECTORS) && (i < Bench_GcCopy); i++)
+    {
+        uint32_t off = i * N25Q128A_SUBSECTOR_SIZE;
+        Bench_Error += (memcmp(QspiSim_Memory(BENCH_GC_SRC + off), QspiSim_Memory(BENCH_GC_DST + off),
+                               N25Q128A_SUBSECTOR_SIZE) != 0);
+    }
+
+    printf("\nQSPI    : %u errors, %u rejected commands\n", Qspi_Stat.Error,
+           QspiSim_Stat.ErrorCount);
+    printf("Verify  : %s\n", (Bench_Error || Qspi_Stat.Error || QspiSim_Stat.ErrorCount) ? "FAIL"
+                                                                                         : "PASS");
+
+    free(Bench_Time);
+    return 0;
+}
@@ -25,7 +25,15 @@
            (++) Write EEPROM variable using EE_WriteVariableXbits() functions
                 A Clean Up request can be raised as return parameter in case
                 FLASH pages used by EEPROM emulation, are full.
+           (++) Write a set of EEPROM variables atomically using
+                EE_WriteTransaction32bits(). The set is framed by begin and commit
+                markers, EE_Init() discards a set interrupted by a power loss.
+           (++) Write a variable length record using EE_WriteBlob(), and read
+                it using EE_ReadBlob(). Blob data is packed in elements with a
+                single crc, a blob is valid once its header is written.
            (++) Read EEPROM variable using EE_ReadVariableXbits() functions
+           (++) Read a range of EEPROM variables at once using
+                EE_ReadSnapshot32bits(), pages are browsed a single time.
 
       (#) Clean up functions of FLASH pages, used by EEPROM emulation:
            (++) There Two modes of erasing:
@@ -156,6 +164,17 @@ uint16_t uhNbWrittenElements = 0U;                  /*!< Nb of elements written
 uint8_t ubCurrentActivePage = 0U;                   /*!< Current active page (can be active or receive state) */
 uint32_t uwAddressNextWrite = PAGE_HEADER_SIZE;     /*!< Initialize write position just after page header */
 
+/* RAM index from virtual address to latest element, avoid scanning pages on read */
+/* Open addressing by virtual address, 0x0000 is a prohibited virtual address and marks a free slot */
+uint16_t uhIndexVirtAdd[EE_INDEX_SIZE];             /*!< Virtual address of each index slot */
+uint16_t uhIndexElement[EE_INDEX_SIZE];             /*!< Latest element of each index slot, in elements from START_PAGE_ADDRESS */
+uint8_t ubIndexValid = 0U;                          /*!< Index matches flash content, else reads scan the pages */
+
+/* Blob being written, a pages transfer writes it instead of copying its previous version */
+uint8_t* pBlobData = NULL;                          /*!< Data of the blob being written, NULL if none */
+uint16_t uhBlobLength = 0U;                         /*!< Length of the blob being written */
+uint8_t ubBlobId = 0U;                              /*!< Index of the blob being written */
+
 /**
   * @}
   */
@@ -170,9 +189,26 @@ static EE_Status WriteVariable(uint16_t VirtAddress, EE_DATA_TYPE Data);
 static EE_Status VerifyPageFullyErased(uint32_t Address, uint32_t PageSize);
 static uint32_t FindPage(EE_Find_type Operation);
 static EE_Status PagesTransfer(uint16_t VirtAddress, EE_DATA_TYPE Data, EE_Transfer_type type);
+static uint32_t TransferResume(void);
 static EE_Status VerifyPagesFullWriteVariable(uint16_t VirtAddress, EE_DATA_TYPE Data);
 static EE_Status SetPageState(uint32_t Page, EE_State_type State);
 static EE_State_type GetPageState(uint32_t Address);
+static void IndexInit(void);
+static uint32_t IndexFind(uint16_t VirtAddress);
+static void IndexBuild(void);
+static void IndexUpdate(uint16_t VirtAddress, uint32_t Address);
+static uint32_t TransactionMarker(EE_ELEMENT_TYPE Element);
+static EE_Status TransactionDiscard(uint32_t Address);
+static EE_Status TransactionRecover(void);
+static EE_Status VerifyPagesFullWriteElement(EE_ELEMENT_TYPE Element);
+static EE_Status PagesReserve(uint32_t NbElements);
+static uint32_t PreviousElement(uint32_t Address);
+static EE_ELEMENT_TYPE BlobElement(uint8_t* pData, uint16_t Length, uint32_t Index);
+static EE_Status BlobElements(uint32_t Address, uint16_t* pElements);
+static EE_Status BlobWrite(uint8_t Id, uint8_t* pData, uint16_t Length, uint32_t* pChanged);
+static EE_Status BlobLoad(uint32_t Address, uint8_t* pData, uint16_t Size);
+static uint32_t BlobFind(uint8_t Id);
+static EE_Status BlobCopy(uint32_t Address);
 void ConfigureCrc(void);
 uint16_t CalculateCrc(EE_DATA_TYPE Data, uint16_t VirtAddress);
 
@@ -190,7 +226,7 @@ uint16_t CalculateCrc(EE_DATA_TYPE Data, uint16_t VirtAddress);
   *         If a page is in RECEIVE state, resume transfer.
   *         Then if some pages are ERASING state, erase these pages.
   * @param  VirtAddTab Table of virtual addresses defined by user.
-  *           0xFFFF value is prohibited as virtual address.
+  *           0x0000 and values from EE_BLOB_VIRTADDR are prohibited as virtual address.
   * @param  EraseType: Type of erase to apply on page requiring to be erased.
   *         This parameter can be one of the following values:
   *          @arg @ref EE_FORCED_ERASE      pages to erase are erased unconditionnally
@@ -225,15 +261,18 @@ EE_Status EE_Init(uint16_t* VirtAddTab, EE_Erase_type EraseType)
   /* Store Table of Virtual addressess */
   puhVirtAdd = VirtAddTab;
 
-  /* Check the variables definitions: 0x0000 and 0xFFFF value are prohibited */
+  /* Check the variables definitions: 0x0000 and reserved values from EE_BLOB_VIRTADDR are prohibited */
   for (varidx = 0U; varidx < NB_OF_VARIABLES; varidx++)
   {
-    if ((puhVirtAdd[varidx] == 0x0000U) || (puhVirtAdd[varidx] == 0xFFFFU))
+    if ((puhVirtAdd[varidx] == 0x0000U) || (puhVirtAdd[varidx] >= EE_BLOB_VIRTADDR))
     {
       return EE_INVALID_VIRTUALADDRESS;
     }
   }
 
+  /* Prepare RAM index slots, index is built once pages are restored */
+  IndexInit();
+
   /***************************************************************************/
   /* Step 1: Read all lines of the flash pages of eeprom emulation to        */
   /*         delete corrupted lines detectable through NMI                   */
@@ -286,6 +325,18 @@ EE_Status EE_Init(uint16_t* VirtAddTab, EE_Erase_type EraseType)
       to receiving state */
       if (GetPageState(PAGE_ADDRESS(PREVIOUS_PAGE(firstvalidpage))) == STATE_PAGE_ERASING)
       {
+        /* A reset between a full active page set valid and the following page
+           set active looks the same while erasing pages are not cleaned up.
+           Discard first an incomplete transaction at the end of last valid
+           page, the transfer recovery would copy its elements */
+        ubCurrentActivePage = lastvalidpage;
+        uwAddressNextWrite = PAGE_SIZE;
+        if (TransactionRecover() != EE_OK)
+        {
+          return EE_WRITE_ERROR;
+        }
+        uwAddressNextWrite = PAGE_HEADER_SIZE;
+
         if (SetPageState(FOLLOWING_PAGE(lastvalidpage), STATE_PAGE_RECEIVE) != EE_OK)
         {
           return EE_WRITE_ERROR;
@@ -533,7 +584,20 @@ EE_Status EE_Init(uint16_t* VirtAddTab, EE_Erase_type EraseType)
   }
 
   /*********************************************************************/
-  /* Step 8: Perform dummy write '0' to get rid of potential           */
+  /* Step 8: Discard incomplete transaction                            */
+  /*********************************************************************/
+  if (TransactionRecover() != EE_OK)
+  {
+    return EE_WRITE_ERROR;
+  }
+
+  /*********************************************************************/
+  /* Step 9: Build RAM index of latest elements                        */
+  /*********************************************************************/
+  IndexBuild();
+
+  /*********************************************************************/
+  /* Step 10: Perform dummy write '0' to get rid of potential           */
   /*         instability of line value 0xFFFFFFFF consecutive to a     */
   /*         reset during write here                                   */
   /*         Only needed if recovery transfer did not occured          */
@@ -611,6 +675,13 @@ EE_Status EE_Format(EE_Erase_type EraseType)
   ubCurrentActivePage = START_PAGE;
   uwAddressNextWrite = PAGE_HEADER_SIZE; /* Initialize write position just after page header */
 
+  /* All variables are empty, index is valid if virtual addresses are known */
+  if (puhVirtAdd != NULL)
+  {
+    IndexInit();
+    ubIndexValid = 1U;
+  }
+
   return EE_OK;
 }
 
@@ -695,6 +766,292 @@ EE_Status EE_WriteVariable32bits(uint16_t VirtAddress, uint32_t Data)
 {
   return WriteVariable(VirtAddress, (EE_DATA_TYPE) Data);
 }
+
+/**
+  * @brief  Writes/updates a set of variables in EEPROM, all or none of them.
+  *         Elements are appended between a begin and a commit marker, if
+  *         the set does not fit in the half of pages in use, a pages transfer
+  *         is performed before so that the set is never split by a transfer.
+  * @note   If the write is interrupted, the elements already written are
+  *         discarded here in case of flash error, or by EE_Init() after reset.
+  * @warning This function is not reentrant
+  * @param  VirtAddress Table of variable virtual addresses
+  * @param  Data Table of 32bits data to be written
+  * @param  Count Number of variables, 1 to EE_TX_MAX_ELEMENTS
+  * @retval EE_Status
+  *           - EE_OK: on success
+  *           - EE_CLEANUP_REQUIRED: success and user has to trig flash pages cleanup
+  *           - EE error code: if an error occurs
+  */
+EE_Status EE_WriteTransaction32bits(uint16_t* VirtAddress, uint32_t* Data, uint16_t Count)
+{
+  EE_Status status = EE_OK, transfer = EE_OK;
+  uint32_t varidx = 0U, beginaddress = 0U;
+
+  /* Check parameters validity */
+  if ((VirtAddress == NULL) || (Data == NULL) || (Count == 0U) || (Count > EE_TX_MAX_ELEMENTS))
+  {
+    return EE_INVALID_ELEMENT;
+  }
+  for (varidx = 0U; varidx < Count; varidx++)
+  {
+    if ((VirtAddress[varidx] == 0x0000U) || (VirtAddress[varidx] >= EE_BLOB_VIRTADDR))
+    {
+      return EE_INVALID_VIRTUALADDRESS;
+    }
+  }
+
+  /* Elements and markers must not be split by a pages transfer */
+  transfer = PagesReserve(Count + 2U);
+  if ((transfer != EE_OK) && (transfer != EE_CLEANUP_REQUIRED))
+  {
+    return transfer;
+  }
+
+  /* Write begin marker, and keep its address to discard the set on error */
+  status = VerifyPagesFullWriteVariable(EE_TX_VIRTADDR, (EE_DATA_TYPE)(EE_TX_BEGIN | Count));
+  if (status != EE_OK)
+  {
+    return EE_WRITE_ERROR;
+  }
+  beginaddress = PAGE_ADDRESS(ubCurrentActivePage) + uwAddressNextWrite - EE_ELEMENT_SIZE;
+
+  /* Write the variables, then commit marker */
+  for (varidx = 0U; (varidx < Count) && (status == EE_OK); varidx++)
+  {
+    status = VerifyPagesFullWriteVariable(VirtAddress[varidx], (EE_DATA_TYPE) Data[varidx]);
+  }
+  if (status == EE_OK)
+  {
+    status = VerifyPagesFullWriteVariable(EE_TX_VIRTADDR, (EE_DATA_TYPE)(EE_TX_COMMIT | Count));
+  }
+
+  if (status != EE_OK)
+  {
+    /* Discard the incomplete set, if this fails EE_Init() does it after reset */
+    (void)TransactionDiscard(beginaddress);
+    return EE_WRITE_ERROR;
+  }
+
+  /* Return whether a pages transfer occured */
+  return transfer;
+}
+
+/**
+  * @brief  Returns the last stored version of a blob.
+  * @param  Id Blob index, 0 to NB_OF_BLOBS - 1
+  * @param  pData Buffer receiving the blob, up to Size bytes
+  * @param  Size Size of the buffer
+  * @param  pLength Returns the length of the blob, may be more than Size
+  * @retval EE_Status
+  *           - EE_OK: if blob was found
+  *           - EE error code: if an error occurs
+  */
+EE_Status EE_ReadBlob(uint8_t Id, uint8_t* pData, uint16_t Size, uint16_t* pLength)
+{
+  uint32_t address = 0U;
+
+  if ((Id >= NB_OF_BLOBS) || (pData == NULL) || (pLength == NULL))
+  {
+    return EE_INVALID_VIRTUALADDRESS;
+  }
+
+  address = BlobFind(Id);
+  if (address == 0U)
+  {
+    return EE_NO_DATA;
+  }
+
+  *pLength = (uint16_t)(EE_DATA_VALUE(*(__IO EE_ELEMENT_TYPE*)(address)) >> 16U);
+  return BlobLoad(address, pData, Size);
+}
+
+/**
+  * @brief  Returns the last stored data of a range of variables, from the RAM
+  *         index if valid and holding every variable of the range, else in a
+  *         single browse of the pages from the latest element to the oldest one,
+  *         instead of one search per variable.
+  * @param  VirtAddress First virtual address of the range
+  * @param  Count Number of variables in the range
+  * @param  pData Array of Count values, pData[n] receives variable VirtAddress + n
+  * @param  pValid Bitmap of (Count + 31) / 32 words, bit n is set if variable
+  *         VirtAddress + n is found, pData[n] is left unchanged otherwise
+  * @retval EE_Status
+  *           - EE_OK: on success, variables may not be found
+  *           - EE error code: if an error occurs
+  */
+EE_Status EE_ReadSnapshot32bits(uint16_t VirtAddress, uint16_t Count, uint32_t* pData, uint32_t* pValid)
+{
+  EE_ELEMENT_TYPE addressvalue = 0U;
+  uint32_t page = 0U, pageaddress = 0U, counter = 0U, offset = 0U, found = 0U, nbpage = 0U, slot = 0U;
+  EE_State_type pagestate = STATE_PAGE_INVALID;
+
+  if ((pData == NULL) || (pValid == NULL) || (((uint32_t)VirtAddress + Count) > EE_BLOB_VIRTADDR))
+  {
+    return EE_INVALID_VIRTUALADDRESS;
+  }
+  for (counter = 0U; counter < ((Count + 31U) / 32U); counter++)
+  {
+    pValid[counter] = 0U;
+  }
+
+  /* Serve the range from RAM index, virtual address 0x0000 is never written */
+  for (offset = 0U; (ubIndexValid != 0U) && (offset < Count); offset++)
+  {
+    slot = IndexFind((uint16_t)(VirtAddress + offset));
+    if (slot < EE_INDEX_SIZE)
+    {
+      if (uhIndexElement[slot] != EE_INDEX_NONE)
+      {
+        /* A mismatch of virtual address falls back to page browse */
+        addressvalue = (*(__IO EE_ELEMENT_TYPE*)(START_PAGE_ADDRESS + (uhIndexElement[slot] * EE_ELEMENT_SIZE)));
+        if (EE_VIRTUALADDRESS_VALUE(addressvalue) != (VirtAddress + offset))
+        {
+          break;
+        }
+        pData[offset] = (uint32_t)EE_DATA_VALUE(addressvalue);
+        pValid[offset / 32U] |= 1UL << (offset % 32U);
+      }
+    }
+    else if ((VirtAddress + offset) != 0U)
+    {
+      break;
+    }
+  }
+  if ((ubIndexValid != 0U) && (offset == Count))
+  {
+    return EE_OK;
+  }
+  for (counter = 0U; counter < ((Count + 31U) / 32U); counter++)
+  {
+    pValid[counter] = 0U;
+  }
+
+  /* Get active Page for read operation */
+  page = FindPage(FIND_READ_PAGE);
+  if (page == EE_NO_PAGE_FOUND)
+  {
+    return EE_ERROR_NOACTIVE_PAGE;
+  }
+  pageaddress = PAGE_ADDRESS(page);
+  pagestate = GetPageState(pageaddress);
+
+  /* Browse pages from the latest one, and elements from the end of each page, until all are found */
+  while (((pagestate == STATE_PAGE_ACTIVE) || (pagestate == STATE_PAGE_VALID) || (pagestate == STATE_PAGE_ERASING))
+         && (nbpage < PAGES_NUMBER) && (found < Count))
+  {
+    for (counter = PAGE_SIZE - EE_ELEMENT_SIZE; counter >= PAGE_HEADER_SIZE; counter -= EE_ELEMENT_SIZE)
+    {
+      addressvalue = (*(__IO EE_ELEMENT_TYPE*)(pageaddress + counter));
+
+      /* Skip erased elements, and discarded ones programmed to 0 */
+      offset = (uint32_t)EE_VIRTUALADDRESS_VALUE(addressvalue) - VirtAddress;
+      if ((addressvalue == EE_PAGESTAT_ERASED) || (EE_VIRTUALADDRESS_VALUE(addressvalue) == 0U) ||
+          (offset >= Count) || ((pValid[offset / 32U] & (1UL << (offset % 32U))) != 0U))
+      {
+        continue;
+      }
+
+      /* Keep the first element found, if its crc is correct */
+      if (CalculateCrc(EE_DATA_VALUE(addressvalue), EE_VIRTUALADDRESS_VALUE(addressvalue)) == EE_CRC_VALUE(addressvalue))
+      {
+        pData[offset] = (uint32_t)EE_DATA_VALUE(addressvalue);
+        pValid[offset / 32U] |= 1UL << (offset % 32U);
+        found++;
+      }
+    }
+
+    /* Decrement page index circularly, among pages allocated to eeprom emulation */
+    page = PREVIOUS_PAGE(page);
+    pageaddress = PAGE_ADDRESS(page);
+    pagestate = GetPageState(pageaddress);
+    nbpage++;
+  }
+
+  return EE_OK;
+}
+
+/**
+  * @brief  Writes/updates a blob, a variable length record, in EEPROM.
+  *         Blob data is written in data elements, then the blob header holding
+  *         its length and the crc of the data. A blob interrupted before its
+  *         header is written is ignored, the previous version is kept.
+  *         Only the data elements which differ from the previous version are
+  *         written, nothing is written if the blob is unchanged. A pages
+  *         transfer triggered by the write transfers the new version.
+  *         Trig internal Pages transfer if the blob does not fit in the half of
+  *         pages in use, a blob is never split by a transfer.
+  * @warning This function is not reentrant
+  * @param  Id Blob index, 0 to NB_OF_BLOBS - 1
+  * @param  pData Blob data
+  * @param  Length Blob length in bytes, 1 to EE_BLOB_MAX_SIZE
+  * @retval EE_Status
+  *           - EE_OK: on success
+  *           - EE_CLEANUP_REQUIRED: success and user has to trig flash pages cleanup
+  *           - EE error code: if an error occurs
+  */
+EE_Status EE_WriteBlob(uint8_t Id, uint8_t* pData, uint16_t Length)
+{
+  EE_Status transfer = EE_OK;
+  uint32_t varidx = 0U, address = 0U, length = 0U, nbelements = 0U, nbchanged = 0U;
+  uint32_t changed[(EE_BLOB_ELEMENTS(EE_BLOB_MAX_SIZE) + 31U) / 32U] = {0U};
+  uint16_t elements[EE_BLOB_ELEMENTS(EE_BLOB_MAX_SIZE)];
+
+  /* Check parameters validity */
+  if (Id >= NB_OF_BLOBS)
+  {
+    return EE_INVALID_VIRTUALADDRESS;
+  }
+  if ((pData == NULL) || (Length == 0U) || (Length > EE_BLOB_MAX_SIZE))
+  {
+    return EE_INVALID_ELEMENT;
+  }
+
+  /* Find data elements of the previous version, if any */
+  address = BlobFind(Id);
+  if ((address != 0U) && (BlobElements(address, elements) == EE_OK))
+  {
+    length = EE_DATA_VALUE(*(__IO EE_ELEMENT_TYPE*)(address)) >> 16U;
+  }
+
+  /* Keep data elements equal to the previous version */
+  nbelements = EE_BLOB_ELEMENTS(Length);
+  for (varidx = 0U; varidx < nbelements; varidx++)
+  {
+    if ((varidx >= EE_BLOB_ELEMENTS(length)) ||
+        ((*(__IO EE_ELEMENT_TYPE*)(START_PAGE_ADDRESS + (elements[varidx] * EE_ELEMENT_SIZE))) != BlobElement(pData, Length, varidx)))
+    {
+      changed[varidx / 32U] |= 1UL << (varidx % 32U);
+      nbchanged++;
+    }
+  }
+
+  /* Blob is unchanged, nothing to write */
+  if ((nbchanged == 0U) && (length == Length))
+  {
+    return EE_OK;
+  }
+
+  /* Data elements and header must not be split by a pages transfer */
+  /* A pages transfer writes the whole blob in place of the previous version */
+  pBlobData = pData;
+  uhBlobLength = Length;
+  ubBlobId = Id;
+  transfer = PagesReserve(nbchanged + 1U);
+  pBlobData = NULL;
+  if (transfer != EE_OK)
+  {
+    return transfer;
+  }
+
+  /* Write changed data elements then header, blob is valid from now on */
+  if (BlobWrite(Id, pData, Length, changed) != EE_OK)
+  {
+    return EE_WRITE_ERROR;
+  }
+
+  return EE_OK;
+}
 #endif
 
 /**
@@ -848,6 +1205,9 @@ EE_Status EE_CleanUp_IT(void)
   */
 EE_Status EE_DeleteCorruptedFlashAddress(uint32_t Address)
 {
+  /* Deleted element may be indexed, fall back to page scan until next init */
+  ubIndexValid = 0U;
+
   return DeleteCorruptedFlashAddress(Address);
 }
 
@@ -883,9 +1243,31 @@ __weak void EE_EndOfCleanup_UserCallback(void)
 static EE_Status ReadVariable(uint16_t VirtAddress, EE_DATA_TYPE* pData)
 {
   EE_ELEMENT_TYPE addressvalue = 0U;
-  uint32_t page = 0U, pageaddress = 0U, counter = 0U, crc = 0U;
+  uint32_t page = 0U, pageaddress = 0U, counter = 0U, crc = 0U, slot = 0U;
   EE_State_type pagestate = STATE_PAGE_INVALID;
 
+  /* Serve the read from RAM index if valid */
+  if (ubIndexValid != 0U)
+  {
+    slot = IndexFind(VirtAddress);
+    if (slot < EE_INDEX_SIZE)
+    {
+      if (uhIndexElement[slot] == EE_INDEX_NONE)
+      {
+        return EE_NO_DATA;
+      }
+
+      /* Indexed elements have a verified crc and are never rewritten, only erased with their page */
+      /* Check virtual address of indexed element, a mismatch falls back to page scan */
+      addressvalue = (*(__IO EE_ELEMENT_TYPE*)(START_PAGE_ADDRESS + (uhIndexElement[slot] * EE_ELEMENT_SIZE)));
+      if (EE_VIRTUALADDRESS_VALUE(addressvalue) == VirtAddress)
+      {
+        *pData = EE_DATA_VALUE(addressvalue);
+        return EE_OK;
+      }
+    }
+  }
+
   /* Get active Page for read operation */
   page = FindPage(FIND_READ_PAGE);
 
@@ -1173,6 +1555,7 @@ static EE_Status PagesTransfer(uint16_t VirtAddress, EE_DATA_TYPE Data, EE_Trans
   EE_ELEMENT_TYPE addressvalue = 0U;
   EE_Status status = EE_OK;
   EE_DATA_TYPE DataValue = 0U;
+  uint32_t blobaddress = 0U, resume = 0U;
 
   /* Get receive Page for transfer operation */
   page = FindPage((Type == EE_TRANSFER_NORMAL?FIND_ERASE_PAGE:FIND_WRITE_PAGE));
@@ -1294,6 +1677,9 @@ static EE_Status PagesTransfer(uint16_t VirtAddress, EE_DATA_TYPE Data, EE_Trans
         break;
       }
     }
+
+    /* Find the variable to resume from, before the dummy element is written */
+    resume = TransferResume();
   }
 
   /* Write the variable passed as parameter in the new active page */
@@ -1306,11 +1692,9 @@ static EE_Status PagesTransfer(uint16_t VirtAddress, EE_DATA_TYPE Data, EE_Trans
   /* Transfer process: transfer variables from old to the new active page */
   /* First element in receive page can be any one, the following elements are */
   /* ordered from the beginning. */
-  /* In case of recovery, Pre-Last element in receive page could be */
-  /* corrupted if reset occured during write of this element, */
-  /* and last element is dummy value that we have just written. */
-  /* Transfer shall then resume from (uhNbWrittenElements-3) variable index */
-  for (varidx = (uhNbWrittenElements >= 3U?uhNbWrittenElements-3U:0U); varidx < NB_OF_VARIABLES; varidx++)
+  /* In case of recovery, transfer resumes from the last variable found */
+  /* transferred, see TransferResume() */
+  for (varidx = resume; varidx < NB_OF_VARIABLES; varidx++)
   {
     /* Check each variable except the one passed as parameter */
     if (puhVirtAdd[varidx] != VirtAddress)
@@ -1340,6 +1724,32 @@ static EE_Status PagesTransfer(uint16_t VirtAddress, EE_DATA_TYPE Data, EE_Trans
     }
   }
 
+  /* Transfer the latest version of each blob, if not yet in the pages receiving data */
+  for (varidx = 0U; varidx < NB_OF_BLOBS; varidx++)
+  {
+    /* The blob being written is transferred with its new data */
+    if ((pBlobData != NULL) && (varidx == ubBlobId))
+    {
+      status = BlobWrite(ubBlobId, pBlobData, uhBlobLength, NULL);
+      if (status != EE_OK)
+      {
+        return status;
+      }
+      continue;
+    }
+
+    blobaddress = BlobFind((uint8_t)varidx);
+    if ((blobaddress != 0U) &&
+        (((PAGE(blobaddress) - START_PAGE) / (PAGES_NUMBER / 2U)) != ((ubCurrentActivePage - START_PAGE) / (PAGES_NUMBER / 2U))))
+    {
+      status = BlobCopy(blobaddress);
+      if (status != EE_OK)
+      {
+        return status;
+      }
+    }
+  }
+
   /* Transfer is now done, mark the receive state page as active */
   if (SetPageState(ubCurrentActivePage, STATE_PAGE_ACTIVE) != EE_OK)
   {
@@ -1364,6 +1774,31 @@ static EE_Status VerifyPagesFullWriteVariable(uint16_t VirtAddress, EE_DATA_TYPE
 {
   uint32_t crc = 0U;
 
+  /* Force crc to 0 in case of Data/VirtAddress are 0*/
+  if ((Data == 0U) && (VirtAddress == 0U))
+  {
+    crc = 0U;
+  }
+  else
+  {
+    /* Calculate crc of variable data and virtual address */
+    crc = CalculateCrc(Data, VirtAddress);
+  }
+
+  return VerifyPagesFullWriteElement(EE_ELEMENT_VALUE(VirtAddress,Data,crc));
+}
+
+/**
+  * @brief  Verify if pages are full
+  *   then if not the case, writes element in EEPROM.
+  * @param  Element Element value, virtual address + crc + data
+  * @retval EE_Status
+  *           - EE_OK: on success
+  *           - EE_FULL: if half pages are full
+  *           - EE error code: if an error occurs
+  */
+static EE_Status VerifyPagesFullWriteElement(EE_ELEMENT_TYPE Element)
+{
   /* Check if pages are full, i.e. max number of written elements achieved */
   if (uhNbWrittenElements >= NB_MAX_WRITTEN_ELEMENTS)
   {
@@ -1382,24 +1817,18 @@ static EE_Status VerifyPagesFullWriteVariable(uint16_t VirtAddress, EE_DATA_TYPE
 
   activepageaddress = PAGE_ADDRESS(activepage);
 
-  /* Force crc to 0 in case of Data/VirtAddress are 0*/
-  if ((Data == 0U) && (VirtAddress == 0U))
-  {
-    crc = 0U;
-  }
-  else
-  {
-    /* Calculate crc of variable data and virtual address */
-    crc = CalculateCrc(Data, VirtAddress);
-  }
-
   /* Program variable data + virtual address + crc */
   /* If program operation was failed, a Flash error code is returned */
-  if (EE_FLASH_PROGRAM(activepageaddress+uwAddressNextWrite, EE_ELEMENT_VALUE(VirtAddress,Data,crc)) != HAL_OK)
+  if (EE_FLASH_PROGRAM(activepageaddress+uwAddressNextWrite, Element) != HAL_OK)
   {
+    /* Element may be partially written, fall back to page scan until next init */
+    ubIndexValid = 0U;
     return EE_WRITE_ERROR;
   }
 
+  /* Element is the latest one of the variable */
+  IndexUpdate(EE_VIRTUALADDRESS_VALUE(Element), activepageaddress + uwAddressNextWrite);
+
   /* Increment global variables relative to write operation done*/
   uwAddressNextWrite += EE_ELEMENT_SIZE;
   uhNbWrittenElements++;
@@ -1515,14 +1944,598 @@ static EE_State_type GetPageState(uint32_t Address)
   return STATE_PAGE_ERASED;
 }
 
+/**
+  * @brief  Initialize RAM index slots with the table of virtual addresses,
+  *         without any element. Index is invalid until built.
+  * @retval None
+  */
+static void IndexInit(void)
+{
+  uint32_t varidx = 0U, slot = 0U;
+  uint16_t virtaddress = 0U;
+
+  ubIndexValid = 0U;
+
+  for (slot = 0U; slot < EE_INDEX_SIZE; slot++)
+  {
+    uhIndexVirtAdd[slot] = 0U;
+    uhIndexElement[slot] = EE_INDEX_NONE;
+  }
+
+  /* Variables, then blob headers */
+  for (varidx = 0U; varidx < (NB_OF_VARIABLES + NB_OF_BLOBS); varidx++)
+  {
+    virtaddress = (varidx < NB_OF_VARIABLES) ? puhVirtAdd[varidx] : (uint16_t)(EE_BLOB_VIRTADDR + varidx - NB_OF_VARIABLES);
+
+    /* Linear probing from virtual address, up to a free slot or the same address */
+    slot = virtaddress & (EE_INDEX_SIZE - 1U);
+    while ((uhIndexVirtAdd[slot] != 0U) && (uhIndexVirtAdd[slot] != virtaddress))
+    {
+      slot = (slot + 1U) & (EE_INDEX_SIZE - 1U);
+    }
+    uhIndexVirtAdd[slot] = virtaddress;
+  }
+}
+
+/**
+  * @brief  Find RAM index slot of a virtual address.
+  * @param  VirtAddress Variable virtual address
+  * @retval Slot index, EE_INDEX_SIZE if the virtual address is not in the table
+  */
+static uint32_t IndexFind(uint16_t VirtAddress)
+{
+  uint32_t slot = VirtAddress & (EE_INDEX_SIZE - 1U);
+
+  /* Virtual address 0x0000 is used by dummy writes, never indexed */
+  if (VirtAddress == 0U)
+  {
+    return EE_INDEX_SIZE;
+  }
+
+  while (uhIndexVirtAdd[slot] != 0U)
+  {
+    if (uhIndexVirtAdd[slot] == VirtAddress)
+    {
+      return slot;
+    }
+    slot = (slot + 1U) & (EE_INDEX_SIZE - 1U);
+  }
+
+  return EE_INDEX_SIZE;
+}
+
+/**
+  * @brief  Build RAM index from flash, the latest element with a valid crc of
+  *         each variable, in the same pages order as a read scans them.
+  * @retval None
+  */
+static void IndexBuild(void)
+{
+  EE_ELEMENT_TYPE addressvalue = 0U;
+  uint32_t page = 0U, pageaddress = 0U, counter = 0U, slot = 0U, nbpage = 0U;
+  EE_State_type pagestate = STATE_PAGE_INVALID;
+
+  /* Get active Page for read operation */
+  page = FindPage(FIND_READ_PAGE);
+  if (page == EE_NO_PAGE_FOUND)
+  {
+    return;
+  }
+  pageaddress = PAGE_ADDRESS(page);
+  pagestate = GetPageState(pageaddress);
+
+  /* Browse pages from the latest one, and elements from the end of each page */
+  while (((pagestate == STATE_PAGE_ACTIVE) || (pagestate == STATE_PAGE_VALID) || (pagestate == STATE_PAGE_ERASING))
+         && (nbpage < PAGES_NUMBER))
+  {
+    for (counter = PAGE_SIZE - EE_ELEMENT_SIZE; counter >= PAGE_HEADER_SIZE; counter -= EE_ELEMENT_SIZE)
+    {
+      addressvalue = (*(__IO EE_ELEMENT_TYPE*)(pageaddress + counter));
+      if (addressvalue == EE_PAGESTAT_ERASED)
+      {
+        continue;
+      }
+
+      /* Keep the first element found, if its crc is correct */
+      slot = IndexFind(EE_VIRTUALADDRESS_VALUE(addressvalue));
+      if ((slot < EE_INDEX_SIZE) && (uhIndexElement[slot] == EE_INDEX_NONE) &&
+          (CalculateCrc(EE_DATA_VALUE(addressvalue), EE_VIRTUALADDRESS_VALUE(addressvalue)) == EE_CRC_VALUE(addressvalue)))
+      {
+        uhIndexElement[slot] = (uint16_t)((pageaddress + counter - START_PAGE_ADDRESS) / EE_ELEMENT_SIZE);
+      }
+    }
+
+    /* Decrement page index circularly, among pages allocated to eeprom emulation */
+    page = PREVIOUS_PAGE(page);
+    pageaddress = PAGE_ADDRESS(page);
+    pagestate = GetPageState(pageaddress);
+    nbpage++;
+  }
+
+  ubIndexValid = 1U;
+}
+
+/**
+  * @brief  Update RAM index with a new element of a variable.
+  * @param  VirtAddress Variable virtual address
+  * @param  Address Flash address of the element
+  * @retval None
+  */
+static void IndexUpdate(uint16_t VirtAddress, uint32_t Address)
+{
+  uint32_t slot = IndexFind(VirtAddress);
+
+  if (slot < EE_INDEX_SIZE)
+  {
+    uhIndexElement[slot] = (uint16_t)((Address - START_PAGE_ADDRESS) / EE_ELEMENT_SIZE);
+  }
+}
+
+/**
+  * @brief  Get transaction marker data of an element.
+  * @param  Element Element value
+  * @retval Marker data, 0 if the element is not a valid transaction marker
+  */
+static uint32_t TransactionMarker(EE_ELEMENT_TYPE Element)
+{
+  if ((EE_VIRTUALADDRESS_VALUE(Element) == EE_TX_VIRTADDR) &&
+      (CalculateCrc(EE_DATA_VALUE(Element), EE_TX_VIRTADDR) == EE_CRC_VALUE(Element)))
+  {
+    return (uint32_t)EE_DATA_VALUE(Element);
+  }
+
+  return 0U;
+}
+
+/**
+  * @brief  Discard elements of a transaction, by writing 0 on all elements
+  *         from the last written element back to its begin marker.
+  * @note   The begin marker is cleared last, so that a discard interrupted by
+  *         a power loss still finds it and is done again by EE_Init().
+  * @param  Address Flash address of the begin marker
+  * @retval EE_Status
+  *           - EE_OK: on success
+  *           - EE error code: if an error occurs
+  */
+static EE_Status TransactionDiscard(uint32_t Address)
+{
+  uint32_t page = ubCurrentActivePage, offset = uwAddressNextWrite, elementaddress = 0U;
+
+  /* Discarded elements may be indexed, fall back to page scan until next init */
+  ubIndexValid = 0U;
+
+  do
+  {
+    /* Continue from the end of previous page, a transaction is never split
+       by a pages transfer so it stays in the half of pages in use */
+    if (offset == PAGE_HEADER_SIZE)
+    {
+      page = PREVIOUS_PAGE(page);
+      offset = PAGE_SIZE;
+    }
+    offset -= EE_ELEMENT_SIZE;
+    elementaddress = PAGE_ADDRESS(page) + offset;
+
+    if ((*(__IO EE_ELEMENT_TYPE*)(elementaddress)) != 0U)
+    {
+      if (EE_FLASH_PROGRAM(elementaddress, 0U) != HAL_OK)
+      {
+        return EE_WRITE_ERROR;
+      }
+    }
+  } while (elementaddress != Address);
+
+  return EE_OK;
+}
+
+/**
+  * @brief  Discard the last transaction if its commit marker is missing.
+  * @note   A transaction is never split by a pages transfer, so the search
+  *         is limited to the half of pages in use.
+  * @retval EE_Status
+  *           - EE_OK: on success
+  *           - EE error code: if an error occurs
+  */
+static EE_Status TransactionRecover(void)
+{
+  uint32_t page = ubCurrentActivePage, offset = uwAddressNextWrite, counter = 0U, marker = 0U;
+
+  /* Browse elements from the last written one, up to transaction max size */
+  for (counter = 0U; counter < (EE_TX_MAX_ELEMENTS + 2U); counter++)
+  {
+    if (offset == PAGE_HEADER_SIZE)
+    {
+      if ((page == START_PAGE) || (page == (uint32_t)(START_PAGE + (PAGES_NUMBER / 2U))))
+      {
+        break;
+      }
+      page = PREVIOUS_PAGE(page);
+      offset = PAGE_SIZE;
+    }
+    offset -= EE_ELEMENT_SIZE;
+
+    marker = TransactionMarker(*(__IO EE_ELEMENT_TYPE*)(PAGE_ADDRESS(page) + offset));
+    if ((marker & EE_TX_MASK) == EE_TX_COMMIT)
+    {
+      return EE_OK;
+    }
+    if ((marker & EE_TX_MASK) == EE_TX_BEGIN)
+    {
+      return TransactionDiscard(PAGE_ADDRESS(page) + offset);
+    }
+  }
+
+  return EE_OK;
+}
+
+/**
+  * @brief  Reserve elements in the half of pages in use, for elements which
+  *         must not be split by a pages transfer. If they do not fit, the half
+  *         is filled with dummy elements and pages are transferred, as
+  *         transfers only occur at half boundary.
+  * @param  NbElements Number of elements to reserve
+  * @retval EE_Status
+  *           - EE_OK: on success, without page transfer
+  *           - EE_CLEANUP_REQUIRED: on success, with page transfer occured
+  *           - EE error code: if an error occurs
+  */
+static EE_Status PagesReserve(uint32_t NbElements)
+{
+  EE_Status status = EE_OK;
+
+  if ((uhNbWrittenElements + NbElements) <= NB_MAX_WRITTEN_ELEMENTS)
+  {
+    return EE_OK;
+  }
+
+  do
+  {
+    status = VerifyPagesFullWriteVariable(0U, 0U);
+  } while (status == EE_OK);
+
+  if (status != EE_PAGE_FULL)
+  {
+    return status;
+  }
+
+  return PagesTransfer(0U, 0U, EE_TRANSFER_NORMAL);
+}
+
+/**
+  * @brief  Get index of the variable to resume an interrupted pages transfer from.
+  * @note   Variables are transferred in the order of the virtual address table,
+  *         after the first element of the receive pages. The last variable
+  *         transferred is searched back from the last written element, skipping
+  *         elements torn by a reset and dummy elements of previous recoveries,
+  *         so that a recovery interrupted by another reset skips no variable.
+  * @retval Index in the table of virtual addresses, 0 if none is transferred
+  */
+static uint32_t TransferResume(void)
+{
+  uint32_t page = ubCurrentActivePage, offset = uwAddressNextWrite, varidx = 0U;
+  EE_ELEMENT_TYPE element = 0U;
+  uint16_t virtaddress = 0U;
+
+  /* Receive pages are the current one and the valid pages before it */
+  while ((offset > (PAGE_HEADER_SIZE + EE_ELEMENT_SIZE)) ||
+         (GetPageState(PAGE_ADDRESS(PREVIOUS_PAGE(page))) == STATE_PAGE_VALID))
+  {
+    if (offset == PAGE_HEADER_SIZE)
+    {
+      page = PREVIOUS_PAGE(page);
+      offset = PAGE_SIZE;
+    }
+    offset -= EE_ELEMENT_SIZE;
+
+    element = (*(__IO EE_ELEMENT_TYPE*)(PAGE_ADDRESS(page) + offset));
+    virtaddress = EE_VIRTUALADDRESS_VALUE(element);
+    if ((virtaddress != 0U) && (virtaddress < EE_BLOB_VIRTADDR) &&
+        (CalculateCrc(EE_DATA_VALUE(element), virtaddress) == EE_CRC_VALUE(element)))
+    {
+      for (varidx = 0U; varidx < NB_OF_VARIABLES; varidx++)
+      {
+        if (puhVirtAdd[varidx] == virtaddress)
+        {
+          return varidx;
+        }
+      }
+    }
+  }
+
+  return 0U;
+}
+
+/**
+  * @brief  Get address of the element written before, among pages of a half.
+  * @param  Address Flash address of an element
+  * @retval Flash address of previous element
+  */
+static uint32_t PreviousElement(uint32_t Address)
+{
+  uint32_t page = PAGE(Address);
+
+  /* Continue from the end of previous page */
+  if ((Address - PAGE_ADDRESS(page)) <= PAGE_HEADER_SIZE)
+  {
+    return PAGE_ADDRESS(PREVIOUS_PAGE(page)) + PAGE_SIZE - EE_ELEMENT_SIZE;
+  }
+
+  return Address - EE_ELEMENT_SIZE;
+}
+
+/**
+  * @brief  Get a data element of a blob, 4 bytes in data field and 2 bytes in
+  *         crc field, zero padded.
+  * @param  pData Blob data
+  * @param  Length Blob length in bytes
+  * @param  Index Index of the data element in the blob
+  * @retval Element value
+  */
+static EE_ELEMENT_TYPE BlobElement(uint8_t* pData, uint16_t Length, uint32_t Index)
+{
+  uint8_t chunk[EE_BLOB_ELEMENT_BYTES] = {0U};
+  uint32_t byte = 0U, offset = Index * EE_BLOB_ELEMENT_BYTES, data = 0U;
+
+  for (byte = 0U; (byte < EE_BLOB_ELEMENT_BYTES) && ((offset + byte) < Length); byte++)
+  {
+    chunk[byte] = pData[offset + byte];
+  }
+  data = (uint32_t)chunk[0] | ((uint32_t)chunk[1] << 8U) | ((uint32_t)chunk[2] << 16U) | ((uint32_t)chunk[3] << 24U);
+
+  return EE_ELEMENT_VALUE(EE_BLOB_DATA_VIRTADDR - Index, data, ((uint32_t)chunk[4] | ((uint32_t)chunk[5] << 8U)));
+}
+
+/**
+  * @brief  Write data elements of a blob, then its header.
+  * @param  Id Blob index
+  * @param  pData Blob data
+  * @param  Length Blob length in bytes
+  * @param  pChanged Bit field of the data elements to write, NULL to write all
+  * @retval EE_Status
+  *           - EE_OK: on success
+  *           - EE error code: if an error occurs
+  */
+static EE_Status BlobWrite(uint8_t Id, uint8_t* pData, uint16_t Length, uint32_t* pChanged)
+{
+  EE_Status status = EE_OK;
+  uint32_t varidx = 0U, crc = 0U;
+
+  for (varidx = 0U; varidx < EE_BLOB_ELEMENTS(Length); varidx++)
+  {
+    if ((pChanged == NULL) || ((pChanged[varidx / 32U] & (1UL << (varidx % 32U))) != 0U))
+    {
+      status = VerifyPagesFullWriteElement(BlobElement(pData, Length, varidx));
+      if (status != EE_OK)
+      {
+        return status;
+      }
+    }
+  }
+
+  /* Calculate crc of blob data */
+  LL_CRC_ResetCRCCalculationUnit(CRC);
+  for (varidx = 0U; varidx < Length; varidx++)
+  {
+    LL_CRC_FeedData8(CRC, pData[varidx]);
+  }
+  crc = LL_CRC_ReadData16(CRC);
+
+  /* Write blob header */
+  return VerifyPagesFullWriteVariable((uint16_t)(EE_BLOB_VIRTADDR + Id), ((uint32_t)Length << 16U) | crc);
+}
+
+/**
+  * @brief  Find the data elements of a blob version.
+  * @note   A blob write only writes the data elements changed since the previous
+  *         version, just before its header. Each data element is the latest one
+  *         found in the data elements written just before the header, then just
+  *         before the previous headers of the blob. Data elements not followed by
+  *         a header of the blob belong to another blob or to an interrupted write.
+  *         A pages transfer copies all data elements, so they are found in the
+  *         half of pages in use.
+  * @param  Address Flash address of the blob header
+  * @param  pElements Position of each data element found, in elements from
+  *         START_PAGE_ADDRESS
+  * @retval EE_Status
+  *           - EE_OK: if all data elements are found
+  *           - EE_INVALID_ELEMENT: if the blob is corrupted
+  */
+static EE_Status BlobElements(uint32_t Address, uint16_t* pElements)
+{
+  EE_ELEMENT_TYPE addressvalue = (*(__IO EE_ELEMENT_TYPE*)(Address));
+  uint16_t virtaddress = EE_VIRTUALADDRESS_VALUE(addressvalue);
+  uint32_t nbelements = EE_BLOB_ELEMENTS(EE_DATA_VALUE(addressvalue) >> 16U);
+  uint32_t nbfound = 0U, counter = 0U, varidx = 0U, header = 1U;
+
+  if ((nbelements == 0U) || (nbelements > EE_BLOB_ELEMENTS(EE_BLOB_MAX_SIZE)))
+  {
+    return EE_INVALID_ELEMENT;
+  }
+
+  for (varidx = 0U; varidx < nbelements; varidx++)
+  {
+    pElements[varidx] = 0U;
+  }
+
+  /* Browse back at most the elements of a half of pages */
+  for (counter = 0U; (nbfound < nbelements) && (counter < NB_MAX_WRITTEN_ELEMENTS); counter++)
+  {
+    Address = PreviousElement(Address);
+    addressvalue = (*(__IO EE_ELEMENT_TYPE*)(Address));
+    varidx = EE_BLOB_INDEX(EE_VIRTUALADDRESS_VALUE(addressvalue));
+
+    if (varidx < EE_BLOB_ELEMENTS(EE_BLOB_MAX_SIZE))
+    {
+      /* Data element just before a header of the blob, keep the latest one */
+      if ((header != 0U) && (varidx < nbelements) && (pElements[varidx] == 0U))
+      {
+        pElements[varidx] = (uint16_t)((Address - START_PAGE_ADDRESS) / EE_ELEMENT_SIZE);
+        nbfound++;
+      }
+    }
+    else
+    {
+      /* Data elements before a previous header of the blob are the previous version */
+      header = (EE_VIRTUALADDRESS_VALUE(addressvalue) == virtaddress) && (addressvalue != EE_PAGESTAT_ERASED) &&
+               (CalculateCrc(EE_DATA_VALUE(addressvalue), virtaddress) == EE_CRC_VALUE(addressvalue));
+    }
+  }
+
+  return (nbfound == nbelements) ? EE_OK : EE_INVALID_ELEMENT;
+}
+
+/**
+  * @brief  Verify a blob from its header and optionally copy its data.
+  * @param  Address Flash address of the blob header, with a verified crc
+  * @param  pData Buffer receiving the blob data, NULL to only verify the blob
+  * @param  Size Size of the buffer, data after Size bytes is not copied
+  * @retval EE_Status
+  *           - EE_OK: if data elements match the crc of the header
+  *           - EE_INVALID_ELEMENT: if the blob is corrupted
+  */
+static EE_Status BlobLoad(uint32_t Address, uint8_t* pData, uint16_t Size)
+{
+  EE_ELEMENT_TYPE header = (*(__IO EE_ELEMENT_TYPE*)(Address)), addressvalue = 0U;
+  uint32_t length = EE_DATA_VALUE(header) >> 16U, byte = 0U, shift = 0U;
+  uint16_t elements[EE_BLOB_ELEMENTS(EE_BLOB_MAX_SIZE)];
+  uint8_t value = 0U;
+
+  if (BlobElements(Address, elements) != EE_OK)
+  {
+    return EE_INVALID_ELEMENT;
+  }
+
+  LL_CRC_ResetCRCCalculationUnit(CRC);
+  for (byte = 0U; byte < length; byte++)
+  {
+    shift = byte % EE_BLOB_ELEMENT_BYTES;
+    if (shift == 0U)
+    {
+      addressvalue = (*(__IO EE_ELEMENT_TYPE*)(START_PAGE_ADDRESS + (elements[byte / EE_BLOB_ELEMENT_BYTES] * EE_ELEMENT_SIZE)));
+    }
+
+    /* 4 bytes in data field, then 2 bytes in crc field */
+    value = (shift < 4U) ? (uint8_t)(EE_DATA_VALUE(addressvalue) >> (8U * shift))
+                         : (uint8_t)(EE_CRC_VALUE(addressvalue) >> (8U * (shift - 4U)));
+    LL_CRC_FeedData8(CRC, value);
+
+    if ((pData != NULL) && (byte < Size))
+    {
+      pData[byte] = value;
+    }
+  }
+
+  if (LL_CRC_ReadData16(CRC) != (uint16_t)EE_DATA_VALUE(header))
+  {
+    return EE_INVALID_ELEMENT;
+  }
+
+  return EE_OK;
+}
+
+/**
+  * @brief  Find the header of the last valid version of a blob.
+  * @param  Id Blob index
+  * @retval Flash address of the blob header, 0 if not found
+  */
+static uint32_t BlobFind(uint8_t Id)
+{
+  EE_ELEMENT_TYPE addressvalue = 0U;
+  uint32_t page = 0U, pageaddress = 0U, counter = 0U, slot = 0U;
+  uint16_t virtaddress = (uint16_t)(EE_BLOB_VIRTADDR + Id);
+  EE_State_type pagestate = STATE_PAGE_INVALID;
+
+  /* Try header of RAM index first, a corrupted blob falls back to page scan */
+  if (ubIndexValid != 0U)
+  {
+    slot = IndexFind(virtaddress);
+    if ((slot < EE_INDEX_SIZE) && (uhIndexElement[slot] == EE_INDEX_NONE))
+    {
+      return 0U;
+    }
+    if (slot < EE_INDEX_SIZE)
+    {
+      pageaddress = START_PAGE_ADDRESS + (uhIndexElement[slot] * EE_ELEMENT_SIZE);
+      addressvalue = (*(__IO EE_ELEMENT_TYPE*)(pageaddress));
+      if ((EE_VIRTUALADDRESS_VALUE(addressvalue) == virtaddress) && (BlobLoad(pageaddress, NULL, 0U) == EE_OK))
+      {
+        return pageaddress;
+      }
+    }
+  }
+
+  /* Get active Page for read operation */
+  page = FindPage(FIND_READ_PAGE);
+  if (page == EE_NO_PAGE_FOUND)
+  {
+    return 0U;
+  }
+  pageaddress = PAGE_ADDRESS(page);
+  pagestate = GetPageState(pageaddress);
+
+  /* Search header from the latest element, as ReadVariable() does */
+  while ((pagestate == STATE_PAGE_ACTIVE) || (pagestate == STATE_PAGE_VALID) || (pagestate == STATE_PAGE_ERASING))
+  {
+    for (counter = PAGE_SIZE - EE_ELEMENT_SIZE; counter >= PAGE_HEADER_SIZE; counter -= EE_ELEMENT_SIZE)
+    {
+      addressvalue = (*(__IO EE_ELEMENT_TYPE*)(pageaddress + counter));
+      if ((EE_VIRTUALADDRESS_VALUE(addressvalue) == virtaddress) && (addressvalue != EE_PAGESTAT_ERASED) &&
+          (CalculateCrc(EE_DATA_VALUE(addressvalue), virtaddress) == EE_CRC_VALUE(addressvalue)) &&
+          (BlobLoad(pageaddress + counter, NULL, 0U) == EE_OK))
+      {
+        return pageaddress + counter;
+      }
+    }
+
+    /* Decrement page index circularly, among pages allocated to eeprom emulation */
+    page = PREVIOUS_PAGE(page);
+    pageaddress = PAGE_ADDRESS(page);
+    pagestate = GetPageState(pageaddress);
+  }
+
+  return 0U;
+}
+
+/**
+  * @brief  Copy a blob, all data elements then header, to the pages in use.
+  * @param  Address Flash address of the blob header, verified by BlobLoad()
+  * @retval EE_Status
+  *           - EE_OK: on success
+  *           - EE error code: if an error occurs
+  */
+static EE_Status BlobCopy(uint32_t Address)
+{
+  uint32_t nbelements = EE_BLOB_ELEMENTS(EE_DATA_VALUE(*(__IO EE_ELEMENT_TYPE*)(Address)) >> 16U);
+  uint32_t varidx = 0U;
+  uint16_t elements[EE_BLOB_ELEMENTS(EE_BLOB_MAX_SIZE)];
+  EE_Status status = EE_OK;
+
+  status = BlobElements(Address, elements);
+  if (status != EE_OK)
+  {
+    return status;
+  }
+
+  /* Data elements hold no address dependent value, copy them as is */
+  for (varidx = 0U; varidx < nbelements; varidx++)
+  {
+    status = VerifyPagesFullWriteElement(*(__IO EE_ELEMENT_TYPE*)(START_PAGE_ADDRESS + (elements[varidx] * EE_ELEMENT_SIZE)));
+    if (status != EE_OK)
+    {
+      return status;
+    }
+  }
+
+  return VerifyPagesFullWriteElement(*(__IO EE_ELEMENT_TYPE*)(Address));
+}
+
 /**
   * @brief  This function configures CRC Instance.
   * @note   This function is used to :
   *         -1- Enable peripheral clock for CRC.
   *         -2- Configure CRC functional parameters.
-  * @note   Peripheral configuration is minimal configuration from reset values.
-  *         Thus, some useless LL unitary functions calls below are provided as
-  *         commented examples - setting is default configuration from reset.
+  * @note   The CRC unit is shared with other modules (CRC32 of DFU images), so
+  *         every field is set here rather than relying on reset values.
   * @param  None
   * @retval None
   */
@@ -1538,16 +2551,13 @@ void ConfigureCrc(void)
   LL_CRC_SetPolynomialSize(CRC, CRC_POLYNOMIAL_LENGTH);
   
   /* Initialize default CRC initial value */
-  /* Reset value is LL_CRC_DEFAULT_CRC_INITVALUE */
-  // LL_CRC_SetInitialData(CRC, LL_CRC_DEFAULT_CRC_INITVALUE);  
+  LL_CRC_SetInitialData(CRC, LL_CRC_DEFAULT_CRC_INITVALUE);
   
   /* Set input data inversion mode : No inversion*/
-  /* Reset value is LL_CRC_INDATA_REVERSE_NONE */
-  // LL_CRC_SetInputDataReverseMode(CRC, LL_CRC_INDATA_REVERSE_NONE);
+  LL_CRC_SetInputDataReverseMode(CRC, LL_CRC_INDATA_REVERSE_NONE);
   
   /* Set output data inversion mode : No inversion */
-  /* Reset value is LL_CRC_OUTDATA_REVERSE_NONE */
-  // LL_CRC_SetOutputDataReverseMode(CRC, LL_CRC_OUTDATA_REVERSE_NONE);
+  LL_CRC_SetOutputDataReverseMode(CRC, LL_CRC_OUTDATA_REVERSE_NONE);
 }
 
 /**
@@ -73,7 +73,8 @@
 #define PAGE_SIZE               FLASH_PAGE_SIZE                                  /*!< Page size */
 #define PAGE_HEADER_SIZE        EE_ELEMENT_SIZE * 4U                             /*!< Page Header is 4 elements to save page state */
 #define NB_MAX_ELEMENTS_BY_PAGE ((PAGE_SIZE - PAGE_HEADER_SIZE) / EE_ELEMENT_SIZE) /*!< Max number of elements by page */
-#define PAGES_NUMBER            (((((NB_OF_VARIABLES + NB_MAX_ELEMENTS_BY_PAGE) / NB_MAX_ELEMENTS_BY_PAGE) * 2U) * CYCLES_NUMBER) + GUARD_PAGES_NUMBER)
+#define NB_TRANSFER_ELEMENTS    (NB_OF_VARIABLES + (NB_OF_BLOBS * (EE_BLOB_ELEMENTS(EE_BLOB_MAX_SIZE) + 1U))) /*!< Max number of elements copied by a pages transfer, variables and blobs */
+#define PAGES_NUMBER            (((((NB_TRANSFER_ELEMENTS + NB_MAX_ELEMENTS_BY_PAGE) / NB_MAX_ELEMENTS_BY_PAGE) * 2U) * CYCLES_NUMBER) + GUARD_PAGES_NUMBER)
                                                                                  /*!< Number of consecutives pages used by the application */
 #define NB_MAX_WRITTEN_ELEMENTS ((NB_MAX_ELEMENTS_BY_PAGE * PAGES_NUMBER) / 2U)  /*!< Max number of elements written before triggering pages transfer */
 #define START_PAGE              PAGE(START_PAGE_ADDRESS)                         /*!< Page index of the 1st page used for EEPROM emul, in the bank */
@@ -82,6 +83,32 @@
 /* No page define */
 #define EE_NO_PAGE_FOUND        ((uint32_t)0xFFFFFFFFU)
 
+/* RAM index definitions */
+#define EE_INDEX_SIZE           512U    /*!< Slots of RAM index from virtual address to latest element, power of 2 and at least 2x NB_OF_VARIABLES */
+#define EE_INDEX_NONE           0xFFFFU /*!< RAM index slot without element */
+
+#if (EE_INDEX_SIZE < (2U * NB_OF_VARIABLES)) || ((EE_INDEX_SIZE & (EE_INDEX_SIZE - 1U)) != 0U)
+#error "EE_INDEX_SIZE must be a power of 2, and at least 2x NB_OF_VARIABLES"
+#endif
+
+/* Transaction definitions */
+#define EE_TX_VIRTADDR          0xFFFEU     /*!< Virtual address of transaction markers, prohibited in table of virtual addresses */
+#define EE_TX_BEGIN             0xB5000000U /*!< Begin marker data, ORed with number of elements */
+#define EE_TX_COMMIT            0xC3000000U /*!< Commit marker data, ORed with number of elements */
+#define EE_TX_MASK              0xFF000000U /*!< Mask of marker type in marker data */
+#define EE_TX_MAX_ELEMENTS      64U         /*!< Max number of elements of a transaction, markers excluded */
+
+/* Blob definitions */
+#define EE_BLOB_VIRTADDR        0xFD00U     /*!< Virtual address of blob 0 header, blob n uses EE_BLOB_VIRTADDR + n.
+                                                 Virtual addresses from EE_BLOB_VIRTADDR are reserved */
+#define EE_BLOB_DATA_VIRTADDR   0xFFFDU     /*!< Virtual address of blob data element 0, data element n of a blob
+                                                 uses EE_BLOB_DATA_VIRTADDR - n */
+#define EE_BLOB_ELEMENT_BYTES   6U          /*!< Blob bytes in a data element, in data and crc fields */
+
+#if ((EE_BLOB_VIRTADDR + NB_OF_BLOBS) > (EE_BLOB_DATA_VIRTADDR + 1U - ((EE_BLOB_MAX_SIZE + EE_BLOB_ELEMENT_BYTES - 1U) / EE_BLOB_ELEMENT_BYTES)))
+#error "NB_OF_BLOBS or EE_BLOB_MAX_SIZE is too big, blob virtual addresses overlap data elements"
+#endif
+
 /**
   * @}
   */
@@ -118,6 +145,8 @@
 #define EE_DATA_VALUE(__ELEMENT__)                      (EE_DATA_TYPE)(((__ELEMENT__) & EE_MASK_DATA) >> EE_DATA_SHIFT) /*!< Get Data value from element value */
 #define EE_CRC_VALUE(__ELEMENT__)                       (EE_CRC_TYPE)(((__ELEMENT__) & EE_MASK_CRC) >> EE_CRC_SHIFT) /*!< Get Crc value from element value */
 #define EE_ELEMENT_VALUE(__VIRTADDR__,__DATA__,__CRC__) (((EE_ELEMENT_TYPE)(__DATA__) << EE_DATA_SHIFT) | (__CRC__) << EE_CRC_SHIFT | (__VIRTADDR__)) /*!< Get element value from virtual addr, data and crc values */
+#define EE_BLOB_ELEMENTS(__LENGTH__)                    (((__LENGTH__) + EE_BLOB_ELEMENT_BYTES - 1U) / EE_BLOB_ELEMENT_BYTES) /*!< Get number of data elements of a blob from its length */
+#define EE_BLOB_INDEX(__VIRTADDR__)                     (uint32_t)(EE_BLOB_DATA_VIRTADDR - (uint32_t)(__VIRTADDR__)) /*!< Get index of a blob data element from its virtual address, out of range if not a data element */
 
 /**
   * @}
@@ -138,7 +167,11 @@ EE_Status EE_Format(EE_Erase_type EraseType);
 EE_Status EE_Init(uint16_t* VirtAddTab, EE_Erase_type EraseType);
 #if defined(EE_ACCESS_32BITS)
 EE_Status EE_ReadVariable32bits(uint16_t VirtAddress, uint32_t* pData);
+EE_Status EE_ReadSnapshot32bits(uint16_t VirtAddress, uint16_t Count, uint32_t* pData, uint32_t* pValid);
 EE_Status EE_WriteVariable32bits(uint16_t VirtAddress, uint32_t Data);
+EE_Status EE_WriteTransaction32bits(uint16_t* VirtAddress, uint32_t* Data, uint16_t Count);
+EE_Status EE_ReadBlob(uint8_t Id, uint8_t* pData, uint16_t Size, uint16_t* pLength);
+EE_Status EE_WriteBlob(uint8_t Id, uint8_t* pData, uint16_t Length);
 #endif
 EE_Status EE_ReadVariable16bits(uint16_t VirtAddress, uint16_t* pData);
 EE_Status EE_WriteVariable16bits(uint16_t VirtAddress, uint16_t Data);
@@ -148,6 +181,7 @@ EE_Status EE_CleanUp(void);
 EE_Status EE_CleanUp_IT(void);
 EE_Status EE_DeleteCorruptedFlashAddress(uint32_t Address);
 void EE_EndOfCleanup_UserCallback(void);
+void EE_PageErase_UserCallback(uint32_t Page, uint16_t NbPages);
 
 /**
   * @}
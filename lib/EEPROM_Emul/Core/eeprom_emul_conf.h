@@ -94,6 +94,10 @@
   * @{
   */
 #define NB_OF_VARIABLES         256  /*!< Number of variables to handle in eeprom */
+#define NB_OF_BLOBS             4U   /*!< Number of blobs, variable length records of EE_WriteBlob() */
+#define EE_BLOB_MAX_SIZE        512U /*!< Max size of a blob in bytes. Latest version of each blob is transferred
+                                          with the variables, pages are sized for NB_OF_VARIABLES + NB_OF_BLOBS x
+                                          (EE_BLOB_MAX_SIZE / 6 + 2) elements */
 
 /**
   * @}
@@ -95,6 +95,8 @@
   * @{
   */
 #define NB_OF_VARIABLES         1000U  /*!< Number of variables to handle in eeprom */
+#define NB_OF_BLOBS             0U     /*!< Number of blobs, variable length records of EE_WriteBlob() */
+#define EE_BLOB_MAX_SIZE        512U   /*!< Max size of a blob in bytes */
 
 /**
   * @}
@@ -55,6 +55,9 @@
 /* Private constants ---------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+uint32_t uwProgramCount = 0U; /*!< Double words programmed, page headers included */
+
 /* Private function prototypes -----------------------------------------------*/
 static uint32_t GetBankNumber(uint32_t Address);
 
@@ -64,6 +67,33 @@ static uint32_t GetBankNumber(uint32_t Address);
   * @{
   */
 
+/**
+  * @brief  Program a double word, counted by uwProgramCount
+  * @param  Address Address of the FLASH Memory to program
+  * @param  Data Double word to program
+  * @retval HAL_StatusTypeDef
+  */
+HAL_StatusTypeDef FlashProgram(uint32_t Address, uint64_t Data)
+{
+  uwProgramCount++;
+  return HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, Address, Data);
+}
+
+/**
+  * @brief  Page erase callback, called before each erase of EEPROM emulation pages.
+  * @param  Page Page number
+  * @param  NbPages Number of pages to erase
+  * @retval None
+  */
+__weak void EE_PageErase_UserCallback(uint32_t Page, uint16_t NbPages)
+{
+  UNUSED(Page);
+  UNUSED(NbPages);
+  /* NOTE : This function should not be modified, when the callback is needed,
+            the EE_PageErase_UserCallback could be implemented in the user file
+   */
+}
+
 /**
   * @brief  Erase a page in polling mode
   * @param  Page Page number
@@ -86,6 +116,8 @@ EE_Status PageErase(uint32_t Page, uint16_t NbPages)
   s_eraseinit.Page        = Page;
   s_eraseinit.Banks       = bank;
 
+  EE_PageErase_UserCallback(Page, NbPages);
+
   /* Erase the Page: Set Page status to ERASED status */
   if (HAL_FLASHEx_Erase(&s_eraseinit, &page_error) != HAL_OK)
   {
@@ -116,6 +148,8 @@ EE_Status PageErase_IT(uint32_t Page, uint16_t NbPages)
   s_eraseinit.Page        = Page;
   s_eraseinit.Banks       = bank;
 
+  EE_PageErase_UserCallback(Page, NbPages);
+
   /* Erase the Page: Set Page status to ERASED status */
   if (HAL_FLASHEx_Erase_IT(&s_eraseinit) != HAL_OK)
   {
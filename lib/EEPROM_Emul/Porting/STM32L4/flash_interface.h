@@ -107,6 +107,9 @@
   * @}
   */
 
+/* Exported variables --------------------------------------------------------*/
+extern uint32_t uwProgramCount;
+
 /* Private macro -------------------------------------------------------------*/
 /** @addtogroup EEPROM_Private_Macros
   * @{
@@ -115,7 +118,7 @@
 /** @defgroup Macros_Flash Macros to access flash
   * @{
   */
-#define EE_FLASH_PROGRAM(__ADDRESS__, __DATA__) HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, (__ADDRESS__), (__DATA__))
+#define EE_FLASH_PROGRAM(__ADDRESS__, __DATA__) FlashProgram((__ADDRESS__), (__DATA__))
 
 /**
   * @}
@@ -129,6 +132,7 @@
 /** @addtogroup EEPROM_Private_Functions
   * @{
   */
+HAL_StatusTypeDef FlashProgram(uint32_t Address, uint64_t Data);
 EE_Status PageErase(uint32_t Page, uint16_t NbPages);
 EE_Status PageErase_IT(uint32_t Page, uint16_t NbPages);
 EE_Status DeleteCorruptedFlashAddress(uint32_t Address);